@@ -95,8 +95,14 @@
  *
  * uri_mutex is used to protect access to the uri field.
  *
- * buffer_mutex is used to protect access to buffer_cond, state and
- * connection_status.
+ * buffer_mutex is used to protect access to buffer_cond, state,
+ * connection_status and the received data.
+ *
+ * Received data is copied once, from the libcurl write callback into blocks
+ * of #GstBaseSrc:blocksize bytes taken from a buffer pool. Complete blocks
+ * are queued and handed downstream as they are by ::create(), as a buffer
+ * list when more than one is available, and the streaming thread is only
+ * woken up once #GstCurlHttpSrc:watermark bytes are available.
  *
  * The gst_curl_http_src_curl_multi_loop() function uses the mutexes:
  * 1. multi_task_context.task_rec_mutex
@@ -161,6 +167,7 @@ enum
   PROP_MAXCONCURRENT_GLOBAL,
   PROP_HTTPVERSION,
   PROP_IRADIO_MODE,
+  PROP_WATERMARK,
   PROP_MAX
 };
 
@@ -190,6 +197,8 @@ static gboolean gst_curl_http_src_negotiate_caps (GstCurlHttpSrc * src);
 static GstStateChangeReturn gst_curl_http_src_change_state (GstElement *
     element, GstStateChange transition);
 static void gst_curl_http_src_cleanup_instance (GstCurlHttpSrc * src);
+static gboolean gst_curl_http_src_ensure_pool (GstCurlHttpSrc * src);
+static void gst_curl_http_src_clear_buffers (GstCurlHttpSrc * src);
 static gboolean gst_curl_http_src_query (GstBaseSrc * bsrc, GstQuery * query);
 static gboolean gst_curl_http_src_get_content_length (GstBaseSrc * bsrc,
     guint64 * size);
@@ -466,6 +475,24 @@ gst_curl_http_src_class_init (GstCurlHttpSrcClass * klass)
           GST_TYPE_CURL_HTTP_VERSION, pref_http_ver,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstCurlHttpSrc:watermark:
+   *
+   * Number of received bytes to wait for before waking up the streaming
+   * thread, unless the transfer is complete. Higher values let the curl
+   * loop and the streaming thread exchange data in large batches, at the
+   * expense of latency. 0 wakes up the streaming thread for every chunk
+   * received from libcurl.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_WATERMARK,
+      g_param_spec_uint ("watermark", "Watermark",
+          "Number of bytes to accumulate before pushing them downstream "
+          "(0 = push as soon as data is received)",
+          0, GSTCURL_MAX_WATERMARK, GSTCURL_DEFAULT_WATERMARK,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* Add a debugging task so it's easier to debug in the Multi worker thread */
   GST_DEBUG_CATEGORY_INIT (gst_curl_loop_debug, "curl_multi_loop", 0,
       "libcURL loop thread debugging");
@@ -583,6 +610,12 @@ gst_curl_http_src_set_property (GObject * object, guint prop_id,
     case PROP_HTTPVERSION:
       source->preferred_http_version = g_value_get_enum (value);
       break;
+    case PROP_WATERMARK:
+      g_mutex_lock (&source->buffer_mutex);
+      source->watermark = g_value_get_uint (value);
+      g_cond_signal (&source->buffer_cond);
+      g_mutex_unlock (&source->buffer_mutex);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -666,6 +699,9 @@ gst_curl_http_src_get_property (GObject * object, guint prop_id,
     case PROP_HTTPVERSION:
       g_value_set_enum (value, source->preferred_http_version);
       break;
+    case PROP_WATERMARK:
+      g_value_set_uint (value, source->watermark);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -714,6 +750,7 @@ gst_curl_http_src_init (GstCurlHttpSrc * source)
   source->stop_position = -1;
 
   gst_base_src_set_automatic_eos (GST_BASE_SRC (source), FALSE);
+  gst_base_src_set_blocksize (GST_BASE_SRC (source), GSTCURL_DEFAULT_BLOCKSIZE);
 
   source->proxy_uri = g_strdup (g_getenv ("http_proxy"));
   source->no_proxy_list = g_strdup (g_getenv ("no_proxy"));
@@ -722,8 +759,13 @@ gst_curl_http_src_init (GstCurlHttpSrc * source)
   g_mutex_init (&source->buffer_mutex);
   g_cond_init (&source->buffer_cond);
 
-  source->buffer = NULL;
-  source->buffer_len = 0;
+  source->pool = NULL;
+  source->pool_blocksize = 0;
+  g_queue_init (&source->buffers);
+  source->fill_buffer = NULL;
+  source->fill_len = 0;
+  source->buffered_bytes = 0;
+  source->watermark = GSTCURL_DEFAULT_WATERMARK;
   source->state = GSTCURL_NONE;
   source->pending_state = GSTCURL_NONE;
   source->transfer_begun = FALSE;
@@ -869,6 +911,10 @@ gst_curl_http_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   GstCurlHttpSrcClass *klass;
   GstStructure *empty_headers;
   GstBaseSrc *basesrc;
+  GstBufferList *list;
+  GstBuffer *buf;
+  guint64 offset;
+  guint n_buffers;
 
   GSTCURL_FUNCTION_ENTRY (src);
 
@@ -889,6 +935,11 @@ retry:
 
   if (!src->transfer_begun) {
     GST_DEBUG_OBJECT (src, "Starting new request for URI %s", src->uri);
+    if (!gst_curl_http_src_ensure_pool (src)) {
+      ret = GST_FLOW_ERROR;
+      goto escape;
+    }
+
     /* Create the Easy Handle and set up the session. */
     src->curl_handle = gst_curl_http_src_create_easy_handle (src);
     if (src->curl_handle == NULL) {
@@ -925,18 +976,15 @@ retry:
 
   g_mutex_unlock (&klass->multi_task_context.mutex);
 
-  /* Wait for data to become available, then punt it downstream */
-  while ((src->buffer_len == 0) && (src->state == GSTCURL_OK)
+  /* Wait for enough data to become available, then punt it downstream */
+  while ((src->buffered_bytes == 0 || src->buffered_bytes < src->watermark)
+      && (src->state == GSTCURL_OK)
       && (src->connection_status == GSTCURL_CONNECTED)) {
     g_cond_wait (&src->buffer_cond, &src->buffer_mutex);
   }
 
   if (src->state == GSTCURL_UNLOCK) {
-    if (src->buffer_len > 0) {
-      g_free (src->buffer);
-      src->buffer = NULL;
-      src->buffer_len = 0;
-    }
+    gst_curl_http_src_clear_buffers (src);
     g_mutex_unlock (&src->buffer_mutex);
     return GST_FLOW_FLUSHING;
   }
@@ -987,21 +1035,41 @@ retry:
   }
 
   if (((src->state == GSTCURL_OK) || (src->state == GSTCURL_DONE)) &&
-      (src->buffer_len > 0)) {
-
-    GST_DEBUG_OBJECT (src, "Pushing %u bytes of transfer for URI %s to pad",
-        src->buffer_len, src->uri);
-    *outbuf = gst_buffer_new_allocate (NULL, src->buffer_len, NULL);
-    gst_buffer_fill (*outbuf, 0, src->buffer, src->buffer_len);
-    GST_BUFFER_OFFSET (*outbuf) = basesrc->segment.position;
+      (src->buffered_bytes > 0)) {
+
+    GST_DEBUG_OBJECT (src, "Pushing %" G_GUINT64_FORMAT " bytes of transfer "
+        "for URI %s to pad", src->buffered_bytes, src->uri);
+
+    /* Hand over the partially filled block too, the next chunk will go to a
+     * new one */
+    if (src->fill_buffer != NULL) {
+      gst_buffer_unmap (src->fill_buffer, &src->fill_map);
+      gst_buffer_set_size (src->fill_buffer, src->fill_len);
+      g_queue_push_tail (&src->buffers, src->fill_buffer);
+      src->fill_buffer = NULL;
+      src->fill_len = 0;
+    }
 
-    g_free (src->buffer);
-    src->buffer = NULL;
-    src->buffer_len = 0;
+    offset = basesrc->segment.position;
+    n_buffers = g_queue_get_length (&src->buffers);
+    if (n_buffers == 1) {
+      *outbuf = g_queue_pop_head (&src->buffers);
+      GST_BUFFER_OFFSET (*outbuf) = offset;
+    } else {
+      list = gst_buffer_list_new_sized (n_buffers);
+      while ((buf = g_queue_pop_head (&src->buffers)) != NULL) {
+        GST_BUFFER_OFFSET (buf) = offset;
+        offset += gst_buffer_get_size (buf);
+        gst_buffer_list_add (list, buf);
+      }
+      gst_base_src_submit_buffer_list (basesrc, list);
+      *outbuf = NULL;
+    }
+    src->buffered_bytes = 0;
     src->data_received = TRUE;
 
     /* ret should still be GST_FLOW_OK */
-  } else if ((src->state == GSTCURL_DONE) && (src->buffer_len == 0)) {
+  } else if ((src->state == GSTCURL_DONE) && (src->buffered_bytes == 0)) {
     GST_INFO_OBJECT (src, "Full body received, signalling EOS for URI %s.",
         src->uri);
     src->state = GSTCURL_NONE;
@@ -1444,6 +1512,14 @@ gst_curl_http_src_change_state (GstElement * element, GstStateChange transition)
          and wait until the multi_loop has stopped using this element */
       gst_curl_http_src_wait_until_removed (source);
       gst_curl_http_src_unref_multi (source);
+      g_mutex_lock (&source->buffer_mutex);
+      gst_curl_http_src_clear_buffers (source);
+      if (source->pool) {
+        gst_buffer_pool_set_active (source->pool, FALSE);
+        gst_object_unref (source->pool);
+        source->pool = NULL;
+      }
+      g_mutex_unlock (&source->buffer_mutex);
       break;
     default:
       break;
@@ -1490,13 +1566,17 @@ gst_curl_http_src_cleanup_instance (GstCurlHttpSrc * src)
   g_free (src->user_agent);
   src->user_agent = NULL;
 
+  gst_curl_http_src_clear_buffers (src);
+  if (src->pool) {
+    gst_buffer_pool_set_active (src->pool, FALSE);
+    gst_object_unref (src->pool);
+    src->pool = NULL;
+  }
+
   g_mutex_clear (&src->buffer_mutex);
 
   g_cond_clear (&src->buffer_cond);
 
-  g_free (src->buffer);
-  src->buffer = NULL;
-
   if (src->request_headers) {
     gst_structure_free (src->request_headers);
     src->request_headers = NULL;
@@ -2044,6 +2124,66 @@ gst_curl_http_src_strcasestr (const char *haystack, const char *needle)
   return location;
 }
 
+/*
+ * (Re)create the pool the received data is stored into, if the blocksize
+ * changed since the last request. Must be called with buffer_mutex held.
+ */
+static gboolean
+gst_curl_http_src_ensure_pool (GstCurlHttpSrc * src)
+{
+  GstStructure *config;
+  guint blocksize;
+
+  blocksize = gst_base_src_get_blocksize (GST_BASE_SRC_CAST (src));
+  if (blocksize == 0)
+    blocksize = GSTCURL_DEFAULT_BLOCKSIZE;
+
+  if (src->pool != NULL && src->pool_blocksize == blocksize)
+    return TRUE;
+
+  /* Blocks already received from the old pool are still pushed as they
+   * are, they will return to it once downstream is done with them */
+  if (src->pool != NULL) {
+    gst_buffer_pool_set_active (src->pool, FALSE);
+    gst_object_unref (src->pool);
+  }
+
+  GST_DEBUG_OBJECT (src, "Creating pool of %u bytes blocks", blocksize);
+  src->pool = gst_buffer_pool_new ();
+  src->pool_blocksize = blocksize;
+  config = gst_buffer_pool_get_config (src->pool);
+  gst_buffer_pool_config_set_params (config, NULL, blocksize, 0, 0);
+  if (!gst_buffer_pool_set_config (src->pool, config) ||
+      !gst_buffer_pool_set_active (src->pool, TRUE)) {
+    GST_ERROR_OBJECT (src, "Failed to set up buffer pool");
+    gst_object_unref (src->pool);
+    src->pool = NULL;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/*
+ * Drop any received data not handed downstream yet. Must be called with
+ * buffer_mutex held.
+ */
+static void
+gst_curl_http_src_clear_buffers (GstCurlHttpSrc * src)
+{
+  GstBuffer *buf;
+
+  if (src->fill_buffer != NULL) {
+    gst_buffer_unmap (src->fill_buffer, &src->fill_map);
+    gst_buffer_unref (src->fill_buffer);
+    src->fill_buffer = NULL;
+    src->fill_len = 0;
+  }
+  while ((buf = g_queue_pop_head (&src->buffers)) != NULL)
+    gst_buffer_unref (buf);
+  src->buffered_bytes = 0;
+}
+
 /*
  * Receive chunks of the requested body and pass these back to the ::create()
  * loop
@@ -2053,6 +2193,9 @@ gst_curl_http_src_get_chunks (void *chunk, size_t size, size_t nmemb, void *src)
 {
   GstCurlHttpSrc *s = src;
   size_t chunk_len = size * nmemb;
+  const guint8 *data = chunk;
+  gsize remaining = chunk_len;
+  gsize len;
   GST_TRACE_OBJECT (s,
       "Received curl chunk for URI %s of size %d", s->uri, (int) chunk_len);
   g_mutex_lock (&s->buffer_mutex);
@@ -2060,15 +2203,35 @@ gst_curl_http_src_get_chunks (void *chunk, size_t size, size_t nmemb, void *src)
     g_mutex_unlock (&s->buffer_mutex);
     return chunk_len;
   }
-  s->buffer =
-      g_realloc (s->buffer, (s->buffer_len + chunk_len + 1) * sizeof (char));
-  if (s->buffer == NULL) {
-    GST_ERROR_OBJECT (s, "Realloc for cURL response message failed!");
-    return 0;
+  while (remaining > 0) {
+    if (s->fill_buffer == NULL) {
+      /* The pool has no maximum, so this never blocks */
+      if (s->pool == NULL ||
+          gst_buffer_pool_acquire_buffer (s->pool, &s->fill_buffer,
+              NULL) != GST_FLOW_OK) {
+        GST_ERROR_OBJECT (s, "Failed to get a block for cURL response data!");
+        g_mutex_unlock (&s->buffer_mutex);
+        return 0;
+      }
+      gst_buffer_map (s->fill_buffer, &s->fill_map, GST_MAP_WRITE);
+      s->fill_len = 0;
+    }
+    len = MIN (remaining, s->fill_map.size - s->fill_len);
+    memcpy (s->fill_map.data + s->fill_len, data, len);
+    s->fill_len += len;
+    data += len;
+    remaining -= len;
+
+    if (s->fill_len == s->fill_map.size) {
+      gst_buffer_unmap (s->fill_buffer, &s->fill_map);
+      g_queue_push_tail (&s->buffers, s->fill_buffer);
+      s->fill_buffer = NULL;
+      s->fill_len = 0;
+    }
   }
-  memcpy (s->buffer + s->buffer_len, chunk, chunk_len);
-  s->buffer_len += chunk_len;
-  g_cond_signal (&s->buffer_cond);
+  s->buffered_bytes += chunk_len;
+  if (s->buffered_bytes >= s->watermark)
+    g_cond_signal (&s->buffer_cond);
   g_mutex_unlock (&s->buffer_mutex);
   return chunk_len;
 }
@@ -204,8 +204,16 @@ struct _GstCurlHttpSrc
   CURL *curl_handle;
   GMutex buffer_mutex;
   GCond buffer_cond;
-  gchar *buffer;
-  guint buffer_len;
+  /* Received data: full blocks waiting for ::create(), and the block
+   * currently being filled by the multi loop, kept mapped */
+  GstBufferPool *pool;
+  guint pool_blocksize;
+  GQueue buffers;
+  GstBuffer *fill_buffer;
+  GstMapInfo fill_map;
+  gsize fill_len;
+  guint64 buffered_bytes;
+  guint watermark;
   gboolean transfer_begun;
   gboolean data_received;
   enum {
@@ -106,6 +106,9 @@ static gboolean gst_hls_demux_stream_has_next_fragment (GstAdaptiveDemuxStream *
     stream);
 static GstFlowReturn gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream *
     stream);
+static gboolean gst_hls_demux_stream_peek_fragment (GstAdaptiveDemuxStream *
+    stream, guint offset, gchar ** uri, gint64 * range_start,
+    gint64 * range_end);
 static GstFlowReturn gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream
     * stream);
 static gboolean gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream,
@@ -173,6 +176,8 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
   adaptivedemux_class->stream_has_next_fragment =
       gst_hls_demux_stream_has_next_fragment;
   adaptivedemux_class->stream_advance_fragment = gst_hls_demux_advance_fragment;
+  adaptivedemux_class->stream_peek_fragment =
+      gst_hls_demux_stream_peek_fragment;
   adaptivedemux_class->stream_update_fragment_info =
       gst_hls_demux_update_fragment_info;
   adaptivedemux_class->stream_select_bitrate = gst_hls_demux_select_bitrate;
@@ -422,8 +427,25 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
   snap_after = ! !(flags & GST_SEEK_FLAG_SNAP_AFTER);
 
   GST_M3U8_CLIENT_LOCK (hlsdemux->client);
+  walk = hls_stream->playlist->files;
+
+  /* Except for reverse playback snapping after the target, a fragment can
+   * only match if it doesn't end before the target, so start looking from
+   * the fragment containing it */
+  if (forward || !snap_after || snap_nearest) {
+    GstClockTime file_start = 0;
+    GList *first;
+
+    first = gst_m3u8_find_file_by_position (hls_stream->playlist,
+        ts > current_pos ? ts - current_pos : 0, &file_start);
+    if (first) {
+      walk = first;
+      current_pos += file_start;
+    }
+  }
+
   /* FIXME: Here we need proper discont handling */
-  for (walk = hls_stream->playlist->files; walk; walk = walk->next) {
+  for (; walk; walk = walk->next) {
     file = walk->data;
 
     current_sequence = file->sequence;
@@ -1217,6 +1239,32 @@ gst_hls_demux_stream_has_next_fragment (GstAdaptiveDemuxStream * stream)
   return has_next;
 }
 
+static gboolean
+gst_hls_demux_stream_peek_fragment (GstAdaptiveDemuxStream * stream,
+    guint offset, gchar ** uri, gint64 * range_start, gint64 * range_end)
+{
+  GstM3U8MediaFile *file;
+  GstM3U8 *m3u8;
+
+  m3u8 = gst_hls_demux_stream_get_m3u8 (GST_HLS_DEMUX_STREAM_CAST (stream));
+
+  file = gst_m3u8_peek_fragment (m3u8, stream->demux->segment.rate > 0,
+      offset);
+  if (file == NULL)
+    return FALSE;
+
+  *uri = g_strdup (file->uri);
+  *range_start = file->offset;
+  if (file->size != -1)
+    *range_end = file->offset + file->size - 1;
+  else
+    *range_end = -1;
+
+  gst_m3u8_media_file_unref (file);
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream * stream)
 {
@@ -1680,7 +1728,8 @@ retry:
 
     GST_M3U8_CLIENT_LOCK (demux->client);
     last_sequence =
-        GST_M3U8_MEDIA_FILE (g_list_last (m3u8->files)->data)->sequence;
+        GST_M3U8_MEDIA_FILE (((GList *) g_ptr_array_index (m3u8->file_index,
+                m3u8->file_index->len - 1))->data)->sequence;
     first_sequence =
         GST_M3U8_MEDIA_FILE (g_list_first (m3u8->files)->data)->sequence;
 
@@ -1724,19 +1773,17 @@ retry:
         GST_TIME_FORMAT " in updated playlist", GST_TIME_ARGS (target_pos));
 
     current_pos = 0;
-    for (walk = m3u8->files; walk; walk = walk->next) {
+    walk = gst_m3u8_find_file_by_position (m3u8, target_pos, &current_pos);
+    if (walk) {
       GstM3U8MediaFile *file = walk->data;
 
       sequence = file->sequence;
-      if (current_pos <= target_pos
-          && target_pos < current_pos + file->duration) {
-        break;
+      /* End of playlist */
+      if (target_pos >= current_pos + file->duration) {
+        current_pos += file->duration;
+        sequence++;
       }
-      current_pos += file->duration;
     }
-    /* End of playlist */
-    if (!walk)
-      sequence++;
     m3u8->sequence = sequence;
     m3u8->sequence_position = current_pos;
     GST_M3U8_CLIENT_UNLOCK (demux->client);
@@ -50,6 +50,9 @@ gst_m3u8_new (void)
   m3u8->highest_sequence_number = -1;
   m3u8->duration = GST_CLOCK_TIME_NONE;
 
+  m3u8->file_index = g_ptr_array_new ();
+  m3u8->file_starts = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+
   g_mutex_init (&m3u8->lock);
   m3u8->ref_count = 1;
 
@@ -107,6 +110,8 @@ gst_m3u8_unref (GstM3U8 * self)
 
     g_list_foreach (self->files, (GFunc) gst_m3u8_media_file_unref, NULL);
     g_list_free (self->files);
+    g_ptr_array_unref (self->file_index);
+    g_array_unref (self->file_starts);
 
     g_free (self->last_data);
     g_mutex_clear (&self->lock);
@@ -349,6 +354,7 @@ check_media_seqnums (GstM3U8 * self, GList * previous_files)
 {
   GList *l, *m;
   GstM3U8MediaFile *f1 = NULL, *f2 = NULL;
+  gint64 min_sequence = G_MAXINT64;
 
   g_return_val_if_fail (previous_files, FALSE);
 
@@ -357,21 +363,16 @@ check_media_seqnums (GstM3U8 * self, GList * previous_files)
     return TRUE;
   }
 
+  for (m = previous_files; m; m = m->next) {
+    f2 = m->data;
+    min_sequence = MIN (min_sequence, f2->sequence);
+  }
+
   /* Find first case of higher/equal sequence number in new playlist.
    * From there on we can linearly step ahead */
   for (l = self->files; l; l = l->next) {
-    gboolean match = FALSE;
-
     f1 = l->data;
-    for (m = previous_files; m; m = m->next) {
-      f2 = m->data;
-
-      if (f1->sequence >= f2->sequence) {
-        match = TRUE;
-        break;
-      }
-    }
-    if (match)
+    if (f1->sequence >= min_sequence)
       break;
   }
 
@@ -379,6 +380,15 @@ check_media_seqnums (GstM3U8 * self, GList * previous_files)
   g_assert (f1 != NULL);
   g_assert (f2 != NULL);
 
+  if (l) {
+    /* First entry of the previous playlist the new one can be matched to */
+    for (m = previous_files; m; m = m->next) {
+      f2 = m->data;
+      if (f1->sequence >= f2->sequence)
+        break;
+    }
+  }
+
   if (!l) {
     /* No match, no sequence in the new playlist was higher than
      * any in the old. This is bad! */
@@ -418,31 +428,34 @@ check_media_seqnums (GstM3U8 * self, GList * previous_files)
 static void
 generate_media_seqnums (GstM3U8 * self, GList * previous_files)
 {
-  GList *l, *m;
+  GList *l, *m = NULL;
   GstM3U8MediaFile *f1 = NULL, *f2 = NULL;
   gint64 mediasequence;
+  GHashTable *previous_uris;
 
   g_return_if_fail (previous_files);
 
+  /* First occurrence of each URI in the previous playlist */
+  previous_uris = g_hash_table_new (g_str_hash, g_str_equal);
+  for (l = previous_files; l; l = l->next) {
+    f2 = l->data;
+    if (!g_hash_table_contains (previous_uris, f2->uri))
+      g_hash_table_insert (previous_uris, f2->uri, l);
+  }
+
   /* Find first case of same URI in new playlist.
    * From there on we can linearly step ahead */
   for (l = self->files; l; l = l->next) {
-    gboolean match = FALSE;
-
     f1 = l->data;
-    for (m = previous_files; m; m = m->next) {
+    m = g_hash_table_lookup (previous_uris, f1->uri);
+    if (m) {
       f2 = m->data;
-
-      if (g_str_equal (f1->uri, f2->uri)) {
-        match = TRUE;
-        break;
-      }
-    }
-
-    if (match)
       break;
+    }
   }
 
+  g_hash_table_destroy (previous_uris);
+
   if (l) {
     /* Match, check that all following ones are matching too and continue
      * sequence numbers from there on */
@@ -476,6 +489,79 @@ generate_media_seqnums (GstM3U8 * self, GList * previous_files)
   }
 }
 
+/* call with M3U8_LOCK held */
+static void
+m3u8_update_file_index (GstM3U8 * self)
+{
+  GList *l;
+  GstClockTime start = 0;
+
+  g_ptr_array_set_size (self->file_index, 0);
+  g_array_set_size (self->file_starts, 0);
+
+  for (l = self->files; l; l = l->next) {
+    g_ptr_array_add (self->file_index, l);
+    g_array_append_val (self->file_starts, start);
+    start += GST_M3U8_MEDIA_FILE (l->data)->duration;
+  }
+  g_array_append_val (self->file_starts, start);
+}
+
+#define M3U8_FILE_AT(m3u8, i) \
+    ((GList *) g_ptr_array_index ((m3u8)->file_index, (i)))
+#define M3U8_FILE_START_AT(m3u8, i) \
+    g_array_index ((m3u8)->file_starts, GstClockTime, (i))
+
+/* Returns the index of the first file with a sequence number higher or
+ * equal to @sequence, or the number of files if there is none.
+ * call with M3U8_LOCK held */
+static guint
+m3u8_find_sequence_index (GstM3U8 * self, gint64 sequence)
+{
+  guint lo = 0, hi = self->file_index->len, mid;
+  gint64 first;
+
+  if (hi == 0)
+    return 0;
+
+  /* Sequence numbers are usually contiguous */
+  first = GST_M3U8_MEDIA_FILE (M3U8_FILE_AT (self, 0)->data)->sequence;
+  if (sequence <= first)
+    return 0;
+  if (sequence - first < hi && GST_M3U8_MEDIA_FILE (M3U8_FILE_AT (self,
+              sequence - first)->data)->sequence == sequence)
+    return sequence - first;
+
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (GST_M3U8_MEDIA_FILE (M3U8_FILE_AT (self, mid)->data)->sequence <
+        sequence)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+/* call with M3U8_LOCK held */
+static GList *
+m3u8_find_file_by_sequence (GstM3U8 * self, gint64 sequence)
+{
+  guint idx;
+  GList *l;
+
+  idx = m3u8_find_sequence_index (self, sequence);
+  if (idx >= self->file_index->len)
+    return NULL;
+
+  l = M3U8_FILE_AT (self, idx);
+  if (GST_M3U8_MEDIA_FILE (l->data)->sequence != sequence)
+    return NULL;
+
+  return l;
+}
+
 /*
  * @data: a m3u8 playlist text data, taking ownership
  */
@@ -529,6 +615,8 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   self->current_file = NULL;
   previous_files = self->files;
   self->files = NULL;
+  g_ptr_array_set_size (self->file_index, 0);
+  g_array_set_size (self->file_starts, 0);
   self->duration = GST_CLOCK_TIME_NONE;
   mediasequence = 0;
 
@@ -768,6 +856,7 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   current_key = NULL;
 
   self->files = g_list_reverse (self->files);
+  m3u8_update_file_index (self);
 
   if (last_init_file)
     gst_m3u8_init_file_unref (last_init_file);
@@ -852,7 +941,7 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       gint i;
       GstClockTime sequence_pos = 0;
 
-      file = g_list_last (self->files);
+      file = M3U8_FILE_AT (self, self->file_index->len - 1);
 
       if (self->last_file_end >= GST_M3U8_MEDIA_FILE (file->data)->duration) {
         sequence_pos =
@@ -878,7 +967,7 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   }
 
   GST_LOG ("processed media playlist %s, %u fragments", self->name,
-      g_list_length (self->files));
+      self->file_index->len);
 
   GST_M3U8_UNLOCK (self);
 
@@ -889,32 +978,19 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 static GList *
 m3u8_find_next_fragment (GstM3U8 * m3u8, gboolean forward)
 {
-  GstM3U8MediaFile *file;
-  GList *l = m3u8->files;
+  guint idx;
 
   if (forward) {
-    while (l) {
-      file = l->data;
-
-      if (file->sequence >= m3u8->sequence)
-        break;
-
-      l = l->next;
-    }
+    idx = m3u8_find_sequence_index (m3u8, m3u8->sequence);
+    if (idx < m3u8->file_index->len)
+      return M3U8_FILE_AT (m3u8, idx);
   } else {
-    l = g_list_last (l);
-
-    while (l) {
-      file = l->data;
-
-      if (file->sequence <= m3u8->sequence)
-        break;
-
-      l = l->prev;
-    }
+    idx = m3u8_find_sequence_index (m3u8, m3u8->sequence + 1);
+    if (idx > 0)
+      return M3U8_FILE_AT (m3u8, idx - 1);
   }
 
-  return l;
+  return NULL;
 }
 
 GstM3U8MediaFile *
@@ -984,13 +1060,41 @@ gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
   return have_next;
 }
 
+/* Returns the fragment @offset fragments after the current one, without
+ * advancing */
+GstM3U8MediaFile *
+gst_m3u8_peek_fragment (GstM3U8 * m3u8, gboolean forward, guint offset)
+{
+  GstM3U8MediaFile *file = NULL;
+  GList *cur;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  if (m3u8->current_file) {
+    cur = m3u8->current_file;
+  } else {
+    cur = m3u8_find_next_fragment (m3u8, forward);
+  }
+
+  while (cur && offset-- > 0)
+    cur = forward ? cur->next : cur->prev;
+
+  if (cur)
+    file = gst_m3u8_media_file_ref (cur->data);
+
+  GST_M3U8_UNLOCK (m3u8);
+
+  return file;
+}
+
 /* call with M3U8_LOCK held */
 static void
 m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
 {
   gint targetnum = m3u8->sequence;
   GList *tmp;
-  GstM3U8MediaFile *mf;
 
   /* figure out the target seqnum */
   if (forward)
@@ -998,11 +1102,7 @@ m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
   else
     targetnum -= 1;
 
-  for (tmp = m3u8->files; tmp; tmp = tmp->next) {
-    mf = (GstM3U8MediaFile *) tmp->data;
-    if (mf->sequence == targetnum)
-      break;
-  }
+  tmp = m3u8_find_file_by_sequence (m3u8, targetnum);
   if (tmp == NULL) {
     GST_WARNING ("Can't find next fragment");
     return;
@@ -1036,15 +1136,8 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
         GST_TIME_ARGS (m3u8->sequence_position));
   }
   if (!m3u8->current_file) {
-    GList *l;
-
     GST_DEBUG ("Looking for fragment %" G_GINT64_FORMAT, m3u8->sequence);
-    for (l = m3u8->files; l != NULL; l = l->next) {
-      if (GST_M3U8_MEDIA_FILE (l->data)->sequence == m3u8->sequence) {
-        m3u8->current_file = l;
-        break;
-      }
-    }
+    m3u8->current_file = m3u8_find_file_by_sequence (m3u8, m3u8->sequence);
     if (m3u8->current_file == NULL) {
       GST_DEBUG
           ("Could not find current fragment, trying next fragment directly");
@@ -1055,8 +1148,8 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
         /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
            the end of the playlist. See section 6.3.3 of HLS draft */
         gint pos =
-            g_list_length (m3u8->files) - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
-        m3u8->current_file = g_list_nth (m3u8->files, pos >= 0 ? pos : 0);
+            (gint) m3u8->file_index->len - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
+        m3u8->current_file = M3U8_FILE_AT (m3u8, pos >= 0 ? pos : 0);
         m3u8->current_file_duration =
             GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->duration;
 
@@ -1109,11 +1202,8 @@ gst_m3u8_get_duration (GstM3U8 * m3u8)
     goto out;
 
   if (!GST_CLOCK_TIME_IS_VALID (m3u8->duration) && m3u8->files != NULL) {
-    GList *f;
-
-    m3u8->duration = 0;
-    for (f = m3u8->files; f != NULL; f = f->next)
-      m3u8->duration += GST_M3U8_MEDIA_FILE (f)->duration;
+    m3u8->duration =
+        M3U8_FILE_START_AT (m3u8, m3u8->file_starts->len - 1);
   }
   duration = m3u8->duration;
 
@@ -1224,8 +1314,6 @@ gboolean
 gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
 {
   GstClockTime duration = 0;
-  GList *walk;
-  GstM3U8MediaFile *file;
   guint count;
   guint min_distance = 0;
 
@@ -1242,13 +1330,11 @@ gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
        playlist - see 6.3.3. "Playing the Playlist file" of the HLS draft */
     min_distance = GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
   }
-  count = g_list_length (m3u8->files);
+  count = m3u8->file_index->len;
 
-  for (walk = m3u8->files; walk && count > min_distance; walk = walk->next) {
-    file = walk->data;
-    --count;
-    duration += file->duration;
-  }
+  /* duration of all files but the last min_distance ones */
+  if (count > min_distance)
+    duration = M3U8_FILE_START_AT (m3u8, count - min_distance);
 
   if (duration <= 0)
     goto out;
@@ -1262,6 +1348,49 @@ out:
   return (duration > 0);
 }
 
+/**
+ * gst_m3u8_find_file_by_position:
+ * @position: position relative to the start of the playlist
+ * @file_start: (out) (optional): position of the start of the returned file
+ *
+ * Returns: the last media file of the playlist starting at or before
+ * @position, or %NULL if the playlist is empty
+ */
+GList *
+gst_m3u8_find_file_by_position (GstM3U8 * m3u8, GstClockTime position,
+    GstClockTime * file_start)
+{
+  GList *file = NULL;
+  guint lo, hi, mid;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  if (m3u8->file_index->len == 0)
+    goto out;
+
+  /* Find the first file starting after position */
+  lo = 1;
+  hi = m3u8->file_index->len;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (M3U8_FILE_START_AT (m3u8, mid) <= position)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  file = M3U8_FILE_AT (m3u8, lo - 1);
+  if (file_start)
+    *file_start = M3U8_FILE_START_AT (m3u8, lo - 1);
+
+out:
+  GST_M3U8_UNLOCK (m3u8);
+
+  return file;
+}
+
 GstHLSMedia *
 gst_hls_media_ref (GstHLSMedia * media)
 {
@@ -66,6 +66,11 @@ struct _GstM3U8
 
   GList *files;
 
+  /* index of files, in playlist order */
+  GPtrArray *file_index;        /* GList node of each file */
+  GArray *file_starts;          /* cumulative duration before each file
+                                 * (GstClockTime), plus the total duration */
+
   /* state */
   GList *current_file;
   GstClockTime current_file_duration; /* Duration of current fragment */
@@ -132,6 +137,10 @@ GstM3U8MediaFile * gst_m3u8_get_next_fragment    (GstM3U8      * m3u8,
 gboolean           gst_m3u8_has_next_fragment    (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
+GstM3U8MediaFile * gst_m3u8_peek_fragment        (GstM3U8 * m3u8,
+                                                  gboolean  forward,
+                                                  guint     offset);
+
 void               gst_m3u8_advance_fragment     (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
@@ -147,6 +156,10 @@ gboolean           gst_m3u8_get_seek_range       (GstM3U8 * m3u8,
                                                   gint64  * start,
                                                   gint64  * stop);
 
+GList *            gst_m3u8_find_file_by_position (GstM3U8      * m3u8,
+                                                   GstClockTime   position,
+                                                   GstClockTime * file_start);
+
 typedef enum
 {
   GST_HLS_MEDIA_TYPE_INVALID = -1,
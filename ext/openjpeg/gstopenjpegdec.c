@@ -36,10 +36,14 @@ enum
 {
   PROP_0,
   PROP_MAX_THREADS,
+  PROP_NUM_THREADS,
   PROP_LAST
 };
 
 #define GST_OPENJPEG_DEC_DEFAULT_MAX_THREADS		0
+#define GST_OPENJPEG_DEC_DEFAULT_NUM_THREADS		0
+
+static void gst_openjpeg_dec_finalize (GObject * object);
 
 static gboolean gst_openjpeg_dec_start (GstVideoDecoder * decoder);
 static gboolean gst_openjpeg_dec_stop (GstVideoDecoder * decoder);
@@ -47,12 +51,16 @@ static gboolean gst_openjpeg_dec_set_format (GstVideoDecoder * decoder,
     GstVideoCodecState * state);
 static GstFlowReturn gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
     GstVideoCodecFrame * frame);
+static GstFlowReturn gst_openjpeg_dec_finish (GstVideoDecoder * decoder);
+static gboolean gst_openjpeg_dec_flush (GstVideoDecoder * decoder);
 static gboolean gst_openjpeg_dec_decide_allocation (GstVideoDecoder * decoder,
     GstQuery * query);
 static void gst_openjpeg_dec_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
 static void gst_openjpeg_dec_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec);
+static void gst_openjpeg_dec_decode_job (gpointer data, gpointer user_data);
+static void gst_openjpeg_dec_drop_jobs (GstOpenJPEGDec * self);
 
 
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
@@ -111,7 +119,11 @@ gst_openjpeg_dec_class_init (GstOpenJPEGDecClass * klass)
       GST_DEBUG_FUNCPTR (gst_openjpeg_dec_set_format);
   video_decoder_class->handle_frame =
       GST_DEBUG_FUNCPTR (gst_openjpeg_dec_handle_frame);
+  video_decoder_class->finish = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_finish);
+  video_decoder_class->drain = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_finish);
+  video_decoder_class->flush = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_flush);
   video_decoder_class->decide_allocation = gst_openjpeg_dec_decide_allocation;
+  gobject_class->finalize = gst_openjpeg_dec_finalize;
   gobject_class->set_property = gst_openjpeg_dec_set_property;
   gobject_class->get_property = gst_openjpeg_dec_get_property;
 
@@ -128,6 +140,24 @@ gst_openjpeg_dec_class_init (GstOpenJPEGDecClass * klass)
           0, G_MAXINT, GST_OPENJPEG_DEC_DEFAULT_MAX_THREADS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstOpenJPEGDec:num-threads:
+   *
+   * Number of frames, or stripes with alignment=stripe input, decoded in
+   * parallel by a pool of threads. Each of them can additionally use
+   * #GstOpenJPEGDec:max-threads threads inside OpenJPEG. (0 = decode in
+   * the streaming thread)
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_NUM_THREADS,
+      g_param_spec_uint ("num-threads", "Number of decoding threads",
+          "Number of frames or stripes decoded in parallel "
+          "(0 = decode in the streaming thread)",
+          0, G_MAXINT, GST_OPENJPEG_DEC_DEFAULT_NUM_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   GST_DEBUG_CATEGORY_INIT (gst_openjpeg_dec_debug, "openjpegdec", 0,
       "OpenJPEG Decoder");
 }
@@ -146,15 +176,44 @@ gst_openjpeg_dec_init (GstOpenJPEGDec * self)
   self->sampling = GST_JPEG2000_SAMPLING_NONE;
   self->max_threads = GST_OPENJPEG_DEC_DEFAULT_MAX_THREADS;
   self->num_procs = g_get_num_processors ();
+  self->num_stripes = 1;
+  self->num_threads = GST_OPENJPEG_DEC_DEFAULT_NUM_THREADS;
+
+  g_mutex_init (&self->jobs_lock);
+  g_cond_init (&self->jobs_cond);
+  g_queue_init (&self->jobs);
+}
+
+static void
+gst_openjpeg_dec_finalize (GObject * object)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (object);
+
+  g_mutex_clear (&self->jobs_lock);
+  g_cond_clear (&self->jobs_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 static gboolean
 gst_openjpeg_dec_start (GstVideoDecoder * decoder)
 {
   GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+  GError *err = NULL;
 
   GST_DEBUG_OBJECT (self, "Starting");
 
+  if (self->num_threads > 0) {
+    self->pool = g_thread_pool_new (gst_openjpeg_dec_decode_job, self,
+        self->num_threads, FALSE, &err);
+    if (!self->pool) {
+      GST_ELEMENT_ERROR (self, RESOURCE, FAILED,
+          ("Failed to create decoding threads"), ("%s", err->message));
+      g_clear_error (&err);
+      return FALSE;
+    }
+  }
+
   return TRUE;
 }
 
@@ -165,6 +224,12 @@ gst_openjpeg_dec_stop (GstVideoDecoder * video_decoder)
 
   GST_DEBUG_OBJECT (self, "Stopping");
 
+  gst_openjpeg_dec_drop_jobs (self);
+  if (self->pool) {
+    g_thread_pool_free (self->pool, FALSE, TRUE);
+    self->pool = NULL;
+  }
+
   if (self->output_state) {
     gst_video_codec_state_unref (self->output_state);
     self->output_state = NULL;
@@ -191,6 +256,9 @@ gst_openjpeg_dec_set_property (GObject * object,
     case PROP_MAX_THREADS:
       g_atomic_int_set (&dec->max_threads, g_value_get_int (value));
       break;
+    case PROP_NUM_THREADS:
+      dec->num_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -207,6 +275,9 @@ gst_openjpeg_dec_get_property (GObject * object,
     case PROP_MAX_THREADS:
       g_value_set_int (value, g_atomic_int_get (&dec->max_threads));
       break;
+    case PROP_NUM_THREADS:
+      g_value_set_uint (value, dec->num_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -222,6 +293,9 @@ gst_openjpeg_dec_set_format (GstVideoDecoder * decoder,
 
   GST_DEBUG_OBJECT (self, "Setting format: %" GST_PTR_FORMAT, state->caps);
 
+  /* frames being decoded still use the previous format */
+  gst_openjpeg_dec_finish (decoder);
+
   s = gst_caps_get_structure (state->caps, 0);
 
   self->color_space = OPJ_CLRSPC_UNKNOWN;
@@ -253,10 +327,24 @@ gst_openjpeg_dec_set_format (GstVideoDecoder * decoder,
   self->ncomps = 0;
   gst_structure_get_int (s, "num-components", &self->ncomps);
 
+  self->num_stripes = 1;
+  if (g_strcmp0 (gst_structure_get_string (s, "alignment"), "stripe") == 0)
+    gst_structure_get_int (s, "num-stripes", &self->num_stripes);
+
   if (self->input_state)
     gst_video_codec_state_unref (self->input_state);
   self->input_state = gst_video_codec_state_ref (state);
 
+  /* frames are output once the following ones are queued for decoding */
+  if (self->pool && self->num_stripes == 1 && state->info.fps_n > 0) {
+    GstClockTime latency = gst_util_uint64_scale (self->num_threads,
+        state->info.fps_d * GST_SECOND, state->info.fps_n);
+
+    gst_video_decoder_set_latency (decoder, latency, latency);
+  } else {
+    gst_video_decoder_set_latency (decoder, 0, 0);
+  }
+
   return TRUE;
 }
 
@@ -267,11 +355,65 @@ reverse_rgb_channels (GstJPEG2000Sampling sampling)
       || sampling == GST_JPEG2000_SAMPLING_BGRA;
 }
 
+/* The unpacking kernels convert one row of one component at a time, with
+ * index based loops on local variables only, so that the compiler can
+ * vectorise them. @pstride is the distance between two output pixels, in
+ * samples. */
+static inline void
+unpack_row_8 (guint8 * out, gint pstride, const gint * in, gint off, gint w)
+{
+  gint x;
+
+  for (x = 0; x < w; x++)
+    out[x * pstride] = off + in[x];
+}
+
+static inline void
+unpack_row_16 (guint16 * out, gint pstride, const gint * in, gint off,
+    gint shift, gint w)
+{
+  gint x;
+
+  for (x = 0; x < w; x++)
+    out[x * pstride] = off + (in[x] << shift);
+}
+
+/* for horizontally sub-sampled components */
+static inline void
+unpack_row_8_sub (guint8 * out, gint pstride, const gint * in, gint dx,
+    gint off, gint w)
+{
+  gint x;
+
+  if (dx == 1) {
+    unpack_row_8 (out, pstride, in, off, w);
+    return;
+  }
+
+  for (x = 0; x < w; x++)
+    out[x * pstride] = off + in[x / dx];
+}
+
+static inline void
+unpack_row_16_sub (guint16 * out, gint pstride, const gint * in, gint dx,
+    gint off, gint shift, gint w)
+{
+  gint x;
+
+  if (dx == 1) {
+    unpack_row_16 (out, pstride, in, off, shift, w);
+    return;
+  }
+
+  for (x = 0; x < w; x++)
+    out[x * pstride] = off + (in[x / dx] << shift);
+}
+
 static void
 fill_frame_packed8_4 (GstVideoFrame * frame, opj_image_t * image)
 {
-  gint x, y, w, h, c;
-  guint8 *data_out, *tmp;
+  gint y, w, h, c;
+  guint8 *data_out;
   const gint *data_in[4];
   gint dstride;
   gint off[4];
@@ -287,22 +429,15 @@ fill_frame_packed8_4 (GstVideoFrame * frame, opj_image_t * image)
   }
 
   for (y = 0; y < h; y++) {
-    tmp = data_out;
-
-    for (x = 0; x < w; x++) {
-      /* alpha, from 4'th input channel */
-      tmp[0] = off[3] + *data_in[3];
-      /* colour channels */
-      tmp[1] = off[0] + *data_in[0];
-      tmp[2] = off[1] + *data_in[1];
-      tmp[3] = off[2] + *data_in[2];
-
-      tmp += 4;
-      data_in[0]++;
-      data_in[1]++;
-      data_in[2]++;
-      data_in[3]++;
-    }
+    /* alpha, from 4'th input channel */
+    unpack_row_8 (data_out, 4, data_in[3], off[3], w);
+    /* colour channels */
+    unpack_row_8 (data_out + 1, 4, data_in[0], off[0], w);
+    unpack_row_8 (data_out + 2, 4, data_in[1], off[1], w);
+    unpack_row_8 (data_out + 3, 4, data_in[2], off[2], w);
+
+    for (c = 0; c < 4; c++)
+      data_in[c] += image->comps[c].w;
     data_out += dstride;
   }
 }
@@ -310,8 +445,8 @@ fill_frame_packed8_4 (GstVideoFrame * frame, opj_image_t * image)
 static void
 fill_frame_packed16_4 (GstVideoFrame * frame, opj_image_t * image)
 {
-  gint x, y, w, h, c;
-  guint16 *data_out, *tmp;
+  gint y, w, h, c;
+  guint16 *data_out;
   const gint *data_in[4];
   gint dstride;
   gint shift[4], off[4];
@@ -330,22 +465,15 @@ fill_frame_packed16_4 (GstVideoFrame * frame, opj_image_t * image)
   }
 
   for (y = 0; y < h; y++) {
-    tmp = data_out;
-
-    for (x = 0; x < w; x++) {
-      /* alpha, from 4'th input channel */
-      tmp[0] = off[3] + (*data_in[3] << shift[3]);
-      /* colour channels */
-      tmp[1] = off[0] + (*data_in[0] << shift[0]);
-      tmp[2] = off[1] + (*data_in[1] << shift[1]);
-      tmp[3] = off[2] + (*data_in[2] << shift[2]);
-
-      tmp += 4;
-      data_in[0]++;
-      data_in[1]++;
-      data_in[2]++;
-      data_in[3]++;
-    }
+    /* alpha, from 4'th input channel */
+    unpack_row_16 (data_out, 4, data_in[3], off[3], shift[3], w);
+    /* colour channels */
+    unpack_row_16 (data_out + 1, 4, data_in[0], off[0], shift[0], w);
+    unpack_row_16 (data_out + 2, 4, data_in[1], off[1], shift[1], w);
+    unpack_row_16 (data_out + 3, 4, data_in[2], off[2], shift[2], w);
+
+    for (c = 0; c < 4; c++)
+      data_in[c] += image->comps[c].w;
     data_out += dstride;
   }
 }
@@ -353,8 +481,8 @@ fill_frame_packed16_4 (GstVideoFrame * frame, opj_image_t * image)
 static void
 fill_frame_packed8_3 (GstVideoFrame * frame, opj_image_t * image)
 {
-  gint x, y, w, h, c;
-  guint8 *data_out, *tmp;
+  gint y, w, h, c;
+  guint8 *data_out;
   const gint *data_in[3];
   gint dstride;
   gint off[3];
@@ -370,16 +498,9 @@ fill_frame_packed8_3 (GstVideoFrame * frame, opj_image_t * image)
   };
 
   for (y = 0; y < h; y++) {
-    tmp = data_out;
-
-    for (x = 0; x < w; x++) {
-      tmp[0] = off[0] + *data_in[0];
-      tmp[1] = off[1] + *data_in[1];
-      tmp[2] = off[2] + *data_in[2];
-      data_in[0]++;
-      data_in[1]++;
-      data_in[2]++;
-      tmp += 3;
+    for (c = 0; c < 3; c++) {
+      unpack_row_8 (data_out + c, 3, data_in[c], off[c], w);
+      data_in[c] += image->comps[c].w;
     }
     data_out += dstride;
   }
@@ -388,8 +509,8 @@ fill_frame_packed8_3 (GstVideoFrame * frame, opj_image_t * image)
 static void
 fill_frame_packed16_3 (GstVideoFrame * frame, opj_image_t * image)
 {
-  gint x, y, w, h, c;
-  guint16 *data_out, *tmp;
+  gint y, w, h, c;
+  guint16 *data_out;
   const gint *data_in[3];
   gint dstride;
   gint shift[3], off[3];
@@ -408,17 +529,9 @@ fill_frame_packed16_3 (GstVideoFrame * frame, opj_image_t * image)
   }
 
   for (y = 0; y < h; y++) {
-    tmp = data_out;
-
-    for (x = 0; x < w; x++) {
-      tmp[1] = off[0] + (*data_in[0] << shift[0]);
-      tmp[2] = off[1] + (*data_in[1] << shift[1]);
-      tmp[3] = off[2] + (*data_in[2] << shift[2]);
-
-      tmp += 4;
-      data_in[0]++;
-      data_in[1]++;
-      data_in[2]++;
+    for (c = 0; c < 3; c++) {
+      unpack_row_16 (data_out + 1 + c, 4, data_in[c], off[c], shift[c], w);
+      data_in[c] += image->comps[c].w;
     }
     data_out += dstride;
   }
@@ -428,8 +541,8 @@ fill_frame_packed16_3 (GstVideoFrame * frame, opj_image_t * image)
 static void
 fill_frame_packed8_2 (GstVideoFrame * frame, opj_image_t * image)
 {
-  gint x, y, w, h, c;
-  guint8 *data_out, *tmp;
+  gint y, w, h, c;
+  guint8 *data_out;
   const gint *data_in[2];
   gint dstride;
   gint off[2];
@@ -445,19 +558,15 @@ fill_frame_packed8_2 (GstVideoFrame * frame, opj_image_t * image)
   };
 
   for (y = 0; y < h; y++) {
-    tmp = data_out;
-
-    for (x = 0; x < w; x++) {
-      /* alpha, from 2nd input channel */
-      tmp[0] = off[1] + *data_in[1];
-      /* luminance, from first input channel */
-      tmp[1] = off[0] + *data_in[0];
-      tmp[2] = tmp[1];
-      tmp[3] = tmp[1];
-      data_in[0]++;
-      data_in[1]++;
-      tmp += 4;
-    }
+    /* alpha, from 2nd input channel */
+    unpack_row_8 (data_out, 4, data_in[1], off[1], w);
+    /* luminance, from first input channel */
+    unpack_row_8 (data_out + 1, 4, data_in[0], off[0], w);
+    unpack_row_8 (data_out + 2, 4, data_in[0], off[0], w);
+    unpack_row_8 (data_out + 3, 4, data_in[0], off[0], w);
+
+    data_in[0] += image->comps[0].w;
+    data_in[1] += image->comps[1].w;
     data_out += dstride;
   }
 }
@@ -466,8 +575,8 @@ fill_frame_packed8_2 (GstVideoFrame * frame, opj_image_t * image)
 static void
 fill_frame_packed16_2 (GstVideoFrame * frame, opj_image_t * image)
 {
-  gint x, y, w, h, c;
-  guint16 *data_out, *tmp;
+  gint y, w, h, c;
+  guint16 *data_out;
   const gint *data_in[2];
   gint dstride;
   gint shift[2], off[2];
@@ -486,19 +595,15 @@ fill_frame_packed16_2 (GstVideoFrame * frame, opj_image_t * image)
   }
 
   for (y = 0; y < h; y++) {
-    tmp = data_out;
-
-    for (x = 0; x < w; x++) {
-      /* alpha, from 2nd input channel */
-      tmp[0] = off[1] + (*data_in[1] << shift[1]);
-      /* luminance, from first input channel  */
-      tmp[1] = off[0] + (*data_in[0] << shift[0]);
-      tmp[2] = tmp[1];
-      tmp[3] = tmp[1];
-      tmp += 4;
-      data_in[0]++;
-      data_in[1]++;
-    }
+    /* alpha, from 2nd input channel */
+    unpack_row_16 (data_out, 4, data_in[1], off[1], shift[1], w);
+    /* luminance, from first input channel  */
+    unpack_row_16 (data_out + 1, 4, data_in[0], off[0], shift[0], w);
+    unpack_row_16 (data_out + 2, 4, data_in[0], off[0], shift[0], w);
+    unpack_row_16 (data_out + 3, 4, data_in[0], off[0], shift[0], w);
+
+    data_in[0] += image->comps[0].w;
+    data_in[1] += image->comps[1].w;
     data_out += dstride;
   }
 }
@@ -507,8 +612,8 @@ fill_frame_packed16_2 (GstVideoFrame * frame, opj_image_t * image)
 static void
 fill_frame_planar8_1 (GstVideoFrame * frame, opj_image_t * image)
 {
-  gint x, y, w, h;
-  guint8 *data_out, *tmp;
+  gint y, w, h;
+  guint8 *data_out;
   const gint *data_in;
   gint dstride;
   gint off;
@@ -522,14 +627,8 @@ fill_frame_planar8_1 (GstVideoFrame * frame, opj_image_t * image)
   off = 0x80 * image->comps[0].sgnd;
 
   for (y = 0; y < h; y++) {
-    tmp = data_out;
-
-    for (x = 0; x < w; x++) {
-      *tmp = off + *data_in;
-
-      tmp++;
-      data_in++;
-    }
+    unpack_row_8 (data_out, 1, data_in, off, w);
+    data_in += image->comps[0].w;
     data_out += dstride;
   }
 }
@@ -537,8 +636,8 @@ fill_frame_planar8_1 (GstVideoFrame * frame, opj_image_t * image)
 static void
 fill_frame_planar16_1 (GstVideoFrame * frame, opj_image_t * image)
 {
-  gint x, y, w, h;
-  guint16 *data_out, *tmp;
+  gint y, w, h;
+  guint16 *data_out;
   const gint *data_in;
   gint dstride;
   gint shift, off;
@@ -556,14 +655,8 @@ fill_frame_planar16_1 (GstVideoFrame * frame, opj_image_t * image)
           8), 0);
 
   for (y = 0; y < h; y++) {
-    tmp = data_out;
-
-    for (x = 0; x < w; x++) {
-      *tmp = off + (*data_in << shift);
-
-      tmp++;
-      data_in++;
-    }
+    unpack_row_16 (data_out, 1, data_in, off, shift, w);
+    data_in += image->comps[0].w;
     data_out += dstride;
   }
 }
@@ -571,8 +664,8 @@ fill_frame_planar16_1 (GstVideoFrame * frame, opj_image_t * image)
 static void
 fill_frame_planar8_3 (GstVideoFrame * frame, opj_image_t * image)
 {
-  gint c, x, y, w, h;
-  guint8 *data_out, *tmp;
+  gint c, y, w, h;
+  guint8 *data_out;
   const gint *data_in;
   gint dstride, off;
 
@@ -585,13 +678,8 @@ fill_frame_planar8_3 (GstVideoFrame * frame, opj_image_t * image)
     off = 0x80 * image->comps[c].sgnd;
 
     for (y = 0; y < h; y++) {
-      tmp = data_out;
-
-      for (x = 0; x < w; x++) {
-        *tmp = off + *data_in;
-        tmp++;
-        data_in++;
-      }
+      unpack_row_8 (data_out, 1, data_in, off, w);
+      data_in += image->comps[c].w;
       data_out += dstride;
     }
   }
@@ -600,8 +688,8 @@ fill_frame_planar8_3 (GstVideoFrame * frame, opj_image_t * image)
 static void
 fill_frame_planar16_3 (GstVideoFrame * frame, opj_image_t * image)
 {
-  gint c, x, y, w, h;
-  guint16 *data_out, *tmp;
+  gint c, y, w, h;
+  guint16 *data_out;
   const gint *data_in;
   gint dstride;
   gint shift, off;
@@ -618,13 +706,8 @@ fill_frame_planar16_3 (GstVideoFrame * frame, opj_image_t * image)
             8), 0);
 
     for (y = 0; y < h; y++) {
-      tmp = data_out;
-
-      for (x = 0; x < w; x++) {
-        *tmp = off + (*data_in << shift);
-        tmp++;
-        data_in++;
-      }
+      unpack_row_16 (data_out, 1, data_in, off, shift, w);
+      data_in += image->comps[c].w;
       data_out += dstride;
     }
   }
@@ -634,32 +717,28 @@ static void
 fill_frame_planar8_3_generic (GstVideoFrame * frame, opj_image_t * image)
 {
   gint x, y, w, h, c;
-  guint8 *data_out, *tmp;
-  const gint *data_in[3];
+  guint8 *data_out;
+  const gint *row;
   gint dstride;
-  gint dx[3], dy[3], off[3];
+  gint off[3];
 
   w = GST_VIDEO_FRAME_WIDTH (frame);
   h = GST_VIDEO_FRAME_HEIGHT (frame);
   data_out = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
   dstride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
 
-  for (c = 0; c < 3; c++) {
-    data_in[c] = image->comps[c].data;
-    dx[c] = image->comps[c].dx;
-    dy[c] = image->comps[c].dy;
+  for (c = 0; c < 3; c++)
     off[c] = 0x80 * image->comps[c].sgnd;
-  }
 
   for (y = 0; y < h; y++) {
-    tmp = data_out;
-
-    for (x = 0; x < w; x++) {
-      tmp[0] = 0xff;
-      tmp[1] = off[0] + data_in[0][((y / dy[0]) * w + x) / dx[0]];
-      tmp[2] = off[1] + data_in[1][((y / dy[1]) * w + x) / dx[1]];
-      tmp[3] = off[2] + data_in[2][((y / dy[2]) * w + x) / dx[2]];
-      tmp += 4;
+    for (x = 0; x < w; x++)
+      data_out[4 * x] = 0xff;
+
+    for (c = 0; c < 3; c++) {
+      row = image->comps[c].data +
+          (y / image->comps[c].dy) * image->comps[c].w;
+      unpack_row_8_sub (data_out + 1 + c, 4, row, image->comps[c].dx, off[c],
+          w);
     }
     data_out += dstride;
   }
@@ -668,33 +747,27 @@ fill_frame_planar8_3_generic (GstVideoFrame * frame, opj_image_t * image)
 static void
 fill_frame_planar8_4_generic (GstVideoFrame * frame, opj_image_t * image)
 {
-  gint x, y, w, h, c;
-  guint8 *data_out, *tmp;
-  const gint *data_in[4];
+  gint y, w, h, c;
+  guint8 *data_out;
+  const gint *row;
   gint dstride;
-  gint dx[4], dy[4], off[4];
+  gint off[4];
 
   w = GST_VIDEO_FRAME_WIDTH (frame);
   h = GST_VIDEO_FRAME_HEIGHT (frame);
   data_out = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
   dstride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
 
-  for (c = 0; c < 4; c++) {
-    data_in[c] = image->comps[c].data;
-    dx[c] = image->comps[c].dx;
-    dy[c] = image->comps[c].dy;
+  for (c = 0; c < 4; c++)
     off[c] = 0x80 * image->comps[c].sgnd;
-  }
 
   for (y = 0; y < h; y++) {
-    tmp = data_out;
-
-    for (x = 0; x < w; x++) {
-      tmp[0] = off[3] + data_in[3][((y / dy[3]) * w + x) / dx[3]];
-      tmp[1] = off[0] + data_in[0][((y / dy[0]) * w + x) / dx[0]];
-      tmp[2] = off[1] + data_in[1][((y / dy[1]) * w + x) / dx[1]];
-      tmp[3] = off[2] + data_in[2][((y / dy[2]) * w + x) / dx[2]];
-      tmp += 4;
+    /* alpha first, then the colour channels */
+    for (c = 0; c < 4; c++) {
+      row = image->comps[c].data +
+          (y / image->comps[c].dy) * image->comps[c].w;
+      unpack_row_8_sub (data_out + (c + 1) % 4, 4, row, image->comps[c].dx,
+          off[c], w);
     }
     data_out += dstride;
   }
@@ -704,10 +777,10 @@ static void
 fill_frame_planar16_3_generic (GstVideoFrame * frame, opj_image_t * image)
 {
   gint x, y, w, h, c;
-  guint16 *data_out, *tmp;
-  const gint *data_in[3];
+  guint16 *data_out;
+  const gint *row;
   gint dstride;
-  gint dx[3], dy[3], shift[3], off[3];
+  gint shift[3], off[3];
 
   w = GST_VIDEO_FRAME_WIDTH (frame);
   h = GST_VIDEO_FRAME_HEIGHT (frame);
@@ -715,9 +788,6 @@ fill_frame_planar16_3_generic (GstVideoFrame * frame, opj_image_t * image)
   dstride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0) / 2;
 
   for (c = 0; c < 3; c++) {
-    dx[c] = image->comps[c].dx;
-    dy[c] = image->comps[c].dy;
-    data_in[c] = image->comps[c].data;
     off[c] = (1 << (image->comps[c].prec - 1)) * image->comps[c].sgnd;
     shift[c] =
         MAX (MIN (GST_VIDEO_FRAME_COMP_DEPTH (frame, c) - image->comps[c].prec,
@@ -725,14 +795,14 @@ fill_frame_planar16_3_generic (GstVideoFrame * frame, opj_image_t * image)
   }
 
   for (y = 0; y < h; y++) {
-    tmp = data_out;
-
-    for (x = 0; x < w; x++) {
-      tmp[0] = 0xff;
-      tmp[1] = off[0] + (data_in[0][((y / dy[0]) * w + x) / dx[0]] << shift[0]);
-      tmp[2] = off[1] + (data_in[1][((y / dy[1]) * w + x) / dx[1]] << shift[1]);
-      tmp[3] = off[2] + (data_in[2][((y / dy[2]) * w + x) / dx[2]] << shift[2]);
-      tmp += 4;
+    for (x = 0; x < w; x++)
+      data_out[4 * x] = 0xff;
+
+    for (c = 0; c < 3; c++) {
+      row = image->comps[c].data +
+          (y / image->comps[c].dy) * image->comps[c].w;
+      unpack_row_16_sub (data_out + 1 + c, 4, row, image->comps[c].dx,
+          off[c], shift[c], w);
     }
     data_out += dstride;
   }
@@ -741,11 +811,11 @@ fill_frame_planar16_3_generic (GstVideoFrame * frame, opj_image_t * image)
 static void
 fill_frame_planar16_4_generic (GstVideoFrame * frame, opj_image_t * image)
 {
-  gint x, y, w, h, c;
-  guint16 *data_out, *tmp;
-  const gint *data_in[4];
+  gint y, w, h, c;
+  guint16 *data_out;
+  const gint *row;
   gint dstride;
-  gint dx[4], dy[4], shift[4], off[4];
+  gint shift[4], off[4];
 
   w = GST_VIDEO_FRAME_WIDTH (frame);
   h = GST_VIDEO_FRAME_HEIGHT (frame);
@@ -753,9 +823,6 @@ fill_frame_planar16_4_generic (GstVideoFrame * frame, opj_image_t * image)
   dstride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0) / 2;
 
   for (c = 0; c < 4; c++) {
-    dx[c] = image->comps[c].dx;
-    dy[c] = image->comps[c].dy;
-    data_in[c] = image->comps[c].data;
     off[c] = (1 << (image->comps[c].prec - 1)) * image->comps[c].sgnd;
     shift[c] =
         MAX (MIN (GST_VIDEO_FRAME_COMP_DEPTH (frame, c) - image->comps[c].prec,
@@ -763,14 +830,12 @@ fill_frame_planar16_4_generic (GstVideoFrame * frame, opj_image_t * image)
   }
 
   for (y = 0; y < h; y++) {
-    tmp = data_out;
-
-    for (x = 0; x < w; x++) {
-      tmp[0] = off[3] + (data_in[3][((y / dy[3]) * w + x) / dx[3]] << shift[3]);
-      tmp[1] = off[0] + (data_in[0][((y / dy[0]) * w + x) / dx[0]] << shift[0]);
-      tmp[2] = off[1] + (data_in[1][((y / dy[1]) * w + x) / dx[1]] << shift[1]);
-      tmp[3] = off[2] + (data_in[2][((y / dy[2]) * w + x) / dx[2]] << shift[2]);
-      tmp += 4;
+    /* alpha first, then the colour channels */
+    for (c = 0; c < 4; c++) {
+      row = image->comps[c].data +
+          (y / image->comps[c].dy) * image->comps[c].w;
+      unpack_row_16_sub (data_out + (c + 1) % 4, 4, row, image->comps[c].dx,
+          off[c], shift[c], w);
     }
     data_out += dstride;
   }
@@ -1001,6 +1066,10 @@ gst_openjpeg_dec_negotiate (GstOpenJPEGDec * self, opj_image_t * image)
   width = image->x1 - image->x0;
   height = image->y1 - image->y0;
 
+  /* a stripe only covers part of the frame, the caps have the full height */
+  if (self->num_stripes > 1)
+    height = GST_VIDEO_INFO_HEIGHT (&self->input_state->info);
+
   if (!self->output_state ||
       self->output_state->info.finfo->format != format ||
       self->output_state->info.width != width ||
@@ -1106,126 +1175,429 @@ seek_fn (OPJ_OFF_T p_nb_bytes, void *p_user_data)
   return OPJ_TRUE;
 }
 
-static GstFlowReturn
-gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
-    GstVideoCodecFrame * frame)
+struct _GstOpenJPEGDecOutput
 {
-  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
-  GstFlowReturn ret = GST_FLOW_OK;
-  gint64 deadline;
+  GstVideoCodecFrame *frame;
+  GstVideoFrame vframe;
+  /* set while outputting the stripes, in the streaming thread */
+  gboolean failed;
+};
+
+typedef struct
+{
+  /* stripe frame to release once decoded, NULL for the first stripe whose
+   * frame is the output frame */
+  GstVideoCodecFrame *frame;
+  GstOpenJPEGDecOutput *output;
+  gboolean last;
+
+  GstBuffer *input_buffer;
   GstMapInfo map;
+  gboolean mapped;
   opj_codec_t *dec;
   opj_stream_t *stream;
   MemStream mstream;
   opj_image_t *image;
+
+  /* part of the output frame this job fills */
   GstVideoFrame vframe;
+  void (*fill_frame) (GstVideoFrame * frame, opj_image_t * image);
+
+  /* set by the decoding thread */
+  gboolean done;
+  gboolean failed;
+} GstOpenJPEGDecJob;
+
+static void
+gst_openjpeg_dec_output_free (GstOpenJPEGDecOutput * output)
+{
+  gst_video_frame_unmap (&output->vframe);
+  gst_video_codec_frame_unref (output->frame);
+  g_slice_free (GstOpenJPEGDecOutput, output);
+}
+
+static void
+gst_openjpeg_dec_job_clear_codec (GstOpenJPEGDecJob * job)
+{
+  if (job->image) {
+    opj_image_destroy (job->image);
+    job->image = NULL;
+  }
+  if (job->stream) {
+    opj_stream_destroy (job->stream);
+    job->stream = NULL;
+  }
+  if (job->dec) {
+    opj_destroy_codec (job->dec);
+    job->dec = NULL;
+  }
+  if (job->mapped) {
+    gst_buffer_unmap (job->input_buffer, &job->map);
+    job->mapped = FALSE;
+  }
+  gst_buffer_replace (&job->input_buffer, NULL);
+}
+
+static void
+gst_openjpeg_dec_job_free (GstOpenJPEGDecJob * job)
+{
+  gst_openjpeg_dec_job_clear_codec (job);
+  if (job->frame)
+    gst_video_codec_frame_unref (job->frame);
+  if (job->last && job->output)
+    gst_openjpeg_dec_output_free (job->output);
+  g_slice_free (GstOpenJPEGDecJob, job);
+}
+
+/* Sets up @view to cover the rows @y0 to @y1 of @vframe. The stripe must
+ * start on a row of every sub-sampled component. */
+static gboolean
+gst_openjpeg_dec_get_stripe_view (GstVideoFrame * vframe, gint y0, gint y1,
+    GstVideoFrame * view)
+{
+  const GstVideoFormatInfo *finfo = vframe->info.finfo;
+  gboolean done[GST_VIDEO_MAX_PLANES] = { FALSE, };
+  gint c, p;
+
+  if (y0 < 0 || y1 <= y0 || y1 > GST_VIDEO_FRAME_HEIGHT (vframe))
+    return FALSE;
+
+  *view = *vframe;
+  GST_VIDEO_INFO_HEIGHT (&view->info) = y1 - y0;
+
+  for (c = 0; c < GST_VIDEO_FRAME_N_COMPONENTS (vframe); c++) {
+    if (y0 % (1 << GST_VIDEO_FORMAT_INFO_H_SUB (finfo, c)) != 0)
+      return FALSE;
+
+    p = GST_VIDEO_FORMAT_INFO_PLANE (finfo, c);
+    if (done[p])
+      continue;
+
+    view->data[p] = (guint8 *) view->data[p] +
+        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, c, y0) *
+        GST_VIDEO_FRAME_PLANE_STRIDE (vframe, p);
+    done[p] = TRUE;
+  }
+
+  return TRUE;
+}
+
+static gint
+gst_openjpeg_dec_get_max_threads (GstOpenJPEGDec * self)
+{
+  gint max_threads = g_atomic_int_get (&self->max_threads);
+
+  if (max_threads > 0)
+    return max_threads;
+
+  /* don't spawn more threads than there are processors when decoding
+   * several frames in parallel */
+  if (self->num_threads > 0)
+    return MAX (self->num_procs / (gint) self->num_threads, 1);
+
+  return self->num_procs;
+}
+
+/* GThreadPool function, also called directly without thread pool */
+static void
+gst_openjpeg_dec_decode_job (gpointer data, gpointer user_data)
+{
+  GstOpenJPEGDecJob *job = data;
+  GstOpenJPEGDec *self = user_data;
+  gboolean failed = FALSE;
+  gint i;
+
+  GST_LOG_OBJECT (self, "Decoding rows %u to %u of frame %u", job->image->y0,
+      job->image->y1, job->output->frame->system_frame_number);
+
+  if (!opj_decode (job->dec, job->stream, job->image)) {
+    failed = TRUE;
+  } else {
+    for (i = 0; i < job->image->numcomps; i++) {
+      if (job->image->comps[i].data == NULL)
+        failed = TRUE;
+    }
+  }
+
+  if (!failed) {
+    job->fill_frame (&job->vframe, job->image);
+    opj_end_decompress (job->dec, job->stream);
+  }
+
+  gst_openjpeg_dec_job_clear_codec (job);
+
+  g_mutex_lock (&self->jobs_lock);
+  job->failed = failed;
+  job->done = TRUE;
+  g_cond_broadcast (&self->jobs_cond);
+  g_mutex_unlock (&self->jobs_lock);
+}
+
+static GstFlowReturn
+gst_openjpeg_dec_finish_output (GstOpenJPEGDec * self,
+    GstOpenJPEGDecOutput * output)
+{
+  GstVideoDecoder *decoder = GST_VIDEO_DECODER (self);
+  GstVideoCodecFrame *frame = gst_video_codec_frame_ref (output->frame);
+  gboolean failed = output->failed;
+
+  gst_openjpeg_dec_output_free (output);
+
+  if (failed) {
+    gst_video_decoder_release_frame (decoder, frame);
+    return GST_FLOW_OK;
+  }
+
+  return gst_video_decoder_finish_frame (decoder, frame);
+}
+
+/* Outputs the decoded jobs at the head of the queue, in order, waiting
+ * until at most @max_pending jobs are left. Once a job failed with a
+ * flow error, all the following ones are dropped. */
+static GstFlowReturn
+gst_openjpeg_dec_finish_jobs (GstOpenJPEGDec * self, guint max_pending)
+{
+  GstVideoDecoder *decoder = GST_VIDEO_DECODER (self);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstOpenJPEGDecJob *job;
+
+  g_mutex_lock (&self->jobs_lock);
+  while ((job = g_queue_peek_head (&self->jobs)) != NULL) {
+    if (!job->done) {
+      if (g_queue_get_length (&self->jobs) <= max_pending)
+        break;
+      g_cond_wait (&self->jobs_cond, &self->jobs_lock);
+      continue;
+    }
+    g_queue_pop_head (&self->jobs);
+    g_mutex_unlock (&self->jobs_lock);
+
+    if (ret == GST_FLOW_OK) {
+      if (job->failed) {
+        job->output->failed = TRUE;
+        GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
+            ("Failed to decode OpenJPEG stream"), (NULL), ret);
+      }
+      if (job->frame) {
+        gst_video_decoder_release_frame (decoder, job->frame);
+        job->frame = NULL;
+      }
+      if (job->last) {
+        GstFlowReturn output_ret =
+            gst_openjpeg_dec_finish_output (self, job->output);
+
+        job->output = NULL;
+        if (ret == GST_FLOW_OK)
+          ret = output_ret;
+      }
+    }
+    gst_openjpeg_dec_job_free (job);
+
+    g_mutex_lock (&self->jobs_lock);
+  }
+  g_mutex_unlock (&self->jobs_lock);
+
+  return ret;
+}
+
+/* Queues the output frame still waiting for stripes, so that it gets
+ * dropped in order once its stripes are decoded */
+static void
+gst_openjpeg_dec_queue_incomplete (GstOpenJPEGDec * self)
+{
+  GstOpenJPEGDecJob *job;
+
+  if (!self->current_output)
+    return;
+
+  GST_WARNING_OBJECT (self, "Missing stripes in frame %u",
+      self->current_output->frame->system_frame_number);
+
+  job = g_slice_new0 (GstOpenJPEGDecJob);
+  job->output = self->current_output;
+  job->output->failed = TRUE;
+  job->last = TRUE;
+  job->done = TRUE;
+  self->current_output = NULL;
+
+  g_mutex_lock (&self->jobs_lock);
+  g_queue_push_tail (&self->jobs, job);
+  g_mutex_unlock (&self->jobs_lock);
+}
+
+/* Waits for the jobs being decoded and discards them */
+static void
+gst_openjpeg_dec_drop_jobs (GstOpenJPEGDec * self)
+{
+  GstOpenJPEGDecJob *job;
+
+  g_mutex_lock (&self->jobs_lock);
+  while ((job = g_queue_peek_head (&self->jobs)) != NULL) {
+    if (!job->done) {
+      g_cond_wait (&self->jobs_cond, &self->jobs_lock);
+      continue;
+    }
+    g_queue_pop_head (&self->jobs);
+    gst_openjpeg_dec_job_free (job);
+  }
+  g_mutex_unlock (&self->jobs_lock);
+
+  if (self->current_output) {
+    gst_openjpeg_dec_output_free (self->current_output);
+    self->current_output = NULL;
+  }
+}
+
+static GstFlowReturn
+gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+  GstFlowReturn ret = GST_FLOW_OK;
+  gint64 deadline;
+  GstOpenJPEGDecJob *job;
+  GstOpenJPEGDecOutput *output = NULL;
   opj_dparameters_t params;
   gint max_threads;
+  gboolean stripe_mode = self->num_stripes > 1;
 
   GST_DEBUG_OBJECT (self, "Handling frame");
 
+  /* the other stripes of the frame would be missing their first one */
   deadline = gst_video_decoder_get_max_decode_time (decoder, frame);
-  if (deadline < 0) {
+  if (deadline < 0 && !stripe_mode) {
     GST_LOG_OBJECT (self, "Dropping too late frame: deadline %" G_GINT64_FORMAT,
         deadline);
     ret = gst_video_decoder_drop_frame (decoder, frame);
     return ret;
   }
 
-  dec = opj_create_decompress (self->codec_format);
-  if (!dec)
+  job = g_slice_new0 (GstOpenJPEGDecJob);
+
+  job->dec = opj_create_decompress (self->codec_format);
+  if (!job->dec)
     goto initialization_error;
 
   if (G_UNLIKELY (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >=
           GST_LEVEL_TRACE)) {
-    opj_set_info_handler (dec, gst_openjpeg_dec_opj_info, self);
-    opj_set_warning_handler (dec, gst_openjpeg_dec_opj_warning, self);
-    opj_set_error_handler (dec, gst_openjpeg_dec_opj_error, self);
+    opj_set_info_handler (job->dec, gst_openjpeg_dec_opj_info, self);
+    opj_set_warning_handler (job->dec, gst_openjpeg_dec_opj_warning, self);
+    opj_set_error_handler (job->dec, gst_openjpeg_dec_opj_error, self);
   } else {
-    opj_set_info_handler (dec, NULL, NULL);
-    opj_set_warning_handler (dec, NULL, NULL);
-    opj_set_error_handler (dec, NULL, NULL);
+    opj_set_info_handler (job->dec, NULL, NULL);
+    opj_set_warning_handler (job->dec, NULL, NULL);
+    opj_set_error_handler (job->dec, NULL, NULL);
   }
 
   params = self->params;
   if (self->ncomps)
     params.jpwl_exp_comps = self->ncomps;
-  if (!opj_setup_decoder (dec, &params))
+  if (!opj_setup_decoder (job->dec, &params))
     goto open_error;
 
-  max_threads = g_atomic_int_get (&self->max_threads);
-  if (max_threads == 0)
-    max_threads = self->num_procs;
-  if (!opj_codec_set_threads (dec, max_threads))
+  max_threads = gst_openjpeg_dec_get_max_threads (self);
+  if (!opj_codec_set_threads (job->dec, max_threads))
     GST_WARNING_OBJECT (self, "Failed to set %d number of threads",
         max_threads);
 
-  if (!gst_buffer_map (frame->input_buffer, &map, GST_MAP_READ))
+  job->input_buffer = gst_buffer_ref (frame->input_buffer);
+  if (!gst_buffer_map (job->input_buffer, &job->map, GST_MAP_READ))
     goto map_read_error;
+  job->mapped = TRUE;
 
-  if (self->is_jp2c && map.size < 8)
+  if (self->is_jp2c && job->map.size < 8)
     goto open_error;
 
-  stream = opj_stream_create (4096, OPJ_TRUE);
-  if (!stream)
+  job->stream = opj_stream_create (4096, OPJ_TRUE);
+  if (!job->stream)
     goto open_error;
 
-  mstream.data = map.data + (self->is_jp2c ? 8 : 0);
-  mstream.offset = 0;
-  mstream.size = map.size - (self->is_jp2c ? 8 : 0);
+  job->mstream.data = job->map.data + (self->is_jp2c ? 8 : 0);
+  job->mstream.offset = 0;
+  job->mstream.size = job->map.size - (self->is_jp2c ? 8 : 0);
 
-  opj_stream_set_read_function (stream, read_fn);
-  opj_stream_set_write_function (stream, write_fn);
-  opj_stream_set_skip_function (stream, skip_fn);
-  opj_stream_set_seek_function (stream, seek_fn);
-  opj_stream_set_user_data (stream, &mstream, NULL);
-  opj_stream_set_user_data_length (stream, mstream.size);
-
-  image = NULL;
-  if (!opj_read_header (stream, dec, &image))
-    goto decode_error;
+  opj_stream_set_read_function (job->stream, read_fn);
+  opj_stream_set_write_function (job->stream, write_fn);
+  opj_stream_set_skip_function (job->stream, skip_fn);
+  opj_stream_set_seek_function (job->stream, seek_fn);
+  opj_stream_set_user_data (job->stream, &job->mstream, NULL);
+  opj_stream_set_user_data_length (job->stream, job->mstream.size);
 
-  if (!opj_decode (dec, stream, image))
+  if (!opj_read_header (job->stream, job->dec, &job->image))
     goto decode_error;
 
-  {
-    gint i;
-
-    for (i = 0; i < image->numcomps; i++) {
-      if (image->comps[i].data == NULL)
-        goto decode_error;
+  /* Everything that needs the stream lock happens here, only decoding and
+   * filling the mapped output frame are left to the job. Stripes go into
+   * the output frame allocated for the first stripe of the frame. */
+  if (!stripe_mode || job->image->y0 == 0) {
+    gst_openjpeg_dec_queue_incomplete (self);
+
+    ret = gst_openjpeg_dec_negotiate (self, job->image);
+    if (ret != GST_FLOW_OK)
+      goto negotiate_error;
+
+    ret = gst_video_decoder_allocate_output_frame (decoder, frame);
+    if (ret != GST_FLOW_OK)
+      goto allocate_error;
+
+    output = g_slice_new0 (GstOpenJPEGDecOutput);
+    if (!gst_video_frame_map (&output->vframe, &self->output_state->info,
+            frame->output_buffer, GST_MAP_WRITE)) {
+      g_slice_free (GstOpenJPEGDecOutput, output);
+      goto map_write_error;
     }
+    output->frame = frame;
+    self->current_output = output;
+  } else if (self->current_output) {
+    output = self->current_output;
+    job->frame = frame;
+  } else {
+    GST_WARNING_OBJECT (self, "Dropping stripe without first stripe");
+    gst_openjpeg_dec_job_free (job);
+    return gst_video_decoder_drop_frame (decoder, frame);
   }
 
-  gst_buffer_unmap (frame->input_buffer, &map);
+  job->output = output;
+  job->fill_frame = self->fill_frame;
 
-  ret = gst_openjpeg_dec_negotiate (self, image);
-  if (ret != GST_FLOW_OK)
-    goto negotiate_error;
-
-  ret = gst_video_decoder_allocate_output_frame (decoder, frame);
-  if (ret != GST_FLOW_OK)
-    goto allocate_error;
-
-  if (!gst_video_frame_map (&vframe, &self->output_state->info,
-          frame->output_buffer, GST_MAP_WRITE))
-    goto map_write_error;
+  if (stripe_mode) {
+    if (!gst_openjpeg_dec_get_stripe_view (&output->vframe, job->image->y0,
+            job->image->y1, &job->vframe))
+      goto stripe_error;
+    job->last =
+        ((gint) job->image->y1 == GST_VIDEO_FRAME_HEIGHT (&output->vframe));
+  } else {
+    job->vframe = output->vframe;
+    job->last = TRUE;
+  }
 
-  self->fill_frame (&vframe, image);
+  if (job->last)
+    self->current_output = NULL;
 
-  gst_video_frame_unmap (&vframe);
+  /* Stripes and frames are queued in output order and, with a thread pool,
+   * decoded in parallel. Up to num-threads of them are left decoding while
+   * the previous ones are output. */
+  g_mutex_lock (&self->jobs_lock);
+  g_queue_push_tail (&self->jobs, job);
+  g_mutex_unlock (&self->jobs_lock);
 
-  opj_end_decompress (dec, stream);
-  opj_stream_destroy (stream);
-  opj_image_destroy (image);
-  opj_destroy_codec (dec);
+  if (self->pool)
+    g_thread_pool_push (self->pool, job, NULL);
+  else
+    gst_openjpeg_dec_decode_job (job, self);
 
-  ret = gst_video_decoder_finish_frame (decoder, frame);
+  /* A frame is output as soon as all its stripes are decoded, for low
+   * latency */
+  if (stripe_mode && job->last)
+    ret = gst_openjpeg_dec_finish_jobs (self, 0);
+  else
+    ret = gst_openjpeg_dec_finish_jobs (self, self->num_threads);
 
   return ret;
 
 initialization_error:
   {
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
     GST_ELEMENT_ERROR (self, LIBRARY, INIT,
         ("Failed to initialize OpenJPEG decoder"), (NULL));
@@ -1233,7 +1605,7 @@ initialization_error:
   }
 map_read_error:
   {
-    opj_destroy_codec (dec);
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, FAILED,
@@ -1242,8 +1614,7 @@ map_read_error:
   }
 open_error:
   {
-    opj_destroy_codec (dec);
-    gst_buffer_unmap (frame->input_buffer, &map);
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, LIBRARY, INIT,
@@ -1252,11 +1623,7 @@ open_error:
   }
 decode_error:
   {
-    if (image)
-      opj_image_destroy (image);
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-    gst_buffer_unmap (frame->input_buffer, &map);
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
@@ -1265,9 +1632,7 @@ decode_error:
   }
 negotiate_error:
   {
-    opj_image_destroy (image);
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, NEGOTIATION,
@@ -1276,9 +1641,7 @@ negotiate_error:
   }
 allocate_error:
   {
-    opj_image_destroy (image);
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, FAILED,
@@ -1287,15 +1650,52 @@ allocate_error:
   }
 map_write_error:
   {
-    opj_image_destroy (image);
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
+    gst_openjpeg_dec_job_free (job);
     gst_video_codec_frame_unref (frame);
 
     GST_ELEMENT_ERROR (self, CORE, FAILED,
         ("Failed to map output buffer"), (NULL));
     return GST_FLOW_ERROR;
   }
+stripe_error:
+  {
+    /* the output frame is dropped with the next first stripe */
+    output->failed = TRUE;
+    GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
+        ("Invalid stripe from row %u to %u", job->image->y0, job->image->y1),
+        (NULL), ret);
+
+    if (job->frame) {
+      job->frame = NULL;
+      gst_video_decoder_release_frame (decoder, frame);
+    }
+    gst_openjpeg_dec_job_free (job);
+    return ret;
+  }
+}
+
+static GstFlowReturn
+gst_openjpeg_dec_finish (GstVideoDecoder * decoder)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+
+  GST_DEBUG_OBJECT (self, "Draining");
+
+  gst_openjpeg_dec_queue_incomplete (self);
+
+  return gst_openjpeg_dec_finish_jobs (self, 0);
+}
+
+static gboolean
+gst_openjpeg_dec_flush (GstVideoDecoder * decoder)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+
+  GST_DEBUG_OBJECT (self, "Flushing");
+
+  gst_openjpeg_dec_drop_jobs (self);
+
+  return TRUE;
 }
 
 static gboolean
@@ -43,6 +43,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstOpenJPEGDec GstOpenJPEGDec;
 typedef struct _GstOpenJPEGDecClass GstOpenJPEGDecClass;
+typedef struct _GstOpenJPEGDecOutput GstOpenJPEGDecOutput;
 
 struct _GstOpenJPEGDec
 {
@@ -59,10 +60,21 @@ struct _GstOpenJPEGDec
   gint ncomps;
   gint max_threads;  /* atomic */
   gint num_procs;
+  gint num_stripes;
+  guint num_threads;
 
   void (*fill_frame) (GstVideoFrame *frame, opj_image_t * image);
 
   opj_dparameters_t params;
+
+  /* Frames or stripes being decoded by the thread pool, in output order */
+  GThreadPool *pool;
+  GMutex jobs_lock;
+  GCond jobs_cond;
+  GQueue jobs;
+
+  /* Output frame still waiting for some of its stripes */
+  GstOpenJPEGDecOutput *current_output;
 };
 
 struct _GstOpenJPEGDecClass
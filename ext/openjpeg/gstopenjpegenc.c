@@ -69,6 +69,7 @@ enum
   PROP_TILE_WIDTH,
   PROP_TILE_HEIGHT,
   PROP_NUM_STRIPES,
+  PROP_NUM_THREADS,
   PROP_LAST
 };
 
@@ -80,11 +81,13 @@ enum
 #define DEFAULT_TILE_WIDTH 0
 #define DEFAULT_TILE_HEIGHT 0
 #define GST_OPENJPEG_ENC_DEFAULT_NUM_STRIPES  1
+#define GST_OPENJPEG_ENC_DEFAULT_NUM_THREADS  0
 
 static void gst_openjpeg_enc_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_openjpeg_enc_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
+static void gst_openjpeg_enc_finalize (GObject * object);
 
 static gboolean gst_openjpeg_enc_start (GstVideoEncoder * encoder);
 static gboolean gst_openjpeg_enc_stop (GstVideoEncoder * encoder);
@@ -92,6 +95,10 @@ static gboolean gst_openjpeg_enc_set_format (GstVideoEncoder * encoder,
     GstVideoCodecState * state);
 static GstFlowReturn gst_openjpeg_enc_handle_frame (GstVideoEncoder * encoder,
     GstVideoCodecFrame * frame);
+static GstFlowReturn gst_openjpeg_enc_finish (GstVideoEncoder * encoder);
+static gboolean gst_openjpeg_enc_flush (GstVideoEncoder * encoder);
+static void gst_openjpeg_enc_encode_job (gpointer data, gpointer user_data);
+static void gst_openjpeg_enc_drop_jobs (GstOpenJPEGEnc * self);
 static gboolean gst_openjpeg_enc_propose_allocation (GstVideoEncoder * encoder,
     GstQuery * query);
 
@@ -148,6 +155,7 @@ gst_openjpeg_enc_class_init (GstOpenJPEGEncClass * klass)
 
   gobject_class->set_property = gst_openjpeg_enc_set_property;
   gobject_class->get_property = gst_openjpeg_enc_get_property;
+  gobject_class->finalize = gst_openjpeg_enc_finalize;
 
   g_object_class_install_property (gobject_class, PROP_NUM_LAYERS,
       g_param_spec_int ("num-layers", "Number of layers",
@@ -198,6 +206,25 @@ gst_openjpeg_enc_class_init (GstOpenJPEGEncClass * klass)
           1, G_MAXINT, GST_OPENJPEG_ENC_DEFAULT_NUM_STRIPES,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstOpenJPEGEnc:num-threads:
+   *
+   * Maximum number of threads used to encode stripes or frames
+   * concurrently. In stripe mode, the stripes of each frame are encoded in
+   * parallel and output in order as soon as possible. Otherwise up to this
+   * number of frames are encoded in parallel, which adds as many frames of
+   * latency. (0 = encode in the streaming thread)
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_NUM_THREADS,
+      g_param_spec_uint ("num-threads", "Number of threads",
+          "Max number of threads to encode stripes or frames in parallel "
+          "(0 = encode in the streaming thread)",
+          0, G_MAXINT, GST_OPENJPEG_ENC_DEFAULT_NUM_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gst_element_class_add_static_pad_template (element_class,
       &gst_openjpeg_enc_src_template);
   gst_element_class_add_static_pad_template (element_class,
@@ -215,6 +242,8 @@ gst_openjpeg_enc_class_init (GstOpenJPEGEncClass * klass)
       GST_DEBUG_FUNCPTR (gst_openjpeg_enc_set_format);
   video_encoder_class->handle_frame =
       GST_DEBUG_FUNCPTR (gst_openjpeg_enc_handle_frame);
+  video_encoder_class->finish = GST_DEBUG_FUNCPTR (gst_openjpeg_enc_finish);
+  video_encoder_class->flush = GST_DEBUG_FUNCPTR (gst_openjpeg_enc_flush);
   video_encoder_class->propose_allocation = gst_openjpeg_enc_propose_allocation;
 
   GST_DEBUG_CATEGORY_INIT (gst_openjpeg_enc_debug, "openjpegenc", 0,
@@ -257,6 +286,22 @@ gst_openjpeg_enc_init (GstOpenJPEGEnc * self)
       && self->params.cp_tdy != 0);
 
   self->num_stripes = GST_OPENJPEG_ENC_DEFAULT_NUM_STRIPES;
+  self->num_threads = GST_OPENJPEG_ENC_DEFAULT_NUM_THREADS;
+
+  g_mutex_init (&self->jobs_lock);
+  g_cond_init (&self->jobs_cond);
+  g_queue_init (&self->jobs);
+}
+
+static void
+gst_openjpeg_enc_finalize (GObject * object)
+{
+  GstOpenJPEGEnc *self = GST_OPENJPEG_ENC (object);
+
+  g_mutex_clear (&self->jobs_lock);
+  g_cond_clear (&self->jobs_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 static void
@@ -294,6 +339,9 @@ gst_openjpeg_enc_set_property (GObject * object, guint prop_id,
     case PROP_NUM_STRIPES:
       self->num_stripes = g_value_get_int (value);
       break;
+    case PROP_NUM_THREADS:
+      self->num_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -331,6 +379,9 @@ gst_openjpeg_enc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_NUM_STRIPES:
       g_value_set_int (value, self->num_stripes);
       break;
+    case PROP_NUM_THREADS:
+      g_value_set_uint (value, self->num_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -341,9 +392,21 @@ static gboolean
 gst_openjpeg_enc_start (GstVideoEncoder * encoder)
 {
   GstOpenJPEGEnc *self = GST_OPENJPEG_ENC (encoder);
+  GError *err = NULL;
 
   GST_DEBUG_OBJECT (self, "Starting");
 
+  if (self->num_threads > 0) {
+    self->pool = g_thread_pool_new (gst_openjpeg_enc_encode_job, self,
+        self->num_threads, FALSE, &err);
+    if (!self->pool) {
+      GST_ELEMENT_ERROR (self, RESOURCE, FAILED,
+          ("Failed to create encoding threads"), ("%s", err->message));
+      g_clear_error (&err);
+      return FALSE;
+    }
+  }
+
   return TRUE;
 }
 
@@ -354,6 +417,12 @@ gst_openjpeg_enc_stop (GstVideoEncoder * video_encoder)
 
   GST_DEBUG_OBJECT (self, "Stopping");
 
+  gst_openjpeg_enc_drop_jobs (self);
+  if (self->pool) {
+    g_thread_pool_free (self->pool, FALSE, TRUE);
+    self->pool = NULL;
+  }
+
   if (self->output_state) {
     gst_video_codec_state_unref (self->output_state);
     self->output_state = NULL;
@@ -623,6 +692,10 @@ gst_openjpeg_enc_set_format (GstVideoEncoder * encoder,
 
   GST_DEBUG_OBJECT (self, "Setting format: %" GST_PTR_FORMAT, state->caps);
 
+  /* Frames still being encoded use the previous format */
+  if (gst_openjpeg_enc_finish (encoder) != GST_FLOW_OK)
+    return FALSE;
+
   if (self->input_state)
     gst_video_codec_state_unref (self->input_state);
   self->input_state = gst_video_codec_state_ref (state);
@@ -768,6 +841,16 @@ gst_openjpeg_enc_set_format (GstVideoEncoder * encoder,
 
   gst_video_encoder_negotiate (GST_VIDEO_ENCODER (encoder));
 
+  /* frames are output once the following ones are queued for encoding */
+  if (self->pool && !stripe_mode && state->info.fps_n > 0) {
+    GstClockTime latency = gst_util_uint64_scale (self->num_threads,
+        state->info.fps_d * GST_SECOND, state->info.fps_n);
+
+    gst_video_encoder_set_latency (encoder, latency, latency);
+  } else {
+    gst_video_encoder_set_latency (encoder, 0, 0);
+  }
+
   return TRUE;
 }
 
@@ -935,17 +1018,280 @@ seek_fn (OPJ_OFF_T p_nb_bytes, void *p_user_data)
   return OPJ_TRUE;
 }
 
+typedef struct
+{
+  GstVideoCodecFrame *frame;
+  guint stripe;
+  gboolean last;
+  opj_cparameters_t params;
+
+  /* set by the encoding thread */
+  gboolean done;
+  GstFlowReturn ret;
+  GstBuffer *output_buffer;
+} GstOpenJPEGEncJob;
+
+static GstOpenJPEGEncJob *
+gst_openjpeg_enc_job_new (GstOpenJPEGEnc * self, GstVideoCodecFrame * frame,
+    guint stripe)
+{
+  GstOpenJPEGEncJob *job = g_slice_new0 (GstOpenJPEGEncJob);
+
+  job->frame = gst_video_codec_frame_ref (frame);
+  job->stripe = stripe;
+  job->last = (stripe == self->num_stripes - 1);
+  job->params = self->params;
+  job->ret = GST_FLOW_OK;
+
+  return job;
+}
+
+static void
+gst_openjpeg_enc_job_free (GstOpenJPEGEncJob * job)
+{
+  if (job->frame)
+    gst_video_codec_frame_unref (job->frame);
+  gst_buffer_replace (&job->output_buffer, NULL);
+  g_slice_free (GstOpenJPEGEncJob, job);
+}
+
+/* Encodes one stripe of @frame. Can be called from any thread, only reads
+ * from @self */
 static GstFlowReturn
-gst_openjpeg_enc_handle_frame (GstVideoEncoder * encoder,
-    GstVideoCodecFrame * frame)
+gst_openjpeg_enc_encode_stripe (GstOpenJPEGEnc * self,
+    GstVideoCodecFrame * frame, guint stripe, opj_cparameters_t * params,
+    GstBuffer ** output_buffer)
 {
-  GstOpenJPEGEnc *self = GST_OPENJPEG_ENC (encoder);
-  GstFlowReturn ret = GST_FLOW_OK;
   opj_codec_t *enc;
   opj_stream_t *stream;
   MemStream mstream;
   opj_image_t *image;
   GstVideoFrame vframe;
+
+  enc = opj_create_compress (self->codec_format);
+  if (!enc)
+    goto initialization_error;
+
+  if (G_UNLIKELY (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >=
+          GST_LEVEL_TRACE)) {
+    opj_set_info_handler (enc, gst_openjpeg_enc_opj_info, self);
+    opj_set_warning_handler (enc, gst_openjpeg_enc_opj_warning, self);
+    opj_set_error_handler (enc, gst_openjpeg_enc_opj_error, self);
+  } else {
+    opj_set_info_handler (enc, NULL, NULL);
+    opj_set_warning_handler (enc, NULL, NULL);
+    opj_set_error_handler (enc, NULL, NULL);
+  }
+
+  if (!gst_video_frame_map (&vframe, &self->input_state->info,
+          frame->input_buffer, GST_MAP_READ))
+    goto map_read_error;
+
+  image = gst_openjpeg_enc_fill_image (self, &vframe, stripe);
+  if (!image)
+    goto fill_image_error;
+  gst_video_frame_unmap (&vframe);
+
+  if (vframe.info.finfo->flags & GST_VIDEO_FORMAT_FLAG_RGB) {
+    params->tcp_mct = 1;
+  }
+  opj_setup_encoder (enc, params, image);
+  stream = opj_stream_create (4096, OPJ_FALSE);
+  if (!stream)
+    goto open_error;
+
+  mstream.allocsize = 4096;
+  mstream.data = g_malloc (mstream.allocsize);
+  mstream.offset = 0;
+  mstream.size = 0;
+
+  opj_stream_set_read_function (stream, read_fn);
+  opj_stream_set_write_function (stream, write_fn);
+  opj_stream_set_skip_function (stream, skip_fn);
+  opj_stream_set_seek_function (stream, seek_fn);
+  opj_stream_set_user_data (stream, &mstream, NULL);
+  opj_stream_set_user_data_length (stream, mstream.size);
+
+  if (!opj_start_compress (enc, image, stream))
+    goto encode_error;
+
+  if (!opj_encode (enc, stream))
+    goto encode_error;
+
+  if (!opj_end_compress (enc, stream))
+    goto encode_error;
+
+  opj_image_destroy (image);
+  opj_stream_destroy (stream);
+  opj_destroy_codec (enc);
+
+  *output_buffer = gst_buffer_new ();
+
+  if (self->is_jp2c) {
+    GstMapInfo map;
+    GstMemory *mem;
+
+    mem = gst_allocator_alloc (NULL, 8, NULL);
+    gst_memory_map (mem, &map, GST_MAP_WRITE);
+    GST_WRITE_UINT32_BE (map.data, mstream.size + 8);
+    GST_WRITE_UINT32_BE (map.data + 4, GST_MAKE_FOURCC ('j', 'p', '2', 'c'));
+    gst_memory_unmap (mem, &map);
+    gst_buffer_append_memory (*output_buffer, mem);
+  }
+
+  gst_buffer_append_memory (*output_buffer,
+      gst_memory_new_wrapped (0, mstream.data, mstream.allocsize, 0,
+          mstream.size, mstream.data, (GDestroyNotify) g_free));
+
+  return GST_FLOW_OK;
+
+initialization_error:
+  {
+    GST_ELEMENT_ERROR (self, LIBRARY, INIT,
+        ("Failed to initialize OpenJPEG encoder"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+map_read_error:
+  {
+    opj_destroy_codec (enc);
+
+    GST_ELEMENT_ERROR (self, CORE, FAILED,
+        ("Failed to map input buffer"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+fill_image_error:
+  {
+    opj_destroy_codec (enc);
+    gst_video_frame_unmap (&vframe);
+
+    GST_ELEMENT_ERROR (self, LIBRARY, INIT,
+        ("Failed to fill OpenJPEG image"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+open_error:
+  {
+    opj_image_destroy (image);
+    opj_destroy_codec (enc);
+
+    GST_ELEMENT_ERROR (self, LIBRARY, INIT,
+        ("Failed to open OpenJPEG data"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+encode_error:
+  {
+    opj_stream_destroy (stream);
+    g_free (mstream.data);
+    opj_image_destroy (image);
+    opj_destroy_codec (enc);
+
+    GST_ELEMENT_ERROR (self, STREAM, ENCODE,
+        ("Failed to encode OpenJPEG stream"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+}
+
+/* GThreadPool function, also called directly without thread pool */
+static void
+gst_openjpeg_enc_encode_job (gpointer data, gpointer user_data)
+{
+  GstOpenJPEGEncJob *job = data;
+  GstOpenJPEGEnc *self = user_data;
+  GstFlowReturn ret;
+  GstBuffer *output_buffer = NULL;
+
+  GST_LOG_OBJECT (self, "Encoding stripe %u of frame %u", job->stripe,
+      job->frame->system_frame_number);
+
+  ret = gst_openjpeg_enc_encode_stripe (self, job->frame, job->stripe,
+      &job->params, &output_buffer);
+
+  g_mutex_lock (&self->jobs_lock);
+  job->ret = ret;
+  job->output_buffer = output_buffer;
+  job->done = TRUE;
+  g_cond_broadcast (&self->jobs_cond);
+  g_mutex_unlock (&self->jobs_lock);
+}
+
+/* Outputs the encoded jobs at the head of the queue, in order, waiting
+ * until at most @max_pending jobs are left. Once a job failed, the
+ * following ones are dropped and their frames released. */
+static GstFlowReturn
+gst_openjpeg_enc_finish_jobs (GstOpenJPEGEnc * self, guint max_pending)
+{
+  GstVideoEncoder *encoder = GST_VIDEO_ENCODER (self);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstOpenJPEGEncJob *job;
+  GstVideoCodecFrame *frame;
+
+  g_mutex_lock (&self->jobs_lock);
+  while ((job = g_queue_peek_head (&self->jobs)) != NULL) {
+    if (!job->done) {
+      if (g_queue_get_length (&self->jobs) <= max_pending)
+        break;
+      g_cond_wait (&self->jobs_cond, &self->jobs_lock);
+      continue;
+    }
+    g_queue_pop_head (&self->jobs);
+    g_mutex_unlock (&self->jobs_lock);
+
+    if (ret == GST_FLOW_OK)
+      ret = job->ret;
+
+    frame = job->frame;
+    if (ret == GST_FLOW_OK) {
+      frame->output_buffer = job->output_buffer;
+      job->output_buffer = NULL;
+      GST_VIDEO_CODEC_FRAME_SET_SYNC_POINT (frame);
+    }
+
+    /* Frames are always finished, without an output buffer after a
+     * failure, so that the base class releases them */
+    if (job->last) {
+      GstFlowReturn finish_ret;
+
+      job->frame = NULL;
+      finish_ret = gst_video_encoder_finish_frame (encoder, frame);
+      if (ret == GST_FLOW_OK)
+        ret = finish_ret;
+    } else if (ret == GST_FLOW_OK) {
+      ret = gst_video_encoder_finish_subframe (encoder, frame);
+    }
+    gst_openjpeg_enc_job_free (job);
+
+    g_mutex_lock (&self->jobs_lock);
+  }
+  g_mutex_unlock (&self->jobs_lock);
+
+  return ret;
+}
+
+/* Waits for the jobs being encoded and discards them */
+static void
+gst_openjpeg_enc_drop_jobs (GstOpenJPEGEnc * self)
+{
+  GstOpenJPEGEncJob *job;
+
+  g_mutex_lock (&self->jobs_lock);
+  while ((job = g_queue_peek_head (&self->jobs)) != NULL) {
+    if (!job->done) {
+      g_cond_wait (&self->jobs_cond, &self->jobs_lock);
+      continue;
+    }
+    g_queue_pop_head (&self->jobs);
+    gst_openjpeg_enc_job_free (job);
+  }
+  g_mutex_unlock (&self->jobs_lock);
+}
+
+static GstFlowReturn
+gst_openjpeg_enc_handle_frame (GstVideoEncoder * encoder,
+    GstVideoCodecFrame * frame)
+{
+  GstOpenJPEGEnc *self = GST_OPENJPEG_ENC (encoder);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstOpenJPEGEncJob *job;
+  GstVideoFrame vframe;
   guint i;
   GstCaps *current_caps;
   GstStructure *s;
@@ -965,7 +1311,6 @@ gst_openjpeg_enc_handle_frame (GstVideoEncoder * encoder,
       GST_ERROR_OBJECT (self,
           "Number of stripes set to %d, but alignment=stripe not supported downstream",
           self->num_stripes);
-      gst_video_codec_frame_unref (frame);
       ret = GST_FLOW_NOT_NEGOTIATED;
       goto done;
     }
@@ -974,10 +1319,10 @@ gst_openjpeg_enc_handle_frame (GstVideoEncoder * encoder,
      * number of wavelet resolutions must not exceed floor(log(stripe height)) + 1 */
     if (!gst_video_frame_map (&vframe, &self->input_state->info,
             frame->input_buffer, GST_MAP_READ)) {
-      gst_video_codec_frame_unref (frame);
       GST_ELEMENT_ERROR (self, CORE, FAILED,
           ("Failed to map input buffer"), (NULL));
-      return GST_FLOW_ERROR;
+      ret = GST_FLOW_ERROR;
+      goto done;
     }
     /* find stripe with least height */
     min_res =
@@ -991,145 +1336,71 @@ gst_openjpeg_enc_handle_frame (GstVideoEncoder * encoder,
     gst_video_frame_unmap (&vframe);
   }
 
-
+  /* Stripes and frames are queued in output order and, with a thread pool,
+   * encoded in parallel. Up to num-threads of them are left encoding while
+   * the previous ones are output. */
   for (i = 0; i < self->num_stripes; ++i) {
-    enc = opj_create_compress (self->codec_format);
-    if (!enc)
-      goto initialization_error;
-
-    if (G_UNLIKELY (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >=
-            GST_LEVEL_TRACE)) {
-      opj_set_info_handler (enc, gst_openjpeg_enc_opj_info, self);
-      opj_set_warning_handler (enc, gst_openjpeg_enc_opj_warning, self);
-      opj_set_error_handler (enc, gst_openjpeg_enc_opj_error, self);
-    } else {
-      opj_set_info_handler (enc, NULL, NULL);
-      opj_set_warning_handler (enc, NULL, NULL);
-      opj_set_error_handler (enc, NULL, NULL);
-    }
-
-    if (!gst_video_frame_map (&vframe, &self->input_state->info,
-            frame->input_buffer, GST_MAP_READ))
-      goto map_read_error;
-
-    image = gst_openjpeg_enc_fill_image (self, &vframe, i);
-    if (!image)
-      goto fill_image_error;
-    gst_video_frame_unmap (&vframe);
-
-    if (vframe.info.finfo->flags & GST_VIDEO_FORMAT_FLAG_RGB) {
-      self->params.tcp_mct = 1;
-    }
-    opj_setup_encoder (enc, &self->params, image);
-    stream = opj_stream_create (4096, OPJ_FALSE);
-    if (!stream)
-      goto open_error;
-
-    mstream.allocsize = 4096;
-    mstream.data = g_malloc (mstream.allocsize);
-    mstream.offset = 0;
-    mstream.size = 0;
-
-    opj_stream_set_read_function (stream, read_fn);
-    opj_stream_set_write_function (stream, write_fn);
-    opj_stream_set_skip_function (stream, skip_fn);
-    opj_stream_set_seek_function (stream, seek_fn);
-    opj_stream_set_user_data (stream, &mstream, NULL);
-    opj_stream_set_user_data_length (stream, mstream.size);
+    job = gst_openjpeg_enc_job_new (self, frame, i);
 
-    if (!opj_start_compress (enc, image, stream))
-      goto encode_error;
+    g_mutex_lock (&self->jobs_lock);
+    g_queue_push_tail (&self->jobs, job);
+    g_mutex_unlock (&self->jobs_lock);
 
-    if (!opj_encode (enc, stream))
-      goto encode_error;
-
-    if (!opj_end_compress (enc, stream))
-      goto encode_error;
-
-    opj_image_destroy (image);
-    opj_stream_destroy (stream);
-    opj_destroy_codec (enc);
-
-    frame->output_buffer = gst_buffer_new ();
-
-    if (self->is_jp2c) {
-      GstMapInfo map;
-      GstMemory *mem;
-
-      mem = gst_allocator_alloc (NULL, 8, NULL);
-      gst_memory_map (mem, &map, GST_MAP_WRITE);
-      GST_WRITE_UINT32_BE (map.data, mstream.size + 8);
-      GST_WRITE_UINT32_BE (map.data + 4, GST_MAKE_FOURCC ('j', 'p', '2', 'c'));
-      gst_memory_unmap (mem, &map);
-      gst_buffer_append_memory (frame->output_buffer, mem);
-    }
-
-    gst_buffer_append_memory (frame->output_buffer,
-        gst_memory_new_wrapped (0, mstream.data, mstream.allocsize, 0,
-            mstream.size, mstream.data, (GDestroyNotify) g_free));
-
-    GST_VIDEO_CODEC_FRAME_SET_SYNC_POINT (frame);
-    ret =
-        (i ==
-        self->num_stripes -
-        1) ? gst_video_encoder_finish_frame (encoder,
-        frame) : gst_video_encoder_finish_subframe (encoder, frame);
+    if (self->pool)
+      g_thread_pool_push (self->pool, job, NULL);
+    else
+      gst_openjpeg_enc_encode_job (job, self);
 
+    ret = gst_openjpeg_enc_finish_jobs (self, self->num_threads);
+    if (ret != GST_FLOW_OK)
+      goto stripe_error;
   }
 
+  /* All the stripes of a frame are output before the next frame is
+   * accepted, for low latency */
+  if (stripe_mode)
+    ret = gst_openjpeg_enc_finish_jobs (self, 0);
+
 done:
+  gst_video_codec_frame_unref (frame);
   if (current_caps)
     gst_caps_unref (current_caps);
   return ret;
 
-initialization_error:
+stripe_error:
   {
-    gst_video_codec_frame_unref (frame);
-    GST_ELEMENT_ERROR (self, LIBRARY, INIT,
-        ("Failed to initialize OpenJPEG encoder"), (NULL));
-    return GST_FLOW_ERROR;
+    /* The remaining stripes are not queued, release the frame here unless
+     * its last stripe already did */
+    if (i < self->num_stripes - 1) {
+      gst_openjpeg_enc_finish_jobs (self, 0);
+      gst_buffer_replace (&frame->output_buffer, NULL);
+      gst_video_encoder_finish_frame (encoder,
+          gst_video_codec_frame_ref (frame));
+    }
+    goto done;
   }
-map_read_error:
-  {
-    opj_destroy_codec (enc);
-    gst_video_codec_frame_unref (frame);
+}
 
-    GST_ELEMENT_ERROR (self, CORE, FAILED,
-        ("Failed to map input buffer"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-fill_image_error:
-  {
-    opj_destroy_codec (enc);
-    gst_video_frame_unmap (&vframe);
-    gst_video_codec_frame_unref (frame);
+static GstFlowReturn
+gst_openjpeg_enc_finish (GstVideoEncoder * encoder)
+{
+  GstOpenJPEGEnc *self = GST_OPENJPEG_ENC (encoder);
 
-    GST_ELEMENT_ERROR (self, LIBRARY, INIT,
-        ("Failed to fill OpenJPEG image"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-open_error:
-  {
-    opj_image_destroy (image);
-    opj_destroy_codec (enc);
-    gst_video_codec_frame_unref (frame);
+  GST_DEBUG_OBJECT (self, "Draining");
 
-    GST_ELEMENT_ERROR (self, LIBRARY, INIT,
-        ("Failed to open OpenJPEG data"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-encode_error:
-  {
-    opj_stream_destroy (stream);
-    g_free (mstream.data);
-    opj_image_destroy (image);
-    opj_destroy_codec (enc);
-    gst_video_codec_frame_unref (frame);
+  return gst_openjpeg_enc_finish_jobs (self, 0);
+}
 
-    GST_ELEMENT_ERROR (self, STREAM, ENCODE,
-        ("Failed to encode OpenJPEG stream"), (NULL));
-    return GST_FLOW_ERROR;
-  }
+static gboolean
+gst_openjpeg_enc_flush (GstVideoEncoder * encoder)
+{
+  GstOpenJPEGEnc *self = GST_OPENJPEG_ENC (encoder);
+
+  GST_DEBUG_OBJECT (self, "Flushing");
+
+  gst_openjpeg_enc_drop_jobs (self);
+
+  return TRUE;
 }
 
 static gboolean
@@ -58,6 +58,13 @@ struct _GstOpenJPEGEnc
 
   opj_cparameters_t params;
   gint num_stripes;
+  guint num_threads;
+
+  /* Stripes or frames being encoded by the thread pool, in output order */
+  GThreadPool *pool;
+  GMutex jobs_lock;
+  GCond jobs_cond;
+  GQueue jobs;
 };
 
 struct _GstOpenJPEGEncClass
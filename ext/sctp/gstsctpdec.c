@@ -62,6 +62,7 @@ enum
 
   PROP_GST_SCTP_ASSOCIATION_ID,
   PROP_LOCAL_SCTP_PORT,
+  PROP_RECEIVE_BUFFER_SIZE,
 
   NUM_PROPERTIES
 };
@@ -70,10 +71,14 @@ static GParamSpec *properties[NUM_PROPERTIES];
 
 #define DEFAULT_GST_SCTP_ASSOCIATION_ID 1
 #define DEFAULT_LOCAL_SCTP_PORT 0
+#define DEFAULT_RECEIVE_BUFFER_SIZE (1024 * 1024)
 #define MAX_SCTP_PORT 65535
 #define MAX_GST_SCTP_ASSOCIATION_ID 65535
 #define MAX_STREAM_ID 65535
 
+/* Maximum number of queued messages pushed downstream as one buffer list */
+#define MAX_OUTPUT_BATCH 64
+
 GType gst_sctp_dec_pad_get_type (void);
 
 #define GST_TYPE_SCTP_DEC_PAD (gst_sctp_dec_pad_get_type())
@@ -146,6 +151,8 @@ static void gst_sctp_dec_get_property (GObject * object, guint prop_id,
 static void gst_sctp_dec_finalize (GObject * object);
 static GstStateChangeReturn gst_sctp_dec_change_state (GstElement * element,
     GstStateChange transition);
+static GstFlowReturn gst_sctp_dec_packet_chain_list (GstPad * pad,
+    GstSctpDec * self, GstBufferList * list);
 static GstFlowReturn gst_sctp_dec_packet_chain (GstPad * pad, GstSctpDec * self,
     GstBuffer * buf);
 static gboolean gst_sctp_dec_packet_event (GstPad * pad, GstSctpDec * self,
@@ -206,6 +213,24 @@ gst_sctp_dec_class_init (GstSctpDecClass * klass)
       0, MAX_SCTP_PORT, DEFAULT_LOCAL_SCTP_PORT,
       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstSctpDec:receive-buffer-size:
+   *
+   * Size of the receive buffer of the SCTP socket in bytes. It bounds the
+   * receive window advertised to the peer, so it must cover the
+   * bandwidth-delay product of the link for bulk transfers to reach the link
+   * rate.
+   *
+   * Since: 1.20
+   */
+  properties[PROP_RECEIVE_BUFFER_SIZE] =
+      g_param_spec_uint ("receive-buffer-size",
+      "Receive buffer size",
+      "Size of the SCTP socket receive buffer in bytes. "
+      "This value must be set before going to PAUSED.",
+      1024, G_MAXINT, DEFAULT_RECEIVE_BUFFER_SIZE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY);
+
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, properties);
 
   signals[SIGNAL_RESET_STREAM] = g_signal_new ("reset-stream",
@@ -225,12 +250,16 @@ gst_sctp_dec_init (GstSctpDec * self)
 {
   self->sctp_association_id = DEFAULT_GST_SCTP_ASSOCIATION_ID;
   self->local_sctp_port = DEFAULT_LOCAL_SCTP_PORT;
+  self->receive_buffer_size = DEFAULT_RECEIVE_BUFFER_SIZE;
 
   self->flow_combiner = gst_flow_combiner_new ();
 
   self->sink_pad = gst_pad_new_from_static_template (&sink_template, "sink");
   gst_pad_set_chain_function (self->sink_pad,
       GST_DEBUG_FUNCPTR ((GstPadChainFunction) gst_sctp_dec_packet_chain));
+  gst_pad_set_chain_list_function (self->sink_pad,
+      GST_DEBUG_FUNCPTR ((GstPadChainListFunction)
+          gst_sctp_dec_packet_chain_list));
   gst_pad_set_event_function (self->sink_pad,
       GST_DEBUG_FUNCPTR ((GstPadEventFunction) gst_sctp_dec_packet_event));
 
@@ -250,6 +279,9 @@ gst_sctp_dec_set_property (GObject * object, guint prop_id,
     case PROP_LOCAL_SCTP_PORT:
       self->local_sctp_port = g_value_get_uint (value);
       break;
+    case PROP_RECEIVE_BUFFER_SIZE:
+      self->receive_buffer_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
       break;
@@ -269,6 +301,9 @@ gst_sctp_dec_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_LOCAL_SCTP_PORT:
       g_value_set_uint (value, self->local_sctp_port);
       break;
+    case PROP_RECEIVE_BUFFER_SIZE:
+      g_value_set_uint (value, self->receive_buffer_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
       break;
@@ -351,6 +386,45 @@ gst_sctp_dec_packet_chain (GstPad * pad, GstSctpDec * self, GstBuffer * buf)
   return flow_ret;
 }
 
+static GstFlowReturn
+gst_sctp_dec_packet_chain_list (GstPad * pad, GstSctpDec * self,
+    GstBufferList * list)
+{
+  GstFlowReturn flow_ret;
+  guint i, n;
+
+  n = gst_buffer_list_length (list);
+
+  GST_DEBUG_OBJECT (self, "Processing list of %u received buffers", n);
+
+  for (i = 0; i < n; i++) {
+    GstBuffer *buf = gst_buffer_list_get (list, i);
+    GstMapInfo map;
+
+    if (!gst_buffer_map (buf, &map, GST_MAP_READ)) {
+      GST_ERROR_OBJECT (self, "Could not map GstBuffer");
+      gst_buffer_list_unref (list);
+      return GST_FLOW_ERROR;
+    }
+
+    gst_sctp_association_incoming_packet (self->sctp_association,
+        (const guint8 *) map.data, (guint32) map.size);
+    gst_buffer_unmap (buf, &map);
+  }
+  gst_buffer_list_unref (list);
+
+  GST_OBJECT_LOCK (self);
+  /* This gets the last combined flow return from all source pads */
+  flow_ret = gst_flow_combiner_update_flow (self->flow_combiner, GST_FLOW_OK);
+  GST_OBJECT_UNLOCK (self);
+
+  if (flow_ret != GST_FLOW_OK) {
+    GST_DEBUG_OBJECT (self, "Returning %s", gst_flow_get_name (flow_ret));
+  }
+
+  return flow_ret;
+}
+
 static void
 flush_srcpad (const GValue * item, gpointer user_data)
 {
@@ -419,13 +493,38 @@ gst_sctp_data_srcpad_loop (GstPad * pad)
 
   if (gst_data_queue_pop (sctpdec_pad->packet_queue, &item)) {
     GstBuffer *buffer;
+    GstBufferList *list = NULL;
     GstFlowReturn flow_ret;
 
     buffer = GST_BUFFER (item->object);
-    GST_DEBUG_OBJECT (pad, "Forwarding buffer %" GST_PTR_FORMAT, buffer);
-
-    flow_ret = gst_pad_push (pad, buffer);
     item->object = NULL;
+    item->destroy (item);
+
+    /* Forward the messages queued in the meantime along in one list */
+    while (!gst_data_queue_is_empty (sctpdec_pad->packet_queue) &&
+        (!list || gst_buffer_list_length (list) < MAX_OUTPUT_BATCH)) {
+      if (!gst_data_queue_pop (sctpdec_pad->packet_queue, &item))
+        break;
+
+      if (!list) {
+        list = gst_buffer_list_new_sized (MAX_OUTPUT_BATCH);
+        gst_buffer_list_add (list, buffer);
+        buffer = NULL;
+      }
+
+      gst_buffer_list_add (list, GST_BUFFER (item->object));
+      item->object = NULL;
+      item->destroy (item);
+    }
+
+    if (list) {
+      GST_DEBUG_OBJECT (pad, "Forwarding list of %u buffers",
+          gst_buffer_list_length (list));
+      flow_ret = gst_pad_push_list (pad, list);
+    } else {
+      GST_DEBUG_OBJECT (pad, "Forwarding buffer %" GST_PTR_FORMAT, buffer);
+      flow_ret = gst_pad_push (pad, buffer);
+    }
 
     GST_OBJECT_LOCK (self);
     gst_flow_combiner_update_pad_flow (self->flow_combiner, pad, flow_ret);
@@ -446,8 +545,6 @@ gst_sctp_data_srcpad_loop (GstPad * pad)
       gst_data_queue_flush (sctpdec_pad->packet_queue);
       gst_pad_pause_task (pad);
     }
-
-    item->destroy (item);
   } else {
     GST_OBJECT_LOCK (self);
     gst_flow_combiner_update_pad_flow (self->flow_combiner, pad,
@@ -485,6 +582,9 @@ configure_association (GstSctpDec * self)
   g_object_bind_property (self, "local-sctp-port", self->sctp_association,
       "local-port", G_BINDING_SYNC_CREATE);
 
+  g_object_bind_property (self, "receive-buffer-size", self->sctp_association,
+      "receive-buffer-size", G_BINDING_SYNC_CREATE);
+
   gst_sctp_association_set_on_packet_received (self->sctp_association,
       on_receive, gst_object_ref (self), gst_object_unref);
 
@@ -50,6 +50,7 @@ struct _GstSctpDec
   GstPad *sink_pad;
   guint sctp_association_id;
   guint local_sctp_port;
+  guint receive_buffer_size;
 
   GstSctpAssociation *sctp_association;
   gulong signal_handler_stream_reset;
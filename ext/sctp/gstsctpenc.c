@@ -61,6 +61,7 @@ enum
   PROP_GST_SCTP_ASSOCIATION_ID,
   PROP_REMOTE_SCTP_PORT,
   PROP_USE_SOCK_STREAM,
+  PROP_SEND_BUFFER_SIZE,
 
   NUM_PROPERTIES
 };
@@ -72,6 +73,14 @@ static GParamSpec *properties[NUM_PROPERTIES];
 #define DEFAULT_GST_SCTP_ORDERED TRUE
 #define DEFAULT_SCTP_PPID 1
 #define DEFAULT_USE_SOCK_STREAM FALSE
+#define DEFAULT_SEND_BUFFER_SIZE (1024 * 1024)
+
+/* Outgoing SCTP packets are at most as big as the path MTU configured by the
+ * association, bigger ones get a buffer of their own */
+#define OUTPUT_POOL_BUFFER_SIZE 1500
+
+/* Maximum number of queued packets pushed downstream as one buffer list */
+#define MAX_OUTPUT_BATCH 64
 
 #define BUFFER_FULL_SLEEP_TIME 100000
 
@@ -155,6 +164,7 @@ static void on_sctp_association_state_changed (GstSctpAssociation *
 static gboolean configure_association (GstSctpEnc * self);
 static void on_sctp_packet_out (GstSctpAssociation * sctp_association,
     const guint8 * buf, gsize length, gpointer user_data);
+static void start_output_pool (GstSctpEnc * self);
 static void stop_srcpad_task (GstPad * pad, GstSctpEnc * self);
 static void sctpenc_cleanup (GstSctpEnc * self);
 static void get_config_from_caps (const GstCaps * caps, gboolean * ordered,
@@ -211,6 +221,23 @@ gst_sctp_enc_class_init (GstSctpEncClass * klass)
       "When TRUE the partial reliability parameters of the channel are ignored.",
       DEFAULT_USE_SOCK_STREAM, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstSctpEnc:send-buffer-size:
+   *
+   * Size of the send buffer of the SCTP socket in bytes. It bounds how much
+   * data can be in flight, so it must cover the bandwidth-delay product of
+   * the link for bulk transfers to reach the link rate.
+   *
+   * Since: 1.20
+   */
+  properties[PROP_SEND_BUFFER_SIZE] =
+      g_param_spec_uint ("send-buffer-size",
+      "Send buffer size",
+      "Size of the SCTP socket send buffer in bytes. "
+      "This value must be set before going to PAUSED.",
+      1024, G_MAXINT, DEFAULT_SEND_BUFFER_SIZE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY);
+
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, properties);
 
   signals[SIGNAL_SCTP_ASSOCIATION_ESTABLISHED] =
@@ -257,11 +284,13 @@ gst_sctp_enc_init (GstSctpEnc * self)
 {
   self->sctp_association_id = DEFAULT_GST_SCTP_ASSOCIATION_ID;
   self->remote_sctp_port = DEFAULT_REMOTE_SCTP_PORT;
+  self->send_buffer_size = DEFAULT_SEND_BUFFER_SIZE;
 
   self->sctp_association = NULL;
   self->outbound_sctp_packet_queue =
       gst_data_queue_new (data_queue_check_full_cb, data_queue_full_cb,
       data_queue_empty_cb, NULL);
+  self->output_pool = gst_buffer_pool_new ();
 
   self->src_pad = gst_pad_new_from_static_template (&src_template, "src");
   gst_pad_set_event_function (self->src_pad,
@@ -279,6 +308,7 @@ gst_sctp_enc_finalize (GObject * object)
 
   g_queue_clear (&self->pending_pads);
   gst_object_unref (self->outbound_sctp_packet_queue);
+  gst_object_unref (self->output_pool);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -299,6 +329,9 @@ gst_sctp_enc_set_property (GObject * object, guint prop_id,
     case PROP_USE_SOCK_STREAM:
       self->use_sock_stream = g_value_get_boolean (value);
       break;
+    case PROP_SEND_BUFFER_SIZE:
+      self->send_buffer_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
       break;
@@ -321,6 +354,9 @@ gst_sctp_enc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_USE_SOCK_STREAM:
       g_value_set_boolean (value, self->use_sock_stream);
       break;
+    case PROP_SEND_BUFFER_SIZE:
+      g_value_set_uint (value, self->send_buffer_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
       break;
@@ -341,6 +377,7 @@ gst_sctp_enc_change_state (GstElement * element, GstStateChange transition)
       self->need_segment = self->need_stream_start_caps = TRUE;
       self->src_ret = GST_FLOW_OK;
       gst_data_queue_set_flushing (self->outbound_sctp_packet_queue, FALSE);
+      start_output_pool (self);
       res = configure_association (self);
       break;
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
@@ -516,11 +553,36 @@ gst_sctp_enc_srcpad_loop (GstPad * pad)
 
   if (gst_data_queue_pop (self->outbound_sctp_packet_queue, &item)) {
     GstBuffer *buffer = GST_BUFFER (item->object);
+    GstBufferList *list = NULL;
 
-    GST_DEBUG_OBJECT (self, "Forwarding buffer %" GST_PTR_FORMAT, buffer);
-
-    flow_ret = gst_pad_push (self->src_pad, buffer);
     item->object = NULL;
+    item->destroy (item);
+
+    /* Forward the packets queued in the meantime along in one list */
+    while (!gst_data_queue_is_empty (self->outbound_sctp_packet_queue) &&
+        (!list || gst_buffer_list_length (list) < MAX_OUTPUT_BATCH)) {
+      if (!gst_data_queue_pop (self->outbound_sctp_packet_queue, &item))
+        break;
+
+      if (!list) {
+        list = gst_buffer_list_new_sized (MAX_OUTPUT_BATCH);
+        gst_buffer_list_add (list, buffer);
+        buffer = NULL;
+      }
+
+      gst_buffer_list_add (list, GST_BUFFER (item->object));
+      item->object = NULL;
+      item->destroy (item);
+    }
+
+    if (list) {
+      GST_DEBUG_OBJECT (self, "Forwarding list of %u buffers",
+          gst_buffer_list_length (list));
+      flow_ret = gst_pad_push_list (self->src_pad, list);
+    } else {
+      GST_DEBUG_OBJECT (self, "Forwarding buffer %" GST_PTR_FORMAT, buffer);
+      flow_ret = gst_pad_push (self->src_pad, buffer);
+    }
 
     GST_OBJECT_LOCK (self);
     self->src_ret = flow_ret;
@@ -541,8 +603,6 @@ gst_sctp_enc_srcpad_loop (GstPad * pad)
       gst_data_queue_flush (self->outbound_sctp_packet_queue);
       gst_pad_pause_task (pad);
     }
-
-    item->destroy (item);
   } else {
     GST_OBJECT_LOCK (self);
     self->src_ret = GST_FLOW_FLUSHING;
@@ -828,6 +888,9 @@ configure_association (GstSctpEnc * self)
   g_object_bind_property (self, "use-sock-stream", self->sctp_association,
       "use-sock-stream", G_BINDING_SYNC_CREATE);
 
+  g_object_bind_property (self, "send-buffer-size", self->sctp_association,
+      "send-buffer-size", G_BINDING_SYNC_CREATE);
+
   gst_sctp_association_set_on_packet_out (self->sctp_association,
       on_sctp_packet_out, gst_object_ref (self), gst_object_unref);
 
@@ -891,7 +954,16 @@ on_sctp_packet_out (GstSctpAssociation * _association, const guint8 * buf,
   GST_DEBUG_OBJECT (self, "Received output packet of size %" G_GSIZE_FORMAT,
       length);
 
-  gstbuf = gst_buffer_new_wrapped (g_memdup (buf, length), length);
+  gstbuf = NULL;
+  if (length <= OUTPUT_POOL_BUFFER_SIZE)
+    gst_buffer_pool_acquire_buffer (self->output_pool, &gstbuf, NULL);
+
+  if (gstbuf) {
+    gst_buffer_fill (gstbuf, 0, buf, length);
+    gst_buffer_set_size (gstbuf, length);
+  } else {
+    gstbuf = gst_buffer_new_wrapped (g_memdup (buf, length), length);
+  }
 
   item = g_new0 (GstDataQueueItem, 1);
   item->object = GST_MINI_OBJECT (gstbuf);
@@ -921,6 +993,19 @@ on_sctp_packet_out (GstSctpAssociation * _association, const guint8 * buf,
   g_list_free (pending_pads);
 }
 
+static void
+start_output_pool (GstSctpEnc * self)
+{
+  GstStructure *config;
+
+  config = gst_buffer_pool_get_config (self->output_pool);
+  gst_buffer_pool_config_set_params (config, NULL, OUTPUT_POOL_BUFFER_SIZE, 0,
+      0);
+  gst_buffer_pool_set_config (self->output_pool, config);
+  if (!gst_buffer_pool_set_active (self->output_pool, TRUE))
+    GST_WARNING_OBJECT (self, "Failed to activate the output buffer pool");
+}
+
 static void
 stop_srcpad_task (GstPad * pad, GstSctpEnc * self)
 {
@@ -945,6 +1030,7 @@ sctpenc_cleanup (GstSctpEnc * self)
 
   gst_sctp_association_set_on_packet_out (self->sctp_association, NULL, NULL,
       NULL);
+  gst_buffer_pool_set_active (self->output_pool, FALSE);
 
   g_signal_handler_disconnect (self->sctp_association,
       self->signal_handler_state_changed);
@@ -85,6 +85,8 @@ enum
   PROP_REMOTE_PORT,
   PROP_STATE,
   PROP_USE_SOCK_STREAM,
+  PROP_SEND_BUFFER_SIZE,
+  PROP_RECEIVE_BUFFER_SIZE,
 
   NUM_PROPERTIES
 };
@@ -96,6 +98,7 @@ static GParamSpec *properties[NUM_PROPERTIES];
 #define DEFAULT_NUMBER_OF_SCTP_STREAMS 1024
 #define DEFAULT_LOCAL_SCTP_PORT 0
 #define DEFAULT_REMOTE_SCTP_PORT 0
+#define DEFAULT_SOCKET_BUFFER_SIZE (1024 * 1024)
 
 static GHashTable *associations = NULL;
 G_LOCK_DEFINE_STATIC (associations_lock);
@@ -171,6 +174,18 @@ gst_sctp_association_class_init (GstSctpAssociationClass * klass)
       "When TRUE the partial reliability parameters of the channel is ignored.",
       FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  properties[PROP_SEND_BUFFER_SIZE] =
+      g_param_spec_uint ("send-buffer-size", "Send buffer size",
+      "Size of the SCTP socket send buffer in bytes, which bounds the data "
+      "in flight", 1024, G_MAXINT, DEFAULT_SOCKET_BUFFER_SIZE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  properties[PROP_RECEIVE_BUFFER_SIZE] =
+      g_param_spec_uint ("receive-buffer-size", "Receive buffer size",
+      "Size of the SCTP socket receive buffer in bytes, which bounds the "
+      "window advertised to the peer", 1024, G_MAXINT,
+      DEFAULT_SOCKET_BUFFER_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, properties);
 }
 
@@ -236,6 +251,9 @@ gst_sctp_association_init (GstSctpAssociation * self)
 
   self->use_sock_stream = FALSE;
 
+  self->send_buffer_size = DEFAULT_SOCKET_BUFFER_SIZE;
+  self->receive_buffer_size = DEFAULT_SOCKET_BUFFER_SIZE;
+
   usrsctp_register_address ((void *) self);
 }
 
@@ -269,6 +287,8 @@ gst_sctp_association_set_property (GObject * object, guint prop_id,
     switch (prop_id) {
       case PROP_LOCAL_PORT:
       case PROP_REMOTE_PORT:
+      case PROP_SEND_BUFFER_SIZE:
+      case PROP_RECEIVE_BUFFER_SIZE:
         GST_ERROR_OBJECT (self, "These properties cannot be set in this state");
         goto error;
     }
@@ -290,6 +310,12 @@ gst_sctp_association_set_property (GObject * object, guint prop_id,
     case PROP_USE_SOCK_STREAM:
       self->use_sock_stream = g_value_get_boolean (value);
       break;
+    case PROP_SEND_BUFFER_SIZE:
+      self->send_buffer_size = g_value_get_uint (value);
+      break;
+    case PROP_RECEIVE_BUFFER_SIZE:
+      self->receive_buffer_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
       break;
@@ -347,6 +373,12 @@ gst_sctp_association_get_property (GObject * object, guint prop_id,
     case PROP_USE_SOCK_STREAM:
       g_value_set_boolean (value, self->use_sock_stream);
       break;
+    case PROP_SEND_BUFFER_SIZE:
+      g_value_set_uint (value, self->send_buffer_size);
+      break;
+    case PROP_RECEIVE_BUFFER_SIZE:
+      g_value_set_uint (value, self->receive_buffer_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
       break;
@@ -576,7 +608,7 @@ create_sctp_socket (GstSctpAssociation * self)
   struct linger l;
   struct sctp_event event;
   struct sctp_assoc_value stream_reset;
-  int buf_size = 1024 * 1024;
+  int rcv_buf_size, snd_buf_size;
   int value = 1;
   guint16 event_types[] = {
     SCTP_ASSOC_CHANGE,
@@ -597,6 +629,11 @@ create_sctp_socket (GstSctpAssociation * self)
   guint32 i;
   guint sock_type = self->use_sock_stream ? SOCK_STREAM : SOCK_SEQPACKET;
 
+  g_mutex_lock (&self->association_mutex);
+  rcv_buf_size = self->receive_buffer_size;
+  snd_buf_size = self->send_buffer_size;
+  g_mutex_unlock (&self->association_mutex);
+
   if ((sock =
           usrsctp_socket (AF_CONN, sock_type, IPPROTO_SCTP, receive_cb, NULL, 0,
               (void *) self)) == NULL) {
@@ -606,13 +643,13 @@ create_sctp_socket (GstSctpAssociation * self)
   }
 
   if (usrsctp_setsockopt (sock, SOL_SOCKET, SO_RCVBUF,
-          (const void *) &buf_size, sizeof (buf_size)) < 0) {
+          (const void *) &rcv_buf_size, sizeof (rcv_buf_size)) < 0) {
     GST_ERROR_OBJECT (self, "Could not change receive buffer size: (%u) %s",
         errno, g_strerror (errno));
     goto error;
   }
   if (usrsctp_setsockopt (sock, SOL_SOCKET, SO_SNDBUF,
-          (const void *) &buf_size, sizeof (buf_size)) < 0) {
+          (const void *) &snd_buf_size, sizeof (snd_buf_size)) < 0) {
     GST_ERROR_OBJECT (self, "Could not change send buffer size: (%u) %s",
         errno, g_strerror (errno));
     goto error;
@@ -77,6 +77,8 @@ struct _GstSctpAssociation
   guint16 local_port;
   guint16 remote_port;
   gboolean use_sock_stream;
+  guint send_buffer_size;
+  guint receive_buffer_size;
   struct socket *sctp_ass_sock;
 
   GMutex association_mutex;
@@ -62,6 +62,23 @@ typedef enum
   GST_SRT_KEY_LENGTH_32 = 32,
 } GstSRTKeyLength;
 
+/**
+ * GstSRTCallerLagPolicy:
+ * @GST_SRT_CALLER_LAG_POLICY_DROP_OLDEST: drop the oldest queued buffer
+ * @GST_SRT_CALLER_LAG_POLICY_DROP_NEWEST: drop the new buffer
+ * @GST_SRT_CALLER_LAG_POLICY_DISCONNECT: disconnect the caller
+ *
+ * What to do when the queue of a caller is full
+ *
+ * Since: 1.20
+ */
+typedef enum
+{
+  GST_SRT_CALLER_LAG_POLICY_DROP_OLDEST,
+  GST_SRT_CALLER_LAG_POLICY_DROP_NEWEST,
+  GST_SRT_CALLER_LAG_POLICY_DISCONNECT,
+} GstSRTCallerLagPolicy;
+
 G_END_DECLS
 
 #endif // __GST_SRT_ENUM_H__
@@ -74,12 +74,26 @@ enum
   PROP_LAST
 };
 
+G_STATIC_ASSERT (PROP_LAST <= GST_SRT_OBJECT_PROP_LAST);
+
+/* How long the sender thread waits for writability before checking
+ * whether it should stop */
+#define SENDER_POLL_TIMEOUT 100
+
 typedef struct
 {
   SRTSOCKET sock;
   gint poll_id;
   GSocketAddress *sockaddr;
   gboolean sent_headers;
+
+  /* Fan-out mode: queued GBytes, how much of the first one is sent and how
+   * many of them are stream headers */
+  GQueue queue;
+  gsize offset;
+  guint queued_headers;
+  gboolean polling;
+  guint64 buffers_dropped;
 } SRTCaller;
 
 static GstStructure *gst_srt_object_accumulate_stats (GstSRTObject * srtobject,
@@ -103,6 +117,9 @@ srt_caller_free (SRTCaller * caller)
 
   g_clear_object (&caller->sockaddr);
 
+  while (!g_queue_is_empty (&caller->queue))
+    g_bytes_unref (g_queue_pop_head (&caller->queue));
+
   if (caller->sock != SRT_INVALID_SOCK) {
     srt_close (caller->sock);
   }
@@ -130,6 +147,21 @@ srt_caller_signal_removed (SRTCaller * caller, GstSRTObject * srtobject)
       caller->sockaddr);
 }
 
+/* called with sock_lock */
+static void
+srt_caller_remove (SRTCaller * caller, GstSRTObject * srtobject)
+{
+  srtobject->callers = g_list_remove (srtobject->callers, caller);
+
+  if (caller->polling) {
+    srt_epoll_remove_usock (srtobject->sender_poll_id, caller->sock);
+    srtobject->sender_pending--;
+  }
+
+  srt_caller_signal_removed (caller, srtobject);
+  srt_caller_free (caller);
+}
+
 struct srt_constant_params
 {
   const gchar *name;
@@ -366,8 +398,12 @@ gst_srt_object_new (GstElement * element)
   srtobject->listener_poll_id = SRT_ERROR;
   srtobject->sent_headers = FALSE;
   srtobject->wait_for_connection = GST_SRT_DEFAULT_WAIT_FOR_CONNECTION;
+  srtobject->caller_queue_size = GST_SRT_DEFAULT_CALLER_QUEUE_SIZE;
+  srtobject->caller_lag_policy = GST_SRT_DEFAULT_CALLER_LAG_POLICY;
+  srtobject->sender_poll_id = SRT_ERROR;
 
   g_cond_init (&srtobject->sock_cond);
+  g_cond_init (&srtobject->sender_cond);
   return srtobject;
 }
 
@@ -382,6 +418,7 @@ gst_srt_object_destroy (GstSRTObject * srtobject)
   }
 
   g_cond_clear (&srtobject->sock_cond);
+  g_cond_clear (&srtobject->sender_cond);
 
   GST_DEBUG_OBJECT (srtobject->element, "Destroying srtobject");
   gst_structure_free (srtobject->parameters);
@@ -1056,6 +1093,159 @@ reject:
   return -1;
 }
 
+/* Sends as much of the queue of @caller as its socket takes. Called with
+ * sock_lock, returns FALSE if the caller must be dropped. */
+static gboolean
+srt_caller_send_queued (SRTCaller * caller, GstSRTObject * srtobject)
+{
+  gint payload_size, optlen = sizeof (payload_size);
+
+  if (srt_getsockflag (caller->sock, SRTO_PAYLOADSIZE, &payload_size,
+          &optlen)) {
+    GST_WARNING_OBJECT (srtobject->element, "%s", srt_getlasterror_str ());
+    return FALSE;
+  }
+
+  while (!g_queue_is_empty (&caller->queue)) {
+    GBytes *bytes = g_queue_peek_head (&caller->queue);
+    gsize size;
+    const guint8 *msg = g_bytes_get_data (bytes, &size);
+
+    while (caller->offset < size) {
+      gint rest = MIN (size - caller->offset, payload_size);
+      gint sent;
+
+      sent = srt_sendmsg2 (caller->sock, (char *) (msg + caller->offset),
+          rest, 0);
+      if (sent < 0) {
+        /* The send buffer is full, wait until it is writable again */
+        if (srt_getlasterror (NULL) == SRT_EASYNCSND)
+          return TRUE;
+
+        GST_WARNING_OBJECT (srtobject->element, "Dropping caller %d: %s",
+            caller->sock, srt_getlasterror_str ());
+        return FALSE;
+      }
+      caller->offset += sent;
+    }
+
+    g_bytes_unref (g_queue_pop_head (&caller->queue));
+    caller->offset = 0;
+    if (caller->queued_headers > 0)
+      caller->queued_headers--;
+  }
+
+  srt_epoll_remove_usock (srtobject->sender_poll_id, caller->sock);
+  caller->polling = FALSE;
+  srtobject->sender_pending--;
+
+  return TRUE;
+}
+
+/* called with sock_lock */
+static SRTCaller *
+gst_srt_object_find_caller (GstSRTObject * srtobject, SRTSOCKET sock)
+{
+  GList *item;
+
+  for (item = srtobject->callers; item; item = item->next) {
+    SRTCaller *caller = item->data;
+
+    if (caller->sock == sock)
+      return caller;
+  }
+
+  return NULL;
+}
+
+static gpointer
+sender_thread_func (gpointer data)
+{
+  GstSRTObject *srtobject = data;
+  GArray *rsocks = g_array_new (FALSE, FALSE, sizeof (SRTSOCKET));
+  GArray *wsocks = g_array_new (FALSE, FALSE, sizeof (SRTSOCKET));
+
+  g_mutex_lock (&srtobject->sock_lock);
+  while (srtobject->sender_running) {
+    gint rsocklen, wsocklen, i;
+    SRTCaller *caller;
+
+    if (srtobject->sender_pending == 0) {
+      g_cond_wait (&srtobject->sender_cond, &srtobject->sock_lock);
+      continue;
+    }
+
+    g_array_set_size (rsocks, srtobject->sender_pending);
+    g_array_set_size (wsocks, srtobject->sender_pending);
+    rsocklen = rsocks->len;
+    wsocklen = wsocks->len;
+    g_mutex_unlock (&srtobject->sock_lock);
+
+    if (srt_epoll_wait (srtobject->sender_poll_id,
+            (SRTSOCKET *) rsocks->data, &rsocklen,
+            (SRTSOCKET *) wsocks->data, &wsocklen, SENDER_POLL_TIMEOUT,
+            NULL, 0, NULL, 0) < 0) {
+      /* Timeout, or all the callers went away meanwhile */
+      g_mutex_lock (&srtobject->sock_lock);
+      continue;
+    }
+
+    g_mutex_lock (&srtobject->sock_lock);
+
+    /* We only poll for writability, sockets that are readable have errors */
+    for (i = 0; i < rsocklen; i++) {
+      SRTSOCKET sock = g_array_index (rsocks, SRTSOCKET, i);
+
+      caller = gst_srt_object_find_caller (srtobject, sock);
+      if (caller) {
+        GST_WARNING_OBJECT (srtobject->element, "Dropping caller %d: %s",
+            sock, srt_getlasterror_str ());
+        srt_caller_remove (caller, srtobject);
+      }
+    }
+
+    for (i = 0; i < wsocklen; i++) {
+      SRTSOCKET sock = g_array_index (wsocks, SRTSOCKET, i);
+
+      caller = gst_srt_object_find_caller (srtobject, sock);
+      if (caller && !srt_caller_send_queued (caller, srtobject))
+        srt_caller_remove (caller, srtobject);
+    }
+  }
+  g_mutex_unlock (&srtobject->sock_lock);
+
+  g_array_unref (rsocks);
+  g_array_unref (wsocks);
+
+  return NULL;
+}
+
+static gboolean
+gst_srt_object_start_sender (GstSRTObject * srtobject, GError ** error)
+{
+  srtobject->sender_poll_id = srt_epoll_create ();
+  if (srtobject->sender_poll_id == SRT_ERROR) {
+    g_set_error (error, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_INIT, "%s",
+        srt_getlasterror_str ());
+    return FALSE;
+  }
+
+  srtobject->sender_running = TRUE;
+  srtobject->sender_pending = 0;
+  srtobject->sender_thread =
+      g_thread_try_new ("GstSRTObjectSender", sender_thread_func, srtobject,
+      error);
+  if (srtobject->sender_thread == NULL) {
+    GST_ERROR_OBJECT (srtobject->element, "Failed to start sender thread");
+    srtobject->sender_running = FALSE;
+    srt_epoll_release (srtobject->sender_poll_id);
+    srtobject->sender_poll_id = SRT_ERROR;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 static gboolean
 gst_srt_object_wait_connect (GstSRTObject * srtobject,
     GCancellable * cancellable, gpointer sa, size_t sa_len, GError ** error)
@@ -1064,6 +1254,7 @@ gst_srt_object_wait_connect (GstSRTObject * srtobject,
   const gchar *local_address = NULL;
   guint local_port = 0;
   gint sock_flags = SRT_EPOLL_ERR | SRT_EPOLL_IN;
+  guint caller_queue_size;
 
   gpointer bind_sa;
   gsize bind_sa_len;
@@ -1140,6 +1331,16 @@ gst_srt_object_wait_connect (GstSRTObject * srtobject,
     goto failed;
   }
 
+  GST_OBJECT_LOCK (srtobject->element);
+  caller_queue_size = srtobject->caller_queue_size;
+  GST_OBJECT_UNLOCK (srtobject->element);
+
+  if (caller_queue_size > 0 && gst_uri_handler_get_uri_type (GST_URI_HANDLER
+          (srtobject->element)) == GST_URI_SINK &&
+      !gst_srt_object_start_sender (srtobject, error)) {
+    goto failed;
+  }
+
   srtobject->thread =
       g_thread_try_new ("GstSRTObjectListener", thread_func, srtobject, error);
   if (srtobject->thread == NULL) {
@@ -1429,6 +1630,16 @@ gst_srt_object_close (GstSRTObject * srtobject)
     g_mutex_lock (&srtobject->sock_lock);
   }
 
+  if (srtobject->sender_thread) {
+    GThread *thread = g_steal_pointer (&srtobject->sender_thread);
+
+    srtobject->sender_running = FALSE;
+    g_cond_signal (&srtobject->sender_cond);
+    g_mutex_unlock (&srtobject->sock_lock);
+    g_thread_join (thread);
+    g_mutex_lock (&srtobject->sock_lock);
+  }
+
   if (srtobject->listener_sock != SRT_INVALID_SOCK) {
     GST_DEBUG_OBJECT (srtobject->element, "Closing SRT listener socket (0x%x)",
         srtobject->listener_sock);
@@ -1443,6 +1654,12 @@ gst_srt_object_close (GstSRTObject * srtobject)
     g_list_free_full (callers, (GDestroyNotify) srt_caller_free);
   }
 
+  if (srtobject->sender_poll_id != SRT_ERROR) {
+    srt_epoll_release (srtobject->sender_poll_id);
+    srtobject->sender_poll_id = SRT_ERROR;
+    srtobject->sender_pending = 0;
+  }
+
   g_mutex_unlock (&srtobject->sock_lock);
 
   GST_OBJECT_LOCK (srtobject->element);
@@ -1715,9 +1932,7 @@ gst_srt_object_write_to_callers (GstSRTObject * srtobject,
     continue;
 
   err:
-    srtobject->callers = g_list_remove (srtobject->callers, caller);
-    srt_caller_signal_removed (caller, srtobject);
-    srt_caller_free (caller);
+    srt_caller_remove (caller, srtobject);
   }
 
   g_mutex_unlock (&srtobject->sock_lock);
@@ -1728,6 +1943,113 @@ cancelled:
   return -1;
 }
 
+/* called with sock_lock, returns FALSE if the caller must be dropped */
+static gboolean
+srt_caller_enqueue (SRTCaller * caller, GstSRTObject * srtobject,
+    GBytes * bytes, guint queue_size, GstSRTCallerLagPolicy lag_policy)
+{
+  /* Stream headers and a partially sent buffer are never dropped */
+  guint pinned = MAX (caller->queued_headers, caller->offset > 0 ? 1 : 0);
+
+  if (caller->queue.length >= queue_size + caller->queued_headers) {
+    switch (lag_policy) {
+      case GST_SRT_CALLER_LAG_POLICY_DROP_OLDEST:
+        if (caller->queue.length > pinned) {
+          GList *link = g_queue_peek_nth_link (&caller->queue, pinned);
+
+          g_bytes_unref (link->data);
+          g_queue_delete_link (&caller->queue, link);
+          caller->buffers_dropped++;
+          break;
+        }
+        /* fall through */
+      case GST_SRT_CALLER_LAG_POLICY_DROP_NEWEST:
+        caller->buffers_dropped++;
+        return TRUE;
+      case GST_SRT_CALLER_LAG_POLICY_DISCONNECT:
+        GST_WARNING_OBJECT (srtobject->element,
+            "Dropping caller %d: queue full", caller->sock);
+        return FALSE;
+    }
+  }
+
+  g_queue_push_tail (&caller->queue, g_bytes_ref (bytes));
+
+  if (!caller->polling) {
+    gint sock_flags = SRT_EPOLL_OUT | SRT_EPOLL_ERR;
+
+    if (srt_epoll_add_usock (srtobject->sender_poll_id, caller->sock,
+            &sock_flags) < 0) {
+      GST_WARNING_OBJECT (srtobject->element, "Dropping caller %d: %s",
+          caller->sock, srt_getlasterror_str ());
+      return FALSE;
+    }
+    caller->polling = TRUE;
+    srtobject->sender_pending++;
+    g_cond_signal (&srtobject->sender_cond);
+  }
+
+  return TRUE;
+}
+
+/* Queues the buffer for each caller, the sender thread sends them out */
+static gssize
+gst_srt_object_queue_to_callers (GstSRTObject * srtobject,
+    GstBufferList * headers, const GstMapInfo * mapinfo,
+    GCancellable * cancellable, GError ** error)
+{
+  GBytes *bytes;
+  GList *callers;
+  guint queue_size;
+  GstSRTCallerLagPolicy lag_policy;
+
+  GST_OBJECT_LOCK (srtobject->element);
+  queue_size = srtobject->caller_queue_size;
+  lag_policy = srtobject->caller_lag_policy;
+  GST_OBJECT_UNLOCK (srtobject->element);
+
+  if (g_cancellable_is_cancelled (cancellable))
+    return -1;
+
+  /* One copy shared by all the callers */
+  bytes = g_bytes_new (mapinfo->data, mapinfo->size);
+
+  g_mutex_lock (&srtobject->sock_lock);
+  callers = srtobject->callers;
+  while (callers != NULL) {
+    SRTCaller *caller = callers->data;
+    callers = callers->next;
+
+    if (!caller->sent_headers && headers) {
+      guint i, n_headers = gst_buffer_list_length (headers);
+
+      GST_DEBUG_OBJECT (srtobject->element, "Queueing %u stream headers",
+          n_headers);
+
+      /* Headers don't count against the queue size */
+      for (i = 0; i < n_headers; i++) {
+        GstBuffer *buffer = gst_buffer_list_get (headers, i);
+        gsize size = gst_buffer_get_size (buffer);
+        gpointer data = g_malloc (size);
+
+        gst_buffer_extract (buffer, 0, data, size);
+        g_queue_push_tail (&caller->queue, g_bytes_new_take (data, size));
+      }
+      caller->queued_headers += n_headers;
+    }
+    caller->sent_headers = TRUE;
+
+    if (!srt_caller_enqueue (caller, srtobject, bytes, queue_size,
+            lag_policy))
+      srt_caller_remove (caller, srtobject);
+  }
+  g_mutex_unlock (&srtobject->sock_lock);
+
+  g_bytes_unref (bytes);
+
+  return mapinfo->size;
+}
+
 static gssize
 gst_srt_object_write_one (GstSRTObject * srtobject,
     GstBufferList * headers,
@@ -1841,9 +2163,15 @@ gst_srt_object_write (GstSRTObject * srtobject,
       if (!gst_srt_object_wait_caller (srtobject, cancellable, error))
         return -1;
     }
-    len =
-        gst_srt_object_write_to_callers (srtobject, headers, mapinfo,
-        cancellable, error);
+    if (srtobject->sender_thread) {
+      len =
+          gst_srt_object_queue_to_callers (srtobject, headers, mapinfo,
+          cancellable, error);
+    } else {
+      len =
+          gst_srt_object_write_to_callers (srtobject, headers, mapinfo,
+          cancellable, error);
+    }
   } else {
     len =
         gst_srt_object_write_one (srtobject, headers, mapinfo, cancellable,
@@ -1949,6 +2277,14 @@ gst_srt_object_get_stats (GstSRTObject * srtobject)
       gst_structure_set (tmp, "caller-address", G_TYPE_SOCKET_ADDRESS,
           caller->sockaddr, NULL);
 
+      if (srtobject->sender_thread) {
+        gst_structure_set (tmp,
+            /* number of buffers waiting to be sent to the caller */
+            "queue-level", G_TYPE_UINT, caller->queue.length,
+            /* number of buffers dropped by the lag policy */
+            "buffers-dropped", G_TYPE_UINT64, caller->buffers_dropped, NULL);
+      }
+
       g_value_array_append (callers_stats, NULL);
       v = g_value_array_get_nth (callers_stats, callers_stats->n_values - 1);
       g_value_init (v, GST_TYPE_STRUCTURE);
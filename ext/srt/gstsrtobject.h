@@ -36,12 +36,18 @@ G_BEGIN_DECLS
 #define GST_SRT_DEFAULT_LOCALADDRESS "0.0.0.0"
 #define GST_SRT_DEFAULT_URI GST_SRT_DEFAULT_URI_SCHEME"://"GST_SRT_DEFAULT_HOST":"G_STRINGIFY(GST_SRT_DEFAULT_PORT)
 
+/* The properties installed by gst_srt_object_install_properties_helper()
+ * have lower ids, the elements can number their own from here */
+#define GST_SRT_OBJECT_PROP_LAST 32
+
 #define GST_SRT_DEFAULT_MODE GST_SRT_CONNECTION_MODE_CALLER
 #define GST_SRT_DEFAULT_PBKEYLEN GST_SRT_KEY_LENGTH_0
 #define GST_SRT_DEFAULT_POLL_TIMEOUT -1
 #define GST_SRT_DEFAULT_LATENCY 125
 #define GST_SRT_DEFAULT_MSG_SIZE 1316
 #define GST_SRT_DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define GST_SRT_DEFAULT_CALLER_QUEUE_SIZE 0
+#define GST_SRT_DEFAULT_CALLER_LAG_POLICY GST_SRT_CALLER_LAG_POLICY_DROP_OLDEST
 
 typedef struct _GstSRTObject GstSRTObject;
 
@@ -73,6 +79,17 @@ struct _GstSRTObject
   gboolean                     authentication;
 
   guint64                      previous_bytes;
+
+  /* Fan-out to the callers of a listener sink, from sender_thread. Callers
+   * with queued data are in sender_poll_id. The properties are protected by
+   * the object lock, the rest by sock_lock */
+  guint                        caller_queue_size;
+  GstSRTCallerLagPolicy        caller_lag_policy;
+  GThread                     *sender_thread;
+  gint                         sender_poll_id;
+  GCond                        sender_cond;
+  gboolean                     sender_running;
+  guint                        sender_pending;
 };
 
 GstSRTObject   *gst_srt_object_new              (GstElement *element);
@@ -63,6 +63,12 @@ enum
 
 static guint signals[LAST_SIGNAL] = { 0 };
 
+enum
+{
+  PROP_CALLER_QUEUE_SIZE = GST_SRT_OBJECT_PROP_LAST,
+  PROP_CALLER_LAG_POLICY,
+};
+
 static void gst_srt_sink_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
 static gchar *gst_srt_sink_uri_get_uri (GstURIHandler * handler);
@@ -104,9 +110,23 @@ gst_srt_sink_set_property (GObject * object,
 {
   GstSRTSink *self = GST_SRT_SINK (object);
 
-  if (!gst_srt_object_set_property_helper (self->srtobject, prop_id, value,
-          pspec)) {
-    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+  switch (prop_id) {
+    case PROP_CALLER_QUEUE_SIZE:
+      GST_OBJECT_LOCK (self);
+      self->srtobject->caller_queue_size = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_CALLER_LAG_POLICY:
+      GST_OBJECT_LOCK (self);
+      self->srtobject->caller_lag_policy = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      if (!gst_srt_object_set_property_helper (self->srtobject, prop_id, value,
+              pspec)) {
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      }
+      break;
   }
 }
 
@@ -116,9 +136,23 @@ gst_srt_sink_get_property (GObject * object,
 {
   GstSRTSink *self = GST_SRT_SINK (object);
 
-  if (!gst_srt_object_get_property_helper (self->srtobject, prop_id, value,
-          pspec)) {
-    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+  switch (prop_id) {
+    case PROP_CALLER_QUEUE_SIZE:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->srtobject->caller_queue_size);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_CALLER_LAG_POLICY:
+      GST_OBJECT_LOCK (self);
+      g_value_set_enum (value, self->srtobject->caller_lag_policy);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      if (!gst_srt_object_get_property_helper (self->srtobject, prop_id, value,
+              pspec)) {
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      }
+      break;
   }
 }
 
@@ -366,6 +400,43 @@ gst_srt_sink_class_init (GstSRTSinkClass * klass)
 
   gst_srt_object_install_properties_helper (gobject_class);
 
+  /**
+   * GstSRTSink:caller-queue-size:
+   *
+   * In listener mode, the number of buffers that can be queued for each
+   * caller. When set, the buffers are queued for each caller and sent from a
+   * separate thread as soon as the caller can take them, so that a slow
+   * caller doesn't hold back the others nor the streaming thread. When
+   * the queue of a caller is full, #GstSRTSink:caller-lag-policy applies.
+   * 0 sends the buffers to all callers from the streaming thread.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_CALLER_QUEUE_SIZE,
+      g_param_spec_uint ("caller-queue-size", "Caller queue size",
+          "Number of buffers queued for each caller in listener mode "
+          "(0 = send from the streaming thread)", 0, G_MAXUINT,
+          GST_SRT_DEFAULT_CALLER_QUEUE_SIZE,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSRTSink:caller-lag-policy:
+   *
+   * What to do when the queue of a caller is full, see
+   * #GstSRTSink:caller-queue-size. The number of dropped buffers is
+   * reported in the statistics of each caller.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_CALLER_LAG_POLICY,
+      g_param_spec_enum ("caller-lag-policy", "Caller lag policy",
+          "What to do when the queue of a caller is full",
+          GST_TYPE_SRT_CALLER_LAG_POLICY, GST_SRT_DEFAULT_CALLER_LAG_POLICY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_type_mark_as_plugin_api (GST_TYPE_SRT_CALLER_LAG_POLICY, 0);
+
   gst_element_class_add_static_pad_template (gstelement_class, &sink_template);
   gst_element_class_set_metadata (gstelement_class,
       "SRT sink", "Sink/Network",
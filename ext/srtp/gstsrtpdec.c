@@ -207,6 +207,10 @@ static GstFlowReturn gst_srtp_dec_chain_rtp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
 static GstFlowReturn gst_srtp_dec_chain_rtcp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_srtp_dec_chain_list_rtp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
+static GstFlowReturn gst_srtp_dec_chain_list_rtcp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
 
 static GstStateChangeReturn gst_srtp_dec_change_state (GstElement * element,
     GstStateChange transition);
@@ -379,6 +383,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtp));
   gst_pad_set_chain_function (filter->rtp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtp));
+  gst_pad_set_chain_list_function (filter->rtp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtp));
 
   filter->rtp_srcpad =
       gst_pad_new_from_static_template (&rtp_src_template, "rtp_src");
@@ -402,6 +408,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtcp));
   gst_pad_set_chain_function (filter->rtcp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtcp));
+  gst_pad_set_chain_list_function (filter->rtcp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtcp));
 
   filter->rtcp_srcpad =
       gst_pad_new_from_static_template (&rtcp_src_template, "rtcp_src");
@@ -1312,7 +1320,8 @@ gst_srtp_dec_push_early_events (GstSrtpDec * filter, GstPad * pad,
 }
 
 /*
- * This function should be called while holding the filter lock
+ * This function should be called while holding the filter lock, @buf must
+ * be writable
  */
 static gboolean
 gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
@@ -1326,9 +1335,6 @@ gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
       " with SSRC = %u", is_rtcp ? "RTCP" : "RTP", gst_buffer_get_size (buf),
       ssrc);
 
-  /* Change buffer to remove protection */
-  buf = gst_buffer_make_writable (buf);
-
   gst_buffer_map (buf, &map, GST_MAP_READWRITE);
   size = map.size;
 
@@ -1443,12 +1449,28 @@ err:
   return FALSE;
 }
 
+/* Returns the source pad for @is_rtcp packets, ready to push buffers */
+static GstPad *
+gst_srtp_dec_get_src_pad (GstSrtpDec * filter, gboolean is_rtcp)
+{
+  if (is_rtcp) {
+    if (!filter->rtcp_has_segment)
+      gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
+          filter->rtp_srcpad, TRUE);
+    return filter->rtcp_srcpad;
+  } else {
+    if (!filter->rtp_has_segment)
+      gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
+          filter->rtcp_srcpad, FALSE);
+    return filter->rtp_srcpad;
+  }
+}
+
 static GstFlowReturn
 gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     gboolean is_rtcp)
 {
   GstSrtpDec *filter = GST_SRTP_DEC (parent);
-  GstPad *otherpad;
   GstSrtpDecSsrcStream *stream = NULL;
   GstFlowReturn ret = GST_FLOW_OK;
   guint32 ssrc = 0;
@@ -1468,6 +1490,9 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     goto push_out;
   }
 
+  /* The protection is removed in place */
+  buf = gst_buffer_make_writable (buf);
+
   if (!gst_srtp_dec_decode_buffer (filter, pad, buf, is_rtcp, ssrc)) {
     GST_OBJECT_UNLOCK (filter);
     goto drop_buffer;
@@ -1481,18 +1506,7 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
 push_out:
   /* Push buffer to source pad */
-  if (is_rtcp) {
-    otherpad = filter->rtcp_srcpad;
-    if (!filter->rtcp_has_segment)
-      gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
-          filter->rtp_srcpad, TRUE);
-  } else {
-    otherpad = filter->rtp_srcpad;
-    if (!filter->rtp_has_segment)
-      gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
-          filter->rtcp_srcpad, FALSE);
-  }
-  ret = gst_pad_push (otherpad, buf);
+  ret = gst_pad_push (gst_srtp_dec_get_src_pad (filter, is_rtcp), buf);
 
   return ret;
 
@@ -1504,6 +1518,101 @@ drop_buffer:
   return ret;
 }
 
+/* Decodes a whole list while holding the filter lock once. With rtcp-mux
+ * the list can mix RTP and RTCP packets, which are pushed as two lists */
+static GstFlowReturn
+gst_srtp_dec_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list, gboolean is_rtcp)
+{
+  GstSrtpDec *filter = GST_SRTP_DEC (parent);
+  GstBufferList *out_lists[2] = { NULL, NULL };
+  GArray *soft_limit_ssrcs = NULL;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer **buffers;
+  guint i, j, n_buffers;
+
+  n_buffers = gst_buffer_list_length (buf_list);
+
+  GST_LOG_OBJECT (pad, "Buffer chain with list of %u", n_buffers);
+
+  /* Take the buffers out of the list, so that the ones nobody else holds
+   * can be decrypted without a copy, and the others are only copied when
+   * they have to be decrypted */
+  buffers = g_new (GstBuffer *, n_buffers);
+  for (i = 0; i < n_buffers; i++)
+    buffers[i] = gst_buffer_ref (gst_buffer_list_get (buf_list, i));
+  gst_buffer_list_unref (buf_list);
+
+  GST_OBJECT_LOCK (filter);
+
+  for (i = 0; i < n_buffers; i++) {
+    GstBuffer *buf = buffers[i];
+    GstSrtpDecSsrcStream *stream;
+    gboolean buf_is_rtcp = is_rtcp;
+    guint32 ssrc = 0;
+
+    if (!(stream = validate_buffer (filter, buf, &ssrc, &buf_is_rtcp))) {
+      GST_WARNING_OBJECT (filter, "Invalid buffer, dropping");
+      gst_buffer_unref (buf);
+      continue;
+    }
+
+    if (STREAM_HAS_CRYPTO (stream)) {
+      /* The protection is removed in place */
+      buf = gst_buffer_make_writable (buf);
+
+      if (!gst_srtp_dec_decode_buffer (filter, pad, buf, buf_is_rtcp, ssrc)) {
+        gst_buffer_unref (buf);
+        continue;
+      }
+
+      if (gst_srtp_get_soft_limit_reached ()) {
+        if (!soft_limit_ssrcs)
+          soft_limit_ssrcs = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+        for (j = 0; j < soft_limit_ssrcs->len; j++) {
+          if (g_array_index (soft_limit_ssrcs, guint32, j) == ssrc)
+            break;
+        }
+        if (j == soft_limit_ssrcs->len)
+          g_array_append_val (soft_limit_ssrcs, ssrc);
+      }
+    }
+
+    j = buf_is_rtcp ? 1 : 0;
+    if (!out_lists[j])
+      out_lists[j] = gst_buffer_list_new_sized (n_buffers);
+    gst_buffer_list_add (out_lists[j], buf);
+  }
+
+  GST_OBJECT_UNLOCK (filter);
+
+  g_free (buffers);
+
+  /* If all is well, we may have reached soft limit */
+  if (soft_limit_ssrcs) {
+    for (j = 0; j < soft_limit_ssrcs->len; j++)
+      request_key_with_signal (filter,
+          g_array_index (soft_limit_ssrcs, guint32, j), SIGNAL_SOFT_LIMIT);
+    g_array_free (soft_limit_ssrcs, TRUE);
+  }
+
+  /* Push the RTP list, then the RTCP one */
+  for (j = 0; j < G_N_ELEMENTS (out_lists); j++) {
+    if (!out_lists[j])
+      continue;
+
+    if (ret == GST_FLOW_OK) {
+      ret = gst_pad_push_list (gst_srtp_dec_get_src_pad (filter, j == 1),
+          out_lists[j]);
+    } else {
+      gst_buffer_list_unref (out_lists[j]);
+    }
+  }
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_srtp_dec_chain_rtp (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -1516,6 +1625,20 @@ gst_srtp_dec_chain_rtcp (GstPad * pad, GstObject * parent, GstBuffer * buf)
   return gst_srtp_dec_chain (pad, parent, buf, TRUE);
 }
 
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, FALSE);
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtcp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, TRUE);
+}
+
 static GstStateChangeReturn
 gst_srtp_dec_change_state (GstElement * element, GstStateChange transition)
 {
@@ -160,14 +160,18 @@ enum
   PROP_MKI
 };
 
-typedef struct ProcessBufferItData
+/* Size of the pooled output buffers, enough for an Ethernet MTU sized packet
+ * and its SRTP trailer. Bigger packets get a buffer of their own */
+#define OUTPUT_POOL_BUFFER_SIZE (1500 + SRTP_MAX_TRAILER_LEN + 10)
+
+typedef struct ProtectItem
 {
-  GstSrtpEnc *filter;
-  GstPad *pad;
-  GstBufferList *out_list;
-  GstFlowReturn flowret;
-  gboolean is_rtcp;
-} ProcessBufferItData;
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gint size;
+  guint32 ssrc;
+  gboolean has_ssrc;
+} ProtectItem;
 
 /* the capabilities of the inputs and outputs.
  *
@@ -1107,100 +1111,193 @@ gst_srtp_enc_check_set_caps (GstSrtpEnc * filter, GstPad * pad,
   return GST_FLOW_OK;
 }
 
-static void
-gst_srtp_enc_ensure_ssrc (GstSrtpEnc * filter, GstBuffer * buf)
+static gboolean
+gst_srtp_enc_get_ssrc (GstBuffer * buf, guint32 * ssrc)
 {
   GstRTPBuffer rtpbuf = GST_RTP_BUFFER_INIT;
-  if (gst_rtp_buffer_map (buf,
-          GST_MAP_READ | GST_RTP_BUFFER_MAP_FLAG_SKIP_PADDING, &rtpbuf)) {
-    guint32 ssrc = gst_rtp_buffer_get_ssrc (&rtpbuf);
-    gst_srtp_enc_add_ssrc (filter, ssrc);
-    gst_rtp_buffer_unmap (&rtpbuf);
-  }
+
+  if (!gst_rtp_buffer_map (buf,
+          GST_MAP_READ | GST_RTP_BUFFER_MAP_FLAG_SKIP_PADDING, &rtpbuf))
+    return FALSE;
+
+  *ssrc = gst_rtp_buffer_get_ssrc (&rtpbuf);
+  gst_rtp_buffer_unmap (&rtpbuf);
+
+  return TRUE;
 }
 
-static GstFlowReturn
-gst_srtp_enc_process_buffer (GstSrtpEnc * filter, GstPad * pad,
-    GstBuffer * buf, gboolean is_rtcp, GstBuffer ** outbuf_ptr)
+/* Returns a buffer holding the packet of @buf, mapped in @map with room for
+ * the SRTP trailer. @buf itself is reused when it is writable and has enough
+ * tailroom, otherwise the packet is copied into a pooled buffer. The caller
+ * shrinks the buffer to the protected size once unmapped.
+ * Takes ownership of @buf */
+static GstBuffer *
+gst_srtp_enc_prepare_buffer (GstSrtpEnc * filter, GstBuffer * buf,
+    GstMapInfo * map)
 {
-  GstFlowReturn ret = GST_FLOW_OK;
-  gint size_max, size;
   GstBuffer *bufout = NULL;
-  GstMapInfo mapout;
-  srtp_err_status_t err;
+  gsize size, size_max, offset, maxsize;
 
-  /* Create a bigger buffer to add protection */
   size = gst_buffer_get_size (buf);
   size_max = size + SRTP_MAX_TRAILER_LEN + 10;
-  bufout = gst_buffer_new_allocate (NULL, size_max, NULL);
 
-  gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+  if (gst_buffer_is_writable (buf) && gst_buffer_n_memory (buf) == 1 &&
+      gst_buffer_is_memory_range_writable (buf, 0, -1)) {
+    gst_buffer_get_sizes (buf, &offset, &maxsize);
+
+    /* The trailer is written past the current size, which must be part of
+     * the mapping */
+    if (maxsize - offset >= size_max) {
+      gst_buffer_set_size (buf, size_max);
+      if (gst_buffer_map (buf, map, GST_MAP_READWRITE))
+        return buf;
+      gst_buffer_set_size (buf, size);
+    }
+  }
 
-  gst_buffer_extract (buf, 0, mapout.data, size);
+  if (filter->pool && size_max <= OUTPUT_POOL_BUFFER_SIZE)
+    gst_buffer_pool_acquire_buffer (filter->pool, &bufout, NULL);
+  if (bufout == NULL)
+    bufout = gst_buffer_new_allocate (NULL, size_max, NULL);
 
-  GST_OBJECT_LOCK (filter);
+  gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
 
-  gst_srtp_init_event_reporter ();
-
-  if (filter->session == NULL) {
-    /* The rtcp session disappeared (element shutting down) */
-    GST_OBJECT_UNLOCK (filter);
-    ret = GST_FLOW_FLUSHING;
-    goto fail;
-  }
+  gst_buffer_map (bufout, map, GST_MAP_READWRITE);
+  gst_buffer_extract (buf, 0, map->data, size);
+  gst_buffer_unref (buf);
 
-  gst_srtp_enc_ensure_ssrc (filter, buf);
+  return bufout;
+}
 
+/*
+ * This function should be called while holding the filter lock
+ */
+static srtp_err_status_t
+gst_srtp_enc_protect (GstSrtpEnc * filter, guint8 * data, gint * size,
+    gboolean is_rtcp)
+{
 #ifdef HAVE_SRTP2
   if (is_rtcp)
-    err = srtp_protect_rtcp_mki (filter->session, mapout.data, &size,
+    return srtp_protect_rtcp_mki (filter->session, data, size,
         (filter->mki != NULL), 0);
   else
-    err = srtp_protect_mki (filter->session, mapout.data, &size,
+    return srtp_protect_mki (filter->session, data, size,
         (filter->mki != NULL), 0);
 #else
   if (is_rtcp)
-    err = srtp_protect_rtcp (filter->session, mapout.data, &size);
+    return srtp_protect_rtcp (filter->session, data, size);
   else
-    err = srtp_protect (filter->session, mapout.data, &size);
+    return srtp_protect (filter->session, data, size);
 #endif
+}
 
-  GST_OBJECT_UNLOCK (filter);
+/* Protects the @n_buffers buffers of @buffers, replacing each of them with
+ * its protected version. The buffers are prepared before taking the filter
+ * lock, which is then only taken once for the whole batch. On failure all
+ * the buffers are released */
+static GstFlowReturn
+gst_srtp_enc_process_buffers (GstSrtpEnc * filter, GstPad * pad,
+    GstBuffer ** buffers, guint n_buffers, gboolean is_rtcp)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  srtp_err_status_t err = srtp_err_status_ok;
+  ProtectItem stack_items[8];
+  ProtectItem *items;
+  guint i;
+
+  if (n_buffers <= G_N_ELEMENTS (stack_items))
+    items = stack_items;
+  else
+    items = g_new (ProtectItem, n_buffers);
+
+  for (i = 0; i < n_buffers; i++) {
+    ProtectItem *item = &items[i];
+
+    item->has_ssrc = gst_srtp_enc_get_ssrc (buffers[i], &item->ssrc);
+    item->size = gst_buffer_get_size (buffers[i]);
+    item->buffer = gst_srtp_enc_prepare_buffer (filter, buffers[i],
+        &item->map);
+    buffers[i] = NULL;
+  }
+
+  GST_OBJECT_LOCK (filter);
 
-  gst_buffer_unmap (bufout, &mapout);
+  gst_srtp_init_event_reporter ();
 
-  if (err == srtp_err_status_ok) {
-    /* Buffer protected */
-    gst_buffer_set_size (bufout, size);
-    gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+  if (filter->session == NULL) {
+    /* The rtcp session disappeared (element shutting down) */
+    GST_OBJECT_UNLOCK (filter);
+    ret = GST_FLOW_FLUSHING;
+    goto done;
+  }
 
-    GST_LOG_OBJECT (pad, "Encoding %s buffer of size %d",
-        is_rtcp ? "RTCP" : "RTP", size);
+  for (i = 0; i < n_buffers; i++) {
+    ProtectItem *item = &items[i];
 
-  } else if (err == srtp_err_status_key_expired) {
+    if (item->has_ssrc)
+      gst_srtp_enc_add_ssrc (filter, item->ssrc);
+
+    err = gst_srtp_enc_protect (filter, item->map.data, &item->size, is_rtcp);
+    if (err != srtp_err_status_ok)
+      break;
+  }
+
+  GST_OBJECT_UNLOCK (filter);
+
+  if (err == srtp_err_status_key_expired) {
 
     GST_ELEMENT_ERROR (GST_ELEMENT_CAST (filter), STREAM, ENCODE,
         ("Key usage limit has been reached"),
         ("Unable to protect buffer (hard key usage limit reached)"));
     ret = GST_FLOW_ERROR;
-    goto fail;
 
-  } else {
+  } else if (err != srtp_err_status_ok) {
     /* srtp_protect failed */
     GST_ELEMENT_ERROR (filter, LIBRARY, FAILED, (NULL),
         ("Unable to protect buffer (protect failed) code %d", err));
     ret = GST_FLOW_ERROR;
-    goto fail;
   }
 
-  *outbuf_ptr = bufout;
-  return ret;
+done:
+  for (i = 0; i < n_buffers; i++) {
+    ProtectItem *item = &items[i];
+
+    gst_buffer_unmap (item->buffer, &item->map);
+
+    if (ret == GST_FLOW_OK) {
+      /* Buffer protected */
+      gst_buffer_set_size (item->buffer, item->size);
+      buffers[i] = item->buffer;
+
+      GST_LOG_OBJECT (pad, "Encoding %s buffer of size %d",
+          is_rtcp ? "RTCP" : "RTP", item->size);
+    } else {
+      gst_buffer_unref (item->buffer);
+    }
+  }
+
+  if (items != stack_items)
+    g_free (items);
 
-fail:
-  gst_buffer_unref (bufout);
   return ret;
 }
 
+static void
+gst_srtp_enc_check_soft_limit (GstSrtpEnc * filter)
+{
+  GST_OBJECT_LOCK (filter);
+
+  if (gst_srtp_get_soft_limit_reached ()) {
+    GST_OBJECT_UNLOCK (filter);
+    g_signal_emit (filter, gst_srtp_enc_signals[SIGNAL_SOFT_LIMIT], 0);
+    GST_OBJECT_LOCK (filter);
+    if (filter->random_key && !filter->key_changed)
+      gst_srtp_enc_replace_random_key (filter);
+  }
+
+  GST_OBJECT_UNLOCK (filter);
+}
+
 static GstFlowReturn
 gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     gboolean is_rtcp)
@@ -1208,10 +1305,10 @@ gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
   GstSrtpEnc *filter = GST_SRTP_ENC (parent);
   GstFlowReturn ret = GST_FLOW_OK;
   GstPad *otherpad;
-  GstBuffer *bufout = NULL;
 
   if ((ret = gst_srtp_enc_check_set_caps (filter, pad, is_rtcp)) != GST_FLOW_OK) {
-    goto out;
+    gst_buffer_unref (buf);
+    return ret;
   }
 
   GST_OBJECT_LOCK (filter);
@@ -1224,54 +1321,20 @@ gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
   GST_OBJECT_UNLOCK (filter);
 
-  ret = gst_srtp_enc_process_buffer (filter, pad, buf, is_rtcp, &bufout);
+  ret = gst_srtp_enc_process_buffers (filter, pad, &buf, 1, is_rtcp);
   if (ret != GST_FLOW_OK)
-    goto out;
+    return ret;
 
   /* Push buffer to source pad */
   otherpad = get_rtp_other_pad (pad);
-  ret = gst_pad_push (otherpad, bufout);
-  bufout = NULL;
+  ret = gst_pad_push (otherpad, buf);
 
-  if (ret != GST_FLOW_OK)
-    goto out;
-
-  GST_OBJECT_LOCK (filter);
+  if (ret == GST_FLOW_OK)
+    gst_srtp_enc_check_soft_limit (filter);
 
-  if (gst_srtp_get_soft_limit_reached ()) {
-    GST_OBJECT_UNLOCK (filter);
-    g_signal_emit (filter, gst_srtp_enc_signals[SIGNAL_SOFT_LIMIT], 0);
-    GST_OBJECT_LOCK (filter);
-    if (filter->random_key && !filter->key_changed)
-      gst_srtp_enc_replace_random_key (filter);
-  }
-
-  GST_OBJECT_UNLOCK (filter);
-
-out:
-  gst_buffer_unref (buf);
   return ret;
 }
 
-static gboolean
-process_buffer_it (GstBuffer ** buffer, guint index, gpointer user_data)
-{
-  ProcessBufferItData *data = user_data;
-  GstBuffer *bufout;
-  GstFlowReturn ret;
-
-  ret = gst_srtp_enc_process_buffer (data->filter, data->pad, *buffer,
-      data->is_rtcp, &bufout);
-  if (ret != GST_FLOW_OK) {
-    data->flowret = ret;
-    return FALSE;
-  }
-
-  gst_buffer_list_add (data->out_list, bufout);
-
-  return TRUE;
-}
-
 static GstFlowReturn
 gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
     GstBufferList * buf_list, gboolean is_rtcp)
@@ -1279,13 +1342,15 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
   GstSrtpEnc *filter = GST_SRTP_ENC (parent);
   GstFlowReturn ret = GST_FLOW_OK;
   GstPad *otherpad;
-  GstBufferList *out_list = NULL;
-  ProcessBufferItData process_data;
+  GstBufferList *out_list;
+  GstBuffer **buffers;
+  guint i, n_buffers;
 
-  GST_LOG_OBJECT (pad, "Buffer chain with list of %d",
-      gst_buffer_list_length (buf_list));
+  n_buffers = gst_buffer_list_length (buf_list);
 
-  if (!gst_buffer_list_length (buf_list))
+  GST_LOG_OBJECT (pad, "Buffer chain with list of %u", n_buffers);
+
+  if (!n_buffers)
     goto out;
 
   if ((ret = gst_srtp_enc_check_set_caps (filter, pad, is_rtcp)) != GST_FLOW_OK)
@@ -1301,50 +1366,37 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
 
   GST_OBJECT_UNLOCK (filter);
 
-  out_list = gst_buffer_list_new ();
-
-  process_data.filter = filter;
-  process_data.pad = pad;
-  process_data.is_rtcp = is_rtcp;
-  process_data.out_list = out_list;
-  process_data.flowret = GST_FLOW_OK;
+  /* Take the buffers out of the list, so that the ones nobody else holds
+   * can be protected in place */
+  buffers = g_new (GstBuffer *, n_buffers);
+  for (i = 0; i < n_buffers; i++)
+    buffers[i] = gst_buffer_ref (gst_buffer_list_get (buf_list, i));
+  gst_buffer_list_unref (buf_list);
+  buf_list = NULL;
 
-  if (!gst_buffer_list_foreach (buf_list, process_buffer_it, &process_data)) {
-    ret = process_data.flowret;
+  ret = gst_srtp_enc_process_buffers (filter, pad, buffers, n_buffers,
+      is_rtcp);
+  if (ret != GST_FLOW_OK) {
+    g_free (buffers);
     goto out;
   }
 
-  if (!gst_buffer_list_length (out_list)) {
-    gst_buffer_list_unref (out_list);
-    ret = GST_FLOW_OK;
-    goto out;
-  }
+  out_list = gst_buffer_list_new_sized (n_buffers);
+  for (i = 0; i < n_buffers; i++)
+    gst_buffer_list_add (out_list, buffers[i]);
+  g_free (buffers);
 
   /* Push buffer to source pad */
   otherpad = get_rtp_other_pad (pad);
-  GST_LOG_OBJECT (pad, "Pushing buffer chain of %d",
-      gst_buffer_list_length (buf_list));
+  GST_LOG_OBJECT (pad, "Pushing buffer chain of %u", n_buffers);
   ret = gst_pad_push_list (otherpad, out_list);
 
-  if (ret != GST_FLOW_OK) {
-    goto out;
-  }
-
-  GST_OBJECT_LOCK (filter);
-
-  if (gst_srtp_get_soft_limit_reached ()) {
-    GST_OBJECT_UNLOCK (filter);
-    g_signal_emit (filter, gst_srtp_enc_signals[SIGNAL_SOFT_LIMIT], 0);
-    GST_OBJECT_LOCK (filter);
-    if (filter->random_key && !filter->key_changed)
-      gst_srtp_enc_replace_random_key (filter);
-  }
-
-  GST_OBJECT_UNLOCK (filter);
+  if (ret == GST_FLOW_OK)
+    gst_srtp_enc_check_soft_limit (filter);
 
 out:
-
-  gst_buffer_list_unref (buf_list);
+  if (buf_list)
+    gst_buffer_list_unref (buf_list);
 
   return ret;
 }
@@ -1419,7 +1471,20 @@ gst_srtp_enc_change_state (GstElement * element, GstStateChange transition)
       GST_OBJECT_UNLOCK (filter);
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+    {
+      GstStructure *config;
+
+      filter->pool = gst_buffer_pool_new ();
+      config = gst_buffer_pool_get_config (filter->pool);
+      gst_buffer_pool_config_set_params (config, NULL,
+          OUTPUT_POOL_BUFFER_SIZE, 0, 0);
+      gst_buffer_pool_set_config (filter->pool, config);
+      if (!gst_buffer_pool_set_active (filter->pool, TRUE)) {
+        GST_WARNING_OBJECT (filter, "Failed to activate the buffer pool");
+        gst_clear_object (&filter->pool);
+      }
       break;
+    }
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
     default:
@@ -1434,6 +1499,10 @@ gst_srtp_enc_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_srtp_enc_reset (filter);
+      if (filter->pool) {
+        gst_buffer_pool_set_active (filter->pool, FALSE);
+        gst_clear_object (&filter->pool);
+      }
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
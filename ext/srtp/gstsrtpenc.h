@@ -86,6 +86,8 @@ struct _GstSrtpEnc
   gboolean allow_repeat_tx;
 
   GHashTable *ssrcs_set;
+
+  GstBufferPool *pool;
 };
 
 struct _GstSrtpEncClass
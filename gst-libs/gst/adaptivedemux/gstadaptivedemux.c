@@ -119,6 +119,7 @@ that the demux object and its streams are not changed by anybody else.
 #endif
 
 #include "gstadaptivedemux.h"
+#include "gstadaptivedemuxabr.h"
 #include "gst/gst-i18n-plugin.h"
 #include <gst/base/gstadapter.h>
 
@@ -129,8 +130,12 @@ GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define DEFAULT_FAILED_COUNT 3
 #define DEFAULT_CONNECTION_SPEED 0
 #define DEFAULT_BITRATE_LIMIT 0.8f
+#define DEFAULT_ABR_POLICY GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT
+#define DEFAULT_ABR_ESTIMATOR GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE
+#define DEFAULT_ABR_BUFFER_TARGET (10 * GST_SECOND)
+#define DEFAULT_PREFETCH_FRAGMENTS 0
+#define MAX_PREFETCH_FRAGMENTS 16
 #define SRC_QUEUE_MAX_BYTES 20 * 1024 * 1024    /* For safety. Large enough to hold a segment. */
-#define NUM_LOOKBACK_FRAGMENTS 3
 
 #define GST_MANIFEST_GET_LOCK(d) (&(GST_ADAPTIVE_DEMUX_CAST(d)->priv->manifest_lock))
 #define GST_MANIFEST_LOCK(d) G_STMT_START { \
@@ -157,6 +162,10 @@ enum
   PROP_0,
   PROP_CONNECTION_SPEED,
   PROP_BITRATE_LIMIT,
+  PROP_ABR_POLICY,
+  PROP_ABR_ESTIMATOR,
+  PROP_ABR_BUFFER_TARGET,
+  PROP_PREFETCH_FRAGMENTS,
   PROP_LAST
 };
 
@@ -207,6 +216,13 @@ struct _GstAdaptiveDemuxPrivate
   GMutex segment_lock;
 
   GstClockTime qos_earliest_time;
+
+  /* bitrate selection, protected by manifest_lock */
+  GstAdaptiveDemuxAbrPolicy abr_policy;
+  GstAdaptiveDemuxBandwidthEstimator abr_estimator;
+  GstClockTime abr_buffer_target;
+
+  guint prefetch_fragments;     /* protected by manifest_lock */
 };
 
 typedef struct _GstAdaptiveDemuxTimer
@@ -363,6 +379,27 @@ gst_adaptive_demux_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       demux->bitrate_limit = g_value_get_float (value);
       break;
+    case PROP_ABR_POLICY:
+      demux->priv->abr_policy = g_value_get_enum (value);
+      break;
+    case PROP_ABR_ESTIMATOR:
+      demux->priv->abr_estimator = g_value_get_enum (value);
+      break;
+    case PROP_ABR_BUFFER_TARGET:
+      demux->priv->abr_buffer_target = g_value_get_uint64 (value);
+      break;
+    case PROP_PREFETCH_FRAGMENTS:
+      demux->priv->prefetch_fragments = g_value_get_uint (value);
+      if (demux->priv->prefetch_fragments == 0) {
+        GList *iter;
+
+        for (iter = demux->streams; iter; iter = g_list_next (iter)) {
+          GstAdaptiveDemuxStream *stream = iter->data;
+          if (stream->prefetch)
+            gst_adaptive_demux_prefetch_flush (stream->prefetch);
+        }
+      }
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -387,6 +424,18 @@ gst_adaptive_demux_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       g_value_set_float (value, demux->bitrate_limit);
       break;
+    case PROP_ABR_POLICY:
+      g_value_set_enum (value, demux->priv->abr_policy);
+      break;
+    case PROP_ABR_ESTIMATOR:
+      g_value_set_enum (value, demux->priv->abr_estimator);
+      break;
+    case PROP_ABR_BUFFER_TARGET:
+      g_value_set_uint64 (value, demux->priv->abr_buffer_target);
+      break;
+    case PROP_PREFETCH_FRAGMENTS:
+      g_value_set_uint (value, demux->priv->prefetch_fragments);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -432,6 +481,69 @@ gst_adaptive_demux_class_init (GstAdaptiveDemuxClass * klass)
           0, 1, DEFAULT_BITRATE_LIMIT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAdaptiveDemux:abr-policy:
+   *
+   * Policy used to select the bitrate of the next fragment. Can be changed
+   * at any time, it is applied from the next fragment on.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_ABR_POLICY,
+      g_param_spec_enum ("abr-policy", "ABR policy",
+          "Policy used to select the bitrate of the next fragment",
+          GST_TYPE_ADAPTIVE_DEMUX_ABR_POLICY, DEFAULT_ABR_POLICY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:abr-estimator:
+   *
+   * Method used to estimate the available bandwidth from the previous
+   * downloads. Can be changed at any time, all estimators are kept up to
+   * date.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_ABR_ESTIMATOR,
+      g_param_spec_enum ("abr-estimator", "ABR bandwidth estimator",
+          "Method used to estimate the available bandwidth",
+          GST_TYPE_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR, DEFAULT_ABR_ESTIMATOR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:abr-buffer-target:
+   *
+   * Amount of data buffered ahead of the playback position that the buffer
+   * based ABR policies aim for. Below a third of it, the lowest bitrate is
+   * selected.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_ABR_BUFFER_TARGET,
+      g_param_spec_uint64 ("abr-buffer-target", "ABR buffer target",
+          "Target buffer level of the buffer based ABR policies (in ns)",
+          0, G_MAXUINT64, DEFAULT_ABR_BUFFER_TARGET,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:prefetch-fragments:
+   *
+   * Number of fragments to download ahead of the current one for each
+   * stream. They are downloaded one after the other on a separate
+   * connection, while the current fragment is downloaded and pushed.
+   * Prefetched fragments are kept in memory until they are needed, and
+   * discarded on seeks and bitrate switches. Only used in forward playback,
+   * and if the subclass supports it.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_FRAGMENTS,
+      g_param_spec_uint ("prefetch-fragments", "Prefetch fragments",
+          "Number of fragments to download ahead of the current one "
+          "(0 = disabled)", 0, MAX_PREFETCH_FRAGMENTS,
+          DEFAULT_PREFETCH_FRAGMENTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_adaptive_demux_change_state;
 
   gstbin_class->handle_message = gst_adaptive_demux_handle_message;
@@ -522,6 +634,10 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   /* Properties */
   demux->bitrate_limit = DEFAULT_BITRATE_LIMIT;
   demux->connection_speed = DEFAULT_CONNECTION_SPEED;
+  demux->priv->abr_policy = DEFAULT_ABR_POLICY;
+  demux->priv->abr_estimator = DEFAULT_ABR_ESTIMATOR;
+  demux->priv->abr_buffer_target = DEFAULT_ABR_BUFFER_TARGET;
+  demux->priv->prefetch_fragments = DEFAULT_PREFETCH_FRAGMENTS;
 
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 }
@@ -1321,8 +1437,9 @@ gst_adaptive_demux_stream_new (GstAdaptiveDemux * demux, GstPad * pad)
 
   stream->pad = pad;
   stream->demux = demux;
-  stream->fragment_bitrates =
-      g_malloc0 (sizeof (guint64) * NUM_LOOKBACK_FRAGMENTS);
+  stream->abr = gst_adaptive_demux_abr_new ();
+  stream->last_request_gap = GST_CLOCK_TIME_NONE;
+  stream->last_download_end = GST_CLOCK_TIME_NONE;
   gst_pad_set_element_private (pad, stream);
   stream->qos_earliest_time = GST_CLOCK_TIME_NONE;
 
@@ -1387,6 +1504,10 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
       stream->cancelled = TRUE;
       g_cond_signal (&stream->fragment_download_cond);
       g_mutex_unlock (&stream->fragment_download_lock);
+
+      /* wake up the task if it is waiting for a prefetch */
+      if (stream->prefetch)
+        gst_adaptive_demux_prefetch_flush (stream->prefetch);
     }
     GST_LOG_OBJECT (demux, "Waiting for task to finish");
 
@@ -1438,7 +1559,9 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
 
   g_cond_clear (&stream->fragment_download_cond);
   g_mutex_clear (&stream->fragment_download_lock);
-  g_free (stream->fragment_bitrates);
+  gst_adaptive_demux_abr_free (stream->abr);
+  if (stream->prefetch)
+    gst_adaptive_demux_prefetch_free (stream->prefetch);
 
   if (stream->pad) {
     gst_object_unref (stream->pad);
@@ -2145,6 +2268,10 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
       gst_task_stop (stream->download_task);
       g_cond_signal (&stream->fragment_download_cond);
       g_mutex_unlock (&stream->fragment_download_lock);
+
+      /* prefetched data is for the old position */
+      if (stream->prefetch)
+        gst_adaptive_demux_prefetch_flush (stream->prefetch);
     }
     list_to_process = demux->prepared_streams;
   }
@@ -2254,56 +2381,71 @@ gst_adaptive_demux_stream_queue_event (GstAdaptiveDemuxStream * stream,
   stream->pending_events = g_list_append (stream->pending_events, event);
 }
 
-/* must be called with manifest_lock taken */
-static guint64
-_update_average_bitrate (GstAdaptiveDemux * demux,
-    GstAdaptiveDemuxStream * stream, guint64 new_bitrate)
+/* Amount of data buffered downstream of the demuxer for @stream, or
+ * GST_CLOCK_TIME_NONE if it can't be known because not playing */
+static GstClockTime
+gst_adaptive_demux_stream_get_buffer_level (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
 {
-  gint index = stream->moving_index % NUM_LOOKBACK_FRAGMENTS;
+  GstClock *clock;
+  GstClockTime base_time, now, position;
+
+  if (GST_STATE (demux) != GST_STATE_PLAYING)
+    return GST_CLOCK_TIME_NONE;
 
-  stream->moving_bitrate -= stream->fragment_bitrates[index];
-  stream->fragment_bitrates[index] = new_bitrate;
-  stream->moving_bitrate += new_bitrate;
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (demux));
+  if (clock == NULL)
+    return GST_CLOCK_TIME_NONE;
+  base_time = gst_element_get_base_time (GST_ELEMENT_CAST (demux));
+  now = gst_clock_get_time (clock);
+  gst_object_unref (clock);
+
+  GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
+  position = gst_segment_to_running_time (&stream->segment, GST_FORMAT_TIME,
+      stream->segment.position);
+  GST_ADAPTIVE_DEMUX_SEGMENT_UNLOCK (demux);
 
-  stream->moving_index += 1;
+  if (!GST_CLOCK_TIME_IS_VALID (position) || now < base_time)
+    return GST_CLOCK_TIME_NONE;
 
-  if (stream->moving_index > NUM_LOOKBACK_FRAGMENTS)
-    return stream->moving_bitrate / NUM_LOOKBACK_FRAGMENTS;
-  return stream->moving_bitrate / stream->moving_index;
+  now -= base_time;
+  return position > now ? position - now : 0;
 }
 
-/* must be called with manifest_lock taken */
+/* must be called with manifest_lock taken. @decision->current_bitrate is
+ * set by the caller, the other fields are filled in */
 static guint64
 gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
-    GstAdaptiveDemuxStream * stream)
+    GstAdaptiveDemuxStream * stream, GstAdaptiveDemuxAbrDecision * decision)
 {
-  guint64 average_bitrate;
-  guint64 fragment_bitrate;
+  decision->policy = demux->priv->abr_policy;
+  decision->estimator = demux->priv->abr_estimator;
+  decision->bitrate_limit = demux->bitrate_limit;
+  decision->buffer_target = demux->priv->abr_buffer_target;
+  decision->buffer_level =
+      gst_adaptive_demux_stream_get_buffer_level (demux, stream);
 
   if (demux->connection_speed) {
     GST_LOG_OBJECT (demux, "Connection-speed is set to %u kbps, using it",
         demux->connection_speed / 1000);
+    decision->bandwidth = decision->target_bitrate = demux->connection_speed;
     stream->current_download_rate = demux->connection_speed;
     return demux->connection_speed;
   }
 
-  fragment_bitrate = stream->last_bitrate;
   GST_DEBUG_OBJECT (demux, "Download bitrate is : %" G_GUINT64_FORMAT " bps",
-      fragment_bitrate);
+      stream->last_bitrate);
 
-  average_bitrate = _update_average_bitrate (demux, stream, fragment_bitrate);
+  gst_adaptive_demux_abr_decide (stream->abr, decision);
 
   GST_INFO_OBJECT (GST_ADAPTIVE_DEMUX_STREAM_PAD (stream),
-      "last fragment bitrate was %" G_GUINT64_FORMAT, fragment_bitrate);
-  GST_INFO_OBJECT (GST_ADAPTIVE_DEMUX_STREAM_PAD (stream),
-      "Last %u fragments average bitrate is %" G_GUINT64_FORMAT,
-      NUM_LOOKBACK_FRAGMENTS, average_bitrate);
-
-  /* Conservative approach, make sure we don't upgrade too fast */
-  stream->current_download_rate = MIN (average_bitrate, fragment_bitrate);
+      "last fragment bitrate was %" G_GUINT64_FORMAT ", estimated bandwidth %"
+      G_GUINT64_FORMAT ", buffer level %" GST_TIME_FORMAT,
+      stream->last_bitrate, decision->bandwidth,
+      GST_TIME_ARGS (decision->buffer_level));
 
-  stream->current_download_rate *= demux->bitrate_limit;
-  GST_DEBUG_OBJECT (demux, "Bitrate after bitrate limit (%0.2f): %"
+  stream->current_download_rate = decision->target_bitrate;
+  GST_DEBUG_OBJECT (demux, "Target bitrate (limit %0.2f): %"
       G_GUINT64_FORMAT, demux->bitrate_limit, stream->current_download_rate);
 
 #if 0
@@ -2664,7 +2806,7 @@ _src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
        * and we don't have a birate from the sub-class, then see if we
        * can work it out from the fragment size and duration */
       if (stream->fragment.bitrate == 0 &&
-          stream->fragment.duration != 0 &&
+          stream->fragment.duration != 0 && !stream->last_prefetched &&
           gst_element_query_duration (stream->uri_handler, GST_FORMAT_BYTES,
               &chunk_size) && chunk_size != -1) {
         guint bitrate = MIN (G_MAXUINT, gst_util_uint64_scale (chunk_size,
@@ -2854,15 +2996,23 @@ _uri_handler_probe (GstPad * pad, GstPadProbeInfo * info,
 
   if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
     GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+    GstClockTime now = gst_adaptive_demux_get_monotonic_time (stream->demux);
+
     if (stream->fragment_bytes_downloaded == 0) {
-      stream->last_latency =
-          gst_adaptive_demux_get_monotonic_time (stream->demux) -
-          (stream->download_start_time * GST_USECOND);
+      stream->last_chunk_time = stream->download_start_time * GST_USECOND;
+      stream->last_latency = now - stream->last_chunk_time;
       GST_DEBUG_OBJECT (pad,
           "FIRST BYTE since download_start %" GST_TIME_FORMAT,
           GST_TIME_ARGS (stream->last_latency));
     }
     stream->fragment_bytes_downloaded += gst_buffer_get_size (buf);
+    /* headers and indexes are too small to tell the bandwidth */
+    if (now > stream->last_chunk_time && !stream->downloading_header &&
+        !stream->downloading_index) {
+      gst_adaptive_demux_abr_add_chunk (stream->abr,
+          gst_buffer_get_size (buf), now - stream->last_chunk_time);
+      stream->last_chunk_time = now;
+    }
     GST_LOG_OBJECT (pad,
         "Received buffer, size %" G_GSIZE_FORMAT " total %" G_GUINT64_FORMAT,
         gst_buffer_get_size (buf), stream->fragment_bytes_downloaded);
@@ -2877,8 +3027,9 @@ _uri_handler_probe (GstPad * pad, GstPadProbeInfo * info,
         break;
       case GST_EVENT_EOS:
       {
-        stream->last_download_time =
-            gst_adaptive_demux_get_monotonic_time (stream->demux) -
+        stream->last_download_end =
+            gst_adaptive_demux_get_monotonic_time (stream->demux);
+        stream->last_download_time = stream->last_download_end -
             (stream->download_start_time * GST_USECOND);
         stream->last_bitrate =
             gst_util_uint64_scale (stream->fragment_bytes_downloaded,
@@ -2888,6 +3039,9 @@ _uri_handler_probe (GstPad * pad, GstPadProbeInfo * info,
             G_GUINT64_FORMAT " bps", GST_TIME_ARGS (stream->last_download_time),
             stream->last_bitrate);
         /* Calculate bitrate since URI request */
+        if (!stream->downloading_header && !stream->downloading_index)
+          gst_adaptive_demux_abr_add_fragment (stream->abr,
+              stream->last_bitrate);
       }
         break;
       default:
@@ -3239,6 +3393,17 @@ gst_adaptive_demux_stream_download_uri (GstAdaptiveDemux * demux,
       stream->download_start_time =
           GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
 
+      /* Time the connection was idle since the previous download */
+      if (GST_CLOCK_TIME_IS_VALID (stream->last_download_end) &&
+          stream->download_start_time * GST_USECOND >
+          stream->last_download_end)
+        stream->last_request_gap =
+            stream->download_start_time * GST_USECOND -
+            stream->last_download_end;
+      else
+        stream->last_request_gap = GST_CLOCK_TIME_NONE;
+      stream->last_prefetched = FALSE;
+
       /* src element is in state READY. Before we start it, we reset
        * download_finished
        */
@@ -3385,6 +3550,94 @@ gst_adaptive_demux_stream_download_header_fragment (GstAdaptiveDemuxStream *
   return ret;
 }
 
+/* must be called with manifest_lock taken */
+static gboolean
+gst_adaptive_demux_stream_can_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+
+  /* the first fragment goes through the source, which sets up the internal
+   * pad prefetched data is pushed to */
+  return klass->stream_peek_fragment != NULL &&
+      demux->priv->prefetch_fragments > 0 && stream->internal_pad != NULL &&
+      demux->segment.rate > 0 && !GST_ADAPTIVE_DEMUX_IN_TRICKMODE_KEY_UNITS
+      (demux);
+}
+
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_stream_prefetch_next (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  guint i;
+
+  if (!stream->prefetch)
+    stream->prefetch =
+        gst_adaptive_demux_prefetch_new (GST_ELEMENT_CAST (demux),
+        SRC_QUEUE_MAX_BYTES);
+
+  for (i = 1; i <= demux->priv->prefetch_fragments; i++) {
+    gchar *uri = NULL;
+    gint64 range_start, range_end;
+
+    if (!klass->stream_peek_fragment (stream, i, &uri, &range_start,
+            &range_end))
+      break;
+
+    if (gst_adaptive_demux_prefetch_request (stream->prefetch, uri,
+            range_start, range_end, demux->priv->prefetch_fragments))
+      GST_DEBUG_OBJECT (stream->pad, "Prefetching fragment %u: %s", i, uri);
+    g_free (uri);
+  }
+}
+
+/* must be called with manifest_lock taken.
+ *
+ * Pushes a prefetched fragment through the same path as data downloaded by
+ * the source would go, and returns the download result */
+static GstFlowReturn
+gst_adaptive_demux_stream_push_prefetched (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstBuffer * buffer,
+    GstClockTime request_gap, GstClockTime download_time)
+{
+  gsize size = gst_buffer_get_size (buffer);
+  GstFlowReturn ret;
+
+  stream->download_start_time =
+      GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  stream->download_finished = FALSE;
+  stream->downloading_first_buffer = TRUE;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  /* what _uri_handler_probe() measures for the source */
+  stream->fragment_bytes_downloaded = size;
+  stream->last_latency = GST_CLOCK_TIME_NONE;
+  stream->last_download_time = download_time;
+  stream->last_request_gap = request_gap;
+  stream->last_prefetched = TRUE;
+  if (download_time > 0) {
+    stream->last_bitrate =
+        gst_util_uint64_scale (size, 8 * GST_SECOND, download_time);
+    gst_adaptive_demux_abr_add_chunk (stream->abr, size, download_time);
+    gst_adaptive_demux_abr_add_fragment (stream->abr, stream->last_bitrate);
+  }
+
+  GST_DEBUG_OBJECT (stream->pad, "Pushing prefetched fragment of %"
+      G_GSIZE_FORMAT " bytes, downloaded in %" GST_TIME_FORMAT, size,
+      GST_TIME_ARGS (download_time));
+
+  ret = _src_chain (stream->internal_pad, GST_OBJECT_CAST (demux), buffer);
+  /* on errors, the download was already finished by _src_chain() */
+  if (ret == GST_FLOW_OK)
+    gst_adaptive_demux_eos_handling (stream);
+
+  return stream->last_ret;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  */
@@ -3503,11 +3756,46 @@ again:
         chunk_end = MIN (chunk_end, range_end);
     }
   } else {
-    ret =
-        gst_adaptive_demux_stream_download_uri (demux, stream, url,
-        stream->fragment.range_start, stream->fragment.range_end, &http_status);
-    GST_DEBUG_OBJECT (stream->pad, "Fragment download result: %d (%d) %s",
-        stream->last_ret, http_status, gst_flow_get_name (stream->last_ret));
+    GstBuffer *prefetched = NULL;
+    GstClockTime request_gap = GST_CLOCK_TIME_NONE, download_time = 0;
+
+    if (gst_adaptive_demux_stream_can_prefetch (demux, stream)) {
+      /* nothing was prefetched before the first use */
+      if (stream->prefetch) {
+        GstAdaptiveDemuxPrefetch *prefetch = stream->prefetch;
+
+        GST_MANIFEST_UNLOCK (demux);
+        prefetched = gst_adaptive_demux_prefetch_take (prefetch, url,
+            stream->fragment.range_start, stream->fragment.range_end,
+            &request_gap, &download_time);
+        GST_MANIFEST_LOCK (demux);
+
+        g_mutex_lock (&stream->fragment_download_lock);
+        if (G_UNLIKELY (stream->cancelled)) {
+          g_mutex_unlock (&stream->fragment_download_lock);
+          if (prefetched)
+            gst_buffer_unref (prefetched);
+          return stream->last_ret = GST_FLOW_FLUSHING;
+        }
+        g_mutex_unlock (&stream->fragment_download_lock);
+      }
+
+      gst_adaptive_demux_stream_prefetch_next (demux, stream);
+    }
+
+    if (prefetched) {
+      ret = gst_adaptive_demux_stream_push_prefetched (demux, stream,
+          prefetched, request_gap, download_time);
+      GST_DEBUG_OBJECT (stream->pad, "Prefetched fragment result: %s",
+          gst_flow_get_name (ret));
+    } else {
+      ret =
+          gst_adaptive_demux_stream_download_uri (demux, stream, url,
+          stream->fragment.range_start, stream->fragment.range_end,
+          &http_status);
+      GST_DEBUG_OBJECT (stream->pad, "Fragment download result: %d (%d) %s",
+          stream->last_ret, http_status, gst_flow_get_name (stream->last_ret));
+    }
   }
   if (ret == GST_FLOW_OK)
     goto beach;
@@ -4227,6 +4515,8 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
 {
   GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
   GstFlowReturn ret;
+  GstAdaptiveDemuxAbrDecision decision = { 0, };
+  GstClockTime transfer_time;
 
   g_return_val_if_fail (klass->stream_advance_fragment != NULL, GST_FLOW_ERROR);
 
@@ -4237,6 +4527,12 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
   stream->download_error_count = 0;
   g_clear_error (&stream->last_error);
 
+  /* Time spent receiving data, as opposed to waiting for the response */
+  transfer_time = stream->last_download_time;
+  if (GST_CLOCK_TIME_IS_VALID (stream->last_latency) &&
+      stream->last_latency < transfer_time)
+    transfer_time -= stream->last_latency;
+
   /* FIXME - url has no indication of byte ranges for subsegments */
   /* FIXME : All those time statistics are biased, since they are calculated
    * *AFTER* the queue2, which might be blocking. They should ideally be
@@ -4251,7 +4547,20 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
               "fragment-stop-time", GST_TYPE_CLOCK_TIME,
               gst_util_get_timestamp (), "fragment-size", G_TYPE_UINT64,
               stream->download_total_bytes, "fragment-download-time",
-              GST_TYPE_CLOCK_TIME, stream->last_download_time, NULL)));
+              GST_TYPE_CLOCK_TIME, stream->last_download_time,
+              "fragment-request-gap", GST_TYPE_CLOCK_TIME,
+              stream->last_request_gap, "fragment-latency",
+              GST_TYPE_CLOCK_TIME, stream->last_latency,
+              "fragment-transfer-time", GST_TYPE_CLOCK_TIME,
+              transfer_time, "fragment-prefetched", G_TYPE_BOOLEAN,
+              stream->last_prefetched, NULL)));
+
+  /* Bitrate of the fragment we just finished, used as the current bitrate
+   * by the buffer based ABR policies */
+  if (GST_CLOCK_TIME_IS_VALID (duration) && duration > 0)
+    decision.current_bitrate =
+        gst_util_uint64_scale (stream->fragment_bytes_downloaded,
+        8 * GST_SECOND, duration);
 
   /* Don't update to the end of the segment if in reverse playback */
   GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
@@ -4291,8 +4600,27 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
       GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
 
   if (ret == GST_FLOW_OK) {
-    if (gst_adaptive_demux_stream_select_bitrate (demux, stream,
-            gst_adaptive_demux_stream_update_current_bitrate (demux, stream))) {
+    gboolean switched;
+
+    switched = gst_adaptive_demux_stream_select_bitrate (demux, stream,
+        gst_adaptive_demux_stream_update_current_bitrate (demux, stream,
+            &decision));
+
+    gst_element_post_message (GST_ELEMENT_CAST (demux),
+        gst_message_new_element (GST_OBJECT_CAST (demux),
+            gst_structure_new (GST_ADAPTIVE_DEMUX_ABR_DECISION_MESSAGE_NAME,
+                "stream", G_TYPE_STRING, GST_PAD_NAME (stream->pad),
+                "policy", GST_TYPE_ADAPTIVE_DEMUX_ABR_POLICY, decision.policy,
+                "estimator", GST_TYPE_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR,
+                decision.estimator, "fragment-bitrate", G_TYPE_UINT64,
+                stream->last_bitrate, "estimated-bandwidth", G_TYPE_UINT64,
+                decision.bandwidth, "buffer-level", GST_TYPE_CLOCK_TIME,
+                decision.buffer_level, "current-bitrate", G_TYPE_UINT64,
+                decision.current_bitrate, "target-bitrate", G_TYPE_UINT64,
+                decision.target_bitrate, "switched", G_TYPE_BOOLEAN,
+                switched, NULL)));
+
+    if (switched) {
       stream->need_header = TRUE;
       ret = (GstFlowReturn) GST_ADAPTIVE_DEMUX_FLOW_SWITCH;
     }
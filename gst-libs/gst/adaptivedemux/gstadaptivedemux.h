@@ -26,6 +26,7 @@
 #include <gst/base/gstadapter.h>
 #include <gst/uridownloader/gsturidownloader.h>
 #include <gst/adaptivedemux/adaptive-demux-prelude.h>
+#include <gst/adaptivedemux/gstadaptivedemuxprefetch.h>
 
 G_BEGIN_DECLS
 
@@ -75,6 +76,16 @@ G_BEGIN_DECLS
  */
 #define GST_ADAPTIVE_DEMUX_STATISTICS_MESSAGE_NAME "adaptive-streaming-statistics"
 
+/**
+ * GST_ADAPTIVE_DEMUX_ABR_DECISION_MESSAGE_NAME:
+ *
+ * Name of the ELEMENT type messages posted by adaptive demuxers every time
+ * the bitrate for the next fragment of a stream is selected.
+ *
+ * Since: 1.20
+ */
+#define GST_ADAPTIVE_DEMUX_ABR_DECISION_MESSAGE_NAME "adaptive-streaming-abr-decision"
+
 #define GST_ELEMENT_ERROR_FROM_ERROR(el, msg, err) G_STMT_START { \
   gchar *__dbg = g_strdup_printf ("%s: %s", msg, err->message);         \
   GST_WARNING_OBJECT (el, "error: %s", __dbg);                          \
@@ -178,11 +189,20 @@ struct _GstAdaptiveDemuxStream
    * of previous fragment (pre-queue2) */
   GstClockTime last_latency;
   GstClockTime last_download_time;
+  /* time between the end of the previous download and the request of the
+   * current one, and when the previous download ended */
+  GstClockTime last_request_gap;
+  GstClockTime last_download_end;
+  /* whether the previous fragment was prefetched */
+  gboolean last_prefetched;
+
+  /* Downloads of the next fragments, created when first needed */
+  GstAdaptiveDemuxPrefetch *prefetch;
 
-  /* Average for the last fragments */
-  guint64 moving_bitrate;
-  guint moving_index;
-  guint64 *fragment_bitrates;
+  /* Bandwidth estimation from the previous fragments */
+  struct _GstAdaptiveDemuxAbr *abr;
+  /* time the last chunk of the current fragment was received (pre-queue2) */
+  GstClockTime last_chunk_time;
 
   /* QoS data : UNUSED !!! */
   GstClockTime qos_earliest_time;
@@ -482,6 +502,23 @@ struct _GstAdaptiveDemuxClass
    * Return: %TRUE if the playlist needs to be refreshed periodically by the demuxer.
    */
   gboolean (*requires_periodical_playlist_update) (GstAdaptiveDemux * demux);
+
+  /**
+   * stream_peek_fragment:
+   * @stream: #GstAdaptiveDemuxStream
+   * @offset: number of fragments after the current one
+   * @uri: (out): location for the URI of the fragment
+   * @range_start: (out): location for the start of the byte range
+   * @range_end: (out): location for the inclusive end of the byte range, or -1
+   *
+   * Optional. Gets the location of an upcoming fragment without advancing,
+   * so that it can be prefetched while the current one is downloaded.
+   *
+   * Return: %TRUE if there is such a fragment
+   *
+   * Since: 1.20
+   */
+  gboolean (*stream_peek_fragment) (GstAdaptiveDemuxStream * stream, guint offset, gchar ** uri, gint64 * range_start, gint64 * range_end);
 };
 
 GST_ADAPTIVE_DEMUX_API
@@ -0,0 +1,322 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Bandwidth estimation and bitrate selection for GstAdaptiveDemux.
+ *
+ * All estimators are updated for every stream, so that switching the
+ * estimator at runtime doesn't start over from an empty history. The
+ * moving average and harmonic mean estimators are fed once per fragment,
+ * while the EWMA estimator also gets fed while a fragment is being
+ * downloaded, so that it reacts to a drop in bandwidth before the end of
+ * a long fragment.
+ *
+ * The buffer based policy is a proportional controller on the buffer level
+ * relative to the target buffer level (BBA/BOLA-like): at the target level
+ * the current bitrate is kept, above it a proportionally higher bitrate is
+ * requested and below the reservoir (a third of the target) the lowest
+ * bitrate is requested. It doesn't need to know the list of available
+ * bitrates, the subclass picks the closest one as usual.
+ *
+ * The estimators and policies are a fixed set selected through enum
+ * properties, there is no interface for applications or subclasses to
+ * provide their own.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+
+#include "gstadaptivedemuxabr.h"
+
+GST_DEBUG_CATEGORY_EXTERN (adaptivedemux_debug);
+#define GST_CAT_DEFAULT adaptivedemux_debug
+
+#define NUM_LOOKBACK_FRAGMENTS 3
+#define NUM_HARMONIC_FRAGMENTS 5
+
+/* half lives, in seconds of download time */
+#define EWMA_FAST_HALF_LIFE 2.0
+#define EWMA_SLOW_HALF_LIFE 5.0
+
+/* chunks smaller than this are too noisy to be used as samples */
+#define MIN_CHUNK_BYTES (16 * 1024)
+#define MIN_CHUNK_DURATION (50 * GST_MSECOND)
+
+typedef struct
+{
+  gdouble half_life;
+  gdouble estimate;
+  gdouble total_weight;
+} GstAdaptiveDemuxEwma;
+
+struct _GstAdaptiveDemuxAbr
+{
+  /* chunks are added from the source streaming thread */
+  GMutex lock;
+
+  guint64 last_bitrate;
+
+  /* moving average */
+  guint64 fragment_bitrates[NUM_LOOKBACK_FRAGMENTS];
+  guint64 moving_bitrate;
+  guint moving_index;
+
+  /* harmonic mean */
+  guint64 harmonic_bitrates[NUM_HARMONIC_FRAGMENTS];
+
+  /* EWMA, and the chunk being accumulated for the next sample */
+  GstAdaptiveDemuxEwma fast;
+  GstAdaptiveDemuxEwma slow;
+  guint64 pending_bytes;
+  GstClockTime pending_duration;
+};
+
+GType
+gst_adaptive_demux_abr_policy_get_type (void)
+{
+  static volatile gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT,
+        "Select the bitrate from the estimated bandwidth", "throughput"},
+    {GST_ADAPTIVE_DEMUX_ABR_POLICY_BUFFER,
+        "Select the bitrate from the buffer level", "buffer"},
+    {GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID,
+          "Select the bitrate from the estimated bandwidth, with a margin "
+          "depending on the buffer level", "hybrid"},
+    {0, NULL, NULL},
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType _type =
+        g_enum_register_static ("GstAdaptiveDemuxAbrPolicy", values);
+    g_once_init_leave (&type, _type);
+  }
+
+  return type;
+}
+
+GType
+gst_adaptive_demux_bandwidth_estimator_get_type (void)
+{
+  static volatile gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE,
+        "Moving average of the last fragments", "moving-average"},
+    {GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_EWMA,
+        "Exponentially weighted moving average", "ewma"},
+    {GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_HARMONIC_MEAN,
+        "Harmonic mean of the last fragments", "harmonic-mean"},
+    {0, NULL, NULL},
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType _type =
+        g_enum_register_static ("GstAdaptiveDemuxBandwidthEstimator", values);
+    g_once_init_leave (&type, _type);
+  }
+
+  return type;
+}
+
+static void
+gst_adaptive_demux_ewma_add_sample (GstAdaptiveDemuxEwma * ewma,
+    gdouble weight, gdouble value)
+{
+  gdouble alpha = pow (0.5, weight / ewma->half_life);
+
+  ewma->estimate = value * (1.0 - alpha) + alpha * ewma->estimate;
+  ewma->total_weight += weight;
+}
+
+static gdouble
+gst_adaptive_demux_ewma_get_estimate (GstAdaptiveDemuxEwma * ewma)
+{
+  /* the estimate starts at 0, correct the resulting bias */
+  return ewma->estimate / (1.0 - pow (0.5,
+          ewma->total_weight / ewma->half_life));
+}
+
+GstAdaptiveDemuxAbr *
+gst_adaptive_demux_abr_new (void)
+{
+  GstAdaptiveDemuxAbr *abr = g_new0 (GstAdaptiveDemuxAbr, 1);
+
+  g_mutex_init (&abr->lock);
+  abr->fast.half_life = EWMA_FAST_HALF_LIFE;
+  abr->slow.half_life = EWMA_SLOW_HALF_LIFE;
+
+  return abr;
+}
+
+void
+gst_adaptive_demux_abr_free (GstAdaptiveDemuxAbr * abr)
+{
+  g_mutex_clear (&abr->lock);
+  g_free (abr);
+}
+
+/* Called for every chunk of a fragment received from the network, with
+ * the time since the previous chunk (or since the request for the first
+ * one) */
+void
+gst_adaptive_demux_abr_add_chunk (GstAdaptiveDemuxAbr * abr, guint64 bytes,
+    GstClockTime duration)
+{
+  gdouble seconds;
+
+  g_mutex_lock (&abr->lock);
+  abr->pending_bytes += bytes;
+  abr->pending_duration += duration;
+
+  if (abr->pending_bytes >= MIN_CHUNK_BYTES &&
+      abr->pending_duration >= MIN_CHUNK_DURATION) {
+    seconds = (gdouble) abr->pending_duration / GST_SECOND;
+    gst_adaptive_demux_ewma_add_sample (&abr->fast, seconds,
+        abr->pending_bytes * 8 / seconds);
+    gst_adaptive_demux_ewma_add_sample (&abr->slow, seconds,
+        abr->pending_bytes * 8 / seconds);
+    abr->pending_bytes = 0;
+    abr->pending_duration = 0;
+  }
+  g_mutex_unlock (&abr->lock);
+}
+
+/* Called once a fragment is completely downloaded, with its bitrate
+ * from request to end of stream */
+void
+gst_adaptive_demux_abr_add_fragment (GstAdaptiveDemuxAbr * abr,
+    guint64 bitrate)
+{
+  guint index;
+
+  g_mutex_lock (&abr->lock);
+  abr->last_bitrate = bitrate;
+
+  index = abr->moving_index % NUM_LOOKBACK_FRAGMENTS;
+  abr->moving_bitrate -= abr->fragment_bitrates[index];
+  abr->fragment_bitrates[index] = bitrate;
+  abr->moving_bitrate += bitrate;
+
+  abr->harmonic_bitrates[abr->moving_index % NUM_HARMONIC_FRAGMENTS] =
+      bitrate;
+
+  abr->moving_index += 1;
+
+  /* leftovers of the fragment are not representative */
+  abr->pending_bytes = 0;
+  abr->pending_duration = 0;
+  g_mutex_unlock (&abr->lock);
+}
+
+/* must be called with the lock taken */
+static guint64
+gst_adaptive_demux_abr_get_bandwidth (GstAdaptiveDemuxAbr * abr,
+    GstAdaptiveDemuxBandwidthEstimator estimator)
+{
+  guint64 average;
+  gdouble sum;
+  guint i, n;
+
+  if (abr->moving_index == 0)
+    return 0;
+
+  switch (estimator) {
+    case GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_EWMA:
+      if (abr->fast.total_weight > 0 && abr->slow.total_weight > 0) {
+        return MIN (gst_adaptive_demux_ewma_get_estimate (&abr->fast),
+            gst_adaptive_demux_ewma_get_estimate (&abr->slow));
+      }
+      /* Fragments too small to be sampled so far */
+      return abr->last_bitrate;
+    case GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_HARMONIC_MEAN:
+      /* Fragments downloaded too fast to be timed have no bitrate, they
+       * would make the mean 0 */
+      n = 0;
+      sum = 0;
+      for (i = 0; i < MIN (abr->moving_index, NUM_HARMONIC_FRAGMENTS); i++) {
+        if (abr->harmonic_bitrates[i] == 0)
+          continue;
+        sum += 1.0 / abr->harmonic_bitrates[i];
+        n++;
+      }
+      return n > 0 ? n / sum : 0;
+    case GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE:
+    default:
+      if (abr->moving_index > NUM_LOOKBACK_FRAGMENTS)
+        average = abr->moving_bitrate / NUM_LOOKBACK_FRAGMENTS;
+      else
+        average = abr->moving_bitrate / abr->moving_index;
+      /* Conservative approach, make sure we don't upgrade too fast */
+      return MIN (average, abr->last_bitrate);
+  }
+}
+
+/* Fills in the bandwidth and target bitrate of @decision */
+void
+gst_adaptive_demux_abr_decide (GstAdaptiveDemuxAbr * abr,
+    GstAdaptiveDemuxAbrDecision * decision)
+{
+  GstClockTime reservoir, level;
+  gdouble margin;
+
+  g_mutex_lock (&abr->lock);
+  decision->bandwidth =
+      gst_adaptive_demux_abr_get_bandwidth (abr, decision->estimator);
+  g_mutex_unlock (&abr->lock);
+
+  decision->target_bitrate = decision->bandwidth * decision->bitrate_limit;
+
+  level = decision->buffer_level;
+  if (!GST_CLOCK_TIME_IS_VALID (level) || decision->buffer_target == 0)
+    return;
+
+  reservoir = decision->buffer_target / 3;
+
+  switch (decision->policy) {
+    case GST_ADAPTIVE_DEMUX_ABR_POLICY_BUFFER:
+      /* Nothing to scale from yet */
+      if (decision->current_bitrate == 0)
+        break;
+      if (level < reservoir)
+        decision->target_bitrate = 0;
+      else
+        decision->target_bitrate =
+            gst_util_uint64_scale (decision->current_bitrate, level,
+            decision->buffer_target);
+      break;
+    case GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID:
+      /* Halve the usual margin when about to underrun, and use all of the
+       * bandwidth when the buffer can absorb variations */
+      if (level <= reservoir)
+        margin = decision->bitrate_limit / 2;
+      else if (level >= decision->buffer_target)
+        margin = 1.0;
+      else
+        margin = decision->bitrate_limit / 2 +
+            (1.0 - decision->bitrate_limit / 2) * (level - reservoir) /
+            (decision->buffer_target - reservoir);
+      decision->target_bitrate = decision->bandwidth * margin;
+      break;
+    case GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT:
+    default:
+      break;
+  }
+}
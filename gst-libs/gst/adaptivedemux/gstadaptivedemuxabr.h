@@ -0,0 +1,111 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_ADAPTIVE_DEMUX_ABR_H_
+#define _GST_ADAPTIVE_DEMUX_ABR_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/*
+ * GstAdaptiveDemuxAbrPolicy:
+ * @GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT: select the bitrate from the
+ *   estimated bandwidth, scaled by the bitrate limit
+ * @GST_ADAPTIVE_DEMUX_ABR_POLICY_BUFFER: select the bitrate from the amount
+ *   of data buffered ahead of the playback position
+ * @GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID: select the bitrate from the
+ *   estimated bandwidth, with a safety margin depending on the buffer level
+ *
+ * Policy used to decide which bitrate to download the next fragment at.
+ * The buffer based policies fall back to the throughput policy as long as
+ * the buffer level is not known, e.g. before the pipeline is playing.
+ */
+typedef enum
+{
+  GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT,
+  GST_ADAPTIVE_DEMUX_ABR_POLICY_BUFFER,
+  GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID,
+} GstAdaptiveDemuxAbrPolicy;
+
+/*
+ * GstAdaptiveDemuxBandwidthEstimator:
+ * @GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE: the lowest of the
+ *   last fragment bitrate and the average of the last 3 fragments
+ * @GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_EWMA: the lowest of a fast and a
+ *   slow exponentially weighted moving average, updated while fragments
+ *   are being downloaded
+ * @GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_HARMONIC_MEAN: the harmonic mean
+ *   of the last 5 fragments, which is robust against short bursts
+ */
+typedef enum
+{
+  GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE,
+  GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_EWMA,
+  GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_HARMONIC_MEAN,
+} GstAdaptiveDemuxBandwidthEstimator;
+
+#define GST_TYPE_ADAPTIVE_DEMUX_ABR_POLICY \
+  (gst_adaptive_demux_abr_policy_get_type())
+#define GST_TYPE_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR \
+  (gst_adaptive_demux_bandwidth_estimator_get_type())
+
+G_GNUC_INTERNAL
+GType gst_adaptive_demux_abr_policy_get_type (void);
+
+G_GNUC_INTERNAL
+GType gst_adaptive_demux_bandwidth_estimator_get_type (void);
+
+typedef struct _GstAdaptiveDemuxAbr GstAdaptiveDemuxAbr;
+
+typedef struct
+{
+  /* inputs */
+  GstAdaptiveDemuxAbrPolicy policy;
+  GstAdaptiveDemuxBandwidthEstimator estimator;
+  gfloat bitrate_limit;
+  GstClockTime buffer_target;
+  GstClockTime buffer_level;    /* GST_CLOCK_TIME_NONE if unknown */
+  guint64 current_bitrate;      /* nominal, 0 if unknown */
+
+  /* outputs, all in bits per second */
+  guint64 bandwidth;
+  guint64 target_bitrate;
+} GstAdaptiveDemuxAbrDecision;
+
+G_GNUC_INTERNAL
+GstAdaptiveDemuxAbr *gst_adaptive_demux_abr_new (void);
+
+G_GNUC_INTERNAL
+void gst_adaptive_demux_abr_free (GstAdaptiveDemuxAbr * abr);
+
+G_GNUC_INTERNAL
+void gst_adaptive_demux_abr_add_chunk (GstAdaptiveDemuxAbr * abr,
+    guint64 bytes, GstClockTime duration);
+
+G_GNUC_INTERNAL
+void gst_adaptive_demux_abr_add_fragment (GstAdaptiveDemuxAbr * abr,
+    guint64 bitrate);
+
+G_GNUC_INTERNAL
+void gst_adaptive_demux_abr_decide (GstAdaptiveDemuxAbr * abr,
+    GstAdaptiveDemuxAbrDecision * decision);
+
+G_END_DECLS
+
+#endif
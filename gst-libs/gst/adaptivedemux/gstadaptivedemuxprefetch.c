@@ -0,0 +1,382 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Fragment prefetching for GstAdaptiveDemux.
+ *
+ * Each stream can have a prefetcher that downloads the next fragments into
+ * memory while the current one is being downloaded and pushed downstream,
+ * so that the round trip of the next request doesn't stall the stream. It
+ * has its own GstUriDownloader, and thus its own source element that is
+ * kept around between requests to reuse the HTTP connection. It is only
+ * created once prefetching is used, and its thread is only started with
+ * the first request.
+ *
+ * Requests are downloaded in the order they are made, one at a time on
+ * that single connection: prefetching overlaps the next downloads with the
+ * current one, it doesn't download several fragments at once. When
+ * the download loop takes a fragment, the fragments requested before it
+ * are discarded, and when it takes a fragment that was never requested
+ * (e.g. after a bitrate switch) everything is discarded.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/uridownloader/gsturidownloader.h>
+
+#include "gstadaptivedemuxprefetch.h"
+
+GST_DEBUG_CATEGORY_EXTERN (adaptivedemux_debug);
+#define GST_CAT_DEFAULT adaptivedemux_debug
+
+typedef struct
+{
+  gchar *uri;
+  gint64 range_start;
+  gint64 range_end;
+
+  /* set once downloaded */
+  GstBuffer *buffer;
+  GstClockTime request_gap;
+  GstClockTime download_time;
+} GstAdaptiveDemuxPrefetchEntry;
+
+struct _GstAdaptiveDemuxPrefetch
+{
+  GstUriDownloader *downloader;
+  GstTask *task;
+  GRecMutex task_lock;
+
+  GMutex lock;
+  GCond cond;
+
+  /* requested fragments in request order: the downloaded ones, then the
+   * one being downloaded and then the pending ones */
+  GQueue entries;
+  GstAdaptiveDemuxPrefetchEntry *downloading;
+  /* incremented when the entry being downloaded is discarded */
+  guint generation;
+
+  guint64 bytes;
+  guint64 max_bytes;
+
+  GstClockTime last_stop_time;
+  gboolean stopping;
+};
+
+static void
+gst_adaptive_demux_prefetch_entry_free (GstAdaptiveDemuxPrefetchEntry * entry)
+{
+  g_free (entry->uri);
+  if (entry->buffer)
+    gst_buffer_unref (entry->buffer);
+  g_slice_free (GstAdaptiveDemuxPrefetchEntry, entry);
+}
+
+/* must be called with the lock taken. Returns TRUE if the entry being
+ * downloaded was discarded and its download should be cancelled */
+static gboolean
+gst_adaptive_demux_prefetch_discard_entry (GstAdaptiveDemuxPrefetch * prefetch,
+    GList * link)
+{
+  GstAdaptiveDemuxPrefetchEntry *entry = link->data;
+  gboolean cancel = FALSE;
+
+  if (entry == prefetch->downloading) {
+    prefetch->downloading = NULL;
+    prefetch->generation++;
+    cancel = TRUE;
+  }
+  if (entry->buffer)
+    prefetch->bytes -= gst_buffer_get_size (entry->buffer);
+
+  g_queue_delete_link (&prefetch->entries, link);
+  gst_adaptive_demux_prefetch_entry_free (entry);
+
+  return cancel;
+}
+
+static gboolean
+gst_adaptive_demux_prefetch_entry_matches (GstAdaptiveDemuxPrefetchEntry *
+    entry, const gchar * uri, gint64 range_start, gint64 range_end)
+{
+  return entry->range_start == range_start && entry->range_end == range_end
+      && g_str_equal (entry->uri, uri);
+}
+
+/* must be called with the lock taken */
+static GstAdaptiveDemuxPrefetchEntry *
+gst_adaptive_demux_prefetch_next_pending (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  GList *iter;
+
+  if (prefetch->downloading || prefetch->bytes >= prefetch->max_bytes)
+    return NULL;
+
+  for (iter = prefetch->entries.head; iter; iter = iter->next) {
+    GstAdaptiveDemuxPrefetchEntry *entry = iter->data;
+
+    if (entry->buffer == NULL)
+      return entry;
+  }
+
+  return NULL;
+}
+
+static void
+gst_adaptive_demux_prefetch_loop (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  GstAdaptiveDemuxPrefetchEntry *entry;
+  GstFragment *fragment;
+  GError *err = NULL;
+  gchar *uri;
+  gint64 range_start, range_end;
+  guint generation;
+
+  g_mutex_lock (&prefetch->lock);
+  while (!prefetch->stopping &&
+      (entry = gst_adaptive_demux_prefetch_next_pending (prefetch)) == NULL)
+    g_cond_wait (&prefetch->cond, &prefetch->lock);
+
+  if (prefetch->stopping) {
+    g_mutex_unlock (&prefetch->lock);
+    return;
+  }
+
+  prefetch->downloading = entry;
+  generation = prefetch->generation;
+  uri = g_strdup (entry->uri);
+  range_start = entry->range_start;
+  range_end = entry->range_end;
+  g_mutex_unlock (&prefetch->lock);
+
+  GST_DEBUG ("Prefetching %s, range %" G_GINT64_FORMAT " - %" G_GINT64_FORMAT,
+      uri, range_start, range_end);
+
+  gst_uri_downloader_reset (prefetch->downloader);
+  fragment = gst_uri_downloader_fetch_uri_with_range (prefetch->downloader,
+      uri, NULL, FALSE, FALSE, TRUE, range_start, range_end, &err);
+
+  g_mutex_lock (&prefetch->lock);
+  /* The entry is gone if it was discarded in the meantime */
+  if (generation == prefetch->generation) {
+    GstBuffer *buffer = fragment ? gst_fragment_get_buffer (fragment) : NULL;
+
+    prefetch->downloading = NULL;
+    if (buffer) {
+      entry->buffer = buffer;
+      entry->download_time =
+          fragment->download_stop_time - fragment->download_start_time;
+      if (GST_CLOCK_TIME_IS_VALID (prefetch->last_stop_time) &&
+          fragment->download_start_time > prefetch->last_stop_time)
+        entry->request_gap =
+            fragment->download_start_time - prefetch->last_stop_time;
+      else
+        entry->request_gap = 0;
+      prefetch->bytes += gst_buffer_get_size (buffer);
+      GST_DEBUG ("Prefetched %s, %" G_GSIZE_FORMAT " bytes in %"
+          GST_TIME_FORMAT, uri, gst_buffer_get_size (buffer),
+          GST_TIME_ARGS (entry->download_time));
+    } else {
+      /* The download loop will try again and deal with the error */
+      GST_DEBUG ("Failed to prefetch %s: %s", uri,
+          err ? err->message : "no data");
+      g_queue_remove (&prefetch->entries, entry);
+      gst_adaptive_demux_prefetch_entry_free (entry);
+    }
+  }
+  if (fragment) {
+    prefetch->last_stop_time = fragment->download_stop_time;
+    g_object_unref (fragment);
+  }
+  g_cond_broadcast (&prefetch->cond);
+  g_mutex_unlock (&prefetch->lock);
+
+  g_clear_error (&err);
+  g_free (uri);
+}
+
+GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_prefetch_new (GstElement * parent, guint64 max_bytes)
+{
+  GstAdaptiveDemuxPrefetch *prefetch = g_new0 (GstAdaptiveDemuxPrefetch, 1);
+
+  prefetch->downloader = gst_uri_downloader_new ();
+  gst_uri_downloader_set_parent (prefetch->downloader, parent);
+
+  g_rec_mutex_init (&prefetch->task_lock);
+  prefetch->task =
+      gst_task_new ((GstTaskFunction) gst_adaptive_demux_prefetch_loop,
+      prefetch, NULL);
+  gst_task_set_lock (prefetch->task, &prefetch->task_lock);
+
+  g_mutex_init (&prefetch->lock);
+  g_cond_init (&prefetch->cond);
+  g_queue_init (&prefetch->entries);
+  prefetch->max_bytes = max_bytes;
+  prefetch->last_stop_time = GST_CLOCK_TIME_NONE;
+
+  return prefetch;
+}
+
+void
+gst_adaptive_demux_prefetch_free (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  g_mutex_lock (&prefetch->lock);
+  prefetch->stopping = TRUE;
+  gst_task_stop (prefetch->task);
+  g_cond_broadcast (&prefetch->cond);
+  g_mutex_unlock (&prefetch->lock);
+
+  gst_uri_downloader_cancel (prefetch->downloader);
+  gst_task_join (prefetch->task);
+
+  g_queue_foreach (&prefetch->entries,
+      (GFunc) gst_adaptive_demux_prefetch_entry_free, NULL);
+  g_queue_clear (&prefetch->entries);
+
+  gst_object_unref (prefetch->task);
+  g_rec_mutex_clear (&prefetch->task_lock);
+  gst_object_unref (prefetch->downloader);
+  g_cond_clear (&prefetch->cond);
+  g_mutex_clear (&prefetch->lock);
+  g_free (prefetch);
+}
+
+/* Queues a download of the given fragment, unless it is already queued or
+ * @max_fragments are already queued. Returns TRUE if queued */
+gboolean
+gst_adaptive_demux_prefetch_request (GstAdaptiveDemuxPrefetch * prefetch,
+    const gchar * uri, gint64 range_start, gint64 range_end,
+    guint max_fragments)
+{
+  GstAdaptiveDemuxPrefetchEntry *entry;
+  GList *iter;
+
+  g_mutex_lock (&prefetch->lock);
+  if (prefetch->stopping ||
+      g_queue_get_length (&prefetch->entries) >= max_fragments)
+    goto skip;
+
+  for (iter = prefetch->entries.head; iter; iter = iter->next) {
+    if (gst_adaptive_demux_prefetch_entry_matches (iter->data, uri,
+            range_start, range_end))
+      goto skip;
+  }
+
+  entry = g_slice_new0 (GstAdaptiveDemuxPrefetchEntry);
+  entry->uri = g_strdup (uri);
+  entry->range_start = range_start;
+  entry->range_end = range_end;
+  g_queue_push_tail (&prefetch->entries, entry);
+
+  if (gst_task_get_state (prefetch->task) != GST_TASK_STARTED)
+    gst_task_start (prefetch->task);
+  g_cond_broadcast (&prefetch->cond);
+  g_mutex_unlock (&prefetch->lock);
+
+  return TRUE;
+
+skip:
+  g_mutex_unlock (&prefetch->lock);
+  return FALSE;
+}
+
+/* Returns the prefetched data of the given fragment, waiting for its
+ * download to finish if needed, or NULL if it has to be downloaded by the
+ * caller */
+GstBuffer *
+gst_adaptive_demux_prefetch_take (GstAdaptiveDemuxPrefetch * prefetch,
+    const gchar * uri, gint64 range_start, gint64 range_end,
+    GstClockTime * request_gap, GstClockTime * download_time)
+{
+  GstAdaptiveDemuxPrefetchEntry *entry;
+  GstBuffer *buffer = NULL;
+  gboolean cancel = FALSE;
+  GList *iter;
+
+  g_mutex_lock (&prefetch->lock);
+again:
+  for (iter = prefetch->entries.head; iter; iter = iter->next) {
+    if (gst_adaptive_demux_prefetch_entry_matches (iter->data, uri,
+            range_start, range_end))
+      break;
+  }
+
+  if (iter == NULL) {
+    /* Not something we expected, everything else is stale too */
+    if (!g_queue_is_empty (&prefetch->entries))
+      GST_DEBUG ("%s was not prefetched, discarding prefetched fragments",
+          uri);
+    while (!g_queue_is_empty (&prefetch->entries))
+      cancel |= gst_adaptive_demux_prefetch_discard_entry (prefetch,
+          prefetch->entries.head);
+    goto done;
+  }
+
+  entry = iter->data;
+  if (entry == prefetch->downloading) {
+    GST_DEBUG ("Waiting for prefetch of %s to finish", uri);
+    g_cond_wait (&prefetch->cond, &prefetch->lock);
+    if (prefetch->stopping)
+      goto done;
+    goto again;
+  }
+
+  /* fragments requested before this one were skipped */
+  while (prefetch->entries.head != iter)
+    cancel |= gst_adaptive_demux_prefetch_discard_entry (prefetch,
+        prefetch->entries.head);
+
+  if (entry->buffer) {
+    buffer = gst_buffer_ref (entry->buffer);
+    *request_gap = entry->request_gap;
+    *download_time = entry->download_time;
+  }
+  gst_adaptive_demux_prefetch_discard_entry (prefetch, iter);
+  g_cond_broadcast (&prefetch->cond);
+
+done:
+  g_mutex_unlock (&prefetch->lock);
+
+  if (cancel)
+    gst_uri_downloader_cancel (prefetch->downloader);
+
+  return buffer;
+}
+
+/* Discards all prefetched and pending fragments, and cancels the current
+ * download, if any */
+void
+gst_adaptive_demux_prefetch_flush (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  gboolean cancel = FALSE;
+
+  g_mutex_lock (&prefetch->lock);
+  while (!g_queue_is_empty (&prefetch->entries))
+    cancel |= gst_adaptive_demux_prefetch_discard_entry (prefetch,
+        prefetch->entries.head);
+  prefetch->last_stop_time = GST_CLOCK_TIME_NONE;
+  g_cond_broadcast (&prefetch->cond);
+  g_mutex_unlock (&prefetch->lock);
+
+  if (cancel)
+    gst_uri_downloader_cancel (prefetch->downloader);
+}
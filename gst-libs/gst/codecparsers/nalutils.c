@@ -36,6 +36,7 @@
 #endif
 
 #include "nalutils.h"
+#include "parserutils.h"
 #include <string.h>
 
 /* Compute Ceil(Log2(v)) */
@@ -64,6 +65,76 @@ ceil_log2 (guint32 v)
 
 /****** Nal parser ******/
 
+/* Maximum number of bytes looked at when scanning for the next emulation
+ * prevention byte */
+#define NAL_READER_EPB_SCAN_SIZE 64
+
+static inline guint
+nal_reader_clz64 (guint64 v)
+{
+#if defined(__GNUC__)
+  return __builtin_clzll (v);
+#else
+  guint n = 0;
+
+  while (!(v & G_GUINT64_CONSTANT (0x8000000000000000))) {
+    v <<= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+static inline gboolean
+nal_reader_is_epb (const NalReader * nr, guint pos)
+{
+  return pos >= 2 && pos < nr->size && nr->data[pos] == 0x03 &&
+      nr->data[pos - 1] == 0x00 && nr->data[pos - 2] == 0x00;
+}
+
+/* Sets epb_pos to the position of the next emulation_prevention_three_byte,
+ * or to the end of the scanned area if there is none in it. 0x03 bytes are
+ * rare enough in NAL payloads for memchr() to skip most of the data */
+static void
+nal_reader_scan_epb (NalReader * nr)
+{
+  const guint8 *data = nr->data;
+  const guint8 *p;
+  guint pos, end;
+
+  pos = MAX (nr->byte, 2);
+  end = MIN (nr->size, nr->byte + NAL_READER_EPB_SCAN_SIZE);
+
+  while (pos < end) {
+    p = memchr (data + pos, 0x03, end - pos);
+    if (p == NULL)
+      break;
+
+    pos = p - data;
+    if (data[pos - 1] == 0x00 && data[pos - 2] == 0x00) {
+      nr->epb_pos = pos;
+      return;
+    }
+    pos++;
+  }
+
+  nr->epb_pos = end;
+}
+
+/* Loads as many bytes as fit in the cache, without going past the next
+ * possible emulation prevention byte */
+static inline void
+nal_reader_load (NalReader * nr)
+{
+  guint n;
+
+  n = MIN ((64 - nr->bits_in_cache) / 8, nr->epb_pos - nr->byte);
+  nr->bits_in_cache += n * 8;
+
+  while (n--)
+    nr->cache = (nr->cache << 8) | nr->data[nr->byte++];
+}
+
 void
 nal_reader_init (NalReader * nr, const guint8 * data, guint size)
 {
@@ -73,15 +144,21 @@ nal_reader_init (NalReader * nr, const guint8 * data, guint size)
 
   nr->byte = 0;
   nr->bits_in_cache = 0;
-  /* fill with something other than 0 to detect emulation prevention bytes */
-  nr->first_byte = 0xff;
-  nr->epb_cache = 0xff;
-  nr->cache = 0xff;
+  nr->cache = 0;
+
+  nal_reader_scan_epb (nr);
 }
 
+/* Makes sure at least @nbits bits are in the cache. Emulation prevention
+ * bytes are only skipped once the bits following them are needed, so that
+ * the position and the count of emulation prevention bytes only account for
+ * what was actually read */
 gboolean
 nal_reader_read (NalReader * nr, guint nbits)
 {
+  if (G_LIKELY (nr->bits_in_cache >= nbits))
+    return TRUE;
+
   if (G_UNLIKELY (nr->byte * 8 + (nbits - nr->bits_in_cache) > nr->size * 8)) {
     GST_DEBUG ("Can not read %u bits, bits in cache %u, Byte * 8 %u, size in "
         "bits %u", nbits, nr->bits_in_cache, nr->byte * 8, nr->size * 8);
@@ -89,23 +166,20 @@ nal_reader_read (NalReader * nr, guint nbits)
   }
 
   while (nr->bits_in_cache < nbits) {
-    guint8 byte;
-
-  next_byte:
-    if (G_UNLIKELY (nr->byte >= nr->size))
-      return FALSE;
-
-    byte = nr->data[nr->byte++];
-    nr->epb_cache = (nr->epb_cache << 8) | byte;
-
-    /* check if the byte is a emulation_prevention_three_byte */
-    if ((nr->epb_cache & 0xffffff) == 0x3) {
-      nr->n_epb++;
-      goto next_byte;
+    if (nr->byte == nr->epb_pos) {
+      if (G_UNLIKELY (nr->byte >= nr->size))
+        return FALSE;
+
+      /* check if the byte is a emulation_prevention_three_byte */
+      if (nal_reader_is_epb (nr, nr->byte)) {
+        nr->n_epb++;
+        nr->byte++;
+      }
+      nal_reader_scan_epb (nr);
+      continue;
     }
-    nr->cache = (nr->cache << 8) | nr->first_byte;
-    nr->first_byte = byte;
-    nr->bits_in_cache += 8;
+
+    nal_reader_load (nr);
   }
 
   return TRUE;
@@ -116,7 +190,7 @@ nal_reader_read (NalReader * nr, guint nbits)
 gboolean
 nal_reader_skip (NalReader * nr, guint nbits)
 {
-  g_assert (nbits <= 8 * sizeof (nr->cache));
+  g_assert (nbits <= 8 * sizeof (nr->cache) - 7);
 
   if (G_UNLIKELY (!nal_reader_read (nr, nbits)))
     return FALSE;
@@ -168,17 +242,17 @@ nal_reader_get_bits_uint##bits (NalReader *nr, guint##bits *val, guint nbits) \
 { \
   guint shift; \
   \
+  if (G_UNLIKELY (nbits == 0)) { \
+    *val = 0; \
+    return TRUE; \
+  } \
+  \
   if (!nal_reader_read (nr, nbits)) \
     return FALSE; \
   \
   /* bring the required bits down and truncate */ \
   shift = nr->bits_in_cache - nbits; \
-  *val = nr->first_byte >> shift; \
-  \
-  *val |= nr->cache << (8 - shift); \
-  /* mask out required bits */ \
-  if (nbits < bits) \
-    *val &= ((guint##bits)1 << nbits) - 1; \
+  *val = (nr->cache >> shift) & ((G_GUINT64_CONSTANT (1) << nbits) - 1); \
   \
   nr->bits_in_cache = shift; \
   \
@@ -208,6 +282,27 @@ nal_reader_get_ue (NalReader * nr, guint32 * val)
   guint8 bit;
   guint32 value;
 
+  /* Fast path: the whole codeword is already in the cache, or can be
+   * loaded without crossing an emulation prevention byte */
+  nal_reader_load (nr);
+  if (G_LIKELY (nr->bits_in_cache > 0)) {
+    guint64 bits = nr->cache << (64 - nr->bits_in_cache);
+
+    if (G_LIKELY (bits != 0)) {
+      guint len;
+
+      i = nal_reader_clz64 (bits);
+      len = 2 * i + 1;
+      if (G_LIKELY (len <= nr->bits_in_cache)) {
+        nr->bits_in_cache -= len;
+        *val = ((nr->cache >> nr->bits_in_cache) &
+            ((G_GUINT64_CONSTANT (1) << len) - 1)) - 1;
+        return TRUE;
+      }
+      i = 0;
+    }
+  }
+
   if (G_UNLIKELY (!nal_reader_get_bits_uint8 (nr, &bit, 1)))
     return FALSE;
 
@@ -247,7 +342,7 @@ nal_reader_get_se (NalReader * nr, gint32 * val)
 gboolean
 nal_reader_is_byte_aligned (NalReader * nr)
 {
-  if (nr->bits_in_cache != 0)
+  if ((nr->bits_in_cache & 0x7) != 0)
     return FALSE;
   return TRUE;
 }
@@ -298,12 +393,8 @@ nal_reader_has_more_data (NalReader * nr)
 gint
 scan_for_start_codes (const guint8 * data, guint size)
 {
-  GstByteReader br;
-  gst_byte_reader_init (&br, data, size);
-
   /* NALU not empty, so we can at least expect 1 (even 2) bytes following sc */
-  return gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
-      0, size);
+  return find_start_code (data, size);
 }
 
 void
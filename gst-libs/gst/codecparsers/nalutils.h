@@ -49,10 +49,10 @@ typedef struct
 
   guint n_epb;                  /* Number of emulation prevention bytes */
   guint byte;                   /* Byte position */
-  guint bits_in_cache;          /* bitpos in the cache of next bit */
-  guint8 first_byte;
-  guint32 epb_cache;            /* cache 3 bytes to check emulation prevention bytes */
-  guint64 cache;                /* cached bytes */
+  guint bits_in_cache;          /* number of valid bits in the cache */
+  guint epb_pos;                /* Position of the next possible emulation
+                                 * prevention byte, no byte before it is one */
+  guint64 cache;                /* cached bits, right-aligned */
 } NalReader;
 
 typedef struct
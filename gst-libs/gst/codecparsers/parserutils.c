@@ -24,6 +24,8 @@
 
 #include "parserutils.h"
 
+#include <string.h>
+
 gboolean
 decode_vlc (GstBitReader * br, guint * res, const VLCTable * table,
     guint length)
@@ -58,3 +60,60 @@ failed:
     return FALSE;
   }
 }
+
+/* Returns the offset of the first 0x000001 start code prefix in @data that
+ * is followed by at least one byte, or -1 if there is none.
+ *
+ * Rather than looking at each byte in turn, this looks for the 0x01 byte
+ * with memchr(), which is vectorised by the C library, and only then
+ * checks for the two preceding zero bytes. 0x01 bytes are rare in coded
+ * video data, so most of the buffer is skipped without further checks */
+gint
+find_start_code (const guint8 * data, guint size)
+{
+  const guint8 *p, *end;
+
+  /* we can't find the pattern with less than 4 bytes */
+  if (G_UNLIKELY (size < 4))
+    return -1;
+
+  p = data + 2;
+  end = data + size - 1;
+
+  while (p < end) {
+    p = memchr (p, 0x01, end - p);
+    if (p == NULL)
+      break;
+
+    if (p[-1] == 0x00 && p[-2] == 0x00)
+      return p - 2 - data;
+
+    /* this 0x01 byte can't be one of the zero bytes of the next start
+     * code prefix, which thus ends at p + 3 at the earliest */
+    p += 3;
+  }
+
+  return -1;
+}
+
+/* Fills @offsets with the offsets of up to @max_offsets start code
+ * prefixes found in @data, following the rules of find_start_code().
+ * Returns the number of start codes found */
+guint
+find_start_codes (const guint8 * data, guint size, guint * offsets,
+    guint max_offsets)
+{
+  guint n = 0, pos = 0;
+  gint off;
+
+  while (n < max_offsets && pos < size) {
+    off = find_start_code (data + pos, size - pos);
+    if (off < 0)
+      break;
+
+    offsets[n++] = pos + off;
+    pos += off + 3;
+  }
+
+  return n;
+}
@@ -105,4 +105,11 @@ G_GNUC_INTERNAL gboolean
 decode_vlc (GstBitReader * br, guint * res, const VLCTable * table,
     guint length);
 
+G_GNUC_INTERNAL gint
+find_start_code (const guint8 * data, guint size);
+
+G_GNUC_INTERNAL guint
+find_start_codes (const guint8 * data, guint size, guint * offsets,
+    guint max_offsets);
+
 #endif /* __PARSER_UTILS__ */
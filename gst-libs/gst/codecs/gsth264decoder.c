@@ -94,6 +94,8 @@ struct _GstH264DecoderPrivate
   GstFlowReturn last_ret;
   /* used for low-latency vs. high throughput mode decision */
   gboolean is_live;
+  /* see gst_h264_decoder_set_low_latency() */
+  gboolean low_latency;
 
   /* sps/pps of the current slice */
   const GstH264SPS *active_sps;
@@ -1862,7 +1864,7 @@ gst_h264_decoder_finish_picture (GstH264Decoder * self,
       gst_h264_dpb_get_size (priv->dpb));
 
   while (gst_h264_dpb_needs_bump (priv->dpb, priv->max_num_reorder_frames,
-          priv->is_live)) {
+          priv->is_live || priv->low_latency)) {
     GstH264Picture *to_output;
 
     to_output = gst_h264_dpb_bump (priv->dpb, FALSE);
@@ -2004,6 +2006,7 @@ gst_h264_decoder_set_latency (GstH264Decoder * self, const GstH264SPS * sps,
   GstStructure *structure;
   gint fps_d = 1, fps_n = 0;
   guint32 num_reorder_frames;
+  gboolean low_latency = priv->is_live || priv->low_latency;
 
   caps = gst_pad_get_current_caps (GST_VIDEO_DECODER_SRC_PAD (self));
   if (!caps)
@@ -2024,12 +2027,12 @@ gst_h264_decoder_set_latency (GstH264Decoder * self, const GstH264SPS * sps,
     fps_d = 1;
   }
 
-  num_reorder_frames = priv->is_live ? 0 : 1;
+  num_reorder_frames = low_latency ? 0 : 1;
   if (sps->vui_parameters_present_flag
       && sps->vui_parameters.bitstream_restriction_flag)
     num_reorder_frames = sps->vui_parameters.num_reorder_frames;
   if (num_reorder_frames > max_dpb_size)
-    num_reorder_frames = priv->is_live ? 0 : 1;
+    num_reorder_frames = low_latency ? 0 : 1;
 
   /* Consider output delay wanted by subclass */
   num_reorder_frames += priv->preferred_output_delay;
@@ -2946,6 +2949,26 @@ gst_h264_decoder_set_process_ref_pic_lists (GstH264Decoder * decoder,
   decoder->priv->process_ref_pic_lists = process;
 }
 
+/**
+ * gst_h264_decoder_set_low_latency:
+ * @decoder: a #GstH264Decoder
+ * @low_latency: whether pictures should be output as early as possible
+ *
+ * Called to en/disable low-latency output. When enabled, a picture is output
+ * as soon as its picture order count directly follows the one of the
+ * previously output picture, instead of when the reordering constraints of
+ * the stream or the fullness of the DPB require it. This is always the case
+ * for live sources.
+ *
+ * Since: 1.20
+ */
+void
+gst_h264_decoder_set_low_latency (GstH264Decoder * decoder,
+    gboolean low_latency)
+{
+  decoder->priv->low_latency = low_latency;
+}
+
 /**
  * gst_h264_decoder_get_picture:
  * @decoder: a #GstH264Decoder
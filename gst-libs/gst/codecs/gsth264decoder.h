@@ -203,6 +203,10 @@ GST_CODECS_API
 void gst_h264_decoder_set_process_ref_pic_lists (GstH264Decoder * decoder,
                                                  gboolean process);
 
+GST_CODECS_API
+void gst_h264_decoder_set_low_latency           (GstH264Decoder * decoder,
+                                                 gboolean low_latency);
+
 GST_CODECS_API
 GstH264Picture * gst_h264_decoder_get_picture   (GstH264Decoder * decoder,
                                                  guint32 system_frame_number);
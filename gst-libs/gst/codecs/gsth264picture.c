@@ -103,6 +103,18 @@ gst_h264_picture_get_user_data (GstH264Picture * picture)
   return picture->user_data;
 }
 
+/* Bumped by gst_h264_picture_set_reference(), so that the DPBs know their
+ * cached reference picture lists may be stale */
+static gint ref_marking_generation = 0;
+
+typedef struct
+{
+  GstH264Picture *picture;
+  /* Insertion order, so that pictures with identical POC are output in the
+   * order they were stored */
+  guint32 order;
+} GstH264DpbOutputEntry;
+
 struct _GstH264Dpb
 {
   GArray *pic_list;
@@ -111,6 +123,21 @@ struct _GstH264Dpb
   gint32 last_output_poc;
 
   gboolean interlaced;
+
+  /* Min-heap on POC of GstH264DpbOutputEntry, holding the pictures which
+   * can be bumped: frames and first fields of complementary field pairs.
+   * Entries whose picture isn't needed for output anymore are dropped
+   * when they reach the top */
+  GArray *output_heap;
+  guint32 output_order;
+
+  /* Short-term and long-term reference pictures in pic_list order, not
+   * owned. Extended by gst_h264_dpb_add(), and rebuilt on the next lookup
+   * once a picture left pic_list or any reference marking changed */
+  GArray *short_ref_list;
+  GArray *long_ref_list;
+  gboolean ref_lists_valid;
+  gint ref_lists_generation;
 };
 
 static void
@@ -118,6 +145,109 @@ gst_h264_dpb_init (GstH264Dpb * dpb)
 {
   dpb->num_output_needed = 0;
   dpb->last_output_poc = G_MININT32;
+  dpb->output_order = 0;
+  dpb->ref_lists_valid = FALSE;
+}
+
+static void
+gst_h264_dpb_output_entry_clear (GstH264DpbOutputEntry * entry)
+{
+  gst_h264_picture_clear (&entry->picture);
+}
+
+static inline gboolean
+gst_h264_dpb_output_entry_less (const GstH264DpbOutputEntry * a,
+    const GstH264DpbOutputEntry * b)
+{
+  if (a->picture->pic_order_cnt != b->picture->pic_order_cnt)
+    return a->picture->pic_order_cnt < b->picture->pic_order_cnt;
+
+  return (gint32) (a->order - b->order) < 0;
+}
+
+static void
+gst_h264_dpb_output_heap_push (GstH264Dpb * dpb, GstH264Picture * picture)
+{
+  GstH264DpbOutputEntry *heap;
+  GstH264DpbOutputEntry entry;
+  guint i;
+
+  entry.picture = gst_h264_picture_ref (picture);
+  entry.order = dpb->output_order++;
+
+  g_array_append_val (dpb->output_heap, entry);
+  heap = (GstH264DpbOutputEntry *) dpb->output_heap->data;
+
+  for (i = dpb->output_heap->len - 1; i > 0; i = (i - 1) / 2) {
+    guint parent = (i - 1) / 2;
+
+    if (!gst_h264_dpb_output_entry_less (&entry, &heap[parent]))
+      break;
+
+    heap[i] = heap[parent];
+  }
+
+  heap[i] = entry;
+}
+
+static void
+gst_h264_dpb_output_heap_pop (GstH264Dpb * dpb)
+{
+  GstH264DpbOutputEntry *heap;
+  GstH264DpbOutputEntry entry;
+  guint len, i;
+
+  /* Releases the top entry and moves the last one to the top */
+  g_array_remove_index_fast (dpb->output_heap, 0);
+
+  len = dpb->output_heap->len;
+  if (len < 2)
+    return;
+
+  heap = (GstH264DpbOutputEntry *) dpb->output_heap->data;
+  entry = heap[0];
+
+  for (i = 0; 2 * i + 1 < len;) {
+    guint child = 2 * i + 1;
+
+    if (child + 1 < len &&
+        gst_h264_dpb_output_entry_less (&heap[child + 1], &heap[child]))
+      child++;
+
+    if (!gst_h264_dpb_output_entry_less (&heap[child], &entry))
+      break;
+
+    heap[i] = heap[child];
+    i = child;
+  }
+
+  heap[i] = entry;
+}
+
+static void
+gst_h264_dpb_update_ref_lists (GstH264Dpb * dpb)
+{
+  gint generation = g_atomic_int_get (&ref_marking_generation);
+  gint i;
+
+  if (dpb->ref_lists_valid && dpb->ref_lists_generation == generation)
+    return;
+
+  g_array_set_size (dpb->short_ref_list, 0);
+  g_array_set_size (dpb->long_ref_list, 0);
+
+  for (i = 0; i < dpb->pic_list->len; i++) {
+    GstH264Picture *picture =
+        g_array_index (dpb->pic_list, GstH264Picture *, i);
+
+    if (GST_H264_PICTURE_IS_SHORT_TERM_REF (picture))
+      g_array_append_val (dpb->short_ref_list, picture);
+    else if (GST_H264_PICTURE_IS_LONG_TERM_REF (picture))
+      g_array_append_val (dpb->long_ref_list, picture);
+  }
+
+  dpb->ref_lists_valid = TRUE;
+  dpb->ref_lists_generation = generation;
 }
 
 /**
@@ -141,6 +271,16 @@ gst_h264_dpb_new (void)
   g_array_set_clear_func (dpb->pic_list,
       (GDestroyNotify) gst_h264_picture_clear);
 
+  dpb->output_heap = g_array_sized_new (FALSE, TRUE,
+      sizeof (GstH264DpbOutputEntry), GST_H264_DPB_MAX_SIZE + 1);
+  g_array_set_clear_func (dpb->output_heap,
+      (GDestroyNotify) gst_h264_dpb_output_entry_clear);
+
+  dpb->short_ref_list = g_array_sized_new (FALSE, TRUE,
+      sizeof (GstH264Picture *), GST_H264_DPB_MAX_SIZE + 1);
+  dpb->long_ref_list = g_array_sized_new (FALSE, TRUE,
+      sizeof (GstH264Picture *), GST_H264_DPB_MAX_SIZE + 1);
+
   return dpb;
 }
 
@@ -221,6 +361,9 @@ gst_h264_dpb_free (GstH264Dpb * dpb)
 
   gst_h264_dpb_clear (dpb);
   g_array_unref (dpb->pic_list);
+  g_array_unref (dpb->output_heap);
+  g_array_unref (dpb->short_ref_list);
+  g_array_unref (dpb->long_ref_list);
   g_free (dpb);
 }
 
@@ -236,6 +379,9 @@ gst_h264_dpb_clear (GstH264Dpb * dpb)
   g_return_if_fail (dpb != NULL);
 
   g_array_set_size (dpb->pic_list, 0);
+  g_array_set_size (dpb->output_heap, 0);
+  g_array_set_size (dpb->short_ref_list, 0);
+  g_array_set_size (dpb->long_ref_list, 0);
   gst_h264_dpb_init (dpb);
 }
 
@@ -276,6 +422,22 @@ gst_h264_dpb_add (GstH264Dpb * dpb, GstH264Picture * picture)
     picture->other_field->other_field = picture;
   }
 
+  /* Field pairs are bumped through their first field once complete */
+  if (GST_H264_PICTURE_IS_FRAME (picture)) {
+    if (picture->needed_for_output)
+      gst_h264_dpb_output_heap_push (dpb, picture);
+  } else if (picture->second_field && picture->other_field &&
+      picture->other_field->needed_for_output) {
+    gst_h264_dpb_output_heap_push (dpb, picture->other_field);
+  }
+
+  if (dpb->ref_lists_valid) {
+    if (GST_H264_PICTURE_IS_SHORT_TERM_REF (picture))
+      g_array_append_val (dpb->short_ref_list, picture);
+    else if (GST_H264_PICTURE_IS_LONG_TERM_REF (picture))
+      g_array_append_val (dpb->long_ref_list, picture);
+  }
+
   g_array_append_val (dpb->pic_list, picture);
 }
 
@@ -303,6 +465,7 @@ gst_h264_dpb_delete_unused (GstH264Dpb * dpb)
           ("remove picture %p (frame num: %d, poc: %d, field: %d) from dpb",
           picture, picture->frame_num, picture->pic_order_cnt, picture->field);
       g_array_remove_index (dpb->pic_list, i);
+      dpb->ref_lists_valid = FALSE;
       i--;
     }
   }
@@ -324,15 +487,22 @@ gst_h264_dpb_num_ref_frames (GstH264Dpb * dpb)
 
   g_return_val_if_fail (dpb != NULL, -1);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
+  gst_h264_dpb_update_ref_lists (dpb);
+
+  /* Count frame, not field picture */
+  for (i = 0; i < dpb->short_ref_list->len; i++) {
     GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+        g_array_index (dpb->short_ref_list, GstH264Picture *, i);
 
-    /* Count frame, not field picture */
-    if (picture->second_field)
-      continue;
+    if (!picture->second_field && GST_H264_PICTURE_IS_SHORT_TERM_REF (picture))
+      ret++;
+  }
+
+  for (i = 0; i < dpb->long_ref_list->len; i++) {
+    GstH264Picture *picture =
+        g_array_index (dpb->long_ref_list, GstH264Picture *, i);
 
-    if (GST_H264_PICTURE_IS_REF (picture))
+    if (!picture->second_field && GST_H264_PICTURE_IS_LONG_TERM_REF (picture))
       ret++;
   }
 
@@ -376,9 +546,11 @@ gst_h264_dpb_get_short_ref_by_pic_num (GstH264Dpb * dpb, gint pic_num)
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
+  gst_h264_dpb_update_ref_lists (dpb);
+
+  for (i = 0; i < dpb->short_ref_list->len; i++) {
     GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+        g_array_index (dpb->short_ref_list, GstH264Picture *, i);
 
     if (GST_H264_PICTURE_IS_SHORT_TERM_REF (picture)
         && picture->pic_num == pic_num)
@@ -409,9 +581,11 @@ gst_h264_dpb_get_long_ref_by_long_term_pic_num (GstH264Dpb * dpb,
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
+  gst_h264_dpb_update_ref_lists (dpb);
+
+  for (i = 0; i < dpb->long_ref_list->len; i++) {
     GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+        g_array_index (dpb->long_ref_list, GstH264Picture *, i);
 
     if (GST_H264_PICTURE_IS_LONG_TERM_REF (picture) &&
         picture->long_term_pic_num == long_term_pic_num)
@@ -439,9 +613,11 @@ gst_h264_dpb_get_lowest_frame_num_short_ref (GstH264Dpb * dpb)
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
+  gst_h264_dpb_update_ref_lists (dpb);
+
+  for (i = 0; i < dpb->short_ref_list->len; i++) {
     GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+        g_array_index (dpb->short_ref_list, GstH264Picture *, i);
 
     if (GST_H264_PICTURE_IS_SHORT_TERM_REF (picture) &&
         (!ret || picture->frame_num_wrap < ret->frame_num_wrap))
@@ -476,9 +652,11 @@ gst_h264_dpb_get_pictures_short_term_ref (GstH264Dpb * dpb,
   g_return_if_fail (dpb != NULL);
   g_return_if_fail (out != NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
+  gst_h264_dpb_update_ref_lists (dpb);
+
+  for (i = 0; i < dpb->short_ref_list->len; i++) {
     GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+        g_array_index (dpb->short_ref_list, GstH264Picture *, i);
 
     if (!include_second_field && picture->second_field)
       continue;
@@ -513,9 +691,11 @@ gst_h264_dpb_get_pictures_long_term_ref (GstH264Dpb * dpb,
   g_return_if_fail (dpb != NULL);
   g_return_if_fail (out != NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
+  gst_h264_dpb_update_ref_lists (dpb);
+
+  for (i = 0; i < dpb->long_ref_list->len; i++) {
     GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
+        g_array_index (dpb->long_ref_list, GstH264Picture *, i);
 
     if (!include_second_field && picture->second_field)
       continue;
@@ -620,38 +800,27 @@ gst_h264_dpb_get_lowest_output_needed_picture (GstH264Dpb * dpb,
     GstH264Picture ** picture)
 {
   gint i;
-  GstH264Picture *lowest = NULL;
-  gint index = -1;
 
   *picture = NULL;
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
-
-    if (!picture->needed_for_output)
-      continue;
-
-    if (!GST_H264_PICTURE_IS_FRAME (picture) &&
-        (!picture->other_field || picture->second_field))
-      continue;
+  while (dpb->output_heap->len > 0) {
+    GstH264Picture *lowest =
+        g_array_index (dpb->output_heap, GstH264DpbOutputEntry, 0).picture;
 
-    if (!lowest) {
-      lowest = picture;
-      index = i;
-      continue;
+    if (lowest->needed_for_output) {
+      for (i = 0; i < dpb->pic_list->len; i++) {
+        if (g_array_index (dpb->pic_list, GstH264Picture *, i) == lowest) {
+          *picture = gst_h264_picture_ref (lowest);
+          return i;
+        }
+      }
     }
 
-    if (picture->pic_order_cnt < lowest->pic_order_cnt) {
-      lowest = picture;
-      index = i;
-    }
+    /* Already outputted or not stored anymore */
+    gst_h264_dpb_output_heap_pop (dpb);
   }
 
-  if (lowest)
-    *picture = gst_h264_picture_ref (lowest);
-
-  return index;
+  return -1;
 }
 
 /**
@@ -769,14 +938,17 @@ gst_h264_dpb_bump (GstH264Dpb * dpb, gboolean drain)
     return NULL;
 
   picture->needed_for_output = FALSE;
+  gst_h264_dpb_output_heap_pop (dpb);
 
   dpb->num_output_needed--;
   g_assert (dpb->num_output_needed >= 0);
 
   /* NOTE: don't use g_array_remove_index_fast here since the last picture
    * need to be referenced for bumping decision */
-  if (!GST_H264_PICTURE_IS_REF (picture) || drain)
+  if (!GST_H264_PICTURE_IS_REF (picture) || drain) {
     g_array_remove_index (dpb->pic_list, index);
+    dpb->ref_lists_valid = FALSE;
+  }
 
   other_picture = picture->other_field;
   if (other_picture) {
@@ -797,6 +969,7 @@ gst_h264_dpb_bump (GstH264Dpb * dpb, gboolean drain)
 
         if (tmp == other_picture) {
           g_array_remove_index (dpb->pic_list, i);
+          dpb->ref_lists_valid = FALSE;
           break;
         }
       }
@@ -1050,4 +1223,6 @@ gst_h264_picture_set_reference (GstH264Picture * picture,
 
   if (other_field && picture->other_field)
     picture->other_field->ref = reference;
+
+  g_atomic_int_inc (&ref_marking_generation);
 }
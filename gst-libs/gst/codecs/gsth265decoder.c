@@ -50,6 +50,56 @@ typedef enum
   GST_H265_DECODER_ALIGN_AU
 } GstH265DecoderAlign;
 
+/* Reference picture set of a picture (8.3.2), with the same layout as the
+ * members of GstH265Decoder it is published to */
+typedef struct
+{
+  GstH265Picture *RefPicSetStCurrBefore[16];
+  GstH265Picture *RefPicSetStCurrAfter[16];
+  GstH265Picture *RefPicSetStFoll[16];
+  GstH265Picture *RefPicSetLtCurr[16];
+  GstH265Picture *RefPicSetLtFoll[16];
+
+  guint NumPocStCurrBefore;
+  guint NumPocStCurrAfter;
+  guint NumPocStFoll;
+  guint NumPocLtCurr;
+  guint NumPocLtFoll;
+  guint NumPocTotalCurr;
+} GstH265DecoderRefPicSet;
+
+typedef struct
+{
+  GstH265Slice slice;
+  GArray *ref_pic_list0;
+  GArray *ref_pic_list1;
+} GstH265DecoderJobSlice;
+
+/* Everything the submission thread needs to hand one picture over to the
+ * subclass in pipelined mode. Parameter sets, DPB and reference picture set
+ * are snapshots taken while the picture was parsed, so that the streaming
+ * thread can go on with the next pictures */
+typedef struct
+{
+  /* NULL if the job only carries pictures to output */
+  GstH265Picture *picture;
+
+  GstBuffer *input_buffer;
+  GstMapInfo map;
+
+  GstH265SPS sps;
+  GstH265PPS pps;
+  GstH265Dpb *dpb;
+  GstH265DecoderRefPicSet rps;
+  GArray *slices;
+
+  /* Pictures bumped from the DPB while this picture was parsed, output once
+   * the job is done */
+  GQueue outputs;
+  gboolean release_frame;
+  gboolean failed;
+} GstH265DecoderJob;
+
 struct _GstH265DecoderPrivate
 {
   gint width, height;
@@ -106,6 +156,9 @@ struct _GstH265DecoderPrivate
   gint32 PocLtCurr[16];
   gint32 PocLtFoll[16];
 
+  /* Reference picture set derived for the current picture */
+  GstH265DecoderRefPicSet rps;
+
   /* PicOrderCount of the previously outputted frame */
   gint last_output_poc;
 
@@ -113,11 +166,27 @@ struct _GstH265DecoderPrivate
   gboolean new_bitstream;
   gboolean prev_nal_is_eos;
 
+  /* See gst_h265_decoder_set_low_latency(), applied to every DPB */
+  gboolean low_latency;
+
   /* Reference picture lists, constructed for each slice */
   gboolean process_ref_pic_lists;
   GArray *ref_pic_list_tmp;
   GArray *ref_pic_list0;
   GArray *ref_pic_list1;
+
+  /* Pipelined mode, see gst_h265_decoder_set_pipeline_depth() */
+  guint pipeline_depth;
+  GstH265DecoderJob *current_job;
+  GThread *submit_thread;
+  GMutex submit_lock;
+  GCond submit_cond;
+  GQueue submit_queue;
+  GQueue done_queue;
+  gboolean submit_busy;
+  gboolean submit_stop;
+  /* Only accessed from the submission thread */
+  GstH265Dpb *submit_dpb;
 };
 
 #define parent_class gst_h265_decoder_parent_class
@@ -144,6 +213,14 @@ static void gst_h265_decoder_clear_ref_pic_sets (GstH265Decoder * self);
 static void gst_h265_decoder_clear_dpb (GstH265Decoder * self, gboolean flush);
 static gboolean gst_h265_decoder_drain_internal (GstH265Decoder * self);
 static gboolean gst_h265_decoder_start_current_picture (GstH265Decoder * self);
+static gpointer gst_h265_decoder_submit_thread (GstH265Decoder * self);
+static void gst_h265_decoder_wait_jobs (GstH265Decoder * self,
+    guint max_in_flight);
+static void gst_h265_decoder_flush_jobs (GstH265Decoder * self);
+static void gst_h265_decoder_job_free (GstH265DecoderJob * job);
+static void gst_h265_decoder_job_add_slice (GstH265DecoderJob * job,
+    const GstH265Slice * slice, GArray * ref_pic_list0,
+    GArray * ref_pic_list1);
 
 static void
 gst_h265_decoder_class_init (GstH265DecoderClass * klass)
@@ -178,6 +255,11 @@ gst_h265_decoder_init (GstH265Decoder * self)
       sizeof (GstH265Picture *), 32);
   priv->ref_pic_list1 = g_array_sized_new (FALSE, TRUE,
       sizeof (GstH265Picture *), 32);
+
+  g_mutex_init (&priv->submit_lock);
+  g_cond_init (&priv->submit_cond);
+  g_queue_init (&priv->submit_queue);
+  g_queue_init (&priv->done_queue);
 }
 
 static void
@@ -190,6 +272,9 @@ gst_h265_decoder_finalize (GObject * object)
   g_array_unref (priv->ref_pic_list0);
   g_array_unref (priv->ref_pic_list1);
 
+  g_mutex_clear (&priv->submit_lock);
+  g_cond_clear (&priv->submit_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -201,9 +286,19 @@ gst_h265_decoder_start (GstVideoDecoder * decoder)
 
   priv->parser = gst_h265_parser_new ();
   priv->dpb = gst_h265_dpb_new ();
+  gst_h265_dpb_set_low_latency (priv->dpb, priv->low_latency);
   priv->new_bitstream = TRUE;
   priv->prev_nal_is_eos = FALSE;
 
+  if (priv->pipeline_depth > 0) {
+    GST_DEBUG_OBJECT (self, "Pipelined mode, %u pictures in flight",
+        priv->pipeline_depth);
+
+    priv->submit_stop = FALSE;
+    priv->submit_thread = g_thread_new ("h265dec-submit",
+        (GThreadFunc) gst_h265_decoder_submit_thread, self);
+  }
+
   return TRUE;
 }
 
@@ -220,6 +315,23 @@ gst_h265_decoder_stop (GstVideoDecoder * decoder)
 
   gst_clear_buffer (&priv->codec_data);
 
+  if (priv->submit_thread) {
+    g_mutex_lock (&priv->submit_lock);
+    priv->submit_stop = TRUE;
+    g_cond_broadcast (&priv->submit_cond);
+    g_mutex_unlock (&priv->submit_lock);
+
+    g_thread_join (priv->submit_thread);
+    priv->submit_thread = NULL;
+
+    gst_h265_decoder_flush_jobs (self);
+  }
+
+  if (priv->current_job) {
+    gst_h265_decoder_job_free (priv->current_job);
+    priv->current_job = NULL;
+  }
+
   if (priv->parser) {
     gst_h265_parser_free (priv->parser);
     priv->parser = NULL;
@@ -306,6 +418,9 @@ gst_h265_decoder_process_sps (GstH265Decoder * self, GstH265SPS * sps)
 
     g_assert (klass->new_sequence);
 
+    /* Let the subclass finish the pictures in flight with the old sequence */
+    gst_h265_decoder_wait_jobs (self, 0);
+
     if (!klass->new_sequence (self, sps, max_dpb_size)) {
       GST_ERROR_OBJECT (self, "subclass does not want accept new sequence");
       return FALSE;
@@ -425,6 +540,7 @@ gst_h265_decoder_process_ref_pic_lists (GstH265Decoder * self,
     GArray ** ref_pic_list0, GArray ** ref_pic_list1)
 {
   GstH265DecoderPrivate *priv = self->priv;
+  GstH265DecoderRefPicSet *rps = &priv->rps;
   GstH265RefPicListModification *ref_mod =
       &slice->header.ref_pic_list_modification;
   GstH265PPSSccExtensionParams *scc_ext =
@@ -440,8 +556,8 @@ gst_h265_decoder_process_ref_pic_lists (GstH265Decoder * self,
     return;
 
   /* Inifinit loop prevention */
-  if (self->NumPocStCurrBefore == 0 && self->NumPocStCurrAfter == 0 &&
-      self->NumPocLtCurr == 0 && !scc_ext->pps_curr_pic_ref_enabled_flag) {
+  if (rps->NumPocStCurrBefore == 0 && rps->NumPocStCurrAfter == 0 &&
+      rps->NumPocLtCurr == 0 && !scc_ext->pps_curr_pic_ref_enabled_flag) {
     GST_WARNING_OBJECT (self,
         "Expected references, got none, preventing infinit loop.");
     return;
@@ -461,14 +577,14 @@ gst_h265_decoder_process_ref_pic_lists (GstH265Decoder * self,
       slice->header.NumPocTotalCurr);
 
   while (tmp_refs->len < num_tmp_refs) {
-    for (i = 0; i < self->NumPocStCurrBefore && tmp_refs->len < num_tmp_refs;
+    for (i = 0; i < rps->NumPocStCurrBefore && tmp_refs->len < num_tmp_refs;
         i++)
-      g_array_append_val (tmp_refs, self->RefPicSetStCurrBefore[i]);
-    for (i = 0; i < self->NumPocStCurrAfter && tmp_refs->len < num_tmp_refs;
+      g_array_append_val (tmp_refs, rps->RefPicSetStCurrBefore[i]);
+    for (i = 0; i < rps->NumPocStCurrAfter && tmp_refs->len < num_tmp_refs;
         i++)
-      g_array_append_val (tmp_refs, self->RefPicSetStCurrAfter[i]);
-    for (i = 0; i < self->NumPocLtCurr && tmp_refs->len < num_tmp_refs; i++)
-      g_array_append_val (tmp_refs, self->RefPicSetLtCurr[i]);
+      g_array_append_val (tmp_refs, rps->RefPicSetStCurrAfter[i]);
+    for (i = 0; i < rps->NumPocLtCurr && tmp_refs->len < num_tmp_refs; i++)
+      g_array_append_val (tmp_refs, rps->RefPicSetLtCurr[i]);
     if (scc_ext->pps_curr_pic_ref_enabled_flag)
       g_array_append_val (tmp_refs, curr_pic);
   }
@@ -511,14 +627,14 @@ gst_h265_decoder_process_ref_pic_lists (GstH265Decoder * self,
       slice->header.NumPocTotalCurr);
 
   while (tmp_refs->len < num_tmp_refs) {
-    for (i = 0; i < self->NumPocStCurrAfter && tmp_refs->len < num_tmp_refs;
+    for (i = 0; i < rps->NumPocStCurrAfter && tmp_refs->len < num_tmp_refs;
         i++)
-      g_array_append_val (tmp_refs, self->RefPicSetStCurrAfter[i]);
-    for (i = 0; i < self->NumPocStCurrBefore && tmp_refs->len < num_tmp_refs;
+      g_array_append_val (tmp_refs, rps->RefPicSetStCurrAfter[i]);
+    for (i = 0; i < rps->NumPocStCurrBefore && tmp_refs->len < num_tmp_refs;
         i++)
-      g_array_append_val (tmp_refs, self->RefPicSetStCurrBefore[i]);
-    for (i = 0; i < self->NumPocLtCurr && tmp_refs->len < num_tmp_refs; i++)
-      g_array_append_val (tmp_refs, self->RefPicSetLtCurr[i]);
+      g_array_append_val (tmp_refs, rps->RefPicSetStCurrBefore[i]);
+    for (i = 0; i < rps->NumPocLtCurr && tmp_refs->len < num_tmp_refs; i++)
+      g_array_append_val (tmp_refs, rps->RefPicSetLtCurr[i]);
     if (scc_ext->pps_curr_pic_ref_enabled_flag)
       g_array_append_val (tmp_refs, curr_pic);
   }
@@ -563,7 +679,13 @@ gst_h265_decoder_decode_slice (GstH265Decoder * self)
     gst_h265_decoder_process_ref_pic_lists (self, picture, slice, &l0, &l1);
   }
 
-  ret = klass->decode_slice (self, picture, slice, l0, l1);
+  /* In pipelined mode, decode_slice() is called by the submission thread */
+  if (priv->current_job) {
+    gst_h265_decoder_job_add_slice (priv->current_job, slice, l0, l1);
+    ret = TRUE;
+  } else {
+    ret = klass->decode_slice (self, picture, slice, l0, l1);
+  }
 
   if (priv->process_ref_pic_lists) {
     g_array_set_size (l0, 0);
@@ -929,6 +1051,7 @@ gst_h265_decoder_flush (GstVideoDecoder * decoder)
 {
   GstH265Decoder *self = GST_H265_DECODER (decoder);
 
+  gst_h265_decoder_flush_jobs (self);
   gst_h265_decoder_clear_dpb (self, TRUE);
 
   return TRUE;
@@ -1186,79 +1309,117 @@ has_entry_in_rps (GstH265Picture * dpb_pic,
 }
 
 static void
-gst_h265_decoder_clear_ref_pic_sets (GstH265Decoder * self)
+gst_h265_ref_pic_set_clear (GstH265DecoderRefPicSet * rps)
 {
   guint i;
 
   for (i = 0; i < 16; i++) {
-    gst_h265_picture_replace (&self->RefPicSetLtCurr[i], NULL);
-    gst_h265_picture_replace (&self->RefPicSetLtFoll[i], NULL);
-    gst_h265_picture_replace (&self->RefPicSetStCurrBefore[i], NULL);
-    gst_h265_picture_replace (&self->RefPicSetStCurrAfter[i], NULL);
-    gst_h265_picture_replace (&self->RefPicSetStFoll[i], NULL);
+    gst_h265_picture_replace (&rps->RefPicSetLtCurr[i], NULL);
+    gst_h265_picture_replace (&rps->RefPicSetLtFoll[i], NULL);
+    gst_h265_picture_replace (&rps->RefPicSetStCurrBefore[i], NULL);
+    gst_h265_picture_replace (&rps->RefPicSetStCurrAfter[i], NULL);
+    gst_h265_picture_replace (&rps->RefPicSetStFoll[i], NULL);
   }
 }
 
+/* Publishes @rps to the subclass through the GstH265Decoder members */
+static void
+gst_h265_decoder_set_ref_pic_sets (GstH265Decoder * self,
+    const GstH265DecoderRefPicSet * rps)
+{
+  guint i;
+
+  for (i = 0; i < 16; i++) {
+    gst_h265_picture_replace (&self->RefPicSetLtCurr[i],
+        rps->RefPicSetLtCurr[i]);
+    gst_h265_picture_replace (&self->RefPicSetLtFoll[i],
+        rps->RefPicSetLtFoll[i]);
+    gst_h265_picture_replace (&self->RefPicSetStCurrBefore[i],
+        rps->RefPicSetStCurrBefore[i]);
+    gst_h265_picture_replace (&self->RefPicSetStCurrAfter[i],
+        rps->RefPicSetStCurrAfter[i]);
+    gst_h265_picture_replace (&self->RefPicSetStFoll[i],
+        rps->RefPicSetStFoll[i]);
+  }
+
+  self->NumPocStCurrBefore = rps->NumPocStCurrBefore;
+  self->NumPocStCurrAfter = rps->NumPocStCurrAfter;
+  self->NumPocStFoll = rps->NumPocStFoll;
+  self->NumPocLtCurr = rps->NumPocLtCurr;
+  self->NumPocLtFoll = rps->NumPocLtFoll;
+  self->NumPocTotalCurr = rps->NumPocTotalCurr;
+}
+
+static void
+gst_h265_decoder_clear_ref_pic_sets (GstH265Decoder * self)
+{
+  GstH265DecoderRefPicSet empty = { {NULL,}, };
+
+  gst_h265_ref_pic_set_clear (&self->priv->rps);
+  gst_h265_decoder_set_ref_pic_sets (self, &empty);
+}
+
 static void
 gst_h265_decoder_derive_and_mark_rps (GstH265Decoder * self,
     GstH265Picture * picture, gint32 * CurrDeltaPocMsbPresentFlag,
     gint32 * FollDeltaPocMsbPresentFlag)
 {
   GstH265DecoderPrivate *priv = self->priv;
+  GstH265DecoderRefPicSet *rps = &priv->rps;
   guint i;
   GArray *dpb_array;
 
-  gst_h265_decoder_clear_ref_pic_sets (self);
+  gst_h265_ref_pic_set_clear (rps);
 
   /* (8-6) */
-  for (i = 0; i < self->NumPocLtCurr; i++) {
+  for (i = 0; i < rps->NumPocLtCurr; i++) {
     if (!CurrDeltaPocMsbPresentFlag[i]) {
-      self->RefPicSetLtCurr[i] =
+      rps->RefPicSetLtCurr[i] =
           gst_h265_dpb_get_ref_by_poc_lsb (priv->dpb, priv->PocLtCurr[i]);
     } else {
-      self->RefPicSetLtCurr[i] =
+      rps->RefPicSetLtCurr[i] =
           gst_h265_dpb_get_ref_by_poc (priv->dpb, priv->PocLtCurr[i]);
     }
   }
 
-  for (i = 0; i < self->NumPocLtFoll; i++) {
+  for (i = 0; i < rps->NumPocLtFoll; i++) {
     if (!FollDeltaPocMsbPresentFlag[i]) {
-      self->RefPicSetLtFoll[i] =
+      rps->RefPicSetLtFoll[i] =
           gst_h265_dpb_get_ref_by_poc_lsb (priv->dpb, priv->PocLtFoll[i]);
     } else {
-      self->RefPicSetLtFoll[i] =
+      rps->RefPicSetLtFoll[i] =
           gst_h265_dpb_get_ref_by_poc (priv->dpb, priv->PocLtFoll[i]);
     }
   }
 
   /* Mark all ref pics in RefPicSetLtCurr and RefPicSetLtFol as long_term_refs */
-  for (i = 0; i < self->NumPocLtCurr; i++) {
-    if (self->RefPicSetLtCurr[i]) {
-      self->RefPicSetLtCurr[i]->ref = TRUE;
-      self->RefPicSetLtCurr[i]->long_term = TRUE;
+  for (i = 0; i < rps->NumPocLtCurr; i++) {
+    if (rps->RefPicSetLtCurr[i]) {
+      rps->RefPicSetLtCurr[i]->ref = TRUE;
+      rps->RefPicSetLtCurr[i]->long_term = TRUE;
     }
   }
 
-  for (i = 0; i < self->NumPocLtFoll; i++) {
-    if (self->RefPicSetLtFoll[i]) {
-      self->RefPicSetLtFoll[i]->ref = TRUE;
-      self->RefPicSetLtFoll[i]->long_term = TRUE;
+  for (i = 0; i < rps->NumPocLtFoll; i++) {
+    if (rps->RefPicSetLtFoll[i]) {
+      rps->RefPicSetLtFoll[i]->ref = TRUE;
+      rps->RefPicSetLtFoll[i]->long_term = TRUE;
     }
   }
 
   /* (8-7) */
-  for (i = 0; i < self->NumPocStCurrBefore; i++) {
-    self->RefPicSetStCurrBefore[i] =
+  for (i = 0; i < rps->NumPocStCurrBefore; i++) {
+    rps->RefPicSetStCurrBefore[i] =
         gst_h265_dpb_get_short_ref_by_poc (priv->dpb, priv->PocStCurrBefore[i]);
   }
 
-  for (i = 0; i < self->NumPocStCurrAfter; i++) {
-    self->RefPicSetStCurrAfter[i] =
+  for (i = 0; i < rps->NumPocStCurrAfter; i++) {
+    rps->RefPicSetStCurrAfter[i] =
         gst_h265_dpb_get_short_ref_by_poc (priv->dpb, priv->PocStCurrAfter[i]);
   }
 
-  for (i = 0; i < self->NumPocStFoll; i++) {
-    self->RefPicSetStFoll[i] =
+  for (i = 0; i < rps->NumPocStFoll; i++) {
+    rps->RefPicSetStFoll[i] =
         gst_h265_dpb_get_short_ref_by_poc (priv->dpb, priv->PocStFoll[i]);
   }
 
@@ -1268,15 +1429,15 @@ gst_h265_decoder_derive_and_mark_rps (GstH265Decoder * self,
     GstH265Picture *dpb_pic = g_array_index (dpb_array, GstH265Picture *, i);
 
     if (dpb_pic &&
-        !has_entry_in_rps (dpb_pic, self->RefPicSetLtCurr, self->NumPocLtCurr)
-        && !has_entry_in_rps (dpb_pic, self->RefPicSetLtFoll,
-            self->NumPocLtFoll)
-        && !has_entry_in_rps (dpb_pic, self->RefPicSetStCurrAfter,
-            self->NumPocStCurrAfter)
-        && !has_entry_in_rps (dpb_pic, self->RefPicSetStCurrBefore,
-            self->NumPocStCurrBefore)
-        && !has_entry_in_rps (dpb_pic, self->RefPicSetStFoll,
-            self->NumPocStFoll)) {
+        !has_entry_in_rps (dpb_pic, rps->RefPicSetLtCurr, rps->NumPocLtCurr)
+        && !has_entry_in_rps (dpb_pic, rps->RefPicSetLtFoll,
+            rps->NumPocLtFoll)
+        && !has_entry_in_rps (dpb_pic, rps->RefPicSetStCurrAfter,
+            rps->NumPocStCurrAfter)
+        && !has_entry_in_rps (dpb_pic, rps->RefPicSetStCurrBefore,
+            rps->NumPocStCurrBefore)
+        && !has_entry_in_rps (dpb_pic, rps->RefPicSetStFoll,
+            rps->NumPocStFoll)) {
       GST_LOG_OBJECT (self, "Mark Picture %p (poc %d) as non-ref", dpb_pic,
           dpb_pic->pic_order_cnt);
       dpb_pic->ref = FALSE;
@@ -1292,6 +1453,7 @@ gst_h265_decoder_prepare_rps (GstH265Decoder * self, const GstH265Slice * slice,
     GstH265Picture * picture)
 {
   GstH265DecoderPrivate *priv = self->priv;
+  GstH265DecoderRefPicSet *rps = &priv->rps;
   gint32 CurrDeltaPocMsbPresentFlag[16] = { 0, };
   gint32 FollDeltaPocMsbPresentFlag[16] = { 0, };
   const GstH265SliceHdr *slice_hdr = &slice->header;
@@ -1313,8 +1475,8 @@ gst_h265_decoder_prepare_rps (GstH265Decoder * self, const GstH265Slice * slice,
     memset (priv->PocStFoll, 0, sizeof (priv->PocStFoll));
     memset (priv->PocLtCurr, 0, sizeof (priv->PocLtCurr));
     memset (priv->PocLtFoll, 0, sizeof (priv->PocLtFoll));
-    self->NumPocStCurrBefore = self->NumPocStCurrAfter = self->NumPocStFoll = 0;
-    self->NumPocLtCurr = self->NumPocLtFoll = 0;
+    rps->NumPocStCurrBefore = rps->NumPocStCurrAfter = rps->NumPocStFoll = 0;
+    rps->NumPocLtCurr = rps->NumPocLtFoll = 0;
   } else {
     const GstH265ShortTermRefPicSet *stRefPic = NULL;
     gint32 num_lt_pics, pocLt;
@@ -1345,7 +1507,7 @@ gst_h265_decoder_prepare_rps (GstH265Decoder * self, const GstH265Slice * slice,
       } else
         priv->PocStFoll[k++] = picture->pic_order_cnt + stRefPic->DeltaPocS0[i];
     }
-    self->NumPocStCurrBefore = j;
+    rps->NumPocStCurrBefore = j;
     for (i = 0, j = 0; i < stRefPic->NumPositivePics; i++) {
       if (stRefPic->UsedByCurrPicS1[i]) {
         priv->PocStCurrAfter[j++] =
@@ -1354,8 +1516,8 @@ gst_h265_decoder_prepare_rps (GstH265Decoder * self, const GstH265Slice * slice,
       } else
         priv->PocStFoll[k++] = picture->pic_order_cnt + stRefPic->DeltaPocS1[i];
     }
-    self->NumPocStCurrAfter = j;
-    self->NumPocStFoll = k;
+    rps->NumPocStCurrAfter = j;
+    rps->NumPocStFoll = k;
     num_lt_pics = slice_hdr->num_long_term_sps + slice_hdr->num_long_term_pics;
     /* The variables PocLsbLt[i] and UsedByCurrPicLt[i] are derived as follows: */
     for (i = 0; i < num_lt_pics; i++) {
@@ -1371,7 +1533,7 @@ gst_h265_decoder_prepare_rps (GstH265Decoder * self, const GstH265Slice * slice,
         numtotalcurr++;
     }
 
-    self->NumPocTotalCurr = numtotalcurr;
+    rps->NumPocTotalCurr = numtotalcurr;
 
     /* The variable DeltaPocMsbCycleLt[i] is derived as follows: (7-38) */
     for (i = 0; i < num_lt_pics; i++) {
@@ -1399,16 +1561,16 @@ gst_h265_decoder_prepare_rps (GstH265Decoder * self, const GstH265Slice * slice,
             slice_hdr->delta_poc_msb_present_flag[i];
       }
     }
-    self->NumPocLtCurr = j;
-    self->NumPocLtFoll = k;
+    rps->NumPocLtCurr = j;
+    rps->NumPocLtFoll = k;
   }
 
-  GST_LOG_OBJECT (self, "NumPocStCurrBefore: %d", self->NumPocStCurrBefore);
-  GST_LOG_OBJECT (self, "NumPocStCurrAfter:  %d", self->NumPocStCurrAfter);
-  GST_LOG_OBJECT (self, "NumPocStFoll:       %d", self->NumPocStFoll);
-  GST_LOG_OBJECT (self, "NumPocLtCurr:       %d", self->NumPocLtCurr);
-  GST_LOG_OBJECT (self, "NumPocLtFoll:       %d", self->NumPocLtFoll);
-  GST_LOG_OBJECT (self, "NumPocTotalCurr:    %d", self->NumPocTotalCurr);
+  GST_LOG_OBJECT (self, "NumPocStCurrBefore: %d", rps->NumPocStCurrBefore);
+  GST_LOG_OBJECT (self, "NumPocStCurrAfter:  %d", rps->NumPocStCurrAfter);
+  GST_LOG_OBJECT (self, "NumPocStFoll:       %d", rps->NumPocStFoll);
+  GST_LOG_OBJECT (self, "NumPocLtCurr:       %d", rps->NumPocLtCurr);
+  GST_LOG_OBJECT (self, "NumPocLtFoll:       %d", rps->NumPocLtFoll);
+  GST_LOG_OBJECT (self, "NumPocTotalCurr:    %d", rps->NumPocTotalCurr);
 
   /* the derivation process for the RPS and the picture marking */
   gst_h265_decoder_derive_and_mark_rps (self, picture,
@@ -1455,6 +1617,418 @@ gst_h265_decoder_do_output_picture (GstH265Decoder * self,
   priv->last_ret = klass->output_picture (self, frame, picture);
 }
 
+/* Outputs a picture bumped from the DPB. In pipelined mode, the pictures
+ * bumped while parsing a picture are output once the submission thread is
+ * done with it, as that picture might be one of them */
+static void
+gst_h265_decoder_queue_output (GstH265Decoder * self, GstH265Picture * picture)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+
+  if (priv->current_job)
+    g_queue_push_tail (&priv->current_job->outputs, picture);
+  else
+    gst_h265_decoder_do_output_picture (self, picture);
+}
+
+G_DEFINE_QUARK (gst-h265-decoder-original-picture,
+    gst_h265_decoder_original_picture);
+
+/* Copies @picture along with its current reference and output state. The
+ * copy shares the user data of @picture and keeps it alive */
+static GstH265Picture *
+gst_h265_decoder_copy_picture (GstH265Picture * picture)
+{
+  GstH265Picture *copy = gst_h265_picture_new ();
+
+  memcpy (&copy->type, &picture->type,
+      sizeof (GstH265Picture) - G_STRUCT_OFFSET (GstH265Picture, type));
+  copy->notify = NULL;
+
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (copy),
+      gst_h265_decoder_original_picture_quark (),
+      gst_h265_picture_ref (picture), (GDestroyNotify) gst_mini_object_unref);
+
+  return copy;
+}
+
+/* Returns the copy of @picture in the DPB snapshot of @job, or @picture
+ * itself if it isn't part of the DPB, like the current picture */
+static GstH265Picture *
+gst_h265_decoder_job_lookup (GstH265DecoderJob * job, GstH265Picture * picture)
+{
+  GQuark quark = gst_h265_decoder_original_picture_quark ();
+  GstH265Picture *ret = picture;
+  GArray *copies;
+  guint i;
+
+  if (!picture)
+    return NULL;
+
+  copies = gst_h265_dpb_get_pictures_all (job->dpb);
+  for (i = 0; i < copies->len; i++) {
+    GstH265Picture *copy = g_array_index (copies, GstH265Picture *, i);
+
+    if (gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (copy), quark) ==
+        picture) {
+      ret = copy;
+      break;
+    }
+  }
+  g_array_unref (copies);
+
+  return ret;
+}
+
+static void
+gst_h265_decoder_job_slice_clear (GstH265DecoderJobSlice * job_slice)
+{
+  if (job_slice->ref_pic_list0)
+    g_array_unref (job_slice->ref_pic_list0);
+  if (job_slice->ref_pic_list1)
+    g_array_unref (job_slice->ref_pic_list1);
+}
+
+static GstH265DecoderJob *
+gst_h265_decoder_job_new (GstH265Decoder * self)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+  GstH265DecoderJob *job;
+
+  job = g_new0 (GstH265DecoderJob, 1);
+  g_queue_init (&job->outputs);
+  job->slices = g_array_new (FALSE, FALSE, sizeof (GstH265DecoderJobSlice));
+  g_array_set_clear_func (job->slices,
+      (GDestroyNotify) gst_h265_decoder_job_slice_clear);
+
+  /* The slices point into the input buffer, keep it mapped until the
+   * subclass is done with them */
+  job->input_buffer = gst_buffer_ref (priv->current_frame->input_buffer);
+  if (!gst_buffer_map (job->input_buffer, &job->map, GST_MAP_READ)) {
+    gst_clear_buffer (&job->input_buffer);
+    gst_h265_decoder_job_free (job);
+    return NULL;
+  }
+
+  job->picture = gst_h265_picture_ref (priv->current_picture);
+  job->sps = *priv->active_sps;
+  job->pps = *priv->active_pps;
+  job->pps.sps = &job->sps;
+
+  return job;
+}
+
+static void
+gst_h265_decoder_job_free (GstH265DecoderJob * job)
+{
+  GstH265Picture *picture;
+
+  while ((picture = g_queue_pop_head (&job->outputs)))
+    gst_h265_picture_unref (picture);
+
+  g_array_unref (job->slices);
+  gst_h265_ref_pic_set_clear (&job->rps);
+  if (job->dpb)
+    gst_h265_dpb_free (job->dpb);
+
+  if (job->input_buffer) {
+    gst_buffer_unmap (job->input_buffer, &job->map);
+    gst_buffer_unref (job->input_buffer);
+  }
+
+  gst_h265_picture_clear (&job->picture);
+  g_free (job);
+}
+
+static void
+gst_h265_decoder_job_copy_ref_pic_set (GstH265DecoderJob * job,
+    GstH265Picture ** dest, GstH265Picture ** src)
+{
+  guint i;
+
+  for (i = 0; i < 16; i++) {
+    GstH265Picture *copy = gst_h265_decoder_job_lookup (job, src[i]);
+
+    dest[i] = copy ? gst_h265_picture_ref (copy) : NULL;
+  }
+}
+
+/* Takes the DPB and reference picture set the subclass gets to see in
+ * start_picture() */
+static void
+gst_h265_decoder_job_snapshot (GstH265Decoder * self, GstH265DecoderJob * job)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+  GstH265DecoderRefPicSet *rps = &priv->rps;
+  GArray *pictures, *copies;
+  guint i;
+
+  job->dpb = gst_h265_dpb_new ();
+  gst_h265_dpb_set_max_num_pics (job->dpb,
+      gst_h265_dpb_get_max_num_pics (priv->dpb));
+  gst_h265_dpb_set_low_latency (job->dpb, priv->low_latency);
+
+  pictures = gst_h265_dpb_get_pictures_all (priv->dpb);
+  for (i = 0; i < pictures->len; i++) {
+    GstH265Picture *picture = g_array_index (pictures, GstH265Picture *, i);
+
+    gst_h265_dpb_add (job->dpb, gst_h265_decoder_copy_picture (picture));
+  }
+
+  /* gst_h265_dpb_add() updates the reference and output state of the
+   * pictures it stores, take it over from the originals again */
+  copies = gst_h265_dpb_get_pictures_all (job->dpb);
+  for (i = 0; i < copies->len; i++) {
+    GstH265Picture *picture = g_array_index (pictures, GstH265Picture *, i);
+    GstH265Picture *copy = g_array_index (copies, GstH265Picture *, i);
+
+    copy->ref = picture->ref;
+    copy->long_term = picture->long_term;
+    copy->needed_for_output = picture->needed_for_output;
+    copy->pic_latency_cnt = picture->pic_latency_cnt;
+  }
+  g_array_unref (copies);
+  g_array_unref (pictures);
+
+  /* Takes the counts, the pictures are replaced with their copies below */
+  job->rps = *rps;
+  gst_h265_decoder_job_copy_ref_pic_set (job, job->rps.RefPicSetStCurrBefore,
+      rps->RefPicSetStCurrBefore);
+  gst_h265_decoder_job_copy_ref_pic_set (job, job->rps.RefPicSetStCurrAfter,
+      rps->RefPicSetStCurrAfter);
+  gst_h265_decoder_job_copy_ref_pic_set (job, job->rps.RefPicSetStFoll,
+      rps->RefPicSetStFoll);
+  gst_h265_decoder_job_copy_ref_pic_set (job, job->rps.RefPicSetLtCurr,
+      rps->RefPicSetLtCurr);
+  gst_h265_decoder_job_copy_ref_pic_set (job, job->rps.RefPicSetLtFoll,
+      rps->RefPicSetLtFoll);
+}
+
+static GArray *
+gst_h265_decoder_job_copy_ref_pic_list (GstH265DecoderJob * job,
+    GArray * ref_pic_list)
+{
+  GArray *copy;
+  guint i;
+
+  if (!ref_pic_list)
+    return NULL;
+
+  copy = g_array_sized_new (FALSE, TRUE, sizeof (GstH265Picture *),
+      ref_pic_list->len);
+  for (i = 0; i < ref_pic_list->len; i++) {
+    GstH265Picture *picture = gst_h265_decoder_job_lookup (job,
+        g_array_index (ref_pic_list, GstH265Picture *, i));
+
+    g_array_append_val (copy, picture);
+  }
+
+  return copy;
+}
+
+static void
+gst_h265_decoder_job_add_slice (GstH265DecoderJob * job,
+    const GstH265Slice * slice, GArray * ref_pic_list0, GArray * ref_pic_list1)
+{
+  GstH265DecoderJobSlice job_slice;
+
+  job_slice.slice = *slice;
+  job_slice.slice.header.pps = &job->pps;
+  job_slice.slice.nalu.data = job->map.data;
+  job_slice.ref_pic_list0 =
+      gst_h265_decoder_job_copy_ref_pic_list (job, ref_pic_list0);
+  job_slice.ref_pic_list1 =
+      gst_h265_decoder_job_copy_ref_pic_list (job, ref_pic_list1);
+
+  g_array_append_val (job->slices, job_slice);
+}
+
+/* Called from the submission thread */
+static void
+gst_h265_decoder_submit_job (GstH265Decoder * self, GstH265DecoderJob * job)
+{
+  GstH265DecoderClass *klass = GST_H265_DECODER_GET_CLASS (self);
+  GstH265DecoderPrivate *priv = self->priv;
+  GstH265DecoderJobSlice *job_slice;
+  gboolean ret = TRUE;
+  guint i;
+
+  if (!job->picture)
+    return;
+
+  if (job->slices->len == 0) {
+    job->failed = TRUE;
+    return;
+  }
+
+  GST_LOG_OBJECT (self, "Submitting picture %p (poc %d), %u slices",
+      job->picture, job->picture->pic_order_cnt, job->slices->len);
+
+  priv->submit_dpb = job->dpb;
+  gst_h265_decoder_set_ref_pic_sets (self, &job->rps);
+
+  job_slice = &g_array_index (job->slices, GstH265DecoderJobSlice, 0);
+  if (klass->start_picture)
+    ret = klass->start_picture (self, job->picture, &job_slice->slice,
+        job->dpb);
+
+  for (i = 0; ret && i < job->slices->len; i++) {
+    job_slice = &g_array_index (job->slices, GstH265DecoderJobSlice, i);
+    ret = klass->decode_slice (self, job->picture, &job_slice->slice,
+        job_slice->ref_pic_list0, job_slice->ref_pic_list1);
+  }
+
+  if (ret && klass->end_picture)
+    ret = klass->end_picture (self, job->picture);
+
+  priv->submit_dpb = NULL;
+
+  if (!ret) {
+    GST_ERROR_OBJECT (self, "Failed to submit picture %p", job->picture);
+    job->failed = TRUE;
+  }
+}
+
+static gpointer
+gst_h265_decoder_submit_thread (GstH265Decoder * self)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+  GstH265DecoderJob *job;
+
+  g_mutex_lock (&priv->submit_lock);
+  while (TRUE) {
+    while (!priv->submit_stop && g_queue_is_empty (&priv->submit_queue))
+      g_cond_wait (&priv->submit_cond, &priv->submit_lock);
+
+    if (priv->submit_stop)
+      break;
+
+    job = g_queue_pop_head (&priv->submit_queue);
+    priv->submit_busy = TRUE;
+    g_mutex_unlock (&priv->submit_lock);
+
+    gst_h265_decoder_submit_job (self, job);
+
+    g_mutex_lock (&priv->submit_lock);
+    priv->submit_busy = FALSE;
+    g_queue_push_tail (&priv->done_queue, job);
+    g_cond_broadcast (&priv->submit_cond);
+  }
+  g_mutex_unlock (&priv->submit_lock);
+
+  return NULL;
+}
+
+/* Called from the streaming thread for the jobs the submission thread is
+ * done with, in decoding order */
+static void
+gst_h265_decoder_finish_job (GstH265Decoder * self, GstH265DecoderJob * job)
+{
+  GstVideoDecoder *decoder = GST_VIDEO_DECODER (self);
+  GstH265DecoderPrivate *priv = self->priv;
+  GstH265Picture *picture;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if (job->picture && job->release_frame) {
+    GstVideoCodecFrame *frame = gst_video_decoder_get_frame (decoder,
+        job->picture->system_frame_number);
+
+    if (frame)
+      gst_video_decoder_release_frame (decoder, frame);
+  }
+
+  if (job->failed) {
+    GstVideoCodecFrame *frame;
+
+    GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
+        ("Failed to decode data"), (NULL), ret);
+    if (ret != GST_FLOW_OK)
+      priv->last_ret = ret;
+
+    /* The picture stays in the DPB as a reference, but must not be output.
+     * It might already have been bumped into the outputs of this job or of
+     * the ones queued after it, which skip it. */
+    job->picture->output_flag = FALSE;
+    job->picture->needed_for_output = FALSE;
+
+    frame = gst_video_decoder_get_frame (decoder,
+        job->picture->system_frame_number);
+    if (frame)
+      gst_video_decoder_drop_frame (decoder, frame);
+  }
+
+  while ((picture = g_queue_pop_head (&job->outputs))) {
+    if (picture->output_flag)
+      gst_h265_decoder_do_output_picture (self, picture);
+    else
+      gst_h265_picture_unref (picture);
+  }
+
+  gst_h265_decoder_job_free (job);
+}
+
+/* Finishes the jobs the submission thread is done with, and waits for more
+ * of them while more than @max_in_flight are queued or being submitted */
+static void
+gst_h265_decoder_wait_jobs (GstH265Decoder * self, guint max_in_flight)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+  GstH265DecoderJob *job;
+
+  if (!priv->submit_thread)
+    return;
+
+  g_mutex_lock (&priv->submit_lock);
+  while (TRUE) {
+    job = g_queue_pop_head (&priv->done_queue);
+    if (job) {
+      g_mutex_unlock (&priv->submit_lock);
+      gst_h265_decoder_finish_job (self, job);
+      g_mutex_lock (&priv->submit_lock);
+      continue;
+    }
+
+    if (g_queue_get_length (&priv->submit_queue) +
+        (priv->submit_busy ? 1 : 0) <= max_in_flight)
+      break;
+
+    g_cond_wait (&priv->submit_cond, &priv->submit_lock);
+  }
+  g_mutex_unlock (&priv->submit_lock);
+}
+
+/* Drops all jobs, after waiting for the one being submitted */
+static void
+gst_h265_decoder_flush_jobs (GstH265Decoder * self)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+  GstH265DecoderJob *job;
+
+  g_mutex_lock (&priv->submit_lock);
+  while ((job = g_queue_pop_head (&priv->submit_queue)))
+    gst_h265_decoder_job_free (job);
+
+  while (priv->submit_busy)
+    g_cond_wait (&priv->submit_cond, &priv->submit_lock);
+
+  while ((job = g_queue_pop_head (&priv->done_queue)))
+    gst_h265_decoder_job_free (job);
+  g_mutex_unlock (&priv->submit_lock);
+}
+
+static void
+gst_h265_decoder_queue_job (GstH265Decoder * self, GstH265DecoderJob * job)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+
+  g_mutex_lock (&priv->submit_lock);
+  g_queue_push_tail (&priv->submit_queue, job);
+  g_cond_broadcast (&priv->submit_cond);
+  g_mutex_unlock (&priv->submit_lock);
+
+  gst_h265_decoder_wait_jobs (self, priv->pipeline_depth);
+}
+
 static void
 gst_h265_decoder_clear_dpb (GstH265Decoder * self, gboolean flush)
 {
@@ -1465,6 +2039,9 @@ gst_h265_decoder_clear_dpb (GstH265Decoder * self, gboolean flush)
   /* If we are not flushing now, videodecoder baseclass will hold
    * GstVideoCodecFrame. Release frames manually */
   if (!flush) {
+    /* The subclass must be done with the pictures in flight first */
+    gst_h265_decoder_wait_jobs (self, 0);
+
     while ((picture = gst_h265_dpb_bump (priv->dpb, TRUE)) != NULL) {
       GstVideoCodecFrame *frame = gst_video_decoder_get_frame (decoder,
           picture->system_frame_number);
@@ -1485,6 +2062,8 @@ gst_h265_decoder_drain_internal (GstH265Decoder * self)
   GstH265DecoderPrivate *priv = self->priv;
   GstH265Picture *picture;
 
+  gst_h265_decoder_wait_jobs (self, 0);
+
   while ((picture = gst_h265_dpb_bump (priv->dpb, TRUE)) != NULL)
     gst_h265_decoder_do_output_picture (self, picture);
 
@@ -1520,7 +2099,7 @@ gst_h265_decoder_dpb_init (GstH265Decoder * self, const GstH265Slice * slice,
     } else {
       gst_h265_dpb_delete_unused (priv->dpb);
       while ((to_output = gst_h265_dpb_bump (priv->dpb, FALSE)) != NULL)
-        gst_h265_decoder_do_output_picture (self, to_output);
+        gst_h265_decoder_queue_output (self, to_output);
     }
   } else {
     gst_h265_dpb_delete_unused (priv->dpb);
@@ -1537,7 +2116,7 @@ gst_h265_decoder_dpb_init (GstH265Decoder * self, const GstH265Slice * slice,
         break;
       }
 
-      gst_h265_decoder_do_output_picture (self, to_output);
+      gst_h265_decoder_queue_output (self, to_output);
     }
   }
 
@@ -1570,8 +2149,24 @@ gst_h265_decoder_start_current_picture (GstH265Decoder * self)
   gst_h265_decoder_prepare_rps (self, &priv->current_slice,
       priv->current_picture);
 
+  if (priv->submit_thread) {
+    priv->current_job = gst_h265_decoder_job_new (self);
+    if (!priv->current_job) {
+      GST_ERROR_OBJECT (self, "Failed to map input buffer");
+      return FALSE;
+    }
+  }
+
   gst_h265_decoder_dpb_init (self, &priv->current_slice, priv->current_picture);
 
+  /* In pipelined mode, start_picture() is called by the submission thread */
+  if (priv->current_job) {
+    gst_h265_decoder_job_snapshot (self, priv->current_job);
+    return TRUE;
+  }
+
+  gst_h265_decoder_set_ref_pic_sets (self, &priv->rps);
+
   klass = GST_H265_DECODER_GET_CLASS (self);
   if (klass->start_picture)
     ret = klass->start_picture (self, priv->current_picture,
@@ -1601,10 +2196,15 @@ gst_h265_decoder_finish_picture (GstH265Decoder * self,
 
   /* This picture is decode only, drop corresponding frame */
   if (!picture->output_flag) {
-    GstVideoCodecFrame *frame = gst_video_decoder_get_frame (decoder,
-        picture->system_frame_number);
+    if (priv->current_job) {
+      /* Once the subclass is done with the picture */
+      priv->current_job->release_frame = TRUE;
+    } else {
+      GstVideoCodecFrame *frame = gst_video_decoder_get_frame (decoder,
+          picture->system_frame_number);
 
-    gst_video_decoder_release_frame (decoder, frame);
+      gst_video_decoder_release_frame (decoder, frame);
+    }
   }
 
   /* gst_h265_dpb_add() will take care of pic_latency_cnt increment and
@@ -1625,7 +2225,7 @@ gst_h265_decoder_finish_picture (GstH265Decoder * self,
       break;
     }
 
-    gst_h265_decoder_do_output_picture (self, to_output);
+    gst_h265_decoder_queue_output (self, to_output);
   }
 
   if (gst_h265_dpb_is_full (priv->dpb)) {
@@ -1650,13 +2250,21 @@ gst_h265_decoder_finish_current_picture (GstH265Decoder * self)
 
   klass = GST_H265_DECODER_GET_CLASS (self);
 
-  if (klass->end_picture)
+  /* In pipelined mode, end_picture() is called by the submission thread */
+  if (!priv->current_job && klass->end_picture)
     ret = klass->end_picture (self, priv->current_picture);
 
   /* finish picture takes ownership of the picture */
   ret = gst_h265_decoder_finish_picture (self, priv->current_picture);
   priv->current_picture = NULL;
 
+  if (priv->current_job) {
+    GstH265DecoderJob *job = priv->current_job;
+
+    priv->current_job = NULL;
+    gst_h265_decoder_queue_job (self, job);
+  }
+
   if (!ret) {
     GST_ERROR_OBJECT (self, "Failed to finish picture");
     return FALSE;
@@ -1740,6 +2348,15 @@ gst_h265_decoder_handle_frame (GstVideoDecoder * decoder,
   priv->current_frame = NULL;
 
   if (!decode_ret) {
+    if (priv->current_job) {
+      GstH265DecoderJob *job = priv->current_job;
+
+      /* Only keep the pictures bumped from the DPB meanwhile */
+      priv->current_job = NULL;
+      gst_h265_picture_clear (&job->picture);
+      gst_h265_decoder_queue_job (self, job);
+    }
+
     GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
         ("Failed to decode data"), (NULL), priv->last_ret);
     gst_video_decoder_drop_frame (decoder, frame);
@@ -1771,6 +2388,30 @@ gst_h265_decoder_set_process_ref_pic_lists (GstH265Decoder * decoder,
   decoder->priv->process_ref_pic_lists = process;
 }
 
+/**
+ * gst_h265_decoder_set_low_latency:
+ * @decoder: a #GstH265Decoder
+ * @low_latency: whether pictures should be output as early as possible
+ *
+ * Called to en/disable low-latency output. When enabled, a picture is output
+ * as soon as its picture order count directly follows the one of the
+ * previously output picture, instead of when the reordering constraints of
+ * the stream or the fullness of the DPB require it. The setting is kept
+ * across stop and start.
+ *
+ * Since: 1.20
+ */
+void
+gst_h265_decoder_set_low_latency (GstH265Decoder * decoder,
+    gboolean low_latency)
+{
+  GstH265DecoderPrivate *priv = decoder->priv;
+
+  priv->low_latency = low_latency;
+  if (priv->dpb)
+    gst_h265_dpb_set_low_latency (priv->dpb, low_latency);
+}
+
 /**
  * gst_h265_decoder_get_picture:
  * @decoder: a #GstH265Decoder
@@ -1787,5 +2428,56 @@ GstH265Picture *
 gst_h265_decoder_get_picture (GstH265Decoder * decoder,
     guint32 system_frame_number)
 {
-  return gst_h265_dpb_get_picture (decoder->priv->dpb, system_frame_number);
+  GstH265DecoderPrivate *priv = decoder->priv;
+
+  /* Look up the DPB as seen by the picture being submitted */
+  if (priv->submit_thread && g_thread_self () == priv->submit_thread &&
+      priv->submit_dpb)
+    return gst_h265_dpb_get_picture (priv->submit_dpb, system_frame_number);
+
+  return gst_h265_dpb_get_picture (priv->dpb, system_frame_number);
+}
+
+/**
+ * gst_h265_decoder_set_pipeline_depth:
+ * @decoder: a #GstH265Decoder
+ * @depth: the maximum number of pictures in flight, or 0 to disable
+ *   pipelining
+ *
+ * Called to en/disable pipelined mode. It must be called before the decoder
+ * is started, usually from the instance init function of the subclass.
+ *
+ * In pipelined mode, the base class goes on parsing slices, tracking the DPB
+ * and building reference picture lists for the next pictures while up to
+ * @depth pictures are submitted to the subclass from a dedicated thread.
+ * Subclasses enabling it can rely on the following:
+ *
+ * - start_picture(), decode_slice() and end_picture() are called from the
+ *   submission thread, one picture at a time and in decoding order. The DPB
+ *   passed to start_picture() and the RefPicSet members of #GstH265Decoder
+ *   are snapshots taken when the picture was parsed. Their pictures are
+ *   copies sharing the user data of the original pictures.
+ * - These three methods must not take the stream lock, nor call
+ *   #GstVideoDecoder methods taking it: the streaming thread holds it while
+ *   waiting for them to return.
+ * - If one of them fails, the error is posted from the streaming thread and
+ *   the frame of the picture is dropped. The picture is still used as a
+ *   reference by the following ones.
+ * - new_sequence(), new_picture() and output_picture() are still called from
+ *   the streaming thread. new_sequence() is only called once the pictures in
+ *   flight are done, and output_picture() only once end_picture() returned
+ *   for the picture.
+ * - new_picture() may be called for up to @depth pictures ahead of the one
+ *   being submitted, so the subclass must be able to allocate that many
+ *   output buffers on top of the DPB size.
+ *
+ * Since: 1.20
+ */
+void
+gst_h265_decoder_set_pipeline_depth (GstH265Decoder * decoder, guint depth)
+{
+  g_return_if_fail (GST_IS_H265_DECODER (decoder));
+  g_return_if_fail (decoder->priv->submit_thread == NULL);
+
+  decoder->priv->pipeline_depth = depth;
 }
@@ -143,10 +143,18 @@ GST_CODECS_API
 void gst_h265_decoder_set_process_ref_pic_lists (GstH265Decoder * decoder,
                                                  gboolean process);
 
+GST_CODECS_API
+void gst_h265_decoder_set_low_latency           (GstH265Decoder * decoder,
+                                                 gboolean low_latency);
+
 GST_CODECS_API
 GstH265Picture * gst_h265_decoder_get_picture   (GstH265Decoder * decoder,
                                                  guint32 system_frame_number);
 
+GST_CODECS_API
+void gst_h265_decoder_set_pipeline_depth (GstH265Decoder * decoder,
+                                          guint depth);
+
 G_END_DECLS
 
 #endif /* __GST_H265_DECODER_H__ */
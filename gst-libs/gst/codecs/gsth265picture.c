@@ -105,13 +105,104 @@ gst_h265_picture_get_user_data (GstH265Picture * picture)
   return picture->user_data;
 }
 
+typedef struct
+{
+  GstH265Picture *picture;
+  /* Insertion order, so that pictures with identical POC are output in the
+   * order they were stored */
+  guint32 order;
+} GstH265DpbOutputEntry;
+
 struct _GstH265Dpb
 {
   GArray *pic_list;
   gint max_num_pics;
   gint num_output_needed;
+  gint32 last_output_poc;
+  gboolean low_latency;
+
+  /* Min-heap on POC of GstH265DpbOutputEntry, holding the pictures needed
+   * for output. Entries whose picture isn't needed for output anymore are
+   * dropped when they reach the top */
+  GArray *output_heap;
+  guint32 output_order;
 };
 
+static void
+gst_h265_dpb_output_entry_clear (GstH265DpbOutputEntry * entry)
+{
+  gst_h265_picture_clear (&entry->picture);
+}
+
+static inline gboolean
+gst_h265_dpb_output_entry_less (const GstH265DpbOutputEntry * a,
+    const GstH265DpbOutputEntry * b)
+{
+  if (a->picture->pic_order_cnt != b->picture->pic_order_cnt)
+    return a->picture->pic_order_cnt < b->picture->pic_order_cnt;
+
+  return (gint32) (a->order - b->order) < 0;
+}
+
+static void
+gst_h265_dpb_output_heap_push (GstH265Dpb * dpb, GstH265Picture * picture)
+{
+  GstH265DpbOutputEntry *heap;
+  GstH265DpbOutputEntry entry;
+  guint i;
+
+  entry.picture = gst_h265_picture_ref (picture);
+  entry.order = dpb->output_order++;
+
+  g_array_append_val (dpb->output_heap, entry);
+  heap = (GstH265DpbOutputEntry *) dpb->output_heap->data;
+
+  for (i = dpb->output_heap->len - 1; i > 0; i = (i - 1) / 2) {
+    guint parent = (i - 1) / 2;
+
+    if (!gst_h265_dpb_output_entry_less (&entry, &heap[parent]))
+      break;
+
+    heap[i] = heap[parent];
+  }
+
+  heap[i] = entry;
+}
+
+static void
+gst_h265_dpb_output_heap_pop (GstH265Dpb * dpb)
+{
+  GstH265DpbOutputEntry *heap;
+  GstH265DpbOutputEntry entry;
+  guint len, i;
+
+  /* Releases the top entry and moves the last one to the top */
+  g_array_remove_index_fast (dpb->output_heap, 0);
+
+  len = dpb->output_heap->len;
+  if (len < 2)
+    return;
+
+  heap = (GstH265DpbOutputEntry *) dpb->output_heap->data;
+  entry = heap[0];
+
+  for (i = 0; 2 * i + 1 < len;) {
+    guint child = 2 * i + 1;
+
+    if (child + 1 < len &&
+        gst_h265_dpb_output_entry_less (&heap[child + 1], &heap[child]))
+      child++;
+
+    if (!gst_h265_dpb_output_entry_less (&heap[child], &entry))
+      break;
+
+    heap[i] = heap[child];
+    i = child;
+  }
+
+  heap[i] = entry;
+}
+
 /**
  * gst_h265_dpb_new: (skip)
  *
@@ -132,6 +223,13 @@ gst_h265_dpb_new (void)
   g_array_set_clear_func (dpb->pic_list,
       (GDestroyNotify) gst_h265_picture_clear);
 
+  dpb->output_heap = g_array_sized_new (FALSE, TRUE,
+      sizeof (GstH265DpbOutputEntry), GST_H265_DPB_MAX_SIZE + 1);
+  g_array_set_clear_func (dpb->output_heap,
+      (GDestroyNotify) gst_h265_dpb_output_entry_clear);
+
+  dpb->last_output_poc = G_MININT32;
+
   return dpb;
 }
 
@@ -164,6 +262,25 @@ gst_h265_dpb_get_max_num_pics (GstH265Dpb * dpb)
   return dpb->max_num_pics;
 }
 
+/**
+ * gst_h265_dpb_set_low_latency:
+ * @dpb: a #GstH265Dpb
+ * @low_latency: %TRUE if low-latency bumping is required
+ *
+ * Makes gst_h265_dpb_needs_bump() also request bumping as soon as the lowest
+ * picture order count needed for output directly follows the one of the
+ * previously outputted picture
+ *
+ * Since: 1.20
+ */
+void
+gst_h265_dpb_set_low_latency (GstH265Dpb * dpb, gboolean low_latency)
+{
+  g_return_if_fail (dpb != NULL);
+
+  dpb->low_latency = low_latency;
+}
+
 /**
  * gst_h265_dpb_free:
  * @dpb: a #GstH265Dpb to free
@@ -177,6 +294,7 @@ gst_h265_dpb_free (GstH265Dpb * dpb)
 
   gst_h265_dpb_clear (dpb);
   g_array_unref (dpb->pic_list);
+  g_array_unref (dpb->output_heap);
   g_free (dpb);
 }
 
@@ -192,7 +310,10 @@ gst_h265_dpb_clear (GstH265Dpb * dpb)
   g_return_if_fail (dpb != NULL);
 
   g_array_set_size (dpb->pic_list, 0);
+  g_array_set_size (dpb->output_heap, 0);
   dpb->num_output_needed = 0;
+  dpb->last_output_poc = G_MININT32;
+  dpb->output_order = 0;
 }
 
 /**
@@ -222,6 +343,7 @@ gst_h265_dpb_add (GstH265Dpb * dpb, GstH265Picture * picture)
 
     dpb->num_output_needed++;
     picture->needed_for_output = TRUE;
+    gst_h265_dpb_output_heap_push (dpb, picture);
   } else {
     picture->needed_for_output = FALSE;
   }
@@ -230,6 +352,11 @@ gst_h265_dpb_add (GstH265Dpb * dpb, GstH265Picture * picture)
   picture->ref = TRUE;
   picture->long_term = FALSE;
 
+  /* PicOrderCntVal starts over at an IRAP with NoRaslOutputFlag, even when
+   * the prior pictures were bumped instead of cleared */
+  if (picture->RapPicFlag && picture->NoRaslOutputFlag)
+    dpb->last_output_poc = G_MININT32;
+
   g_array_append_val (dpb->pic_list, picture);
 }
 
@@ -514,6 +641,34 @@ gst_h265_dpb_check_latency_count (GstH265Dpb * dpb, guint32 max_latency)
   return FALSE;
 }
 
+static gint
+gst_h265_dpb_get_lowest_output_needed_picture (GstH265Dpb * dpb,
+    GstH265Picture ** picture)
+{
+  gint i;
+
+  *picture = NULL;
+
+  while (dpb->output_heap->len > 0) {
+    GstH265Picture *lowest =
+        g_array_index (dpb->output_heap, GstH265DpbOutputEntry, 0).picture;
+
+    if (lowest->needed_for_output) {
+      for (i = 0; i < dpb->pic_list->len; i++) {
+        if (g_array_index (dpb->pic_list, GstH265Picture *, i) == lowest) {
+          *picture = gst_h265_picture_ref (lowest);
+          return i;
+        }
+      }
+    }
+
+    /* Already outputted or not stored anymore */
+    gst_h265_dpb_output_heap_pop (dpb);
+  }
+
+  return -1;
+}
+
 /**
  * gst_h265_dpb_needs_bump:
  * @dpb: a #GstH265Dpb
@@ -554,42 +709,29 @@ gst_h265_dpb_needs_bump (GstH265Dpb * dpb, guint max_num_reorder_pics,
     return TRUE;
   }
 
-  return FALSE;
-}
-
-static gint
-gst_h265_dpb_get_lowest_output_needed_picture (GstH265Dpb * dpb,
-    GstH265Picture ** picture)
-{
-  gint i;
-  GstH265Picture *lowest = NULL;
-  gint index = -1;
-
-  *picture = NULL;
-
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH265Picture *picture =
-        g_array_index (dpb->pic_list, GstH265Picture *, i);
-
-    if (!picture->needed_for_output)
-      continue;
-
-    if (!lowest) {
-      lowest = picture;
-      index = i;
-      continue;
+  /* Output right away when no picture can be missing in between the
+   * previously outputted one and the lowest POC. Like in GstH264Dpb, this
+   * assumes PicOrderCntVal increments by one */
+  if (dpb->low_latency && dpb->num_output_needed &&
+      dpb->last_output_poc != G_MININT32) {
+    GstH265Picture *picture = NULL;
+    gint32 lowest_poc = G_MININT32;
+
+    gst_h265_dpb_get_lowest_output_needed_picture (dpb, &picture);
+    if (picture) {
+      lowest_poc = picture->pic_order_cnt;
+      gst_h265_picture_unref (picture);
     }
 
-    if (picture->pic_order_cnt < lowest->pic_order_cnt) {
-      lowest = picture;
-      index = i;
+    if (lowest_poc != G_MININT32 && lowest_poc > dpb->last_output_poc &&
+        lowest_poc - dpb->last_output_poc <= 1) {
+      GST_TRACE ("bumping for low-latency, lowest-poc: %d, last-output-poc: %d",
+          lowest_poc, dpb->last_output_poc);
+      return TRUE;
     }
   }
 
-  if (lowest)
-    *picture = gst_h265_picture_ref (lowest);
-
-  return index;
+  return FALSE;
 }
 
 /**
@@ -621,6 +763,7 @@ gst_h265_dpb_bump (GstH265Dpb * dpb, gboolean drain)
     return NULL;
 
   picture->needed_for_output = FALSE;
+  gst_h265_dpb_output_heap_pop (dpb);
 
   dpb->num_output_needed--;
   g_assert (dpb->num_output_needed >= 0);
@@ -628,5 +771,7 @@ gst_h265_dpb_bump (GstH265Dpb * dpb, gboolean drain)
   if (!picture->ref || drain)
     g_array_remove_index_fast (dpb->pic_list, index);
 
+  dpb->last_output_poc = picture->pic_order_cnt;
+
   return picture;
 }
@@ -146,6 +146,10 @@ void  gst_h265_dpb_set_max_num_pics (GstH265Dpb * dpb,
 GST_CODECS_API
 gint gst_h265_dpb_get_max_num_pics  (GstH265Dpb * dpb);
 
+GST_CODECS_API
+void  gst_h265_dpb_set_low_latency  (GstH265Dpb * dpb,
+                                     gboolean low_latency);
+
 GST_CODECS_API
 void  gst_h265_dpb_free             (GstH265Dpb * dpb);
 
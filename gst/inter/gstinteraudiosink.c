@@ -214,6 +214,7 @@ gst_inter_audio_sink_start (GstBaseSink * sink)
   gst_base_sink_set_render_delay (sink,
       interaudiosink->surface->audio_latency_time);
   g_mutex_unlock (&interaudiosink->surface->mutex);
+  gst_inter_surface_info_changed (interaudiosink->surface);
 
   return TRUE;
 }
@@ -225,10 +226,12 @@ gst_inter_audio_sink_stop (GstBaseSink * sink)
 
   GST_DEBUG_OBJECT (interaudiosink, "stop");
 
+  gst_inter_surface_clear_audio (interaudiosink->surface);
+
   g_mutex_lock (&interaudiosink->surface->mutex);
-  gst_adapter_clear (interaudiosink->surface->audio_adapter);
   memset (&interaudiosink->surface->audio_info, 0, sizeof (GstAudioInfo));
   g_mutex_unlock (&interaudiosink->surface->mutex);
+  gst_inter_surface_info_changed (interaudiosink->surface);
 
   gst_inter_surface_unref (interaudiosink->surface);
   interaudiosink->surface = NULL;
@@ -252,9 +255,10 @@ gst_inter_audio_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
   g_mutex_lock (&interaudiosink->surface->mutex);
   interaudiosink->surface->audio_info = info;
   interaudiosink->info = info;
-  /* TODO: Ideally we would drain the source here */
-  gst_adapter_clear (interaudiosink->surface->audio_adapter);
   g_mutex_unlock (&interaudiosink->surface->mutex);
+  /* TODO: Ideally we would drain the sources here, instead they skip
+   * whatever they didn't read yet */
+  gst_inter_surface_info_changed (interaudiosink->surface);
 
   return TRUE;
 }
@@ -270,10 +274,9 @@ gst_inter_audio_sink_event (GstBaseSink * sink, GstEvent * event)
       guint n;
 
       if ((n = gst_adapter_available (interaudiosink->input_adapter)) > 0) {
-        g_mutex_lock (&interaudiosink->surface->mutex);
         tmp = gst_adapter_take_buffer (interaudiosink->input_adapter, n);
-        gst_adapter_push (interaudiosink->surface->audio_adapter, tmp);
-        g_mutex_unlock (&interaudiosink->surface->mutex);
+        gst_inter_surface_push_audio (interaudiosink->surface, tmp);
+        gst_buffer_unref (tmp);
       }
       break;
     }
@@ -290,42 +293,30 @@ gst_inter_audio_sink_render (GstBaseSink * sink, GstBuffer * buffer)
   GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (sink);
   guint n, bpf;
   guint64 period_time, buffer_time;
-  guint64 period_samples, buffer_samples;
+  guint64 period_samples;
 
   GST_DEBUG_OBJECT (interaudiosink, "render %" G_GSIZE_FORMAT,
       gst_buffer_get_size (buffer));
   bpf = interaudiosink->info.bpf;
 
   g_mutex_lock (&interaudiosink->surface->mutex);
-
   buffer_time = interaudiosink->surface->audio_buffer_time;
   period_time = interaudiosink->surface->audio_period_time;
+  g_mutex_unlock (&interaudiosink->surface->mutex);
 
   if (buffer_time < period_time) {
     GST_ERROR_OBJECT (interaudiosink,
         "Buffer time smaller than period time (%" GST_TIME_FORMAT " < %"
         GST_TIME_FORMAT ")", GST_TIME_ARGS (buffer_time),
         GST_TIME_ARGS (period_time));
-    g_mutex_unlock (&interaudiosink->surface->mutex);
     return GST_FLOW_ERROR;
   }
 
-  buffer_samples =
-      gst_util_uint64_scale (buffer_time, interaudiosink->info.rate,
-      GST_SECOND);
   period_samples =
       gst_util_uint64_scale (period_time, interaudiosink->info.rate,
       GST_SECOND);
 
-  n = gst_adapter_available (interaudiosink->surface->audio_adapter) / bpf;
-  while (n > buffer_samples) {
-    GST_DEBUG_OBJECT (interaudiosink, "flushing %" GST_TIME_FORMAT,
-        GST_TIME_ARGS (period_time));
-    gst_adapter_flush (interaudiosink->surface->audio_adapter,
-        period_samples * bpf);
-    n -= period_samples;
-  }
-
+  /* Each source drops what it couldn't read within its own buffer time */
   n = gst_adapter_available (interaudiosink->input_adapter);
   if (period_samples * bpf > gst_buffer_get_size (buffer) + n) {
     gst_adapter_push (interaudiosink->input_adapter, gst_buffer_ref (buffer));
@@ -334,12 +325,11 @@ gst_inter_audio_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 
     if (n > 0) {
       tmp = gst_adapter_take_buffer (interaudiosink->input_adapter, n);
-      gst_adapter_push (interaudiosink->surface->audio_adapter, tmp);
+      gst_inter_surface_push_audio (interaudiosink->surface, tmp);
+      gst_buffer_unref (tmp);
     }
-    gst_adapter_push (interaudiosink->surface->audio_adapter,
-        gst_buffer_ref (buffer));
+    gst_inter_surface_push_audio (interaudiosink->surface, buffer);
   }
-  g_mutex_unlock (&interaudiosink->surface->mutex);
 
   return GST_FLOW_OK;
 }
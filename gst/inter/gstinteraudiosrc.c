@@ -77,7 +77,9 @@ enum
   PROP_CHANNEL,
   PROP_BUFFER_TIME,
   PROP_LATENCY_TIME,
-  PROP_PERIOD_TIME
+  PROP_PERIOD_TIME,
+  PROP_DROPPED,
+  PROP_LAG
 };
 
 #define DEFAULT_CHANNEL ("default")
@@ -148,6 +150,33 @@ gst_inter_audio_src_class_init (GstInterAudioSrcClass * klass)
           "The minimum amount of data to read in each iteration",
           1, G_MAXUINT64, DEFAULT_AUDIO_PERIOD_TIME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterAudioSrc:dropped:
+   *
+   * Number of samples written by the interaudiosink that this source
+   * discarded, because it fell more than #GstInterAudioSrc:buffer-time
+   * behind the sink.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_DROPPED,
+      g_param_spec_uint64 ("dropped", "Dropped",
+          "Number of samples from the sink that were discarded", 0,
+          G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterAudioSrc:lag:
+   *
+   * Amount of audio written by the interaudiosink that this source did not
+   * output yet.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_LAG,
+      g_param_spec_uint64 ("lag", "Lag",
+          "Amount of audio from the sink not output yet (in nanoseconds)", 0,
+          G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -161,6 +190,7 @@ gst_inter_audio_src_init (GstInterAudioSrc * interaudiosrc)
   interaudiosrc->buffer_time = DEFAULT_AUDIO_BUFFER_TIME;
   interaudiosrc->latency_time = DEFAULT_AUDIO_LATENCY_TIME;
   interaudiosrc->period_time = DEFAULT_AUDIO_PERIOD_TIME;
+  interaudiosrc->adapter = gst_adapter_new ();
 }
 
 void
@@ -208,6 +238,16 @@ gst_inter_audio_src_get_property (GObject * object, guint property_id,
     case PROP_PERIOD_TIME:
       g_value_set_uint64 (value, interaudiosrc->period_time);
       break;
+    case PROP_DROPPED:
+      GST_OBJECT_LOCK (interaudiosrc);
+      g_value_set_uint64 (value, interaudiosrc->dropped);
+      GST_OBJECT_UNLOCK (interaudiosrc);
+      break;
+    case PROP_LAG:
+      GST_OBJECT_LOCK (interaudiosrc);
+      g_value_set_uint64 (value, interaudiosrc->lag);
+      GST_OBJECT_UNLOCK (interaudiosrc);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -221,6 +261,7 @@ gst_inter_audio_src_finalize (GObject * object)
 
   /* clean up object here */
   g_free (interaudiosrc->channel);
+  g_object_unref (interaudiosrc->adapter);
 
   G_OBJECT_CLASS (gst_inter_audio_src_parent_class)->finalize (object);
 }
@@ -287,8 +328,16 @@ gst_inter_audio_src_start (GstBaseSrc * src)
   interaudiosrc->surface->audio_buffer_time = interaudiosrc->buffer_time;
   interaudiosrc->surface->audio_latency_time = interaudiosrc->latency_time;
   interaudiosrc->surface->audio_period_time = interaudiosrc->period_time;
+  interaudiosrc->surface_info = interaudiosrc->surface->audio_info;
   g_mutex_unlock (&interaudiosrc->surface->mutex);
 
+  interaudiosrc->reader = gst_inter_surface_reader_new (interaudiosrc->surface);
+
+  GST_OBJECT_LOCK (interaudiosrc);
+  interaudiosrc->dropped = 0;
+  interaudiosrc->lag = 0;
+  GST_OBJECT_UNLOCK (interaudiosrc);
+
   return TRUE;
 }
 
@@ -299,6 +348,9 @@ gst_inter_audio_src_stop (GstBaseSrc * src)
 
   GST_DEBUG_OBJECT (interaudiosrc, "stop");
 
+  gst_inter_surface_reader_free (interaudiosrc->reader);
+  interaudiosrc->reader = NULL;
+  gst_adapter_clear (interaudiosrc->adapter);
   gst_inter_surface_unref (interaudiosrc->surface);
   interaudiosrc->surface = NULL;
 
@@ -336,21 +388,28 @@ gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
 {
   GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (src);
   GstCaps *caps;
-  GstBuffer *buffer;
+  GstBuffer *buffer, *tmp;
   guint n, bpf;
-  guint64 period_time;
-  guint64 period_samples;
+  guint64 period_samples, buffer_samples;
+  guint64 dropped, lag;
 
   GST_DEBUG_OBJECT (interaudiosrc, "create");
 
   buffer = NULL;
   caps = NULL;
 
-  g_mutex_lock (&interaudiosrc->surface->mutex);
-  if (interaudiosrc->surface->audio_info.finfo) {
-    if (!gst_audio_info_is_equal (&interaudiosrc->surface->audio_info,
+  /* Only take the surface mutex when the sink changed its caps */
+  if (gst_inter_surface_reader_info_changed (interaudiosrc->reader)) {
+    g_mutex_lock (&interaudiosrc->surface->mutex);
+    interaudiosrc->surface_info = interaudiosrc->surface->audio_info;
+    g_mutex_unlock (&interaudiosrc->surface->mutex);
+    gst_adapter_clear (interaudiosrc->adapter);
+  }
+
+  if (interaudiosrc->surface_info.finfo) {
+    if (!gst_audio_info_is_equal (&interaudiosrc->surface_info,
             &interaudiosrc->info)) {
-      caps = gst_audio_info_to_caps (&interaudiosrc->surface->audio_info);
+      caps = gst_audio_info_to_caps (&interaudiosrc->surface_info);
       interaudiosrc->timestamp_offset +=
           gst_util_uint64_scale (interaudiosrc->n_samples, GST_SECOND,
           interaudiosrc->info.rate);
@@ -358,26 +417,64 @@ gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
     }
   }
 
-  bpf = interaudiosrc->surface->audio_info.bpf;
-  period_time = interaudiosrc->surface->audio_period_time;
-  period_samples =
-      gst_util_uint64_scale (period_time, interaudiosrc->info.rate, GST_SECOND);
+  dropped = 0;
+  while ((tmp = gst_inter_surface_reader_pull_audio (interaudiosrc->reader,
+              &dropped)))
+    gst_adapter_push (interaudiosrc->adapter, tmp);
 
-  if (bpf > 0)
-    n = gst_adapter_available (interaudiosrc->surface->audio_adapter) / bpf;
-  else
+  bpf = interaudiosrc->surface_info.bpf;
+  period_samples =
+      gst_util_uint64_scale (interaudiosrc->period_time,
+      interaudiosrc->info.rate, GST_SECOND);
+
+  if (bpf > 0) {
+    guint64 flush_samples;
+
+    dropped /= bpf;
+
+    /* Don't fall more than buffer-time behind the sink */
+    buffer_samples =
+        gst_util_uint64_scale (interaudiosrc->buffer_time,
+        interaudiosrc->surface_info.rate, GST_SECOND);
+    flush_samples =
+        gst_util_uint64_scale (interaudiosrc->period_time,
+        interaudiosrc->surface_info.rate, GST_SECOND);
+    n = gst_adapter_available (interaudiosrc->adapter) / bpf;
+    while (n > buffer_samples && flush_samples > 0) {
+      GST_DEBUG_OBJECT (interaudiosrc, "flushing %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (interaudiosrc->period_time));
+      flush_samples = MIN (flush_samples, n);
+      gst_adapter_flush (interaudiosrc->adapter, flush_samples * bpf);
+      dropped += flush_samples;
+      n -= flush_samples;
+    }
+  } else {
     n = 0;
+  }
 
   if (n > period_samples)
     n = period_samples;
   if (n > 0) {
-    buffer = gst_adapter_take_buffer (interaudiosrc->surface->audio_adapter,
-        n * bpf);
+    buffer = gst_adapter_take_buffer (interaudiosrc->adapter, n * bpf);
   } else {
     buffer = gst_buffer_new ();
     GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
   }
-  g_mutex_unlock (&interaudiosrc->surface->mutex);
+
+  if (bpf > 0)
+    lag = gst_util_uint64_scale (gst_adapter_available (interaudiosrc->adapter)
+        / bpf, GST_SECOND, interaudiosrc->surface_info.rate);
+  else
+    lag = 0;
+
+  if (dropped)
+    GST_LOG_OBJECT (interaudiosrc, "%" G_GUINT64_FORMAT " samples dropped",
+        dropped);
+
+  GST_OBJECT_LOCK (interaudiosrc);
+  interaudiosrc->dropped += dropped;
+  interaudiosrc->lag = lag;
+  GST_OBJECT_UNLOCK (interaudiosrc);
 
   if (caps) {
     gboolean ret = gst_base_src_set_caps (src, caps);
@@ -40,8 +40,15 @@ struct _GstInterAudioSrc
   GstBaseSrc base_interaudiosrc;
 
   GstInterSurface *surface;
+  GstInterSurfaceReader *reader;
   char *channel;
 
+  /* audio read from the surface but not output yet */
+  GstAdapter *adapter;
+  GstAudioInfo surface_info;
+  guint64 dropped;
+  GstClockTime lag;
+
   guint64 n_samples;
   GstClockTime timestamp_offset;
   GstAudioInfo info;
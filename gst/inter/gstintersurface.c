@@ -25,9 +25,107 @@
 
 #include "gstintersurface.h"
 
+/* The video frame and audio buffers are published by the sinks as
+ * immutable items in atomic slots, and read by any number of sources without
+ * taking the surface mutex. Each source reader announces the item it is
+ * about to read in its hazard pointer before re-checking the slot, and
+ * replaced items are only freed once no reader hazard points to them.
+ *
+ * Only the readers are lock-free: the sinks take the mutex for every item
+ * they publish, which serializes several sinks writing to the same channel
+ * (the last one wins) and protects the list of retired items. The mutex is
+ * also taken when (un)registering readers or when the caps change. */
+
 static GList *list;
 static GMutex mutex;
 
+static void
+gst_inter_surface_item_free (GstInterSurfaceItem * item)
+{
+  if (item == NULL)
+    return;
+
+  if (item->buffer)
+    gst_buffer_unref (item->buffer);
+  g_free (item);
+}
+
+static gboolean
+gst_inter_surface_item_in_use (GstInterSurface * surface,
+    GstInterSurfaceItem * item)
+{
+  GList *g;
+
+  for (g = surface->readers; g; g = g_list_next (g)) {
+    GstInterSurfaceReader *reader = g->data;
+
+    if (g_atomic_pointer_get (&reader->hazard) == item)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* Called by the writer after @item was replaced in its slot. Frees it, and
+ * any previously retired item, unless it is still being read. Must be
+ * called with the surface mutex held */
+static void
+gst_inter_surface_retire (GstInterSurface * surface, GstInterSurfaceItem * item)
+{
+  guint i;
+
+  if (item)
+    g_ptr_array_add (surface->retired, item);
+
+  for (i = 0; i < surface->retired->len;) {
+    GstInterSurfaceItem *tmp = g_ptr_array_index (surface->retired, i);
+
+    if (gst_inter_surface_item_in_use (surface, tmp)) {
+      i++;
+    } else {
+      g_ptr_array_remove_index_fast (surface->retired, i);
+      gst_inter_surface_item_free (tmp);
+    }
+  }
+}
+
+/* Replaces the item in @slot. Must be called with the surface mutex held, so
+ * that the replaced item is only retired once */
+static void
+gst_inter_surface_publish (GstInterSurface * surface, gpointer * slot,
+    GstInterSurfaceItem * item)
+{
+  GstInterSurfaceItem *old;
+
+  old = g_atomic_pointer_get (slot);
+  g_atomic_pointer_set (slot, item);
+
+  if (old)
+    gst_inter_surface_retire (surface, old);
+}
+
+/* Reads the item in @slot and protects it from being freed until
+ * gst_inter_surface_reader_release() is called */
+static GstInterSurfaceItem *
+gst_inter_surface_reader_acquire (GstInterSurfaceReader * reader,
+    gpointer * slot)
+{
+  GstInterSurfaceItem *item;
+
+  do {
+    item = g_atomic_pointer_get (slot);
+    g_atomic_pointer_set (&reader->hazard, item);
+  } while (g_atomic_pointer_get (slot) != item);
+
+  return item;
+}
+
+static void
+gst_inter_surface_reader_release (GstInterSurfaceReader * reader)
+{
+  g_atomic_pointer_set (&reader->hazard, NULL);
+}
+
 GstInterSurface *
 gst_inter_surface_get (const char *name)
 {
@@ -48,7 +146,7 @@ gst_inter_surface_get (const char *name)
   surface->ref_count = 1;
   surface->name = g_strdup (name);
   g_mutex_init (&surface->mutex);
-  surface->audio_adapter = gst_adapter_new ();
+  surface->retired = g_ptr_array_new ();
   surface->audio_buffer_time = DEFAULT_AUDIO_BUFFER_TIME;
   surface->audio_latency_time = DEFAULT_AUDIO_LATENCY_TIME;
   surface->audio_period_time = DEFAULT_AUDIO_PERIOD_TIME;
@@ -68,6 +166,7 @@ gst_inter_surface_unref (GstInterSurface * surface)
   g_mutex_lock (&mutex);
   if ((--surface->ref_count) == 0) {
     GList *g;
+    guint i;
 
     for (g = list; g; g = g_list_next (g)) {
       GstInterSurface *tmp = g->data;
@@ -77,12 +176,221 @@ gst_inter_surface_unref (GstInterSurface * surface)
       }
     }
 
+    g_assert (surface->readers == NULL);
+
     g_mutex_clear (&surface->mutex);
-    gst_buffer_replace (&surface->video_buffer, NULL);
+    gst_inter_surface_item_free (surface->video_item);
+    for (i = 0; i < GST_INTER_SURFACE_AUDIO_RING_SIZE; i++)
+      gst_inter_surface_item_free (surface->audio_ring[i]);
+    g_ptr_array_foreach (surface->retired, (GFunc) gst_inter_surface_item_free,
+        NULL);
+    g_ptr_array_free (surface->retired, TRUE);
     gst_buffer_replace (&surface->sub_buffer, NULL);
-    gst_object_unref (surface->audio_adapter);
     g_free (surface->name);
     g_free (surface);
   }
   g_mutex_unlock (&mutex);
 }
+
+/* Must be called by the sinks after changing the video or audio info */
+void
+gst_inter_surface_info_changed (GstInterSurface * surface)
+{
+  g_atomic_int_inc (&surface->info_cookie);
+}
+
+/* Publishes a new video frame, or no frame at all if @buffer is NULL */
+void
+gst_inter_surface_push_video (GstInterSurface * surface, GstBuffer * buffer)
+{
+  GstInterSurfaceItem *item;
+
+  item = g_new (GstInterSurfaceItem, 1);
+  item->buffer = buffer ? gst_buffer_ref (buffer) : NULL;
+
+  g_mutex_lock (&surface->mutex);
+  item->seqnum = ++surface->video_seqnum;
+  gst_inter_surface_publish (surface, (gpointer *) & surface->video_item, item);
+  g_mutex_unlock (&surface->mutex);
+}
+
+/* Appends an audio buffer to the ring, overwriting the oldest one */
+void
+gst_inter_surface_push_audio (GstInterSurface * surface, GstBuffer * buffer)
+{
+  GstInterSurfaceItem *item;
+  guint index;
+
+  item = g_new (GstInterSurfaceItem, 1);
+  item->buffer = gst_buffer_ref (buffer);
+
+  g_mutex_lock (&surface->mutex);
+  item->seqnum = surface->audio_written;
+  item->offset = surface->audio_offset;
+  surface->audio_offset += gst_buffer_get_size (buffer);
+
+  index = item->seqnum % GST_INTER_SURFACE_AUDIO_RING_SIZE;
+  gst_inter_surface_publish (surface,
+      (gpointer *) & surface->audio_ring[index], item);
+  g_atomic_int_inc (&surface->audio_written);
+  g_mutex_unlock (&surface->mutex);
+}
+
+/* Drops all audio buffers that weren't read yet */
+void
+gst_inter_surface_clear_audio (GstInterSurface * surface)
+{
+  guint i;
+
+  g_mutex_lock (&surface->mutex);
+  for (i = 0; i < GST_INTER_SURFACE_AUDIO_RING_SIZE; i++)
+    gst_inter_surface_publish (surface, (gpointer *) & surface->audio_ring[i],
+        NULL);
+  g_mutex_unlock (&surface->mutex);
+}
+
+GstInterSurfaceReader *
+gst_inter_surface_reader_new (GstInterSurface * surface)
+{
+  GstInterSurfaceReader *reader;
+
+  reader = g_new0 (GstInterSurfaceReader, 1);
+  reader->surface = surface;
+
+  g_mutex_lock (&surface->mutex);
+  surface->readers = g_list_prepend (surface->readers, reader);
+  g_mutex_unlock (&surface->mutex);
+
+  /* Start reading from the most recent data */
+  reader->info_cookie = g_atomic_int_get (&surface->info_cookie);
+  reader->audio_seqnum = g_atomic_int_get (&surface->audio_written);
+  reader->audio_offset = GST_BUFFER_OFFSET_NONE;
+
+  return reader;
+}
+
+void
+gst_inter_surface_reader_free (GstInterSurfaceReader * reader)
+{
+  GstInterSurface *surface = reader->surface;
+
+  g_mutex_lock (&surface->mutex);
+  surface->readers = g_list_remove (surface->readers, reader);
+  g_mutex_unlock (&surface->mutex);
+
+  g_free (reader);
+}
+
+/* Returns TRUE if the video or audio info of the surface changed since the
+ * last call. The new info can then be read with the surface mutex held. Any
+ * audio written before the change is skipped */
+gboolean
+gst_inter_surface_reader_info_changed (GstInterSurfaceReader * reader)
+{
+  GstInterSurface *surface = reader->surface;
+  gint cookie;
+
+  cookie = g_atomic_int_get (&surface->info_cookie);
+  if (cookie == reader->info_cookie)
+    return FALSE;
+
+  reader->info_cookie = cookie;
+  reader->audio_seqnum = g_atomic_int_get (&surface->audio_written);
+  reader->audio_offset = GST_BUFFER_OFFSET_NONE;
+
+  return TRUE;
+}
+
+/* Returns TRUE and the most recent video frame in @buffer if it changed since
+ * the last call. @buffer is set to NULL if the writer stopped. @dropped is
+ * increased by the number of frames that were never read */
+gboolean
+gst_inter_surface_reader_pull_video (GstInterSurfaceReader * reader,
+    GstBuffer ** buffer, guint64 * dropped)
+{
+  GstInterSurface *surface = reader->surface;
+  GstInterSurfaceItem *item;
+  gboolean ret = FALSE;
+
+  item = gst_inter_surface_reader_acquire (reader,
+      (gpointer *) & surface->video_item);
+  if (item && item->seqnum != reader->video_seqnum) {
+    if (dropped && reader->video_seqnum != 0)
+      *dropped += item->seqnum - reader->video_seqnum - 1;
+
+    reader->video_seqnum = item->seqnum;
+    *buffer = item->buffer ? gst_buffer_ref (item->buffer) : NULL;
+    ret = TRUE;
+  }
+  gst_inter_surface_reader_release (reader);
+
+  return ret;
+}
+
+/* Returns the number of audio buffers written but not read yet */
+static guint
+gst_inter_surface_reader_audio_pending (GstInterSurfaceReader * reader)
+{
+  guint written;
+
+  written = (guint) g_atomic_int_get (&reader->surface->audio_written);
+
+  return written - reader->audio_seqnum;
+}
+
+/* Returns the next audio buffer, or NULL if the reader caught up with the
+ * writer. @dropped is increased by the number of bytes that were
+ * overwritten before they could be read */
+GstBuffer *
+gst_inter_surface_reader_pull_audio (GstInterSurfaceReader * reader,
+    guint64 * dropped)
+{
+  GstInterSurface *surface = reader->surface;
+  GstInterSurfaceItem *item;
+  GstBuffer *buffer = NULL;
+  guint lag;
+  gint diff;
+
+  while (TRUE) {
+    lag = gst_inter_surface_reader_audio_pending (reader);
+    if (lag == 0)
+      return NULL;
+
+    /* Skip what the writer already overwrote */
+    if (lag > GST_INTER_SURFACE_AUDIO_RING_SIZE)
+      reader->audio_seqnum += lag - GST_INTER_SURFACE_AUDIO_RING_SIZE;
+
+    item = gst_inter_surface_reader_acquire (reader,
+        (gpointer *) & surface->audio_ring[reader->audio_seqnum %
+            GST_INTER_SURFACE_AUDIO_RING_SIZE]);
+
+    if (item == NULL) {
+      /* Cleared by the writer */
+      gst_inter_surface_reader_release (reader);
+      reader->audio_seqnum++;
+      reader->audio_offset = GST_BUFFER_OFFSET_NONE;
+      continue;
+    }
+
+    diff = (gint) (item->seqnum - reader->audio_seqnum);
+    if (diff < 0) {
+      /* Not written yet */
+      gst_inter_surface_reader_release (reader);
+      return NULL;
+    }
+
+    if (diff == 0) {
+      buffer = gst_buffer_ref (item->buffer);
+      if (dropped && reader->audio_offset != GST_BUFFER_OFFSET_NONE &&
+          item->offset > reader->audio_offset)
+        *dropped += item->offset - reader->audio_offset;
+      reader->audio_offset = item->offset + gst_buffer_get_size (buffer);
+      gst_inter_surface_reader_release (reader);
+      reader->audio_seqnum++;
+      return buffer;
+    }
+
+    /* Overwritten while we were looking, try again */
+    gst_inter_surface_reader_release (reader);
+  }
+}
@@ -27,6 +27,11 @@
 G_BEGIN_DECLS
 
 typedef struct _GstInterSurface GstInterSurface;
+typedef struct _GstInterSurfaceItem GstInterSurfaceItem;
+typedef struct _GstInterSurfaceReader GstInterSurfaceReader;
+
+/* Number of audio buffers kept around for the readers */
+#define GST_INTER_SURFACE_AUDIO_RING_SIZE 64
 
 struct _GstInterSurface
 {
@@ -37,7 +42,6 @@ struct _GstInterSurface
 
   /* video */
   GstVideoInfo video_info;
-  int video_buffer_count;
 
   /* audio */
   GstAudioInfo audio_info;
@@ -45,9 +49,45 @@ struct _GstInterSurface
   guint64 audio_latency_time;
   guint64 audio_period_time;
 
-  GstBuffer *video_buffer;
   GstBuffer *sub_buffer;
-  GstAdapter *audio_adapter;
+
+  /* Incremented whenever video_info or audio_info change (ATOMIC) */
+  gint info_cookie;
+
+  /* Published video frame and audio buffers (ATOMIC). These are written by
+   * the sinks with the mutex held, and read by the sources without taking
+   * the mutex */
+  GstInterSurfaceItem *video_item;
+  GstInterSurfaceItem *audio_ring[GST_INTER_SURFACE_AUDIO_RING_SIZE];
+  guint video_seqnum;           /* protected by mutex */
+  gint audio_written;           /* ATOMIC, number of audio buffers pushed */
+  guint64 audio_offset;         /* protected by mutex */
+
+  /* protected by mutex */
+  GList *readers;
+  GPtrArray *retired;
+};
+
+struct _GstInterSurfaceItem
+{
+  GstBuffer *buffer;
+  guint seqnum;
+  guint64 offset;               /* audio only, bytes written before */
+};
+
+/* A source reading from a surface. Each reader has its own position in the
+ * published data, and must only be used from a single thread */
+struct _GstInterSurfaceReader
+{
+  GstInterSurface *surface;
+
+  /* item being read, keeps it from being freed (ATOMIC) */
+  gpointer hazard;
+
+  gint info_cookie;
+  guint video_seqnum;           /* last video frame read */
+  guint audio_seqnum;           /* next audio buffer to read */
+  guint64 audio_offset;         /* expected offset of the next buffer */
 };
 
 #define DEFAULT_AUDIO_BUFFER_TIME  (GST_SECOND)
@@ -58,6 +98,23 @@ struct _GstInterSurface
 GstInterSurface * gst_inter_surface_get (const char *name);
 void gst_inter_surface_unref (GstInterSurface *surface);
 
+void gst_inter_surface_info_changed (GstInterSurface *surface);
+
+void gst_inter_surface_push_video (GstInterSurface *surface, GstBuffer *buffer);
+void gst_inter_surface_push_audio (GstInterSurface *surface, GstBuffer *buffer);
+void gst_inter_surface_clear_audio (GstInterSurface *surface);
+
+GstInterSurfaceReader * gst_inter_surface_reader_new (GstInterSurface *surface);
+void gst_inter_surface_reader_free (GstInterSurfaceReader *reader);
+
+gboolean gst_inter_surface_reader_info_changed (GstInterSurfaceReader *reader);
+
+gboolean gst_inter_surface_reader_pull_video (GstInterSurfaceReader *reader,
+                                              GstBuffer **buffer,
+                                              guint64 *dropped);
+GstBuffer * gst_inter_surface_reader_pull_audio (GstInterSurfaceReader *reader,
+                                                 guint64 *dropped);
+
 
 G_END_DECLS
 
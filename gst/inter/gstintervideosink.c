@@ -200,6 +200,7 @@ gst_inter_video_sink_start (GstBaseSink * sink)
   g_mutex_lock (&intervideosink->surface->mutex);
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
   g_mutex_unlock (&intervideosink->surface->mutex);
+  gst_inter_surface_info_changed (intervideosink->surface);
 
   return TRUE;
 }
@@ -209,13 +210,12 @@ gst_inter_video_sink_stop (GstBaseSink * sink)
 {
   GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
 
+  gst_inter_surface_push_video (intervideosink->surface, NULL);
+
   g_mutex_lock (&intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
-  }
-  intervideosink->surface->video_buffer = NULL;
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
   g_mutex_unlock (&intervideosink->surface->mutex);
+  gst_inter_surface_info_changed (intervideosink->surface);
 
   gst_inter_surface_unref (intervideosink->surface);
   intervideosink->surface = NULL;
@@ -238,6 +238,7 @@ gst_inter_video_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
   intervideosink->surface->video_info = info;
   intervideosink->info = info;
   g_mutex_unlock (&intervideosink->surface->mutex);
+  gst_inter_surface_info_changed (intervideosink->surface);
 
   return TRUE;
 }
@@ -250,13 +251,7 @@ gst_inter_video_sink_show_frame (GstVideoSink * sink, GstBuffer * buffer)
   GST_DEBUG_OBJECT (intervideosink, "render ts %" GST_TIME_FORMAT,
       GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
 
-  g_mutex_lock (&intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
-  }
-  intervideosink->surface->video_buffer = gst_buffer_ref (buffer);
-  intervideosink->surface->video_buffer_count = 0;
-  g_mutex_unlock (&intervideosink->surface->mutex);
+  gst_inter_surface_push_video (intervideosink->surface, buffer);
 
   return GST_FLOW_OK;
 }
@@ -71,7 +71,8 @@ enum
 {
   PROP_0,
   PROP_CHANNEL,
-  PROP_TIMEOUT
+  PROP_TIMEOUT,
+  PROP_DROPPED
 };
 
 #define DEFAULT_CHANNEL ("default")
@@ -130,6 +131,19 @@ gst_inter_video_src_class_init (GstInterVideoSrcClass * klass)
           "Timeout after which to start outputting black frames",
           0, G_MAXUINT64, DEFAULT_TIMEOUT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterVideoSrc:dropped:
+   *
+   * Number of frames published by the intervideosink that this source
+   * never read, because it was reading slower than the sink was writing.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_DROPPED,
+      g_param_spec_uint64 ("dropped", "Dropped",
+          "Number of frames from the sink that were never read", 0,
+          G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -175,6 +189,11 @@ gst_inter_video_src_get_property (GObject * object, guint property_id,
     case PROP_TIMEOUT:
       g_value_set_uint64 (value, intervideosrc->timeout);
       break;
+    case PROP_DROPPED:
+      GST_OBJECT_LOCK (intervideosrc);
+      g_value_set_uint64 (value, intervideosrc->dropped);
+      GST_OBJECT_UNLOCK (intervideosrc);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -274,8 +293,18 @@ gst_inter_video_src_start (GstBaseSrc * src)
   GST_DEBUG_OBJECT (intervideosrc, "start");
 
   intervideosrc->surface = gst_inter_surface_get (intervideosrc->channel);
+  intervideosrc->reader = gst_inter_surface_reader_new (intervideosrc->surface);
   intervideosrc->timestamp_offset = 0;
   intervideosrc->n_frames = 0;
+  intervideosrc->video_buffer_count = 0;
+
+  g_mutex_lock (&intervideosrc->surface->mutex);
+  intervideosrc->surface_info = intervideosrc->surface->video_info;
+  g_mutex_unlock (&intervideosrc->surface->mutex);
+
+  GST_OBJECT_LOCK (intervideosrc);
+  intervideosrc->dropped = 0;
+  GST_OBJECT_UNLOCK (intervideosrc);
 
   return TRUE;
 }
@@ -287,6 +316,9 @@ gst_inter_video_src_stop (GstBaseSrc * src)
 
   GST_DEBUG_OBJECT (intervideosrc, "stop");
 
+  gst_inter_surface_reader_free (intervideosrc->reader);
+  intervideosrc->reader = NULL;
+  gst_buffer_replace (&intervideosrc->video_buffer, NULL);
   gst_inter_surface_unref (intervideosrc->surface);
   intervideosrc->surface = NULL;
   gst_buffer_replace (&intervideosrc->black_frame, NULL);
@@ -326,7 +358,7 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
   GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (src);
   GstCaps *caps;
   GstBuffer *buffer;
-  guint64 frames;
+  guint64 frames, dropped;
   gboolean is_gap = FALSE;
 
   GST_DEBUG_OBJECT (intervideosrc, "create");
@@ -338,9 +370,15 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
       GST_VIDEO_INFO_FPS_N (&intervideosrc->info),
       GST_VIDEO_INFO_FPS_D (&intervideosrc->info) * GST_SECOND);
 
-  g_mutex_lock (&intervideosrc->surface->mutex);
-  if (intervideosrc->surface->video_info.finfo) {
-    GstVideoInfo tmp_info = intervideosrc->surface->video_info;
+  /* Only take the surface mutex when the sink changed its caps */
+  if (gst_inter_surface_reader_info_changed (intervideosrc->reader)) {
+    g_mutex_lock (&intervideosrc->surface->mutex);
+    intervideosrc->surface_info = intervideosrc->surface->video_info;
+    g_mutex_unlock (&intervideosrc->surface->mutex);
+  }
+
+  if (intervideosrc->surface_info.finfo) {
+    GstVideoInfo tmp_info = intervideosrc->surface_info;
 
     /* We negotiate the framerate ourselves */
     tmp_info.fps_n = intervideosrc->info.fps_n;
@@ -360,25 +398,41 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
     }
   }
 
-  if (intervideosrc->surface->video_buffer) {
+  dropped = 0;
+  if (gst_inter_surface_reader_pull_video (intervideosrc->reader, &buffer,
+          &dropped)) {
+    /* A new frame, or NULL if the sink stopped */
+    gst_buffer_replace (&intervideosrc->video_buffer, NULL);
+    intervideosrc->video_buffer = buffer;
+    if (buffer)
+      intervideosrc->video_buffer_count = 0;
+    buffer = NULL;
+  }
+
+  if (dropped) {
+    GST_LOG_OBJECT (intervideosrc, "%" G_GUINT64_FORMAT " frames dropped",
+        dropped);
+    GST_OBJECT_LOCK (intervideosrc);
+    intervideosrc->dropped += dropped;
+    GST_OBJECT_UNLOCK (intervideosrc);
+  }
+
+  if (intervideosrc->video_buffer) {
     /* We have a buffer to push */
-    buffer = gst_buffer_ref (intervideosrc->surface->video_buffer);
+    buffer = gst_buffer_ref (intervideosrc->video_buffer);
 
     /* Can only be true if timeout > 0 */
-    if (intervideosrc->surface->video_buffer_count == frames) {
-      gst_buffer_unref (intervideosrc->surface->video_buffer);
-      intervideosrc->surface->video_buffer = NULL;
-    }
+    if (intervideosrc->video_buffer_count == frames)
+      gst_buffer_replace (&intervideosrc->video_buffer, NULL);
   }
 
-  if (intervideosrc->surface->video_buffer_count != 0 &&
-      intervideosrc->surface->video_buffer_count != (frames + 1)) {
+  if (intervideosrc->video_buffer_count != 0 &&
+      intervideosrc->video_buffer_count != (frames + 1)) {
     /* This is a repeat of the stored buffer or of a black frame */
     is_gap = TRUE;
   }
 
-  intervideosrc->surface->video_buffer_count++;
-  g_mutex_unlock (&intervideosrc->surface->mutex);
+  intervideosrc->video_buffer_count++;
 
   if (caps) {
     gboolean ret;
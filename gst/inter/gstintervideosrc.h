@@ -40,10 +40,17 @@ struct _GstInterVideoSrc
   GstBaseSrc base_intervideosrc;
 
   GstInterSurface *surface;
+  GstInterSurfaceReader *reader;
 
   char *channel;
   guint64 timeout;
 
+  /* last frame read from the surface, and number of times it was output */
+  GstBuffer *video_buffer;
+  guint64 video_buffer_count;
+  GstVideoInfo surface_info;
+  guint64 dropped;
+
   GstVideoInfo info;
   GstBuffer *black_frame;
   int n_frames;
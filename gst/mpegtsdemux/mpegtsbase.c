@@ -224,6 +224,14 @@ mpegts_base_reset (MpegTSBase * base)
   /* ATSC */
   MPEGTS_BIT_SET (base->known_psi, 0x1ffb);
 
+  /* If the subclass doesn't look at packets on PIDs we don't handle, let the
+   * packetizer skip over them without parsing them */
+  mpegts_packetizer_clear_pid_filters (base->packetizer);
+  if (!base->push_unknown && !klass->inspect_packet) {
+    mpegts_packetizer_add_pid_filter (base->packetizer, base->is_pes);
+    mpegts_packetizer_add_pid_filter (base->packetizer, base->known_psi);
+  }
+
   if (base->pat) {
     g_ptr_array_unref (base->pat);
     base->pat = NULL;
@@ -0,0 +1,418 @@
+/*
+ * mpegtsindex.c : On-disk PCR/keyframe index for MPEG transport streams
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * The index is a sidecar file storing, for a given transport stream file,
+ * the byte offset of PCR observations and of keyframes (PES packets
+ * starting with the random_access_indicator set) along with the
+ * corresponding running time as computed by tsdemux.
+ *
+ * File layout (all values little-endian):
+ *
+ *   header:  "TSIX" magic (4 bytes), version (4 bytes), reserved (8 bytes)
+ *   entries: timestamp (8 bytes), offset (8 bytes), pid (2 bytes),
+ *            type (1 byte), reserved (5 bytes)
+ *
+ * Entries are only ever appended to the file, in the order in which the
+ * stream was demuxed. After seeking this isn't the order of the offsets, so
+ * the tables used for lookups keep the positions of the entries sorted by
+ * offset for each type and PID. On opening an existing index the file is
+ * memory-mapped and new entries (from parts of the stream that weren't
+ * indexed yet) are appended to it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include "mpegtsindex.h"
+
+GST_DEBUG_CATEGORY_STATIC (mpegts_index_debug);
+#define GST_CAT_DEFAULT mpegts_index_debug
+
+#define INDEX_MAGIC "TSIX"
+#define INDEX_VERSION 1
+#define INDEX_HEADER_SIZE 16
+#define INDEX_ENTRY_SIZE 24
+
+/* Number of entries after which pending writes are flushed to disk */
+#define INDEX_SYNC_INTERVAL 64
+
+#define INDEX_KEY(type, pid) GUINT_TO_POINTER (((type) << 16) | (pid))
+
+typedef struct
+{
+  GstClockTime ts;
+  guint64 offset;
+  guint16 pid;
+  guint8 type;
+} MpegTSIndexEntry;
+
+struct _MpegTSIndex
+{
+  gchar *location;
+
+  /* Entries read from disk when opening */
+  GMappedFile *mapped;
+  const guint8 *mapped_entries;
+  guint n_mapped;
+
+  /* Entries added since opening */
+  GArray *entries;
+
+  /* Positions of the entries sorted by offset, per type and PID (GArray of
+   * guint) */
+  GHashTable *positions;
+
+  FILE *file;
+  guint unsynced;
+};
+
+static void
+mpegts_index_get_entry (MpegTSIndex * index, guint pos,
+    MpegTSIndexEntry * entry)
+{
+  const guint8 *data;
+
+  if (pos >= index->n_mapped) {
+    *entry = g_array_index (index->entries, MpegTSIndexEntry,
+        pos - index->n_mapped);
+    return;
+  }
+
+  data = index->mapped_entries + pos * INDEX_ENTRY_SIZE;
+  entry->ts = GST_READ_UINT64_LE (data);
+  entry->offset = GST_READ_UINT64_LE (data + 8);
+  entry->pid = GST_READ_UINT16_LE (data + 16);
+  entry->type = data[18];
+}
+
+static GArray *
+mpegts_index_get_positions (MpegTSIndex * index, MpegTSIndexEntryType type,
+    guint16 pid, gboolean create)
+{
+  GArray *positions;
+
+  positions = g_hash_table_lookup (index->positions, INDEX_KEY (type, pid));
+  if (positions == NULL && create) {
+    positions = g_array_new (FALSE, FALSE, sizeof (guint));
+    g_hash_table_insert (index->positions, INDEX_KEY (type, pid), positions);
+  }
+
+  return positions;
+}
+
+/* Returns the index in @positions of the first entry with an offset
+ * bigger or equal to @offset */
+static guint
+mpegts_index_find_offset (MpegTSIndex * index, GArray * positions,
+    guint64 offset)
+{
+  MpegTSIndexEntry entry;
+  guint lo, hi, mid;
+
+  lo = 0;
+  hi = positions->len;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    mpegts_index_get_entry (index, g_array_index (positions, guint, mid),
+        &entry);
+    if (entry.offset < offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+/* Check that an entry can be added to the index and returns where its
+ * position has to be inserted in the table of its type and PID. Entries
+ * at an offset that is already indexed are refused, and timestamps must
+ * increase with the offsets so that lookups by timestamp can be done with
+ * a binary search too */
+static gboolean
+mpegts_index_accept_entry (MpegTSIndex * index, MpegTSIndexEntry * entry,
+    guint * insert_at)
+{
+  GArray *positions;
+  MpegTSIndexEntry other;
+  guint i;
+
+  positions = mpegts_index_get_positions (index, entry->type, entry->pid,
+      FALSE);
+  if (positions == NULL || positions->len == 0) {
+    *insert_at = 0;
+    return TRUE;
+  }
+
+  i = mpegts_index_find_offset (index, positions, entry->offset);
+
+  if (i < positions->len) {
+    mpegts_index_get_entry (index, g_array_index (positions, guint, i),
+        &other);
+    if (other.offset == entry->offset || entry->ts >= other.ts)
+      return FALSE;
+  }
+
+  if (i > 0) {
+    mpegts_index_get_entry (index, g_array_index (positions, guint, i - 1),
+        &other);
+    if (entry->ts <= other.ts)
+      return FALSE;
+  }
+
+  *insert_at = i;
+  return TRUE;
+}
+
+static void
+mpegts_index_insert_position (MpegTSIndex * index, MpegTSIndexEntry * entry,
+    guint pos, guint insert_at)
+{
+  GArray *positions;
+
+  positions = mpegts_index_get_positions (index, entry->type, entry->pid,
+      TRUE);
+  g_array_insert_val (positions, insert_at, pos);
+}
+
+static gboolean
+mpegts_index_load (MpegTSIndex * index)
+{
+  GError *err = NULL;
+  const guint8 *data;
+  gsize size;
+  guint i;
+
+  index->mapped = g_mapped_file_new (index->location, FALSE, &err);
+  if (index->mapped == NULL) {
+    GST_DEBUG ("Could not map index %s: %s", index->location, err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  data = (const guint8 *) g_mapped_file_get_contents (index->mapped);
+  size = g_mapped_file_get_length (index->mapped);
+
+  if (size < INDEX_HEADER_SIZE || memcmp (data, INDEX_MAGIC, 4) != 0 ||
+      GST_READ_UINT32_LE (data + 4) != INDEX_VERSION ||
+      (size - INDEX_HEADER_SIZE) % INDEX_ENTRY_SIZE != 0) {
+    GST_WARNING ("Invalid index %s, recreating it", index->location);
+    goto invalid;
+  }
+
+  index->mapped_entries = data + INDEX_HEADER_SIZE;
+  index->n_mapped = (size - INDEX_HEADER_SIZE) / INDEX_ENTRY_SIZE;
+
+  for (i = 0; i < index->n_mapped; i++) {
+    MpegTSIndexEntry entry;
+    guint insert_at;
+
+    mpegts_index_get_entry (index, i, &entry);
+    if (!mpegts_index_accept_entry (index, &entry, &insert_at)) {
+      GST_WARNING ("Inconsistent entry %u in index %s, recreating it", i,
+          index->location);
+      goto invalid;
+    }
+    mpegts_index_insert_position (index, &entry, i, insert_at);
+  }
+
+  GST_INFO ("Loaded %u entries from index %s", index->n_mapped,
+      index->location);
+
+  return TRUE;
+
+invalid:
+  g_hash_table_remove_all (index->positions);
+  index->mapped_entries = NULL;
+  index->n_mapped = 0;
+  g_mapped_file_unref (index->mapped);
+  index->mapped = NULL;
+  return FALSE;
+}
+
+/* Opens the index at @location, loading the existing entries if any and
+ * appending new entries to it. Returns NULL if the index can't be written */
+MpegTSIndex *
+mpegts_index_open (const gchar * location)
+{
+  MpegTSIndex *index;
+
+  g_return_val_if_fail (location != NULL, NULL);
+
+  index = g_new0 (MpegTSIndex, 1);
+  index->location = g_strdup (location);
+  index->entries = g_array_new (FALSE, FALSE, sizeof (MpegTSIndexEntry));
+  index->positions = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+      NULL, (GDestroyNotify) g_array_unref);
+
+  if (mpegts_index_load (index)) {
+    index->file = g_fopen (location, "ab");
+  } else {
+    guint8 header[INDEX_HEADER_SIZE] = { 0, };
+
+    memcpy (header, INDEX_MAGIC, 4);
+    GST_WRITE_UINT32_LE (header + 4, INDEX_VERSION);
+
+    index->file = g_fopen (location, "wb");
+    if (index->file && fwrite (header, INDEX_HEADER_SIZE, 1, index->file) != 1) {
+      fclose (index->file);
+      index->file = NULL;
+    }
+  }
+
+  if (index->file == NULL) {
+    GST_WARNING ("Could not open index %s for writing: %s", location,
+        g_strerror (errno));
+    mpegts_index_free (index);
+    return NULL;
+  }
+
+  return index;
+}
+
+void
+mpegts_index_sync (MpegTSIndex * index)
+{
+  if (index->unsynced) {
+    fflush (index->file);
+    index->unsynced = 0;
+  }
+}
+
+void
+mpegts_index_free (MpegTSIndex * index)
+{
+  if (index->file) {
+    mpegts_index_sync (index);
+    fclose (index->file);
+  }
+  if (index->mapped)
+    g_mapped_file_unref (index->mapped);
+  g_hash_table_unref (index->positions);
+  g_array_unref (index->entries);
+  g_free (index->location);
+  g_free (index);
+}
+
+/* Adds an entry to the index. Entries can be added in any order, e.g. when
+ * demuxing parts of the stream that were skipped by a seek. Entries at
+ * offsets which were already indexed, or whose timestamp doesn't fit
+ * between the ones of the surrounding entries, are ignored. Returns TRUE if
+ * the entry was added */
+gboolean
+mpegts_index_add_entry (MpegTSIndex * index, MpegTSIndexEntryType type,
+    guint16 pid, GstClockTime ts, guint64 offset)
+{
+  MpegTSIndexEntry entry;
+  guint8 data[INDEX_ENTRY_SIZE] = { 0, };
+  guint insert_at;
+
+  g_return_val_if_fail (GST_CLOCK_TIME_IS_VALID (ts), FALSE);
+
+  entry.ts = ts;
+  entry.offset = offset;
+  entry.pid = pid;
+  entry.type = type;
+
+  if (!mpegts_index_accept_entry (index, &entry, &insert_at))
+    return FALSE;
+
+  GST_LOG ("type %d pid 0x%04x ts %" GST_TIME_FORMAT " offset %"
+      G_GUINT64_FORMAT, type, pid, GST_TIME_ARGS (ts), offset);
+
+  GST_WRITE_UINT64_LE (data, entry.ts);
+  GST_WRITE_UINT64_LE (data + 8, entry.offset);
+  GST_WRITE_UINT16_LE (data + 16, entry.pid);
+  data[18] = entry.type;
+
+  if (fwrite (data, INDEX_ENTRY_SIZE, 1, index->file) != 1) {
+    GST_WARNING ("Could not write to index %s", index->location);
+    return FALSE;
+  }
+
+  g_array_append_val (index->entries, entry);
+  mpegts_index_insert_position (index, &entry,
+      index->n_mapped + index->entries->len - 1, insert_at);
+
+  if (++index->unsynced >= INDEX_SYNC_INTERVAL)
+    mpegts_index_sync (index);
+
+  return TRUE;
+}
+
+/* Looks up the last entry of the given type and PID with a timestamp
+ * lower or equal to @ts */
+gboolean
+mpegts_index_lookup (MpegTSIndex * index, MpegTSIndexEntryType type,
+    guint16 pid, GstClockTime ts, GstClockTime * entry_ts,
+    guint64 * entry_offset)
+{
+  GArray *positions;
+  MpegTSIndexEntry entry;
+  guint lo, hi, mid;
+
+  positions = mpegts_index_get_positions (index, type, pid, FALSE);
+  if (positions == NULL || positions->len == 0)
+    return FALSE;
+
+  /* Find the first entry with a timestamp bigger than ts */
+  lo = 0;
+  hi = positions->len;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    mpegts_index_get_entry (index, g_array_index (positions, guint, mid),
+        &entry);
+    if (entry.ts <= ts)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo == 0)
+    return FALSE;
+
+  mpegts_index_get_entry (index, g_array_index (positions, guint, lo - 1),
+      &entry);
+
+  GST_DEBUG ("type %d pid 0x%04x ts %" GST_TIME_FORMAT " found ts %"
+      GST_TIME_FORMAT " offset %" G_GUINT64_FORMAT, type, pid,
+      GST_TIME_ARGS (ts), GST_TIME_ARGS (entry.ts), entry.offset);
+
+  if (entry_ts)
+    *entry_ts = entry.ts;
+  if (entry_offset)
+    *entry_offset = entry.offset;
+
+  return TRUE;
+}
+
+void
+init_mpegts_index (void)
+{
+  GST_DEBUG_CATEGORY_INIT (mpegts_index_debug, "mpegtsindex", 0,
+      "MPEG transport stream index");
+}
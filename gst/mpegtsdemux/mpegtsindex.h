@@ -0,0 +1,54 @@
+/*
+ * mpegtsindex.h : On-disk PCR/keyframe index for MPEG transport streams
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef GST_MPEGTS_INDEX_H
+#define GST_MPEGTS_INDEX_H
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  MPEGTS_INDEX_ENTRY_PCR = 0,
+  MPEGTS_INDEX_ENTRY_KEYFRAME = 1
+} MpegTSIndexEntryType;
+
+typedef struct _MpegTSIndex MpegTSIndex;
+
+G_GNUC_INTERNAL MpegTSIndex *mpegts_index_open (const gchar * location);
+G_GNUC_INTERNAL void mpegts_index_free (MpegTSIndex * index);
+
+G_GNUC_INTERNAL gboolean mpegts_index_add_entry (MpegTSIndex * index,
+						 MpegTSIndexEntryType type,
+						 guint16 pid,
+						 GstClockTime ts,
+						 guint64 offset);
+G_GNUC_INTERNAL gboolean mpegts_index_lookup (MpegTSIndex * index,
+					      MpegTSIndexEntryType type,
+					      guint16 pid,
+					      GstClockTime ts,
+					      GstClockTime * entry_ts,
+					      guint64 * entry_offset);
+G_GNUC_INTERNAL void mpegts_index_sync (MpegTSIndex * index);
+
+G_GNUC_INTERNAL void init_mpegts_index (void);
+
+G_END_DECLS
+
+#endif /* GST_MPEGTS_INDEX_H */
@@ -50,6 +50,8 @@ G_DEFINE_TYPE_EXTENDED (MpegTSPacketizer2, mpegts_packetizer, G_TYPE_OBJECT, 0,
 
 static void mpegts_packetizer_dispose (GObject * object);
 static void mpegts_packetizer_finalize (GObject * object);
+static void mpegts_packetizer_clear_map_memory (MpegTSPacketizer2 *
+    packetizer);
 static GstClockTime calculate_skew (MpegTSPacketizer2 * packetizer,
     MpegTSPCR * pcr, guint64 pcrtime, GstClockTime time);
 static void _close_current_group (MpegTSPCR * pcrtable);
@@ -260,6 +262,9 @@ mpegts_packetizer_init (MpegTSPacketizer2 * packetizer)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  packetizer->map_memory = NULL;
+  packetizer->map_memory_checked = FALSE;
+  packetizer->n_pid_filters = 0;
   packetizer->need_sync = FALSE;
 
   memset (packetizer->pcrtablelut, 0xff, 0x2000);
@@ -291,6 +296,7 @@ mpegts_packetizer_dispose (GObject * object)
       g_free (packetizer->streams);
     }
 
+    mpegts_packetizer_clear_map_memory (packetizer);
     gst_adapter_clear (packetizer->adapter);
     g_object_unref (packetizer->adapter);
     g_mutex_clear (&packetizer->group_lock);
@@ -591,6 +597,7 @@ mpegts_packetizer_clear (MpegTSPacketizer2 * packetizer)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  mpegts_packetizer_clear_map_memory (packetizer);
   packetizer->last_in_time = GST_CLOCK_TIME_NONE;
   packetizer->last_pts = GST_CLOCK_TIME_NONE;
   packetizer->last_dts = GST_CLOCK_TIME_NONE;
@@ -633,6 +640,7 @@ mpegts_packetizer_flush (MpegTSPacketizer2 * packetizer, gboolean hard)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  mpegts_packetizer_clear_map_memory (packetizer);
   packetizer->last_in_time = GST_CLOCK_TIME_NONE;
   packetizer->last_pts = GST_CLOCK_TIME_NONE;
   packetizer->last_dts = GST_CLOCK_TIME_NONE;
@@ -712,6 +720,77 @@ mpegts_packetizer_flush_bytes (MpegTSPacketizer2 * packetizer, gsize size)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  mpegts_packetizer_clear_map_memory (packetizer);
+}
+
+static void
+mpegts_packetizer_clear_map_memory (MpegTSPacketizer2 * packetizer)
+{
+  if (packetizer->map_memory) {
+    gst_memory_unref (packetizer->map_memory);
+    packetizer->map_memory = NULL;
+  }
+  packetizer->map_memory_checked = FALSE;
+}
+
+/* Figure out whether the currently mapped region is backed by a single
+ * upstream GstMemory, in which case sub-references can be handed out
+ * instead of copying */
+static void
+mpegts_packetizer_check_map_memory (MpegTSPacketizer2 * packetizer)
+{
+  GstBuffer *buffer;
+  GstMemory *mem;
+  GstMapInfo info;
+
+  packetizer->map_memory_checked = TRUE;
+
+  if (gst_adapter_available_fast (packetizer->adapter) < packetizer->map_size)
+    return;
+
+  buffer = gst_adapter_get_buffer_fast (packetizer->adapter,
+      packetizer->map_size);
+  if (buffer == NULL)
+    return;
+
+  if (gst_buffer_n_memory (buffer) == 1) {
+    mem = gst_buffer_peek_memory (buffer, 0);
+    if (!GST_MEMORY_FLAG_IS_SET (mem, GST_MEMORY_FLAG_NO_SHARE) &&
+        gst_memory_map (mem, &info, GST_MAP_READ)) {
+      if (info.data == packetizer->map_data)
+        packetizer->map_memory = gst_memory_ref (mem);
+      gst_memory_unmap (mem, &info);
+    }
+  }
+  gst_buffer_unref (buffer);
+
+  GST_LOG ("mapped region can%s be referenced",
+      packetizer->map_memory ? "" : "not");
+}
+
+/* Returns a new GstMemory sharing @size bytes at @data, which must be
+ * located within the currently mapped region (i.e. within a packet
+ * returned by mpegts_packetizer_next_packet() that wasn't cleared yet).
+ * Returns NULL if the data can't be referenced without a copy */
+GstMemory *
+mpegts_packetizer_share_data (MpegTSPacketizer2 * packetizer,
+    const guint8 * data, gsize size)
+{
+  if (G_UNLIKELY (packetizer->map_data == NULL))
+    return NULL;
+
+  if (G_UNLIKELY (data < packetizer->map_data ||
+          data + size > packetizer->map_data + packetizer->map_size))
+    return NULL;
+
+  if (!packetizer->map_memory_checked)
+    mpegts_packetizer_check_map_memory (packetizer);
+
+  if (packetizer->map_memory == NULL)
+    return NULL;
+
+  return gst_memory_share (packetizer->map_memory,
+      data - packetizer->map_data, size);
 }
 
 static gboolean
@@ -741,6 +820,24 @@ mpegts_packetizer_map (MpegTSPacketizer2 * packetizer, gsize size)
   return TRUE;
 }
 
+/* Returns the position of the first sync byte in data[from..to[, or @to if
+ * there is none. memchr() is vectorised by all common C libraries, which is
+ * considerably faster than checking byte by byte when resyncing */
+static inline gsize
+mpegts_packetizer_find_sync_byte (const guint8 * data, gsize from, gsize to)
+{
+  const guint8 *found;
+
+  if (from >= to)
+    return to;
+
+  found = memchr (data + from, PACKET_SYNC_BYTE, to - from);
+  if (found == NULL)
+    return to;
+
+  return found - data;
+}
+
 static gboolean
 mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 {
@@ -762,8 +859,10 @@ mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 
   for (i = 0; i + 3 * MPEGTS_MAX_PACKETSIZE < size; i++) {
     /* find a sync byte */
-    if (data[i] != PACKET_SYNC_BYTE)
-      continue;
+    i = mpegts_packetizer_find_sync_byte (data, i,
+        size - 3 * MPEGTS_MAX_PACKETSIZE);
+    if (i + 3 * MPEGTS_MAX_PACKETSIZE >= size)
+      break;
 
     /* check for 4 consecutive sync bytes with each possible packet size */
     for (j = 0; j < G_N_ELEMENTS (psizes); j++) {
@@ -819,8 +918,10 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
     sync_offset = 0;
 
   for (i = sync_offset; i + 2 * packet_size < size; i++) {
-    if (data[i] == PACKET_SYNC_BYTE &&
-        data[i + packet_size] == PACKET_SYNC_BYTE &&
+    i = mpegts_packetizer_find_sync_byte (data, i, size - 2 * packet_size);
+    if (i + 2 * packet_size >= size)
+      break;
+    if (data[i + packet_size] == PACKET_SYNC_BYTE &&
         data[i + 2 * packet_size] == PACKET_SYNC_BYTE) {
       found = TRUE;
       break;
@@ -835,6 +936,65 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
   return found;
 }
 
+static inline gboolean
+mpegts_packetizer_pid_is_wanted (MpegTSPacketizer2 * packetizer, guint16 pid)
+{
+  guint i;
+
+  for (i = 0; i < packetizer->n_pid_filters; i++) {
+    if (MPEGTS_BIT_IS_SET (packetizer->pid_filters[i], pid))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* Skips, without parsing them, all consecutive packets of the mapped region
+ * that are on PIDs not present in any of the PID filters.
+ *
+ * Packets carrying a PCR are never skipped so that PCR observations (used
+ * for skew, bitrate and seeking calculations) are the same whether
+ * filtering is active or not.
+ *
+ * Stops at the first packet that is wanted, has no sync byte or isn't
+ * completely mapped. Returns the number of skipped packets */
+static guint
+mpegts_packetizer_skip_filtered_packets (MpegTSPacketizer2 * packetizer,
+    gsize sync_offset)
+{
+  guint packet_size = packetizer->packet_size;
+  gsize offset = packetizer->map_offset;
+  guint8 *data;
+  guint16 pid;
+  guint skipped = 0;
+
+  while (offset + packet_size <= packetizer->map_size) {
+    data = packetizer->map_data + offset + sync_offset;
+
+    if (G_UNLIKELY (data[0] != PACKET_SYNC_BYTE))
+      break;
+
+    pid = GST_READ_UINT16_BE (data + 1) & 0x1FFF;
+    if (mpegts_packetizer_pid_is_wanted (packetizer, pid))
+      break;
+
+    /* adaptation field present, non-empty and with a PCR */
+    if ((data[3] & 0x20) && data[4] != 0 && (data[5] & MPEGTS_AFC_PCR_FLAG))
+      break;
+
+    offset += packet_size;
+    skipped++;
+  }
+
+  if (skipped) {
+    GST_LOG ("skipped %u filtered packets", skipped);
+    packetizer->map_offset = offset;
+    packetizer->offset += (guint64) skipped *packet_size;
+  }
+
+  return skipped;
+}
+
 MpegTSPacketizerPacketReturn
 mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
     MpegTSPacketizerPacket * packet)
@@ -866,6 +1026,12 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
     if (!mpegts_packetizer_map (packetizer, packet_size))
       return PACKET_NEED_MORE;
 
+    /* Go over the packets nobody is interested in in one go. If any were
+     * skipped make sure the next one is still mapped */
+    if (packetizer->n_pid_filters &&
+        mpegts_packetizer_skip_filtered_packets (packetizer, sync_offset))
+      continue;
+
     packet_data = &packetizer->map_data[packetizer->map_offset + sync_offset];
 
     /* Check sync byte */
@@ -914,6 +1080,27 @@ mpegts_packetizer_clear_packet (MpegTSPacketizer2 * packetizer,
   }
 }
 
+/* Only return packets on PIDs set in @pid_filter (a 0x2000 bits bitfield
+ * as used by the MPEGTS_BIT_* macros) or in any other previously added
+ * filter. Packets on other PIDs are skipped by
+ * mpegts_packetizer_next_packet() without being parsed, except if they
+ * carry a PCR. The bitfield is not copied and can be modified while
+ * installed */
+void
+mpegts_packetizer_add_pid_filter (MpegTSPacketizer2 * packetizer,
+    const guint8 * pid_filter)
+{
+  g_return_if_fail (packetizer->n_pid_filters < MAX_PID_FILTERS);
+
+  packetizer->pid_filters[packetizer->n_pid_filters++] = pid_filter;
+}
+
+void
+mpegts_packetizer_clear_pid_filters (MpegTSPacketizer2 * packetizer)
+{
+  packetizer->n_pid_filters = 0;
+}
+
 gboolean
 mpegts_packetizer_has_packets (MpegTSPacketizer2 * packetizer)
 {
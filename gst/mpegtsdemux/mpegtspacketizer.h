@@ -50,6 +50,8 @@
 
 #define MAX_WINDOW 512
 
+#define MAX_PID_FILTERS 4
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_MPEGTS_PACKETIZER \
@@ -269,6 +271,17 @@ struct _MpegTSPacketizer2 {
   gsize map_size;
   gboolean need_sync;
 
+  /* Memory backing map_data, used to hand out sub-references of the
+   * mapped region. Only set when map_data points straight into a single
+   * upstream GstMemory (and therefore no copy was done by the adapter) */
+  GstMemory *map_memory;
+  gboolean map_memory_checked;
+
+  /* PID bitfields of packets to return, see mpegts_packetizer_add_pid_filter().
+   * No filtering is done if there are none */
+  const guint8 *pid_filters[MAX_PID_FILTERS];
+  guint n_pid_filters;
+
   /* Reference offset */
   guint64 refoffset;
 
@@ -345,6 +358,9 @@ G_GNUC_INTERNAL MpegTSPacketizer2 *mpegts_packetizer_new (void);
 G_GNUC_INTERNAL void mpegts_packetizer_clear (MpegTSPacketizer2 *packetizer);
 G_GNUC_INTERNAL void mpegts_packetizer_flush (MpegTSPacketizer2 *packetizer, gboolean hard);
 G_GNUC_INTERNAL void mpegts_packetizer_push (MpegTSPacketizer2 *packetizer, GstBuffer *buffer);
+G_GNUC_INTERNAL void mpegts_packetizer_add_pid_filter (MpegTSPacketizer2 *packetizer,
+				     const guint8 *pid_filter);
+G_GNUC_INTERNAL void mpegts_packetizer_clear_pid_filters (MpegTSPacketizer2 *packetizer);
 G_GNUC_INTERNAL gboolean mpegts_packetizer_has_packets (MpegTSPacketizer2 *packetizer);
 G_GNUC_INTERNAL MpegTSPacketizerPacketReturn mpegts_packetizer_next_packet (MpegTSPacketizer2 *packetizer,
   MpegTSPacketizerPacket *packet);
@@ -352,6 +368,8 @@ G_GNUC_INTERNAL MpegTSPacketizerPacketReturn
 mpegts_packetizer_process_next_packet(MpegTSPacketizer2 * packetizer);
 G_GNUC_INTERNAL void mpegts_packetizer_clear_packet (MpegTSPacketizer2 *packetizer,
 				     MpegTSPacketizerPacket *packet);
+G_GNUC_INTERNAL GstMemory *mpegts_packetizer_share_data (MpegTSPacketizer2 *packetizer,
+				     const guint8 *data, gsize size);
 G_GNUC_INTERNAL void mpegts_packetizer_remove_stream(MpegTSPacketizer2 *packetizer,
   gint16 pid);
 
@@ -82,6 +82,14 @@
  * up to this size */
 #define MAX_PES_PAYLOAD (32 * 1024 * 1024)
 
+/* Largest amount of payload carried by a single TS packet */
+#define MAX_TS_PAYLOAD (MPEGTS_NORMAL_PACKETSIZE - 4)
+
+#define DEFAULT_ZERO_COPY_PES FALSE
+
+/* Minimum interval between PCR entries stored in the index */
+#define INDEX_PCR_INTERVAL GST_SECOND
+
 GST_DEBUG_CATEGORY_STATIC (ts_demux_debug);
 #define GST_CAT_DEFAULT ts_demux_debug
 
@@ -175,6 +183,16 @@ struct _TSDemuxStream
   /* Data being reconstructed (allocated) */
   guint8 *data;
 
+  /* Data being reconstructed (referenced from upstream, one memory per
+   * TS packet). Only used if data is NULL */
+  GstMemory **mems;
+  guint n_mems;
+  guint mems_size;
+
+  /* Amount of bytes copied/referenced for the data being reconstructed */
+  guint copied_size;
+  guint referenced_size;
+
   /* Size of data being reconstructed (if known, else 0) */
   guint expected_size;
 
@@ -297,6 +315,10 @@ enum
   PROP_PROGRAM_NUMBER,
   PROP_EMIT_STATS,
   PROP_LATENCY,
+  PROP_ZERO_COPY_PES,
+  PROP_BYTES_COPIED,
+  PROP_BYTES_REFERENCED,
+  PROP_INDEX_LOCATION,
   /* FILL ME */
 };
 
@@ -318,6 +340,7 @@ static GstFlowReturn
 gst_ts_demux_push (MpegTSBase * base, MpegTSPacketizerPacket * packet,
     GstMpegtsSection * section);
 static void gst_ts_demux_flush (MpegTSBase * base, gboolean hard);
+static void gst_ts_demux_stream_clear_data (TSDemuxStream * stream);
 static GstFlowReturn gst_ts_demux_drain (MpegTSBase * base);
 static gboolean
 gst_ts_demux_stream_added (MpegTSBase * base, MpegTSBaseStream * stream,
@@ -363,6 +386,8 @@ gst_ts_demux_dispose (GObject * object)
   GstTSDemux *demux = GST_TS_DEMUX_CAST (object);
 
   gst_flow_combiner_free (demux->flowcombiner);
+  g_free (demux->index_location);
+  demux->index_location = NULL;
 
   GST_CALL_PARENT (G_OBJECT_CLASS, dispose, (object));
 }
@@ -395,6 +420,82 @@ gst_ts_demux_class_init (GstTSDemuxClass * klass)
           G_MAXINT, DEFAULT_LATENCY,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstTSDemux:zero-copy-pes:
+   *
+   * Reassemble PES packets by referencing the upstream memory instead of
+   * copying every TS packet payload.
+   *
+   * Each TS packet payload becomes one memory of the output. Video PES
+   * (MPEG-1/2, MPEG-4 part 2, H.264 and H.265) larger than what a single
+   * buffer can hold are output as a buffer list, the first buffer carrying
+   * the timestamps. Other PES are only referenced when they fit in one
+   * buffer, i.e. up to gst_buffer_get_max_memory() TS packets.
+   *
+   * Payloads are copied into a single allocation when the stream needs to
+   * be parsed by tsdemux (keyframe scanning, Opus, JPEG 2000 and ADTS
+   * access units) or when upstream memory can't be shared. The latter
+   * happens whenever the packets being handled span several upstream
+   * buffers, so this is only effective if upstream pushes buffers holding
+   * whole TS packets (e.g. udpsrc, or filesrc with a blocksize multiple of
+   * the packet size). #GstTSDemux:bytes-copied and
+   * #GstTSDemux:bytes-referenced report how much data went through each
+   * path.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_ZERO_COPY_PES,
+      g_param_spec_boolean ("zero-copy-pes", "Zero-copy PES",
+          "Reference upstream memory when reassembling PES packets "
+          "instead of copying them", DEFAULT_ZERO_COPY_PES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTSDemux:bytes-copied:
+   *
+   * Number of PES payload bytes that were copied before being output.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BYTES_COPIED,
+      g_param_spec_uint64 ("bytes-copied", "Bytes copied",
+          "Number of PES payload bytes copied before being output",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTSDemux:bytes-referenced:
+   *
+   * Number of PES payload bytes that were output without being copied.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BYTES_REFERENCED,
+      g_param_spec_uint64 ("bytes-referenced", "Bytes referenced",
+          "Number of PES payload bytes output without being copied",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTSDemux:index-location:
+   *
+   * Location of a sidecar index file storing the offsets of PCRs and of
+   * video keyframes. The index is extended while demuxing and loaded again
+   * the next time the same stream is demuxed, allowing seeks to land
+   * directly on the right offset instead of estimating it from the
+   * bitrate.
+   *
+   * The stored timestamps are those computed by tsdemux, the index should
+   * therefore only be reused for the same stream played back in the same
+   * way (e.g. a file read in pull mode).
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_INDEX_LOCATION,
+      g_param_spec_string ("index-location", "Index location",
+          "Location of the sidecar file used to store/load the seek index "
+          "(NULL = no index)", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   element_class = GST_ELEMENT_CLASS (klass);
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&video_template));
@@ -454,6 +555,12 @@ gst_ts_demux_reset (MpegTSBase * base)
 
   demux->last_seek_offset = -1;
   demux->program_generation = 0;
+
+  if (demux->index) {
+    mpegts_index_free (demux->index);
+    demux->index = NULL;
+  }
+  demux->index_failed = FALSE;
 }
 
 static void
@@ -470,6 +577,7 @@ gst_ts_demux_init (GstTSDemux * demux)
   demux->requested_program_number = -1;
   demux->program_number = -1;
   demux->latency = DEFAULT_LATENCY;
+  demux->zero_copy_pes = DEFAULT_ZERO_COPY_PES;
   gst_ts_demux_reset (base);
 }
 
@@ -492,6 +600,15 @@ gst_ts_demux_set_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       demux->latency = g_value_get_int (value);
       break;
+    case PROP_ZERO_COPY_PES:
+      demux->zero_copy_pes = g_value_get_boolean (value);
+      break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (demux);
+      g_free (demux->index_location);
+      demux->index_location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -513,6 +630,24 @@ gst_ts_demux_get_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       g_value_set_int (value, demux->latency);
       break;
+    case PROP_ZERO_COPY_PES:
+      g_value_set_boolean (value, demux->zero_copy_pes);
+      break;
+    case PROP_BYTES_COPIED:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_uint64 (value, demux->bytes_copied);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_BYTES_REFERENCED:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_uint64 (value, demux->bytes_referenced);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_string (value, demux->index_location);
+      GST_OBJECT_UNLOCK (demux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -854,6 +989,112 @@ gst_ts_demux_adjust_seek_offset_for_keyframe (TSDemuxStream * stream,
   return TRUE;
 }
 
+/* Returns the seek index, opening it if needed. Must be called from the
+ * streaming thread */
+static MpegTSIndex *
+gst_ts_demux_get_index (GstTSDemux * demux)
+{
+  gchar *location;
+
+  if (G_LIKELY (demux->index || demux->index_failed))
+    return demux->index;
+
+  GST_OBJECT_LOCK (demux);
+  location = g_strdup (demux->index_location);
+  GST_OBJECT_UNLOCK (demux);
+
+  if (location) {
+    demux->index = mpegts_index_open (location);
+    if (demux->index == NULL)
+      GST_ELEMENT_WARNING (demux, RESOURCE, OPEN_WRITE,
+          ("Could not open index file \"%s\".", location), GST_ERROR_SYSTEM);
+  }
+  /* Don't try again until the next reset */
+  demux->index_failed = (demux->index == NULL);
+  g_free (location);
+
+  return demux->index;
+}
+
+static void
+gst_ts_demux_index_pcr (GstTSDemux * demux, MpegTSPacketizerPacket * packet)
+{
+  MpegTSIndex *index = gst_ts_demux_get_index (demux);
+  GstClockTime ts, prev_ts;
+
+  if (index == NULL)
+    return;
+
+  ts = mpegts_packetizer_pts_to_ts (MPEG_TS_BASE_PACKETIZER (demux),
+      PCRTIME_TO_GSTTIME (packet->pcr), packet->pid);
+  if (!GST_CLOCK_TIME_IS_VALID (ts))
+    return;
+
+  /* Compare with the index rather than with the last added PCR, so that
+   * going over parts of the stream that were already indexed (e.g. after
+   * seeking back) doesn't add more entries */
+  if (mpegts_index_lookup (index, MPEGTS_INDEX_ENTRY_PCR, packet->pid, ts,
+          &prev_ts, NULL) && ts < prev_ts + INDEX_PCR_INTERVAL)
+    return;
+
+  mpegts_index_add_entry (index, MPEGTS_INDEX_ENTRY_PCR, packet->pid, ts,
+      packet->offset);
+}
+
+static void
+gst_ts_demux_index_keyframe (GstTSDemux * demux, TSDemuxStream * stream,
+    guint64 offset)
+{
+  MpegTSBaseStream *bs = (MpegTSBaseStream *) stream;
+  MpegTSIndex *index = gst_ts_demux_get_index (demux);
+
+  if (index == NULL || !GST_CLOCK_TIME_IS_VALID (stream->pts))
+    return;
+
+  if (bs->stream_object == NULL ||
+      !(gst_stream_get_stream_type (bs->stream_object) & GST_STREAM_TYPE_VIDEO))
+    return;
+
+  mpegts_index_add_entry (index, MPEGTS_INDEX_ENTRY_KEYFRAME, bs->pid,
+      stream->pts, offset);
+}
+
+/* Looks up the offset to seek to in the index. The keyframe preceding
+ * @seek_ts on a video stream is used if known, else the PCR preceding
+ * @target (the seek position minus the usual safety margin) */
+static gboolean
+gst_ts_demux_index_lookup (GstTSDemux * demux, GstClockTime seek_ts,
+    GstClockTime target, guint64 * offset)
+{
+  MpegTSIndex *index = gst_ts_demux_get_index (demux);
+  GList *tmp;
+  GstClockTime ts;
+
+  if (index == NULL)
+    return FALSE;
+
+  for (tmp = demux->program->stream_list; tmp; tmp = tmp->next) {
+    MpegTSBaseStream *bs = (MpegTSBaseStream *) tmp->data;
+
+    if (mpegts_index_lookup (index, MPEGTS_INDEX_ENTRY_KEYFRAME, bs->pid,
+            seek_ts, &ts, offset)) {
+      GST_DEBUG_OBJECT (demux, "Seeking to keyframe %" GST_TIME_FORMAT
+          " of PID 0x%04x at offset %" G_GUINT64_FORMAT, GST_TIME_ARGS (ts),
+          bs->pid, *offset);
+      return TRUE;
+    }
+  }
+
+  if (mpegts_index_lookup (index, MPEGTS_INDEX_ENTRY_PCR,
+          demux->program->pcr_pid, target, &ts, offset)) {
+    GST_DEBUG_OBJECT (demux, "Seeking to PCR %" GST_TIME_FORMAT
+        " at offset %" G_GUINT64_FORMAT, GST_TIME_ARGS (ts), *offset);
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
 static GstFlowReturn
 gst_ts_demux_do_seek (MpegTSBase * base, GstEvent * event)
 {
@@ -910,9 +1151,11 @@ gst_ts_demux_do_seek (MpegTSBase * base, GstEvent * event)
     else
       target = 0;
 
-    start_offset =
-        mpegts_packetizer_ts_to_offset (base->packetizer, target,
-        demux->program->pcr_pid);
+    if (!gst_ts_demux_index_lookup (demux, seeksegment.start, target,
+            &start_offset))
+      start_offset =
+          mpegts_packetizer_ts_to_offset (base->packetizer, target,
+          demux->program->pcr_pid);
     if (G_UNLIKELY (start_offset == -1)) {
       GST_WARNING ("Couldn't convert start position to an offset");
       goto done;
@@ -1952,6 +2195,10 @@ gst_ts_demux_stream_removed (MpegTSBase * base, MpegTSBaseStream * bstream)
 
   gst_ts_demux_stream_flush (stream, GST_TS_DEMUX_CAST (base), TRUE);
 
+  g_free (stream->mems);
+  stream->mems = NULL;
+  stream->mems_size = 0;
+
   if (stream->taglist != NULL) {
     gst_tag_list_unref (stream->taglist);
     stream->taglist = NULL;
@@ -1983,8 +2230,7 @@ gst_ts_demux_stream_flush (TSDemuxStream * stream, GstTSDemux * tsdemux,
 {
   GST_DEBUG ("flushing stream %p", stream);
 
-  g_free (stream->data);
-  stream->data = NULL;
+  gst_ts_demux_stream_clear_data (stream);
   stream->state = PENDING_PACKET_EMPTY;
   stream->expected_size = 0;
   stream->allocated_size = 0;
@@ -2384,6 +2630,177 @@ check_pending_buffers (GstTSDemux * demux)
   return TRUE;
 }
 
+static gboolean
+gst_ts_demux_stream_needs_contiguous (TSDemuxStream * stream)
+{
+  MpegTSBaseStream *bs = (MpegTSBaseStream *) stream;
+
+  /* Keyframe scanning and the access unit parsers used in
+   * gst_ts_demux_push_pending_data() all work on stream->data */
+  if (stream->needs_keyframe)
+    return TRUE;
+
+  switch (bs->stream_type) {
+    case GST_MPEGTS_STREAM_TYPE_PRIVATE_PES_PACKETS:
+      return bs->registration_id == DRF_ID_OPUS;
+    case GST_MPEGTS_STREAM_TYPE_VIDEO_JP2K:
+    case GST_MPEGTS_STREAM_TYPE_AUDIO_AAC_ADTS:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+/* Whether the output can be split over several buffers. This is the case
+ * for the video byte-streams, which are reassembled by the parsers
+ * downstream anyway, but not for streams where each buffer has to be a
+ * complete PES (subtitles, metadata, most audio) */
+static gboolean
+gst_ts_demux_stream_can_split (TSDemuxStream * stream)
+{
+  MpegTSBaseStream *bs = (MpegTSBaseStream *) stream;
+
+  switch (bs->stream_type) {
+    case GST_MPEGTS_STREAM_TYPE_VIDEO_MPEG1:
+    case GST_MPEGTS_STREAM_TYPE_VIDEO_MPEG2:
+    case GST_MPEGTS_STREAM_TYPE_VIDEO_MPEG4:
+    case GST_MPEGTS_STREAM_TYPE_VIDEO_H264:
+    case GST_MPEGTS_STREAM_TYPE_VIDEO_HEVC:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+static void
+gst_ts_demux_stream_clear_data (TSDemuxStream * stream)
+{
+  guint i;
+
+  g_free (stream->data);
+  stream->data = NULL;
+
+  for (i = 0; i < stream->n_mems; i++)
+    gst_memory_unref (stream->mems[i]);
+  stream->n_mems = 0;
+
+  stream->copied_size = 0;
+  stream->referenced_size = 0;
+}
+
+/* Appends a reference to @data (located in the packet currently being
+ * handled) to the PES being reconstructed. Returns FALSE if the data
+ * needs to be copied instead */
+static gboolean
+gst_ts_demux_stream_reference_data (GstTSDemux * demux, TSDemuxStream * stream,
+    guint8 * data, guint size)
+{
+  GstMemory *mem;
+
+  if (!demux->zero_copy_pes || stream->data != NULL)
+    return FALSE;
+
+  /* More memories than a buffer can hold would be merged (i.e. copied) by
+   * GstBuffer, unless they can be output over several buffers */
+  if (stream->n_mems >= gst_buffer_get_max_memory () &&
+      !gst_ts_demux_stream_can_split (stream))
+    return FALSE;
+
+  mem = mpegts_packetizer_share_data (MPEG_TS_BASE_PACKETIZER (demux),
+      data, size);
+  if (mem == NULL)
+    return FALSE;
+
+  if (stream->n_mems == stream->mems_size) {
+    stream->mems_size = MAX (16, 2 * stream->mems_size);
+    stream->mems = g_renew (GstMemory *, stream->mems, stream->mems_size);
+  }
+
+  stream->mems[stream->n_mems++] = mem;
+  stream->current_size += size;
+
+  return TRUE;
+}
+
+/* Copies all referenced data into stream->data */
+static void
+gst_ts_demux_stream_coalesce (TSDemuxStream * stream)
+{
+  GstMapInfo info;
+  guint i, offset = 0;
+
+  if (stream->n_mems == 0)
+    return;
+
+  GST_LOG ("coalescing %u memories (%u bytes)", stream->n_mems,
+      stream->current_size);
+
+  g_assert (stream->data == NULL);
+  stream->allocated_size = MAX (stream->expected_size, stream->current_size);
+  stream->data = g_malloc (stream->allocated_size);
+
+  for (i = 0; i < stream->n_mems; i++) {
+    if (gst_memory_map (stream->mems[i], &info, GST_MAP_READ)) {
+      memcpy (stream->data + offset, info.data, info.size);
+      gst_memory_unmap (stream->mems[i], &info);
+    } else {
+      GST_WARNING ("Failed to map memory %u", i);
+      memset (stream->data + offset, 0, stream->mems[i]->size);
+    }
+    offset += stream->mems[i]->size;
+    gst_memory_unref (stream->mems[i]);
+  }
+  stream->n_mems = 0;
+  stream->copied_size += offset;
+}
+
+/* Returns the reconstructed data as a buffer, taking ownership of it */
+static GstBuffer *
+gst_ts_demux_stream_take_buffer (TSDemuxStream * stream)
+{
+  GstBuffer *buffer;
+  guint i;
+
+  if (stream->data)
+    return gst_buffer_new_wrapped (stream->data, stream->current_size);
+
+  buffer = gst_buffer_new ();
+  for (i = 0; i < stream->n_mems; i++)
+    gst_buffer_append_memory (buffer, stream->mems[i]);
+  stream->n_mems = 0;
+  stream->referenced_size = stream->current_size;
+
+  return buffer;
+}
+
+/* Returns the referenced data as a list of buffers holding as many
+ * memories as possible, for PES that don't fit in a single buffer */
+static GstBufferList *
+gst_ts_demux_stream_take_buffer_list (TSDemuxStream * stream)
+{
+  GstBufferList *buffer_list;
+  GstBuffer *buffer = NULL;
+  guint i, max_memory;
+
+  g_assert (stream->data == NULL);
+
+  max_memory = gst_buffer_get_max_memory ();
+  buffer_list = gst_buffer_list_new_sized ((stream->n_mems + max_memory - 1) /
+      max_memory);
+
+  for (i = 0; i < stream->n_mems; i++) {
+    if (i % max_memory == 0) {
+      buffer = gst_buffer_new ();
+      gst_buffer_list_add (buffer_list, buffer);
+    }
+    gst_buffer_append_memory (buffer, stream->mems[i]);
+  }
+  stream->n_mems = 0;
+  stream->referenced_size = stream->current_size;
+
+  return buffer_list;
+}
+
 static void
 gst_ts_demux_parse_pes_header (GstTSDemux * demux, TSDemuxStream * stream,
     guint8 * data, guint32 length, guint64 bufferoffset)
@@ -2442,16 +2859,33 @@ gst_ts_demux_parse_pes_header (GstTSDemux * demux, TSDemuxStream * stream,
   data += header.header_size;
   length -= header.header_size;
 
-  /* Create the output buffer */
+  g_assert (stream->data == NULL && stream->n_mems == 0);
+  stream->current_size = 0;
+
+  /* Reference the payload if nobody needs to look at the data and it can
+   * be output without merging the memories (i.e. the announced PES fits in
+   * one buffer, or the stream can be split over several buffers), else
+   * create the output buffer */
+  if (demux->zero_copy_pes && !gst_ts_demux_stream_needs_contiguous (stream)
+      && (gst_ts_demux_stream_can_split (stream) || (stream->expected_size
+              && stream->expected_size <=
+              gst_buffer_get_max_memory () * MAX_TS_PAYLOAD))) {
+    if (length == 0 || gst_ts_demux_stream_reference_data (demux, stream,
+            data, length)) {
+      stream->state = PENDING_PACKET_BUFFER;
+      return;
+    }
+  }
+
   if (stream->expected_size)
     stream->allocated_size = MAX (stream->expected_size, length);
   else
     stream->allocated_size = MAX (8192, length);
 
-  g_assert (stream->data == NULL);
   stream->data = g_malloc (stream->allocated_size);
   memcpy (stream->data, data, length);
   stream->current_size = length;
+  stream->copied_size = length;
 
   stream->state = PENDING_PACKET_BUFFER;
 
@@ -2489,10 +2923,7 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
       if (packet->payload_unit_start_indicator) {
         /* A mismatch is fatal, except if this is the beginning of a new
          * frame (from which we can recover) */
-        if (G_UNLIKELY (stream->data)) {
-          g_free (stream->data);
-          stream->data = NULL;
-        }
+        gst_ts_demux_stream_clear_data (stream);
         stream->state = PENDING_PACKET_HEADER;
       } else {
         GST_WARNING ("CONTINUITY: Mismatch packet %d, stream %d",
@@ -2520,11 +2951,21 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
 
       /* parse the header */
       gst_ts_demux_parse_pes_header (demux, stream, data, size, packet->offset);
+
+      if (G_UNLIKELY (demux->index_location) &&
+          stream->state == PENDING_PACKET_BUFFER &&
+          (packet->afc_flags & MPEGTS_AFC_RANDOM_ACCESS_FLAG))
+        gst_ts_demux_index_keyframe (demux, stream, packet->offset);
       break;
     }
     case PENDING_PACKET_BUFFER:
     {
       GST_LOG ("BUFFER: appending data");
+      if (stream->data == NULL) {
+        if (gst_ts_demux_stream_reference_data (demux, stream, data, size))
+          break;
+        gst_ts_demux_stream_coalesce (stream);
+      }
       if (G_UNLIKELY (stream->current_size + size > stream->allocated_size)) {
         GST_LOG ("resizing buffer");
         do {
@@ -2534,15 +2975,13 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
       }
       memcpy (stream->data + stream->current_size, data, size);
       stream->current_size += size;
+      stream->copied_size += size;
       break;
     }
     case PENDING_PACKET_DISCONT:
     {
       GST_LOG ("DISCONT: not storing/pushing");
-      if (G_UNLIKELY (stream->data)) {
-        g_free (stream->data);
-        stream->data = NULL;
-      }
+      gst_ts_demux_stream_clear_data (stream);
       stream->continuity_counter = CONTINUITY_UNSET;
       break;
     }
@@ -3060,7 +3499,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
       "stream:%p, pid:0x%04x stream_type:%d state:%d", stream, bs->pid,
       bs->stream_type, stream->state);
 
-  if (G_UNLIKELY (stream->data == NULL)) {
+  if (G_UNLIKELY (stream->data == NULL && stream->n_mems == 0)) {
     GST_LOG ("stream->data == NULL");
     goto beach;
   }
@@ -3077,10 +3516,16 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
 
   if (G_UNLIKELY (demux->program == NULL)) {
     GST_LOG_OBJECT (demux, "No program");
-    g_free (stream->data);
+    gst_ts_demux_stream_clear_data (stream);
     goto beach;
   }
 
+  /* The data might have been referenced before we knew it had to be
+   * looked at (e.g. seeking started while collecting it) */
+  if (G_UNLIKELY (stream->n_mems && gst_ts_demux_stream_needs_contiguous
+          (stream)))
+    gst_ts_demux_stream_coalesce (stream);
+
   if (stream->needs_keyframe) {
     MpegTSBase *base = (MpegTSBase *) demux;
 
@@ -3110,7 +3555,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
           goto beach;
         }
       } else {
-        buffer = gst_buffer_new_wrapped (stream->data, stream->current_size);
+        buffer = gst_ts_demux_stream_take_buffer (stream);
       }
 
       stream->seeked_pts = stream->pts;
@@ -3126,7 +3571,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
 
       stream->continuity_counter = CONTINUITY_UNSET;
       res = GST_FLOW_REWINDING;
-      g_free (stream->data);
+      gst_ts_demux_stream_clear_data (stream);
       goto beach;
     }
   } else {
@@ -3155,8 +3600,10 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
         res = GST_FLOW_ERROR;
         goto beach;
       }
+    } else if (stream->n_mems > gst_buffer_get_max_memory ()) {
+      buffer_list = gst_ts_demux_stream_take_buffer_list (stream);
     } else {
-      buffer = gst_buffer_new_wrapped (stream->data, stream->current_size);
+      buffer = gst_ts_demux_stream_take_buffer (stream);
     }
 
     if (G_UNLIKELY (stream->pending_ts && !check_pending_buffers (demux))) {
@@ -3302,6 +3749,13 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
   }
 
 beach:
+  if (stream->copied_size || stream->referenced_size) {
+    GST_OBJECT_LOCK (demux);
+    demux->bytes_copied += stream->copied_size;
+    demux->bytes_referenced += stream->referenced_size;
+    GST_OBJECT_UNLOCK (demux);
+  }
+
   /* Reset the PES payload collection, but don't clear the state,
    * we might want to keep collecting this PES */
   GST_LOG ("Cleared PES data. returning %s", gst_flow_get_name (res));
@@ -3314,6 +3768,8 @@ beach:
   stream->data = NULL;
   stream->allocated_size = 0;
   stream->current_size = 0;
+  /* Drop any references that weren't output */
+  gst_ts_demux_stream_clear_data (stream);
 
   return res;
 }
@@ -3391,6 +3847,9 @@ gst_ts_demux_drain (MpegTSBase * base)
   if (!demux->program)
     return res;
 
+  if (demux->index)
+    mpegts_index_sync (demux->index);
+
   for (tmp = demux->program->stream_list; tmp; tmp = tmp->next) {
     TSDemuxStream *stream = (TSDemuxStream *) tmp->data;
     if (stream->pad) {
@@ -3412,6 +3871,10 @@ gst_ts_demux_push (MpegTSBase * base, MpegTSPacketizerPacket * packet,
   GstFlowReturn res = GST_FLOW_OK;
 
   if (G_LIKELY (demux->program)) {
+    if (G_UNLIKELY (demux->index_location) && packet->pcr != G_MAXUINT64
+        && packet->pid == demux->program->pcr_pid)
+      gst_ts_demux_index_pcr (demux, packet);
+
     stream = (TSDemuxStream *) demux->program->streams[packet->pid];
 
     if (stream) {
@@ -3427,6 +3890,7 @@ gst_ts_demux_plugin_init (GstPlugin * plugin)
   GST_DEBUG_CATEGORY_INIT (ts_demux_debug, "tsdemux", 0,
       "MPEG transport stream demuxer");
   init_pes_parser ();
+  init_mpegts_index ();
 
   return gst_element_register (plugin, "tsdemux",
       GST_RANK_PRIMARY, GST_TYPE_TS_DEMUX);
@@ -308,6 +308,53 @@ steal_si_section (GstMpegtsSectionType * type, TsMuxSection * section,
   return TRUE;
 }
 
+static void
+gst_base_ts_mux_clear_pool (GstBufferPool ** pool, gsize * pool_size)
+{
+  if (*pool) {
+    gst_buffer_pool_set_active (*pool, FALSE);
+    gst_object_unref (*pool);
+    *pool = NULL;
+  }
+  *pool_size = 0;
+}
+
+/* Acquires a buffer of @size bytes from @pool, (re)creating the pool if
+ * needed. Packets and output units are allocated at a high rate, recycling
+ * them avoids allocating new buffers and memory for each of them. The size
+ * the pool was configured with is kept in @pool_size so that the pool
+ * configuration doesn't need to be copied for every buffer */
+static GstBuffer *
+gst_base_ts_mux_acquire_buffer (GstBaseTsMux * mux, GstBufferPool ** pool,
+    gsize * pool_size, gsize size)
+{
+  GstBuffer *buf = NULL;
+  GstStructure *config;
+
+  if (*pool && *pool_size != size)
+    gst_base_ts_mux_clear_pool (pool, pool_size);
+
+  if (*pool == NULL) {
+    *pool = gst_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (*pool);
+    gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+    if (!gst_buffer_pool_set_config (*pool, config) ||
+        !gst_buffer_pool_set_active (*pool, TRUE)) {
+      GST_WARNING_OBJECT (mux, "Failed to configure buffer pool");
+      gst_object_unref (*pool);
+      *pool = NULL;
+    } else {
+      *pool_size = size;
+    }
+  }
+
+  if (*pool == NULL ||
+      gst_buffer_pool_acquire_buffer (*pool, &buf, NULL) != GST_FLOW_OK)
+    buf = gst_buffer_new_and_alloc (size);
+
+  return buf;
+}
+
 static void
 gst_base_ts_mux_reset (GstBaseTsMux * mux, gboolean alloc)
 {
@@ -329,6 +376,9 @@ gst_base_ts_mux_reset (GstBaseTsMux * mux, gboolean alloc)
   if (mux->out_adapter)
     gst_adapter_clear (mux->out_adapter);
 
+  gst_base_ts_mux_clear_pool (&mux->packet_pool, &mux->packet_pool_size);
+  gst_base_ts_mux_clear_pool (&mux->unit_pool, &mux->unit_pool_size);
+
   if (mux->tsmux) {
     if (mux->tsmux->si_sections)
       si_sections = g_hash_table_ref (mux->tsmux->si_sections);
@@ -920,9 +970,27 @@ gst_base_ts_mux_push_packets (GstBaseTsMux * mux, gboolean force)
   while (align <= av) {
     GstBuffer *buf;
     GstClockTime pts;
+    GstMapInfo map;
 
     pts = gst_adapter_prev_pts (mux->out_adapter, NULL);
-    buf = gst_adapter_take_buffer (mux->out_adapter, align);
+
+    /* A single packet is pushed as is, else the packets are gathered into
+     * a recycled buffer instead of a newly allocated one */
+    if (align == packet_size) {
+      buf = gst_adapter_take_buffer (mux->out_adapter, align);
+    } else {
+      buf = gst_base_ts_mux_acquire_buffer (mux, &mux->unit_pool,
+          &mux->unit_pool_size, align);
+      if (gst_buffer_map (buf, &map, GST_MAP_WRITE)) {
+        gst_adapter_copy (mux->out_adapter, map.data, 0, align);
+        gst_buffer_unmap (buf, &map);
+        gst_adapter_flush (mux->out_adapter, align);
+      } else {
+        GST_WARNING_OBJECT (mux, "Failed to map output buffer");
+        gst_buffer_unref (buf);
+        buf = gst_adapter_take_buffer (mux->out_adapter, align);
+      }
+    }
 
     GST_BUFFER_PTS (buf) = pts;
 
@@ -1918,7 +1986,8 @@ gst_base_ts_mux_default_allocate_packet (GstBaseTsMux * mux,
 {
   GstBuffer *buf;
 
-  buf = gst_buffer_new_and_alloc (mux->packet_size);
+  buf = gst_base_ts_mux_acquire_buffer (mux, &mux->packet_pool,
+      &mux->packet_pool_size, mux->packet_size);
 
   *buffer = buf;
 }
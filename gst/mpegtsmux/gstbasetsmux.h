@@ -197,6 +197,12 @@ struct GstBaseTsMux {
   /* output buffer aggregation */
   GstAdapter *out_adapter;
   GstBuffer *out_buffer;
+
+  /* recycled buffers for single packets and for aligned output units */
+  GstBufferPool *packet_pool;
+  gsize packet_pool_size;
+  GstBufferPool *unit_pool;
+  gsize unit_pool_size;
 };
 
 /**
@@ -66,6 +66,11 @@ enum
   PROP_MAX_KBPS,
   PROP_MAX_BUCKET_SIZE,
   PROP_ALLOW_REORDERING,
+  PROP_GILBERT_ELLIOTT_P,
+  PROP_GILBERT_ELLIOTT_R,
+  PROP_GILBERT_ELLIOTT_GOOD_LOSS,
+  PROP_GILBERT_ELLIOTT_BAD_LOSS,
+  PROP_TRACE_FILE,
 };
 
 /* these numbers are nothing but wild guesses and don't reflect any reality */
@@ -79,6 +84,25 @@ enum
 #define DEFAULT_MAX_KBPS -1
 #define DEFAULT_MAX_BUCKET_SIZE -1
 #define DEFAULT_ALLOW_REORDERING TRUE
+#define DEFAULT_GILBERT_ELLIOTT_P 0.0
+#define DEFAULT_GILBERT_ELLIOTT_R 1.0
+#define DEFAULT_GILBERT_ELLIOTT_GOOD_LOSS 0.0
+#define DEFAULT_GILBERT_ELLIOTT_BAD_LOSS 1.0
+#define DEFAULT_TRACE_FILE NULL
+
+/* The delay queue is a timer wheel of WHEEL_SIZE slots of WHEEL_RESOLUTION
+ * microseconds. Delayed packets are hashed into the slot of their ready
+ * time, and a single GSource releases all the packets that are due at once,
+ * as a buffer list. The wheel only covers one turn from wheel_time, packets
+ * due later wait in a sorted overflow queue until their slot comes into
+ * range, so a slot only ever holds packets of the same turn. */
+#define WHEEL_SIZE 1024
+#define WHEEL_RESOLUTION 1000
+#define WHEEL_TICK(t) ((t) / WHEEL_RESOLUTION)
+#define WHEEL_SLOT(t) (WHEEL_TICK (t) & (WHEEL_SIZE - 1))
+
+/* each line of a trace file is an opportunity to send that many bytes */
+#define TRACE_MTU 1500
 
 static GstStaticPadTemplate gst_net_sim_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
@@ -94,12 +118,17 @@ GST_STATIC_PAD_TEMPLATE ("src",
 
 G_DEFINE_TYPE (GstNetSim, gst_net_sim, GST_TYPE_ELEMENT);
 
+typedef struct
+{
+  GstBuffer *buf;
+  gint64 ready_time;
+} NetSimPacket;
+
 static gboolean
 gst_net_sim_source_dispatch (GSource * source,
     GSourceFunc callback, gpointer user_data)
 {
-  callback (user_data);
-  return FALSE;
+  return callback (user_data);
 }
 
 GSourceFuncs gst_net_sim_source_funcs = {
@@ -147,6 +176,315 @@ _main_loop_quit_and_remove_source (gpointer user_data)
   return FALSE;                 /* Remove source */
 }
 
+/* Must be called with the loop_mutex */
+static void
+gst_net_sim_overflow_push (GstNetSim * netsim, NetSimPacket * packet)
+{
+  GList *l;
+
+  /* Packets mostly come in order, look for their place from the end */
+  for (l = netsim->overflow.tail; l; l = l->prev) {
+    if (((NetSimPacket *) l->data)->ready_time <= packet->ready_time)
+      break;
+  }
+
+  if (l)
+    g_queue_insert_after (&netsim->overflow, l, packet);
+  else
+    g_queue_push_head (&netsim->overflow, packet);
+}
+
+/* Must be called with the loop_mutex */
+static void
+gst_net_sim_wheel_insert (GstNetSim * netsim, NetSimPacket * packet)
+{
+  if (WHEEL_TICK (packet->ready_time) >=
+      WHEEL_TICK (netsim->wheel_time) + WHEEL_SIZE)
+    gst_net_sim_overflow_push (netsim, packet);
+  else
+    g_queue_push_tail (&netsim->wheel[WHEEL_SLOT (packet->ready_time)],
+        packet);
+}
+
+/* Moves the overflowing packets that are now in range into the wheel. Must
+ * be called with the loop_mutex, whenever wheel_time moves forward. */
+static void
+gst_net_sim_wheel_cascade (GstNetSim * netsim)
+{
+  NetSimPacket *packet;
+
+  while ((packet = g_queue_peek_head (&netsim->overflow)) &&
+      WHEEL_TICK (packet->ready_time) <
+      WHEEL_TICK (netsim->wheel_time) + WHEEL_SIZE) {
+    g_queue_pop_head (&netsim->overflow);
+    g_queue_push_tail (&netsim->wheel[WHEEL_SLOT (packet->ready_time)],
+        packet);
+  }
+}
+
+/* Must be called with the loop_mutex */
+static void
+gst_net_sim_wheel_push (GstNetSim * netsim, GstBuffer * buf,
+    gint64 ready_time)
+{
+  NetSimPacket *packet = g_slice_new (NetSimPacket);
+  gint64 source_ready_time;
+
+  /* The slots before wheel_time have already been swept */
+  if (ready_time < netsim->wheel_time)
+    ready_time = netsim->wheel_time;
+
+  packet->buf = gst_buffer_ref (buf);
+  packet->ready_time = ready_time;
+  gst_net_sim_wheel_insert (netsim, packet);
+  netsim->wheel_count++;
+
+  source_ready_time = g_source_get_ready_time (netsim->wheel_source);
+  if (source_ready_time == -1 || ready_time < source_ready_time)
+    g_source_set_ready_time (netsim->wheel_source, ready_time);
+}
+
+/* Must be called with the loop_mutex */
+static GstBufferList *
+gst_net_sim_wheel_pop_ready (GstNetSim * netsim, gint64 now)
+{
+  GstBufferList *list = NULL;
+  NetSimPacket *packet;
+  gint64 tick, last_tick;
+
+  while (netsim->wheel_count > 0) {
+    /* With only overflowing packets, skip right to the first one */
+    if (netsim->wheel_count == g_queue_get_length (&netsim->overflow)) {
+      packet = g_queue_peek_head (&netsim->overflow);
+      if (packet->ready_time > now)
+        break;
+      netsim->wheel_time = MAX (netsim->wheel_time,
+          WHEEL_TICK (packet->ready_time) * WHEEL_RESOLUTION);
+      gst_net_sim_wheel_cascade (netsim);
+    }
+
+    /* Sweep at most one turn at a time, so that the overflowing packets
+     * get their slot before it is swept */
+    last_tick = MIN (WHEEL_TICK (now),
+        WHEEL_TICK (netsim->wheel_time) + WHEEL_SIZE - 1);
+
+    for (tick = WHEEL_TICK (netsim->wheel_time); tick <= last_tick; tick++) {
+      GQueue *slot = &netsim->wheel[tick & (WHEEL_SIZE - 1)];
+      GList *l = slot->head;
+
+      while (l) {
+        GList *next = l->next;
+
+        packet = l->data;
+        if (packet->ready_time <= now) {
+          if (!list)
+            list = gst_buffer_list_new ();
+          gst_buffer_list_add (list, packet->buf);
+          g_slice_free (NetSimPacket, packet);
+          g_queue_delete_link (slot, l);
+          netsim->wheel_count--;
+        }
+
+        l = next;
+      }
+    }
+
+    if (last_tick == WHEEL_TICK (now))
+      break;
+
+    netsim->wheel_time = (last_tick + 1) * WHEEL_RESOLUTION;
+    gst_net_sim_wheel_cascade (netsim);
+  }
+
+  if (now > netsim->wheel_time) {
+    netsim->wheel_time = now;
+    gst_net_sim_wheel_cascade (netsim);
+  }
+
+  return list;
+}
+
+/* Must be called with the loop_mutex, returns -1 if the wheel is empty */
+static gint64
+gst_net_sim_wheel_next_ready_time (GstNetSim * netsim)
+{
+  NetSimPacket *packet;
+  gint64 t, ready_time = -1;
+  guint n;
+  GList *l;
+
+  if (netsim->wheel_count == 0)
+    return -1;
+
+  /* All the packets of a slot are due in the same tick, the first
+   * non-empty slot has the next ones */
+  if (netsim->wheel_count > g_queue_get_length (&netsim->overflow)) {
+    for (t = netsim->wheel_time, n = 0; n < WHEEL_SIZE;
+        t += WHEEL_RESOLUTION, n++) {
+      for (l = netsim->wheel[WHEEL_SLOT (t)].head; l; l = l->next) {
+        packet = l->data;
+        if (ready_time == -1 || packet->ready_time < ready_time)
+          ready_time = packet->ready_time;
+      }
+
+      if (ready_time != -1)
+        return ready_time;
+    }
+  }
+
+  packet = g_queue_peek_head (&netsim->overflow);
+
+  return packet->ready_time;
+}
+
+/* Must be called with the loop_mutex */
+static void
+gst_net_sim_wheel_clear (GstNetSim * netsim)
+{
+  NetSimPacket *packet;
+  guint n;
+
+  for (n = 0; n < WHEEL_SIZE; n++) {
+    while ((packet = g_queue_pop_head (&netsim->wheel[n]))) {
+      gst_buffer_unref (packet->buf);
+      g_slice_free (NetSimPacket, packet);
+    }
+  }
+  while ((packet = g_queue_pop_head (&netsim->overflow))) {
+    gst_buffer_unref (packet->buf);
+    g_slice_free (NetSimPacket, packet);
+  }
+  netsim->wheel_count = 0;
+}
+
+static gboolean
+gst_net_sim_wheel_release (GstNetSim * netsim)
+{
+  GstBufferList *list;
+
+  g_mutex_lock (&netsim->loop_mutex);
+  list = gst_net_sim_wheel_pop_ready (netsim, g_get_monotonic_time ());
+  g_source_set_ready_time (netsim->wheel_source,
+      gst_net_sim_wheel_next_ready_time (netsim));
+
+  if (!list) {
+    g_mutex_unlock (&netsim->loop_mutex);
+    return G_SOURCE_CONTINUE;
+  }
+
+  /* Not pushed with the lock, the streaming thread would be blocked for
+   * as long as downstream takes. Without reordering, the buffers coming in
+   * meanwhile go through the wheel to stay behind these ones. */
+  netsim->wheel_releasing = TRUE;
+  g_mutex_unlock (&netsim->loop_mutex);
+
+  GST_LOG_OBJECT (netsim, "Releasing %u delayed packets",
+      gst_buffer_list_length (list));
+  gst_pad_push_list (netsim->srcpad, list);
+
+  g_mutex_lock (&netsim->loop_mutex);
+  netsim->wheel_releasing = FALSE;
+  g_mutex_unlock (&netsim->loop_mutex);
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Must be called with the loop_mutex */
+static gboolean
+gst_net_sim_load_trace (GstNetSim * netsim)
+{
+  GstNetSimTraceEntry *last;
+  GError *err = NULL;
+  gchar *contents;
+  gchar **lines;
+  guint i;
+
+  g_clear_pointer (&netsim->trace, g_array_unref);
+  netsim->trace_start = -1;
+  netsim->trace_index = 0;
+  netsim->trace_time = 0;
+  netsim->trace_bytes_left = 0;
+  netsim->trace_delay = 0;
+  netsim->trace_drop_probability = 0;
+
+  if (!netsim->trace_file)
+    return TRUE;
+
+  if (!g_file_get_contents (netsim->trace_file, &contents, NULL, &err)) {
+    GST_ELEMENT_ERROR (netsim, RESOURCE, OPEN_READ,
+        ("Could not read trace file \"%s\"", netsim->trace_file),
+        ("%s", err->message));
+    g_error_free (err);
+    return FALSE;
+  }
+
+  netsim->trace = g_array_new (FALSE, FALSE, sizeof (GstNetSimTraceEntry));
+  lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+
+  for (i = 0; lines[i]; i++) {
+    GstNetSimTraceEntry entry = { 0, -1, -1 };
+    gchar *line = g_strstrip (lines[i]);
+    gchar *end;
+
+    if (line[0] == '\0' || line[0] == '#')
+      continue;
+
+    entry.time = g_ascii_strtoll (line, &end, 10);
+    if (end == line || entry.time < 0)
+      goto parse_error;
+
+    line = g_strchug (end);
+    if (line[0] != '\0') {
+      entry.delay = g_ascii_strtoll (line, &end, 10);
+      if (end == line || entry.delay < 0)
+        goto parse_error;
+
+      line = g_strchug (end);
+      if (line[0] != '\0') {
+        entry.drop_probability = g_ascii_strtod (line, &end);
+        if (end == line || *end != '\0' || entry.drop_probability < 0 ||
+            entry.drop_probability > 1)
+          goto parse_error;
+      }
+    }
+
+    entry.time *= 1000;
+    if (netsim->trace->len > 0 && entry.time <
+        g_array_index (netsim->trace, GstNetSimTraceEntry,
+            netsim->trace->len - 1).time)
+      goto parse_error;
+
+    g_array_append_val (netsim->trace, entry);
+  }
+  g_strfreev (lines);
+
+  if (netsim->trace->len == 0) {
+    GST_ELEMENT_ERROR (netsim, RESOURCE, READ,
+        ("Trace file \"%s\" is empty", netsim->trace_file), (NULL));
+    g_clear_pointer (&netsim->trace, g_array_unref);
+    return FALSE;
+  }
+
+  /* Like Mahimahi, the trace loops at its last timestamp */
+  last = &g_array_index (netsim->trace, GstNetSimTraceEntry,
+      netsim->trace->len - 1);
+  netsim->trace_period = MAX (last->time, WHEEL_RESOLUTION);
+
+  GST_DEBUG_OBJECT (netsim, "Loaded %u trace entries over %" G_GINT64_FORMAT
+      "ms", netsim->trace->len, netsim->trace_period / 1000);
+
+  return TRUE;
+
+parse_error:
+  GST_ELEMENT_ERROR (netsim, RESOURCE, READ,
+      ("Invalid line %u in trace file \"%s\"", i + 1, netsim->trace_file),
+      (NULL));
+  g_strfreev (lines);
+  g_clear_pointer (&netsim->trace, g_array_unref);
+  return FALSE;
+}
+
 static gboolean
 gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
     GstPadMode mode, gboolean active)
@@ -157,8 +495,23 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
   g_mutex_lock (&netsim->loop_mutex);
   if (active) {
     if (netsim->main_loop == NULL) {
-      GMainContext *main_context = g_main_context_new ();
+      GMainContext *main_context;
+
+      if (!gst_net_sim_load_trace (netsim)) {
+        g_mutex_unlock (&netsim->loop_mutex);
+        return FALSE;
+      }
+
+      main_context = g_main_context_new ();
       netsim->main_loop = g_main_loop_new (main_context, FALSE);
+
+      netsim->wheel_time = g_get_monotonic_time ();
+      netsim->last_ready_time = 0;
+      netsim->wheel_source = g_source_new (&gst_net_sim_source_funcs,
+          sizeof (GSource));
+      g_source_set_callback (netsim->wheel_source,
+          (GSourceFunc) gst_net_sim_wheel_release, netsim, NULL);
+      g_source_attach (netsim->wheel_source, main_context);
       g_main_context_unref (main_context);
 
       GST_TRACE_OBJECT (netsim, "ACT: Starting task on srcpad");
@@ -198,6 +551,11 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
       GST_TRACE_OBJECT (netsim, "DEACT: Stopping task on srcpad");
       result = gst_pad_stop_task (netsim->srcpad);
       GST_TRACE_OBJECT (netsim, "DEACT: Mainloop and GstTask stopped");
+
+      g_source_destroy (netsim->wheel_source);
+      g_source_unref (netsim->wheel_source);
+      netsim->wheel_source = NULL;
+      gst_net_sim_wheel_clear (netsim);
     }
   }
   g_mutex_unlock (&netsim->loop_mutex);
@@ -205,39 +563,6 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
   return result;
 }
 
-typedef struct
-{
-  GstPad *pad;
-  GstBuffer *buf;
-} PushBufferCtx;
-
-static inline PushBufferCtx *
-push_buffer_ctx_new (GstPad * pad, GstBuffer * buf)
-{
-  PushBufferCtx *ctx = g_slice_new (PushBufferCtx);
-  ctx->pad = gst_object_ref (pad);
-  ctx->buf = gst_buffer_ref (buf);
-  return ctx;
-}
-
-static inline void
-push_buffer_ctx_free (PushBufferCtx * ctx)
-{
-  if (G_LIKELY (ctx != NULL)) {
-    gst_buffer_unref (ctx->buf);
-    gst_object_unref (ctx->pad);
-    g_slice_free (PushBufferCtx, ctx);
-  }
-}
-
-static gboolean
-push_buffer_ctx_push (PushBufferCtx * ctx)
-{
-  GST_DEBUG_OBJECT (ctx->pad, "Pushing buffer now");
-  gst_pad_push (ctx->pad, gst_buffer_ref (ctx->buf));
-  return FALSE;
-}
-
 static gint
 get_random_value_uniform (GRand * rand_seed, gint32 min_value, gint32 max_value)
 {
@@ -326,18 +651,84 @@ get_random_value_gamma (GRand * rand_seed, gint32 low, gint32 high,
   return round (x + low);
 }
 
+/* Returns the time at which a packet of @size bytes arriving at @now leaves
+ * the link described by the trace. Each entry of the trace is an opportunity
+ * to send TRACE_MTU bytes, and the opportunities in the past are lost, as
+ * on a real link that was idle. Must be called with the loop_mutex. */
+static gint64
+gst_net_sim_trace_get_departure (GstNetSim * netsim, gint64 now, gsize size)
+{
+  if (netsim->trace_start == -1)
+    netsim->trace_start = now;
+
+  /* Skip the whole turns of the trace the link was idle for */
+  if (netsim->trace_time < now &&
+      now - netsim->trace_start >= netsim->trace_period) {
+    netsim->trace_start += (now - netsim->trace_start) /
+        netsim->trace_period * netsim->trace_period;
+    netsim->trace_index = 0;
+    netsim->trace_bytes_left = 0;
+  }
+
+  while (TRUE) {
+    GstNetSimTraceEntry *entry;
+
+    if (netsim->trace_bytes_left > 0 && netsim->trace_time >= now) {
+      gsize taken = MIN (size, netsim->trace_bytes_left);
+
+      size -= taken;
+      netsim->trace_bytes_left -= taken;
+      if (size == 0)
+        return netsim->trace_time;
+    }
+
+    entry = &g_array_index (netsim->trace, GstNetSimTraceEntry,
+        netsim->trace_index);
+    netsim->trace_time = netsim->trace_start + entry->time;
+    netsim->trace_bytes_left = TRACE_MTU;
+    if (entry->delay >= 0)
+      netsim->trace_delay = entry->delay;
+    if (entry->drop_probability >= 0)
+      netsim->trace_drop_probability = entry->drop_probability;
+
+    if (++netsim->trace_index == netsim->trace->len) {
+      netsim->trace_index = 0;
+      netsim->trace_start += netsim->trace_period;
+    }
+  }
+}
+
 static GstFlowReturn
 gst_net_sim_delay_buffer (GstNetSim * netsim, GstBuffer * buf)
 {
   GstFlowReturn ret = GST_FLOW_OK;
+  gint64 ready_time, now_time;
 
   g_mutex_lock (&netsim->loop_mutex);
-  if (netsim->main_loop != NULL && netsim->delay_probability > 0 &&
+  if (netsim->main_loop == NULL) {
+    ret = gst_pad_push (netsim->srcpad, gst_buffer_ref (buf));
+    goto done;
+  }
+
+  now_time = g_get_monotonic_time ();
+  ready_time = now_time;
+
+  if (netsim->trace) {
+    ready_time = gst_net_sim_trace_get_departure (netsim, now_time,
+        gst_buffer_get_size (buf));
+
+    if (netsim->trace_drop_probability > 0 &&
+        g_rand_double (netsim->rand_seed) < netsim->trace_drop_probability) {
+      GST_DEBUG_OBJECT (netsim, "Dropping packet from trace");
+      goto done;
+    }
+
+    ready_time += netsim->trace_delay * 1000;
+  }
+
+  if (netsim->delay_probability > 0 &&
       g_rand_double (netsim->rand_seed) < netsim->delay_probability) {
     gint delay;
-    PushBufferCtx *ctx;
-    GSource *source;
-    gint64 ready_time, now_time;
 
     switch (netsim->delay_distribution) {
       case DISTRIBUTION_UNIFORM:
@@ -357,29 +748,26 @@ gst_net_sim_delay_buffer (GstNetSim * netsim, GstBuffer * buf)
         break;
     }
 
-    if (delay < 0)
-      delay = 0;
-
-    ctx = push_buffer_ctx_new (netsim->srcpad, buf);
+    if (delay > 0)
+      ready_time += delay * 1000;
+  }
 
-    source = g_source_new (&gst_net_sim_source_funcs, sizeof (GSource));
-    now_time = g_get_monotonic_time ();
-    ready_time = now_time + delay * 1000;
-    if (!netsim->allow_reordering && ready_time < netsim->last_ready_time)
-      ready_time = netsim->last_ready_time + 1;
+  if (!netsim->allow_reordering && ready_time < netsim->last_ready_time)
+    ready_time = netsim->last_ready_time + 1;
+  netsim->last_ready_time = ready_time;
 
-    netsim->last_ready_time = ready_time;
+  /* Without reordering, packets that are not delayed still have to wait for
+   * the delayed ones */
+  if (ready_time > now_time || (!netsim->allow_reordering &&
+          (netsim->wheel_count > 0 || netsim->wheel_releasing))) {
     GST_DEBUG_OBJECT (netsim, "Delaying packet by %" G_GINT64_FORMAT "ms",
         (ready_time - now_time) / 1000);
-
-    g_source_set_ready_time (source, ready_time);
-    g_source_set_callback (source, (GSourceFunc) push_buffer_ctx_push,
-        ctx, (GDestroyNotify) push_buffer_ctx_free);
-    g_source_attach (source, g_main_loop_get_context (netsim->main_loop));
-    g_source_unref (source);
+    gst_net_sim_wheel_push (netsim, buf, ready_time);
   } else {
     ret = gst_pad_push (netsim->srcpad, gst_buffer_ref (buf));
   }
+
+done:
   g_mutex_unlock (&netsim->loop_mutex);
 
   return ret;
@@ -468,6 +856,25 @@ gst_net_sim_token_bucket (GstNetSim * netsim, GstBuffer * buf)
   return TRUE;
 }
 
+/* Moves between the good and the bad state of the Gilbert-Elliott model,
+ * then decides whether to drop with the loss probability of the new state */
+static gboolean
+gst_net_sim_gilbert_elliott_drop (GstNetSim * netsim)
+{
+  gfloat loss;
+
+  if (netsim->ge_bad) {
+    if (g_rand_double (netsim->rand_seed) < (gdouble) netsim->ge_r)
+      netsim->ge_bad = FALSE;
+  } else if (g_rand_double (netsim->rand_seed) < (gdouble) netsim->ge_p) {
+    netsim->ge_bad = TRUE;
+  }
+
+  loss = netsim->ge_bad ? netsim->ge_bad_loss : netsim->ge_good_loss;
+
+  return loss > 0 && g_rand_double (netsim->rand_seed) < (gdouble) loss;
+}
+
 static GstFlowReturn
 gst_net_sim_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -485,6 +892,10 @@ gst_net_sim_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
       && g_rand_double (netsim->rand_seed) <
       (gdouble) netsim->drop_probability) {
     GST_DEBUG_OBJECT (netsim, "Dropping packet");
+  } else if ((netsim->ge_p > 0 || netsim->ge_bad) &&
+      gst_net_sim_gilbert_elliott_drop (netsim)) {
+    GST_DEBUG_OBJECT (netsim, "Dropping packet (%s state)",
+        netsim->ge_bad ? "bad" : "good");
   } else if (netsim->duplicate_probability > 0 &&
       g_rand_double (netsim->rand_seed) <
       (gdouble) netsim->duplicate_probability) {
@@ -540,6 +951,24 @@ gst_net_sim_set_property (GObject * object,
     case PROP_ALLOW_REORDERING:
       netsim->allow_reordering = g_value_get_boolean (value);
       break;
+    case PROP_GILBERT_ELLIOTT_P:
+      netsim->ge_p = g_value_get_float (value);
+      break;
+    case PROP_GILBERT_ELLIOTT_R:
+      netsim->ge_r = g_value_get_float (value);
+      break;
+    case PROP_GILBERT_ELLIOTT_GOOD_LOSS:
+      netsim->ge_good_loss = g_value_get_float (value);
+      break;
+    case PROP_GILBERT_ELLIOTT_BAD_LOSS:
+      netsim->ge_bad_loss = g_value_get_float (value);
+      break;
+    case PROP_TRACE_FILE:
+      g_mutex_lock (&netsim->loop_mutex);
+      g_free (netsim->trace_file);
+      netsim->trace_file = g_value_dup_string (value);
+      g_mutex_unlock (&netsim->loop_mutex);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -583,6 +1012,23 @@ gst_net_sim_get_property (GObject * object,
     case PROP_ALLOW_REORDERING:
       g_value_set_boolean (value, netsim->allow_reordering);
       break;
+    case PROP_GILBERT_ELLIOTT_P:
+      g_value_set_float (value, netsim->ge_p);
+      break;
+    case PROP_GILBERT_ELLIOTT_R:
+      g_value_set_float (value, netsim->ge_r);
+      break;
+    case PROP_GILBERT_ELLIOTT_GOOD_LOSS:
+      g_value_set_float (value, netsim->ge_good_loss);
+      break;
+    case PROP_GILBERT_ELLIOTT_BAD_LOSS:
+      g_value_set_float (value, netsim->ge_bad_loss);
+      break;
+    case PROP_TRACE_FILE:
+      g_mutex_lock (&netsim->loop_mutex);
+      g_value_set_string (value, netsim->trace_file);
+      g_mutex_unlock (&netsim->loop_mutex);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -606,6 +1052,8 @@ gst_net_sim_init (GstNetSim * netsim)
   netsim->rand_seed = g_rand_new ();
   netsim->main_loop = NULL;
   netsim->prev_time = GST_CLOCK_TIME_NONE;
+  netsim->wheel = g_new0 (GQueue, WHEEL_SIZE);
+  g_queue_init (&netsim->overflow);
 
   GST_OBJECT_FLAG_SET (netsim->sinkpad,
       GST_PAD_FLAG_PROXY_CAPS | GST_PAD_FLAG_PROXY_ALLOCATION);
@@ -622,6 +1070,10 @@ gst_net_sim_finalize (GObject * object)
   GstNetSim *netsim = GST_NET_SIM (object);
 
   g_rand_free (netsim->rand_seed);
+  g_free (netsim->wheel);
+  g_free (netsim->trace_file);
+  if (netsim->trace)
+    g_array_unref (netsim->trace);
   g_mutex_clear (&netsim->loop_mutex);
   g_cond_clear (&netsim->start_cond);
 
@@ -746,6 +1198,8 @@ gst_net_sim_class_init (GstNetSimClass * klass)
    * default this is enabled, but in the real world packet reordering is
    * fairly uncommon, yet the delay functions will always introduce reordering
    * if delay > packet-spacing, This property allows switching that off.
+   * When switched off, the buffers that are not delayed also wait for the
+   * delayed ones, so that the output is in the same order as the input.
    *
    * Since: 1.14
    */
@@ -755,6 +1209,91 @@ gst_net_sim_class_init (GstNetSimClass * klass)
           DEFAULT_ALLOW_REORDERING,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstNetSim:gilbert-elliott-p:
+   *
+   * Probability to go from the good to the bad state of the Gilbert-Elliott
+   * burst loss model, for every buffer. Setting this property to a positive
+   * value enables the model. The average burst length is 1 /
+   * "gilbert-elliott-r" buffers.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_GILBERT_ELLIOTT_P,
+      g_param_spec_float ("gilbert-elliott-p", "Gilbert-Elliott p",
+          "Probability to go from the good to the bad state of the "
+          "Gilbert-Elliott model (0 = disabled)",
+          0.0, 1.0, DEFAULT_GILBERT_ELLIOTT_P,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:gilbert-elliott-r:
+   *
+   * Probability to go from the bad to the good state of the Gilbert-Elliott
+   * burst loss model, for every buffer.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_GILBERT_ELLIOTT_R,
+      g_param_spec_float ("gilbert-elliott-r", "Gilbert-Elliott r",
+          "Probability to go from the bad to the good state of the "
+          "Gilbert-Elliott model",
+          0.0, 1.0, DEFAULT_GILBERT_ELLIOTT_R,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:gilbert-elliott-good-loss:
+   *
+   * Probability a buffer is dropped in the good state of the
+   * Gilbert-Elliott model (1 - k).
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_GILBERT_ELLIOTT_GOOD_LOSS,
+      g_param_spec_float ("gilbert-elliott-good-loss",
+          "Gilbert-Elliott good loss",
+          "Probability a buffer is dropped in the good state",
+          0.0, 1.0, DEFAULT_GILBERT_ELLIOTT_GOOD_LOSS,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:gilbert-elliott-bad-loss:
+   *
+   * Probability a buffer is dropped in the bad state of the Gilbert-Elliott
+   * model (1 - h).
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_GILBERT_ELLIOTT_BAD_LOSS,
+      g_param_spec_float ("gilbert-elliott-bad-loss",
+          "Gilbert-Elliott bad loss",
+          "Probability a buffer is dropped in the bad state",
+          0.0, 1.0, DEFAULT_GILBERT_ELLIOTT_BAD_LOSS,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:trace-file:
+   *
+   * A trace to replay, in the format of Mahimahi link traces: every line
+   * holds a timestamp in milliseconds at which the link can deliver 1500
+   * bytes, and the trace loops at its last timestamp. Buffers are queued
+   * until enough delivery opportunities are available. Lines can
+   * optionally be followed by a delay in milliseconds and a drop
+   * probability, which apply to the buffers sent from that timestamp on,
+   * e.g. "120 40 0.01". Lines starting with '#' are ignored.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_TRACE_FILE,
+      g_param_spec_string ("trace-file", "Trace File",
+          "Mahimahi-style trace of the delivery opportunities of the link, "
+          "optionally with delay and drop probability columns",
+          DEFAULT_TRACE_FILE,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (netsim_debug, "netsim", 0, "Network simulator");
 
   gst_type_mark_as_plugin_api (distribution_get_type (), 0);
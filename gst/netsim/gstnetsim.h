@@ -60,6 +60,13 @@ typedef struct
   gdouble z1;
 } NormalDistributionState;
 
+typedef struct
+{
+  gint64 time;                  /* us, from the start of the trace */
+  gint delay;                   /* ms, -1 if not set */
+  gfloat drop_probability;      /* -1 if not set */
+} GstNetSimTraceEntry;
+
 struct _GstNetSim
 {
   GstElement parent;
@@ -77,6 +84,28 @@ struct _GstNetSim
   NormalDistributionState delay_state;
   gint64 last_ready_time;
 
+  /* delay queue, a timer wheel of NetSimPacket released by wheel_source,
+   * with the packets due after one turn in overflow */
+  GQueue *wheel;
+  GQueue overflow;
+  guint wheel_count;
+  gint64 wheel_time;
+  GSource *wheel_source;
+  gboolean wheel_releasing;
+
+  /* Gilbert-Elliott state */
+  gboolean ge_bad;
+
+  /* trace replay */
+  GArray *trace;
+  gint64 trace_period;
+  gint64 trace_start;
+  guint trace_index;
+  gint64 trace_time;
+  gsize trace_bytes_left;
+  gint trace_delay;
+  gfloat trace_drop_probability;
+
   /* properties */
   gint min_delay;
   gint max_delay;
@@ -88,6 +117,11 @@ struct _GstNetSim
   gint max_kbps;
   gint max_bucket_size;
   gboolean allow_reordering;
+  gfloat ge_p;
+  gfloat ge_r;
+  gfloat ge_good_loss;
+  gfloat ge_bad_loss;
+  gchar *trace_file;
 };
 
 struct _GstNetSimClass
@@ -72,10 +72,33 @@ typedef struct {
 } GstRistRtpDeextClass;
 GType gst_rist_rtp_deext_get_type (void);
 
+#define GST_TYPE_RIST_DISPATCHER   (gst_rist_dispatcher_get_type())
+#define GST_RIST_DISPATCHER(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_RIST_DISPATCHER,GstRistDispatcher))
+#define GST_IS_RIST_DISPATCHER(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_RIST_DISPATCHER))
+typedef struct _GstRistDispatcher GstRistDispatcher;
+typedef struct {
+  GstElementClass parent;
+} GstRistDispatcherClass;
+GType gst_rist_dispatcher_get_type (void);
+
+typedef enum
+{
+  GST_RIST_DISPATCHER_MODE_WEIGHTED,
+  GST_RIST_DISPATCHER_MODE_ADAPTIVE,
+  GST_RIST_DISPATCHER_MODE_DUPLICATE_WORST,
+} GstRistDispatcherMode;
+
+#define GST_TYPE_RIST_DISPATCHER_MODE (gst_rist_dispatcher_mode_get_type())
+GType gst_rist_dispatcher_mode_get_type (void);
+
 guint32 gst_rist_rtp_ext_seq (guint32 * extseqnum, guint16 seqnum);
 
 void gst_rist_rtx_send_set_extseqnum (GstRistRtxSend *self, guint32 ssrc,
     guint16 seqnum_ext);
 void gst_rist_rtx_send_clear_extseqnum (GstRistRtxSend *self, guint32 ssrc);
 
+void gst_rist_dispatcher_set_link_stats (GstRistDispatcher *disp, guint id,
+    GstClockTime rtt, GstClockTime timestamp, guint32 ext_highest_seq,
+    gint32 packets_lost);
+
 #endif
@@ -0,0 +1,791 @@
+/* GStreamer RIST plugin
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-ristdispatcher
+ * @title: ristdispatcher
+ * @see_also: ristsink, roundrobin
+ *
+ * This element distributes incoming buffers over multiple src pads, like
+ * the roundrobin element, but in proportion to a weight given to each
+ * link. It is used by ristsink to implement the "weighted", "adaptive" and
+ * "duplicate-worst" bonding methods.
+ *
+ * The static weight of each link is set through the "weights" property,
+ * which is a comma separated list indexed by the number of the src pads,
+ * so the first weight applies to "src_0". Links without weight get a
+ * weight of 1.
+ *
+ * In "adaptive" mode, the static weights are scaled by the delivery ratio
+ * of each link, and by how much longer its round trip time is compared to
+ * the fastest link. These statistics are provided by ristsink from the
+ * RTCP receiver reports of each session. In "duplicate-worst" mode, the
+ * buffers are dispatched as in "adaptive" mode, but the buffers that are
+ * sent over the worst link are also sent over the best one.
+ *
+ * The delivery ratio and the bandwidth of each link are derived from
+ * successive receiver reports: the difference of their extended highest
+ * sequence numbers and of their cumulative number of lost packets gives
+ * how many packets the link delivered over the report interval, which is
+ * compared to how many were sent over it. A link that delivers less than it
+ * is given is saturated, and its delivered rate is taken as its bandwidth.
+ * Its share of the buffers is then capped to that rate, and the rest is
+ * spread over the other links. The cap is raised by a tenth on every report
+ * without losses, and lifted once it exceeds the input rate.
+ *
+ * Buffers are dispatched using a smooth weighted round robin, so that
+ * consecutive buffers are interleaved over the links rather than sent in
+ * bursts. Buffer lists are split into one list per link, which are then
+ * pushed in one go.
+ *
+ * Since: 1.20
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+
+#include "gstrist.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_rist_dispatcher_debug);
+#define GST_CAT_DEFAULT gst_rist_dispatcher_debug
+
+/* links losing more than that are still used a little, so that we keep
+ * getting statistics about them */
+#define MIN_DELIVERY_RATIO 0.05
+#define MIN_RTT (1 * GST_MSECOND)
+
+/* links delivering less than that are saturated */
+#define SATURATED_DELIVERY_RATIO 0.98
+/* growth of the bandwidth of a saturated link, on every report without
+ * losses */
+#define BANDWIDTH_PROBE 1.1
+
+#define DEFAULT_MODE GST_RIST_DISPATCHER_MODE_WEIGHTED
+#define DEFAULT_WEIGHTS NULL
+
+enum
+{
+  PROP_0,
+  PROP_MODE,
+  PROP_WEIGHTS,
+};
+
+static GstStaticPadTemplate sink_templ = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("ANY"));
+
+static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src_%u",
+    GST_PAD_SRC,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS ("ANY"));
+
+typedef struct
+{
+  GstPad *pad;
+  guint id;
+
+  /* statistics, GST_CLOCK_TIME_NONE and 0 until known. The bandwidth is in
+   * packets per second, and stays 0 while the link is not saturated */
+  GstClockTime rtt;
+  gdouble loss;
+  gdouble bandwidth;
+
+  /* packets sent over the link, and counters as of the last report */
+  guint64 sent;
+  GstClockTime report_time;
+  guint32 report_ext_highest_seq;
+  gint32 report_packets_lost;
+  guint64 report_sent;
+  guint64 report_input;
+
+  /* effective weight, and smooth weighted round robin state */
+  gdouble weight;
+  gdouble current;
+} RistDispatcherLink;
+
+struct _GstRistDispatcher
+{
+  GstElement parent;
+
+  /* All protected by the object lock */
+  GstRistDispatcherMode mode;
+  gchar *weights_str;
+  GArray *weights;
+
+  GPtrArray *links;
+  guint64 n_input;
+  gdouble input_rate;
+  gdouble total_weight;
+  gint best;
+  gint worst;
+};
+
+G_DEFINE_TYPE_WITH_CODE (GstRistDispatcher, gst_rist_dispatcher,
+    GST_TYPE_ELEMENT, GST_DEBUG_CATEGORY_INIT (gst_rist_dispatcher_debug,
+        "ristdispatcher", 0, "RIST Bonding Dispatcher"));
+
+GType
+gst_rist_dispatcher_mode_get_type (void)
+{
+  static gsize id = 0;
+  static const GEnumValue values[] = {
+    {GST_RIST_DISPATCHER_MODE_WEIGHTED,
+        "GST_RIST_DISPATCHER_MODE_WEIGHTED", "weighted"},
+    {GST_RIST_DISPATCHER_MODE_ADAPTIVE,
+        "GST_RIST_DISPATCHER_MODE_ADAPTIVE", "adaptive"},
+    {GST_RIST_DISPATCHER_MODE_DUPLICATE_WORST,
+        "GST_RIST_DISPATCHER_MODE_DUPLICATE_WORST", "duplicate-worst"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&id)) {
+    GType tmp = g_enum_register_static ("GstRistDispatcherMode", values);
+    g_once_init_leave (&id, tmp);
+  }
+
+  return (GType) id;
+}
+
+static void
+rist_dispatcher_link_free (RistDispatcherLink * link)
+{
+  gst_object_unref (link->pad);
+  g_slice_free (RistDispatcherLink, link);
+}
+
+/* Lowers the weights so that no link is given more than its bandwidth, the
+ * share it cannot carry is spread over the other links in proportion to
+ * their weight. Must be called with the object lock. */
+static void
+gst_rist_dispatcher_limit_bandwidth (GstRistDispatcher * disp)
+{
+  gdouble free_share = 1.0, free_weight = 0;
+  gboolean *limited;
+  gboolean changed = TRUE;
+  gint i;
+
+  if (disp->input_rate <= 0)
+    return;
+
+  limited = g_newa (gboolean, disp->links->len);
+  for (i = 0; i < disp->links->len; i++) {
+    RistDispatcherLink *link = g_ptr_array_index (disp->links, i);
+
+    limited[i] = FALSE;
+    free_weight += link->weight;
+  }
+
+  /* Capping a link raises the share of the others, which may then exceed
+   * their own bandwidth */
+  while (changed && free_weight > 0) {
+    changed = FALSE;
+
+    for (i = 0; i < disp->links->len; i++) {
+      RistDispatcherLink *link = g_ptr_array_index (disp->links, i);
+      gdouble share;
+
+      if (limited[i] || link->bandwidth <= 0 || link->weight <= 0)
+        continue;
+
+      share = free_share * link->weight / free_weight;
+      if (share * disp->input_rate <= link->bandwidth)
+        continue;
+
+      free_weight -= link->weight;
+      link->weight = MIN (link->bandwidth / disp->input_rate, free_share);
+      free_share -= link->weight;
+      limited[i] = TRUE;
+      changed = TRUE;
+    }
+  }
+
+  for (i = 0; i < disp->links->len; i++) {
+    RistDispatcherLink *link = g_ptr_array_index (disp->links, i);
+
+    if (!limited[i] && free_weight > 0)
+      link->weight = free_share * link->weight / free_weight;
+  }
+}
+
+/* Must be called with the object lock, whenever the weights, the
+ * statistics or the links change */
+static void
+gst_rist_dispatcher_update_weights (GstRistDispatcher * disp)
+{
+  GstClockTime min_rtt = GST_CLOCK_TIME_NONE;
+  gint i;
+
+  disp->total_weight = 0;
+  disp->best = -1;
+  disp->worst = -1;
+
+  if (disp->mode != GST_RIST_DISPATCHER_MODE_WEIGHTED) {
+    for (i = 0; i < disp->links->len; i++) {
+      RistDispatcherLink *link = g_ptr_array_index (disp->links, i);
+
+      if (GST_CLOCK_TIME_IS_VALID (link->rtt))
+        min_rtt = MIN (min_rtt, MAX (link->rtt, MIN_RTT));
+    }
+  }
+
+  for (i = 0; i < disp->links->len; i++) {
+    RistDispatcherLink *link = g_ptr_array_index (disp->links, i);
+
+    link->weight = 1.0;
+    if (link->id < disp->weights->len)
+      link->weight = g_array_index (disp->weights, gdouble, link->id);
+
+    if (disp->mode != GST_RIST_DISPATCHER_MODE_WEIGHTED) {
+      link->weight *= MAX (1.0 - link->loss, MIN_DELIVERY_RATIO);
+      if (GST_CLOCK_TIME_IS_VALID (link->rtt) && link->rtt > min_rtt)
+        link->weight *= (gdouble) min_rtt / link->rtt;
+    }
+  }
+
+  if (disp->mode != GST_RIST_DISPATCHER_MODE_WEIGHTED)
+    gst_rist_dispatcher_limit_bandwidth (disp);
+
+  for (i = 0; i < disp->links->len; i++) {
+    RistDispatcherLink *link = g_ptr_array_index (disp->links, i);
+
+    disp->total_weight += link->weight;
+
+    if (link->weight <= 0)
+      continue;
+
+    if (disp->best < 0 || link->weight >
+        ((RistDispatcherLink *) g_ptr_array_index (disp->links,
+                disp->best))->weight)
+      disp->best = i;
+    if (disp->worst < 0 || link->weight <
+        ((RistDispatcherLink *) g_ptr_array_index (disp->links,
+                disp->worst))->weight)
+      disp->worst = i;
+  }
+
+  GST_DEBUG_OBJECT (disp, "Total weight %f, best link %d, worst link %d",
+      disp->total_weight, disp->best, disp->worst);
+}
+
+/* Smooth weighted round robin, as used by nginx: every link earns its
+ * weight, and the richest link pays back the total. The buffer is accounted
+ * to the picked link. Must be called with the object lock, returns -1 if no
+ * link can be used. */
+static gint
+gst_rist_dispatcher_pick (GstRistDispatcher * disp)
+{
+  RistDispatcherLink *best = NULL;
+  gint i, index = -1;
+
+  if (disp->total_weight <= 0)
+    return -1;
+
+  for (i = 0; i < disp->links->len; i++) {
+    RistDispatcherLink *link = g_ptr_array_index (disp->links, i);
+
+    link->current += link->weight;
+    if (link->weight > 0 && (!best || link->current > best->current)) {
+      best = link;
+      index = i;
+    }
+  }
+
+  best->current -= disp->total_weight;
+  best->sent++;
+  disp->n_input++;
+
+  return index;
+}
+
+/* Returns the link the buffer sent to @index should be duplicated to, or
+ * -1. The duplicate is accounted to that link. Must be called with the
+ * object lock. */
+static gint
+gst_rist_dispatcher_get_duplicate (GstRistDispatcher * disp, gint index)
+{
+  RistDispatcherLink *link;
+
+  if (disp->mode != GST_RIST_DISPATCHER_MODE_DUPLICATE_WORST)
+    return -1;
+
+  if (index != disp->worst || disp->worst == disp->best)
+    return -1;
+
+  link = g_ptr_array_index (disp->links, disp->best);
+  link->sent++;
+
+  return disp->best;
+}
+
+/* A link that is not linked is not fatal, as long as the others work */
+static GstFlowReturn
+gst_rist_dispatcher_combine_flows (GstFlowReturn ret, GstFlowReturn link_ret)
+{
+  if (ret != GST_FLOW_OK || link_ret == GST_FLOW_NOT_LINKED)
+    return ret;
+
+  return link_ret;
+}
+
+static GstFlowReturn
+gst_rist_dispatcher_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstRistDispatcher *disp = GST_RIST_DISPATCHER (parent);
+  GstPad *src_pad = NULL, *dup_pad = NULL;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gint index, dup;
+
+  GST_OBJECT_LOCK (disp);
+  index = gst_rist_dispatcher_pick (disp);
+  if (index >= 0) {
+    RistDispatcherLink *link = g_ptr_array_index (disp->links, index);
+
+    src_pad = gst_object_ref (link->pad);
+
+    dup = gst_rist_dispatcher_get_duplicate (disp, index);
+    if (dup >= 0) {
+      link = g_ptr_array_index (disp->links, dup);
+      dup_pad = gst_object_ref (link->pad);
+    }
+  }
+  GST_OBJECT_UNLOCK (disp);
+
+  if (!src_pad) {
+    /* no pad, that's fine */
+    gst_buffer_unref (buffer);
+    return GST_FLOW_OK;
+  }
+
+  if (dup_pad) {
+    ret = gst_rist_dispatcher_combine_flows (ret,
+        gst_pad_push (dup_pad, gst_buffer_ref (buffer)));
+    gst_object_unref (dup_pad);
+  }
+
+  ret = gst_rist_dispatcher_combine_flows (ret, gst_pad_push (src_pad,
+          buffer));
+  gst_object_unref (src_pad);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_rist_dispatcher_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstRistDispatcher *disp = GST_RIST_DISPATCHER (parent);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBufferList **lists;
+  GstPad **pads;
+  guint i, len, n_links;
+
+  GST_OBJECT_LOCK (disp);
+  n_links = disp->links->len;
+  if (n_links == 0) {
+    GST_OBJECT_UNLOCK (disp);
+    gst_buffer_list_unref (list);
+    return GST_FLOW_OK;
+  }
+
+  lists = g_newa (GstBufferList *, n_links);
+  pads = g_newa (GstPad *, n_links);
+  for (i = 0; i < n_links; i++) {
+    RistDispatcherLink *link = g_ptr_array_index (disp->links, i);
+
+    lists[i] = NULL;
+    pads[i] = gst_object_ref (link->pad);
+  }
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len; i++) {
+    GstBuffer *buffer = gst_buffer_list_get (list, i);
+    gint index, dup;
+
+    index = gst_rist_dispatcher_pick (disp);
+    if (index < 0)
+      break;
+
+    if (!lists[index])
+      lists[index] = gst_buffer_list_new_sized (len);
+    gst_buffer_list_add (lists[index], gst_buffer_ref (buffer));
+
+    dup = gst_rist_dispatcher_get_duplicate (disp, index);
+    if (dup >= 0) {
+      if (!lists[dup])
+        lists[dup] = gst_buffer_list_new_sized (len);
+      gst_buffer_list_add (lists[dup], gst_buffer_ref (buffer));
+    }
+  }
+  GST_OBJECT_UNLOCK (disp);
+
+  gst_buffer_list_unref (list);
+
+  for (i = 0; i < n_links; i++) {
+    if (lists[i])
+      ret = gst_rist_dispatcher_combine_flows (ret,
+          gst_pad_push_list (pads[i], lists[i]));
+    gst_object_unref (pads[i]);
+  }
+
+  return ret;
+}
+
+static GstPad *
+gst_rist_dispatcher_request_pad (GstElement * element, GstPadTemplate * templ,
+    const gchar * name, const GstCaps * caps)
+{
+  GstRistDispatcher *disp = GST_RIST_DISPATCHER (element);
+  RistDispatcherLink *link;
+  GstPad *pad;
+  guint id;
+
+  if (name) {
+    pad = gst_element_get_static_pad (element, name);
+    if (pad) {
+      gst_object_unref (pad);
+      return NULL;
+    }
+
+    if (sscanf (name, "src_%u", &id) != 1) {
+      GST_WARNING_OBJECT (disp, "Invalid pad name %s", name);
+      return NULL;
+    }
+
+    pad = gst_pad_new_from_static_template (&src_templ, name);
+  } else {
+    gchar pad_name[32];
+
+    GST_OBJECT_LOCK (disp);
+    id = element->numsrcpads;
+    GST_OBJECT_UNLOCK (disp);
+
+    g_snprintf (pad_name, 32, "src_%u", id);
+    pad = gst_pad_new_from_static_template (&src_templ, pad_name);
+  }
+
+  link = g_slice_new0 (RistDispatcherLink);
+  link->pad = gst_object_ref (pad);
+  link->id = id;
+  link->rtt = GST_CLOCK_TIME_NONE;
+  link->report_time = GST_CLOCK_TIME_NONE;
+
+  GST_OBJECT_LOCK (disp);
+  g_ptr_array_add (disp->links, link);
+  gst_rist_dispatcher_update_weights (disp);
+  GST_OBJECT_UNLOCK (disp);
+
+  gst_element_add_pad (element, pad);
+
+  return pad;
+}
+
+static void
+gst_rist_dispatcher_release_pad (GstElement * element, GstPad * pad)
+{
+  GstRistDispatcher *disp = GST_RIST_DISPATCHER (element);
+  gint i;
+
+  GST_OBJECT_LOCK (disp);
+  for (i = 0; i < disp->links->len; i++) {
+    RistDispatcherLink *link = g_ptr_array_index (disp->links, i);
+
+    if (link->pad == pad) {
+      g_ptr_array_remove_index (disp->links, i);
+      break;
+    }
+  }
+  gst_rist_dispatcher_update_weights (disp);
+  GST_OBJECT_UNLOCK (disp);
+
+  gst_element_remove_pad (element, pad);
+}
+
+/* Derives the delivery ratio and the bandwidth of the link from the packets
+ * it delivered since the previous report. Must be called with the object
+ * lock. */
+static void
+gst_rist_dispatcher_update_delivery (GstRistDispatcher * disp,
+    RistDispatcherLink * link, GstClockTime timestamp,
+    guint32 ext_highest_seq, gint32 packets_lost)
+{
+  gdouble interval, delivery, rate, input_rate;
+  gint64 received;
+  guint64 sent;
+
+  interval = (gdouble) (timestamp - link->report_time) / GST_SECOND;
+  received = (gint64) (guint32) (ext_highest_seq -
+      link->report_ext_highest_seq) - (gint32) (packets_lost -
+      link->report_packets_lost);
+  sent = link->sent - link->report_sent;
+
+  if (received < 0 || sent == 0)
+    return;
+
+  delivery = MIN ((gdouble) received / sent, 1.0);
+  rate = received / interval;
+  input_rate = (disp->n_input - link->report_input) / interval;
+
+  link->loss = (3 * link->loss + 1.0 - delivery) / 4;
+  if (disp->input_rate > 0)
+    disp->input_rate = (3 * disp->input_rate + input_rate) / 4;
+  else
+    disp->input_rate = input_rate;
+
+  if (delivery < SATURATED_DELIVERY_RATIO)
+    link->bandwidth = rate;
+  else if (link->bandwidth > 0)
+    link->bandwidth *= BANDWIDTH_PROBE;
+
+  if (link->bandwidth > disp->input_rate)
+    link->bandwidth = 0;
+
+  GST_LOG_OBJECT (disp, "Link %u delivered %" G_GINT64_FORMAT " of %"
+      G_GUINT64_FORMAT " packets (%f/s), bandwidth %f/s", link->id, received,
+      sent, rate, link->bandwidth);
+}
+
+/**
+ * gst_rist_dispatcher_set_link_stats:
+ * @disp: a #GstRistDispatcher
+ * @id: the number of the src pad of the link
+ * @rtt: the round trip time of the link
+ * @timestamp: when the report was received
+ * @ext_highest_seq: the extended highest sequence number received
+ * @packets_lost: the cumulative number of packets lost
+ *
+ * Feeds the statistics of a link, as found in a RTCP receiver report. They
+ * are only used in the "adaptive" and "duplicate-worst" modes. The delivery
+ * ratio and the bandwidth of the link are derived from the difference with
+ * the previous report, which makes them immune to the gaps in the sequence
+ * numbers left by the packets sent over the other links.
+ */
+void
+gst_rist_dispatcher_set_link_stats (GstRistDispatcher * disp, guint id,
+    GstClockTime rtt, GstClockTime timestamp, guint32 ext_highest_seq,
+    gint32 packets_lost)
+{
+  gint i;
+
+  GST_OBJECT_LOCK (disp);
+  for (i = 0; i < disp->links->len; i++) {
+    RistDispatcherLink *link = g_ptr_array_index (disp->links, i);
+
+    if (link->id != id)
+      continue;
+
+    if (GST_CLOCK_TIME_IS_VALID (rtt) && rtt > 0)
+      link->rtt = rtt;
+
+    /* the same report can be signalled more than once */
+    if (!GST_CLOCK_TIME_IS_VALID (link->report_time) ||
+        (timestamp > link->report_time &&
+            (ext_highest_seq != link->report_ext_highest_seq ||
+                packets_lost != link->report_packets_lost))) {
+      if (GST_CLOCK_TIME_IS_VALID (link->report_time))
+        gst_rist_dispatcher_update_delivery (disp, link, timestamp,
+            ext_highest_seq, packets_lost);
+
+      link->report_time = timestamp;
+      link->report_ext_highest_seq = ext_highest_seq;
+      link->report_packets_lost = packets_lost;
+      link->report_sent = link->sent;
+      link->report_input = disp->n_input;
+    }
+
+    GST_LOG_OBJECT (disp, "Link %u has rtt %" GST_TIME_FORMAT " and loss %f",
+        id, GST_TIME_ARGS (link->rtt), link->loss);
+
+    gst_rist_dispatcher_update_weights (disp);
+    break;
+  }
+  GST_OBJECT_UNLOCK (disp);
+}
+
+static gboolean
+gst_rist_dispatcher_parse_weights (GstRistDispatcher * disp,
+    const gchar * weights_str)
+{
+  gchar **weights;
+  gint i;
+
+  g_array_set_size (disp->weights, 0);
+
+  if (!weights_str)
+    return TRUE;
+
+  weights = g_strsplit (weights_str, ",", 0);
+  for (i = 0; weights[i]; i++) {
+    gchar *end = NULL;
+    gdouble weight = g_ascii_strtod (weights[i], &end);
+
+    if (end == weights[i] || *end != '\0' || weight < 0) {
+      GST_ERROR_OBJECT (disp, "Invalid weight '%s'", weights[i]);
+      g_array_set_size (disp->weights, 0);
+      g_strfreev (weights);
+      return FALSE;
+    }
+
+    g_array_append_val (disp->weights, weight);
+  }
+  g_strfreev (weights);
+
+  return TRUE;
+}
+
+static void
+gst_rist_dispatcher_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRistDispatcher *disp = GST_RIST_DISPATCHER (object);
+
+  GST_OBJECT_LOCK (disp);
+  switch (prop_id) {
+    case PROP_MODE:
+      g_value_set_enum (value, disp->mode);
+      break;
+    case PROP_WEIGHTS:
+      g_value_set_string (value, disp->weights_str);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (disp);
+}
+
+static void
+gst_rist_dispatcher_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRistDispatcher *disp = GST_RIST_DISPATCHER (object);
+
+  GST_OBJECT_LOCK (disp);
+  switch (prop_id) {
+    case PROP_MODE:
+      disp->mode = g_value_get_enum (value);
+      break;
+    case PROP_WEIGHTS:
+      g_free (disp->weights_str);
+      disp->weights_str = g_value_dup_string (value);
+      gst_rist_dispatcher_parse_weights (disp, disp->weights_str);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  gst_rist_dispatcher_update_weights (disp);
+  GST_OBJECT_UNLOCK (disp);
+}
+
+static void
+gst_rist_dispatcher_finalize (GObject * object)
+{
+  GstRistDispatcher *disp = GST_RIST_DISPATCHER (object);
+
+  g_ptr_array_unref (disp->links);
+  g_array_unref (disp->weights);
+  g_free (disp->weights_str);
+
+  G_OBJECT_CLASS (gst_rist_dispatcher_parent_class)->finalize (object);
+}
+
+static void
+gst_rist_dispatcher_init (GstRistDispatcher * disp)
+{
+  GstPad *pad;
+
+  disp->mode = DEFAULT_MODE;
+  disp->weights = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  disp->links =
+      g_ptr_array_new_with_free_func ((GDestroyNotify)
+      rist_dispatcher_link_free);
+  disp->best = -1;
+  disp->worst = -1;
+
+  gst_element_create_all_pads (GST_ELEMENT (disp));
+  pad = GST_PAD (GST_ELEMENT (disp)->sinkpads->data);
+
+  GST_PAD_SET_PROXY_CAPS (pad);
+  GST_PAD_SET_PROXY_SCHEDULING (pad);
+  /* do not proxy allocation, it requires special handling like tee does */
+
+  gst_pad_set_chain_function (pad,
+      GST_DEBUG_FUNCPTR (gst_rist_dispatcher_chain));
+  gst_pad_set_chain_list_function (pad,
+      GST_DEBUG_FUNCPTR (gst_rist_dispatcher_chain_list));
+}
+
+static void
+gst_rist_dispatcher_class_init (GstRistDispatcherClass * klass)
+{
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GObjectClass *object_class = (GObjectClass *) klass;
+
+  gst_element_class_set_metadata (element_class,
+      "RIST Bonding Dispatcher", "Generic",
+      "Dispatches buffers over multiple links according to their weight "
+      "and statistics",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+
+  gst_element_class_add_static_pad_template (element_class, &sink_templ);
+  gst_element_class_add_static_pad_template (element_class, &src_templ);
+
+  element_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_rist_dispatcher_request_pad);
+  element_class->release_pad =
+      GST_DEBUG_FUNCPTR (gst_rist_dispatcher_release_pad);
+
+  object_class->get_property = gst_rist_dispatcher_get_property;
+  object_class->set_property = gst_rist_dispatcher_set_property;
+  object_class->finalize = gst_rist_dispatcher_finalize;
+
+  /**
+   * GstRistDispatcher:mode:
+   *
+   * How the weights of the links are computed.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_MODE,
+      g_param_spec_enum ("mode", "Mode",
+          "How the weights of the links are computed",
+          GST_TYPE_RIST_DISPATCHER_MODE, DEFAULT_MODE,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRistDispatcher:weights:
+   *
+   * Comma separated list of the weights of the links, indexed by the number
+   * of their src pad (e.g. "5,1" sends 5 times more buffers over src_0 than
+   * over src_1). A weight of 0 disables the link.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_WEIGHTS,
+      g_param_spec_string ("weights", "Weights",
+          "Comma separated list of weights, indexed by src pad number",
+          DEFAULT_WEIGHTS, G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  gst_type_mark_as_plugin_api (GST_TYPE_RIST_DISPATCHER_MODE, 0);
+}
@@ -30,6 +30,9 @@
  * This elements replies to custom events 'GstRTPRetransmissionRequest' and
  * when available sends in RIST form the lost packet. This element is intented
  * to be used by ristsink element.
+ *
+ * A request can cover a range of consecutive packets with an optional
+ * 'seqnum-count' field, as used for RIST range NACKs.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -48,6 +51,11 @@ GST_DEBUG_CATEGORY_STATIC (gst_rist_rtx_send_debug);
 #define DEFAULT_MAX_SIZE_TIME    0
 #define DEFAULT_MAX_SIZE_PACKETS 100
 
+/* Packet history ring sizes, always a power of two. Without packet limit
+ * the ring grows up to the largest window a 16 bit NACK can address. */
+#define MIN_QUEUE_SIZE 64
+#define MAX_QUEUE_SIZE 65536
+
 enum
 {
   PROP_0,
@@ -55,6 +63,8 @@ enum
   PROP_MAX_SIZE_PACKETS,
   PROP_NUM_RTX_REQUESTS,
   PROP_NUM_RTX_PACKETS,
+  PROP_NUM_RTX_HITS,
+  PROP_NUM_RTX_MISSES,
 };
 
 static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
@@ -92,6 +102,8 @@ struct _GstRistRtxSend
   /* statistics */
   guint num_rtx_requests;
   guint num_rtx_packets;
+  guint num_rtx_hits;
+  guint num_rtx_misses;
 };
 
 static gboolean gst_rist_rtx_send_queue_check_full (GstDataQueue * queue,
@@ -130,21 +142,20 @@ typedef struct
   GstBuffer *buffer;
 } BufferQueueItem;
 
-static void
-buffer_queue_item_free (BufferQueueItem * item)
-{
-  gst_buffer_unref (item->buffer);
-  g_slice_free (BufferQueueItem, item);
-}
-
 typedef struct
 {
   guint32 rtx_ssrc;
   guint16 seqnum_base, next_seqnum;
   gint clock_rate;
 
-  /* history of rtp packets */
-  GSequence *queue;
+  /* history of rtp packets, a ring indexed by extended seqnum holding the
+   * packets from first_extseqnum to last_extseqnum, with holes for the
+   * packets that were never sent */
+  BufferQueueItem *queue;
+  guint queue_size;
+  guint queue_length;
+  guint32 first_extseqnum;
+  guint32 last_extseqnum;
   guint32 max_extseqnum;
 
   /* current rtcp app seqnum extension */
@@ -152,6 +163,9 @@ typedef struct
   guint16 seqnum_ext;
 } SSRCRtxData;
 
+#define QUEUE_ITEM(data, extseqnum) \
+    (&(data)->queue[(extseqnum) & ((data)->queue_size - 1)])
+
 static SSRCRtxData *
 ssrc_rtx_data_new (guint32 rtx_ssrc)
 {
@@ -159,7 +173,8 @@ ssrc_rtx_data_new (guint32 rtx_ssrc)
 
   data->rtx_ssrc = rtx_ssrc;
   data->next_seqnum = data->seqnum_base = g_random_int_range (0, G_MAXUINT16);
-  data->queue = g_sequence_new ((GDestroyNotify) buffer_queue_item_free);
+  data->queue_size = MIN_QUEUE_SIZE;
+  data->queue = g_new0 (BufferQueueItem, data->queue_size);
   data->max_extseqnum = -1;
 
   return data;
@@ -168,10 +183,108 @@ ssrc_rtx_data_new (guint32 rtx_ssrc)
 static void
 ssrc_rtx_data_free (SSRCRtxData * data)
 {
-  g_sequence_free (data->queue);
+  guint i;
+
+  for (i = 0; i < data->queue_size; i++)
+    gst_buffer_replace (&data->queue[i].buffer, NULL);
+  g_free (data->queue);
   g_slice_free (SSRCRtxData, data);
 }
 
+/* Moves the packets to a ring of @size slots, which must be large enough
+ * to hold all of them */
+static void
+ssrc_rtx_data_resize (SSRCRtxData * data, guint size)
+{
+  BufferQueueItem *old_queue = data->queue;
+  guint old_size = data->queue_size;
+  guint32 extseqnum;
+
+  data->queue = g_new0 (BufferQueueItem, size);
+  data->queue_size = size;
+
+  if (data->queue_length > 0) {
+    for (extseqnum = data->first_extseqnum;
+        extseqnum != data->last_extseqnum + 1; extseqnum++)
+      *QUEUE_ITEM (data, extseqnum) = old_queue[extseqnum & (old_size - 1)];
+  }
+
+  g_free (old_queue);
+}
+
+/* Removes the oldest packet, and skips the holes following it */
+static void
+ssrc_rtx_data_pop_oldest (SSRCRtxData * data)
+{
+  BufferQueueItem *item = QUEUE_ITEM (data, data->first_extseqnum);
+
+  gst_buffer_replace (&item->buffer, NULL);
+  data->queue_length--;
+  data->first_extseqnum++;
+
+  while (data->queue_length > 0 &&
+      QUEUE_ITEM (data, data->first_extseqnum)->buffer == NULL)
+    data->first_extseqnum++;
+}
+
+static BufferQueueItem *
+ssrc_rtx_data_lookup (SSRCRtxData * data, guint32 extseqnum)
+{
+  BufferQueueItem *item;
+
+  if (data->queue_length == 0 ||
+      extseqnum - data->first_extseqnum >
+      data->last_extseqnum - data->first_extseqnum)
+    return NULL;
+
+  item = QUEUE_ITEM (data, extseqnum);
+  if (item->buffer == NULL || item->extseqnum != extseqnum)
+    return NULL;
+
+  return item;
+}
+
+/* Stores @buffer in the ring, making room for it by growing the ring up to
+ * @max_size slots or by dropping the oldest packets */
+static void
+ssrc_rtx_data_push (SSRCRtxData * data, guint32 extseqnum, guint32 timestamp,
+    GstBuffer * buffer, guint max_size)
+{
+  BufferQueueItem *item;
+
+  if (data->queue_length == 0) {
+    data->first_extseqnum = data->last_extseqnum = extseqnum;
+  } else if ((gint32) (extseqnum - data->last_extseqnum) <= 0) {
+    /* retransmitted or reordered by upstream, keep it only if it fits in
+     * the current window */
+    if ((gint32) (extseqnum - data->first_extseqnum) < 0 ||
+        extseqnum - data->first_extseqnum >= data->queue_size)
+      return;
+  } else {
+    while (extseqnum - data->first_extseqnum >= data->queue_size) {
+      if (data->queue_size < max_size) {
+        ssrc_rtx_data_resize (data, data->queue_size * 2);
+      } else {
+        ssrc_rtx_data_pop_oldest (data);
+        if (data->queue_length == 0) {
+          data->first_extseqnum = extseqnum;
+          break;
+        }
+      }
+    }
+    data->last_extseqnum = extseqnum;
+  }
+
+  item = QUEUE_ITEM (data, extseqnum);
+  if (item->buffer == NULL)
+    data->queue_length++;
+  else
+    gst_buffer_unref (item->buffer);
+  item->extseqnum = extseqnum;
+  item->timestamp = timestamp;
+  item->buffer = gst_buffer_ref (buffer);
+}
+
 static void
 gst_rist_rtx_send_class_init (GstRistRtxSendClass * klass)
 {
@@ -206,6 +319,31 @@ gst_rist_rtx_send_class_init (GstRistRtxSendClass * klass)
           " Number of retransmission packets sent", 0, G_MAXUINT,
           0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRistRtxSend:num-rtx-hits:
+   *
+   * Number of requested packets that were found in the queue.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_NUM_RTX_HITS,
+      g_param_spec_uint ("num-rtx-hits", "Num RTX Hits",
+          "Number of requested packets found in the queue", 0, G_MAXUINT,
+          0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRistRtxSend:num-rtx-misses:
+   *
+   * Number of requested packets that were not in the queue, either because
+   * they already expired or because they were never sent.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_NUM_RTX_MISSES,
+      g_param_spec_uint ("num-rtx-misses", "Num RTX Misses",
+          "Number of requested packets not found in the queue", 0, G_MAXUINT,
+          0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &src_factory);
   gst_element_class_add_static_pad_template (gstelement_class, &sink_factory);
 
@@ -227,6 +365,8 @@ gst_rist_rtx_send_reset (GstRistRtxSend * rtx)
   g_hash_table_remove_all (rtx->rtx_ssrcs);
   rtx->num_rtx_requests = 0;
   rtx->num_rtx_packets = 0;
+  rtx->num_rtx_hits = 0;
+  rtx->num_rtx_misses = 0;
   GST_OBJECT_UNLOCK (rtx);
 }
 
@@ -367,16 +507,6 @@ gst_rtp_rist_buffer_new (GstRistRtxSend * rtx, GstBuffer * buffer, guint32 ssrc)
   return buffer;
 }
 
-static gint
-buffer_queue_items_cmp (BufferQueueItem * a, BufferQueueItem * b,
-    gpointer user_data)
-{
-  /* gst_rtp_buffer_compare_seqnum returns the opposite of what we want,
-   * it returns negative when seqnum1 > seqnum2 and we want negative
-   * when b > a, i.e. a is smaller, so it comes first in the sequence */
-  return a->extseqnum - b->extseqnum;
-}
-
 static gboolean
 gst_rist_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -391,7 +521,8 @@ gst_rist_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
       if (gst_structure_has_name (s, "GstRTPRetransmissionRequest")) {
         guint seqnum = 0;
         guint ssrc = 0;
-        GstBuffer *rtx_buf = NULL;
+        guint count = 1;
+        GstBufferList *rtx_list = NULL;
 
         /* retrieve seqnum of the packet that need to be retransmitted */
         if (!gst_structure_get_uint (s, "seqnum", &seqnum))
@@ -401,23 +532,26 @@ gst_rist_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
         if (!gst_structure_get_uint (s, "ssrc", &ssrc))
           ssrc = -1;
 
-        GST_DEBUG_OBJECT (rtx, "got rtx request for seqnum: %u, ssrc: %X",
-            seqnum, ssrc);
+        /* range requests from RIST NACKs cover consecutive seqnums */
+        if (!gst_structure_get_uint (s, "seqnum-count", &count) || count == 0)
+          count = 1;
+
+        GST_DEBUG_OBJECT (rtx, "got rtx request for seqnum: %u (%u packets), "
+            "ssrc: %X", seqnum, count, ssrc);
 
         GST_OBJECT_LOCK (rtx);
         /* check if request is for us */
         if (g_hash_table_contains (rtx->ssrc_data, GUINT_TO_POINTER (ssrc))) {
           SSRCRtxData *data;
-          GSequenceIter *iter;
-          BufferQueueItem search_item;
+          BufferQueueItem *item;
           guint32 extseqnum;
+          guint i;
 
           /* update statistics */
-          ++rtx->num_rtx_requests;
+          rtx->num_rtx_requests += count;
 
           data = gst_rist_rtx_send_get_ssrc_data (rtx, ssrc);
 
-
           if (data->has_seqnum_ext) {
             extseqnum = data->seqnum_ext << 16 | seqnum;
           } else {
@@ -425,40 +559,41 @@ gst_rist_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
             extseqnum = gst_rist_rtp_ext_seq (&max_extseqnum, seqnum);
           }
 
-          search_item.extseqnum = extseqnum;
-          iter = g_sequence_lookup (data->queue, &search_item,
-              (GCompareDataFunc) buffer_queue_items_cmp, NULL);
-          if (iter) {
-            BufferQueueItem *item = g_sequence_get (iter);
-            GST_LOG_OBJECT (rtx, "found %u (%u:%u)", item->extseqnum,
-                item->extseqnum >> 16, item->extseqnum & 0xFFFF);
-            rtx_buf = gst_rtp_rist_buffer_new (rtx, item->buffer, ssrc);
-          }
-#ifndef GST_DISABLE_DEBUG
-          else {
-            BufferQueueItem *item = NULL;
-
-            iter = g_sequence_get_begin_iter (data->queue);
-            if (!g_sequence_iter_is_end (iter))
-              item = g_sequence_get (iter);
+          for (i = 0; i < count; i++, extseqnum++) {
+            item = ssrc_rtx_data_lookup (data, extseqnum);
+            if (item) {
+              GST_LOG_OBJECT (rtx, "found %u (%u:%u)", item->extseqnum,
+                  item->extseqnum >> 16, item->extseqnum & 0xFFFF);
+              if (!rtx_list)
+                rtx_list = gst_buffer_list_new_sized (count - i);
+              gst_buffer_list_add (rtx_list,
+                  gst_rtp_rist_buffer_new (rtx, item->buffer, ssrc));
+              rtx->num_rtx_hits++;
+              continue;
+            }
 
-            if (item && extseqnum < item->extseqnum) {
+            rtx->num_rtx_misses++;
+            if (data->queue_length > 0 &&
+                (gint32) (extseqnum - data->first_extseqnum) < 0) {
               GST_DEBUG_OBJECT (rtx, "requested seqnum %u has already been "
                   "removed from the rtx queue; the first available is %u",
-                  seqnum, item->extseqnum);
-            } else {
+                  extseqnum & 0xFFFF, data->first_extseqnum);
+            } else if (data->queue_length == 0 ||
+                (gint32) (extseqnum - data->last_extseqnum) > 0) {
               GST_WARNING_OBJECT (rtx, "requested seqnum %u has not been "
                   "transmitted yet in the original stream; either the remote end "
                   "is not configured correctly, or the source is too slow",
-                  seqnum);
+                  extseqnum & 0xFFFF);
+            } else {
+              GST_DEBUG_OBJECT (rtx, "requested seqnum %u was never sent",
+                  extseqnum & 0xFFFF);
             }
-#endif
           }
         }
         GST_OBJECT_UNLOCK (rtx);
 
-        if (rtx_buf)
-          gst_rist_rtx_send_push_out (rtx, rtx_buf);
+        if (rtx_list)
+          gst_rist_rtx_send_push_out (rtx, rtx_list);
 
         gst_event_unref (event);
         return TRUE;
@@ -548,19 +683,13 @@ static guint32
 gst_rist_rtx_send_get_ts_diff (SSRCRtxData * data)
 {
   guint64 high_ts, low_ts;
-  BufferQueueItem *high_buf, *low_buf;
   guint32 result;
 
-  high_buf =
-      g_sequence_get (g_sequence_iter_prev (g_sequence_get_end_iter
-          (data->queue)));
-  low_buf = g_sequence_get (g_sequence_get_begin_iter (data->queue));
-
-  if (!high_buf || !low_buf || high_buf == low_buf)
+  if (data->queue_length < 2)
     return 0;
 
-  high_ts = high_buf->timestamp;
-  low_ts = low_buf->timestamp;
+  high_ts = QUEUE_ITEM (data, data->last_extseqnum)->timestamp;
+  low_ts = QUEUE_ITEM (data, data->first_extseqnum)->timestamp;
 
   /* it needs to work if ts wraps */
   if (high_ts >= low_ts) {
@@ -578,8 +707,8 @@ static void
 process_buffer (GstRistRtxSend * rtx, GstBuffer * buffer)
 {
   GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
-  BufferQueueItem *item;
   SSRCRtxData *data;
+  guint max_size;
   guint16 seqnum;
   guint32 ssrc, rtptime;
   guint16 bits;
@@ -614,20 +743,21 @@ process_buffer (GstRistRtxSend * rtx, GstBuffer * buffer)
     extseqnum = gst_rist_rtp_ext_seq (&data->max_extseqnum, seqnum);
 
   /* add current rtp buffer to queue history */
-  item = g_slice_new0 (BufferQueueItem);
-  item->extseqnum = extseqnum;
-  item->timestamp = rtptime;
-  item->buffer = gst_buffer_ref (buffer);
-  g_sequence_append (data->queue, item);
+  if (rtx->max_size_packets)
+    max_size = MAX (1 << g_bit_storage (rtx->max_size_packets - 1),
+        MIN_QUEUE_SIZE);
+  else
+    max_size = MAX_QUEUE_SIZE;
+  ssrc_rtx_data_push (data, extseqnum, rtptime, buffer, max_size);
 
   /* remove oldest packets from history if they are too many */
   if (rtx->max_size_packets) {
-    while (g_sequence_get_length (data->queue) > rtx->max_size_packets)
-      g_sequence_remove (g_sequence_get_begin_iter (data->queue));
+    while (data->queue_length > rtx->max_size_packets)
+      ssrc_rtx_data_pop_oldest (data);
   }
   if (rtx->max_size_time) {
     while (gst_rist_rtx_send_get_ts_diff (data) > rtx->max_size_time)
-      g_sequence_remove (g_sequence_get_begin_iter (data->queue));
+      ssrc_rtx_data_pop_oldest (data);
   }
 }
 
@@ -683,6 +813,13 @@ gst_rist_rtx_send_src_loop (GstRistRtxSend * rtx)
       GST_OBJECT_UNLOCK (rtx);
 
       gst_pad_push (rtx->srcpad, GST_BUFFER (data->object));
+    } else if (GST_IS_BUFFER_LIST (data->object)) {
+      GST_OBJECT_LOCK (rtx);
+      rtx->num_rtx_packets +=
+          gst_buffer_list_length (GST_BUFFER_LIST (data->object));
+      GST_OBJECT_UNLOCK (rtx);
+
+      gst_pad_push_list (rtx->srcpad, GST_BUFFER_LIST (data->object));
     } else if (GST_IS_EVENT (data->object)) {
       gst_pad_push_event (rtx->srcpad, GST_EVENT (data->object));
 
@@ -755,6 +892,16 @@ gst_rist_rtx_send_get_property (GObject * object,
       g_value_set_uint (value, rtx->num_rtx_packets);
       GST_OBJECT_UNLOCK (rtx);
       break;
+    case PROP_NUM_RTX_HITS:
+      GST_OBJECT_LOCK (rtx);
+      g_value_set_uint (value, rtx->num_rtx_hits);
+      GST_OBJECT_UNLOCK (rtx);
+      break;
+    case PROP_NUM_RTX_MISSES:
+      GST_OBJECT_LOCK (rtx);
+      g_value_set_uint (value, rtx->num_rtx_misses);
+      GST_OBJECT_UNLOCK (rtx);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -51,13 +51,21 @@
  * mapped to its own RTP session. RTX request are only replied to on the
  * link the NACK was received from.
  *
- * There are currently two bonding methods in place: "broadcast" and "round-robin".
+ * There are currently five bonding methods in place: "broadcast",
+ * "round-robin", "weighted", "adaptive" and "duplicate-worst".
  * In "broadcast" mode, all the packets are duplicated over all sessions.
- * While in "round-robin" mode, packets are evenly distributed over the links. One
- * can also implement its own dispatcher element and configure it using the
- * "dispatcher" property. As a reference, "broadcast" mode is implemented with
- * the "tee" element, while "round-robin" mode is implemented with the
- * "round-robin" element.
+ * While in "round-robin" mode, packets are evenly distributed over the links.
+ * In "weighted" mode, packets are distributed over the links in proportion
+ * to the weights set in the "bonding-weights" property. In "adaptive" mode,
+ * these weights are further scaled down for the links that lose packets or
+ * have a longer round trip time than the others, as reported by the RTCP
+ * receiver reports of each session. The "duplicate-worst" mode works like
+ * "adaptive", but the packets sent over the worst link are also sent over
+ * the best one. One can also implement its own dispatcher element and
+ * configure it using the "dispatcher" property. As a reference, "broadcast"
+ * mode is implemented with the "tee" element, "round-robin" mode is
+ * implemented with the "round-robin" element, and the other modes with the
+ * "ristdispatcher" element.
  *
  * ## Example gst-launch line for bonding
  * |[
@@ -101,13 +109,17 @@ enum
   PROP_BONDING_METHOD,
   PROP_DISPATCHER,
   PROP_DROP_NULL_TS_PACKETS,
-  PROP_SEQUENCE_NUMBER_EXTENSION
+  PROP_SEQUENCE_NUMBER_EXTENSION,
+  PROP_BONDING_WEIGHTS
 };
 
 typedef enum
 {
   GST_RIST_BONDING_METHOD_BROADCAST,
   GST_RIST_BONDING_METHOD_ROUND_ROBIN,
+  GST_RIST_BONDING_METHOD_WEIGHTED,
+  GST_RIST_BONDING_METHOD_ADAPTIVE,
+  GST_RIST_BONDING_METHOD_DUPLICATE_WORST,
 } GstRistBondingMethod;
 
 static GstStaticPadTemplate sink_templ = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -147,6 +159,7 @@ struct _GstRistSink
   GstClockTime min_rtcp_interval;
   gdouble max_rtcp_bandwidth;
   GstRistBondingMethod bonding_method;
+  gchar *bonding_weights;
 
   /* Bonds */
   GPtrArray *bonds;
@@ -175,6 +188,12 @@ gst_rist_bonding_method_get_type (void)
         "GST_RIST_BONDING_METHOD_BROADCAST", "broadcast"},
     {GST_RIST_BONDING_METHOD_ROUND_ROBIN,
         "GST_RIST_BONDING_METHOD_ROUND_ROBIN", "round-robin"},
+    {GST_RIST_BONDING_METHOD_WEIGHTED,
+        "GST_RIST_BONDING_METHOD_WEIGHTED", "weighted"},
+    {GST_RIST_BONDING_METHOD_ADAPTIVE,
+        "GST_RIST_BONDING_METHOD_ADAPTIVE", "adaptive"},
+    {GST_RIST_BONDING_METHOD_DUPLICATE_WORST,
+        "GST_RIST_BONDING_METHOD_DUPLICATE_WORST", "duplicate-worst"},
     {0, NULL, NULL}
   };
 
@@ -387,18 +406,17 @@ on_app_rtcp (GObject * session, guint32 subtype, guint32 ssrc,
           guint32 dword = GST_READ_UINT32_BE (map.data + i);
           guint16 seqnum = dword >> 16;
           guint16 num = dword & 0x0000FFFF;
-          guint16 j;
 
           GST_DEBUG ("got RIST nack packet, #%u %u", seqnum, num);
 
-          /* num is inclusive, i.e. it can be 0, which means exactly 1 seqnum */
-          for (j = 0; j <= num; j++) {
-            event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
-                gst_structure_new ("GstRTPRetransmissionRequest",
-                    "seqnum", G_TYPE_UINT, (guint) seqnum + j,
-                    "ssrc", G_TYPE_UINT, (guint) ssrc, NULL));
-            gst_pad_push_event (send_rtp_sink, event);
-          }
+          /* num is inclusive, i.e. it can be 0, which means exactly 1 seqnum.
+           * The whole range is handled by ristrtxsend in one go. */
+          event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
+              gst_structure_new ("GstRTPRetransmissionRequest",
+                  "seqnum", G_TYPE_UINT, (guint) seqnum,
+                  "seqnum-count", G_TYPE_UINT, (guint) num + 1,
+                  "ssrc", G_TYPE_UINT, (guint) ssrc, NULL));
+          gst_pad_push_event (send_rtp_sink, event);
         }
 
         gst_buffer_unmap (data, &map);
@@ -433,6 +451,41 @@ on_app_rtcp (GObject * session, guint32 subtype, guint32 ssrc,
   }
 }
 
+/* Feeds the statistics of the receiver reports to the dispatcher, so that it
+ * can adapt to the state of each link */
+static void
+on_ssrc_active (GObject * session, GObject * source, GstRistSink * sink)
+{
+  GstStructure *stats = NULL;
+  gboolean internal = TRUE, have_rb = FALSE;
+  guint rb_rtt = 0, rb_exthighestseq = 0;
+  gint rb_packetslost = 0;
+  guint session_id;
+
+  if (!GST_IS_RIST_DISPATCHER (sink->dispatcher))
+    return;
+
+  g_object_get (source, "stats", &stats, NULL);
+  gst_structure_get_boolean (stats, "internal", &internal);
+  gst_structure_get_boolean (stats, "have-rb", &have_rb);
+  gst_structure_get_uint (stats, "rb-round-trip", &rb_rtt);
+  gst_structure_get_uint (stats, "rb-exthighestseq", &rb_exthighestseq);
+  gst_structure_get_int (stats, "rb-packetslost", &rb_packetslost);
+  gst_structure_free (stats);
+
+  if (internal || !have_rb)
+    return;
+
+  session_id =
+      GPOINTER_TO_UINT (g_object_get_qdata (session, session_id_quark));
+
+  /* rb_rtt is in Q16 in NTP time. The fraction lost is not used, as each
+   * bond only receives part of the sequence numbers */
+  gst_rist_dispatcher_set_link_stats (GST_RIST_DISPATCHER (sink->dispatcher),
+      session_id, gst_util_uint64_scale (rb_rtt, GST_SECOND, 65536),
+      gst_util_get_timestamp (), rb_exthighestseq, rb_packetslost);
+}
+
 static void
 gst_rist_sink_on_new_sender_ssrc (GstRistSink * sink, guint session_id,
     guint ssrc, GstElement * rtpbin)
@@ -728,6 +781,25 @@ gst_rist_sink_start (GstRistSink * sink)
             "rist_dispatcher");
         g_assert (sink->dispatcher);
         break;
+      case GST_RIST_BONDING_METHOD_WEIGHTED:
+      case GST_RIST_BONDING_METHOD_ADAPTIVE:
+      case GST_RIST_BONDING_METHOD_DUPLICATE_WORST:
+      {
+        GstRistDispatcherMode mode = GST_RIST_DISPATCHER_MODE_WEIGHTED;
+
+        if (sink->bonding_method == GST_RIST_BONDING_METHOD_ADAPTIVE)
+          mode = GST_RIST_DISPATCHER_MODE_ADAPTIVE;
+        else if (sink->bonding_method ==
+            GST_RIST_BONDING_METHOD_DUPLICATE_WORST)
+          mode = GST_RIST_DISPATCHER_MODE_DUPLICATE_WORST;
+
+        sink->dispatcher = gst_element_factory_make ("ristdispatcher",
+            "rist_dispatcher");
+        g_assert (sink->dispatcher);
+        g_object_set (sink->dispatcher, "mode", mode,
+            "weights", sink->bonding_weights, NULL);
+        break;
+      }
     }
   }
 
@@ -753,9 +825,12 @@ gst_rist_sink_start (GstRistSink * sink)
     GstPad *pad;
     gchar name[32];
 
-    g_signal_emit_by_name (sink->rtpbin, "get-session", i, &session);
+    g_signal_emit_by_name (sink->rtpbin, "get-internal-session", i, &session);
     g_object_set (session, "rtcp-min-interval", sink->min_rtcp_interval,
         "rtcp-fraction", sink->max_rtcp_bandwidth, NULL);
+    g_object_set_qdata (session, session_id_quark, GUINT_TO_POINTER (i));
+    g_signal_connect_object (session, "on-ssrc-active",
+        (GCallback) on_ssrc_active, sink, 0);
     g_object_unref (session);
 
     g_snprintf (name, 32, "src_%u", bond->session);
@@ -1166,6 +1241,10 @@ gst_rist_sink_get_property (GObject * object, guint prop_id,
           "sequence-number-extension", value);
       break;
 
+    case PROP_BONDING_WEIGHTS:
+      g_value_set_string (value, sink->bonding_weights);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1279,6 +1358,11 @@ gst_rist_sink_set_property (GObject * object, guint prop_id,
           "sequence-number-extension", value);
       break;
 
+    case PROP_BONDING_WEIGHTS:
+      g_free (sink->bonding_weights);
+      sink->bonding_weights = g_value_dup_string (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1302,6 +1386,7 @@ gst_rist_sink_finalize (GObject * object)
     g_slice_free (RistSenderBond, bond);
   }
   g_ptr_array_free (sink->bonds, TRUE);
+  g_free (sink->bonding_weights);
 
   g_clear_object (&sink->rtxbin);
 
@@ -1422,5 +1507,21 @@ gst_rist_sink_class_init (GstRistSinkClass * klass)
           "Add sequence number extension to packets.", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_CONSTRUCT));
 
+  /**
+   * GstRistSink:bonding-weights:
+   *
+   * Comma (,) separated list of the weights of the links, in the same order
+   * as the "bonding-addresses". Only used by the "weighted", "adaptive" and
+   * "duplicate-worst" bonding methods. Links without a weight get a weight
+   * of 1, and a weight of 0 disables the link.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_BONDING_WEIGHTS,
+      g_param_spec_string ("bonding-weights", "Bonding Weights",
+          "Comma (,) separated list of the weights of the bonded links.",
+          NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gst_type_mark_as_plugin_api (gst_rist_bonding_method_get_type (), 0);
 }
@@ -0,0 +1,1121 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:element-rtmp2server
+ * @title: rtmp2server
+ * @see_also: rtmp2sink, rtmp2src
+ *
+ * The rtmp2server element is an RTMP ingest server. It accepts any number of
+ * concurrent publishing clients and exposes each published stream as an FLV
+ * stream on its own sometimes pad.
+ *
+ * All the client connections are handled by a single thread. Each pad pushes
+ * from its own streaming thread, so a slow downstream of one stream doesn't
+ * hold back the other ones; when its queue is full, the buffers of that
+ * stream are dropped.
+ *
+ * When a client starts publishing, a new pad is added and an
+ * "rtmp2server-publish-started" element message is posted, with the "pad",
+ * the "application", the "stream" name and the "address" of the client. When
+ * it stops, EOS is pushed on the pad, an "rtmp2server-publish-stopped"
+ * message is posted and the pad is removed.
+ *
+ * ## Example launch lines
+ * |[
+ * gst-launch-1.0 rtmp2server port=1935 application=live ! flvdemux ! \
+ *     decodebin ! autovideosink
+ * ]| Receive a stream and display it.
+ * |[
+ * gst-launch-1.0 videotestsrc is-live=true ! x264enc ! flvmux ! \
+ *     rtmp2sink location=rtmp://127.0.0.1/live/test
+ * ]| Publish a stream to the server above.
+ *
+ * Since: 1.20
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstrtmp2server.h"
+
+#include "rtmp/rtmpserver.h"
+#include "rtmp/rtmpmessage.h"
+
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_rtmp2_server_debug_category);
+#define GST_CAT_DEFAULT gst_rtmp2_server_debug_category
+
+#define GST_RTMP2_SERVER(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_RTMP2_SERVER,GstRtmp2Server))
+#define GST_IS_RTMP2_SERVER(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_RTMP2_SERVER))
+
+typedef struct _Publisher Publisher;
+
+typedef struct
+{
+  GstElement parent_instance;
+
+  /* properties */
+  gchar *host;
+  guint port;
+  gint current_port;
+  gchar *application;
+  guint max_publishers;
+  guint max_queue_size;
+
+  /* Protects the values below. If both self->lock and OBJECT_LOCK are
+   * needed, self->lock must be taken first */
+  GMutex lock;
+  GCond cond;
+
+  gboolean started;
+
+  GstTask *task;
+  GRecMutex task_lock;
+
+  GMainLoop *loop;
+  GMainContext *context;
+
+  GCancellable *cancellable;
+  GSocketListener *listener;
+
+  /* Publishers with a pad */
+  GList *publishers;
+  guint pad_count;
+
+  /* Only accessed from the loop thread */
+  GList *clients;
+} GstRtmp2Server;
+
+typedef struct
+{
+  GstElementClass parent_class;
+} GstRtmp2ServerClass;
+
+/* A published stream. Shared by the client of the loop thread, which fills
+ * the queue, and by the pad task, which empties it */
+struct _Publisher
+{
+  gint refcount;
+
+  GstRtmp2Server *server;
+  GstPad *pad;
+  gchar *application;
+  gchar *stream;
+
+  GMutex lock;
+  GCond cond;
+  GQueue queue;
+  gboolean eos;
+  gboolean flushing;
+  gboolean sent_header;
+  gboolean discont;
+  guint64 dropped;
+};
+
+/* A client connection, only accessed from the loop thread */
+typedef struct
+{
+  GstRtmp2Server *server;
+  GstRtmpConnection *connection;
+  GSocketAddress *address;
+  gchar *application;
+  guint32 stream_id;
+  gulong error_handler_id;
+  Publisher *publisher;
+} Client;
+
+/* GObject virtual functions */
+static void gst_rtmp2_server_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_rtmp2_server_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_rtmp2_server_finalize (GObject * object);
+
+/* GstElement virtual functions */
+static GstStateChangeReturn gst_rtmp2_server_change_state (GstElement *
+    element, GstStateChange transition);
+
+/* Internal API */
+static void gst_rtmp2_server_task_func (gpointer user_data);
+static void accept_next (GstRtmp2Server * self);
+static void client_free (Client * client);
+
+enum
+{
+  PROP_0,
+  PROP_HOST,
+  PROP_PORT,
+  PROP_CURRENT_PORT,
+  PROP_APPLICATION,
+  PROP_MAX_PUBLISHERS,
+  PROP_MAX_QUEUE_SIZE,
+};
+
+#define DEFAULT_HOST NULL
+#define DEFAULT_PORT 1935
+#define DEFAULT_APPLICATION NULL
+#define DEFAULT_MAX_PUBLISHERS 0
+#define DEFAULT_MAX_QUEUE_SIZE 256
+
+/* pad templates */
+
+static GstStaticPadTemplate gst_rtmp2_server_src_template =
+GST_STATIC_PAD_TEMPLATE ("src_%u",
+    GST_PAD_SRC,
+    GST_PAD_SOMETIMES,
+    GST_STATIC_CAPS ("video/x-flv")
+    );
+
+/* class initialization */
+
+G_DEFINE_TYPE (GstRtmp2Server, gst_rtmp2_server, GST_TYPE_ELEMENT);
+
+static void
+gst_rtmp2_server_class_init (GstRtmp2ServerClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (element_class,
+      &gst_rtmp2_server_src_template);
+
+  gst_element_class_set_static_metadata (element_class,
+      "RTMP server element", "Source/Network",
+      "Accepts RTMP streams from publishing clients",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+
+  gobject_class->set_property = gst_rtmp2_server_set_property;
+  gobject_class->get_property = gst_rtmp2_server_get_property;
+  gobject_class->finalize = gst_rtmp2_server_finalize;
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_rtmp2_server_change_state);
+
+  g_object_class_install_property (gobject_class, PROP_HOST,
+      g_param_spec_string ("host", "Host",
+          "Address to listen on (NULL = all interfaces)", DEFAULT_HOST,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PORT,
+      g_param_spec_uint ("port", "Port",
+          "Port to listen on (0 = random available port)", 0, 65535,
+          DEFAULT_PORT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CURRENT_PORT,
+      g_param_spec_int ("current-port", "Current port",
+          "The port the server is listening on, or -1 when not listening",
+          -1, 65535, -1, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_APPLICATION,
+      g_param_spec_string ("application", "Application",
+          "Application clients must connect to (NULL = any)",
+          DEFAULT_APPLICATION, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_PUBLISHERS,
+      g_param_spec_uint ("max-publishers", "Max publishers",
+          "Maximum number of concurrently published streams (0 = unlimited)",
+          0, G_MAXUINT, DEFAULT_MAX_PUBLISHERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_QUEUE_SIZE,
+      g_param_spec_uint ("max-queue-size", "Max queue size",
+          "Maximum number of FLV tags queued for each pad before dropping",
+          1, G_MAXUINT, DEFAULT_MAX_QUEUE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  GST_DEBUG_CATEGORY_INIT (gst_rtmp2_server_debug_category, "rtmp2server", 0,
+      "debug category for rtmp2server element");
+}
+
+static void
+gst_rtmp2_server_init (GstRtmp2Server * self)
+{
+  self->host = g_strdup (DEFAULT_HOST);
+  self->port = DEFAULT_PORT;
+  self->current_port = -1;
+  self->application = g_strdup (DEFAULT_APPLICATION);
+  self->max_publishers = DEFAULT_MAX_PUBLISHERS;
+  self->max_queue_size = DEFAULT_MAX_QUEUE_SIZE;
+
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+
+  self->task = gst_task_new (gst_rtmp2_server_task_func, self, NULL);
+  g_rec_mutex_init (&self->task_lock);
+  gst_task_set_lock (self->task, &self->task_lock);
+
+  GST_OBJECT_FLAG_SET (self, GST_ELEMENT_FLAG_SOURCE);
+}
+
+static void
+gst_rtmp2_server_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtmp2Server *self = GST_RTMP2_SERVER (object);
+
+  switch (property_id) {
+    case PROP_HOST:
+      GST_OBJECT_LOCK (self);
+      g_free (self->host);
+      self->host = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PORT:
+      GST_OBJECT_LOCK (self);
+      self->port = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_APPLICATION:
+      GST_OBJECT_LOCK (self);
+      g_free (self->application);
+      self->application = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_MAX_PUBLISHERS:
+      GST_OBJECT_LOCK (self);
+      self->max_publishers = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_MAX_QUEUE_SIZE:
+      GST_OBJECT_LOCK (self);
+      self->max_queue_size = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtmp2_server_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtmp2Server *self = GST_RTMP2_SERVER (object);
+
+  switch (property_id) {
+    case PROP_HOST:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->host);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PORT:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->port);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_CURRENT_PORT:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int (value, self->current_port);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_APPLICATION:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->application);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_MAX_PUBLISHERS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->max_publishers);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_MAX_QUEUE_SIZE:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->max_queue_size);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtmp2_server_finalize (GObject * object)
+{
+  GstRtmp2Server *self = GST_RTMP2_SERVER (object);
+
+  g_clear_object (&self->cancellable);
+  g_clear_object (&self->listener);
+
+  g_clear_object (&self->task);
+  g_rec_mutex_clear (&self->task_lock);
+
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  g_free (self->host);
+  g_free (self->application);
+
+  G_OBJECT_CLASS (gst_rtmp2_server_parent_class)->finalize (object);
+}
+
+static Publisher *
+publisher_new (GstRtmp2Server * self, const gchar * application,
+    const gchar * stream)
+{
+  Publisher *publisher = g_slice_new0 (Publisher);
+
+  publisher->refcount = 1;
+  publisher->server = self;
+  publisher->application = g_strdup (application);
+  publisher->stream = g_strdup (stream);
+  g_mutex_init (&publisher->lock);
+  g_cond_init (&publisher->cond);
+  g_queue_init (&publisher->queue);
+
+  return publisher;
+}
+
+static Publisher *
+publisher_ref (Publisher * publisher)
+{
+  g_atomic_int_inc (&publisher->refcount);
+  return publisher;
+}
+
+static void
+publisher_unref (Publisher * publisher)
+{
+  if (!g_atomic_int_dec_and_test (&publisher->refcount))
+    return;
+
+  g_queue_foreach (&publisher->queue, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&publisher->queue);
+  g_mutex_clear (&publisher->lock);
+  g_cond_clear (&publisher->cond);
+  gst_clear_object (&publisher->pad);
+  g_free (publisher->application);
+  g_free (publisher->stream);
+  g_slice_free (Publisher, publisher);
+}
+
+static void
+publisher_set_eos (Publisher * publisher)
+{
+  g_mutex_lock (&publisher->lock);
+  publisher->eos = TRUE;
+  g_cond_signal (&publisher->cond);
+  g_mutex_unlock (&publisher->lock);
+}
+
+static void
+post_publish_message (GstRtmp2Server * self, Publisher * publisher,
+    GSocketAddress * address, gboolean started)
+{
+  GstStructure *s;
+
+  s = gst_structure_new (started ? "rtmp2server-publish-started" :
+      "rtmp2server-publish-stopped",
+      "pad", GST_TYPE_PAD, publisher->pad,
+      "application", G_TYPE_STRING, publisher->application,
+      "stream", G_TYPE_STRING, publisher->stream,
+      "address", G_TYPE_SOCKET_ADDRESS, address, NULL);
+
+  if (!started) {
+    gst_structure_set (s, "dropped", G_TYPE_UINT64, publisher->dropped, NULL);
+  }
+
+  gst_element_post_message (GST_ELEMENT (self),
+      gst_message_new_element (GST_OBJECT (self), s));
+}
+
+/* Stops the pad of @publisher and removes it, unless that's done already.
+ * Must not be called from the pad task */
+static void
+gst_rtmp2_server_remove_publisher (GstRtmp2Server * self,
+    Publisher * publisher)
+{
+  GList *link;
+
+  g_mutex_lock (&self->lock);
+  link = g_list_find (self->publishers, publisher);
+  if (!link) {
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+  self->publishers = g_list_delete_link (self->publishers, link);
+  g_mutex_unlock (&self->lock);
+
+  GST_DEBUG_OBJECT (self, "Removing %" GST_PTR_FORMAT, publisher->pad);
+
+  g_mutex_lock (&publisher->lock);
+  publisher->flushing = TRUE;
+  g_cond_signal (&publisher->cond);
+  g_mutex_unlock (&publisher->lock);
+
+  gst_pad_set_active (publisher->pad, FALSE);
+  gst_pad_stop_task (publisher->pad);
+  gst_element_remove_pad (GST_ELEMENT (self), publisher->pad);
+
+  /* The reference of the list */
+  publisher_unref (publisher);
+}
+
+static void
+remove_publisher_async (GstElement * element, gpointer user_data)
+{
+  gst_rtmp2_server_remove_publisher (GST_RTMP2_SERVER (element), user_data);
+}
+
+static void
+publisher_loop (gpointer user_data)
+{
+  Publisher *publisher = user_data;
+  GstRtmp2Server *self = publisher->server;
+  GstBuffer *buffer;
+  GstFlowReturn ret;
+
+  g_mutex_lock (&publisher->lock);
+  while (g_queue_is_empty (&publisher->queue) && !publisher->eos &&
+      !publisher->flushing) {
+    g_cond_wait (&publisher->cond, &publisher->lock);
+  }
+
+  if (publisher->flushing) {
+    g_mutex_unlock (&publisher->lock);
+    goto pause;
+  }
+
+  buffer = g_queue_pop_head (&publisher->queue);
+  g_mutex_unlock (&publisher->lock);
+
+  if (!buffer) {
+    GST_INFO_OBJECT (publisher->pad, "Publishing stopped, pushing EOS");
+    gst_pad_push_event (publisher->pad, gst_event_new_eos ());
+    gst_element_call_async (GST_ELEMENT (self), remove_publisher_async,
+        publisher_ref (publisher), (GDestroyNotify) publisher_unref);
+    goto pause;
+  }
+
+  ret = gst_pad_push (publisher->pad, buffer);
+
+  /* Keep emptying the queue of unlinked pads, the application may link
+   * them later */
+  if (ret == GST_FLOW_OK || ret == GST_FLOW_NOT_LINKED)
+    return;
+
+  GST_DEBUG_OBJECT (publisher->pad, "Pausing task, reason %s",
+      gst_flow_get_name (ret));
+
+  if (ret == GST_FLOW_EOS) {
+    /* Downstream doesn't want more of this stream */
+    g_mutex_lock (&publisher->lock);
+    publisher->flushing = TRUE;
+    g_queue_foreach (&publisher->queue, (GFunc) gst_buffer_unref, NULL);
+    g_queue_clear (&publisher->queue);
+    g_mutex_unlock (&publisher->lock);
+  } else if (ret < GST_FLOW_EOS) {
+    GST_ELEMENT_FLOW_ERROR (self, ret);
+    gst_pad_push_event (publisher->pad, gst_event_new_eos ());
+  }
+
+pause:
+  gst_pad_pause_task (publisher->pad);
+}
+
+/* Called from the loop thread with a new FLV tag */
+static void
+publisher_push (Publisher * publisher, GstBuffer * buffer, guint max_queue)
+{
+  g_mutex_lock (&publisher->lock);
+
+  if (publisher->flushing) {
+    gst_buffer_unref (buffer);
+    goto out;
+  }
+
+  if (g_queue_get_length (&publisher->queue) >= max_queue) {
+    GST_LOG_OBJECT (publisher->pad, "Queue full, dropping %" GST_PTR_FORMAT,
+        buffer);
+    gst_buffer_unref (buffer);
+    publisher->dropped++;
+    publisher->discont = TRUE;
+    goto out;
+  }
+
+  if (publisher->discont) {
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+    publisher->discont = FALSE;
+  }
+
+  g_queue_push_tail (&publisher->queue, buffer);
+  g_cond_signal (&publisher->cond);
+
+out:
+  g_mutex_unlock (&publisher->lock);
+}
+
+/* Called from the loop thread, returns FALSE if the publish must be
+ * rejected */
+static gboolean
+gst_rtmp2_server_add_publisher (GstRtmp2Server * self, Publisher * publisher)
+{
+  GstPad *pad;
+  GstSegment segment;
+  GstCaps *caps;
+  gchar *name, *stream_id;
+  guint max_publishers;
+  GList *l;
+
+  GST_OBJECT_LOCK (self);
+  max_publishers = self->max_publishers;
+  GST_OBJECT_UNLOCK (self);
+
+  g_mutex_lock (&self->lock);
+
+  if (max_publishers && g_list_length (self->publishers) >= max_publishers) {
+    GST_WARNING_OBJECT (self, "Rejecting '%s/%s', too many publishers",
+        publisher->application, publisher->stream);
+    g_mutex_unlock (&self->lock);
+    return FALSE;
+  }
+
+  for (l = self->publishers; l; l = l->next) {
+    Publisher *other = l->data;
+
+    if (g_str_equal (other->application, publisher->application) &&
+        g_str_equal (other->stream, publisher->stream)) {
+      GST_WARNING_OBJECT (self, "Rejecting '%s/%s', already published",
+          publisher->application, publisher->stream);
+      g_mutex_unlock (&self->lock);
+      return FALSE;
+    }
+  }
+
+  name = g_strdup_printf ("src_%u", self->pad_count++);
+  self->publishers = g_list_append (self->publishers,
+      publisher_ref (publisher));
+  g_mutex_unlock (&self->lock);
+
+  pad = gst_pad_new_from_static_template (&gst_rtmp2_server_src_template,
+      name);
+  g_free (name);
+
+  publisher->pad = gst_object_ref (pad);
+  gst_pad_use_fixed_caps (pad);
+  gst_pad_set_active (pad, TRUE);
+
+  stream_id = gst_pad_create_stream_id_printf (pad, GST_ELEMENT (self),
+      "%s/%s", publisher->application, publisher->stream);
+  gst_pad_push_event (pad, gst_event_new_stream_start (stream_id));
+  g_free (stream_id);
+
+  caps = gst_static_pad_template_get_caps (&gst_rtmp2_server_src_template);
+  gst_pad_set_caps (pad, caps);
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (pad, gst_event_new_segment (&segment));
+
+  gst_element_add_pad (GST_ELEMENT (self), pad);
+  gst_pad_start_task (pad, publisher_loop, publisher, NULL);
+
+  return TRUE;
+}
+
+static void
+got_message (GstRtmpConnection * connection, GstBuffer * buffer,
+    gpointer user_data)
+{
+  Client *client = user_data;
+  GstRtmp2Server *self = client->server;
+  Publisher *publisher = client->publisher;
+  GstRtmpMeta *meta = gst_buffer_get_rtmp_meta (buffer);
+  guint32 min_size = 1, timestamp = 0;
+  gsize offset = 0;
+  GstBuffer *tag;
+  guint max_queue;
+
+  static const guint8 flv_header_data[] = {
+    0x46, 0x4c, 0x56, 0x01, 0x01, 0x00, 0x00, 0x00,
+    0x09, 0x00, 0x00, 0x00, 0x00,
+  };
+
+  /* The AMF0 string "@setDataFrame" publishers put before the metadata */
+  static const guint8 set_data_frame[] = {
+    0x02, 0x00, 0x0d, '@', 's', 'e', 't', 'D', 'a', 't', 'a', 'F', 'r', 'a',
+    'm', 'e',
+  };
+
+  g_return_if_fail (meta);
+
+  if (meta->mstream != client->stream_id) {
+    GST_DEBUG_OBJECT (self, "Ignoring %s message with stream %" G_GUINT32_FORMAT
+        " != %" G_GUINT32_FORMAT, gst_rtmp_message_type_get_nick (meta->type),
+        meta->mstream, client->stream_id);
+    return;
+  }
+
+  switch (meta->type) {
+    case GST_RTMP_MESSAGE_TYPE_VIDEO:
+      min_size = 6;
+      break;
+
+    case GST_RTMP_MESSAGE_TYPE_AUDIO:
+      min_size = 2;
+      break;
+
+    case GST_RTMP_MESSAGE_TYPE_DATA_AMF0:
+      if (gst_buffer_memcmp (buffer, 0, set_data_frame,
+              sizeof set_data_frame) == 0) {
+        offset = sizeof set_data_frame;
+      }
+      break;
+
+    default:
+      GST_DEBUG_OBJECT (self, "Ignoring %s message, wrong type",
+          gst_rtmp_message_type_get_nick (meta->type));
+      return;
+  }
+
+  if (meta->size < min_size + offset) {
+    GST_DEBUG_OBJECT (self, "Ignoring too small %s message (%" G_GUINT32_FORMAT
+        " < %" G_GUINT32_FORMAT ")",
+        gst_rtmp_message_type_get_nick (meta->type), meta->size,
+        (guint32) (min_size + offset));
+    return;
+  }
+
+  if (GST_BUFFER_DTS_IS_VALID (buffer)) {
+    timestamp = GST_BUFFER_DTS (buffer) / GST_MSECOND;
+  }
+
+  tag = gst_rtmp_message_to_flv_tag (buffer, offset, timestamp);
+  GST_BUFFER_DTS (tag) = GST_BUFFER_DTS (buffer);
+
+  if (!publisher->sent_header) {
+    GstMemory *memory = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+        (guint8 *) flv_header_data, sizeof flv_header_data, 0,
+        sizeof flv_header_data, NULL, NULL);
+    gst_buffer_prepend_memory (tag, memory);
+    publisher->sent_header = TRUE;
+  }
+
+  GST_OBJECT_LOCK (self);
+  max_queue = self->max_queue_size;
+  GST_OBJECT_UNLOCK (self);
+
+  publisher_push (publisher, tag, max_queue);
+}
+
+static void
+client_end (Client * client)
+{
+  GstRtmp2Server *self = client->server;
+
+  GST_INFO_OBJECT (self, "Client %p gone", client);
+
+  self->clients = g_list_remove (self->clients, client);
+  client_free (client);
+}
+
+static void
+client_error (GstRtmpConnection * connection, gpointer user_data)
+{
+  client_end (user_data);
+}
+
+static void
+on_command (GstRtmpConnection * connection, guint32 stream_id,
+    const gchar * command_name, gdouble transaction_id, GPtrArray * args,
+    gpointer user_data)
+{
+  Client *client = user_data;
+
+  if (gst_rtmp_server_is_stop_command (command_name)) {
+    GST_INFO_OBJECT (client->server, "Client stopped publishing ('%s')",
+        command_name);
+    client_end (client);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (client->server, "Ignoring command \"%s\"",
+      GST_STR_NULL (command_name));
+}
+
+static void
+wait_publish_done (GObject * source, GAsyncResult * result,
+    gpointer user_data)
+{
+  GstRtmpConnection *connection = GST_RTMP_CONNECTION (source);
+  Client *client = user_data;
+  GstRtmp2Server *self = client->server;
+  GError *error = NULL;
+  gchar *stream = NULL;
+  Publisher *publisher;
+
+  if (!gst_rtmp_server_wait_publish_finish (connection, result,
+          &client->stream_id, &stream, &error)) {
+    GST_INFO_OBJECT (self, "Client %p failed to publish: %s", client,
+        error->message);
+    g_error_free (error);
+    client_end (client);
+    return;
+  }
+
+  publisher = publisher_new (self, client->application, stream);
+
+  if (!gst_rtmp2_server_add_publisher (self, publisher)) {
+    /* Let the client close the connection once it got the status */
+    gst_rtmp_server_send_publish_status (connection, client->stream_id,
+        stream, FALSE);
+    client->error_handler_id = g_signal_connect (connection, "error",
+        G_CALLBACK (client_error), client);
+    publisher_unref (publisher);
+    g_free (stream);
+    return;
+  }
+
+  client->publisher = publisher;
+  gst_rtmp_server_send_publish_status (connection, client->stream_id,
+      stream, TRUE);
+  g_free (stream);
+
+  post_publish_message (self, publisher, client->address, TRUE);
+
+  gst_rtmp_connection_set_input_handler (connection, got_message, client,
+      NULL);
+  gst_rtmp_connection_set_command_handler (connection, on_command, client,
+      NULL);
+  client->error_handler_id = g_signal_connect (connection, "error",
+      G_CALLBACK (client_error), client);
+}
+
+static void
+server_accept_done (GObject * source, GAsyncResult * result,
+    gpointer user_data)
+{
+  Client *client = user_data;
+  GstRtmp2Server *self = client->server;
+  GError *error = NULL;
+
+  client->connection = gst_rtmp_server_accept_finish (result,
+      &client->application, &error);
+  if (!client->connection) {
+    GST_INFO_OBJECT (self, "Client %p failed to connect: %s", client,
+        error->message);
+    g_error_free (error);
+    client_end (client);
+    return;
+  }
+
+  gst_rtmp_server_wait_publish_async (client->connection, self->cancellable,
+      wait_publish_done, client);
+}
+
+static void
+accept_done (GObject * source, GAsyncResult * result, gpointer user_data)
+{
+  GstRtmp2Server *self = GST_RTMP2_SERVER (user_data);
+  GSocketConnection *socket_connection;
+  GError *error = NULL;
+  Client *client;
+  gchar *application;
+
+  socket_connection = g_socket_listener_accept_finish (self->listener,
+      result, NULL, &error);
+  if (!socket_connection) {
+    if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      GST_DEBUG_OBJECT (self, "Accepting was cancelled");
+      g_error_free (error);
+      return;
+    }
+
+    GST_WARNING_OBJECT (self, "Failed to accept: %s", error->message);
+    g_error_free (error);
+    accept_next (self);
+    return;
+  }
+
+  client = g_slice_new0 (Client);
+  client->server = self;
+  client->address = g_socket_connection_get_remote_address (socket_connection,
+      NULL);
+  self->clients = g_list_prepend (self->clients, client);
+
+  GST_INFO_OBJECT (self, "Accepted client %p", client);
+
+  GST_OBJECT_LOCK (self);
+  application = g_strdup (self->application);
+  GST_OBJECT_UNLOCK (self);
+
+  gst_rtmp_server_accept_async (socket_connection, application,
+      self->cancellable, server_accept_done, client);
+
+  g_free (application);
+  g_object_unref (socket_connection);
+
+  accept_next (self);
+}
+
+static void
+accept_next (GstRtmp2Server * self)
+{
+  g_socket_listener_accept_async (self->listener, self->cancellable,
+      accept_done, self);
+}
+
+static void
+client_free (Client * client)
+{
+  if (client->publisher) {
+    publisher_set_eos (client->publisher);
+    post_publish_message (client->server, client->publisher, client->address,
+        FALSE);
+    publisher_unref (client->publisher);
+  }
+
+  if (client->connection) {
+    if (client->error_handler_id) {
+      g_signal_handler_disconnect (client->connection,
+          client->error_handler_id);
+    }
+    gst_rtmp_connection_set_input_handler (client->connection, NULL, NULL,
+        NULL);
+    gst_rtmp_connection_set_command_handler (client->connection, NULL, NULL,
+        NULL);
+    gst_rtmp_connection_close_and_unref (client->connection);
+  }
+
+  g_clear_object (&client->address);
+  g_free (client->application);
+  g_slice_free (Client, client);
+}
+
+static gboolean
+main_loop_running_cb (GstRtmp2Server * self)
+{
+  GST_TRACE_OBJECT (self, "Main loop running now");
+
+  accept_next (self);
+
+  g_mutex_lock (&self->lock);
+  self->started = TRUE;
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Mainloop task, handles all the client connections */
+static void
+gst_rtmp2_server_task_func (gpointer user_data)
+{
+  GstRtmp2Server *self = GST_RTMP2_SERVER (user_data);
+  GMainContext *context;
+  GMainLoop *loop;
+  GSource *source;
+
+  GST_DEBUG_OBJECT (self, "gst_rtmp2_server_task starting");
+  g_mutex_lock (&self->lock);
+
+  context = self->context = g_main_context_new ();
+  g_main_context_push_thread_default (context);
+  loop = self->loop = g_main_loop_new (context, TRUE);
+
+  source = g_idle_source_new ();
+  g_source_set_callback (source, (GSourceFunc) main_loop_running_cb, self,
+      NULL);
+  g_source_attach (source, self->context);
+  g_source_unref (source);
+
+  /* Run loop */
+  g_mutex_unlock (&self->lock);
+  g_main_loop_run (loop);
+
+  /* Let the cancelled operations finish, then close the connections left */
+  while (g_main_context_pending (context)) {
+    GST_DEBUG_OBJECT (self, "iterating main context to clean up");
+    g_main_context_iteration (context, FALSE);
+  }
+  g_list_free_full (g_steal_pointer (&self->clients),
+      (GDestroyNotify) client_free);
+  g_main_context_pop_thread_default (context);
+
+  g_mutex_lock (&self->lock);
+  g_clear_pointer (&self->loop, g_main_loop_unref);
+  g_clear_pointer (&self->context, g_main_context_unref);
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  GST_DEBUG_OBJECT (self, "gst_rtmp2_server_task exiting");
+}
+
+static gboolean
+gst_rtmp2_server_start (GstRtmp2Server * self)
+{
+  GSocketAddress *address, *effective = NULL;
+  GInetAddress *inet_address;
+  GError *error = NULL;
+  gchar *host;
+  guint port;
+
+  GST_OBJECT_LOCK (self);
+  host = g_strdup (self->host);
+  port = self->port;
+  GST_OBJECT_UNLOCK (self);
+
+  if (host) {
+    inet_address = g_inet_address_new_from_string (host);
+  } else {
+    inet_address = g_inet_address_new_any (G_SOCKET_FAMILY_IPV4);
+  }
+
+  if (!inet_address) {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+        ("Invalid host address '%s'", host));
+    g_free (host);
+    return FALSE;
+  }
+
+  self->listener = g_socket_listener_new ();
+  address = g_inet_socket_address_new (inet_address, port);
+  g_object_unref (inet_address);
+
+  if (!g_socket_listener_add_address (self->listener, address,
+          G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_TCP, NULL, &effective,
+          &error)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ,
+        ("Could not listen on %s:%u", GST_STR_NULL (host), port),
+        ("%s", error->message));
+    g_error_free (error);
+    g_object_unref (address);
+    g_clear_object (&self->listener);
+    g_free (host);
+    return FALSE;
+  }
+  g_object_unref (address);
+  g_free (host);
+
+  port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (effective));
+  g_object_unref (effective);
+  GST_INFO_OBJECT (self, "Listening on port %u", port);
+
+  GST_OBJECT_LOCK (self);
+  self->current_port = port;
+  GST_OBJECT_UNLOCK (self);
+
+  g_object_notify (G_OBJECT (self), "current-port");
+
+  g_mutex_lock (&self->lock);
+  self->cancellable = g_cancellable_new ();
+  self->started = FALSE;
+  gst_task_start (self->task);
+
+  while (!self->started) {
+    g_cond_wait (&self->cond, &self->lock);
+  }
+  g_mutex_unlock (&self->lock);
+
+  return TRUE;
+}
+
+static gboolean
+quit_invoker (gpointer user_data)
+{
+  g_main_loop_quit (user_data);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gst_rtmp2_server_stop (GstRtmp2Server * self)
+{
+  GList *publishers;
+
+  g_mutex_lock (&self->lock);
+  gst_task_stop (self->task);
+
+  if (self->cancellable) {
+    GST_DEBUG_OBJECT (self, "Cancelling");
+    g_cancellable_cancel (self->cancellable);
+  }
+
+  if (self->loop) {
+    GST_DEBUG_OBJECT (self, "Stopping loop");
+    g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT_IDLE,
+        quit_invoker, g_main_loop_ref (self->loop),
+        (GDestroyNotify) g_main_loop_unref);
+  }
+  g_mutex_unlock (&self->lock);
+
+  gst_task_join (self->task);
+
+  if (self->listener) {
+    g_socket_listener_close (self->listener);
+    g_clear_object (&self->listener);
+  }
+  g_clear_object (&self->cancellable);
+
+  GST_OBJECT_LOCK (self);
+  self->current_port = -1;
+  GST_OBJECT_UNLOCK (self);
+
+  g_mutex_lock (&self->lock);
+  publishers = g_list_copy (self->publishers);
+  g_mutex_unlock (&self->lock);
+
+  g_list_foreach (publishers, (GFunc) publisher_ref, NULL);
+  while (publishers) {
+    Publisher *publisher = publishers->data;
+
+    gst_rtmp2_server_remove_publisher (self, publisher);
+    publisher_unref (publisher);
+    publishers = g_list_delete_link (publishers, publishers);
+  }
+}
+
+static GstStateChangeReturn
+gst_rtmp2_server_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstRtmp2Server *self = GST_RTMP2_SERVER (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!gst_rtmp2_server_start (self))
+        return GST_STATE_CHANGE_FAILURE;
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_rtmp2_server_stop (self);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (gst_rtmp2_server_parent_class)->change_state
+      (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE) {
+    if (transition == GST_STATE_CHANGE_READY_TO_PAUSED)
+      gst_rtmp2_server_stop (self);
+    return ret;
+  }
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      ret = GST_STATE_CHANGE_NO_PREROLL;
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
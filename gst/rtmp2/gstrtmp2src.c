@@ -650,27 +650,7 @@ gst_rtmp2_src_create (GstBaseSrc * src, guint64 offset, guint size,
     timestamp = ts / GST_MSECOND;
   }
 
-  buffer = gst_buffer_copy_region (message, GST_BUFFER_COPY_MEMORY, 0, -1);
-
-  {
-    guint8 *tag_header = g_malloc (11);
-    GstMemory *memory =
-        gst_memory_new_wrapped (0, tag_header, 11, 0, 11, tag_header, g_free);
-    GST_WRITE_UINT8 (tag_header, meta->type);
-    GST_WRITE_UINT24_BE (tag_header + 1, meta->size);
-    GST_WRITE_UINT24_BE (tag_header + 4, timestamp);
-    GST_WRITE_UINT8 (tag_header + 7, timestamp >> 24);
-    GST_WRITE_UINT24_BE (tag_header + 8, 0);
-    gst_buffer_prepend_memory (buffer, memory);
-  }
-
-  {
-    guint8 *tag_footer = g_malloc (4);
-    GstMemory *memory =
-        gst_memory_new_wrapped (0, tag_footer, 4, 0, 4, tag_footer, g_free);
-    GST_WRITE_UINT32_BE (tag_footer, meta->size + 11);
-    gst_buffer_append_memory (buffer, memory);
-  }
+  buffer = gst_rtmp_message_to_flv_tag (message, 0, timestamp);
 
   if (!self->sent_header) {
     GstMemory *memory = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
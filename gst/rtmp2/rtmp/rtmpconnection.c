@@ -71,6 +71,10 @@ struct _GstRtmpConnection
   gpointer output_handler_user_data;
   GDestroyNotify output_handler_user_data_destroy;
 
+  GstRtmpConnectionCommandFunc command_handler;
+  gpointer command_handler_user_data;
+  GDestroyNotify command_handler_user_data_destroy;
+
   gboolean writing;
 
   /* Protects the values below during concurrent access.
@@ -277,6 +281,7 @@ gst_rtmp_connection_dispose (GObject * object)
   g_cancellable_cancel (rtmpconnection->cancellable);
   gst_rtmp_connection_set_input_handler (rtmpconnection, NULL, NULL, NULL);
   gst_rtmp_connection_set_output_handler (rtmpconnection, NULL, NULL, NULL);
+  gst_rtmp_connection_set_command_handler (rtmpconnection, NULL, NULL, NULL);
 
   G_OBJECT_CLASS (gst_rtmp_connection_parent_class)->dispose (object);
 }
@@ -434,6 +439,22 @@ gst_rtmp_connection_set_output_handler (GstRtmpConnection * sc,
   sc->output_handler_user_data_destroy = user_data_destroy;
 }
 
+/* Receives the commands that are neither responses nor expected, such as
+ * the ones a client sends to a server */
+void
+gst_rtmp_connection_set_command_handler (GstRtmpConnection * sc,
+    GstRtmpConnectionCommandFunc callback, gpointer user_data,
+    GDestroyNotify user_data_destroy)
+{
+  if (sc->command_handler_user_data_destroy) {
+    sc->command_handler_user_data_destroy (sc->command_handler_user_data);
+  }
+
+  sc->command_handler = callback;
+  sc->command_handler_user_data = user_data;
+  sc->command_handler_user_data_destroy = user_data_destroy;
+}
+
 static gboolean
 gst_rtmp_connection_input_ready (GInputStream * is, gpointer user_data)
 {
@@ -1057,7 +1078,7 @@ gst_rtmp_connection_handle_cm (GstRtmpConnection * sc, GstBuffer * buffer)
   } else {
     GList *l;
 
-    if (transaction_id != 0) {
+    if (transaction_id != 0 && !sc->command_handler) {
       GST_FIXME_OBJECT (sc, "Server sent command \"%s\" expecting reply",
           GST_STR_NULL (command_name));
     }
@@ -1080,6 +1101,13 @@ gst_rtmp_connection_handle_cm (GstRtmpConnection * sc, GstBuffer * buffer)
       g_list_free_full (l, expected_command_free);
       break;
     }
+
+    if (!l && sc->command_handler) {
+      GST_LOG_OBJECT (sc, "calling command handler %s",
+          GST_DEBUG_FUNCPTR_NAME (sc->command_handler));
+      sc->command_handler (sc, meta->mstream, command_name, transaction_id,
+          args, sc->command_handler_user_data);
+    }
   }
 
   g_free (command_name);
@@ -1111,18 +1139,34 @@ gst_rtmp_connection_get_num_queued (GstRtmpConnection * connection)
   return g_async_queue_length (connection->output_queue);
 }
 
+static void
+queue_command_valist (GstRtmpConnection * connection, guint32 stream_id,
+    gdouble transaction_id, const gchar * command_name,
+    const GstAmfNode * argument, va_list ap)
+{
+  GstBuffer *buffer;
+  GBytes *payload;
+  guint8 *data;
+  gsize size;
+
+  payload = gst_amf_serialize_command_valist (transaction_id,
+      command_name, argument, ap);
+
+  data = g_bytes_unref_to_data (payload, &size);
+  buffer = gst_rtmp_message_new_wrapped (GST_RTMP_MESSAGE_TYPE_COMMAND_AMF0,
+      3, stream_id, data, size);
+
+  gst_rtmp_connection_queue_message (connection, buffer);
+}
+
 guint
 gst_rtmp_connection_send_command (GstRtmpConnection * connection,
     GstRtmpCommandCallback response_command, gpointer user_data,
     guint32 stream_id, const gchar * command_name, const GstAmfNode * argument,
     ...)
 {
-  GstBuffer *buffer;
   gdouble transaction_id = 0;
   va_list ap;
-  GBytes *payload;
-  guint8 *data;
-  gsize size;
 
   g_return_val_if_fail (GST_IS_RTMP_CONNECTION (connection), 0);
 
@@ -1148,18 +1192,38 @@ gst_rtmp_connection_send_command (GstRtmpConnection * connection,
   }
 
   va_start (ap, argument);
-  payload = gst_amf_serialize_command_valist (transaction_id,
-      command_name, argument, ap);
+  queue_command_valist (connection, stream_id, transaction_id, command_name,
+      argument, ap);
   va_end (ap);
 
-  data = g_bytes_unref_to_data (payload, &size);
-  buffer = gst_rtmp_message_new_wrapped (GST_RTMP_MESSAGE_TYPE_COMMAND_AMF0,
-      3, stream_id, data, size);
-
-  gst_rtmp_connection_queue_message (connection, buffer);
   return transaction_id;
 }
 
+/* Answers a command received by the command handler, with "_result",
+ * "_error" or a status command like "onStatus" */
+void
+gst_rtmp_connection_send_response (GstRtmpConnection * connection,
+    guint32 stream_id, gdouble transaction_id, const gchar * command_name,
+    const GstAmfNode * argument, ...)
+{
+  va_list ap;
+
+  g_return_if_fail (GST_IS_RTMP_CONNECTION (connection));
+
+  if (connection->thread != g_thread_self ()) {
+    GST_ERROR_OBJECT (connection, "Called from wrong thread");
+  }
+
+  GST_DEBUG_OBJECT (connection,
+      "Sending response '%s' for transaction %.0f on stream id %"
+      G_GUINT32_FORMAT, command_name, transaction_id, stream_id);
+
+  va_start (ap, argument);
+  queue_command_valist (connection, stream_id, transaction_id, command_name,
+      argument, ap);
+  va_end (ap);
+}
+
 void
 gst_rtmp_connection_expect_command (GstRtmpConnection * connection,
     GstRtmpCommandCallback response_command, gpointer user_data,
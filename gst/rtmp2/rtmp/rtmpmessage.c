@@ -25,6 +25,7 @@
 #include "amf.h"
 #include "rtmpmessage.h"
 #include "rtmpchunkstream.h"
+#include "rtmputils.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_rtmp_message_debug_category);
 #define GST_CAT_DEFAULT gst_rtmp_message_debug_category
@@ -538,3 +539,40 @@ err:
   gst_buffer_unmap (buffer, &map);
   return ret;
 }
+
+/* Wraps the payload of @message, starting at @offset, into an FLV tag
+ * without copying it */
+GstBuffer *
+gst_rtmp_message_to_flv_tag (GstBuffer * message, gsize offset,
+    guint32 timestamp)
+{
+  GstRtmpMeta *meta = gst_buffer_get_rtmp_meta (message);
+  GstBuffer *buffer;
+  GstMemory *memory;
+  guint8 *tag_header, *tag_footer;
+  gsize size;
+
+  g_return_val_if_fail (meta, NULL);
+
+  buffer = gst_buffer_copy_region (message, GST_BUFFER_COPY_MEMORY, offset,
+      -1);
+  size = gst_buffer_get_size (buffer);
+
+  tag_header = g_malloc (GST_RTMP_FLV_TAG_HEADER_SIZE);
+  memory = gst_memory_new_wrapped (0, tag_header,
+      GST_RTMP_FLV_TAG_HEADER_SIZE, 0, GST_RTMP_FLV_TAG_HEADER_SIZE,
+      tag_header, g_free);
+  GST_WRITE_UINT8 (tag_header, meta->type);
+  GST_WRITE_UINT24_BE (tag_header + 1, size);
+  GST_WRITE_UINT24_BE (tag_header + 4, timestamp);
+  GST_WRITE_UINT8 (tag_header + 7, timestamp >> 24);
+  GST_WRITE_UINT24_BE (tag_header + 8, 0);
+  gst_buffer_prepend_memory (buffer, memory);
+
+  tag_footer = g_malloc (4);
+  memory = gst_memory_new_wrapped (0, tag_footer, 4, 0, 4, tag_footer, g_free);
+  GST_WRITE_UINT32_BE (tag_footer, size + GST_RTMP_FLV_TAG_HEADER_SIZE);
+  gst_buffer_append_memory (buffer, memory);
+
+  return buffer;
+}
@@ -141,6 +141,9 @@ GstBuffer * gst_rtmp_message_new_user_control (GstRtmpUserControl * uc);
 
 gboolean gst_rtmp_message_is_metadata (GstBuffer * buffer);
 
+GstBuffer * gst_rtmp_message_to_flv_tag (GstBuffer * message, gsize offset,
+    guint32 timestamp);
+
 G_END_DECLS
 
 #endif
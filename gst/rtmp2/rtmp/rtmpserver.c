@@ -0,0 +1,474 @@
+/* GStreamer RTMP Library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "rtmpserver.h"
+#include "rtmphandshake.h"
+#include "rtmpmessage.h"
+
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_rtmp_server_debug_category);
+#define GST_CAT_DEFAULT gst_rtmp_server_debug_category
+
+static void
+init_debug (void)
+{
+  static volatile gsize done = 0;
+  if (g_once_init_enter (&done)) {
+    GST_DEBUG_CATEGORY_INIT (gst_rtmp_server_debug_category, "rtmpserver",
+        0, "debug category for the rtmp server");
+    g_once_init_leave (&done, 1);
+  }
+}
+
+static void handshake_done (GObject * source, GAsyncResult * result,
+    gpointer user_data);
+static void connection_error (GstRtmpConnection * connection,
+    gpointer user_data);
+static void on_connect_command (GstRtmpConnection * connection,
+    guint32 stream_id, const gchar * command_name, gdouble transaction_id,
+    GPtrArray * args, gpointer user_data);
+static void on_publish_command (GstRtmpConnection * connection,
+    guint32 stream_id, const gchar * command_name, gdouble transaction_id,
+    GPtrArray * args, gpointer user_data);
+
+/* Same as what libavformat and nginx-rtmp announce */
+#define SERVER_FMS_VERSION "FMS/3,0,1,123"
+#define SERVER_CAPABILITIES 31
+
+typedef struct
+{
+  gchar *application;
+  GstRtmpConnection *connection;
+  gulong error_handler_id;
+} AcceptTaskData;
+
+static AcceptTaskData *
+accept_task_data_new (const gchar * application)
+{
+  AcceptTaskData *data = g_slice_new0 (AcceptTaskData);
+  data->application = g_strdup (application);
+  return data;
+}
+
+static void
+accept_task_data_free (gpointer ptr)
+{
+  AcceptTaskData *data = ptr;
+  g_clear_pointer (&data->application, g_free);
+  if (data->error_handler_id) {
+    g_signal_handler_disconnect (data->connection, data->error_handler_id);
+  }
+  g_clear_object (&data->connection);
+  g_slice_free (AcceptTaskData, data);
+}
+
+/**
+ * gst_rtmp_server_accept_async:
+ * @application: (nullable): the application clients must connect to, or
+ *   %NULL to accept any
+ *
+ * Runs the server side of the handshake on a freshly accepted
+ * @socket_connection and waits for the "connect" command of the client.
+ * Must be called from the thread that runs the main context the connection
+ * should live in.
+ */
+void
+gst_rtmp_server_accept_async (GSocketConnection * socket_connection,
+    const gchar * application, GCancellable * cancellable,
+    GAsyncReadyCallback callback, gpointer user_data)
+{
+  GTask *task;
+
+  g_return_if_fail (G_IS_SOCKET_CONNECTION (socket_connection));
+
+  init_debug ();
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_task_data (task, accept_task_data_new (application),
+      accept_task_data_free);
+
+  gst_rtmp_server_handshake (G_IO_STREAM (socket_connection), FALSE,
+      g_task_get_cancellable (task), handshake_done, task);
+}
+
+static void
+handshake_done (GObject * source, GAsyncResult * result, gpointer user_data)
+{
+  GIOStream *stream = G_IO_STREAM (source);
+  GSocketConnection *socket_connection = G_SOCKET_CONNECTION (stream);
+  GTask *task = user_data;
+  AcceptTaskData *data = g_task_get_task_data (task);
+  GError *error = NULL;
+
+  if (!gst_rtmp_server_handshake_finish (stream, result, &error)) {
+    g_io_stream_close_async (stream, G_PRIORITY_DEFAULT, NULL, NULL, NULL);
+    g_task_return_error (task, error);
+    g_object_unref (task);
+    return;
+  }
+
+  data->connection = gst_rtmp_connection_new (socket_connection,
+      g_task_get_cancellable (task));
+  data->error_handler_id = g_signal_connect (data->connection,
+      "error", G_CALLBACK (connection_error), task);
+
+  /* The task is referenced by the handler until the connect command is
+   * answered or the connection fails */
+  gst_rtmp_connection_set_command_handler (data->connection,
+      on_connect_command, task, NULL);
+}
+
+static void
+connection_error (GstRtmpConnection * connection, gpointer user_data)
+{
+  GTask *task = user_data;
+
+  gst_rtmp_connection_set_command_handler (connection, NULL, NULL, NULL);
+
+  if (!g_task_had_error (task)) {
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+        "error while waiting for the client");
+  }
+  g_object_unref (task);
+}
+
+static void
+send_connect_result (GstRtmpConnection * connection, gdouble transaction_id,
+    gboolean accepted)
+{
+  GstAmfNode *properties, *info;
+  GstRtmpProtocolControl pc = {
+    .type = GST_RTMP_MESSAGE_TYPE_SET_PEER_BANDWIDTH,
+    .param = GST_RTMP_DEFAULT_WINDOW_ACK_SIZE,
+    .param2 = 2,                /* dynamic */
+  };
+
+  if (accepted) {
+    gst_rtmp_connection_request_window_size (connection,
+        GST_RTMP_DEFAULT_WINDOW_ACK_SIZE);
+    gst_rtmp_connection_queue_message (connection,
+        gst_rtmp_message_new_protocol_control (&pc));
+  }
+
+  properties = gst_amf_node_new_object ();
+  gst_amf_node_append_field_string (properties, "fmsVer",
+      SERVER_FMS_VERSION, -1);
+  gst_amf_node_append_field_number (properties, "capabilities",
+      SERVER_CAPABILITIES);
+
+  info = gst_amf_node_new_object ();
+  gst_amf_node_append_field_string (info, "level",
+      accepted ? "status" : "error", -1);
+  gst_amf_node_append_field_string (info, "code", accepted ?
+      "NetConnection.Connect.Success" : "NetConnection.Connect.Rejected", -1);
+  gst_amf_node_append_field_string (info, "description", accepted ?
+      "Connection succeeded." : "Unknown application.", -1);
+  gst_amf_node_append_field_number (info, "objectEncoding", 0);
+
+  gst_rtmp_connection_send_response (connection, 0, transaction_id,
+      accepted ? "_result" : "_error", properties, info, NULL);
+
+  gst_amf_node_free (properties);
+  gst_amf_node_free (info);
+}
+
+static void
+on_connect_command (GstRtmpConnection * connection, guint32 stream_id,
+    const gchar * command_name, gdouble transaction_id, GPtrArray * args,
+    gpointer user_data)
+{
+  GTask *task = G_TASK (user_data);
+  AcceptTaskData *data = g_task_get_task_data (task);
+  const GstAmfNode *command_object, *node;
+  gchar *application = NULL, *query;
+
+  if (g_strcmp0 (command_name, "connect") != 0) {
+    GST_WARNING ("Ignoring command \"%s\" before connect",
+        GST_STR_NULL (command_name));
+    return;
+  }
+
+  gst_rtmp_connection_set_command_handler (connection, NULL, NULL, NULL);
+  g_signal_handler_disconnect (connection, data->error_handler_id);
+  data->error_handler_id = 0;
+
+  if (g_task_return_error_if_cancelled (task)) {
+    g_object_unref (task);
+    return;
+  }
+
+  command_object = args->len > 0 ? g_ptr_array_index (args, 0) : NULL;
+  node = command_object ? gst_amf_node_get_field (command_object, "app") :
+      NULL;
+  if (node) {
+    application = gst_amf_node_get_string (node, NULL);
+  }
+
+  if (!application) {
+    send_connect_result (connection, transaction_id, FALSE);
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "connect without application");
+    g_object_unref (task);
+    return;
+  }
+
+  /* Drop the authentication query, if any */
+  query = strchr (application, '?');
+  if (query) {
+    *query = '\0';
+  }
+
+  GST_INFO ("Client connecting to application '%s'", application);
+
+  if (data->application && g_strcmp0 (data->application, application) != 0) {
+    send_connect_result (connection, transaction_id, FALSE);
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_PERMISSION_DENIED,
+        "unknown application '%s'", application);
+    g_object_unref (task);
+    g_free (application);
+    return;
+  }
+
+  send_connect_result (connection, transaction_id, TRUE);
+
+  g_task_return_pointer (task, application, g_free);
+  g_object_unref (task);
+}
+
+/**
+ * gst_rtmp_server_accept_finish:
+ * @application: (out) (transfer full): the application the client connected
+ *   to
+ *
+ * Returns: (transfer full) (nullable): the connection, ready to receive the
+ *   stream commands of the client
+ */
+GstRtmpConnection *
+gst_rtmp_server_accept_finish (GAsyncResult * result, gchar ** application,
+    GError ** error)
+{
+  GTask *task = G_TASK (result);
+  AcceptTaskData *data = g_task_get_task_data (task);
+  gchar *app;
+
+  app = g_task_propagate_pointer (task, error);
+  if (!app) {
+    if (data->connection) {
+      gst_rtmp_connection_close (data->connection);
+    }
+    return NULL;
+  }
+
+  if (application) {
+    *application = app;
+  } else {
+    g_free (app);
+  }
+
+  return g_object_ref (data->connection);
+}
+
+typedef struct
+{
+  GstRtmpConnection *connection;
+  gulong error_handler_id;
+  guint32 next_stream_id;
+  guint32 stream_id;
+  gchar *stream;
+} PublishTaskData;
+
+static PublishTaskData *
+publish_task_data_new (GstRtmpConnection * connection)
+{
+  PublishTaskData *data = g_slice_new0 (PublishTaskData);
+  data->connection = g_object_ref (connection);
+  data->next_stream_id = 1;
+  return data;
+}
+
+static void
+publish_task_data_free (gpointer ptr)
+{
+  PublishTaskData *data = ptr;
+  if (data->error_handler_id) {
+    g_signal_handler_disconnect (data->connection, data->error_handler_id);
+  }
+  g_clear_object (&data->connection);
+  g_clear_pointer (&data->stream, g_free);
+  g_slice_free (PublishTaskData, data);
+}
+
+/**
+ * gst_rtmp_server_wait_publish_async:
+ *
+ * Answers the commands of a connected client until it sends "publish".
+ * The publish request must then be answered with
+ * gst_rtmp_server_send_publish_status().
+ */
+void
+gst_rtmp_server_wait_publish_async (GstRtmpConnection * connection,
+    GCancellable * cancellable, GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+  GTask *task;
+  PublishTaskData *data;
+
+  init_debug ();
+
+  task = g_task_new (connection, cancellable, callback, user_data);
+  data = publish_task_data_new (connection);
+  g_task_set_task_data (task, data, publish_task_data_free);
+
+  data->error_handler_id = g_signal_connect (connection,
+      "error", G_CALLBACK (connection_error), task);
+
+  gst_rtmp_connection_set_command_handler (connection, on_publish_command,
+      task, NULL);
+}
+
+static void
+on_publish_command (GstRtmpConnection * connection, guint32 stream_id,
+    const gchar * command_name, gdouble transaction_id, GPtrArray * args,
+    gpointer user_data)
+{
+  GTask *task = G_TASK (user_data);
+  PublishTaskData *data = g_task_get_task_data (task);
+  const GstAmfNode *node;
+
+  if (g_strcmp0 (command_name, "createStream") == 0) {
+    GstAmfNode *command_object = gst_amf_node_new_null ();
+    GstAmfNode *id = gst_amf_node_new_number (data->next_stream_id);
+
+    GST_DEBUG ("Created stream %" G_GUINT32_FORMAT, data->next_stream_id);
+    gst_rtmp_connection_send_response (connection, 0, transaction_id,
+        "_result", command_object, id, NULL);
+    data->next_stream_id++;
+
+    gst_amf_node_free (command_object);
+    gst_amf_node_free (id);
+    return;
+  }
+
+  if (g_strcmp0 (command_name, "publish") != 0) {
+    /* releaseStream, FCPublish and the like need no answer */
+    GST_DEBUG ("Ignoring command \"%s\"", GST_STR_NULL (command_name));
+    return;
+  }
+
+  gst_rtmp_connection_set_command_handler (connection, NULL, NULL, NULL);
+  g_signal_handler_disconnect (connection, data->error_handler_id);
+  data->error_handler_id = 0;
+
+  if (g_task_return_error_if_cancelled (task)) {
+    g_object_unref (task);
+    return;
+  }
+
+  node = args->len > 1 ? g_ptr_array_index (args, 1) : NULL;
+  data->stream = node ? gst_amf_node_get_string (node, NULL) : NULL;
+  if (!data->stream || stream_id == 0 || stream_id >= data->next_stream_id) {
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "invalid publish on stream %" G_GUINT32_FORMAT, stream_id);
+    g_object_unref (task);
+    return;
+  }
+
+  GST_INFO ("Client publishing '%s' on stream %" G_GUINT32_FORMAT,
+      data->stream, stream_id);
+
+  data->stream_id = stream_id;
+  g_task_return_boolean (task, TRUE);
+  g_object_unref (task);
+}
+
+gboolean
+gst_rtmp_server_wait_publish_finish (GstRtmpConnection * connection,
+    GAsyncResult * result, guint32 * stream_id, gchar ** stream,
+    GError ** error)
+{
+  PublishTaskData *data;
+
+  g_return_val_if_fail (g_task_is_valid (result, connection), FALSE);
+
+  if (!g_task_propagate_boolean (G_TASK (result), error)) {
+    return FALSE;
+  }
+
+  data = g_task_get_task_data (G_TASK (result));
+
+  if (stream_id) {
+    *stream_id = data->stream_id;
+  }
+  if (stream) {
+    *stream = g_strdup (data->stream);
+  }
+
+  return TRUE;
+}
+
+void
+gst_rtmp_server_send_publish_status (GstRtmpConnection * connection,
+    guint32 stream_id, const gchar * stream, gboolean accepted)
+{
+  GstAmfNode *command_object, *info;
+  gchar *description;
+
+  if (accepted) {
+    GstRtmpUserControl uc = {
+      .type = GST_RTMP_USER_CONTROL_TYPE_STREAM_BEGIN,
+      .param = stream_id,
+    };
+
+    gst_rtmp_connection_queue_message (connection,
+        gst_rtmp_message_new_user_control (&uc));
+  }
+
+  command_object = gst_amf_node_new_null ();
+
+  description = g_strdup_printf (accepted ? "%s is now published." :
+      "%s is already published.", GST_STR_NULL (stream));
+
+  info = gst_amf_node_new_object ();
+  gst_amf_node_append_field_string (info, "level",
+      accepted ? "status" : "error", -1);
+  gst_amf_node_append_field_string (info, "code", accepted ?
+      "NetStream.Publish.Start" : "NetStream.Publish.BadName", -1);
+  gst_amf_node_append_field_take_string (info, "description", description,
+      -1);
+
+  gst_rtmp_connection_send_response (connection, stream_id, 0, "onStatus",
+      command_object, info, NULL);
+
+  gst_amf_node_free (command_object);
+  gst_amf_node_free (info);
+}
+
+/* The commands a client sends when it stops publishing, see
+ * gst_rtmp_client_stop_publish() */
+gboolean
+gst_rtmp_server_is_stop_command (const gchar * command_name)
+{
+  return g_strcmp0 (command_name, "FCUnpublish") == 0 ||
+      g_strcmp0 (command_name, "closeStream") == 0 ||
+      g_strcmp0 (command_name, "deleteStream") == 0;
+}
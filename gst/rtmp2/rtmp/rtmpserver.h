@@ -0,0 +1,45 @@
+/* GStreamer RTMP Library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_RTMP_SERVER_H_
+#define _GST_RTMP_SERVER_H_
+
+#include "rtmpconnection.h"
+
+G_BEGIN_DECLS
+
+void gst_rtmp_server_accept_async (GSocketConnection * socket_connection,
+    const gchar * application, GCancellable * cancellable,
+    GAsyncReadyCallback callback, gpointer user_data);
+GstRtmpConnection *gst_rtmp_server_accept_finish (GAsyncResult * result,
+    gchar ** application, GError ** error);
+
+void gst_rtmp_server_wait_publish_async (GstRtmpConnection * connection,
+    GCancellable * cancellable, GAsyncReadyCallback callback,
+    gpointer user_data);
+gboolean gst_rtmp_server_wait_publish_finish (GstRtmpConnection * connection,
+    GAsyncResult * result, guint32 * stream_id, gchar ** stream,
+    GError ** error);
+
+void gst_rtmp_server_send_publish_status (GstRtmpConnection * connection,
+    guint32 stream_id, const gchar * stream, gboolean accepted);
+
+gboolean gst_rtmp_server_is_stop_command (const gchar * command_name);
+
+G_END_DECLS
+#endif
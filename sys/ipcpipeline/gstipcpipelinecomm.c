@@ -24,6 +24,9 @@
 #  include "config.h"
 #endif
 
+/* for the memfd sealing fcntl() commands */
+#define _GNU_SOURCE
+
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>
 #endif
@@ -35,14 +38,25 @@
 #include <string.h>
 #include <gst/base/gstbytewriter.h>
 #include <gst/gstprotection.h>
+#include <gst/allocators/allocators.h>
 #include "gstipcpipelinecomm.h"
 
+#ifdef G_OS_UNIX
+#  include <fcntl.h>
+#  include <sys/socket.h>
+#  include <sys/stat.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (gst_ipc_pipeline_comm_debug);
 #define GST_CAT_DEFAULT gst_ipc_pipeline_comm_debug
 
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
 
 GQuark QUARK_ID;
+static GQuark QUARK_FD_RELEASE;
+
+/* maximum number of file descriptors expected in a single read */
+#define MAX_RECEIVED_FDS 16
 
 typedef enum
 {
@@ -192,6 +206,10 @@ gst_ipc_pipeline_comm_data_type_get_name (GstIpcPipelineCommDataType type)
       return "MESSAGE";
     case GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE:
       return "GERROR_MESSAGE";
+    case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER:
+      return "FD_BUFFER";
+    case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_RELEASE:
+      return "BUFFER_RELEASE";
     default:
       return "UNKNOWN";
   }
@@ -262,6 +280,72 @@ write_byte_writer_to_fd (GstIpcPipelineComm * comm, GstByteWriter * bw)
   return ret;
 }
 
+/* Same as write_byte_writer_to_fd, but passes @fd along with the data.
+ * Returns 1 without writing anything if fdout can't carry file descriptors,
+ * 0 on success and -1 on error */
+static gint
+write_byte_writer_with_fd_to_fd (GstIpcPipelineComm * comm,
+    GstByteWriter * bw, gint fd)
+{
+#ifdef G_OS_UNIX
+  struct msghdr msg = { 0, };
+  struct iovec iov;
+  union
+  {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE (sizeof (int))];
+  } cmsgbuf;
+  struct cmsghdr *cmsg;
+  ssize_t written;
+  guint8 *data;
+  guint size;
+  gint ret = 0;
+
+  size = gst_byte_writer_get_size (bw);
+  data = gst_byte_writer_reset_and_get_data (bw);
+  if (!data)
+    return -1;
+
+  memset (&cmsgbuf, 0, sizeof (cmsgbuf));
+  iov.iov_base = data;
+  iov.iov_len = size;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cmsgbuf.buf;
+  msg.msg_controllen = sizeof (cmsgbuf.buf);
+  cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+  memcpy (CMSG_DATA (cmsg), &fd, sizeof (int));
+
+  GST_TRACE_OBJECT (comm->element, "Writing %u bytes and fd %d to fdout",
+      size, fd);
+  do {
+    written = sendmsg (comm->fdout, &msg, 0);
+  } while (written < 0 && (errno == EAGAIN || errno == EINTR));
+
+  if (written < 0) {
+    if (errno == ENOTSOCK || errno == EINVAL || errno == EOPNOTSUPP) {
+      ret = 1;
+    } else {
+      GST_ERROR_OBJECT (comm->element, "Failed to write to fd: %s",
+          strerror (errno));
+      ret = -1;
+    }
+  } else if ((gsize) written < size) {
+    /* the fd went along with the first chunk, the rest is plain data */
+    if (!write_to_fd_raw (comm, data + written, size - written))
+      ret = -1;
+  }
+
+  g_free (data);
+  return ret;
+#else
+  return 1;
+#endif
+}
+
 static void
 gst_ipc_pipeline_comm_write_ack_to_fd (GstIpcPipelineComm * comm, guint32 id,
     guint32 ret, CommRequestType type)
@@ -503,6 +587,52 @@ typedef struct
   guint64 flags;
 } CommBufferMetadata;
 
+typedef struct
+{
+  guint64 maxsize;
+  guint64 offset;
+  guint64 size;
+} CommFdMemoryInfo;
+
+typedef struct
+{
+  GstIpcPipelineComm *comm;
+  GstElement *element;
+  guint32 id;
+} CommFdBufferRelease;
+
+/* The receiver only maps memory that can't be truncated under its feet */
+static gboolean
+fd_is_sealed (gint fd)
+{
+#ifdef F_GET_SEALS
+  gint seals = fcntl (fd, F_GET_SEALS);
+
+  return seals >= 0 && (seals & F_SEAL_SHRINK);
+#else
+  return FALSE;
+#endif
+}
+
+/* Returns the memory of @buffer if it can be passed as a file descriptor */
+static GstMemory *
+get_fd_memory (GstBuffer * buffer)
+{
+  GstMemory *mem;
+
+  if (gst_buffer_n_memory (buffer) != 1)
+    return NULL;
+
+  mem = gst_buffer_peek_memory (buffer, 0);
+  if (!gst_is_fd_memory (mem))
+    return NULL;
+
+  if (!fd_is_sealed (gst_fd_memory_get_fd (mem)))
+    return NULL;
+
+  return mem;
+}
+
 GstFlowReturn
 gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
     GstBuffer * buffer)
@@ -512,6 +642,7 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
   guint32 ret32 = GST_FLOW_OK;
   guint32 size, n;
   CommBufferMetadata meta;
+  GstMemory *fd_mem;
   GstFlowReturn ret;
   MetaListRepresentation repr = { comm, 0, 4, NULL };   /* starts a 4 for n_meta */
   GstByteWriter bw;
@@ -534,29 +665,74 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
   /* work out meta size */
   gst_buffer_foreach_meta (buffer, build_meta, &repr);
 
-  if (!gst_byte_writer_put_uint8 (&bw, payload_type))
-    goto write_failed;
-  if (!gst_byte_writer_put_uint32_le (&bw, comm->send_id))
-    goto write_failed;
-  size =
-      gst_buffer_get_size (buffer) + sizeof (guint32) +
-      sizeof (CommBufferMetadata) + repr.total_bytes;
-  if (!gst_byte_writer_put_uint32_le (&bw, size))
-    goto write_failed;
-  if (!gst_byte_writer_put_data (&bw, (const guint8 *) &meta, sizeof (meta)))
-    goto write_failed;
-  size = gst_buffer_get_size (buffer);
-  if (!gst_byte_writer_put_uint32_le (&bw, size))
-    goto write_failed;
-  if (!write_byte_writer_to_fd (comm, &bw))
-    goto write_failed;
+  fd_mem = comm->pass_fds && comm->fdout_is_socket ?
+      get_fd_memory (buffer) : NULL;
+  if (fd_mem) {
+    CommFdMemoryInfo fd_info;
+    gint res;
 
-  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
-    goto map_failed;
-  ret = write_to_fd_raw (comm, map.data, map.size);
-  gst_buffer_unmap (buffer, &map);
-  if (!ret)
-    goto write_failed;
+    fd_info.maxsize = fd_mem->maxsize;
+    fd_info.offset = fd_mem->offset;
+    fd_info.size = fd_mem->size;
+
+    if (!gst_byte_writer_put_uint8 (&bw,
+            GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint32_le (&bw, comm->send_id))
+      goto write_failed;
+    size = sizeof (CommBufferMetadata) + sizeof (CommFdMemoryInfo) +
+        repr.total_bytes;
+    if (!gst_byte_writer_put_uint32_le (&bw, size))
+      goto write_failed;
+    if (!gst_byte_writer_put_data (&bw, (const guint8 *) &meta, sizeof (meta)))
+      goto write_failed;
+    if (!gst_byte_writer_put_data (&bw, (const guint8 *) &fd_info,
+            sizeof (fd_info)))
+      goto write_failed;
+
+    res = write_byte_writer_with_fd_to_fd (comm, &bw,
+        gst_fd_memory_get_fd (fd_mem));
+    if (res < 0)
+      goto write_failed;
+
+    if (res == 0) {
+      /* the peer now maps our memory, keep it until it tells us it's done */
+      g_hash_table_insert (comm->sent_buffers,
+          GINT_TO_POINTER (comm->send_id), gst_buffer_ref (buffer));
+    } else {
+      GST_WARNING_OBJECT (comm->element, "fdout can not carry file "
+          "descriptors, copying buffers");
+      comm->fdout_is_socket = FALSE;
+      fd_mem = NULL;
+      gst_byte_writer_init (&bw);
+    }
+  }
+
+  if (!fd_mem) {
+    if (!gst_byte_writer_put_uint8 (&bw, payload_type))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint32_le (&bw, comm->send_id))
+      goto write_failed;
+    size =
+        gst_buffer_get_size (buffer) + sizeof (guint32) +
+        sizeof (CommBufferMetadata) + repr.total_bytes;
+    if (!gst_byte_writer_put_uint32_le (&bw, size))
+      goto write_failed;
+    if (!gst_byte_writer_put_data (&bw, (const guint8 *) &meta, sizeof (meta)))
+      goto write_failed;
+    size = gst_buffer_get_size (buffer);
+    if (!gst_byte_writer_put_uint32_le (&bw, size))
+      goto write_failed;
+    if (!write_byte_writer_to_fd (comm, &bw))
+      goto write_failed;
+
+    if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+      goto map_failed;
+    ret = write_to_fd_raw (comm, map.data, map.size);
+    gst_buffer_unmap (buffer, &map);
+    if (!ret)
+      goto write_failed;
+  }
 
   /* meta */
   gst_byte_writer_init (&bw);
@@ -611,6 +787,7 @@ done:
 write_failed:
   GST_ELEMENT_ERROR (comm->element, RESOURCE, WRITE, (NULL),
       ("Failed to write to socket"));
+  g_hash_table_remove (comm->sent_buffers, GINT_TO_POINTER (comm->send_id));
   ret = GST_FLOW_COMM_ERROR;
   goto done;
 
@@ -627,8 +804,120 @@ map_failed:
   goto done;
 }
 
+static void
+gst_ipc_pipeline_comm_write_buffer_release_to_fd (GstIpcPipelineComm * comm,
+    guint32 id)
+{
+  const unsigned char payload_type =
+      GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_RELEASE;
+  GstByteWriter bw;
+
+  g_mutex_lock (&comm->mutex);
+
+  if (comm->fdout < 0) {
+    GST_DEBUG_OBJECT (comm->element, "Not connected, dropping release for "
+        "buffer %u", id);
+    g_mutex_unlock (&comm->mutex);
+    return;
+  }
+
+  GST_TRACE_OBJECT (comm->element, "Writing release for buffer %u", id);
+  gst_byte_writer_init (&bw);
+  if (!gst_byte_writer_put_uint8 (&bw, payload_type))
+    goto write_failed;
+  if (!gst_byte_writer_put_uint32_le (&bw, id))
+    goto write_failed;
+  if (!gst_byte_writer_put_uint32_le (&bw, 0))
+    goto write_failed;
+
+  if (!write_byte_writer_to_fd (comm, &bw))
+    goto write_failed;
+
+done:
+  g_mutex_unlock (&comm->mutex);
+  gst_byte_writer_reset (&bw);
+  return;
+
+write_failed:
+  /* the peer may well be gone already, so this is not an error */
+  GST_WARNING_OBJECT (comm->element, "Failed to write release for buffer %u",
+      id);
+  goto done;
+}
+
+static void
+comm_fd_buffer_release_free (CommFdBufferRelease * release)
+{
+  gst_ipc_pipeline_comm_write_buffer_release_to_fd (release->comm,
+      release->id);
+  gst_object_unref (release->element);
+  g_free (release);
+}
+
+/* Wraps the next received file descriptor in a GstFdMemory. The sender
+ * is told to release its buffer once that memory is freed */
+static GstMemory *
+gst_ipc_pipeline_comm_wrap_fd (GstIpcPipelineComm * comm,
+    const CommFdMemoryInfo * info)
+{
+#ifdef G_OS_UNIX
+  CommFdBufferRelease *release;
+  GstMemory *mem;
+  struct stat st;
+  gint fd;
+
+  if (g_queue_is_empty (&comm->fds)) {
+    GST_ERROR_OBJECT (comm->element, "No file descriptor received for "
+        "buffer %u", comm->id);
+    goto error;
+  }
+  fd = GPOINTER_TO_INT (g_queue_pop_head (&comm->fds));
+
+  /* Touching the mapping past the end of the file would crash us, so
+   * don't let the peer get us there */
+  if (info->offset + info->size > info->maxsize || fstat (fd, &st) < 0 ||
+      (guint64) st.st_size < info->maxsize) {
+    GST_ERROR_OBJECT (comm->element, "Invalid memory layout for buffer %u",
+        comm->id);
+    goto close_fd;
+  }
+  if (!fd_is_sealed (fd)) {
+    GST_ERROR_OBJECT (comm->element, "Memory of buffer %u is not sealed "
+        "against shrinking", comm->id);
+    goto close_fd;
+  }
+
+  mem = gst_fd_allocator_alloc (comm->fd_allocator, fd, info->maxsize,
+      GST_FD_MEMORY_FLAG_NONE);
+  if (!mem)
+    goto close_fd;
+  gst_memory_resize (mem, info->offset, info->size);
+
+  release = g_new (CommFdBufferRelease, 1);
+  release->comm = comm;
+  release->element = gst_object_ref (comm->element);
+  release->id = comm->id;
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (mem), QUARK_FD_RELEASE,
+      release, (GDestroyNotify) comm_fd_buffer_release_free);
+
+  return mem;
+
+close_fd:
+  close (fd);
+error:
+  /* let the peer reclaim its buffer */
+  gst_ipc_pipeline_comm_write_buffer_release_to_fd (comm, comm->id);
+  return NULL;
+#else
+  GST_ERROR_OBJECT (comm->element, "Passing file descriptors is not "
+      "supported on this platform");
+  return NULL;
+#endif
+}
+
 static GstBuffer *
-gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
+gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size,
+    gboolean with_fd)
 {
   GstBuffer *buffer;
   CommBufferMetadata meta;
@@ -640,24 +929,47 @@ gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
   g_return_val_if_fail (gst_adapter_available (comm->adapter) >= size, NULL);
   g_return_val_if_fail (size >= sizeof (CommBufferMetadata), NULL);
 
-  mapped_size = sizeof (CommBufferMetadata) + sizeof (buffer_data_size);
-  payload = gst_adapter_map (comm->adapter, mapped_size);
-  if (!payload)
-    return NULL;
-  memcpy (&meta, payload, sizeof (CommBufferMetadata));
-  payload += sizeof (CommBufferMetadata);
-  memcpy (&buffer_data_size, payload, sizeof (buffer_data_size));
-  size -= mapped_size;
-  gst_adapter_unmap (comm->adapter);
-  gst_adapter_flush (comm->adapter, mapped_size);
-
-  if (buffer_data_size == 0) {
+  if (with_fd) {
+    CommFdMemoryInfo fd_info;
+    GstMemory *mem;
+
+    mapped_size = sizeof (CommBufferMetadata) + sizeof (CommFdMemoryInfo);
+    g_return_val_if_fail (size >= mapped_size, NULL);
+    payload = gst_adapter_map (comm->adapter, mapped_size);
+    if (!payload)
+      return NULL;
+    memcpy (&meta, payload, sizeof (CommBufferMetadata));
+    payload += sizeof (CommBufferMetadata);
+    memcpy (&fd_info, payload, sizeof (CommFdMemoryInfo));
+    size -= mapped_size;
+    gst_adapter_unmap (comm->adapter);
+    gst_adapter_flush (comm->adapter, mapped_size);
+
+    mem = gst_ipc_pipeline_comm_wrap_fd (comm, &fd_info);
+    if (!mem)
+      return NULL;
     buffer = gst_buffer_new ();
+    gst_buffer_append_memory (buffer, mem);
   } else {
-    buffer = gst_adapter_get_buffer (comm->adapter, buffer_data_size);
-    gst_adapter_flush (comm->adapter, buffer_data_size);
+    mapped_size = sizeof (CommBufferMetadata) + sizeof (buffer_data_size);
+    payload = gst_adapter_map (comm->adapter, mapped_size);
+    if (!payload)
+      return NULL;
+    memcpy (&meta, payload, sizeof (CommBufferMetadata));
+    payload += sizeof (CommBufferMetadata);
+    memcpy (&buffer_data_size, payload, sizeof (buffer_data_size));
+    size -= mapped_size;
+    gst_adapter_unmap (comm->adapter);
+    gst_adapter_flush (comm->adapter, mapped_size);
+
+    if (buffer_data_size == 0) {
+      buffer = gst_buffer_new ();
+    } else {
+      buffer = gst_adapter_get_buffer (comm->adapter, buffer_data_size);
+      gst_adapter_flush (comm->adapter, buffer_data_size);
+    }
+    size -= buffer_data_size;
   }
-  size -= buffer_data_size;
 
   GST_BUFFER_PTS (buffer) = meta.pts;
   GST_BUFFER_DTS (buffer) = meta.dts;
@@ -1614,11 +1926,31 @@ gst_ipc_pipeline_comm_init (GstIpcPipelineComm * comm, GstElement * element)
   comm->adapter = gst_adapter_new ();
   comm->poll = gst_poll_new (TRUE);
   gst_poll_fd_init (&comm->pollFDin);
+  comm->pass_fds = FALSE;
+  comm->fdout_is_socket = TRUE;
+  comm->sent_buffers =
+      g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+      (GDestroyNotify) gst_buffer_unref);
+  g_queue_init (&comm->fds);
+  comm->fdin_is_socket = TRUE;
+  comm->fd_allocator = gst_fd_allocator_new ();
+}
+
+static void
+gst_ipc_pipeline_comm_close_received_fds (GstIpcPipelineComm * comm)
+{
+#ifdef G_OS_UNIX
+  while (!g_queue_is_empty (&comm->fds))
+    close (GPOINTER_TO_INT (g_queue_pop_head (&comm->fds)));
+#endif
 }
 
 void
 gst_ipc_pipeline_comm_clear (GstIpcPipelineComm * comm)
 {
+  g_hash_table_destroy (comm->sent_buffers);
+  gst_ipc_pipeline_comm_close_received_fds (comm);
+  gst_object_unref (comm->fd_allocator);
   g_hash_table_destroy (comm->waiting_ids);
   gst_object_unref (comm->adapter);
   gst_poll_free (comm->poll);
@@ -1654,6 +1986,8 @@ gst_ipc_pipeline_comm_cancel (GstIpcPipelineComm * comm, gboolean cleanup)
 {
   g_mutex_lock (&comm->mutex);
   g_hash_table_foreach (comm->waiting_ids, cancel_request_error, comm);
+  /* the peer won't be releasing those anymore */
+  g_hash_table_remove_all (comm->sent_buffers);
   if (cleanup) {
     g_hash_table_unref (comm->waiting_ids);
     comm->waiting_ids =
@@ -1706,6 +2040,71 @@ gst_ipc_pipeline_comm_reply_request (GstIpcPipelineComm * comm, guint32 id,
   return TRUE;
 }
 
+static ssize_t
+read_from_fd (GstIpcPipelineComm * comm, gint fd, guint8 * data, gsize size)
+{
+#ifdef G_OS_UNIX
+  if (comm->fdin_is_socket) {
+    struct msghdr msg = { 0, };
+    struct iovec iov;
+    union
+    {
+      struct cmsghdr hdr;
+      char buf[CMSG_SPACE (sizeof (int) * MAX_RECEIVED_FDS)];
+    } cmsgbuf;
+    struct cmsghdr *cmsg;
+    gint flags = 0;
+    ssize_t sz;
+
+    iov.iov_base = data;
+    iov.iov_len = size;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cmsgbuf.buf;
+    msg.msg_controllen = sizeof (cmsgbuf.buf);
+#ifdef MSG_CMSG_CLOEXEC
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+    sz = recvmsg (fd, &msg, flags);
+    if (sz < 0 && errno == ENOTSOCK) {
+      GST_DEBUG_OBJECT (comm->element, "fd %d is not a socket", fd);
+      comm->fdin_is_socket = FALSE;
+      return read (fd, data, size);
+    }
+
+    if (sz > 0) {
+      for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+        const gint *fds;
+        guint n_fds, i;
+
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+          continue;
+
+        fds = (const gint *) CMSG_DATA (cmsg);
+        n_fds = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (gint);
+        for (i = 0; i < n_fds; i++) {
+          GST_TRACE_OBJECT (comm->element, "Received fd %d", fds[i]);
+          g_queue_push_tail (&comm->fds, GINT_TO_POINTER (fds[i]));
+        }
+      }
+      /* the fds left in the queue would be matched with the wrong buffers,
+       * the stream can't be trusted anymore */
+      if (msg.msg_flags & MSG_CTRUNC) {
+        GST_ERROR_OBJECT (comm->element, "Some file descriptors were lost");
+        gst_ipc_pipeline_comm_close_received_fds (comm);
+        errno = EBADMSG;
+        return -1;
+      }
+    }
+
+    return sz;
+  }
+#endif
+
+  return read (fd, data, size);
+}
+
 static gint
 update_adapter (GstIpcPipelineComm * comm)
 {
@@ -1727,6 +2126,8 @@ again:
           comm->pollFDin.fd);
       gst_poll_remove_fd (comm->poll, &comm->pollFDin);
       gst_poll_fd_init (&comm->pollFDin);
+      gst_ipc_pipeline_comm_close_received_fds (comm);
+      comm->fdin_is_socket = TRUE;
     }
     if (comm->fdin != -1 && GST_OBJECT_PARENT (comm->element)) {
       GST_DEBUG_OBJECT (comm->element, "Start watching fd %d", comm->fdin);
@@ -1752,7 +2153,7 @@ again:
       mem = gst_allocator_alloc (NULL, comm->read_chunk_size, NULL);
 
     gst_memory_map (mem, &map, GST_MAP_WRITE);
-    sz = read (comm->pollFDin.fd, map.data, map.size);
+    sz = read_from_fd (comm, comm->pollFDin.fd, map.data, map.size);
     gst_memory_unmap (mem, &map);
 
     if (sz <= 0) {
@@ -1817,6 +2218,8 @@ read_many (GstIpcPipelineComm * comm)
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE:
+          case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER:
+          case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_RELEASE:
             GST_TRACE_OBJECT (comm->element, "switching to state %s",
                 gst_ipc_pipeline_comm_data_type_get_name (type));
             comm->state = type;
@@ -1881,6 +2284,7 @@ read_many (GstIpcPipelineComm * comm)
         break;
       }
       case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER:
+      case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER:
       {
         GstBuffer *buf;
 
@@ -1888,7 +2292,8 @@ read_many (GstIpcPipelineComm * comm)
         if (available < comm->payload_length)
           goto done;
 
-        buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length);
+        buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length,
+            comm->state == GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER);
         if (!buf)
           goto buffer_failed;
 
@@ -1912,6 +2317,35 @@ read_many (GstIpcPipelineComm * comm)
         comm->state = GST_IPC_PIPELINE_COMM_STATE_TYPE;
         break;
       }
+      case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_RELEASE:
+      {
+        GstBuffer *buf;
+
+        available = gst_adapter_available (comm->adapter);
+        if (available < comm->payload_length)
+          goto done;
+        gst_adapter_flush (comm->adapter, comm->payload_length);
+
+        g_mutex_lock (&comm->mutex);
+        buf = g_hash_table_lookup (comm->sent_buffers,
+            GINT_TO_POINTER (comm->id));
+        if (buf)
+          g_hash_table_steal (comm->sent_buffers, GINT_TO_POINTER (comm->id));
+        g_mutex_unlock (&comm->mutex);
+
+        if (buf) {
+          GST_TRACE_OBJECT (comm->element, "Peer released buffer %u: %"
+              GST_PTR_FORMAT, comm->id, buf);
+          gst_buffer_unref (buf);
+        } else {
+          GST_WARNING_OBJECT (comm->element, "Got release for unknown "
+              "buffer %u", comm->id);
+        }
+
+        GST_TRACE_OBJECT (comm->element, "switching to state TYPE");
+        comm->state = GST_IPC_PIPELINE_COMM_STATE_TYPE;
+        break;
+      }
       case GST_IPC_PIPELINE_COMM_DATA_TYPE_EVENT:
       {
         GstEvent *event;
@@ -2324,6 +2758,7 @@ gst_ipc_pipeline_comm_plugin_init (void)
     GST_DEBUG_CATEGORY_INIT (gst_ipc_pipeline_comm_debug, "ipcpipelinecomm", 0,
         "ipc pipeline comm");
     QUARK_ID = g_quark_from_static_string ("ipcpipeline-id");
+    QUARK_FD_RELEASE = g_quark_from_static_string ("ipcpipeline-fd-release");
     REGISTER_SERIALIZATION_NO_COMPARE (gst_event_get_type (), event);
     g_once_init_leave (&once, (gsize) 1);
   }
@@ -51,6 +51,8 @@ typedef enum {
   GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE,
+  GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER,
+  GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_RELEASE,
 } GstIpcPipelineCommDataType;
 
 typedef struct
@@ -76,6 +78,17 @@ typedef struct
   guint read_chunk_size;
   GstClockTime ack_time;
 
+  /* zero-copy: buffers backed by a file descriptor are passed as such
+   * over fdout, and kept alive until the peer releases them */
+  gboolean pass_fds;
+  /* cleared once fdout was found not to carry file descriptors */
+  gboolean fdout_is_socket;
+  GHashTable *sent_buffers;
+  /* file descriptors received on fdin, not yet consumed */
+  GQueue fds;
+  gboolean fdin_is_socket;
+  GstAllocator *fd_allocator;
+
   void (*on_buffer) (guint32, GstBuffer *, gpointer);
   void (*on_event) (guint32, GstEvent *, gboolean, gpointer);
   void (*on_query) (guint32, GstQuery *, gboolean, gpointer);
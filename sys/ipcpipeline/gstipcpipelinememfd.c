@@ -0,0 +1,276 @@
+/* GStreamer
+ * Copyright (C) 2015-2017 YouView TV Ltd
+ *
+ * gstipcpipelinememfd.c:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Allocator proposed upstream by ipcpipelinesink when zero-copy is enabled.
+ * Memory is backed by a memfd, so that its file descriptor can be passed to
+ * the ipcpipelinesrc process instead of the buffer contents.
+ *
+ * The memfd is sealed against shrinking and growing once sized, so the
+ * receiving process can safely mmap it without the sender being able to
+ * truncate it under its feet. ipcpipelinesrc refuses unsealed memory, so
+ * there is no fallback on temporary files, which can't be sealed.
+ *
+ * Since creating, sizing and mapping a memfd for every buffer is costly,
+ * released memories are kept in a small pool and handed out again for
+ * allocations that fit in them. The fd is still passed along with every
+ * buffer, the receiver closes its copy once done with the buffer.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+/* for memfd_create() and the sealing fcntl() commands */
+#define _GNU_SOURCE
+
+#ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#ifdef HAVE_MEMFD_CREATE
+#  include <sys/mman.h>
+#endif
+
+#include "gstipcpipelinememfd.h"
+
+#if defined (HAVE_MEMFD_CREATE) && defined (F_ADD_SEALS)
+#define HAVE_SEALED_MEMFD
+#endif
+
+/* Released memories kept for reuse */
+#define MAX_FREE_MEMORIES 16
+
+GST_DEBUG_CATEGORY_STATIC (gst_ipc_pipeline_memfd_debug);
+#define GST_CAT_DEFAULT gst_ipc_pipeline_memfd_debug
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_ipc_pipeline_memfd_debug, "ipcpipelinememfd", 0, "ipcpipeline memfd allocator");
+G_DEFINE_TYPE_WITH_CODE (GstIpcPipelineMemfdAllocator,
+    gst_ipc_pipeline_memfd_allocator, GST_TYPE_FD_ALLOCATOR, _do_init);
+
+static gint
+gst_ipc_pipeline_memfd_allocator_create_fd (GstIpcPipelineMemfdAllocator *
+    self, gsize size)
+{
+#ifdef HAVE_SEALED_MEMFD
+  gint fd;
+
+  fd = memfd_create ("gst-ipcpipeline", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    GST_ERROR_OBJECT (self, "memfd_create failed: %s", strerror (errno));
+    return -1;
+  }
+
+  if (ftruncate (fd, size) < 0) {
+    GST_ERROR_OBJECT (self, "ftruncate failed: %s", strerror (errno));
+    close (fd);
+    return -1;
+  }
+
+  if (fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+    GST_ERROR_OBJECT (self, "Could not seal fd %d: %s", fd, strerror (errno));
+    close (fd);
+    return -1;
+  }
+
+  return fd;
+#else
+  GST_ERROR_OBJECT (self, "Sealed memfds are not supported");
+  return -1;
+#endif
+}
+
+/* Takes the memory back into the pool instead of freeing it, unless the
+ * allocator was flushed */
+static gboolean
+gst_ipc_pipeline_memfd_memory_dispose (GstMemory * mem)
+{
+  GstIpcPipelineMemfdAllocator *self =
+      GST_IPC_PIPELINE_MEMFD_ALLOCATOR (mem->allocator);
+  GstMemory *evicted = NULL;
+
+  g_mutex_lock (&self->lock);
+  if (self->flushing) {
+    g_mutex_unlock (&self->lock);
+    return TRUE;
+  }
+
+  gst_memory_ref (mem);
+  g_queue_push_tail (&self->free_memories, mem);
+  if (self->free_memories.length > MAX_FREE_MEMORIES)
+    evicted = g_queue_pop_head (&self->free_memories);
+  g_mutex_unlock (&self->lock);
+
+  if (evicted) {
+    GST_MINI_OBJECT_CAST (evicted)->dispose = NULL;
+    gst_memory_unref (evicted);
+  }
+
+  return FALSE;
+}
+
+/* Returns a released memory of at least @maxsize bytes, or %NULL */
+static GstMemory *
+gst_ipc_pipeline_memfd_allocator_acquire (GstIpcPipelineMemfdAllocator *
+    self, gsize maxsize)
+{
+  GstMemory *mem = NULL;
+  GList *l;
+
+  g_mutex_lock (&self->lock);
+  for (l = self->free_memories.head; l; l = l->next) {
+    GstMemory *tmp = l->data;
+
+    if (tmp->maxsize >= maxsize) {
+      mem = tmp;
+      g_queue_delete_link (&self->free_memories, l);
+      break;
+    }
+  }
+  g_mutex_unlock (&self->lock);
+
+  return mem;
+}
+
+static GstMemory *
+gst_ipc_pipeline_memfd_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  GstIpcPipelineMemfdAllocator *self =
+      GST_IPC_PIPELINE_MEMFD_ALLOCATOR (allocator);
+  GstMemory *mem;
+  gsize maxsize;
+  gint fd;
+
+  maxsize = size + params->prefix + params->padding;
+
+  mem = gst_ipc_pipeline_memfd_allocator_acquire (self, maxsize);
+  if (mem) {
+    GST_LOG_OBJECT (self, "Reusing %" G_GSIZE_FORMAT " bytes on fd %d",
+        mem->maxsize, gst_fd_memory_get_fd (mem));
+
+    /* back to what a fresh memory looks like */
+    mem->offset = 0;
+    mem->size = mem->maxsize;
+    GST_MINI_OBJECT_FLAGS (mem) = 0;
+  } else {
+    fd = gst_ipc_pipeline_memfd_allocator_create_fd (self, maxsize);
+    if (fd < 0)
+      return NULL;
+
+    mem = gst_fd_allocator_alloc (allocator, fd, maxsize,
+        GST_FD_MEMORY_FLAG_KEEP_MAPPED);
+    if (G_UNLIKELY (!mem)) {
+      GST_ERROR_OBJECT (self, "GstFdMemory allocation failed");
+      close (fd);
+      return NULL;
+    }
+
+    GST_MINI_OBJECT_CAST (mem)->dispose =
+        (GstMiniObjectDisposeFunction) gst_ipc_pipeline_memfd_memory_dispose;
+
+    GST_LOG_OBJECT (self, "Allocated %" G_GSIZE_FORMAT " bytes on fd %d",
+        maxsize, fd);
+  }
+
+  gst_memory_resize (mem, params->prefix, size);
+  GST_MINI_OBJECT_FLAG_SET (mem, params->flags);
+
+  return mem;
+}
+
+static void
+gst_ipc_pipeline_memfd_allocator_finalize (GObject * object)
+{
+  GstIpcPipelineMemfdAllocator *self =
+      GST_IPC_PIPELINE_MEMFD_ALLOCATOR (object);
+
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (gst_ipc_pipeline_memfd_allocator_parent_class)->finalize
+      (object);
+}
+
+static void
+gst_ipc_pipeline_memfd_allocator_class_init (GstIpcPipelineMemfdAllocatorClass
+    * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstAllocatorClass *alloc_class = (GstAllocatorClass *) klass;
+
+  gobject_class->finalize = gst_ipc_pipeline_memfd_allocator_finalize;
+
+  alloc_class->alloc =
+      GST_DEBUG_FUNCPTR (gst_ipc_pipeline_memfd_allocator_alloc);
+}
+
+static void
+gst_ipc_pipeline_memfd_allocator_init (GstIpcPipelineMemfdAllocator * self)
+{
+  GST_OBJECT_FLAG_UNSET (self, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC);
+
+  g_mutex_init (&self->lock);
+  g_queue_init (&self->free_memories);
+}
+
+/* Returns %NULL if sealed memfds can't be created on this system */
+GstAllocator *
+gst_ipc_pipeline_memfd_allocator_new (void)
+{
+  GstAllocator *alloc;
+  gint fd;
+
+  alloc = g_object_new (GST_TYPE_IPC_PIPELINE_MEMFD_ALLOCATOR, NULL);
+  gst_object_ref_sink (alloc);
+
+  fd = gst_ipc_pipeline_memfd_allocator_create_fd
+      (GST_IPC_PIPELINE_MEMFD_ALLOCATOR (alloc), 1);
+  if (fd < 0) {
+    gst_object_unref (alloc);
+    return NULL;
+  }
+  close (fd);
+
+  return alloc;
+}
+
+/* Frees the released memories and stops taking them back. The pool holds
+ * references to the allocator, so this must be called before dropping it */
+void
+gst_ipc_pipeline_memfd_allocator_flush (GstAllocator * allocator)
+{
+  GstIpcPipelineMemfdAllocator *self =
+      GST_IPC_PIPELINE_MEMFD_ALLOCATOR (allocator);
+  GstMemory *mem;
+  GQueue free_memories;
+
+  g_mutex_lock (&self->lock);
+  self->flushing = TRUE;
+  free_memories = self->free_memories;
+  g_queue_init (&self->free_memories);
+  g_mutex_unlock (&self->lock);
+
+  while ((mem = g_queue_pop_head (&free_memories)))
+    gst_memory_unref (mem);
+}
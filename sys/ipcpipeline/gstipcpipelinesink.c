@@ -66,7 +66,11 @@
  * GError are serialized differently).
  *
  * Buffers are transported by writing their content directly on the socket.
- * More efficient ways for memory sharing could be implemented in the future.
+ * When the #GstIpcPipelineSink:zero-copy property is enabled, memfd backed
+ * memory is proposed upstream instead, and buffers made of a single file
+ * descriptor backed memory are passed to the other process as a file
+ * descriptor, so that only their metadata goes through the socket. This
+ * requires the sockets to be UNIX domain sockets.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -74,6 +78,9 @@
 #endif
 
 #include "gstipcpipelinesink.h"
+#ifdef G_OS_UNIX
+#include "gstipcpipelinememfd.h"
+#endif
 
 static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -98,11 +105,13 @@ enum
   PROP_FDOUT,
   PROP_READ_CHUNK_SIZE,
   PROP_ACK_TIME,
+  PROP_ZERO_COPY,
 };
 
 
 #define DEFAULT_READ_CHUNK_SIZE 4096
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
+#define DEFAULT_ZERO_COPY FALSE
 
 #define _do_init \
     GST_DEBUG_CATEGORY_INIT (gst_ipc_pipeline_sink_debug, "ipcpipelinesink", 0, "ipcpipelinesink element");
@@ -175,6 +184,21 @@ gst_ipc_pipeline_sink_class_init (GstIpcPipelineSinkClass * klass)
           0, G_MAXUINT64, DEFAULT_ACK_TIME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstIpcPipelineSink:zero-copy:
+   *
+   * Propose memfd backed memory upstream and pass file descriptor backed
+   * buffers to ipcpipelinesrc as file descriptors instead of copying their
+   * contents through the socket. fdout must be a UNIX domain socket,
+   * buffers are copied otherwise.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_ZERO_COPY,
+      g_param_spec_boolean ("zero-copy", "Zero copy",
+          "Pass buffer memory as file descriptors instead of copying it",
+          DEFAULT_ZERO_COPY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_ipc_pipeline_sink_signals[SIGNAL_DISCONNECT] =
       g_signal_new ("disconnect",
       G_TYPE_FROM_CLASS (klass),
@@ -212,6 +236,7 @@ gst_ipc_pipeline_sink_init (GstIpcPipelineSink * sink)
   sink->comm.ack_time = DEFAULT_ACK_TIME;
   sink->comm.fdin = -1;
   sink->comm.fdout = -1;
+  sink->comm.pass_fds = DEFAULT_ZERO_COPY;
   sink->threads = g_thread_pool_new (pusher, sink, -1, FALSE, NULL);
   gst_ipc_pipeline_sink_start_reader_thread (sink);
 
@@ -248,6 +273,12 @@ gst_ipc_pipeline_sink_finalize (GObject * obj)
 
   gst_ipc_pipeline_comm_clear (&sink->comm);
   g_thread_pool_free (sink->threads, TRUE, TRUE);
+#ifdef G_OS_UNIX
+  if (sink->allocator) {
+    gst_ipc_pipeline_memfd_allocator_flush (sink->allocator);
+    gst_object_unref (sink->allocator);
+  }
+#endif
 
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -264,6 +295,7 @@ gst_ipc_pipeline_sink_set_property (GObject * object, guint prop_id,
       break;
     case PROP_FDOUT:
       sink->comm.fdout = g_value_get_int (value);
+      sink->comm.fdout_is_socket = TRUE;
       break;
     case PROP_READ_CHUNK_SIZE:
       sink->comm.read_chunk_size = g_value_get_uint (value);
@@ -271,6 +303,9 @@ gst_ipc_pipeline_sink_set_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       sink->comm.ack_time = g_value_get_uint64 (value);
       break;
+    case PROP_ZERO_COPY:
+      sink->comm.pass_fds = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -296,6 +331,9 @@ gst_ipc_pipeline_sink_get_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       g_value_set_uint64 (value, sink->comm.ack_time);
       break;
+    case PROP_ZERO_COPY:
+      g_value_set_boolean (value, sink->comm.pass_fds);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -344,6 +382,25 @@ gst_ipc_pipeline_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
 
   switch (GST_QUERY_TYPE (query)) {
     case GST_QUERY_ALLOCATION:
+      /* Upstream will allocate from this one when creating its pool, the
+       * other side can then map the memory instead of receiving a copy */
+#ifdef G_OS_UNIX
+      if (sink->comm.pass_fds && sink->comm.fdout_is_socket) {
+        GstAllocator *allocator;
+
+        GST_OBJECT_LOCK (sink);
+        if (!sink->allocator)
+          sink->allocator = gst_ipc_pipeline_memfd_allocator_new ();
+        allocator = sink->allocator;
+        GST_OBJECT_UNLOCK (sink);
+
+        if (allocator) {
+          GST_DEBUG_OBJECT (sink, "Proposing memfd allocator");
+          gst_query_add_allocation_param (query, allocator, NULL);
+          return TRUE;
+        }
+      }
+#endif
       GST_DEBUG_OBJECT (sink, "Rejecting ALLOCATION query");
       return FALSE;
     case GST_QUERY_CAPS:
@@ -52,6 +52,10 @@ struct _GstIpcPipelineSink {
   GThreadPool *threads;
   gboolean pass_next_async_done;
   GstPad *sinkpad;
+
+  /* memfd allocator proposed upstream in zero-copy mode, created on the
+   * first allocation query */
+  GstAllocator *allocator;
 };
 
 struct _GstIpcPipelineSinkClass {
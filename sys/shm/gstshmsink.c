@@ -39,6 +39,7 @@
 #include "gstshmsink.h"
 
 #include <gst/gst.h>
+#include <gst/video/video.h>
 
 #include <string.h>
 
@@ -58,7 +59,8 @@ enum
   PROP_PERMS,
   PROP_SHM_SIZE,
   PROP_WAIT_FOR_CONNECTION,
-  PROP_BUFFER_TIME
+  PROP_BUFFER_TIME,
+  PROP_STATS
 };
 
 struct GstShmClient
@@ -417,6 +419,31 @@ gst_shm_sink_class_init (GstShmSinkClass * klass)
           -1, G_MAXINT64, -1,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstShmSink:stats:
+   *
+   * Statistics about the usage of the shared memory area, in a #GstStructure
+   * named "application/x-shm-sink-stats" with the following fields:
+   *
+   * - "size": #G_TYPE_UINT64, size of the shared memory area
+   * - "used": #G_TYPE_UINT64, bytes currently allocated
+   * - "used-blocks": #G_TYPE_UINT64, number of allocated blocks
+   * - "free-blocks": #G_TYPE_UINT64, number of free blocks
+   * - "largest-free": #G_TYPE_UINT64, size of the largest free block
+   * - "fragmentation": #G_TYPE_DOUBLE, fraction of the free space that is
+   *   not in the largest free block
+   * - "alloc-failures": #G_TYPE_UINT64, number of times there was no free
+   *   block big enough
+   * - "copied": #G_TYPE_UINT64, number of buffers that had to be copied
+   *   into the shared memory area
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Statistics about the usage of the shared memory area",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   signals[SIGNAL_CLIENT_CONNECTED] = g_signal_new ("client-connected",
       GST_TYPE_SHM_SINK, G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL,
       G_TYPE_NONE, 1, G_TYPE_INT);
@@ -510,6 +537,32 @@ gst_shm_sink_set_property (GObject * object, guint prop_id,
   }
 }
 
+/* Must be called with the object lock */
+static GstStructure *
+gst_shm_sink_get_stats (GstShmSink * self)
+{
+  ShmAllocStats stats = { 0, };
+  gdouble fragmentation = 0.0;
+  gulong free_size;
+
+  if (self->pipe)
+    sp_writer_get_alloc_stats (self->pipe, &stats);
+
+  free_size = stats.size - stats.used;
+  if (free_size > 0)
+    fragmentation = 1.0 - (gdouble) stats.largest_free / free_size;
+
+  return gst_structure_new ("application/x-shm-sink-stats",
+      "size", G_TYPE_UINT64, (guint64) stats.size,
+      "used", G_TYPE_UINT64, (guint64) stats.used,
+      "used-blocks", G_TYPE_UINT64, (guint64) stats.used_blocks,
+      "free-blocks", G_TYPE_UINT64, (guint64) stats.free_blocks,
+      "largest-free", G_TYPE_UINT64, (guint64) stats.largest_free,
+      "fragmentation", G_TYPE_DOUBLE, fragmentation,
+      "alloc-failures", G_TYPE_UINT64, (guint64) stats.alloc_failures,
+      "copied", G_TYPE_UINT64, self->copied, NULL);
+}
+
 static void
 gst_shm_sink_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
@@ -534,6 +587,9 @@ gst_shm_sink_get_property (GObject * object, guint prop_id,
     case PROP_BUFFER_TIME:
       g_value_set_int64 (value, self->buffer_time);
       break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_shm_sink_get_stats (self));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -551,6 +607,7 @@ gst_shm_sink_start (GstBaseSink * bsink)
   GError *err = NULL;
 
   self->stop = FALSE;
+  self->copied = 0;
 
   if (!self->socket_path) {
     GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ_WRITE,
@@ -765,6 +822,7 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
     written_bytes = gst_buffer_extract (buf, 0, map.data, map.size);
     GST_DEBUG_OBJECT (self, "Copied %" G_GSIZE_FORMAT " bytes.", written_bytes);
     gst_memory_unmap (memory, &map);
+    self->copied++;
 
     sendbuf = gst_buffer_new ();
     if (!gst_buffer_copy_into (sendbuf, buf, GST_BUFFER_COPY_METADATA, 0, -1)) {
@@ -1002,10 +1060,56 @@ static gboolean
 gst_shm_sink_propose_allocation (GstBaseSink * sink, GstQuery * query)
 {
   GstShmSink *self = GST_SHM_SINK (sink);
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstCaps *caps;
+  GstVideoInfo info;
+  gboolean need_pool;
+  gsize area_size, block_size;
+  guint max_buffers;
+
+  if (!self->allocator)
+    return TRUE;
 
-  if (self->allocator)
-    gst_query_add_allocation_param (query, GST_ALLOCATOR (self->allocator),
-        NULL);
+  gst_query_add_allocation_param (query, GST_ALLOCATOR (self->allocator),
+      &self->params);
+
+  /* For raw video, also offer a pool of buffers in the shared memory area so
+   * that upstream renders directly into it and we don't have to copy */
+  gst_query_parse_allocation (query, &caps, &need_pool);
+  if (!need_pool || caps == NULL || gst_caps_get_size (caps) == 0 ||
+      !gst_structure_has_name (gst_caps_get_structure (caps, 0),
+          "video/x-raw") || !gst_video_info_from_caps (&info, caps))
+    return TRUE;
+
+  GST_OBJECT_LOCK (self);
+  area_size = sp_writer_get_max_buf_size (self->pipe);
+  GST_OBJECT_UNLOCK (self);
+
+  /* Don't let the pool hold more buffers than fit in the area, including
+   * the alignment added by the allocator */
+  block_size = GST_ROUND_UP_64 (info.size + (self->params.align |
+          gst_memory_alignment));
+  max_buffers = area_size / block_size;
+  if (max_buffers == 0)
+    return TRUE;
+
+  pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, info.size, 0, max_buffers);
+  gst_buffer_pool_config_set_allocator (config,
+      GST_ALLOCATOR (self->allocator), &self->params);
+  if (!gst_buffer_pool_set_config (pool, config)) {
+    GST_WARNING_OBJECT (self, "Failed to configure buffer pool");
+    gst_object_unref (pool);
+    return TRUE;
+  }
+
+  GST_DEBUG_OBJECT (self, "Proposing pool of up to %u buffers of %"
+      G_GSIZE_FORMAT " bytes", max_buffers, info.size);
+
+  gst_query_add_allocation_pool (query, pool, info.size, 0, max_buffers);
+  gst_object_unref (pool);
 
   return TRUE;
 }
@@ -69,6 +69,10 @@ struct _GstShmSink
   GstShmSinkAllocator *allocator;
 
   GstAllocationParams params;
+
+  /* number of buffers copied into the shared memory, protected by the
+   * object lock */
+  guint64 copied;
 };
 
 struct _GstShmSinkClass
@@ -33,20 +33,61 @@
 #include <string.h>
 #include <assert.h>
 
+/*
+ * The space is managed with a two-level segregated fit allocator: free
+ * blocks are kept in lists by size class, the first level being the power
+ * of two of the size and the second level splitting it in
+ * SHM_ALLOC_SL_COUNT linear ranges. Bitmaps of the non-empty lists make
+ * finding a big enough block, splitting it and merging freed blocks with
+ * their neighbours constant time operations, independently of how many
+ * blocks are in use.
+ *
+ * The blocks are described outside of the shared memory, as it is mapped
+ * read-only by the readers. To find the block containing an offset, each
+ * page of the space points to the block containing its first byte.
+ */
+
+#define SHM_ALLOC_ALIGN_LOG 6
+#define SHM_ALLOC_ALIGN (1UL << SHM_ALLOC_ALIGN_LOG)
+
+#define SHM_ALLOC_SL_LOG 4
+#define SHM_ALLOC_SL_COUNT (1 << SHM_ALLOC_SL_LOG)
+#define SHM_ALLOC_FL_SHIFT (SHM_ALLOC_SL_LOG + SHM_ALLOC_ALIGN_LOG)
+#define SHM_ALLOC_SMALL_SIZE (1UL << SHM_ALLOC_FL_SHIFT)
+#define SHM_ALLOC_FL_COUNT (sizeof (unsigned long) * 8 - SHM_ALLOC_FL_SHIFT + 1)
+
+#define SHM_ALLOC_PAGE_LOG 16
+
 /* This is the allocated space to hold multiple blocks */
 struct _ShmAllocSpace
 {
   /* The total size of this space */
   size_t size;
 
-  /* chained list of the blocks contained in this space */
+  /* chained list of the blocks contained in this space, in offset order */
   ShmAllocBlock *blocks;
+
+  /* free lists, and bitmaps of the non-empty ones */
+  unsigned long fl_map;
+  unsigned int sl_map[SHM_ALLOC_FL_COUNT];
+  ShmAllocBlock *free_blocks[SHM_ALLOC_FL_COUNT][SHM_ALLOC_SL_COUNT];
+
+  /* block containing the first byte of each page */
+  ShmAllocBlock **pages;
+  unsigned long n_pages;
+
+  /* statistics */
+  unsigned long used;
+  unsigned long n_used_blocks;
+  unsigned long n_free_blocks;
+  unsigned long alloc_failures;
 };
 
 /* A single block of data */
 struct _ShmAllocBlock
 {
   int use_count;
+  int is_free;
 
   /* Pointer back to the AllocSpace where this block is */
   ShmAllocSpace *space;
@@ -56,27 +97,206 @@ struct _ShmAllocBlock
   /* The size of the block */
   unsigned long size;
 
-  /* Pointer to the next block in the chain */
+  /* Pointers to the previous and next blocks in the space */
+  ShmAllocBlock *prev;
   ShmAllocBlock *next;
+
+  /* Pointers to the previous and next blocks in the free list */
+  ShmAllocBlock *prev_free;
+  ShmAllocBlock *next_free;
 };
 
+/* Index of the highest bit set */
+static int
+shm_alloc_fls (unsigned long x)
+{
+#if defined(__GNUC__)
+  return (int) (sizeof (unsigned long) * 8 - 1) - __builtin_clzl (x);
+#else
+  int bit = -1;
+
+  while (x) {
+    x >>= 1;
+    bit++;
+  }
+  return bit;
+#endif
+}
+
+/* Index of the lowest bit set */
+static int
+shm_alloc_ffs (unsigned long x)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzl (x);
+#else
+  int bit = 0;
+
+  while (!(x & 1)) {
+    x >>= 1;
+    bit++;
+  }
+  return bit;
+#endif
+}
+
+static void
+shm_alloc_mapping (unsigned long size, int *fl, int *sl)
+{
+  if (size < SHM_ALLOC_SMALL_SIZE) {
+    *fl = 0;
+    *sl = size >> SHM_ALLOC_ALIGN_LOG;
+  } else {
+    int f = shm_alloc_fls (size);
+
+    *sl = (size >> (f - SHM_ALLOC_SL_LOG)) ^ SHM_ALLOC_SL_COUNT;
+    *fl = f - (SHM_ALLOC_FL_SHIFT - 1);
+  }
+}
+
+static void
+shm_alloc_space_set_pages (ShmAllocSpace * self, ShmAllocBlock * block,
+    unsigned long offset, unsigned long size)
+{
+  unsigned long page;
+
+  page = (offset + (1UL << SHM_ALLOC_PAGE_LOG) - 1) >> SHM_ALLOC_PAGE_LOG;
+  for (; page < self->n_pages && (page << SHM_ALLOC_PAGE_LOG) < offset + size;
+      page++)
+    self->pages[page] = block;
+}
+
+static void
+shm_alloc_space_insert_free (ShmAllocSpace * self, ShmAllocBlock * block)
+{
+  int fl, sl;
+
+  shm_alloc_mapping (block->size, &fl, &sl);
+
+  block->is_free = 1;
+  block->prev_free = NULL;
+  block->next_free = self->free_blocks[fl][sl];
+  if (block->next_free)
+    block->next_free->prev_free = block;
+  self->free_blocks[fl][sl] = block;
+
+  self->fl_map |= 1UL << fl;
+  self->sl_map[fl] |= 1U << sl;
+  self->n_free_blocks++;
+}
+
+static void
+shm_alloc_space_remove_free (ShmAllocSpace * self, ShmAllocBlock * block)
+{
+  int fl, sl;
+
+  shm_alloc_mapping (block->size, &fl, &sl);
+
+  if (block->prev_free)
+    block->prev_free->next_free = block->next_free;
+  else
+    self->free_blocks[fl][sl] = block->next_free;
+  if (block->next_free)
+    block->next_free->prev_free = block->prev_free;
+
+  if (self->free_blocks[fl][sl] == NULL) {
+    self->sl_map[fl] &= ~(1U << sl);
+    if (self->sl_map[fl] == 0)
+      self->fl_map &= ~(1UL << fl);
+  }
+
+  block->is_free = 0;
+  block->prev_free = block->next_free = NULL;
+  self->n_free_blocks--;
+}
+
+/* Finds a free block of at least @size bytes */
+static ShmAllocBlock *
+shm_alloc_space_find_free (ShmAllocSpace * self, unsigned long size)
+{
+  ShmAllocBlock *block;
+  unsigned long search = size;
+  unsigned long fl_map;
+  unsigned int sl_map;
+  int fl, sl;
+
+  /* Look in the lists of the next size class, where all blocks fit */
+  if (search >= SHM_ALLOC_SMALL_SIZE)
+    search += (1UL << (shm_alloc_fls (search) - SHM_ALLOC_SL_LOG)) - 1;
+  shm_alloc_mapping (search, &fl, &sl);
+
+  if (fl < SHM_ALLOC_FL_COUNT) {
+    sl_map = self->sl_map[fl] & (~0U << sl);
+    if (!sl_map) {
+      fl_map = fl + 1 < SHM_ALLOC_FL_COUNT ?
+          self->fl_map & (~0UL << (fl + 1)) : 0;
+      if (fl_map) {
+        fl = shm_alloc_ffs (fl_map);
+        sl_map = self->sl_map[fl];
+      }
+    }
+
+    if (sl_map)
+      return self->free_blocks[fl][shm_alloc_ffs (sl_map)];
+  }
+
+  /* Otherwise there might still be a big enough block in the size class
+   * of the request */
+  shm_alloc_mapping (size, &fl, &sl);
+  for (block = self->free_blocks[fl][sl]; block; block = block->next_free) {
+    if (block->size >= size)
+      return block;
+  }
+
+  return NULL;
+}
 
 ShmAllocSpace *
 shm_alloc_space_new (size_t size)
 {
   ShmAllocSpace *self = spalloc_new (ShmAllocSpace);
+  ShmAllocBlock *block;
 
   memset (self, 0, sizeof (ShmAllocSpace));
 
   self->size = size;
 
+  self->n_pages = (size + (1UL << SHM_ALLOC_PAGE_LOG) - 1) >>
+      SHM_ALLOC_PAGE_LOG;
+  if (self->n_pages) {
+    self->pages = spalloc_alloc (self->n_pages * sizeof (ShmAllocBlock *));
+    memset (self->pages, 0, self->n_pages * sizeof (ShmAllocBlock *));
+  }
+
+  /* All blocks are multiples of the alignment */
+  size &= ~(SHM_ALLOC_ALIGN - 1);
+  if (size) {
+    block = spalloc_new (ShmAllocBlock);
+    memset (block, 0, sizeof (ShmAllocBlock));
+    block->space = self;
+    block->size = size;
+    self->blocks = block;
+    shm_alloc_space_set_pages (self, block, 0, size);
+    shm_alloc_space_insert_free (self, block);
+  }
+
   return self;
 }
 
 void
 shm_alloc_space_free (ShmAllocSpace * self)
 {
-  assert (self && self->blocks == NULL);
+  ShmAllocBlock *block;
+
+  assert (self && self->n_used_blocks == 0);
+
+  while ((block = self->blocks)) {
+    self->blocks = block->next;
+    spalloc_free (ShmAllocBlock, block);
+  }
+
+  if (self->pages)
+    spalloc_free1 (self->n_pages * sizeof (ShmAllocBlock *), self->pages);
   spalloc_free (ShmAllocSpace, self);
 }
 
@@ -85,44 +305,49 @@ ShmAllocBlock *
 shm_alloc_space_alloc_block (ShmAllocSpace * self, unsigned long size)
 {
   ShmAllocBlock *block;
-  ShmAllocBlock *item = NULL;
-  ShmAllocBlock *prev_item = NULL;
-  unsigned long prev_end_offset = 0;
-
-
-  for (item = self->blocks; item; item = item->next) {
-    unsigned long max_size = 0;
-
-    max_size = item->offset - prev_end_offset;
-
-    if (max_size >= size)
-      break;
-
-    prev_end_offset = item->offset + item->size;
-    prev_item = item;
+  ShmAllocBlock *rest;
+
+  if (size > self->size)
+    goto no_space;
+
+  size = (size + SHM_ALLOC_ALIGN - 1) & ~(SHM_ALLOC_ALIGN - 1);
+  if (size == 0)
+    size = SHM_ALLOC_ALIGN;
+
+  /* Return NULL if there is no big enough space */
+  block = shm_alloc_space_find_free (self, size);
+  if (!block)
+    goto no_space;
+
+  shm_alloc_space_remove_free (self, block);
+
+  /* Give back what we don't need */
+  if (block->size - size >= SHM_ALLOC_ALIGN) {
+    rest = spalloc_new (ShmAllocBlock);
+    memset (rest, 0, sizeof (ShmAllocBlock));
+    rest->space = self;
+    rest->offset = block->offset + size;
+    rest->size = block->size - size;
+    rest->prev = block;
+    rest->next = block->next;
+    if (rest->next)
+      rest->next->prev = rest;
+    block->next = rest;
+    block->size = size;
+
+    shm_alloc_space_set_pages (self, rest, rest->offset, rest->size);
+    shm_alloc_space_insert_free (self, rest);
   }
 
-  /* Return NULL if there is no big enough space, otherwise, there is space
-   * at the end */
-  assert (prev_end_offset <= self->size);
-  if (!item && self->size - prev_end_offset < size)
-    return NULL;
-
-  block = spalloc_new (ShmAllocBlock);
-  memset (block, 0, sizeof (ShmAllocBlock));
-  block->offset = prev_end_offset;
-  block->size = size;
   block->use_count = 1;
-  block->space = self;
-
-  if (prev_item)
-    prev_item->next = block;
-  else
-    self->blocks = block;
-
-  block->next = item;
+  self->used += block->size;
+  self->n_used_blocks++;
 
   return block;
+
+no_space:
+  self->alloc_failures++;
+  return NULL;
 }
 
 unsigned long
@@ -134,22 +359,37 @@ shm_alloc_space_alloc_block_get_offset (ShmAllocBlock * block)
 static void
 shm_alloc_space_free_block (ShmAllocBlock * block)
 {
-  ShmAllocBlock *item = NULL;
-  ShmAllocBlock *prev_item = NULL;
   ShmAllocSpace *self = block->space;
+  ShmAllocBlock *other;
+
+  self->used -= block->size;
+  self->n_used_blocks--;
+
+  /* Merge with the free neighbours, the lower block is always kept */
+  other = block->prev;
+  if (other && other->is_free) {
+    shm_alloc_space_remove_free (self, other);
+    other->size += block->size;
+    other->next = block->next;
+    if (other->next)
+      other->next->prev = other;
+    shm_alloc_space_set_pages (self, other, block->offset, block->size);
+    spalloc_free (ShmAllocBlock, block);
+    block = other;
+  }
 
-  for (item = self->blocks; item; item = item->next) {
-    if (item == block) {
-      if (prev_item)
-        prev_item->next = item->next;
-      else
-        self->blocks = item->next;
-      break;
-    }
-    prev_item = item;
+  other = block->next;
+  if (other && other->is_free) {
+    shm_alloc_space_remove_free (self, other);
+    block->size += other->size;
+    block->next = other->next;
+    if (block->next)
+      block->next->prev = block;
+    shm_alloc_space_set_pages (self, block, other->offset, other->size);
+    spalloc_free (ShmAllocBlock, other);
   }
 
-  spalloc_free (ShmAllocBlock, block);
+  shm_alloc_space_insert_free (self, block);
 }
 
 ShmAllocBlock *
@@ -157,9 +397,13 @@ shm_alloc_space_block_get (ShmAllocSpace * self, unsigned long offset)
 {
   ShmAllocBlock *block = NULL;
 
-  for (block = self->blocks; block; block = block->next) {
+  if (offset >= self->size)
+    return NULL;
+
+  for (block = self->pages[offset >> SHM_ALLOC_PAGE_LOG]; block;
+      block = block->next) {
     if (block->offset <= offset && (block->offset + block->size) > offset)
-      return block;
+      return block->is_free ? NULL : block;
   }
 
   return NULL;
@@ -180,3 +424,28 @@ shm_alloc_space_block_dec (ShmAllocBlock * block)
   if (block->use_count <= 0)
     shm_alloc_space_free_block (block);
 }
+
+void
+shm_alloc_space_get_stats (ShmAllocSpace * self, ShmAllocStats * stats)
+{
+  ShmAllocBlock *block;
+  int fl, sl;
+
+  memset (stats, 0, sizeof (ShmAllocStats));
+
+  stats->size = self->size;
+  stats->used = self->used;
+  stats->used_blocks = self->n_used_blocks;
+  stats->free_blocks = self->n_free_blocks;
+  stats->alloc_failures = self->alloc_failures;
+
+  /* The largest free block is in the highest non-empty list */
+  if (self->fl_map) {
+    fl = shm_alloc_fls (self->fl_map);
+    sl = shm_alloc_fls (self->sl_map[fl]);
+    for (block = self->free_blocks[fl][sl]; block; block = block->next_free) {
+      if (block->size > stats->largest_free)
+        stats->largest_free = block->size;
+    }
+  }
+}
@@ -53,6 +53,21 @@ extern "C" {
 typedef struct _ShmAllocSpace ShmAllocSpace;
 typedef struct _ShmAllocBlock ShmAllocBlock;
 
+typedef struct
+{
+  /* size of the space, and bytes currently allocated in it */
+  unsigned long size;
+  unsigned long used;
+
+  unsigned long used_blocks;
+  unsigned long free_blocks;
+  /* the biggest block that can currently be allocated */
+  unsigned long largest_free;
+
+  /* number of allocations that failed for lack of space */
+  unsigned long alloc_failures;
+} ShmAllocStats;
+
 ShmAllocSpace *shm_alloc_space_new (size_t size);
 void shm_alloc_space_free (ShmAllocSpace * self);
 
@@ -66,6 +81,8 @@ void shm_alloc_space_block_dec (ShmAllocBlock * block);
 ShmAllocBlock * shm_alloc_space_block_get (ShmAllocSpace * space,
     unsigned long offset);
 
+void shm_alloc_space_get_stats (ShmAllocSpace * self, ShmAllocStats * stats);
+
 
 #ifdef __cplusplus
 }
@@ -993,3 +993,16 @@ sp_writer_get_max_buf_size (ShmPipe * self)
 
   return self->shm_area->shm_area_len;
 }
+
+/* Gets the allocation statistics of the current shm area, returns 0 if
+ * there is none */
+int
+sp_writer_get_alloc_stats (ShmPipe * self, ShmAllocStats * stats)
+{
+  if (self->shm_area == NULL || self->shm_area->allocspace == NULL)
+    return 0;
+
+  shm_alloc_space_get_stats (self->shm_area->allocspace, stats);
+
+  return 1;
+}
@@ -0,0 +1,430 @@
+/* GStreamer
+ *
+ * Benchmark for the stateless decoder base classes in gst-libs/gst/codecs
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Decodes a file with the "null backend" subclasses of the codec base
+ * classes from tests/check/libs/nulldecoders.c, whose decoding vfuncs are
+ * no-ops, so that the time spent in the base classes can be measured.
+ *
+ * Usage: codecs [FILE [NUM_DPB_PICTURES]]
+ *
+ * When FILE is given, it is demuxed and parsed by parsebin and its first
+ * supported video stream is decoded by the matching null decoder:
+ *
+ *   filesrc ! parsebin ! null*dec ! fakesink
+ *
+ * and the time spent inside the decoder (parsing, DPB management, reference
+ * list construction and allocation of the dummy frames) is reported per
+ * frame. The time downstream takes to handle the frames is not counted.
+ *
+ * Then NUM_DPB_PICTURES pictures (default 1000000) are pushed through a
+ * GstH264Dpb and a GstH265Dpb following the sequence of calls the decoders
+ * make for an IbbP-like GOP, and the number of DPB operations per second is
+ * reported.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gst/codecs/gsth264decoder.h>
+#include <gst/codecs/gsth265decoder.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../check/libs/nulldecoders.h"
+
+/* Decoding benchmark */
+
+typedef struct
+{
+  GMainLoop *loop;
+  GstElement *pipeline;
+  GstElement *dec;
+  gboolean error;
+} Benchmark;
+
+static void
+link_to_sink (Benchmark * bench, GstPad * pad, GstElement * dec)
+{
+  GstElement *sink;
+  GstPad *sinkpad;
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, "async", FALSE, NULL);
+  gst_bin_add (GST_BIN (bench->pipeline), sink);
+
+  if (dec) {
+    gst_bin_add (GST_BIN (bench->pipeline), dec);
+    gst_element_link (dec, sink);
+    sinkpad = gst_element_get_static_pad (dec, "sink");
+  } else {
+    sinkpad = gst_element_get_static_pad (sink, "sink");
+  }
+
+  if (gst_pad_link (pad, sinkpad) != GST_PAD_LINK_OK)
+    g_printerr ("Could not link %s:%s\n", GST_DEBUG_PAD_NAME (pad));
+  gst_object_unref (sinkpad);
+
+  gst_element_sync_state_with_parent (sink);
+  if (dec)
+    gst_element_sync_state_with_parent (dec);
+}
+
+static void
+on_pad_added (GstElement * parsebin, GstPad * pad, Benchmark * bench)
+{
+  GstElement *dec = NULL;
+  GstCaps *caps;
+
+  /* Only the first supported stream is decoded, all the others are
+   * discarded so that they don't stall the demuxer */
+  if (!bench->dec) {
+    caps = gst_pad_get_current_caps (pad);
+    if (!caps)
+      caps = gst_pad_query_caps (pad, NULL);
+
+    dec = make_null_decoder (caps);
+    gst_caps_unref (caps);
+  }
+
+  if (dec)
+    bench->dec = gst_object_ref (dec);
+
+  link_to_sink (bench, pad, dec);
+}
+
+static gboolean
+on_bus_message (GstBus * bus, GstMessage * message, Benchmark * bench)
+{
+  switch (GST_MESSAGE_TYPE (message)) {
+    case GST_MESSAGE_ERROR:{
+      GError *error = NULL;
+
+      gst_message_parse_error (message, &error, NULL);
+      g_printerr ("Error: %s\n", error->message);
+      g_error_free (error);
+      bench->error = TRUE;
+      g_main_loop_quit (bench->loop);
+      break;
+    }
+    case GST_MESSAGE_EOS:
+      g_main_loop_quit (bench->loop);
+      break;
+    default:
+      break;
+  }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+run_decode (const gchar * location)
+{
+  Benchmark bench = { NULL, };
+  GstElement *src, *parsebin;
+  NullDecStats *stats;
+  GstBus *bus;
+
+  src = gst_element_factory_make ("filesrc", NULL);
+  parsebin = gst_element_factory_make ("parsebin", NULL);
+  if (!src || !parsebin) {
+    g_printerr ("filesrc or parsebin is missing\n");
+    gst_clear_object (&src);
+    gst_clear_object (&parsebin);
+    return FALSE;
+  }
+
+  bench.loop = g_main_loop_new (NULL, FALSE);
+  bench.pipeline = gst_pipeline_new (NULL);
+
+  g_object_set (src, "location", location, NULL);
+  gst_bin_add_many (GST_BIN (bench.pipeline), src, parsebin, NULL);
+  gst_element_link (src, parsebin);
+  g_signal_connect (parsebin, "pad-added", G_CALLBACK (on_pad_added), &bench);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (bench.pipeline));
+  gst_bus_add_watch (bus, (GstBusFunc) on_bus_message, &bench);
+
+  gst_element_set_state (bench.pipeline, GST_STATE_PLAYING);
+  g_main_loop_run (bench.loop);
+  gst_element_set_state (bench.pipeline, GST_STATE_NULL);
+
+  if (!bench.dec) {
+    g_printerr ("%s has no H.264, H.265, VP9, AV1 or MPEG-2 video stream\n",
+        location);
+    bench.error = TRUE;
+  } else if (!bench.error) {
+    stats = null_dec_get_stats (bench.dec);
+
+    g_print ("%s: %" G_GUINT64_FORMAT " frames, %" G_GUINT64_FORMAT
+        " pictures, %" G_GUINT64_FORMAT " slices/tiles in %.3f ms",
+        GST_OBJECT_NAME (gst_element_get_factory (bench.dec)), stats->frames,
+        stats->pictures, stats->slices,
+        (gdouble) stats->time / GST_MSECOND);
+    if (stats->frames) {
+      g_print (": %.2f us/frame", (gdouble) stats->time / stats->frames /
+          GST_USECOND);
+    }
+    g_print ("\n");
+  }
+
+  gst_clear_object (&bench.dec);
+  gst_bus_remove_watch (bus);
+  gst_object_unref (bus);
+  gst_object_unref (bench.pipeline);
+  g_main_loop_unref (bench.loop);
+
+  return !bench.error;
+}
+
+/* DPB benchmark
+ *
+ * Decoding order I0 P8 B4 b2 b6 P16 B12 b10 b14 ..., where the I, P and B
+ * pictures are used for reference and the b pictures are not */
+
+#define DPB_SIZE 16
+#define NUM_REFS 4
+#define MAX_REORDER 2
+
+static const gint gop_poc[] = { 8, 4, 2, 6 };
+
+#define GOP_POC(i) \
+    ((i) == 0 ? 0 : (((i) - 1) / 4) * 8 + gop_poc[((i) - 1) % 4])
+#define GOP_IS_REF(i) ((i) == 0 || ((i) - 1) % 4 < 2)
+
+static void
+report_dpb (const gchar * name, guint num_pictures, guint64 ops,
+    GstClockTime time)
+{
+  gdouble secs = (gdouble) time / GST_SECOND;
+
+  g_print ("%s: %u pictures, %" G_GUINT64_FORMAT " operations in %.3f s: "
+      "%.0f ops/s, %.1f ns/picture\n", name, num_pictures, ops, secs,
+      ops / secs, (gdouble) time / num_pictures);
+}
+
+static gint
+h264_pic_num_desc_compare (const GstH264Picture ** a,
+    const GstH264Picture ** b)
+{
+  return (*b)->pic_num - (*a)->pic_num;
+}
+
+static void
+run_h264_dpb (guint num_pictures)
+{
+  GstH264Dpb *dpb;
+  GstH264Picture *picture;
+  GArray *refs;
+  GstClockTime start;
+  guint64 ops = 0;
+  guint i;
+
+  dpb = gst_h264_dpb_new ();
+  gst_h264_dpb_set_max_num_frames (dpb, DPB_SIZE);
+  refs = g_array_sized_new (FALSE, TRUE, sizeof (GstH264Picture *), DPB_SIZE);
+  g_array_set_clear_func (refs, (GDestroyNotify) gst_h264_picture_clear);
+
+  start = gst_util_get_timestamp ();
+
+  for (i = 0; i < num_pictures; i++) {
+    picture = gst_h264_picture_new ();
+    picture->system_frame_number = i;
+    picture->frame_num = picture->frame_num_wrap = picture->pic_num = i;
+    picture->pic_order_cnt = picture->top_field_order_cnt =
+        picture->bottom_field_order_cnt = GOP_POC (i);
+    picture->idr = i == 0;
+    picture->nal_ref_idc = GOP_IS_REF (i);
+
+    /* Reference picture list initialisation, 8.2.4.2.1 */
+    gst_h264_dpb_get_pictures_short_term_ref (dpb, FALSE, FALSE, refs);
+    g_array_sort (refs, (GCompareFunc) h264_pic_num_desc_compare);
+    gst_h264_dpb_get_pictures_long_term_ref (dpb, FALSE, refs);
+    g_array_set_size (refs, 0);
+    ops += 2;
+
+    /* Sliding window reference marking, 8.2.5.3 */
+    if (GOP_IS_REF (i)) {
+      picture->ref = GST_H264_PICTURE_REF_SHORT_TERM;
+
+      ops++;
+      if (gst_h264_dpb_num_ref_frames (dpb) >= NUM_REFS) {
+        GstH264Picture *to_unmark =
+            gst_h264_dpb_get_lowest_frame_num_short_ref (dpb);
+
+        to_unmark->ref = GST_H264_PICTURE_REF_NONE;
+        gst_h264_picture_unref (to_unmark);
+        ops++;
+      }
+    }
+
+    gst_h264_dpb_delete_unused (dpb);
+    gst_h264_dpb_add (dpb, picture);
+    ops += 2;
+
+    while (gst_h264_dpb_needs_bump (dpb, MAX_REORDER, FALSE)) {
+      picture = gst_h264_dpb_bump (dpb, FALSE);
+      ops += 2;
+      if (!picture)
+        break;
+
+      gst_h264_picture_unref (picture);
+    }
+    ops++;
+  }
+
+  while ((picture = gst_h264_dpb_bump (dpb, TRUE))) {
+    gst_h264_picture_unref (picture);
+    ops++;
+  }
+
+  report_dpb ("GstH264Dpb", num_pictures, ops,
+      gst_util_get_timestamp () - start);
+
+  g_array_unref (refs);
+  gst_h264_dpb_free (dpb);
+}
+
+static void
+run_h265_dpb (guint num_pictures)
+{
+  GstH265Dpb *dpb;
+  GstH265Picture *picture;
+  GstH265Picture *rps[NUM_REFS];
+  gint ref_pocs[NUM_REFS];
+  guint num_ref_pocs = 0;
+  GArray *pictures;
+  GstClockTime start;
+  guint64 ops = 0;
+  guint i, j, k;
+
+  dpb = gst_h265_dpb_new ();
+  gst_h265_dpb_set_max_num_pics (dpb, DPB_SIZE);
+
+  start = gst_util_get_timestamp ();
+
+  for (i = 0; i < num_pictures; i++) {
+    picture = gst_h265_picture_new ();
+    picture->system_frame_number = i;
+    picture->pic_order_cnt = GOP_POC (i);
+    picture->output_flag = TRUE;
+
+    /* Reference picture set derivation and marking, 8.3.2 */
+    for (j = 0; j < num_ref_pocs; j++) {
+      rps[j] = gst_h265_dpb_get_short_ref_by_poc (dpb, ref_pocs[j]);
+      ops++;
+    }
+
+    pictures = gst_h265_dpb_get_pictures_all (dpb);
+    for (j = 0; j < pictures->len; j++) {
+      GstH265Picture *other = g_array_index (pictures, GstH265Picture *, j);
+
+      for (k = 0; k < num_ref_pocs; k++) {
+        if (rps[k] == other)
+          break;
+      }
+
+      if (k == num_ref_pocs)
+        other->ref = FALSE;
+    }
+    g_array_unref (pictures);
+    ops++;
+
+    for (j = 0; j < num_ref_pocs; j++)
+      gst_h265_picture_clear (&rps[j]);
+
+    /* C.5.2.2 */
+    gst_h265_dpb_delete_unused (dpb);
+    ops++;
+    while (gst_h265_dpb_needs_bump (dpb, MAX_REORDER, 0, DPB_SIZE)) {
+      GstH265Picture *to_output = gst_h265_dpb_bump (dpb, FALSE);
+
+      ops += 2;
+      if (!to_output)
+        break;
+
+      gst_h265_picture_unref (to_output);
+      gst_h265_dpb_delete_unused (dpb);
+      ops++;
+    }
+    ops++;
+
+    gst_h265_dpb_add (dpb, picture);
+    ops++;
+
+    /* C.5.2.3 */
+    while (gst_h265_dpb_needs_bump (dpb, MAX_REORDER, 0, 0)) {
+      GstH265Picture *to_output = gst_h265_dpb_bump (dpb, FALSE);
+
+      ops += 2;
+      if (!to_output)
+        break;
+
+      gst_h265_picture_unref (to_output);
+    }
+    ops++;
+
+    if (GOP_IS_REF (i)) {
+      if (num_ref_pocs == NUM_REFS) {
+        memmove (ref_pocs, ref_pocs + 1, (NUM_REFS - 1) * sizeof (gint));
+        num_ref_pocs--;
+      }
+      ref_pocs[num_ref_pocs++] = GOP_POC (i);
+    }
+  }
+
+  while ((picture = gst_h265_dpb_bump (dpb, TRUE))) {
+    gst_h265_picture_unref (picture);
+    ops++;
+  }
+
+  report_dpb ("GstH265Dpb", num_pictures, ops,
+      gst_util_get_timestamp () - start);
+
+  gst_h265_dpb_free (dpb);
+}
+
+int
+main (int argc, char **argv)
+{
+  guint num_dpb_pictures = 1000000;
+  gboolean ret = TRUE;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 2)
+    num_dpb_pictures = atoi (argv[2]);
+
+  if (argc > 3 || num_dpb_pictures == 0) {
+    g_printerr ("Usage: %s [FILE [NUM_DPB_PICTURES]]\n", argv[0]);
+    return 1;
+  }
+
+  register_null_decoders ();
+
+  if (argc > 1)
+    ret = run_decode (argv[1]);
+
+  run_h264_dpb (num_dpb_pictures);
+  run_h265_dpb (num_dpb_pictures);
+
+  return ret ? 0 : 1;
+}
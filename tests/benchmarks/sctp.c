@@ -0,0 +1,216 @@
+/* GStreamer
+ *
+ * Benchmark for the throughput of the sctpenc and sctpdec elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures how fast data goes through two SCTP associations connected back
+ * to back, the way two webrtcbin peers use them for data channels:
+ *
+ *   fakesrc ! sctpenc (1) ! sctpdec (2) ! fakesink
+ *             sctpenc (2) ! sctpdec (1)
+ *
+ * Usage: sctp [MESSAGE_SIZE [TOTAL_MB [BUFFER_SIZE]]]
+ *
+ * MESSAGE_SIZE is the size of each data channel message (default 16384),
+ * TOTAL_MB the amount of data to send (default 256) and BUFFER_SIZE the
+ * send and receive buffer sizes of the SCTP sockets (default 1048576).
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <stdlib.h>
+
+typedef struct
+{
+  GMainLoop *loop;
+  GstElement *pipeline;
+  GstElement *src;
+  GstElement *enc;
+
+  guint64 expected;
+  guint64 received;
+  gint64 start_time;
+  gint64 end_time;
+} Benchmark;
+
+static void
+on_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    Benchmark * bench)
+{
+  bench->received += gst_buffer_get_size (buffer);
+
+  if (bench->received >= bench->expected && !bench->end_time) {
+    bench->end_time = g_get_monotonic_time ();
+    g_main_loop_quit (bench->loop);
+  }
+}
+
+static void
+on_pad_added (GstElement * dec, GstPad * pad, Benchmark * bench)
+{
+  GstElement *sink;
+  GstPad *sinkpad;
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, "async", FALSE, "signal-handoffs", TRUE,
+      NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (on_handoff), bench);
+
+  gst_bin_add (GST_BIN (bench->pipeline), sink);
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_element_sync_state_with_parent (sink);
+}
+
+static gboolean
+start_sending (Benchmark * bench)
+{
+  GstPad *srcpad, *sinkpad;
+
+  sinkpad = gst_element_get_request_pad (bench->enc, "sink_0");
+  if (!sinkpad) {
+    g_printerr ("Could not request a stream from sctpenc\n");
+    g_main_loop_quit (bench->loop);
+    return G_SOURCE_REMOVE;
+  }
+
+  srcpad = gst_element_get_static_pad (bench->src, "src");
+  gst_pad_link (srcpad, sinkpad);
+  gst_object_unref (srcpad);
+  gst_object_unref (sinkpad);
+
+  bench->start_time = g_get_monotonic_time ();
+  gst_element_set_locked_state (bench->src, FALSE);
+  gst_element_sync_state_with_parent (bench->src);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+on_association_established (GstElement * enc, gboolean established,
+    Benchmark * bench)
+{
+  /* Emitted from the usrsctp thread */
+  if (established)
+    g_idle_add ((GSourceFunc) start_sending, bench);
+}
+
+static gboolean
+on_bus_message (GstBus * bus, GstMessage * message, Benchmark * bench)
+{
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR) {
+    GError *error = NULL;
+
+    gst_message_parse_error (message, &error, NULL);
+    g_printerr ("Error: %s\n", error->message);
+    g_error_free (error);
+    g_main_loop_quit (bench->loop);
+  }
+
+  return G_SOURCE_CONTINUE;
+}
+
+int
+main (int argc, char **argv)
+{
+  Benchmark bench = { NULL, };
+  GstElement *enc2, *dec1, *dec2;
+  guint message_size = 16384, total_mb = 256, buffer_size = 1024 * 1024;
+  GstBus *bus;
+  gdouble secs;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    message_size = atoi (argv[1]);
+  if (argc > 2)
+    total_mb = atoi (argv[2]);
+  if (argc > 3)
+    buffer_size = atoi (argv[3]);
+
+  if (message_size == 0 || total_mb == 0 || buffer_size == 0) {
+    g_printerr ("Usage: %s [MESSAGE_SIZE [TOTAL_MB [BUFFER_SIZE]]]\n",
+        argv[0]);
+    return 1;
+  }
+
+  bench.loop = g_main_loop_new (NULL, FALSE);
+  bench.pipeline = gst_pipeline_new (NULL);
+
+  bench.src = gst_element_factory_make ("fakesrc", NULL);
+  bench.enc = gst_element_factory_make ("sctpenc", NULL);
+  enc2 = gst_element_factory_make ("sctpenc", NULL);
+  dec1 = gst_element_factory_make ("sctpdec", NULL);
+  dec2 = gst_element_factory_make ("sctpdec", NULL);
+
+  if (!bench.src || !bench.enc || !enc2 || !dec1 || !dec2) {
+    g_printerr ("The sctp plugin is missing\n");
+    return 1;
+  }
+
+  bench.expected = (guint64) total_mb * 1024 * 1024;
+  bench.expected -= bench.expected % message_size;
+
+  g_object_set (bench.src, "sizetype", 2, "sizemax", message_size,
+      "filltype", 1, "num-buffers", (gint) (bench.expected / message_size),
+      NULL);
+  gst_element_set_locked_state (bench.src, TRUE);
+
+  g_object_set (bench.enc, "sctp-association-id", 1, "remote-sctp-port", 5000,
+      "send-buffer-size", buffer_size, NULL);
+  g_object_set (dec1, "sctp-association-id", 1, "local-sctp-port", 5000,
+      "receive-buffer-size", buffer_size, NULL);
+  g_object_set (enc2, "sctp-association-id", 2, "remote-sctp-port", 5000,
+      "send-buffer-size", buffer_size, NULL);
+  g_object_set (dec2, "sctp-association-id", 2, "local-sctp-port", 5000,
+      "receive-buffer-size", buffer_size, NULL);
+
+  gst_bin_add_many (GST_BIN (bench.pipeline), bench.src, bench.enc, enc2, dec1,
+      dec2, NULL);
+  gst_element_link (bench.enc, dec2);
+  gst_element_link (enc2, dec1);
+
+  g_signal_connect (bench.enc, "sctp-association-established",
+      G_CALLBACK (on_association_established), &bench);
+  g_signal_connect (dec2, "pad-added", G_CALLBACK (on_pad_added), &bench);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (bench.pipeline));
+  gst_bus_add_watch (bus, (GstBusFunc) on_bus_message, &bench);
+
+  gst_element_set_state (bench.pipeline, GST_STATE_PLAYING);
+  g_main_loop_run (bench.loop);
+  gst_element_set_state (bench.pipeline, GST_STATE_NULL);
+
+  if (bench.end_time) {
+    secs = (bench.end_time - bench.start_time) / (gdouble) G_USEC_PER_SEC;
+    g_print ("%" G_GUINT64_FORMAT " bytes in messages of %u bytes: "
+        "%.3f s, %.1f Mbit/s\n", bench.received, message_size, secs,
+        bench.received * 8 / secs / 1000000);
+  }
+
+  gst_bus_remove_watch (bus);
+  gst_object_unref (bus);
+  gst_object_unref (bench.pipeline);
+  g_main_loop_unref (bench.loop);
+
+  return bench.end_time ? 0 : 1;
+}
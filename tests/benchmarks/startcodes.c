@@ -0,0 +1,174 @@
+/* GStreamer
+ *
+ * Benchmark for the start code scanning used by the video codec parsers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Compares the throughput of the start code scanner of the codec parsers
+ * with a gst_byte_reader_masked_scan_uint32() based scan.
+ *
+ * Usage: startcodes [FILE]
+ *
+ * FILE is a raw Annex-B (or MPEG-1/2/4 elementary) stream. If not given, a
+ * synthetic stream of 64 MB made of random NAL units is used.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gst/base/gstbytereader.h>
+#include <gst/codecparsers/parserutils.h>
+#include <string.h>
+
+#define SYNTHETIC_SIZE (64 * 1024 * 1024)
+#define N_RUNS 10
+#define MAX_OFFSETS 1024
+
+static guint8 *
+generate_stream (gsize size)
+{
+  GRand *rand = g_rand_new_with_seed (0);
+  guint8 *data = g_malloc (size);
+  gsize pos = 0, nal_size, i;
+  guint zeros = 0;
+
+  while (pos < size) {
+    /* start code and NAL header */
+    if (pos + 4 > size)
+      break;
+    data[pos++] = 0x00;
+    data[pos++] = 0x00;
+    data[pos++] = 0x01;
+    data[pos++] = g_rand_int_range (rand, 1, 0x20);
+
+    nal_size = g_rand_int_range (rand, 16, 64 * 1024);
+    for (i = 0; i < nal_size && pos < size; i++) {
+      guint8 byte = g_rand_int (rand) & 0xff;
+
+      /* insert emulation prevention bytes */
+      if (zeros == 2 && byte <= 0x03) {
+        data[pos++] = 0x03;
+        zeros = 0;
+        if (pos == size)
+          break;
+      }
+
+      data[pos++] = byte;
+      zeros = byte ? 0 : zeros + 1;
+    }
+    zeros = 0;
+  }
+
+  memset (data + pos, 0xff, size - pos);
+  g_rand_free (rand);
+
+  return data;
+}
+
+static guint
+scan_byte_reader (const guint8 * data, gsize size)
+{
+  GstByteReader br;
+  guint n = 0;
+  gint off = 0;
+
+  gst_byte_reader_init (&br, data, size);
+
+  while (TRUE) {
+    off = gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
+        off, size - off);
+    if (off < 0)
+      break;
+    n++;
+    off += 3;
+  }
+
+  return n;
+}
+
+static guint
+scan_parserutils (const guint8 * data, gsize size)
+{
+  guint offsets[MAX_OFFSETS];
+  guint n = 0, found;
+  gsize pos = 0;
+
+  do {
+    found = find_start_codes (data + pos, size - pos, offsets, MAX_OFFSETS);
+    n += found;
+    if (found)
+      pos += offsets[found - 1] + 3;
+  } while (found == MAX_OFFSETS);
+
+  return n;
+}
+
+static void
+run (const gchar * name, guint (*scan) (const guint8 *, gsize),
+    const guint8 * data, gsize size, guint * n_found)
+{
+  gint64 start, best = G_MAXINT64;
+  guint i;
+
+  for (i = 0; i < N_RUNS; i++) {
+    start = g_get_monotonic_time ();
+    *n_found = scan (data, size);
+    best = MIN (best, g_get_monotonic_time () - start);
+  }
+
+  g_print ("%-16s %8u start codes, %8.1f MB/s\n", name, *n_found,
+      (size / (1024.0 * 1024.0)) / (MAX (best, 1) / (gdouble) G_USEC_PER_SEC));
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  GError *err = NULL;
+  guint8 *data;
+  gsize size;
+  guint n_old, n_new;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1) {
+    if (!g_file_get_contents (argv[1], (gchar **) & data, &size, &err)) {
+      g_printerr ("Could not read %s: %s\n", argv[1], err->message);
+      g_clear_error (&err);
+      return 1;
+    }
+  } else {
+    size = SYNTHETIC_SIZE;
+    data = generate_stream (size);
+  }
+
+  g_print ("Scanning %" G_GSIZE_FORMAT " bytes, best of %d runs\n", size,
+      N_RUNS);
+
+  run ("byte reader", scan_byte_reader, data, size, &n_old);
+  run ("parserutils", scan_parserutils, data, size, &n_new);
+
+  g_free (data);
+
+  if (n_old != n_new) {
+    g_printerr ("Start code count mismatch: %u != %u\n", n_old, n_new);
+    return 1;
+  }
+
+  return 0;
+}
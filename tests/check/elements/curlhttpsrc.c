@@ -820,21 +820,33 @@ typedef struct _DataProbeResult
   guint64 received;
 } DataProbeResult;
 
+static gboolean
+count_buffer (GstBuffer ** buf, guint idx, gpointer user_data)
+{
+  DataProbeResult *dpr = (DataProbeResult *) user_data;
+
+  dpr->received += gst_buffer_get_size (*buf);
+  return TRUE;
+}
+
 static GstPadProbeReturn
 src_data_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
 {
-  DataProbeResult *dpr = (DataProbeResult *) user_data;
   GstBuffer *buf;
 
   if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
     buf = GST_PAD_PROBE_INFO_BUFFER (info);
-    dpr->received += gst_buffer_get_size (buf);
+    count_buffer (&buf, 0, user_data);
+  } else if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    gst_buffer_list_foreach (GST_PAD_PROBE_INFO_BUFFER_LIST (info),
+        count_buffer, user_data);
   }
 
   return GST_PAD_PROBE_OK;
 }
 
-GST_START_TEST (test_range_get)
+static void
+run_range_get_test (guint blocksize, guint watermark)
 {
   GstStateChangeReturn ret;
   MultipleHttpRequestsContext context;
@@ -850,10 +862,14 @@ GST_START_TEST (test_range_get)
   fail_unless (context.downloader1 != NULL);
   context.downloader1->start_position = 128;
   context.downloader1->stop_position = 255;
+  if (blocksize > 0)
+    g_object_set (context.downloader1->src, "blocksize", blocksize, NULL);
+  g_object_set (context.downloader1->src, "watermark", watermark, NULL);
   src_pad = gst_element_get_static_pad (context.downloader1->src, "src");
   fail_unless (src_pad != NULL);
   dpr.received = 0;
-  probe_id = gst_pad_add_probe (src_pad, GST_PAD_PROBE_TYPE_BUFFER,
+  probe_id = gst_pad_add_probe (src_pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
       src_data_probe, &dpr, NULL);
   fail_unless (probe_id > 0);
   context.downloader2 = NULL;
@@ -885,6 +901,19 @@ GST_START_TEST (test_range_get)
   g_main_loop_unref (context.loop);
 }
 
+GST_START_TEST (test_range_get)
+{
+  run_range_get_test (0, 0);
+}
+
+GST_END_TEST;
+
+/* Blocks smaller than the response, pushed downstream in batches */
+GST_START_TEST (test_range_get_small_blocks)
+{
+  run_range_get_test (16, 64);
+}
+
 GST_END_TEST;
 
 static Suite *
@@ -911,6 +940,7 @@ curlhttpsrc_suite (void)
   tcase_add_test (tc_chain, test_cookies);
   tcase_add_test (tc_chain, test_multiple_http_requests);
   tcase_add_test (tc_chain, test_range_get);
+  tcase_add_test (tc_chain, test_range_get_small_blocks);
 
   return s;
 }
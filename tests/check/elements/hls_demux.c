@@ -726,6 +726,182 @@ GST_START_TEST (testFragmentDownloadError)
 
 GST_END_TEST;
 
+static void
+testPrefetchPreTestCallback (GstAdaptiveDemuxTestEngine * engine,
+    gpointer user_data)
+{
+  g_object_set (engine->demux, "prefetch-fragments", 2, NULL);
+}
+
+/*
+ * Test that enabling prefetching doesn't cause any extra request when there
+ * is nothing to prefetch
+ */
+GST_START_TEST (testPrefetchLastFragment)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "001.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  const GValue *requests;
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.pre_test = testPrefetchPreTestCallback;
+  engine_callbacks.appsink_received_data =
+      gst_adaptive_demux_test_check_received_data;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+
+  requests = gst_structure_get_value (hlsTestCase.state, "requests");
+  fail_unless (requests != NULL);
+  assert_equals_uint64 (gst_value_array_get_size (requests), 2);
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
+static gint prefetched_fragments;
+
+static void
+testPrefetchStatisticsCallback (GstBus * bus, GstMessage * msg,
+    gpointer user_data)
+{
+  const GstStructure *s = gst_message_get_structure (msg);
+  gboolean prefetched;
+
+  if (gst_structure_has_name (s, "adaptive-streaming-statistics") &&
+      gst_structure_get_boolean (s, "fragment-prefetched", &prefetched) &&
+      prefetched)
+    g_atomic_int_inc (&prefetched_fragments);
+}
+
+static void
+testPrefetchCacheHitPreTestCallback (GstAdaptiveDemuxTestEngine * engine,
+    gpointer user_data)
+{
+  GstBus *bus = gst_element_get_bus (engine->pipeline);
+
+  prefetched_fragments = 0;
+  gst_bus_enable_sync_message_emission (bus);
+  g_signal_connect (bus, "sync-message::element",
+      G_CALLBACK (testPrefetchStatisticsCallback), NULL);
+  gst_object_unref (bus);
+
+  g_object_set (engine->demux, "prefetch-fragments", 2, NULL);
+}
+
+/*
+ * Test that a prefetched fragment is pushed from the cache, without
+ * downloading it a second time
+ */
+GST_START_TEST (testPrefetchCacheHit)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "001.ts\n"
+      "#EXTINF:1,Test\n" "002.ts\n"
+      "#EXTINF:1,Test\n" "003.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {"http://unit.test/002.ts", NULL, segment_size},
+    {"http://unit.test/003.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 3 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  const GValue *requests;
+  guint i, j, count;
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.pre_test = testPrefetchCacheHitPreTestCallback;
+  engine_callbacks.appsink_received_data =
+      gst_adaptive_demux_test_check_received_data;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+
+  /* The last fragment was prefetched while the second one was downloaded */
+  fail_unless (g_atomic_int_get (&prefetched_fragments) > 0);
+
+  /* and every fragment was requested exactly once */
+  requests = gst_structure_get_value (hlsTestCase.state, "requests");
+  fail_unless (requests != NULL);
+  assert_equals_uint64 (gst_value_array_get_size (requests),
+      G_N_ELEMENTS (inputTestData) - 1);
+  for (i = 0; inputTestData[i].uri; i++) {
+    count = 0;
+    for (j = 0; j < gst_value_array_get_size (requests); j++) {
+      const GValue *uri = gst_value_array_get_value (requests, j);
+
+      if (g_str_equal (g_value_get_string (uri), inputTestData[i].uri))
+        count++;
+    }
+    fail_unless_equals_int (count, 1);
+  }
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
+/*
+ * Test that the ABR policy and bandwidth estimator can be selected
+ */
+GST_START_TEST (testAbrProperties)
+{
+  GstElement *demux;
+  gint policy, estimator;
+  guint64 buffer_target;
+
+  demux = gst_element_factory_make (DEMUX_ELEMENT_NAME, NULL);
+  fail_unless (demux != NULL);
+
+  g_object_get (demux, "abr-policy", &policy, "abr-estimator", &estimator,
+      "abr-buffer-target", &buffer_target, NULL);
+  fail_unless_equals_int (policy, 0);
+  fail_unless_equals_int (estimator, 0);
+  fail_unless_equals_uint64 (buffer_target, 10 * GST_SECOND);
+
+  gst_util_set_object_arg (G_OBJECT (demux), "abr-policy", "hybrid");
+  gst_util_set_object_arg (G_OBJECT (demux), "abr-estimator", "ewma");
+  g_object_set (demux, "abr-buffer-target", 20 * GST_SECOND, NULL);
+
+  g_object_get (demux, "abr-policy", &policy, "abr-estimator", &estimator,
+      "abr-buffer-target", &buffer_target, NULL);
+  fail_unless_equals_int (policy, 2);
+  fail_unless_equals_int (estimator, 1);
+  fail_unless_equals_uint64 (buffer_target, 20 * GST_SECOND);
+
+  gst_object_unref (demux);
+}
+
+GST_END_TEST;
+
 static Suite *
 hls_demux_suite (void)
 {
@@ -745,6 +921,9 @@ hls_demux_suite (void)
   tcase_add_test (tc_basicTest, testSeekSnapAfterPosition);
   tcase_add_test (tc_basicTest, testReverseSeekSnapBeforePosition);
   tcase_add_test (tc_basicTest, testReverseSeekSnapAfterPosition);
+  tcase_add_test (tc_basicTest, testAbrProperties);
+  tcase_add_test (tc_basicTest, testPrefetchLastFragment);
+  tcase_add_test (tc_basicTest, testPrefetchCacheHit);
 
   tcase_add_unchecked_fixture (tc_basicTest, gst_adaptive_demux_test_setup,
       gst_adaptive_demux_test_teardown);
@@ -1469,6 +1469,88 @@ GST_START_TEST (test_map_tag)
 
 GST_END_TEST;
 
+static gchar *
+generate_live_playlist (guint first, guint n_files, gboolean with_sequence)
+{
+  GString *str;
+  guint i;
+
+  str = g_string_new ("#EXTM3U\n#EXT-X-TARGETDURATION:2\n");
+  if (with_sequence)
+    g_string_append_printf (str, "#EXT-X-MEDIA-SEQUENCE:%u\n", first);
+  for (i = first; i < first + n_files; i++)
+    g_string_append_printf (str, "#EXTINF:2,\nhttp://example.com/%u.ts\n", i);
+
+  return g_string_free (str, FALSE);
+}
+
+GST_START_TEST (test_large_live_playlist)
+{
+  GstM3U8 *pl;
+  GstM3U8MediaFile *file;
+  GList *l;
+  GstClockTime start;
+  gint64 range_start, range_stop;
+
+  pl = gst_m3u8_new ();
+  fail_unless (gst_m3u8_update (pl, generate_live_playlist (1000, 20000,
+              TRUE)));
+  assert_equals_int (pl->file_index->len, 20000);
+
+  /* lookups by position */
+  l = gst_m3u8_find_file_by_position (pl, 3001 * GST_SECOND, &start);
+  file = GST_M3U8_MEDIA_FILE (l->data);
+  assert_equals_int64 (file->sequence, 2500);
+  assert_equals_uint64 (start, 3000 * GST_SECOND);
+  l = gst_m3u8_find_file_by_position (pl, 3000 * GST_SECOND, &start);
+  assert_equals_int64 (GST_M3U8_MEDIA_FILE (l->data)->sequence, 2500);
+  l = gst_m3u8_find_file_by_position (pl, 0, &start);
+  assert_equals_int64 (GST_M3U8_MEDIA_FILE (l->data)->sequence, 1000);
+  assert_equals_uint64 (start, 0);
+  l = gst_m3u8_find_file_by_position (pl, 50000 * GST_SECOND, &start);
+  assert_equals_int64 (GST_M3U8_MEDIA_FILE (l->data)->sequence, 20999);
+  assert_equals_uint64 (start, 39998 * GST_SECOND);
+
+  fail_unless (gst_m3u8_get_seek_range (pl, &range_start, &range_stop));
+  assert_equals_int64 (range_stop - range_start,
+      (20000 - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE) * 2 * GST_SECOND);
+
+  /* lookups by sequence */
+  assert_equals_int64 (pl->sequence, 20996);
+  pl->sequence = 12345;
+  pl->current_file = NULL;
+  file = gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL);
+  assert_equals_int64 (file->sequence, 12345);
+  gst_m3u8_media_file_unref (file);
+
+  /* sliding window, the current file is looked up again */
+  fail_unless (gst_m3u8_update (pl, generate_live_playlist (1010, 20000,
+              TRUE)));
+  assert_equals_int (pl->file_index->len, 20000);
+  gst_m3u8_advance_fragment (pl, TRUE);
+  assert_equals_int64 (pl->sequence, 12346);
+  file = GST_M3U8_MEDIA_FILE (pl->current_file->data);
+  assert_equals_int64 (file->sequence, 12346);
+  assert_equals_string (file->uri, "http://example.com/12346.ts");
+
+  gst_m3u8_unref (pl);
+
+  /* Without MEDIA-SEQUENCE, numbers are generated by matching URIs */
+  pl = gst_m3u8_new ();
+  fail_unless (gst_m3u8_update (pl, generate_live_playlist (0, 20000, FALSE)));
+  fail_unless (gst_m3u8_update (pl, generate_live_playlist (30, 20000,
+              FALSE)));
+  l = gst_m3u8_find_file_by_position (pl, 0, NULL);
+  file = GST_M3U8_MEDIA_FILE (l->data);
+  assert_equals_int64 (file->sequence, 30);
+  assert_equals_string (file->uri, "http://example.com/30.ts");
+  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  assert_equals_int64 (file->sequence, 20029);
+  gst_m3u8_unref (pl);
+}
+
+GST_END_TEST;
+
 static Suite *
 hlsdemux_suite (void)
 {
@@ -1501,6 +1583,7 @@ hlsdemux_suite (void)
   tcase_add_test (tc_m3u8, test_get_duration);
   tcase_add_test (tc_m3u8, test_get_target_duration);
   tcase_add_test (tc_m3u8, test_get_stream_for_bitrate);
+  tcase_add_test (tc_m3u8, test_large_live_playlist);
 #if 0
   tcase_add_test (tc_m3u8, test_seek);
   tcase_add_test (tc_m3u8, test_alternate_audio_playlist);
@@ -0,0 +1,161 @@
+/* GStreamer
+ *
+ * Unit tests for the inter elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#define VIDEO_CAPS "video/x-raw,format=GRAY8,width=64,height=48,framerate=200/1"
+
+#define N_WRITERS 2
+#define N_READERS 3
+
+static void
+count_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gint * count)
+{
+  g_atomic_int_inc (count);
+}
+
+static GstElement *
+create_writer (const gchar * channel, gint pattern)
+{
+  GstElement *pipeline;
+  gchar *desc;
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=400 pattern=%d ! "
+      VIDEO_CAPS " ! intervideosink channel=%s sync=false", pattern, channel);
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (desc);
+
+  return pipeline;
+}
+
+static GstElement *
+create_reader (const gchar * channel, gint * count)
+{
+  GstElement *pipeline, *sink;
+  gchar *desc;
+
+  desc = g_strdup_printf ("intervideosrc channel=%s ! " VIDEO_CAPS
+      " ! fakesink name=sink sync=false signal-handoffs=true", channel);
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (desc);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (count_handoff), count);
+  gst_object_unref (sink);
+
+  return pipeline;
+}
+
+static void
+wait_for_eos (GstElement * pipeline)
+{
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *msg;
+
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+}
+
+/* Several sinks publishing to the same channel while several sources read
+ * from it. Frames replaced by one sink must only be freed once, and every
+ * source must keep getting frames */
+GST_START_TEST (test_video_concurrent_writers_and_readers)
+{
+  GstElement *writers[N_WRITERS], *readers[N_READERS];
+  gint counts[N_READERS] = { 0, };
+  gint i;
+
+  for (i = 0; i < N_READERS; i++) {
+    readers[i] = create_reader ("concurrent", &counts[i]);
+    fail_unless (gst_element_set_state (readers[i], GST_STATE_PLAYING) !=
+        GST_STATE_CHANGE_FAILURE);
+  }
+
+  for (i = 0; i < N_WRITERS; i++) {
+    writers[i] = create_writer ("concurrent", i);
+    fail_unless (gst_element_set_state (writers[i], GST_STATE_PLAYING) !=
+        GST_STATE_CHANGE_FAILURE);
+  }
+
+  for (i = 0; i < N_WRITERS; i++) {
+    wait_for_eos (writers[i]);
+    gst_element_set_state (writers[i], GST_STATE_NULL);
+    gst_object_unref (writers[i]);
+  }
+
+  for (i = 0; i < N_READERS; i++) {
+    gst_element_set_state (readers[i], GST_STATE_NULL);
+    gst_object_unref (readers[i]);
+    fail_unless (g_atomic_int_get (&counts[i]) > 0);
+  }
+}
+
+GST_END_TEST;
+
+/* Sources coming and going while a sink publishes, so that readers get
+ * (un)registered while items are being retired */
+GST_START_TEST (test_video_readers_come_and_go)
+{
+  GstElement *writer, *reader;
+  gint count = 0;
+  gint i;
+
+  writer = create_writer ("come-and-go", 0);
+  fail_unless (gst_element_set_state (writer, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  for (i = 0; i < 20; i++) {
+    reader = create_reader ("come-and-go", &count);
+    fail_unless (gst_element_set_state (reader, GST_STATE_PLAYING) !=
+        GST_STATE_CHANGE_FAILURE);
+    g_usleep (10 * G_TIME_SPAN_MILLISECOND);
+    gst_element_set_state (reader, GST_STATE_NULL);
+    gst_object_unref (reader);
+  }
+
+  wait_for_eos (writer);
+  gst_element_set_state (writer, GST_STATE_NULL);
+  gst_object_unref (writer);
+
+  fail_unless (count > 0);
+}
+
+GST_END_TEST;
+
+static Suite *
+inter_suite (void)
+{
+  Suite *s = suite_create ("inter");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_video_concurrent_writers_and_readers);
+  tcase_add_test (tc_chain, test_video_readers_come_and_go);
+
+  return s;
+}
+
+GST_CHECK_MAIN (inter);
@@ -0,0 +1,364 @@
+/* GStreamer
+ *
+ * Unit tests for the ipcpipeline zero-copy mode
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <glib/gstdio.h>
+#include <gst/check/gstcheck.h>
+#include <gst/allocators/allocators.h>
+
+#define BUFFER_SIZE 4096
+#define N_BUFFERS 8
+
+typedef struct
+{
+  GstElement *master;
+  GstElement *slave;
+  GstElement *appsrc;
+  GstElement *ipcsink;
+  gint fds[4];
+
+  gint n_received;
+  gint n_fd_memory;
+  gint n_released;
+} TestData;
+
+static guint8
+pattern (gint buffer, gsize i)
+{
+  return (guint8) (buffer * 31 + i);
+}
+
+static void
+on_handoff (GstElement * fakesink, GstBuffer * buffer, GstPad * pad,
+    TestData * data)
+{
+  GstMapInfo map;
+  gint n = g_atomic_int_get (&data->n_received);
+  gsize i;
+
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer), n * GST_MSECOND);
+  fail_unless_equals_int (gst_buffer_n_memory (buffer), 1);
+  if (gst_is_fd_memory (gst_buffer_peek_memory (buffer, 0)))
+    g_atomic_int_inc (&data->n_fd_memory);
+
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.size, BUFFER_SIZE);
+  for (i = 0; i < map.size; i++)
+    fail_unless_equals_int (map.data[i], pattern (n, i));
+  gst_buffer_unmap (buffer, &map);
+
+  g_atomic_int_inc (&data->n_received);
+}
+
+static void
+on_buffer_finalized (TestData * data, GstMiniObject * buffer)
+{
+  g_atomic_int_inc (&data->n_released);
+}
+
+/* Links an ipcpipelinesink in a master pipeline to an ipcpipelinesrc in a
+ * slave pipeline of the same process. With @use_socket, both directions
+ * use a UNIX socket pair, otherwise each direction is a plain pipe, which
+ * can't carry file descriptors */
+static void
+setup_pipelines (TestData * data, gboolean use_socket)
+{
+  GstElement *ipcsrc, *fakesink;
+  GstCaps *caps;
+  gint sinkin, sinkout, srcin, srcout;
+
+  memset (data, 0, sizeof (TestData));
+
+  if (use_socket) {
+    fail_if (socketpair (AF_UNIX, SOCK_STREAM, 0, data->fds) < 0);
+    data->fds[2] = data->fds[3] = -1;
+    sinkin = sinkout = data->fds[0];
+    srcin = srcout = data->fds[1];
+  } else {
+    fail_if (pipe (data->fds) < 0);
+    fail_if (pipe (data->fds + 2) < 0);
+    srcin = data->fds[0];
+    sinkout = data->fds[1];
+    sinkin = data->fds[2];
+    srcout = data->fds[3];
+  }
+
+  data->master = gst_pipeline_new ("master");
+  data->appsrc = gst_element_factory_make ("appsrc", NULL);
+  fail_unless (data->appsrc != NULL);
+  caps = gst_caps_new_empty_simple ("application/x-test");
+  g_object_set (data->appsrc, "format", GST_FORMAT_TIME, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  data->ipcsink = gst_element_factory_make ("ipcpipelinesink", NULL);
+  fail_unless (data->ipcsink != NULL);
+  g_object_set (data->ipcsink, "fdin", sinkin, "fdout", sinkout,
+      "zero-copy", TRUE, NULL);
+  gst_bin_add_many (GST_BIN (data->master), data->appsrc, data->ipcsink,
+      NULL);
+  fail_unless (gst_element_link (data->appsrc, data->ipcsink));
+
+  data->slave = gst_element_factory_make ("ipcslavepipeline", NULL);
+  fail_unless (data->slave != NULL);
+  ipcsrc = gst_element_factory_make ("ipcpipelinesrc", NULL);
+  g_object_set (ipcsrc, "fdin", srcin, "fdout", srcout, NULL);
+  fakesink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (fakesink, "sync", FALSE, "signal-handoffs", TRUE,
+      "enable-last-sample", FALSE, NULL);
+  g_signal_connect (fakesink, "handoff", G_CALLBACK (on_handoff), data);
+  gst_bin_add_many (GST_BIN (data->slave), ipcsrc, fakesink, NULL);
+  fail_unless (gst_element_link (ipcsrc, fakesink));
+}
+
+static void
+teardown_pipelines (TestData * data)
+{
+  gint i;
+
+  gst_element_set_state (data->master, GST_STATE_NULL);
+  gst_element_set_state (data->slave, GST_STATE_NULL);
+  g_signal_emit_by_name (data->ipcsink, "disconnect", NULL);
+  gst_object_unref (data->master);
+  gst_object_unref (data->slave);
+
+  for (i = 0; i < 4; i++) {
+    if (data->fds[i] >= 0)
+      close (data->fds[i]);
+  }
+}
+
+static GstAllocator *
+query_allocator (TestData * data)
+{
+  GstAllocator *allocator = NULL;
+  GstQuery *query;
+  GstPad *pad;
+
+  pad = gst_element_get_static_pad (data->ipcsink, "sink");
+  query = gst_query_new_allocation (NULL, TRUE);
+  fail_unless (gst_pad_query (pad, query));
+  fail_unless (gst_query_get_n_allocation_params (query) > 0);
+  gst_query_parse_nth_allocation_param (query, 0, &allocator, NULL);
+  fail_unless (GST_IS_FD_ALLOCATOR (allocator));
+  gst_query_unref (query);
+  gst_object_unref (pad);
+
+  return allocator;
+}
+
+/* Memory on a temporary file, which can't be sealed against truncation */
+static GstBuffer *
+new_unsealed_buffer (GstAllocator * fd_allocator)
+{
+  GstBuffer *buffer;
+  GstMemory *mem;
+  gchar *filename;
+  gint fd;
+
+  fd = g_file_open_tmp (NULL, &filename, NULL);
+  fail_if (fd < 0);
+  g_unlink (filename);
+  g_free (filename);
+  fail_if (ftruncate (fd, BUFFER_SIZE) < 0);
+  mem = gst_fd_allocator_alloc (fd_allocator, fd, BUFFER_SIZE,
+      GST_FD_MEMORY_FLAG_NONE);
+  fail_unless (mem != NULL);
+
+  buffer = gst_buffer_new ();
+  gst_buffer_append_memory (buffer, mem);
+
+  return buffer;
+}
+
+/* Pushes buffers allocated from @allocator, or from unsealed files if
+ * @allocator is a plain #GstFdAllocator */
+static void
+push_buffers (TestData * data, GstAllocator * allocator)
+{
+  GstFlowReturn flow;
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gint i;
+  gsize j;
+
+  for (i = 0; i < N_BUFFERS; i++) {
+    if (G_OBJECT_TYPE (allocator) == GST_TYPE_FD_ALLOCATOR)
+      buffer = new_unsealed_buffer (allocator);
+    else
+      buffer = gst_buffer_new_allocate (allocator, BUFFER_SIZE, NULL);
+    fail_unless (gst_buffer_map (buffer, &map, GST_MAP_WRITE));
+    for (j = 0; j < map.size; j++)
+      map.data[j] = pattern (i, j);
+    gst_buffer_unmap (buffer, &map);
+    GST_BUFFER_PTS (buffer) = i * GST_MSECOND;
+    gst_mini_object_weak_ref (GST_MINI_OBJECT_CAST (buffer),
+        (GstMiniObjectNotify) on_buffer_finalized, data);
+
+    g_signal_emit_by_name (data->appsrc, "push-buffer", buffer, &flow);
+    fail_unless_equals_int (flow, GST_FLOW_OK);
+    gst_buffer_unref (buffer);
+  }
+  g_signal_emit_by_name (data->appsrc, "end-of-stream", &flow);
+}
+
+static void
+wait_for_count (gint * count, gint expected)
+{
+  gint64 deadline = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+
+  while (g_atomic_int_get (count) < expected &&
+      g_get_monotonic_time () < deadline)
+    g_usleep (G_TIME_SPAN_MILLISECOND);
+  fail_unless_equals_int (g_atomic_int_get (count), expected);
+}
+
+GST_START_TEST (test_zero_copy_socketpair)
+{
+  TestData data;
+  GstAllocator *allocator;
+  gboolean zero_copy;
+
+  setup_pipelines (&data, TRUE);
+
+  allocator = query_allocator (&data);
+  gst_element_set_state (data.master, GST_STATE_PLAYING);
+  push_buffers (&data, allocator);
+
+  /* The slave gets the very memory we filled, and once it's done with it
+   * the sink lets go of the buffers */
+  wait_for_count (&data.n_received, N_BUFFERS);
+  fail_unless_equals_int (g_atomic_int_get (&data.n_fd_memory), N_BUFFERS);
+  wait_for_count (&data.n_released, N_BUFFERS);
+
+  g_object_get (data.ipcsink, "zero-copy", &zero_copy, NULL);
+  fail_unless (zero_copy);
+
+  gst_object_unref (allocator);
+  teardown_pipelines (&data);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_zero_copy_pipe_fallback)
+{
+  TestData data;
+  GstAllocator *allocator;
+  gboolean zero_copy;
+
+  setup_pipelines (&data, FALSE);
+
+  allocator = query_allocator (&data);
+  gst_element_set_state (data.master, GST_STATE_PLAYING);
+  push_buffers (&data, allocator);
+
+  /* Pipes can't carry the fds, the contents are copied instead */
+  wait_for_count (&data.n_received, N_BUFFERS);
+  fail_unless_equals_int (g_atomic_int_get (&data.n_fd_memory), 0);
+  wait_for_count (&data.n_released, N_BUFFERS);
+
+  /* which doesn't change what the application asked for */
+  g_object_get (data.ipcsink, "zero-copy", &zero_copy, NULL);
+  fail_unless (zero_copy);
+
+  gst_object_unref (allocator);
+  teardown_pipelines (&data);
+}
+
+GST_END_TEST;
+
+/* Memories come back to the allocator once released and are handed out
+ * again, with the same memfd */
+GST_START_TEST (test_zero_copy_memory_reuse)
+{
+  TestData data;
+  GstAllocator *allocator;
+  GstMemory *mem;
+  gint fd;
+
+  setup_pipelines (&data, TRUE);
+
+  allocator = query_allocator (&data);
+
+  mem = gst_allocator_alloc (allocator, BUFFER_SIZE, NULL);
+  fail_unless (mem != NULL);
+  fd = gst_fd_memory_get_fd (mem);
+  gst_memory_unref (mem);
+
+  mem = gst_allocator_alloc (allocator, BUFFER_SIZE / 2, NULL);
+  fail_unless_equals_int (gst_fd_memory_get_fd (mem), fd);
+  fail_unless_equals_int (mem->size, BUFFER_SIZE / 2);
+  gst_memory_unref (mem);
+
+  /* Too small for this one */
+  mem = gst_allocator_alloc (allocator, 2 * BUFFER_SIZE, NULL);
+  fail_if (gst_fd_memory_get_fd (mem) == fd);
+  fail_unless_equals_int (mem->size, 2 * BUFFER_SIZE);
+  gst_memory_unref (mem);
+
+  gst_object_unref (allocator);
+  teardown_pipelines (&data);
+}
+
+GST_END_TEST;
+
+/* The peer could truncate memory that isn't sealed and crash the slave
+ * when it's mapped, so it's copied instead */
+GST_START_TEST (test_zero_copy_unsealed_fd)
+{
+  TestData data;
+  GstAllocator *allocator;
+
+  setup_pipelines (&data, TRUE);
+
+  allocator = gst_fd_allocator_new ();
+  gst_element_set_state (data.master, GST_STATE_PLAYING);
+  push_buffers (&data, allocator);
+
+  wait_for_count (&data.n_received, N_BUFFERS);
+  fail_unless_equals_int (g_atomic_int_get (&data.n_fd_memory), 0);
+  wait_for_count (&data.n_released, N_BUFFERS);
+
+  gst_object_unref (allocator);
+  teardown_pipelines (&data);
+}
+
+GST_END_TEST;
+
+static Suite *
+ipcpipeline_suite (void)
+{
+  Suite *s = suite_create ("ipcpipeline");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_zero_copy_socketpair);
+  tcase_add_test (tc_chain, test_zero_copy_pipe_fallback);
+  tcase_add_test (tc_chain, test_zero_copy_memory_reuse);
+  tcase_add_test (tc_chain, test_zero_copy_unsealed_fd);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ipcpipeline);
@@ -22,6 +22,9 @@
 #include <gst/check/gstcheck.h>
 #include <gst/check/gstharness.h>
 
+#include <glib/gstdio.h>
+#include <string.h>
+
 #define PACKETSIZE 188
 
 /* Output of the following pipeline, split into standard 188-bytes packets:
@@ -335,6 +338,95 @@ GST_START_TEST (test_tsparse_padding)
 
 GST_END_TEST;
 
+/* Helpers to generate streams that don't fit in a static array */
+static guint32
+ts_crc32 (const guint8 * data, gsize size)
+{
+  guint32 crc = 0xffffffff;
+  gsize i;
+  gint j;
+
+  for (i = 0; i < size; i++) {
+    crc ^= (guint32) data[i] << 24;
+    for (j = 0; j < 8; j++)
+      crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+  }
+
+  return crc;
+}
+
+/* Writes a TS packet carrying @size bytes of @payload. An adaptation field
+ * with the 6 bytes of @pcr (if not NULL) and the random_access_indicator
+ * is added if needed, and used for stuffing if @size is smaller than the
+ * available space */
+static void
+write_ts_packet (guint8 * out, guint16 pid, gboolean start, guint8 cc,
+    gboolean random_access, const guint8 * pcr, const guint8 * payload,
+    guint size)
+{
+  guint af_size = 0;
+
+  if (pcr || random_access || size < PACKETSIZE - 4)
+    af_size = PACKETSIZE - 4 - size;
+  g_assert (pcr == NULL || af_size >= 8);
+  g_assert (!random_access || af_size >= 2);
+
+  out[0] = 0x47;
+  out[1] = (start ? 0x40 : 0x00) | (pid >> 8);
+  out[2] = pid & 0xff;
+  out[3] = (af_size ? 0x30 : 0x10) | (cc & 0x0f);
+
+  if (af_size) {
+    out[4] = af_size - 1;
+    if (af_size > 1) {
+      out[5] = (random_access ? 0x40 : 0x00) | (pcr ? 0x10 : 0x00);
+      memset (out + 6, 0xff, af_size - 2);
+      if (pcr)
+        memcpy (out + 6, pcr, 6);
+    }
+  }
+
+  memcpy (out + 4 + af_size, payload, size);
+}
+
+/* Writes a TS packet carrying a PMT for one stream of @stream_type on
+ * @pid, which also carries the PCR */
+static void
+write_pmt_packet (guint8 * out, guint16 pmt_pid, guint8 stream_type,
+    guint16 pid)
+{
+  guint8 payload[PACKETSIZE - 4];
+  guint8 *section = payload + 1;
+  guint32 crc;
+
+  memset (payload, 0xff, sizeof payload);
+  payload[0] = 0;               /* pointer_field */
+
+  section[0] = 0x02;
+  section[1] = 0xb0;
+  section[2] = 18;              /* section_length */
+  section[3] = 0x00;            /* program_number */
+  section[4] = 0x01;
+  section[5] = 0xc1;
+  section[6] = 0x00;
+  section[7] = 0x00;
+  section[8] = 0xe0 | (pid >> 8);       /* PCR_PID */
+  section[9] = pid & 0xff;
+  section[10] = 0xf0;           /* program_info_length */
+  section[11] = 0x00;
+  section[12] = stream_type;
+  section[13] = 0xe0 | (pid >> 8);
+  section[14] = pid & 0xff;
+  section[15] = 0xf0;           /* ES_info_length */
+  section[16] = 0x00;
+
+  crc = ts_crc32 (section, 17);
+  GST_WRITE_UINT32_BE (section + 17, crc);
+
+  write_ts_packet (out, pmt_pid, TRUE, 0, FALSE, NULL, payload,
+      sizeof payload);
+}
+
 static void
 tsdemux_simple_pad_added (GstElement * tsdemux, GstPad * pad, GstHarness * h)
 {
@@ -377,6 +469,326 @@ GST_START_TEST (test_tsdemux_simple)
 
 GST_END_TEST;
 
+GST_START_TEST (test_tsdemux_zero_copy_pes)
+{
+  GstHarness *h = gst_harness_new_with_padnames ("tsdemux", "sink", NULL);
+  GstBuffer *buf;
+  GstCaps *caps;
+  GstSegment segment;
+  guint64 copied, referenced;
+
+  g_object_set (h->element, "zero-copy-pes", TRUE, NULL);
+
+  caps = gst_caps_from_string ("video/mpegts,systemstream=true");
+  gst_harness_push_event (h, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_harness_push_event (h, gst_event_new_segment (&segment));
+
+  gst_harness_set_sink_caps_str (h,
+      "audio/mpeg,mpegversion=4,stream-format=adts");
+
+  g_signal_connect (h->element, "pad-added",
+      G_CALLBACK (tsdemux_simple_pad_added), h);
+
+  buf =
+      gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, (guint8 *) aac_ts,
+      sizeof aac_ts, 0, sizeof aac_ts, NULL, NULL);
+  fail_unless (gst_harness_push (h, buf) == GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  /* Output must be identical to the copying mode */
+  buf = gst_harness_take_all_data_as_buffer (h);
+  gst_check_buffer_data (buf, aac_data, sizeof aac_data);
+  gst_buffer_unref (buf);
+
+  /* ADTS frames are parsed by tsdemux and therefore always copied */
+  g_object_get (h->element, "bytes-copied", &copied, "bytes-referenced",
+      &referenced, NULL);
+  fail_unless_equals_uint64 (copied, sizeof aac_data);
+  fail_unless_equals_uint64 (referenced, 0);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static void
+tsdemux_video_pad_added (GstElement * tsdemux, GstPad * pad, GstHarness * h)
+{
+  fail_unless (g_strcmp0 (GST_PAD_NAME (pad), "video_0_0041") == 0);
+  gst_harness_add_element_src_pad (h, pad);
+}
+
+#define VIDEO_PES_PACKETS 40
+
+GST_START_TEST (test_tsdemux_zero_copy_video_pes)
+{
+  GstHarness *h = gst_harness_new_with_padnames ("tsdemux", "sink", NULL);
+  /* PCR and PTS of the AAC stream above */
+  static const guint8 pcr[] = { 0x09, 0xa7, 0xd6, 0x87, 0x7e, 0x00 };
+  static const guint8 pes_header[] = {
+    0x00, 0x00, 0x01, 0xe0, 0x00, 0x00, 0x81, 0x80, 0x05, 0x21, 0x4d, 0x3f,
+    0xb2, 0x01
+  };
+  guint8 *ts, *es, *p;
+  gsize ts_size, es_size, offset = 0;
+  GstBuffer *buf;
+  GstCaps *caps;
+  GstSegment segment;
+  guint64 copied, referenced;
+  guint i, j, first_size;
+
+  g_object_set (h->element, "zero-copy-pes", TRUE, NULL);
+
+  /* PAT, PMT and one unbounded video PES spanning VIDEO_PES_PACKETS TS
+   * packets, more than the memories a single buffer can hold */
+  first_size = PACKETSIZE - 4 - 8 - sizeof pes_header;
+  es_size = first_size + (VIDEO_PES_PACKETS - 1) * (PACKETSIZE - 4);
+  es = g_malloc (es_size);
+  for (i = 0; i < es_size; i++)
+    es[i] = i % 251;
+
+  ts_size = (2 + VIDEO_PES_PACKETS) * PACKETSIZE;
+  p = ts = g_malloc (ts_size);
+
+  memcpy (p, aac_ts, PACKETSIZE);
+  p += PACKETSIZE;
+  write_pmt_packet (p, 0x20, 0x1b, 0x41);
+  p += PACKETSIZE;
+
+  {
+    guint8 payload[PACKETSIZE - 4];
+
+    memcpy (payload, pes_header, sizeof pes_header);
+    memcpy (payload + sizeof pes_header, es, first_size);
+    write_ts_packet (p, 0x41, TRUE, 0, FALSE, pcr, payload,
+        sizeof pes_header + first_size);
+    p += PACKETSIZE;
+  }
+
+  for (i = 1; i < VIDEO_PES_PACKETS; i++) {
+    write_ts_packet (p, 0x41, FALSE, i, FALSE, NULL,
+        es + first_size + (i - 1) * (PACKETSIZE - 4), PACKETSIZE - 4);
+    p += PACKETSIZE;
+  }
+
+  caps = gst_caps_from_string ("video/mpegts,systemstream=true");
+  gst_harness_push_event (h, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_harness_push_event (h, gst_event_new_segment (&segment));
+
+  gst_harness_set_sink_caps_str (h, "video/x-h264");
+
+  g_signal_connect (h->element, "pad-added",
+      G_CALLBACK (tsdemux_video_pad_added), h);
+
+  buf = gst_buffer_new_wrapped (ts, ts_size);
+  fail_unless (gst_harness_push (h, buf) == GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  /* The PES is output as a list of buffers with as many memories as
+   * possible, all of them pointing into the input */
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h),
+      (VIDEO_PES_PACKETS + gst_buffer_get_max_memory () - 1) /
+      gst_buffer_get_max_memory ());
+
+  for (i = 0; (buf = gst_harness_try_pull (h)); i++) {
+    if (i == 0)
+      fail_unless (GST_BUFFER_PTS_IS_VALID (buf));
+
+    for (j = 0; j < gst_buffer_n_memory (buf); j++) {
+      GstMemory *mem = gst_buffer_peek_memory (buf, j);
+      GstMapInfo info;
+
+      fail_unless (gst_memory_map (mem, &info, GST_MAP_READ));
+      fail_unless (info.data >= ts && info.data + info.size <= ts + ts_size);
+      fail_unless (offset + info.size <= es_size);
+      fail_unless (memcmp (info.data, es + offset, info.size) == 0);
+      offset += info.size;
+      gst_memory_unmap (mem, &info);
+    }
+    gst_buffer_unref (buf);
+  }
+  fail_unless_equals_uint64 (offset, es_size);
+
+  g_object_get (h->element, "bytes-copied", &copied, "bytes-referenced",
+      &referenced, NULL);
+  fail_unless_equals_uint64 (copied, 0);
+  fail_unless_equals_uint64 (referenced, es_size);
+
+  gst_harness_teardown (h);
+  g_free (es);
+}
+
+GST_END_TEST;
+
+#define INDEX_TEST_FRAMES 10
+
+typedef struct
+{
+  guint8 *data;
+  gsize size;
+  guint64 offset;
+  guint64 seek_offset;
+} IndexTestSource;
+
+/* Creates a stream with a PAT, a PMT and INDEX_TEST_FRAMES H.264 keyframes,
+ * one per second, each in a single TS packet also carrying a PCR */
+static guint8 *
+create_index_test_stream (gsize * size)
+{
+  guint8 *ts, *p;
+  guint i;
+
+  *size = (2 + INDEX_TEST_FRAMES) * PACKETSIZE;
+  p = ts = g_malloc (*size);
+
+  memcpy (p, aac_ts, PACKETSIZE);
+  p += PACKETSIZE;
+  write_pmt_packet (p, 0x20, 0x1b, 0x41);
+  p += PACKETSIZE;
+
+  for (i = 0; i < INDEX_TEST_FRAMES; i++) {
+    /* Start at 10s, with the PTS 100ms after the PCR */
+    guint64 pcr_base = 900000 + i * 90000;
+    guint64 pts = pcr_base + 9000;
+    guint8 pcr[6];
+    guint8 pes[14 + 16] = {
+      0x00, 0x00, 0x01, 0xe0, 0x00, 0x00, 0x81, 0x80, 0x05,
+    };
+
+    pcr[0] = pcr_base >> 25;
+    pcr[1] = pcr_base >> 17;
+    pcr[2] = pcr_base >> 9;
+    pcr[3] = pcr_base >> 1;
+    pcr[4] = ((pcr_base & 1) << 7) | 0x7e;
+    pcr[5] = 0;
+
+    pes[9] = 0x21 | ((pts >> 29) & 0x0e);
+    pes[10] = pts >> 22;
+    pes[11] = ((pts >> 14) & 0xfe) | 0x01;
+    pes[12] = pts >> 7;
+    pes[13] = ((pts << 1) & 0xfe) | 0x01;
+    memset (pes + 14, i, 16);
+
+    write_ts_packet (p, 0x41, TRUE, i, TRUE, pcr, pes, sizeof pes);
+    p += PACKETSIZE;
+  }
+
+  return ts;
+}
+
+static void
+index_test_need_data (GstElement * appsrc, guint length,
+    IndexTestSource * src)
+{
+  GstFlowReturn ret;
+
+  if (src->offset < src->size) {
+    GstBuffer *buf;
+    gsize size = src->size - src->offset;
+
+    buf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+        src->data + src->offset, size, 0, size, NULL, NULL);
+    src->offset = src->size;
+    g_signal_emit_by_name (appsrc, "push-buffer", buf, &ret);
+    gst_buffer_unref (buf);
+  }
+
+  g_signal_emit_by_name (appsrc, "end-of-stream", &ret);
+}
+
+static gboolean
+index_test_seek_data (GstElement * appsrc, guint64 offset,
+    IndexTestSource * src)
+{
+  src->offset = offset;
+  src->seek_offset = offset;
+  return TRUE;
+}
+
+static GstElement *
+index_test_pipeline_new (IndexTestSource * src, const gchar * location)
+{
+  GstElement *pipeline, *appsrc, *demux;
+
+  pipeline = gst_parse_launch ("appsrc name=src ! tsdemux name=demux "
+      "! fakesink sync=false", NULL);
+  fail_unless (pipeline != NULL);
+
+  appsrc = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  gst_util_set_object_arg (G_OBJECT (appsrc), "stream-type", "seekable");
+  g_object_set (appsrc, "size", (gint64) src->size, NULL);
+  g_signal_connect (appsrc, "need-data", G_CALLBACK (index_test_need_data),
+      src);
+  g_signal_connect (appsrc, "seek-data", G_CALLBACK (index_test_seek_data),
+      src);
+  gst_object_unref (appsrc);
+
+  demux = gst_bin_get_by_name (GST_BIN (pipeline), "demux");
+  g_object_set (demux, "index-location", location, NULL);
+  gst_object_unref (demux);
+
+  return pipeline;
+}
+
+GST_START_TEST (test_tsdemux_index_seek)
+{
+  IndexTestSource src = { NULL, };
+  GstElement *pipeline;
+  GstMessage *msg;
+  GstBus *bus;
+  gchar *location;
+  gint fd;
+
+  fd = g_file_open_tmp ("tsdemux-index-XXXXXX", &location, NULL);
+  fail_unless (fd >= 0);
+  g_close (fd, NULL);
+
+  src.data = create_index_test_stream (&src.size);
+
+  /* Demux the whole stream once to create the index */
+  pipeline = index_test_pipeline_new (&src, location);
+  bus = gst_element_get_bus (pipeline);
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  /* Seeking with the index goes straight to the keyframe preceding the
+   * seek position. Upstream can't seek in time, so tsdemux has to convert
+   * the position to an offset itself */
+  src.offset = 0;
+  pipeline = index_test_pipeline_new (&src, location);
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PAUSED) !=
+      GST_STATE_CHANGE_FAILURE);
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+
+  src.seek_offset = G_MAXUINT64;
+  fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH, 5500 * GST_MSECOND));
+  fail_unless_equals_uint64 (src.seek_offset, (2 + 5) * PACKETSIZE);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  g_unlink (location);
+  g_free (location);
+  g_free (src.data);
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegtsdemux_suite (void)
 {
@@ -394,6 +806,9 @@ mpegtsdemux_suite (void)
   tc = tcase_create ("tsdemux");
   suite_add_tcase (s, tc);
   tcase_add_test (tc, test_tsdemux_simple);
+  tcase_add_test (tc, test_tsdemux_zero_copy_pes);
+  tcase_add_test (tc, test_tsdemux_zero_copy_video_pes);
+  tcase_add_test (tc, test_tsdemux_index_seek);
 
   return s;
 }
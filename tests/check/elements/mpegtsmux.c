@@ -19,6 +19,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
 #include <string.h>
 #include <gst/video/video.h>
 
@@ -586,6 +587,89 @@ GST_START_TEST (test_keyframe_flag_propagation)
 
 GST_END_TEST;
 
+/* Muxes a fixed video stream and returns all the output. If @hold_output is
+ * TRUE, output buffers are only released at the end so none of them can be
+ * recycled while muxing, else they are released as soon as they are output
+ * and the muxer gets to reuse them */
+static GByteArray *
+mux_fixed_stream (gint alignment, gboolean hold_output)
+{
+  GstHarness *h;
+  GByteArray *output = g_byte_array_new ();
+  GstBuffer *buf;
+  GstEvent *event;
+  GstMapInfo map;
+  guint i;
+
+  h = gst_harness_new_with_padnames ("mpegtsmux", "sink_%d", "src");
+  g_object_set (h->element, "alignment", alignment, NULL);
+  gst_harness_set_src_caps_str (h, VIDEO_CAPS_STRING);
+
+  for (i = 0; i < 100; i++) {
+    gsize size = 100 + (i * 997) % 5000;
+
+    buf = gst_buffer_new_and_alloc (size);
+    gst_buffer_memset (buf, 0, i, size);
+    GST_BUFFER_PTS (buf) = GST_BUFFER_DTS (buf) = i * 40 * GST_MSECOND;
+    if (i % KEYFRAME_DISTANCE != 0)
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+    while (!hold_output && (buf = gst_harness_try_pull (h))) {
+      gst_buffer_map (buf, &map, GST_MAP_READ);
+      g_byte_array_append (output, map.data, map.size);
+      gst_buffer_unmap (buf, &map);
+      gst_buffer_unref (buf);
+    }
+  }
+
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+  while ((event = gst_harness_pull_event (h))) {
+    GstEventType type = GST_EVENT_TYPE (event);
+
+    gst_event_unref (event);
+    if (type == GST_EVENT_EOS)
+      break;
+  }
+
+  while ((buf = gst_harness_try_pull (h))) {
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    g_byte_array_append (output, map.data, map.size);
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (h);
+
+  return output;
+}
+
+GST_START_TEST (test_recycled_buffers_output)
+{
+  GByteArray *reference, *output;
+
+  /* Packets and aligned output units come from buffer pools. Recycling
+   * them must not change the output, whether the packets are pushed one
+   * by one or gathered into aligned units */
+  reference = mux_fixed_stream (7, TRUE);
+  fail_unless (reference->len > 0);
+  fail_unless_equals_int (reference->len % 188, 0);
+
+  output = mux_fixed_stream (7, FALSE);
+  fail_unless_equals_int (output->len, reference->len);
+  fail_unless (memcmp (output->data, reference->data, reference->len) == 0);
+  g_byte_array_unref (output);
+
+  output = mux_fixed_stream (1, FALSE);
+  fail_unless (output->len <= reference->len);
+  fail_unless (memcmp (output->data, reference->data, output->len) == 0);
+  g_byte_array_unref (output);
+
+  g_byte_array_unref (reference);
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegtsmux_suite (void)
 {
@@ -602,6 +686,7 @@ mpegtsmux_suite (void)
   tcase_add_test (tc_chain, test_reappearing_pad_while_playing);
   tcase_add_test (tc_chain, test_reappearing_pad_while_stopped);
   tcase_add_test (tc_chain, test_unused_pad);
+  tcase_add_test (tc_chain, test_recycled_buffers_output);
 
   return s;
 }
@@ -1,6 +1,9 @@
 #include <gst/check/gstharness.h>
 #include <gst/check/gstcheck.h>
 
+#include <glib/gstdio.h>
+#include <unistd.h>
+
 GST_START_TEST (netsim_stress)
 {
   GstHarness *h = gst_harness_new ("netsim");
@@ -49,6 +52,153 @@ GST_START_TEST (netsim_stress_delayed)
 
 GST_END_TEST;
 
+GST_START_TEST (netsim_no_reordering)
+{
+  GstHarness *h = gst_harness_new_parse ("netsim delay-probability=0.5 "
+      "min-delay=1 max-delay=20 allow-reordering=false");
+  guint i;
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  for (i = 0; i < 100; i++) {
+    GstBuffer *buf = gst_harness_create_buffer (h, 100);
+    GST_BUFFER_OFFSET (buf) = i;
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+
+  for (i = 0; i < 100; i++) {
+    GstBuffer *buf = gst_harness_pull (h);
+    fail_unless (buf != NULL);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buf), i);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* Delays longer than the 1024 ms the timer wheel covers */
+GST_START_TEST (netsim_long_delays)
+{
+  GstHarness *h = gst_harness_new_parse ("netsim delay-probability=1.0 "
+      "min-delay=1 max-delay=1500 allow-reordering=false");
+  guint i;
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  for (i = 0; i < 50; i++) {
+    GstBuffer *buf = gst_harness_create_buffer (h, 100);
+    GST_BUFFER_OFFSET (buf) = i;
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+
+  for (i = 0; i < 50; i++) {
+    GstBuffer *buf = gst_harness_pull (h);
+    fail_unless (buf != NULL);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buf), i);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (netsim_gilbert_elliott)
+{
+  GstHarness *h;
+  guint i;
+
+  /* always switching state, so every other buffer is in the bad state */
+  h = gst_harness_new_parse ("netsim gilbert-elliott-p=1.0 "
+      "gilbert-elliott-r=1.0 gilbert-elliott-good-loss=0.0 "
+      "gilbert-elliott-bad-loss=1.0");
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  for (i = 0; i < 10; i++)
+    fail_unless_equals_int (gst_harness_push (h,
+            gst_harness_create_buffer (h, 100)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (h), 5);
+  gst_harness_teardown (h);
+
+  /* never leaving the bad state */
+  h = gst_harness_new_parse ("netsim gilbert-elliott-p=1.0 "
+      "gilbert-elliott-r=0.0");
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  for (i = 0; i < 10; i++)
+    fail_unless_equals_int (gst_harness_push (h,
+            gst_harness_create_buffer (h, 100)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (h), 0);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static GstHarness *
+create_trace_harness (const gchar * trace, gchar ** filename)
+{
+  GstHarness *h;
+  GError *err = NULL;
+  gchar *launch;
+  gint fd;
+
+  fd = g_file_open_tmp ("netsim-trace-XXXXXX", filename, &err);
+  fail_unless (fd != -1, "%s", err ? err->message : "");
+  close (fd);
+  fail_unless (g_file_set_contents (*filename, trace, -1, NULL));
+
+  /* the trace is loaded when activating */
+  launch = g_strdup_printf ("netsim trace-file=\"%s\"", *filename);
+  h = gst_harness_new_parse (launch);
+  g_free (launch);
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  return h;
+}
+
+GST_START_TEST (netsim_trace)
+{
+  GstHarness *h;
+  gchar *filename;
+  guint i;
+
+  /* one delivery opportunity every millisecond, and 5 ms of delay */
+  h = create_trace_harness ("# comment\n1 5\n", &filename);
+
+  for (i = 0; i < 10; i++) {
+    GstBuffer *buf = gst_harness_create_buffer (h, 1000);
+    GST_BUFFER_OFFSET (buf) = i;
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+
+  for (i = 0; i < 10; i++) {
+    GstBuffer *buf = gst_harness_pull (h);
+    fail_unless (buf != NULL);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buf), i);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (h);
+  g_unlink (filename);
+  g_free (filename);
+
+  /* everything is lost */
+  h = create_trace_harness ("1 0 1.0\n", &filename);
+
+  for (i = 0; i < 10; i++)
+    fail_unless_equals_int (gst_harness_push (h,
+            gst_harness_create_buffer (h, 100)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (h), 0);
+
+  gst_harness_teardown (h);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
 static Suite *
 netsim_suite (void)
 {
@@ -58,6 +208,10 @@ netsim_suite (void)
   suite_add_tcase (s, (tc_chain = tcase_create ("general")));
   tcase_add_test (tc_chain, netsim_stress);
   tcase_add_test (tc_chain, netsim_stress_delayed);
+  tcase_add_test (tc_chain, netsim_no_reordering);
+  tcase_add_test (tc_chain, netsim_long_delays);
+  tcase_add_test (tc_chain, netsim_gilbert_elliott);
+  tcase_add_test (tc_chain, netsim_trace);
 
   return s;
 }
@@ -0,0 +1,310 @@
+/* GStreamer
+ *
+ * Unit tests for the OpenJPEG encoder and decoder
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+
+#define WIDTH 64
+#define HEIGHT 64
+#define N_FRAMES 16
+#define FRAME_DURATION (GST_SECOND / 25)
+
+#define VIDEO_CAPS_FORMAT "video/x-raw,format=GRAY8,width=%d,height=%d," \
+    "framerate=25/1"
+
+static guint8
+pattern (gint frame, gint x, gint y)
+{
+  return (guint8) (frame * 16 + x + y * 2);
+}
+
+static GstBuffer *
+create_frame (gint n, gint width, gint height)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gint x, y;
+
+  /* GRAY8 rows are padded to 4 bytes */
+  buffer = gst_buffer_new_allocate (NULL, GST_ROUND_UP_4 (width) * height,
+      NULL);
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_WRITE));
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < GST_ROUND_UP_4 (width); x++)
+      map.data[y * GST_ROUND_UP_4 (width) + x] = pattern (n, x, y);
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_PTS (buffer) = n * FRAME_DURATION;
+  GST_BUFFER_DURATION (buffer) = FRAME_DURATION;
+
+  return buffer;
+}
+
+static GstHarness *
+setup_encoder (gint num_threads, gint num_stripes, gint width, gint height)
+{
+  GstHarness *h = gst_harness_new ("openjpegenc");
+  gchar *caps;
+
+  g_object_set (h->element, "num-threads", num_threads,
+      "num-stripes", num_stripes, NULL);
+
+  caps = g_strdup_printf (VIDEO_CAPS_FORMAT, width, height);
+  gst_harness_set_src_caps_str (h, caps);
+  g_free (caps);
+  gst_harness_set_sink_caps_str (h, "image/x-j2c");
+
+  return h;
+}
+
+/* Encodes @n_frames and returns the output buffers once drained */
+static GList *
+encode (GstHarness * h, gint n_frames)
+{
+  GList *buffers = NULL;
+  GstBuffer *buffer;
+  gint i;
+
+  for (i = 0; i < n_frames; i++)
+    fail_unless_equals_int (gst_harness_push (h, create_frame (i, WIDTH,
+                HEIGHT)), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  while ((buffer = gst_harness_try_pull (h)))
+    buffers = g_list_append (buffers, buffer);
+
+  return buffers;
+}
+
+static void
+assert_no_pending_frames (GstHarness * h)
+{
+  GList *frames = gst_video_encoder_get_frames (GST_VIDEO_ENCODER
+      (h->element));
+
+  fail_unless_equals_int (g_list_length (frames), 0);
+  g_list_free_full (frames, (GDestroyNotify) gst_video_codec_frame_unref);
+}
+
+static void
+assert_same_buffers (GList * a, GList * b)
+{
+  GstMapInfo map;
+
+  fail_unless_equals_int (g_list_length (a), g_list_length (b));
+  for (; a && b; a = a->next, b = b->next) {
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (a->data),
+        GST_BUFFER_PTS (b->data));
+    fail_unless (gst_buffer_map (b->data, &map, GST_MAP_READ));
+    fail_unless_equals_uint64 (gst_buffer_get_size (a->data), map.size);
+    fail_unless (gst_buffer_memcmp (a->data, 0, map.data, map.size) == 0);
+    gst_buffer_unmap (b->data, &map);
+  }
+}
+
+/* With a thread pool, frames are encoded in parallel but output in input
+ * order, with the same data as when encoded one after the other */
+GST_START_TEST (test_enc_threads_frame_order)
+{
+  GstHarness *h, *h_ref;
+  GList *buffers, *ref_buffers, *l;
+  gint i;
+
+  h_ref = setup_encoder (0, 1, WIDTH, HEIGHT);
+  ref_buffers = encode (h_ref, N_FRAMES);
+  fail_unless_equals_int (g_list_length (ref_buffers), N_FRAMES);
+
+  h = setup_encoder (4, 1, WIDTH, HEIGHT);
+  buffers = encode (h, N_FRAMES);
+
+  for (l = buffers, i = 0; l; l = l->next, i++)
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (l->data), i * FRAME_DURATION);
+  assert_same_buffers (buffers, ref_buffers);
+  assert_no_pending_frames (h);
+
+  g_list_free_full (buffers, (GDestroyNotify) gst_buffer_unref);
+  g_list_free_full (ref_buffers, (GDestroyNotify) gst_buffer_unref);
+  gst_harness_teardown (h);
+  gst_harness_teardown (h_ref);
+}
+
+GST_END_TEST;
+
+/* In stripe mode, all the stripes of a frame are output in order before
+ * the next frame, even when encoded in parallel */
+GST_START_TEST (test_enc_threads_stripes)
+{
+  GstHarness *h, *h_ref;
+  GList *buffers, *ref_buffers, *l;
+  GstCaps *caps;
+  GstStructure *s;
+  gint num_stripes;
+  gint i;
+
+  h_ref = setup_encoder (0, 4, WIDTH, HEIGHT);
+  ref_buffers = encode (h_ref, 4);
+
+  h = setup_encoder (4, 4, WIDTH, HEIGHT);
+  buffers = encode (h, 4);
+  fail_unless_equals_int (g_list_length (buffers), 4 * 4);
+
+  for (l = buffers, i = 0; l; l = l->next, i++)
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (l->data),
+        (i / 4) * FRAME_DURATION);
+  assert_same_buffers (buffers, ref_buffers);
+  assert_no_pending_frames (h);
+
+  caps = gst_pad_get_current_caps (h->sinkpad);
+  s = gst_caps_get_structure (caps, 0);
+  fail_unless_equals_string (gst_structure_get_string (s, "alignment"),
+      "stripe");
+  fail_unless (gst_structure_get_int (s, "num-stripes", &num_stripes));
+  fail_unless_equals_int (num_stripes, 4);
+  gst_caps_unref (caps);
+
+  g_list_free_full (buffers, (GDestroyNotify) gst_buffer_unref);
+  g_list_free_full (ref_buffers, (GDestroyNotify) gst_buffer_unref);
+  gst_harness_teardown (h);
+  gst_harness_teardown (h_ref);
+}
+
+GST_END_TEST;
+
+/* Frames following a failed one are still released, or output if they
+ * could be encoded */
+GST_START_TEST (test_enc_threads_error)
+{
+  GstHarness *h;
+  GstBuffer *buffer;
+  gint n_errors = 0, n_outputs = 0;
+  gint i;
+
+  /* An 8x8 image only has room for up to 4 resolution levels */
+  h = setup_encoder (2, 1, 8, 8);
+  g_object_set (h->element, "num-resolutions", 3, NULL);
+
+  for (i = 0; i < N_FRAMES; i++) {
+    g_object_set (h->element, "num-resolutions", i == 4 ? 6 : 3, NULL);
+    if (gst_harness_push (h, create_frame (i, 8, 8)) != GST_FLOW_OK)
+      n_errors++;
+  }
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  while ((buffer = gst_harness_try_pull (h))) {
+    n_outputs++;
+    gst_buffer_unref (buffer);
+  }
+
+  /* Only the failed frame and the ones finished along with it are lost */
+  fail_unless (n_errors > 0);
+  fail_unless (n_outputs < N_FRAMES);
+  fail_unless (n_outputs >= N_FRAMES - 1 - 2);
+  assert_no_pending_frames (h);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static GList *
+decode (GList * input, GstCaps * caps, gint num_threads)
+{
+  GstHarness *h = gst_harness_new ("openjpegdec");
+  GList *buffers = NULL, *l;
+  GstBuffer *buffer;
+
+  g_object_set (h->element, "num-threads", num_threads, NULL);
+  gst_harness_set_src_caps (h, gst_caps_ref (caps));
+
+  for (l = input; l; l = l->next)
+    fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (l->data)),
+        GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  while ((buffer = gst_harness_try_pull (h)))
+    buffers = g_list_append (buffers, buffer);
+
+  gst_harness_teardown (h);
+
+  return buffers;
+}
+
+/* Each stripe is decoded into its own rows of the output frame, which is
+ * output once complete, also when the stripes are decoded in parallel */
+GST_START_TEST (test_dec_stripes)
+{
+  GstHarness *h_enc;
+  GList *stripes, *buffers, *ref_buffers, *l;
+  GstBuffer *frame;
+  GstCaps *caps;
+  GstMapInfo map;
+  gint i;
+
+  h_enc = setup_encoder (0, 4, WIDTH, HEIGHT);
+  stripes = encode (h_enc, 4);
+  fail_unless_equals_int (g_list_length (stripes), 4 * 4);
+  caps = gst_pad_get_current_caps (h_enc->sinkpad);
+
+  ref_buffers = decode (stripes, caps, 0);
+  buffers = decode (stripes, caps, 4);
+  fail_unless_equals_int (g_list_length (buffers), 4);
+
+  /* Encoding is lossless by default */
+  for (l = buffers, i = 0; l; l = l->next, i++) {
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (l->data), i * FRAME_DURATION);
+    frame = create_frame (i, WIDTH, HEIGHT);
+    fail_unless (gst_buffer_map (frame, &map, GST_MAP_READ));
+    fail_unless_equals_uint64 (gst_buffer_get_size (l->data), map.size);
+    fail_unless (gst_buffer_memcmp (l->data, 0, map.data, map.size) == 0);
+    gst_buffer_unmap (frame, &map);
+    gst_buffer_unref (frame);
+  }
+  assert_same_buffers (buffers, ref_buffers);
+
+  g_list_free_full (buffers, (GDestroyNotify) gst_buffer_unref);
+  g_list_free_full (ref_buffers, (GDestroyNotify) gst_buffer_unref);
+  g_list_free_full (stripes, (GDestroyNotify) gst_buffer_unref);
+  gst_caps_unref (caps);
+  gst_harness_teardown (h_enc);
+}
+
+GST_END_TEST;
+
+static Suite *
+openjpeg_suite (void)
+{
+  Suite *s = suite_create ("openjpeg");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_enc_threads_frame_order);
+  tcase_add_test (tc_chain, test_enc_threads_stripes);
+  tcase_add_test (tc_chain, test_enc_threads_error);
+  tcase_add_test (tc_chain, test_dec_stripes);
+
+  return s;
+}
+
+GST_CHECK_MAIN (openjpeg);
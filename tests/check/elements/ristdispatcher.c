@@ -0,0 +1,334 @@
+/* GStreamer
+ *
+ * Unit tests for the ristdispatcher bonding dispatcher
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The statistics are fed through gst_rist_dispatcher_set_link_stats(),
+ * which is not exported by the plugin */
+#include "../../../gst/rist/gstristdispatcher.c"
+#include <gst/check/check.h>
+
+typedef struct
+{
+  GstHarness *h[2];
+} DispatcherHarness;
+
+static void
+setup_dispatcher_full (DispatcherHarness * dh, GstRistDispatcherMode mode,
+    const gchar * weights)
+{
+  GstElement *disp = g_object_new (GST_TYPE_RIST_DISPATCHER, "mode", mode,
+      "weights", weights, NULL);
+
+  dh->h[0] = gst_harness_new_with_element (disp, "sink", "src_0");
+  dh->h[1] = gst_harness_new_with_element (disp, NULL, "src_1");
+  gst_harness_set_src_caps_str (dh->h[0], "application/x-rtp");
+  gst_object_unref (disp);
+}
+
+static void
+setup_dispatcher (DispatcherHarness * dh, const gchar * weights)
+{
+  setup_dispatcher_full (dh, GST_RIST_DISPATCHER_MODE_WEIGHTED, weights);
+}
+
+/* Feeds a receiver report for the link, as ristsink does. All links
+ * receive the same sequence numbers, so each one loses the packets sent
+ * over the other */
+static void
+set_link_stats (DispatcherHarness * dh, guint link, GstClockTime rtt,
+    GstClockTime timestamp, guint32 ext_highest_seq, gint32 packets_lost)
+{
+  gst_rist_dispatcher_set_link_stats (GST_RIST_DISPATCHER (dh->h[0]->element),
+      link, rtt, timestamp, ext_highest_seq, packets_lost);
+}
+
+static void
+teardown_dispatcher (DispatcherHarness * dh)
+{
+  gst_harness_teardown (dh->h[1]);
+  gst_harness_teardown (dh->h[0]);
+}
+
+static GstBuffer *
+create_buffer (guint64 n)
+{
+  GstBuffer *buffer = gst_buffer_new ();
+
+  GST_BUFFER_OFFSET (buffer) = n;
+
+  return buffer;
+}
+
+static void
+push_buffers (DispatcherHarness * dh, guint n_buffers)
+{
+  guint i;
+
+  for (i = 0; i < n_buffers; i++)
+    fail_unless_equals_int (gst_harness_push (dh->h[0], create_buffer (i)),
+        GST_FLOW_OK);
+}
+
+static void
+push_list (DispatcherHarness * dh, guint n_buffers)
+{
+  GstBufferList *list = gst_buffer_list_new ();
+  guint i;
+
+  for (i = 0; i < n_buffers; i++)
+    gst_buffer_list_add (list, create_buffer (i));
+
+  fail_unless_equals_int (gst_pad_push_list (dh->h[0]->srcpad, list),
+      GST_FLOW_OK);
+}
+
+/* Checks that the buffers with the given offsets, and only those, were
+ * sent over the link */
+static void
+check_link (DispatcherHarness * dh, guint link, const guint64 * offsets,
+    guint n_offsets)
+{
+  GstBuffer *buffer;
+  guint i;
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (dh->h[link]),
+      n_offsets);
+  for (i = 0; i < n_offsets; i++) {
+    buffer = gst_harness_pull (dh->h[link]);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buffer), offsets[i]);
+    gst_buffer_unref (buffer);
+  }
+}
+
+static void
+drop_buffers (DispatcherHarness * dh, guint link, guint n_buffers)
+{
+  guint i;
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (dh->h[link]),
+      n_buffers);
+  for (i = 0; i < n_buffers; i++)
+    gst_buffer_unref (gst_harness_pull (dh->h[link]));
+}
+
+/* The links get their share in a smooth interleaving rather than in bursts
+ * of consecutive buffers */
+GST_START_TEST (test_smooth_weighted_round_robin)
+{
+  DispatcherHarness dh;
+  const guint64 link0[] = { 0, 1, 3, 4, 5, 7 };
+  const guint64 link1[] = { 2, 6 };
+
+  setup_dispatcher (&dh, "3,1");
+  push_buffers (&dh, 8);
+  check_link (&dh, 0, link0, G_N_ELEMENTS (link0));
+  check_link (&dh, 1, link1, G_N_ELEMENTS (link1));
+  teardown_dispatcher (&dh);
+}
+
+GST_END_TEST;
+
+/* Buffer lists are split in the same way as single buffers */
+GST_START_TEST (test_smooth_weighted_round_robin_list)
+{
+  DispatcherHarness dh;
+  const guint64 link0[] = { 0, 1, 3, 4, 5, 7 };
+  const guint64 link1[] = { 2, 6 };
+
+  setup_dispatcher (&dh, "3,1");
+  push_list (&dh, 8);
+  check_link (&dh, 0, link0, G_N_ELEMENTS (link0));
+  check_link (&dh, 1, link1, G_N_ELEMENTS (link1));
+  teardown_dispatcher (&dh);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_weights_parsing)
+{
+  DispatcherHarness dh;
+  const guint64 all[] = { 0, 1, 2, 3 };
+  const guint64 even[] = { 0, 2 };
+  const guint64 odd[] = { 1, 3 };
+  const guint64 two_thirds[] = { 0, 2, 3, 5 };
+  const guint64 one_third[] = { 1, 4 };
+  gchar *weights;
+
+  /* A weight of 0 disables the link */
+  setup_dispatcher (&dh, "0,1");
+  g_object_get (dh.h[0]->element, "weights", &weights, NULL);
+  fail_unless_equals_string (weights, "0,1");
+  g_free (weights);
+  push_buffers (&dh, 4);
+  check_link (&dh, 0, NULL, 0);
+  check_link (&dh, 1, all, G_N_ELEMENTS (all));
+  teardown_dispatcher (&dh);
+
+  /* Links without a weight get 1 */
+  setup_dispatcher (&dh, "2");
+  push_buffers (&dh, 6);
+  check_link (&dh, 0, two_thirds, G_N_ELEMENTS (two_thirds));
+  check_link (&dh, 1, one_third, G_N_ELEMENTS (one_third));
+  teardown_dispatcher (&dh);
+
+  /* Fractional weights are fine */
+  setup_dispatcher (&dh, "1.0,0.5");
+  push_buffers (&dh, 6);
+  check_link (&dh, 0, two_thirds, G_N_ELEMENTS (two_thirds));
+  check_link (&dh, 1, one_third, G_N_ELEMENTS (one_third));
+  teardown_dispatcher (&dh);
+
+  /* Invalid lists are ignored as a whole, all links get the same weight */
+  setup_dispatcher (&dh, "3,abc");
+  push_buffers (&dh, 4);
+  check_link (&dh, 0, even, G_N_ELEMENTS (even));
+  check_link (&dh, 1, odd, G_N_ELEMENTS (odd));
+  teardown_dispatcher (&dh);
+
+  setup_dispatcher (&dh, "3,-1");
+  push_buffers (&dh, 4);
+  check_link (&dh, 0, even, G_N_ELEMENTS (even));
+  check_link (&dh, 1, odd, G_N_ELEMENTS (odd));
+  teardown_dispatcher (&dh);
+}
+
+GST_END_TEST;
+
+/* The statistics are ignored in weighted mode */
+GST_START_TEST (test_weighted_ignores_stats)
+{
+  DispatcherHarness dh;
+  const guint64 even[] = { 0, 2, 4, 6 };
+  const guint64 odd[] = { 1, 3, 5, 7 };
+
+  setup_dispatcher (&dh, NULL);
+  set_link_stats (&dh, 0, 10 * GST_MSECOND, 0, 0, 0);
+  set_link_stats (&dh, 1, 40 * GST_MSECOND, 0, 0, 0);
+  push_buffers (&dh, 8);
+  drop_buffers (&dh, 0, 4);
+  drop_buffers (&dh, 1, 4);
+
+  /* src_1 lost everything */
+  set_link_stats (&dh, 0, 10 * GST_MSECOND, GST_SECOND, 8, 4);
+  set_link_stats (&dh, 1, 40 * GST_MSECOND, GST_SECOND, 8, 8);
+  push_buffers (&dh, 8);
+  check_link (&dh, 0, even, G_N_ELEMENTS (even));
+  check_link (&dh, 1, odd, G_N_ELEMENTS (odd));
+  teardown_dispatcher (&dh);
+}
+
+GST_END_TEST;
+
+/* A link twice as slow as the fastest one gets half its share */
+GST_START_TEST (test_adaptive_rtt)
+{
+  DispatcherHarness dh;
+  const guint64 two_thirds[] = { 0, 2, 3, 5 };
+  const guint64 one_third[] = { 1, 4 };
+
+  setup_dispatcher_full (&dh, GST_RIST_DISPATCHER_MODE_ADAPTIVE, NULL);
+  set_link_stats (&dh, 0, 10 * GST_MSECOND, 0, 0, 0);
+  set_link_stats (&dh, 1, 20 * GST_MSECOND, 0, 0, 0);
+  push_buffers (&dh, 6);
+  check_link (&dh, 0, two_thirds, G_N_ELEMENTS (two_thirds));
+  check_link (&dh, 1, one_third, G_N_ELEMENTS (one_third));
+  teardown_dispatcher (&dh);
+}
+
+GST_END_TEST;
+
+/* A link delivering only half of what it is given is capped to the rate it
+ * delivered, the rest goes to the other link */
+GST_START_TEST (test_adaptive_bandwidth)
+{
+  DispatcherHarness dh;
+  const guint64 link0[] = { 0, 1, 3, 4, 5, 7 };
+  const guint64 link1[] = { 2, 6 };
+
+  setup_dispatcher_full (&dh, GST_RIST_DISPATCHER_MODE_ADAPTIVE, NULL);
+  set_link_stats (&dh, 0, GST_CLOCK_TIME_NONE, 0, 0, 0);
+  set_link_stats (&dh, 1, GST_CLOCK_TIME_NONE, 0, 0, 0);
+
+  /* 100 packets per second, 50 over each link */
+  push_buffers (&dh, 100);
+  drop_buffers (&dh, 0, 50);
+  drop_buffers (&dh, 1, 50);
+
+  /* src_0 received its 50 packets, src_1 only 25 of them. Without the
+   * bandwidth term, src_1 would still get 7/15 of the buffers for its 1/8
+   * smoothed loss, instead of the 25 packets per second it can carry. */
+  set_link_stats (&dh, 0, GST_CLOCK_TIME_NONE, GST_SECOND, 100, 50);
+  set_link_stats (&dh, 1, GST_CLOCK_TIME_NONE, GST_SECOND, 100, 75);
+  push_buffers (&dh, 8);
+  check_link (&dh, 0, link0, G_N_ELEMENTS (link0));
+  check_link (&dh, 1, link1, G_N_ELEMENTS (link1));
+
+  /* The same report again does not change anything */
+  set_link_stats (&dh, 1, GST_CLOCK_TIME_NONE, 2 * GST_SECOND, 100, 75);
+  push_list (&dh, 8);
+  check_link (&dh, 0, link0, G_N_ELEMENTS (link0));
+  check_link (&dh, 1, link1, G_N_ELEMENTS (link1));
+  teardown_dispatcher (&dh);
+}
+
+GST_END_TEST;
+
+/* The buffers sent over the worst link are also sent over the best one, and
+ * the duplicates follow when the links swap */
+GST_START_TEST (test_duplicate_worst)
+{
+  DispatcherHarness dh;
+  const guint64 all[] = { 0, 1, 2, 3, 4, 5 };
+  const guint64 one_third[] = { 1, 4 };
+
+  setup_dispatcher_full (&dh, GST_RIST_DISPATCHER_MODE_DUPLICATE_WORST, NULL);
+  set_link_stats (&dh, 0, 10 * GST_MSECOND, 0, 0, 0);
+  set_link_stats (&dh, 1, 20 * GST_MSECOND, 0, 0, 0);
+  push_buffers (&dh, 6);
+  check_link (&dh, 0, all, G_N_ELEMENTS (all));
+  check_link (&dh, 1, one_third, G_N_ELEMENTS (one_third));
+
+  set_link_stats (&dh, 0, 40 * GST_MSECOND, GST_SECOND, 0, 0);
+  push_list (&dh, 6);
+  check_link (&dh, 0, one_third, G_N_ELEMENTS (one_third));
+  check_link (&dh, 1, all, G_N_ELEMENTS (all));
+  teardown_dispatcher (&dh);
+}
+
+GST_END_TEST;
+
+static Suite *
+ristdispatcher_suite (void)
+{
+  Suite *s = suite_create ("ristdispatcher");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_smooth_weighted_round_robin);
+  tcase_add_test (tc_chain, test_smooth_weighted_round_robin_list);
+  tcase_add_test (tc_chain, test_weights_parsing);
+  tcase_add_test (tc_chain, test_weighted_ignores_stats);
+  tcase_add_test (tc_chain, test_adaptive_rtt);
+  tcase_add_test (tc_chain, test_adaptive_bandwidth);
+  tcase_add_test (tc_chain, test_duplicate_worst);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ristdispatcher);
@@ -0,0 +1,192 @@
+/* GStreamer
+ *
+ * Unit tests for the ristrtxsend retransmission history
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/check.h>
+#include <gst/rtp/rtp.h>
+
+#define SSRC 12
+
+static GstHarness *
+setup_rtx_send (guint max_size_packets)
+{
+  GstHarness *h = gst_harness_new ("ristrtxsend");
+
+  g_object_set (h->element, "max-size-packets", max_size_packets, NULL);
+  gst_harness_set_src_caps_str (h, "application/x-rtp, "
+      "clock-rate = (int) 90000, payload = (int) 33, ssrc = (uint) 12");
+
+  return h;
+}
+
+static void
+push_packets (GstHarness * h, guint16 first_seqnum, guint num)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buf;
+  guint i;
+
+  for (i = 0; i < num; i++) {
+    buf = gst_rtp_buffer_new_allocate (16, 0, 0);
+    gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+    gst_rtp_buffer_set_ssrc (&rtp, SSRC);
+    gst_rtp_buffer_set_seq (&rtp, first_seqnum + i);
+    gst_rtp_buffer_set_timestamp (&rtp, i * 3000);
+    gst_rtp_buffer_set_payload_type (&rtp, 33);
+    gst_rtp_buffer_unmap (&rtp);
+
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+    gst_buffer_unref (gst_harness_pull (h));
+  }
+}
+
+static void
+request_packets (GstHarness * h, guint seqnum, guint count)
+{
+  GstEvent *event;
+
+  event = gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
+      gst_structure_new ("GstRTPRetransmissionRequest",
+          "seqnum", G_TYPE_UINT, seqnum,
+          "seqnum-count", G_TYPE_UINT, count,
+          "ssrc", G_TYPE_UINT, SSRC, NULL));
+  fail_unless (gst_harness_push_upstream_event (h, event));
+}
+
+static void
+pull_rtx_packet (GstHarness * h, guint16 seqnum)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buf;
+
+  buf = gst_harness_pull (h);
+  fail_unless (buf);
+  fail_unless (gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp));
+  fail_unless_equals_int (gst_rtp_buffer_get_ssrc (&rtp), SSRC + 1);
+  fail_unless_equals_int (gst_rtp_buffer_get_seq (&rtp), seqnum);
+  gst_rtp_buffer_unmap (&rtp);
+  gst_buffer_unref (buf);
+}
+
+static void
+check_stats (GstHarness * h, guint wanted_hits, guint wanted_misses)
+{
+  guint hits, misses, requests;
+
+  g_object_get (h->element, "num-rtx-hits", &hits, "num-rtx-misses", &misses,
+      "num-rtx-requests", &requests, NULL);
+  fail_unless_equals_int (hits, wanted_hits);
+  fail_unless_equals_int (misses, wanted_misses);
+  fail_unless_equals_int (requests, wanted_hits + wanted_misses);
+}
+
+GST_START_TEST (test_rtx_single)
+{
+  GstHarness *h = setup_rtx_send (100);
+
+  push_packets (h, 0, 10);
+
+  request_packets (h, 3, 1);
+  pull_rtx_packet (h, 3);
+  check_stats (h, 1, 0);
+
+  /* not sent yet */
+  request_packets (h, 20, 1);
+  check_stats (h, 1, 1);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtx_range)
+{
+  GstHarness *h = setup_rtx_send (100);
+  guint i;
+
+  push_packets (h, 0, 10);
+
+  /* the last two are not sent yet */
+  request_packets (h, 6, 6);
+  for (i = 6; i < 10; i++)
+    pull_rtx_packet (h, i);
+  check_stats (h, 4, 2);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtx_expired)
+{
+  GstHarness *h = setup_rtx_send (4);
+
+  push_packets (h, 0, 10);
+
+  request_packets (h, 5, 1);
+  check_stats (h, 0, 1);
+
+  request_packets (h, 6, 1);
+  pull_rtx_packet (h, 6);
+  check_stats (h, 1, 1);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtx_seqnum_wrap)
+{
+  GstHarness *h = setup_rtx_send (0);
+  guint i;
+
+  /* more packets than the initial queue size, around the wrap-around */
+  push_packets (h, 65500, 100);
+
+  request_packets (h, 65530, 12);
+  for (i = 0; i < 12; i++)
+    pull_rtx_packet (h, (guint16) (65530 + i));
+
+  /* the oldest one is still there without packet limit */
+  request_packets (h, 65500, 1);
+  pull_rtx_packet (h, 65500);
+  check_stats (h, 13, 0);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+ristrtxsend_suite (void)
+{
+  Suite *s = suite_create ("ristrtxsend");
+  TCase *tc = tcase_create ("general");
+
+  suite_add_tcase (s, tc);
+
+  tcase_add_test (tc, test_rtx_single);
+  tcase_add_test (tc, test_rtx_range);
+  tcase_add_test (tc, test_rtx_expired);
+  tcase_add_test (tc, test_rtx_seqnum_wrap);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ristrtxsend);
@@ -0,0 +1,271 @@
+/* GStreamer
+ *
+ * Unit tests for rtmp2sink publishing to rtmp2server
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <gst/check/gstcheck.h>
+
+#define FLV_HEADER_SIZE 13
+#define FLV_TAG_HEADER_SIZE 11
+
+#define FLV_TAG_TYPE_AUDIO 8
+#define FLV_TAG_TYPE_VIDEO 9
+#define FLV_TAG_TYPE_SCRIPT 18
+
+#define N_TAGS 32
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  GstElement *server;
+  GstElement *pipeline;
+  GList *tags;
+  gint n_pads;
+} ServerData;
+
+/* "onMetaData" followed by an empty ECMA array */
+static const guint8 metadata[] = {
+  0x02, 0x00, 0x0a, 'o', 'n', 'M', 'e', 't', 'a', 'D', 'a', 't', 'a',
+  0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09,
+};
+
+static GstBuffer *
+create_tag (guint8 type, guint32 timestamp, const guint8 * payload,
+    gsize payload_size)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gsize size = FLV_TAG_HEADER_SIZE + payload_size + 4;
+
+  buffer = gst_buffer_new_allocate (NULL, size, NULL);
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_WRITE));
+  GST_WRITE_UINT8 (map.data, type);
+  GST_WRITE_UINT24_BE (map.data + 1, payload_size);
+  GST_WRITE_UINT24_BE (map.data + 4, timestamp);
+  GST_WRITE_UINT8 (map.data + 7, timestamp >> 24);
+  GST_WRITE_UINT24_BE (map.data + 8, 0);
+  memcpy (map.data + FLV_TAG_HEADER_SIZE, payload, payload_size);
+  GST_WRITE_UINT32_BE (map.data + size - 4,
+      FLV_TAG_HEADER_SIZE + payload_size);
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+/* A script tag followed by alternating video and audio tags, each with its
+ * own timestamp and contents */
+static GList *
+create_tags (void)
+{
+  GList *tags = NULL;
+  guint8 payload[64];
+  guint32 timestamp;
+  guint i, j;
+
+  tags = g_list_append (tags, create_tag (FLV_TAG_TYPE_SCRIPT, 0, metadata,
+          sizeof metadata));
+
+  for (i = 1; i < N_TAGS; i++) {
+    timestamp = i * 20;
+    for (j = 0; j < sizeof payload; j++)
+      payload[j] = i + j;
+
+    if (i % 2) {
+      /* H.264 NALU, keyframe every 8 tags */
+      payload[0] = i % 8 == 1 ? 0x17 : 0x27;
+      payload[1] = 0x01;
+      tags = g_list_append (tags, create_tag (FLV_TAG_TYPE_VIDEO, timestamp,
+              payload, sizeof payload));
+    } else {
+      /* AAC raw */
+      payload[0] = 0xaf;
+      payload[1] = 0x01;
+      tags = g_list_append (tags, create_tag (FLV_TAG_TYPE_AUDIO, timestamp,
+              payload, sizeof payload / 2));
+    }
+  }
+
+  return tags;
+}
+
+static void
+on_handoff (GstElement * fakesink, GstBuffer * buffer, GstPad * pad,
+    ServerData * data)
+{
+  g_mutex_lock (&data->lock);
+  data->tags = g_list_append (data->tags, gst_buffer_ref (buffer));
+  g_cond_signal (&data->cond);
+  g_mutex_unlock (&data->lock);
+}
+
+static void
+on_pad_added (GstElement * server, GstPad * pad, ServerData * data)
+{
+  GstElement *fakesink;
+  GstPad *sinkpad;
+
+  fakesink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (fakesink, "sync", FALSE, "async", FALSE,
+      "signal-handoffs", TRUE, NULL);
+  g_signal_connect (fakesink, "handoff", G_CALLBACK (on_handoff), data);
+  gst_bin_add (GST_BIN (data->pipeline), fakesink);
+  gst_element_sync_state_with_parent (fakesink);
+
+  sinkpad = gst_element_get_static_pad (fakesink, "sink");
+  fail_unless_equals_int (gst_pad_link (pad, sinkpad), GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+
+  g_atomic_int_inc (&data->n_pads);
+}
+
+static void
+setup_server (ServerData * data)
+{
+  memset (data, 0, sizeof (ServerData));
+  g_mutex_init (&data->lock);
+  g_cond_init (&data->cond);
+
+  data->pipeline = gst_pipeline_new ("server");
+  data->server = gst_element_factory_make ("rtmp2server", NULL);
+  fail_unless (data->server != NULL);
+  g_object_set (data->server, "host", "127.0.0.1", "port", 0, NULL);
+  g_signal_connect (data->server, "pad-added", G_CALLBACK (on_pad_added),
+      data);
+  gst_bin_add (GST_BIN (data->pipeline), data->server);
+
+  fail_if (gst_element_set_state (data->pipeline, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+}
+
+static void
+teardown_server (ServerData * data)
+{
+  gst_element_set_state (data->pipeline, GST_STATE_NULL);
+  gst_object_unref (data->pipeline);
+  g_list_free_full (data->tags, (GDestroyNotify) gst_buffer_unref);
+  g_mutex_clear (&data->lock);
+  g_cond_clear (&data->cond);
+}
+
+static void
+wait_for_tags (ServerData * data, guint n_tags)
+{
+  gint64 deadline = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+
+  g_mutex_lock (&data->lock);
+  while (g_list_length (data->tags) < n_tags) {
+    if (!g_cond_wait_until (&data->cond, &data->lock, deadline))
+      break;
+  }
+  fail_unless_equals_int (g_list_length (data->tags), n_tags);
+  g_mutex_unlock (&data->lock);
+}
+
+/* What the server outputs is the FLV stream the sink got, tag by tag */
+GST_START_TEST (test_publish_loopback)
+{
+  ServerData data;
+  GstElement *pipeline, *appsrc, *sink;
+  GstFlowReturn flow;
+  GstBuffer *header;
+  GList *tags, *l, *r;
+  GstMapInfo map;
+  gchar *location;
+  gint port;
+
+  setup_server (&data);
+  g_object_get (data.server, "current-port", &port, NULL);
+  fail_unless (port > 0);
+
+  pipeline = gst_parse_launch ("appsrc name=src format=bytes "
+      "caps=video/x-flv ! rtmp2sink name=sink", NULL);
+  fail_unless (pipeline != NULL);
+  appsrc = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  location = g_strdup_printf ("rtmp://127.0.0.1:%d/live/test", port);
+  g_object_set (sink, "location", location, NULL);
+  g_free (location);
+  fail_if (gst_element_set_state (pipeline, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+
+  /* The header is dropped by the sink, the server makes its own */
+  header = gst_buffer_new_allocate (NULL, FLV_HEADER_SIZE, NULL);
+  gst_buffer_fill (header, 0, "FLV\x01\x05\x00\x00\x00\x09\x00\x00\x00\x00",
+      FLV_HEADER_SIZE);
+  g_signal_emit_by_name (appsrc, "push-buffer", header, &flow);
+  fail_unless_equals_int (flow, GST_FLOW_OK);
+  gst_buffer_unref (header);
+
+  tags = create_tags ();
+  for (l = tags; l; l = l->next) {
+    g_signal_emit_by_name (appsrc, "push-buffer", l->data, &flow);
+    fail_unless_equals_int (flow, GST_FLOW_OK);
+  }
+
+  wait_for_tags (&data, N_TAGS);
+  fail_unless_equals_int (g_atomic_int_get (&data.n_pads), 1);
+
+  for (l = tags, r = data.tags; l && r; l = l->next, r = r->next) {
+    GstBuffer *tag = r->data;
+    gsize offset = 0;
+    guint32 timestamp;
+
+    /* The first tag comes after the FLV header */
+    if (l == tags) {
+      fail_unless (gst_buffer_memcmp (tag, 0, "FLV", 3) == 0);
+      offset = FLV_HEADER_SIZE;
+    }
+
+    fail_unless (gst_buffer_map (l->data, &map, GST_MAP_READ));
+    fail_unless_equals_uint64 (gst_buffer_get_size (tag) - offset, map.size);
+    fail_unless (gst_buffer_memcmp (tag, offset, map.data, map.size) == 0);
+    timestamp = GST_READ_UINT24_BE (map.data + 4);
+    gst_buffer_unmap (l->data, &map);
+
+    fail_unless_equals_uint64 (GST_BUFFER_DTS (tag), timestamp * GST_MSECOND);
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (appsrc);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+  g_list_free_full (tags, (GDestroyNotify) gst_buffer_unref);
+  teardown_server (&data);
+}
+
+GST_END_TEST;
+
+static Suite *
+rtmp2_suite (void)
+{
+  Suite *s = suite_create ("rtmp2");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_publish_loopback);
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtmp2);
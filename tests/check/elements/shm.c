@@ -169,6 +169,77 @@ GST_START_TEST (test_shm_alloc)
 
 GST_END_TEST;
 
+GST_START_TEST (test_shm_pool)
+{
+  GstBuffer *buf;
+  GstBufferPool *pool;
+  GstQuery *query;
+  GstCaps *caps;
+  GstAllocator *alloc;
+  GstStructure *stats;
+  GstSegment segment;
+  guint size, min, max;
+  guint64 copied, used;
+
+  caps = gst_caps_from_string ("video/x-raw, format=(string)I420, "
+      "width=(int)320, height=(int)240, framerate=(fraction)30/1");
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (srcpad, gst_event_new_caps (caps));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  query = gst_query_new_allocation (caps, TRUE);
+  gst_caps_unref (caps);
+
+  fail_unless (gst_pad_peer_query (srcpad, query));
+
+  fail_unless (gst_query_get_n_allocation_params (query) == 1);
+  gst_query_parse_nth_allocation_param (query, 0, &alloc, NULL);
+  fail_unless (alloc != NULL);
+
+  fail_unless (gst_query_get_n_allocation_pools (query) == 1);
+  gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+  gst_query_unref (query);
+  fail_unless (pool != NULL);
+  fail_unless_equals_int (size, 320 * 240 * 3 / 2);
+  fail_unless (max > 0);
+
+  fail_unless (gst_buffer_pool_set_active (pool, TRUE));
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf,
+          NULL) == GST_FLOW_OK);
+  fail_unless (gst_buffer_peek_memory (buf, 0)->allocator == alloc);
+  gst_object_unref (alloc);
+
+  g_object_get (sink, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "used", &used));
+  fail_unless (used >= size);
+  gst_structure_free (stats);
+
+  GST_BUFFER_PTS (buf) = 0;
+  fail_unless (gst_pad_push (srcpad, buf) == GST_FLOW_OK);
+
+  g_mutex_lock (&check_mutex);
+  while (buffers == NULL)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  /* The buffer from the pool was sent without copying it */
+  g_object_get (sink, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "copied", &copied));
+  fail_unless_equals_uint64 (copied, 0);
+  gst_structure_free (stats);
+
+  /* The pool holds a reference to the sink through its allocator */
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+
+  gst_check_drop_buffers ();
+  teardown_shm ();
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_shm_live)
 {
   GstElement *producer, *consumer;
@@ -239,6 +310,7 @@ shm_suite (void)
   tcase_add_checked_fixture (tc, setup_shm, NULL);
   tcase_add_test (tc, test_shm_sysmem_alloc);
   tcase_add_test (tc, test_shm_alloc);
+  tcase_add_test (tc, test_shm_pool);
   suite_add_tcase (s, tc);
 
   tc = tcase_create ("shm2");
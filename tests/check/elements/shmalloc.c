@@ -0,0 +1,287 @@
+/* GStreamer
+ *
+ * Unit tests for the shared memory space allocator
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+#include "../../../sys/shm/shmalloc.h"
+
+/* Blocks are rounded up to this */
+#define ALIGN 64
+
+static void
+check_stats (ShmAllocSpace * space, unsigned long used,
+    unsigned long used_blocks, unsigned long free_blocks,
+    unsigned long largest_free)
+{
+  ShmAllocStats stats;
+
+  shm_alloc_space_get_stats (space, &stats);
+  fail_unless_equals_uint64 (stats.used, used);
+  fail_unless_equals_uint64 (stats.used_blocks, used_blocks);
+  fail_unless_equals_uint64 (stats.free_blocks, free_blocks);
+  fail_unless_equals_uint64 (stats.largest_free, largest_free);
+}
+
+static unsigned long
+alloc_at (ShmAllocSpace * space, unsigned long size, ShmAllocBlock ** block)
+{
+  *block = shm_alloc_space_alloc_block (space, size);
+  fail_unless (*block != NULL);
+
+  return shm_alloc_space_alloc_block_get_offset (*block);
+}
+
+GST_START_TEST (test_split)
+{
+  ShmAllocSpace *space = shm_alloc_space_new (65536);
+  ShmAllocBlock *a, *b, *c;
+
+  check_stats (space, 0, 0, 1, 65536);
+
+  /* Sizes are rounded to the alignment and the rest is given back */
+  fail_unless_equals_uint64 (alloc_at (space, 100, &a), 0);
+  check_stats (space, 128, 1, 1, 65536 - 128);
+
+  fail_unless_equals_uint64 (alloc_at (space, 1, &b), 128);
+  check_stats (space, 192, 2, 1, 65536 - 192);
+
+  /* Taking all that is left does not leave an empty block behind */
+  fail_unless_equals_uint64 (alloc_at (space, 65536 - 192, &c), 192);
+  check_stats (space, 65536, 3, 0, 0);
+
+  shm_alloc_space_block_dec (a);
+  shm_alloc_space_block_dec (b);
+  shm_alloc_space_block_dec (c);
+  check_stats (space, 0, 0, 1, 65536);
+
+  shm_alloc_space_free (space);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_merge)
+{
+  ShmAllocSpace *space = shm_alloc_space_new (65536);
+  ShmAllocBlock *a, *b, *c, *d;
+
+  alloc_at (space, 1024, &a);
+  alloc_at (space, 1024, &b);
+  alloc_at (space, 1024, &c);
+  alloc_at (space, 1024, &d);
+  check_stats (space, 4096, 4, 1, 65536 - 4096);
+
+  /* A hole with used neighbours stays on its own */
+  shm_alloc_space_block_dec (b);
+  check_stats (space, 3072, 3, 2, 65536 - 4096);
+
+  /* Merged with the following free block */
+  shm_alloc_space_block_dec (a);
+  check_stats (space, 2048, 2, 2, 65536 - 4096);
+
+  /* Merged with the preceding free block */
+  shm_alloc_space_block_dec (d);
+  check_stats (space, 1024, 1, 2, 65536 - 3072);
+
+  /* Merged on both sides, back to a single block */
+  shm_alloc_space_block_dec (c);
+  check_stats (space, 0, 0, 1, 65536);
+
+  /* And the whole space can be handed out again */
+  fail_unless_equals_uint64 (alloc_at (space, 65536, &a), 0);
+  shm_alloc_space_block_dec (a);
+
+  shm_alloc_space_free (space);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_use_count)
+{
+  ShmAllocSpace *space = shm_alloc_space_new (65536);
+  ShmAllocBlock *a;
+
+  alloc_at (space, 1024, &a);
+  shm_alloc_space_block_inc (a);
+
+  /* Only freed once the last user is gone */
+  shm_alloc_space_block_dec (a);
+  check_stats (space, 1024, 1, 1, 65536 - 1024);
+  shm_alloc_space_block_dec (a);
+  check_stats (space, 0, 0, 1, 65536);
+
+  shm_alloc_space_free (space);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_free_list_selection)
+{
+  ShmAllocSpace *space = shm_alloc_space_new (65536);
+  ShmAllocBlock *small, *big, *sep[3], *block;
+
+  /* Leave a 256 byte hole at 0 and a 1024 byte hole at 320, before the
+   * big free block at the end */
+  alloc_at (space, 256, &small);
+  alloc_at (space, 64, &sep[0]);
+  alloc_at (space, 1024, &big);
+  alloc_at (space, 64, &sep[1]);
+  shm_alloc_space_block_dec (small);
+  shm_alloc_space_block_dec (big);
+  check_stats (space, 128, 2, 3, 65536 - 1408);
+
+  /* Small requests are served from the exact size list */
+  fail_unless_equals_uint64 (alloc_at (space, 200, &small), 0);
+
+  /* A request of a hole's size class goes into that hole and not in the
+   * bigger block */
+  fail_unless_equals_uint64 (alloc_at (space, 1024, &big), 320);
+  check_stats (space, 1408, 4, 1, 65536 - 1408);
+
+  /* Too big for any hole, taken from the end */
+  fail_unless_equals_uint64 (alloc_at (space, 1100, &block), 1408);
+  shm_alloc_space_block_dec (block);
+
+  /* A smaller request splits the smallest list that is sure to fit */
+  shm_alloc_space_block_dec (big);
+  fail_unless_equals_uint64 (alloc_at (space, 64, &block), 320);
+  fail_unless_equals_uint64 (alloc_at (space, 64, &sep[2]), 384);
+  check_stats (space, 512, 5, 2, 65536 - 1408);
+
+  shm_alloc_space_block_dec (block);
+  shm_alloc_space_block_dec (sep[2]);
+  shm_alloc_space_block_dec (sep[0]);
+  shm_alloc_space_block_dec (sep[1]);
+  shm_alloc_space_block_dec (small);
+  check_stats (space, 0, 0, 1, 65536);
+
+  shm_alloc_space_free (space);
+}
+
+GST_END_TEST;
+
+#define N_FRAG_BLOCKS 64
+
+GST_START_TEST (test_fragmentation)
+{
+  ShmAllocSpace *space = shm_alloc_space_new (N_FRAG_BLOCKS * ALIGN);
+  ShmAllocBlock *blocks[N_FRAG_BLOCKS], *block;
+  ShmAllocStats stats;
+  gint i;
+
+  for (i = 0; i < N_FRAG_BLOCKS; i++)
+    fail_unless_equals_uint64 (alloc_at (space, ALIGN, &blocks[i]),
+        i * ALIGN);
+  check_stats (space, N_FRAG_BLOCKS * ALIGN, N_FRAG_BLOCKS, 0, 0);
+
+  fail_unless (shm_alloc_space_alloc_block (space, ALIGN) == NULL);
+  shm_alloc_space_get_stats (space, &stats);
+  fail_unless_equals_int (stats.alloc_failures, 1);
+
+  /* Free every other block: half of the space is free but no two free
+   * blocks are contiguous */
+  for (i = 0; i < N_FRAG_BLOCKS; i += 2)
+    shm_alloc_space_block_dec (blocks[i]);
+  check_stats (space, N_FRAG_BLOCKS * ALIGN / 2, N_FRAG_BLOCKS / 2,
+      N_FRAG_BLOCKS / 2, ALIGN);
+
+  fail_unless (shm_alloc_space_alloc_block (space, 2 * ALIGN) == NULL);
+  shm_alloc_space_get_stats (space, &stats);
+  fail_unless_equals_int (stats.alloc_failures, 2);
+
+  /* Freeing the rest coalesces everything back into one block */
+  for (i = 1; i < N_FRAG_BLOCKS; i += 2) {
+    shm_alloc_space_block_dec (blocks[i]);
+    shm_alloc_space_get_stats (space, &stats);
+    fail_unless_equals_int (stats.free_blocks,
+        MAX (1, N_FRAG_BLOCKS / 2 - (i + 1) / 2));
+  }
+  check_stats (space, 0, 0, 1, N_FRAG_BLOCKS * ALIGN);
+
+  fail_unless_equals_uint64 (alloc_at (space, N_FRAG_BLOCKS * ALIGN,
+          &block), 0);
+  shm_alloc_space_block_dec (block);
+
+  shm_alloc_space_free (space);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_block_get)
+{
+  ShmAllocSpace *space = shm_alloc_space_new (4 * 65536);
+  ShmAllocBlock *a, *b, *c;
+
+  alloc_at (space, 100000, &a);
+  alloc_at (space, 64, &b);
+
+  /* Offsets inside a block find it, also on pages it does not start on */
+  fail_unless (shm_alloc_space_block_get (space, 0) == a);
+  fail_unless (shm_alloc_space_block_get (space, 70000) == a);
+  fail_unless (shm_alloc_space_block_get (space, 100031) == a);
+  fail_unless (shm_alloc_space_block_get (space, 100032) == b);
+
+  /* Free space and offsets past the end have no block */
+  fail_unless (shm_alloc_space_block_get (space, 150000) == NULL);
+  fail_unless (shm_alloc_space_block_get (space, 4 * 65536) == NULL);
+
+  /* The page index follows splits and merges */
+  alloc_at (space, 100000, &c);
+  fail_unless (shm_alloc_space_block_get (space, 150000) == c);
+  shm_alloc_space_block_dec (b);
+  fail_unless (shm_alloc_space_block_get (space, 100032) == NULL);
+  fail_unless (shm_alloc_space_block_get (space, 150000) == c);
+  shm_alloc_space_block_dec (a);
+  fail_unless (shm_alloc_space_block_get (space, 70000) == NULL);
+  fail_unless (shm_alloc_space_block_get (space, 150000) == c);
+
+  alloc_at (space, 100000, &a);
+  fail_unless (shm_alloc_space_block_get (space, 70000) == a);
+
+  shm_alloc_space_block_dec (a);
+  shm_alloc_space_block_dec (c);
+  check_stats (space, 0, 0, 1, 4 * 65536);
+
+  shm_alloc_space_free (space);
+}
+
+GST_END_TEST;
+
+static Suite *
+shmalloc_suite (void)
+{
+  Suite *s = suite_create ("shmalloc");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_split);
+  tcase_add_test (tc_chain, test_merge);
+  tcase_add_test (tc_chain, test_use_count);
+  tcase_add_test (tc_chain, test_free_list_selection);
+  tcase_add_test (tc_chain, test_fragmentation);
+  tcase_add_test (tc_chain, test_block_get);
+
+  return s;
+}
+
+GST_CHECK_MAIN (shmalloc);
@@ -30,6 +30,7 @@
 #include <gst/check/gstcheck.h>
 
 #include <gst/check/gstharness.h>
+#include <gst/rtp/gstrtpbuffer.h>
 
 GST_START_TEST (test_create_and_unref)
 {
@@ -207,6 +208,98 @@ GST_START_TEST (test_roc)
 
 GST_END_TEST;
 
+#define TEST_KEY "012345678901234567890123456789012345678901234567890123456789"
+
+static GstBuffer *
+create_rtp_buffer (guint16 seqnum, guint payload_size, guint tailroom)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buf;
+  guint8 *payload;
+  guint i;
+
+  /* Allocate the trailer room up front, then hide it */
+  buf = gst_rtp_buffer_new_allocate (payload_size + tailroom, 0, 0);
+  gst_buffer_set_size (buf, gst_buffer_get_size (buf) - tailroom);
+
+  gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+  gst_rtp_buffer_set_payload_type (&rtp, 8);
+  gst_rtp_buffer_set_ssrc (&rtp, 1356955624);
+  gst_rtp_buffer_set_seq (&rtp, seqnum);
+  payload = gst_rtp_buffer_get_payload (&rtp);
+  for (i = 0; i < payload_size; i++)
+    payload[i] = seqnum + i;
+  gst_rtp_buffer_unmap (&rtp);
+
+  return buf;
+}
+
+static void
+check_rtp_buffer (GstBuffer * buf, guint16 seqnum, guint payload_size)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint8 *payload;
+  guint i;
+
+  fail_unless (gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp));
+  fail_unless_equals_int (gst_rtp_buffer_get_seq (&rtp), seqnum);
+  fail_unless_equals_int (gst_rtp_buffer_get_payload_len (&rtp),
+      payload_size);
+  payload = gst_rtp_buffer_get_payload (&rtp);
+  for (i = 0; i < payload_size; i++)
+    fail_unless_equals_int (payload[i], (guint8) (seqnum + i));
+  gst_rtp_buffer_unmap (&rtp);
+}
+
+GST_START_TEST (test_buffer_list)
+{
+  GstHarness *enc, *dec;
+  GstBufferList *list;
+  guint i, n_buffers = 16;
+
+  enc = gst_harness_new_with_padnames ("srtpenc", "rtp_sink_0", "rtp_src_0");
+  gst_util_set_object_arg (G_OBJECT (enc->element), "key", TEST_KEY);
+  gst_harness_set_src_caps_str (enc,
+      "application/x-rtp, payload=(int)8, ssrc=(uint)1356955624");
+
+  dec = gst_harness_new_with_padnames ("srtpdec", "rtp_sink", "rtp_src");
+  gst_harness_set_src_caps_str (dec,
+      "application/x-srtp, payload=(int)8, ssrc=(uint)1356955624, "
+      "srtp-key=(buffer)" TEST_KEY ", srtp-cipher=(string)aes-128-icm, "
+      "srtp-auth=(string)hmac-sha1-80, srtcp-cipher=(string)aes-128-icm, "
+      "srtcp-auth=(string)hmac-sha1-80");
+
+  /* Mix packets protected in place, copied into the pool and too big for
+   * the pool */
+  list = gst_buffer_list_new ();
+  for (i = 0; i < n_buffers; i++) {
+    guint payload_size = (i % 4 == 3) ? 3000 : 160;
+    guint tailroom = (i % 2) ? 256 : 0;
+
+    gst_buffer_list_add (list, create_rtp_buffer (i, payload_size, tailroom));
+  }
+  fail_unless_equals_int (gst_pad_push_list (enc->srcpad, list), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (enc), n_buffers);
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < n_buffers; i++)
+    gst_buffer_list_add (list, gst_harness_pull (enc));
+  fail_unless_equals_int (gst_pad_push_list (dec->srcpad, list), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (dec), n_buffers);
+
+  for (i = 0; i < n_buffers; i++) {
+    GstBuffer *buf = gst_harness_pull (dec);
+
+    check_rtp_buffer (buf, i, (i % 4 == 3) ? 3000 : 160);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (enc);
+  gst_harness_teardown (dec);
+}
+
+GST_END_TEST;
+
 #ifdef HAVE_SRTP2
 
 GST_START_TEST (test_simple_mki)
@@ -352,6 +445,7 @@ srtp_suite (void)
   tcase_add_test (tc_chain, test_create_and_unref);
   tcase_add_test (tc_chain, test_play);
   tcase_add_test (tc_chain, test_roc);
+  tcase_add_test (tc_chain, test_buffer_list);
 #ifdef HAVE_SRTP2
   tcase_add_test (tc_chain, test_simple_mki);
   tcase_add_test (tc_chain, test_srtpdec_multiple_mki);
@@ -0,0 +1,197 @@
+/* GStreamer
+ *
+ * Unit tests for srtsink in listener mode
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+/* Needed for GValueArray */
+#define GLIB_DISABLE_DEPRECATION_WARNINGS
+
+#include <gst/check/gstcheck.h>
+#include <gio/gnetworking.h>
+#include <srt/srt.h>
+
+/* The largest payload of a live mode packet */
+#define PAYLOAD_SIZE 1316
+
+/* More than the send and receive buffers of a caller that doesn't read
+ * can hold, so that it lags behind */
+#define N_BUFFERS 20000
+
+typedef struct
+{
+  SRTSOCKET sock;
+  gint n_received;
+  gboolean in_order;
+} Reader;
+
+static void
+on_caller_added (GstElement * sink, gint unused, GSocketAddress * addr,
+    gint * n_callers)
+{
+  g_atomic_int_inc (n_callers);
+}
+
+static SRTSOCKET
+connect_caller (guint port)
+{
+  struct sockaddr_in sa = { 0, };
+  SRTSOCKET sock;
+  gint timeout = 5000;
+
+  sock = srt_create_socket ();
+  fail_unless (sock != SRT_INVALID_SOCK);
+  srt_setsockopt (sock, 0, SRTO_RCVTIMEO, &timeout, sizeof timeout);
+
+  sa.sin_family = AF_INET;
+  sa.sin_port = g_htons (port);
+  sa.sin_addr.s_addr = g_htonl (INADDR_LOOPBACK);
+  fail_if (srt_connect (sock, (struct sockaddr *) &sa, sizeof sa) ==
+      SRT_ERROR, "%s", srt_getlasterror_str ());
+
+  return sock;
+}
+
+static gpointer
+read_thread (Reader * reader)
+{
+  gchar data[PAYLOAD_SIZE];
+
+  reader->in_order = TRUE;
+  while (reader->n_received < N_BUFFERS) {
+    gint len = srt_recvmsg (reader->sock, data, sizeof data);
+
+    if (len == SRT_ERROR)
+      break;
+
+    if (len != PAYLOAD_SIZE || GST_READ_UINT32_BE (data) !=
+        reader->n_received)
+      reader->in_order = FALSE;
+    reader->n_received++;
+  }
+
+  return NULL;
+}
+
+/* Returns how many callers had buffers dropped */
+static guint
+count_lagging_callers (GstElement * sink)
+{
+  GstStructure *stats;
+  GValueArray *callers;
+  guint i, n_lagging = 0;
+
+  g_object_get (sink, "stats", &stats, NULL);
+  fail_unless (gst_structure_get (stats, "callers", G_TYPE_VALUE_ARRAY,
+          &callers, NULL));
+
+  fail_unless_equals_int (callers->n_values, 2);
+  for (i = 0; i < callers->n_values; i++) {
+    const GstStructure *s =
+        gst_value_get_structure (g_value_array_get_nth (callers, i));
+    guint64 dropped;
+
+    fail_unless (gst_structure_get_uint64 (s, "buffers-dropped", &dropped));
+    if (dropped > 0)
+      n_lagging++;
+  }
+  g_value_array_free (callers);
+  gst_structure_free (stats);
+
+  return n_lagging;
+}
+
+/* A caller that stops reading must not hold back the others, nor the
+ * streaming thread. Its buffers are dropped instead. */
+GST_START_TEST (test_listener_slow_caller)
+{
+  GstHarness *h;
+  GThread *thread;
+  Reader reader = { SRT_INVALID_SOCK, 0, FALSE };
+  SRTSOCKET slow;
+  gchar *launch;
+  guint port = g_random_int_range (20000, 40000);
+  gint n_callers = 0;
+  guint i;
+
+  /* Without too-late packet drop, the packets the slow caller doesn't
+   * take stay in the send buffer */
+  launch = g_strdup_printf ("srtsink uri=\"srt://:%u?mode=listener"
+      "&tlpktdrop=false\" sync=false caller-queue-size=64 "
+      "caller-lag-policy=drop-oldest", port);
+  h = gst_harness_new_parse (launch);
+  g_free (launch);
+  g_signal_connect (h->element, "caller-added", G_CALLBACK (on_caller_added),
+      &n_callers);
+  gst_harness_set_src_caps_str (h, "application/x-test");
+
+  reader.sock = connect_caller (port);
+  slow = connect_caller (port);
+  while (g_atomic_int_get (&n_callers) < 2)
+    g_usleep (G_TIME_SPAN_MILLISECOND);
+
+  thread = g_thread_new ("reader", (GThreadFunc) read_thread, &reader);
+
+  for (i = 0; i < N_BUFFERS; i++) {
+    GstBuffer *buffer = gst_buffer_new_allocate (NULL, PAYLOAD_SIZE, NULL);
+    GstMapInfo map;
+
+    fail_unless (gst_buffer_map (buffer, &map, GST_MAP_WRITE));
+    memset (map.data, 0, map.size);
+    GST_WRITE_UINT32_BE (map.data, i);
+    gst_buffer_unmap (buffer, &map);
+
+    fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+
+    /* about 200 Mbps, which the fast caller keeps up with */
+    if (i % 20 == 19)
+      g_usleep (G_TIME_SPAN_MILLISECOND);
+  }
+
+  /* The fast caller got everything */
+  g_thread_join (thread);
+  fail_unless_equals_int (reader.n_received, N_BUFFERS);
+  fail_unless (reader.in_order);
+
+  /* and only the slow one lost some */
+  fail_unless_equals_int (count_lagging_callers (h->element), 1);
+
+  srt_close (reader.sock);
+  srt_close (slow);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+srtsink_suite (void)
+{
+  Suite *s = suite_create ("srtsink");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_set_timeout (tc_chain, 60);
+  tcase_add_test (tc_chain, test_listener_slow_caller);
+
+  return s;
+}
+
+GST_CHECK_MAIN (srtsink);
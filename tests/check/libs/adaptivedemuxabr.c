@@ -0,0 +1,245 @@
+/* GStreamer
+ *
+ * Unit tests for the adaptive demux bandwidth estimators and ABR policies
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <string.h>
+
+#include "../../../gst-libs/gst/adaptivedemux/gstadaptivedemuxabr.h"
+
+/* The ABR module logs in the base class category */
+GST_DEBUG_CATEGORY (adaptivedemux_debug);
+
+#define BITRATE_LIMIT 0.8
+
+static void
+decide (GstAdaptiveDemuxAbr * abr, GstAdaptiveDemuxAbrDecision * decision,
+    GstAdaptiveDemuxAbrPolicy policy,
+    GstAdaptiveDemuxBandwidthEstimator estimator,
+    GstClockTime buffer_level, guint64 current_bitrate)
+{
+  memset (decision, 0, sizeof (GstAdaptiveDemuxAbrDecision));
+  decision->policy = policy;
+  decision->estimator = estimator;
+  decision->bitrate_limit = BITRATE_LIMIT;
+  decision->buffer_target = 30 * GST_SECOND;
+  decision->buffer_level = buffer_level;
+  decision->current_bitrate = current_bitrate;
+
+  gst_adaptive_demux_abr_decide (abr, decision);
+}
+
+static guint64
+get_bandwidth (GstAdaptiveDemuxAbr * abr,
+    GstAdaptiveDemuxBandwidthEstimator estimator)
+{
+  GstAdaptiveDemuxAbrDecision decision;
+
+  decide (abr, &decision, GST_ADAPTIVE_DEMUX_ABR_POLICY_THROUGHPUT,
+      estimator, GST_CLOCK_TIME_NONE, 0);
+  /* Without a buffer level, the throughput margin applies */
+  fail_unless_equals_uint64 (decision.target_bitrate,
+      (guint64) (decision.bandwidth * decision.bitrate_limit));
+
+  return decision.bandwidth;
+}
+
+#define assert_close(a, b) \
+  fail_unless (ABS ((gdouble) (a) - (gdouble) (b)) <= (gdouble) (b) / 100, \
+      "%" G_GUINT64_FORMAT " is not close to %" G_GUINT64_FORMAT, \
+      (guint64) (a), (guint64) (b))
+
+GST_START_TEST (test_moving_average)
+{
+  GstAdaptiveDemuxAbr *abr = gst_adaptive_demux_abr_new ();
+  GstAdaptiveDemuxBandwidthEstimator estimator =
+      GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE;
+
+  /* Nothing known yet */
+  fail_unless_equals_uint64 (get_bandwidth (abr, estimator), 0);
+
+  gst_adaptive_demux_abr_add_fragment (abr, 1000000);
+  fail_unless_equals_uint64 (get_bandwidth (abr, estimator), 1000000);
+
+  /* Going up is limited by the average */
+  gst_adaptive_demux_abr_add_fragment (abr, 2000000);
+  gst_adaptive_demux_abr_add_fragment (abr, 3000000);
+  fail_unless_equals_uint64 (get_bandwidth (abr, estimator), 2000000);
+
+  /* Going down follows the last fragment */
+  gst_adaptive_demux_abr_add_fragment (abr, 500000);
+  fail_unless_equals_uint64 (get_bandwidth (abr, estimator), 500000);
+
+  /* Only the last 3 fragments count */
+  gst_adaptive_demux_abr_add_fragment (abr, 4000000);
+  gst_adaptive_demux_abr_add_fragment (abr, 4000000);
+  fail_unless_equals_uint64 (get_bandwidth (abr, estimator), 2833333);
+  gst_adaptive_demux_abr_add_fragment (abr, 4000000);
+  fail_unless_equals_uint64 (get_bandwidth (abr, estimator), 4000000);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_harmonic_mean)
+{
+  GstAdaptiveDemuxAbr *abr = gst_adaptive_demux_abr_new ();
+  GstAdaptiveDemuxBandwidthEstimator estimator =
+      GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_HARMONIC_MEAN;
+  gint i;
+
+  /* Fragments that could not be timed don't give an estimate */
+  gst_adaptive_demux_abr_add_fragment (abr, 0);
+  fail_unless_equals_uint64 (get_bandwidth (abr, estimator), 0);
+
+  /* and don't drag the mean down to 0 either */
+  gst_adaptive_demux_abr_add_fragment (abr, 1000000);
+  gst_adaptive_demux_abr_add_fragment (abr, 4000000);
+  assert_close (get_bandwidth (abr, estimator), 1600000);
+
+  /* A short burst barely moves it */
+  gst_adaptive_demux_abr_add_fragment (abr, 100000000);
+  assert_close (get_bandwidth (abr, estimator), 2380952);
+
+  /* Only the last 5 fragments count */
+  for (i = 0; i < 5; i++)
+    gst_adaptive_demux_abr_add_fragment (abr, 3000000);
+  assert_close (get_bandwidth (abr, estimator), 3000000);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_ewma)
+{
+  GstAdaptiveDemuxAbr *abr = gst_adaptive_demux_abr_new ();
+  GstAdaptiveDemuxBandwidthEstimator estimator =
+      GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_EWMA;
+  guint64 bandwidth;
+  gint i;
+
+  /* 8 Mbps, in chunks of 100 ms */
+  for (i = 0; i < 50; i++)
+    gst_adaptive_demux_abr_add_chunk (abr, 100000, 100 * GST_MSECOND);
+  gst_adaptive_demux_abr_add_fragment (abr, 8000000);
+  assert_close (get_bandwidth (abr, estimator), 8000000);
+
+  /* The bandwidth drops in the middle of a fragment, the estimate follows
+   * before the fragment is done */
+  for (i = 0; i < 20; i++)
+    gst_adaptive_demux_abr_add_chunk (abr, 25000, 100 * GST_MSECOND);
+  bandwidth = get_bandwidth (abr, estimator);
+  fail_unless (bandwidth < 6000000);
+  fail_unless (bandwidth > 2000000);
+
+  /* Chunks too small to be timed reliably are accumulated */
+  gst_adaptive_demux_abr_add_chunk (abr, 1000, GST_MSECOND);
+  fail_unless_equals_uint64 (get_bandwidth (abr, estimator), bandwidth);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_buffer_policy)
+{
+  GstAdaptiveDemuxAbr *abr = gst_adaptive_demux_abr_new ();
+  GstAdaptiveDemuxAbrDecision decision;
+  GstAdaptiveDemuxAbrPolicy policy = GST_ADAPTIVE_DEMUX_ABR_POLICY_BUFFER;
+  GstAdaptiveDemuxBandwidthEstimator estimator =
+      GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE;
+
+  gst_adaptive_demux_abr_add_fragment (abr, 5000000);
+
+  /* At the target level the current bitrate is kept */
+  decide (abr, &decision, policy, estimator, 30 * GST_SECOND, 2000000);
+  fail_unless_equals_uint64 (decision.target_bitrate, 2000000);
+
+  /* and scaled proportionally around it */
+  decide (abr, &decision, policy, estimator, 15 * GST_SECOND, 2000000);
+  fail_unless_equals_uint64 (decision.target_bitrate, 1000000);
+  decide (abr, &decision, policy, estimator, 60 * GST_SECOND, 2000000);
+  fail_unless_equals_uint64 (decision.target_bitrate, 4000000);
+
+  /* Below the reservoir, the lowest bitrate */
+  decide (abr, &decision, policy, estimator, 5 * GST_SECOND, 2000000);
+  fail_unless_equals_uint64 (decision.target_bitrate, 0);
+
+  /* Falls back to the throughput policy when the buffer level or the
+   * current bitrate are not known */
+  decide (abr, &decision, policy, estimator, GST_CLOCK_TIME_NONE, 2000000);
+  fail_unless_equals_uint64 (decision.target_bitrate, 4000000);
+  decide (abr, &decision, policy, estimator, 15 * GST_SECOND, 0);
+  fail_unless_equals_uint64 (decision.target_bitrate, 4000000);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_hybrid_policy)
+{
+  GstAdaptiveDemuxAbr *abr = gst_adaptive_demux_abr_new ();
+  GstAdaptiveDemuxAbrDecision decision;
+  GstAdaptiveDemuxAbrPolicy policy = GST_ADAPTIVE_DEMUX_ABR_POLICY_HYBRID;
+  GstAdaptiveDemuxBandwidthEstimator estimator =
+      GST_ADAPTIVE_DEMUX_BANDWIDTH_ESTIMATOR_MOVING_AVERAGE;
+
+  gst_adaptive_demux_abr_add_fragment (abr, 5000000);
+
+  /* A full buffer can absorb variations, all of the bandwidth is used */
+  decide (abr, &decision, policy, estimator, 40 * GST_SECOND, 2000000);
+  fail_unless_equals_uint64 (decision.bandwidth, 5000000);
+  fail_unless_equals_uint64 (decision.target_bitrate, 5000000);
+
+  /* About to underrun, half of the usual margin */
+  decide (abr, &decision, policy, estimator, 5 * GST_SECOND, 2000000);
+  fail_unless_equals_uint64 (decision.target_bitrate, 2000000);
+
+  /* In between, somewhere in between */
+  decide (abr, &decision, policy, estimator, 20 * GST_SECOND, 2000000);
+  assert_close (decision.target_bitrate, 3500000);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_END_TEST;
+
+static Suite *
+adaptivedemuxabr_suite (void)
+{
+  Suite *s = suite_create ("adaptivedemuxabr");
+  TCase *tc_chain = tcase_create ("general");
+
+  GST_DEBUG_CATEGORY_INIT (adaptivedemux_debug, "adaptivedemux", 0,
+      "adaptivedemux");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_moving_average);
+  tcase_add_test (tc_chain, test_harmonic_mean);
+  tcase_add_test (tc_chain, test_ewma);
+  tcase_add_test (tc_chain, test_buffer_policy);
+  tcase_add_test (tc_chain, test_hybrid_policy);
+
+  return s;
+}
+
+GST_CHECK_MAIN (adaptivedemuxabr);
@@ -0,0 +1,147 @@
+/* GStreamer
+ *
+ * Unit tests for the stateless decoder base classes, through the null
+ * decoders
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+
+#include "codecsfixtures.h"
+#include "nulldecoders.h"
+
+#define N_FRAMES 8
+
+/* Decodes N_FRAMES copies of an intra-only access unit made of @n_slices
+ * slices (or tiles), which are output in input order with their own
+ * timestamps */
+static void
+check_decode (const gchar * caps, const Chunk * chunks, guint n_chunks,
+    gint width, gint height, guint n_slices)
+{
+  GstHarness *h;
+  GstCaps *src_caps;
+  GstElement *dec;
+  GstBuffer *buffer;
+  NullDecStats *stats;
+  GstVideoInfo info;
+  GstCaps *out_caps;
+  guint i;
+
+  src_caps = gst_caps_from_string (caps);
+  dec = make_null_decoder (src_caps);
+  fail_unless (dec != NULL);
+
+  h = gst_harness_new_with_element (dec, "sink", "src");
+  gst_harness_set_src_caps (h, src_caps);
+
+  for (i = 0; i < N_FRAMES; i++)
+    fail_unless_equals_int (gst_harness_push (h,
+            create_access_unit (chunks, n_chunks, i)), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), N_FRAMES);
+  for (i = 0; i < N_FRAMES; i++) {
+    buffer = gst_harness_pull (h);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer), i * FRAME_DURATION);
+    fail_unless_equals_uint64 (GST_BUFFER_DURATION (buffer), FRAME_DURATION);
+    gst_buffer_unref (buffer);
+  }
+
+  out_caps = gst_pad_get_current_caps (h->sinkpad);
+  fail_unless (gst_video_info_from_caps (&info, out_caps));
+  fail_unless_equals_int (GST_VIDEO_INFO_WIDTH (&info), width);
+  fail_unless_equals_int (GST_VIDEO_INFO_HEIGHT (&info), height);
+  gst_caps_unref (out_caps);
+
+  stats = null_dec_get_stats (dec);
+  fail_unless_equals_uint64 (stats->frames, N_FRAMES);
+  fail_unless_equals_uint64 (stats->pictures, N_FRAMES);
+  fail_unless_equals_uint64 (stats->slices, n_slices * N_FRAMES);
+
+  gst_object_unref (dec);
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_null_h264_dec)
+{
+  check_decode ("video/x-h264, stream-format = (string) byte-stream, "
+      "alignment = (string) au, framerate = (fraction) 25/1",
+      h264_access_unit, G_N_ELEMENTS (h264_access_unit), 128, 128, 2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_null_h265_dec)
+{
+  check_decode ("video/x-h265, stream-format = (string) byte-stream, "
+      "alignment = (string) au, framerate = (fraction) 25/1",
+      h265_access_unit, G_N_ELEMENTS (h265_access_unit), 128, 128, 2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_null_vp9_dec)
+{
+  check_decode ("video/x-vp9, framerate = (fraction) 25/1",
+      vp9_access_unit, G_N_ELEMENTS (vp9_access_unit), 256, 144, 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_null_av1_dec)
+{
+  check_decode ("video/x-av1, stream-format = (string) obu-stream, "
+      "alignment = (string) tu, framerate = (fraction) 25/1",
+      av1_access_unit, G_N_ELEMENTS (av1_access_unit), 16, 16, 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_null_mpeg2_dec)
+{
+  check_decode ("video/mpeg, mpegversion = (int) 2, "
+      "systemstream = (boolean) false, framerate = (fraction) 25/1",
+      mpeg2_access_unit, G_N_ELEMENTS (mpeg2_access_unit), 32, 24, 2);
+}
+
+GST_END_TEST;
+
+static Suite *
+codecs_suite (void)
+{
+  Suite *s = suite_create ("codecs");
+  TCase *tc_chain = tcase_create ("general");
+
+  register_null_decoders ();
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_null_h264_dec);
+  tcase_add_test (tc_chain, test_null_h265_dec);
+  tcase_add_test (tc_chain, test_null_vp9_dec);
+  tcase_add_test (tc_chain, test_null_av1_dec);
+  tcase_add_test (tc_chain, test_null_mpeg2_dec);
+
+  return s;
+}
+
+GST_CHECK_MAIN (codecs);
@@ -0,0 +1,216 @@
+/* GStreamer
+ *
+ * Bitstreams and helpers shared by the tests of the codecs library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __CODECS_FIXTURES_H__
+#define __CODECS_FIXTURES_H__
+
+#include <gst/gst.h>
+
+/* For profile_0_frame0, a 256x144 VP9 key frame */
+#include "../elements/vp9parse.h"
+
+#define FRAME_DURATION (GST_SECOND / 25)
+
+/* A NAL unit, or whatever else an access unit of the codec is made of */
+typedef struct
+{
+  const guint8 *data;
+  gsize size;
+} Chunk;
+
+#define CHUNK(array) { array, sizeof (array) }
+
+/* Generated with:
+ * gst-launch-1.0 videotestsrc num-buffers=1 pattern=green \
+ *     ! video/x-raw,width=128,height=128 \
+ *     ! openh264enc num-slices=2 \
+ *     ! fakesink dump=1
+ */
+
+static const guint8 h264_slicing_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0xc0, 0x0b,
+  0x8c, 0x8d, 0x41, 0x02, 0x24, 0x03, 0xc2, 0x21,
+  0x1a, 0x80
+};
+
+static const guint8 h264_slicing_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x68, 0xce, 0x3c, 0x80
+};
+
+static const guint8 h264_idr_slice_1[] = {
+  0x00, 0x00, 0x00, 0x01, 0x65, 0xb8, 0x00, 0x04,
+  0x00, 0x00, 0x11, 0xff, 0xff, 0xf8, 0x22, 0x8a,
+  0x1f, 0x1c, 0x00, 0x04, 0x0a, 0x63, 0x80, 0x00,
+  0x81, 0xec, 0x9a, 0x93, 0x93, 0x93, 0x93, 0x93,
+  0x93, 0xad, 0x57, 0x5d, 0x75, 0xd7, 0x5d, 0x75,
+  0xd7, 0x5d, 0x75, 0xd7, 0x5d, 0x75, 0xd7, 0x5d,
+  0x75, 0xd7, 0x5d, 0x78
+};
+
+static const guint8 h264_idr_slice_2[] = {
+  0x00, 0x00, 0x00, 0x01, 0x65, 0x04, 0x2e, 0x00,
+  0x01, 0x00, 0x00, 0x04, 0x7f, 0xff, 0xfe, 0x08,
+  0xa2, 0x87, 0xc7, 0x00, 0x01, 0x02, 0x98, 0xe0,
+  0x00, 0x20, 0x7b, 0x26, 0xa4, 0xe4, 0xe4, 0xe4,
+  0xe4, 0xe4, 0xeb, 0x55, 0xd7, 0x5d, 0x75, 0xd7,
+  0x5d, 0x75, 0xd7, 0x5d, 0x75, 0xd7, 0x5d, 0x75,
+  0xd7, 0x5d, 0x75, 0xd7, 0x5e
+};
+
+static const Chunk h264_access_unit[] = {
+  CHUNK (h264_slicing_sps),
+  CHUNK (h264_slicing_pps),
+  CHUNK (h264_idr_slice_1),
+  CHUNK (h264_idr_slice_2),
+};
+
+/* Generated on zynqultrascaleplus with:
+ * gst-launch-1.0 videotestsrc num-buffers=1 pattern=green \
+ *    ! video/x-raw,width=128,height=128 \
+ *    ! omxh265enc num-slices=2 \
+ *    ! fakesink dump=1
+ */
+
+static const guint8 h265_128x128_sliced_vps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01,
+  0xff, 0xff, 0x01, 0x40, 0x00, 0x00, 0x03, 0x00,
+  0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+  0x1e, 0x25, 0x02, 0x40
+};
+
+static const guint8 h265_128x128_sliced_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01,
+  0x40, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00,
+  0x03, 0x00, 0x00, 0x03, 0x00, 0x1e, 0xa0, 0x10,
+  0x20, 0x20, 0x59, 0xe9, 0x6e, 0x44, 0xa1, 0x73,
+  0x50, 0x60, 0x20, 0x2e, 0x10, 0x00, 0x00, 0x03,
+  0x00, 0x10, 0x00, 0x00, 0x03, 0x01, 0xe5, 0x1a,
+  0xff, 0xff, 0x10, 0x3e, 0x80, 0x5d, 0xf7, 0xc2,
+  0x01, 0x04
+};
+
+static const guint8 h265_128x128_sliced_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc0, 0x71,
+  0x81, 0x8d, 0xb2
+};
+
+static const guint8 h265_128x128_slice_1_idr_n_lp[] = {
+  0x00, 0x00, 0x00, 0x01, 0x28, 0x01, 0xac, 0x46,
+  0x13, 0xb6, 0x45, 0x43, 0xaf, 0xee, 0x3d, 0x3f,
+  0x76, 0xe5, 0x73, 0x2f, 0xee, 0xd2, 0xeb, 0xbf,
+  0x80
+};
+
+static const guint8 h265_128x128_slice_2_idr_n_lp[] = {
+  0x00, 0x00, 0x00, 0x01, 0x28, 0x01, 0x30, 0xc4,
+  0x60, 0x13, 0xb6, 0x45, 0x43, 0xaf, 0xee, 0x3d,
+  0x3f, 0x76, 0xe5, 0x73, 0x2f, 0xee, 0xd2, 0xeb,
+  0xbf, 0x80
+};
+
+static const Chunk h265_access_unit[] = {
+  CHUNK (h265_128x128_sliced_vps),
+  CHUNK (h265_128x128_sliced_sps),
+  CHUNK (h265_128x128_sliced_pps),
+  CHUNK (h265_128x128_slice_1_idr_n_lp),
+  CHUNK (h265_128x128_slice_2_idr_n_lp),
+};
+
+static const Chunk vp9_access_unit[] = {
+  CHUNK (profile_0_frame0),
+};
+
+/* The first temporal unit of av1-1-b8-01-size-16x16 from the aom test
+ * vectors: a temporal delimiter, the sequence header and a key frame */
+static const guint8 av1_16x16_key_frame[] = {
+  0x12, 0x00, 0x0a, 0x0a, 0x00, 0x00, 0x00, 0x01,
+  0x9f, 0xfb, 0xff, 0xf3, 0x00, 0x80, 0x32, 0xa6,
+  0x01, 0x10, 0x00, 0x87, 0x80, 0x00, 0x03, 0x00,
+  0x00, 0x00, 0x40, 0x00, 0x9e, 0x86, 0x5b, 0xb2,
+  0x22, 0xb5, 0x58, 0x4d, 0x68, 0xe6, 0x37, 0x54,
+  0x42, 0x7b, 0x84, 0xce, 0xdf, 0x9f, 0xec, 0xab,
+  0x07, 0x4d, 0xf6, 0xe1, 0x5e, 0x9e, 0x27, 0xbf,
+  0x93, 0x2f, 0x47, 0x0d, 0x7b, 0x7c, 0x45, 0x8d,
+  0xcf, 0x26, 0xf7, 0x6c, 0x06, 0xd7, 0x8c, 0x2e,
+  0xf5, 0x2c, 0xb0, 0x8a, 0x31, 0xac, 0x69, 0xf5,
+  0xcd, 0xd8, 0x71, 0x5d, 0xaf, 0xf8, 0x96, 0x43,
+  0x8c, 0x9c, 0x23, 0x6f, 0xab, 0xd0, 0x35, 0x43,
+  0xdf, 0x81, 0x12, 0xe3, 0x7d, 0xec, 0x22, 0xb0,
+  0x30, 0x54, 0x32, 0x9f, 0x90, 0xc0, 0x5d, 0x64,
+  0x9b, 0x0f, 0x75, 0x31, 0x84, 0x3a, 0x57, 0xd7,
+  0x5f, 0x03, 0x6e, 0x7f, 0x43, 0x17, 0x6d, 0x08,
+  0xc3, 0x81, 0x8a, 0xae, 0x73, 0x1c, 0xa8, 0xa7,
+  0xe4, 0x9c, 0xa9, 0x5b, 0x3f, 0xd1, 0xeb, 0x75,
+  0x3a, 0x7f, 0x22, 0x77, 0x38, 0x64, 0x1c, 0x77,
+  0xdb, 0xcd, 0xef, 0xb7, 0x08, 0x45, 0x8e, 0x7f,
+  0xea, 0xa3, 0xd0, 0x81, 0xc9, 0xc1, 0xbc, 0x93,
+  0x9b, 0x41, 0xb1, 0xa1, 0x42, 0x17, 0x98, 0x3f,
+  0x1e, 0x95, 0xdf, 0x68, 0x7c, 0xb7, 0x98
+};
+
+static const Chunk av1_access_unit[] = {
+  CHUNK (av1_16x16_key_frame),
+};
+
+/* From the mpegvideoparse test: 32x24 sequence and GOP headers, and a
+ * two-slice I frame */
+static const guint8 mpeg2_32x24_seq_gop[] = {
+  0x00, 0x00, 0x01, 0xb3, 0x02, 0x00, 0x18, 0x15,
+  0xff, 0xff, 0xe0, 0x28, 0x00, 0x00, 0x01, 0xb5,
+  0x14, 0x8a, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+  0x01, 0xb8, 0x00, 0x08, 0x00, 0x00
+};
+
+static const guint8 mpeg2_32x24_iframe[] = {
+  0x00, 0x00, 0x01, 0x00, 0x00, 0x0f, 0xff, 0xf8,
+  0x00, 0x00, 0x01, 0xb5, 0x8f, 0xff, 0xf3, 0x41,
+  0x80, 0x00, 0x00, 0x01, 0x01, 0x23, 0xf8, 0x7d,
+  0x29, 0x48, 0x8b, 0x94, 0xa5, 0x22, 0x20, 0x00,
+  0x00, 0x01, 0x02, 0x23, 0xf8, 0x7d, 0x29, 0x48,
+  0x8b, 0x94, 0xa5, 0x22, 0x20
+};
+
+static const Chunk mpeg2_access_unit[] = {
+  CHUNK (mpeg2_32x24_seq_gop),
+  CHUNK (mpeg2_32x24_iframe),
+};
+
+/* Wraps @chunks into the @n-th access unit of a FRAME_DURATION spaced
+ * stream */
+static inline GstBuffer *
+create_access_unit (const Chunk * chunks, guint n_chunks, guint n)
+{
+  GstBuffer *buffer = gst_buffer_new ();
+  guint i;
+
+  for (i = 0; i < n_chunks; i++) {
+    gst_buffer_append_memory (buffer,
+        gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+            (gpointer) chunks[i].data, chunks[i].size, 0, chunks[i].size,
+            NULL, NULL));
+  }
+
+  GST_BUFFER_PTS (buffer) = GST_BUFFER_DTS (buffer) = n * FRAME_DURATION;
+  GST_BUFFER_DURATION (buffer) = FRAME_DURATION;
+
+  return buffer;
+}
+
+#endif /* __CODECS_FIXTURES_H__ */
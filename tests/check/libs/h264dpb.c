@@ -0,0 +1,457 @@
+/* GStreamer
+ *
+ * Unit tests for the H.264 decoded picture buffer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/codecs/gsth264picture.h>
+
+static GstH264Picture *
+new_frame (gint32 poc, gint frame_num, GstH264PictureReference ref)
+{
+  GstH264Picture *picture = gst_h264_picture_new ();
+
+  picture->pic_order_cnt = poc;
+  picture->frame_num = picture->frame_num_wrap = picture->pic_num = frame_num;
+  picture->ref = ref;
+
+  return picture;
+}
+
+static GstH264Picture *
+new_field (gint32 poc, GstH264PictureField field, GstH264Picture * first)
+{
+  GstH264Picture *picture = new_frame (poc, 0, GST_H264_PICTURE_REF_NONE);
+
+  picture->field = field;
+  if (first) {
+    picture->second_field = TRUE;
+    picture->other_field = first;
+  }
+
+  return picture;
+}
+
+/* Adds @picture then outputs what the DPB wants to, appending the POCs to
+ * @output */
+static void
+add_and_bump (GstH264Dpb * dpb, GstH264Picture * picture,
+    guint32 max_num_reorder_frames, gboolean low_latency, GArray * output)
+{
+  gst_h264_dpb_add (dpb, picture);
+
+  while (gst_h264_dpb_needs_bump (dpb, max_num_reorder_frames, low_latency)) {
+    GstH264Picture *out = gst_h264_dpb_bump (dpb, FALSE);
+
+    fail_unless (out != NULL);
+    g_array_append_val (output, out->pic_order_cnt);
+    gst_h264_picture_unref (out);
+  }
+
+  gst_h264_dpb_delete_unused (dpb);
+}
+
+/* Outputs all remaining pictures then drops the reference ones, as the
+ * decoder does */
+static void
+drain (GstH264Dpb * dpb, GArray * output)
+{
+  GstH264Picture *out;
+
+  while ((out = gst_h264_dpb_bump (dpb, TRUE))) {
+    g_array_append_val (output, out->pic_order_cnt);
+    gst_h264_picture_unref (out);
+  }
+
+  gst_h264_dpb_clear (dpb);
+}
+
+static void
+assert_output (GArray * output, const gint32 * expected, guint n_expected)
+{
+  guint i;
+
+  fail_unless_equals_int (output->len, n_expected);
+  for (i = 0; i < n_expected; i++)
+    fail_unless_equals_int (g_array_index (output, gint32, i), expected[i]);
+
+  g_array_set_size (output, 0);
+}
+
+GST_START_TEST (test_h264_dpb_bump_order)
+{
+  GstH264Dpb *dpb = gst_h264_dpb_new ();
+  GArray *output = g_array_new (FALSE, FALSE, sizeof (gint32));
+  const gint32 pocs[] = { 0, 8, 4, 2, 6, 16, 12, 10, 14 };
+  const gint32 expected[] = { 0, 2, 4, 6, 8, 10, 12, 14, 16 };
+  const gint32 expected_dups[] = { 20, 20, 22 };
+  GstH264Picture *picture;
+  guint i;
+
+  gst_h264_dpb_set_max_num_frames (dpb, 4);
+
+  /* Reference pictures stay in the DPB after output, non-reference ones
+   * are removed right away */
+  for (i = 0; i < G_N_ELEMENTS (pocs); i++) {
+    picture = new_frame (pocs[i], i, i % 4 == 0 ?
+        GST_H264_PICTURE_REF_SHORT_TERM : GST_H264_PICTURE_REF_NONE);
+    add_and_bump (dpb, picture, 2, FALSE, output);
+    fail_unless (gst_h264_dpb_get_size (dpb) <= 4);
+  }
+
+  drain (dpb, output);
+  assert_output (output, expected, G_N_ELEMENTS (expected));
+
+  /* Pictures with the same POC come out in the order they were added */
+  for (i = 0; i < 3; i++) {
+    picture = new_frame (i == 2 ? 22 : 20, i, GST_H264_PICTURE_REF_NONE);
+    picture->system_frame_number = i;
+    gst_h264_dpb_add (dpb, picture);
+  }
+
+  for (i = 0; i < 3; i++) {
+    picture = gst_h264_dpb_bump (dpb, TRUE);
+    fail_unless_equals_int (picture->system_frame_number, i);
+    g_array_append_val (output, picture->pic_order_cnt);
+    gst_h264_picture_unref (picture);
+  }
+  fail_unless (gst_h264_dpb_bump (dpb, TRUE) == NULL);
+  assert_output (output, expected_dups, G_N_ELEMENTS (expected_dups));
+
+  g_array_unref (output);
+  gst_h264_dpb_free (dpb);
+}
+
+GST_END_TEST;
+
+/* 8.2.5.3 with max_num_ref_frames 3: reference pictures which have been
+ * output and then unmarked must leave the DPB, and lookups must not
+ * return them anymore */
+GST_START_TEST (test_h264_dpb_sliding_window)
+{
+  GstH264Dpb *dpb = gst_h264_dpb_new ();
+  GArray *output = g_array_new (FALSE, FALSE, sizeof (gint32));
+  GArray *refs = g_array_new (FALSE, FALSE, sizeof (GstH264Picture *));
+  GstH264Picture *picture;
+  gint i;
+
+  g_array_set_clear_func (refs, (GDestroyNotify) gst_h264_picture_clear);
+  gst_h264_dpb_set_max_num_frames (dpb, 4);
+
+  for (i = 0; i < 10; i++) {
+    if (gst_h264_dpb_num_ref_frames (dpb) >= 3) {
+      GstH264Picture *to_unmark =
+          gst_h264_dpb_get_lowest_frame_num_short_ref (dpb);
+
+      fail_unless (to_unmark != NULL);
+      fail_unless_equals_int (to_unmark->frame_num, i - 3);
+      to_unmark->ref = GST_H264_PICTURE_REF_NONE;
+      gst_h264_picture_unref (to_unmark);
+    }
+
+    picture = new_frame (2 * i, i, GST_H264_PICTURE_REF_SHORT_TERM);
+    add_and_bump (dpb, picture, 0, FALSE, output);
+
+    fail_unless_equals_int (output->len, i + 1);
+    fail_unless_equals_int (gst_h264_dpb_num_ref_frames (dpb), MIN (i + 1, 3));
+    fail_unless_equals_int (gst_h264_dpb_get_size (dpb), MIN (i + 1, 3));
+  }
+
+  /* Only frame_num 7, 8 and 9 are left */
+  fail_unless (gst_h264_dpb_get_short_ref_by_pic_num (dpb, 6) == NULL);
+  for (i = 7; i < 10; i++) {
+    picture = gst_h264_dpb_get_short_ref_by_pic_num (dpb, i);
+    fail_unless (picture != NULL);
+    fail_unless_equals_int (picture->pic_order_cnt, 2 * i);
+  }
+
+  gst_h264_dpb_get_pictures_short_term_ref (dpb, FALSE, FALSE, refs);
+  fail_unless_equals_int (refs->len, 3);
+  g_array_set_size (refs, 0);
+
+  gst_h264_dpb_get_pictures_long_term_ref (dpb, FALSE, refs);
+  fail_unless_equals_int (refs->len, 0);
+
+  gst_h264_dpb_mark_all_non_ref (dpb);
+  fail_unless_equals_int (gst_h264_dpb_num_ref_frames (dpb), 0);
+  fail_unless (gst_h264_dpb_get_lowest_frame_num_short_ref (dpb) == NULL);
+  gst_h264_dpb_delete_unused (dpb);
+  fail_unless_equals_int (gst_h264_dpb_get_size (dpb), 0);
+
+  g_array_unref (refs);
+  g_array_unref (output);
+  gst_h264_dpb_free (dpb);
+}
+
+GST_END_TEST;
+
+static void
+mmco (GstH264Dpb * dpb, GstH264Picture * picture, guint8 type,
+    guint32 value)
+{
+  GstH264RefPicMarking marking = { 0, };
+
+  marking.memory_management_control_operation = type;
+  switch (type) {
+    case 1:
+      marking.difference_of_pic_nums_minus1 = value;
+      break;
+    case 2:
+      marking.long_term_pic_num = value;
+      break;
+    case 4:
+      marking.max_long_term_frame_idx_plus1 = value;
+      break;
+    case 6:
+      marking.long_term_frame_idx = value;
+      break;
+    default:
+      break;
+  }
+
+  fail_unless (gst_h264_dpb_perform_memory_management_control_operation (dpb,
+          &marking, picture));
+}
+
+static gint
+count_long_term_refs (GstH264Dpb * dpb)
+{
+  GArray *refs = g_array_new (FALSE, FALSE, sizeof (GstH264Picture *));
+  gint n;
+
+  g_array_set_clear_func (refs, (GDestroyNotify) gst_h264_picture_clear);
+  gst_h264_dpb_get_pictures_long_term_ref (dpb, TRUE, refs);
+  n = refs->len;
+  g_array_unref (refs);
+
+  return n;
+}
+
+/* 8.2.5.4 adaptive reference picture marking */
+GST_START_TEST (test_h264_dpb_mmco)
+{
+  GstH264Dpb *dpb = gst_h264_dpb_new ();
+  GArray *output = g_array_new (FALSE, FALSE, sizeof (gint32));
+  GstH264RefPicMarking marking = { 0, };
+  GstH264Picture *picture, *current;
+  GArray *all;
+  gint i;
+
+  gst_h264_dpb_set_max_num_frames (dpb, 8);
+
+  for (i = 0; i < 4; i++) {
+    picture = new_frame (2 * i, i, GST_H264_PICTURE_REF_SHORT_TERM);
+    add_and_bump (dpb, picture, 0, FALSE, output);
+  }
+  fail_unless_equals_int (gst_h264_dpb_num_ref_frames (dpb), 4);
+
+  current = new_frame (8, 4, GST_H264_PICTURE_REF_SHORT_TERM);
+
+  /* MMCO-1: picNumX = 4 - (0 + 1) */
+  mmco (dpb, current, 1, 0);
+  fail_unless (gst_h264_dpb_get_short_ref_by_pic_num (dpb, 3) == NULL);
+  fail_unless_equals_int (gst_h264_dpb_num_ref_frames (dpb), 3);
+
+  /* MMCO-3: picNumX = 4 - (3 + 1) becomes LongTermFrameIdx 0 */
+  marking.memory_management_control_operation = 3;
+  marking.difference_of_pic_nums_minus1 = 3;
+  marking.long_term_frame_idx = 0;
+  fail_unless (gst_h264_dpb_perform_memory_management_control_operation (dpb,
+          &marking, current));
+  fail_unless (gst_h264_dpb_get_short_ref_by_pic_num (dpb, 0) == NULL);
+  fail_unless_equals_int (gst_h264_dpb_num_ref_frames (dpb), 3);
+  fail_unless_equals_int (count_long_term_refs (dpb), 1);
+
+  /* The decoder derives LongTermPicNum before each picture */
+  all = gst_h264_dpb_get_pictures_all (dpb);
+  for (i = 0; i < all->len; i++) {
+    picture = g_array_index (all, GstH264Picture *, i);
+    if (GST_H264_PICTURE_IS_LONG_TERM_REF (picture))
+      picture->long_term_pic_num = picture->long_term_frame_idx;
+  }
+  g_array_unref (all);
+
+  picture = gst_h264_dpb_get_long_ref_by_long_term_pic_num (dpb, 0);
+  fail_unless (picture != NULL);
+  fail_unless_equals_int (picture->pic_order_cnt, 0);
+
+  /* MMCO-2 unmarks it again */
+  mmco (dpb, current, 2, 0);
+  fail_unless (gst_h264_dpb_get_long_ref_by_long_term_pic_num (dpb, 0) ==
+      NULL);
+  fail_unless_equals_int (count_long_term_refs (dpb), 0);
+  fail_unless_equals_int (gst_h264_dpb_num_ref_frames (dpb), 2);
+
+  /* MMCO-6 makes the current picture a long-term one */
+  mmco (dpb, current, 6, 1);
+  fail_unless (GST_H264_PICTURE_IS_LONG_TERM_REF (current));
+  fail_unless_equals_int (current->long_term_frame_idx, 1);
+  add_and_bump (dpb, current, 0, FALSE, output);
+  fail_unless_equals_int (count_long_term_refs (dpb), 1);
+  fail_unless_equals_int (gst_h264_dpb_num_ref_frames (dpb), 3);
+
+  current = new_frame (10, 5, GST_H264_PICTURE_REF_SHORT_TERM);
+
+  /* MMCO-4 with MaxLongTermFrameIdx 0 drops LongTermFrameIdx 1 */
+  mmco (dpb, current, 4, 1);
+  fail_unless_equals_int (count_long_term_refs (dpb), 0);
+  fail_unless_equals_int (gst_h264_dpb_num_ref_frames (dpb), 2);
+
+  /* MMCO-5 unmarks everything and requests output of prior pictures */
+  mmco (dpb, current, 5, 0);
+  fail_unless (current->mem_mgmt_5);
+  fail_unless_equals_int (current->frame_num, 0);
+  fail_unless_equals_int (gst_h264_dpb_num_ref_frames (dpb), 0);
+
+  gst_h264_dpb_delete_unused (dpb);
+  fail_unless_equals_int (gst_h264_dpb_get_size (dpb), 0);
+  gst_h264_picture_unref (current);
+
+  fail_unless_equals_int (output->len, 5);
+
+  g_array_unref (output);
+  gst_h264_dpb_free (dpb);
+}
+
+GST_END_TEST;
+
+/* In low-latency mode, a picture is output as soon as its POC follows the
+ * last output one by 2 at most, instead of once max_num_reorder_frames is
+ * exceeded */
+GST_START_TEST (test_h264_dpb_low_latency)
+{
+  GstH264Dpb *dpb = gst_h264_dpb_new ();
+  GArray *output = g_array_new (FALSE, FALSE, sizeof (gint32));
+  const gint32 pocs[] = { 0, 4, 2, 6, 10, 8 };
+  const guint n_output[] = { 1, 1, 3, 4, 4, 6 };
+  const guint n_output_reorder[] = { 1, 1, 1, 1, 1, 2 };
+  const gint32 expected[] = { 0, 2, 4, 6, 8, 10 };
+  GstH264Picture *picture;
+  guint i;
+
+  gst_h264_dpb_set_max_num_frames (dpb, 8);
+
+  /* The IDR is output right away, which gives the first POC to follow */
+  for (i = 0; i < G_N_ELEMENTS (pocs); i++) {
+    picture = new_frame (pocs[i], i, GST_H264_PICTURE_REF_NONE);
+    picture->idr = i == 0;
+    add_and_bump (dpb, picture, 4, TRUE, output);
+    fail_unless_equals_int (output->len, n_output[i]);
+  }
+
+  drain (dpb, output);
+  assert_output (output, expected, G_N_ELEMENTS (expected));
+
+  /* The same stream, waiting for reordering */
+  for (i = 0; i < G_N_ELEMENTS (pocs); i++) {
+    picture = new_frame (pocs[i], i, GST_H264_PICTURE_REF_NONE);
+    picture->idr = i == 0;
+    add_and_bump (dpb, picture, 4, FALSE, output);
+    fail_unless_equals_int (output->len, n_output_reorder[i]);
+  }
+
+  drain (dpb, output);
+  assert_output (output, expected, G_N_ELEMENTS (expected));
+
+  g_array_unref (output);
+  gst_h264_dpb_free (dpb);
+}
+
+GST_END_TEST;
+
+/* Field pairs are output once complete, through their first field, in POC
+ * order */
+GST_START_TEST (test_h264_dpb_field_pairs)
+{
+  GstH264Dpb *dpb = gst_h264_dpb_new ();
+  GArray *output = g_array_new (FALSE, FALSE, sizeof (gint32));
+  const gint32 expected[] = { 3, 5 };
+  GstH264Picture *first, *second, *out;
+
+  gst_h264_dpb_set_max_num_frames (dpb, 2);
+  gst_h264_dpb_set_interlaced (dpb, TRUE);
+
+  /* Top field first */
+  first = new_field (0, GST_H264_PICTURE_FIELD_TOP_FIELD, NULL);
+  gst_h264_dpb_add (dpb, first);
+  fail_if (gst_h264_dpb_needs_bump (dpb, 0, FALSE));
+
+  second = new_field (1, GST_H264_PICTURE_FIELD_BOTTOM_FIELD, first);
+  gst_h264_dpb_add (dpb, second);
+  fail_unless (first->other_field == second);
+  fail_unless (gst_h264_dpb_needs_bump (dpb, 0, FALSE));
+
+  out = gst_h264_dpb_bump (dpb, FALSE);
+  fail_unless (out == first);
+  fail_unless (out->buffer_flags & GST_VIDEO_BUFFER_FLAG_INTERLACED);
+  fail_unless (out->buffer_flags & GST_VIDEO_BUFFER_FLAG_TFF);
+  gst_h264_picture_unref (out);
+
+  /* Both non-reference fields left the DPB */
+  fail_unless_equals_int (gst_h264_dpb_get_size (dpb), 0);
+  fail_if (gst_h264_dpb_needs_bump (dpb, 0, FALSE));
+
+  /* Bottom field first, and pairs added out of POC order */
+  first = new_field (5, GST_H264_PICTURE_FIELD_BOTTOM_FIELD, NULL);
+  gst_h264_dpb_add (dpb, first);
+  second = new_field (4, GST_H264_PICTURE_FIELD_TOP_FIELD, first);
+  gst_h264_dpb_add (dpb, second);
+
+  first = new_field (3, GST_H264_PICTURE_FIELD_BOTTOM_FIELD, NULL);
+  gst_h264_dpb_add (dpb, first);
+  fail_unless_equals_int (gst_h264_dpb_get_size (dpb), 3);
+  second = new_field (2, GST_H264_PICTURE_FIELD_TOP_FIELD, first);
+  gst_h264_dpb_add (dpb, second);
+
+  out = gst_h264_dpb_bump (dpb, FALSE);
+  fail_unless (out == first);
+  fail_unless (out->buffer_flags & GST_VIDEO_BUFFER_FLAG_INTERLACED);
+  fail_if (out->buffer_flags & GST_VIDEO_BUFFER_FLAG_TFF);
+  g_array_append_val (output, out->pic_order_cnt);
+  gst_h264_picture_unref (out);
+
+  drain (dpb, output);
+  assert_output (output, expected, G_N_ELEMENTS (expected));
+
+  g_array_unref (output);
+  gst_h264_dpb_free (dpb);
+}
+
+GST_END_TEST;
+
+static Suite *
+h264dpb_suite (void)
+{
+  Suite *s = suite_create ("H.264 DPB");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_h264_dpb_bump_order);
+  tcase_add_test (tc_chain, test_h264_dpb_sliding_window);
+  tcase_add_test (tc_chain, test_h264_dpb_mmco);
+  tcase_add_test (tc_chain, test_h264_dpb_low_latency);
+  tcase_add_test (tc_chain, test_h264_dpb_field_pairs);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h264dpb);
@@ -0,0 +1,692 @@
+/* GStreamer
+ *
+ * Unit tests for the pipelined mode of the H.265 decoder base class
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/codecs/gsth265decoder.h>
+
+#include "codecsfixtures.h"
+
+#define N_FRAMES 16
+#define PIPELINE_DEPTH 4
+
+/* A hand-made stream of one-slice pictures, decoded in the order
+ * I0 P2 B1 P4 B3 P6 B5 P8 B7. The P pictures reference the two previous
+ * ones, and the B pictures the surrounding ones, in both of their reference
+ * picture lists. The slice data is not valid, only the headers are. */
+
+static const guint8 h265_128x128_bframes_vps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01,
+  0xff, 0xff, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00,
+  0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+  0x3c, 0x91, 0x40, 0x90
+};
+
+static const guint8 h265_128x128_bframes_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01,
+  0x60, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00,
+  0x03, 0x00, 0x00, 0x03, 0x00, 0x3c, 0xa0, 0x10,
+  0x20, 0x20, 0x59, 0x64, 0x5a, 0xb4, 0x82, 0x08
+};
+
+static const guint8 h265_128x128_bframes_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc0, 0x71,
+  0x80, 0x12
+};
+
+static const guint8 h265_128x128_bframes_idr_poc0[] = {
+  0x00, 0x00, 0x00, 0x01, 0x28, 0x01, 0xaf, 0xaf,
+  0xfe, 0x80
+};
+
+static const guint8 h265_128x128_bframes_p_poc2[] = {
+  0x00, 0x00, 0x00, 0x01, 0x02, 0x01, 0xd0, 0x11,
+  0x55, 0xc0, 0xaf, 0xfe, 0x80
+};
+
+static const guint8 h265_128x128_bframes_b_poc1[] = {
+  0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0xe0, 0x24,
+  0xbe, 0x93, 0x80, 0xaf, 0xfe, 0x80
+};
+
+static const guint8 h265_128x128_bframes_p_poc4[] = {
+  0x00, 0x00, 0x00, 0x01, 0x02, 0x01, 0xd0, 0x21,
+  0xd5, 0x6b, 0x80, 0xaf, 0xfe, 0x80
+};
+
+static const guint8 h265_128x128_bframes_b_poc3[] = {
+  0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0xe0, 0x64,
+  0xbe, 0x93, 0x80, 0xaf, 0xfe, 0x80
+};
+
+static const guint8 h265_128x128_bframes_p_poc6[] = {
+  0x00, 0x00, 0x00, 0x01, 0x02, 0x01, 0xd0, 0x31,
+  0xd5, 0x6b, 0x80, 0xaf, 0xfe, 0x80
+};
+
+static const guint8 h265_128x128_bframes_b_poc5[] = {
+  0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0xe0, 0xa4,
+  0xbe, 0x93, 0x80, 0xaf, 0xfe, 0x80
+};
+
+static const guint8 h265_128x128_bframes_p_poc8[] = {
+  0x00, 0x00, 0x00, 0x01, 0x02, 0x01, 0xd0, 0x41,
+  0xd5, 0x6b, 0x80, 0xaf, 0xfe, 0x80
+};
+
+static const guint8 h265_128x128_bframes_b_poc7[] = {
+  0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0xe0, 0xe4,
+  0xbe, 0x93, 0x80, 0xaf, 0xfe, 0x80
+};
+
+typedef struct
+{
+  const guint8 *data;
+  gsize size;
+  gint poc;
+  /* the POCs of the pictures in RefPicList0 and RefPicList1 */
+  const gchar *ref_pic_lists;
+} BFramesPicture;
+
+#define BFRAMES_PICTURE(array, poc, lists) \
+  { array, sizeof (array), poc, lists }
+
+static const BFramesPicture h265_128x128_bframes[] = {
+  BFRAMES_PICTURE (h265_128x128_bframes_idr_poc0, 0, ", l0, l1"),
+  BFRAMES_PICTURE (h265_128x128_bframes_p_poc2, 2, ", l0 0, l1"),
+  BFRAMES_PICTURE (h265_128x128_bframes_b_poc1, 1, ", l0 0 2, l1 2 0"),
+  BFRAMES_PICTURE (h265_128x128_bframes_p_poc4, 4, ", l0 2 0, l1"),
+  BFRAMES_PICTURE (h265_128x128_bframes_b_poc3, 3, ", l0 2 4, l1 4 2"),
+  BFRAMES_PICTURE (h265_128x128_bframes_p_poc6, 6, ", l0 4 2, l1"),
+  BFRAMES_PICTURE (h265_128x128_bframes_b_poc5, 5, ", l0 4 6, l1 6 4"),
+  BFRAMES_PICTURE (h265_128x128_bframes_p_poc8, 8, ", l0 6 4, l1"),
+  BFRAMES_PICTURE (h265_128x128_bframes_b_poc7, 7, ", l0 6 8, l1 8 6"),
+};
+
+/* GstTestH265Dec, a subclass which checks from which thread each vfunc is
+ * called, and how many pictures are alive */
+
+#define GST_TYPE_TEST_H265_DEC (gst_test_h265_dec_get_type ())
+G_DECLARE_FINAL_TYPE (GstTestH265Dec, gst_test_h265_dec, GST, TEST_H265_DEC,
+    GstH265Decoder);
+
+struct _GstTestH265Dec
+{
+  GstH265Decoder parent;
+
+  /* The thread pushing the input */
+  GThread *streaming_thread;
+  /* The thread start_picture(), decode_slice() and end_picture() are called
+   * from */
+  GThread *submit_thread;
+  gboolean wrong_thread;
+
+  gulong submit_delay;
+  /* decode_slice() fails for the picture of that frame */
+  gint fail_frame;
+  gint n_slices;
+  gint n_pictures_alive;
+
+  /* What start_picture() and decode_slice() got to see, in decoding order,
+   * and the pictures output_picture() got, in output order */
+  GString *decode_log;
+  GString *output_log;
+};
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-h265, stream-format = (string) byte-stream, "
+        "alignment = (string) au"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("GRAY8")));
+
+G_DEFINE_TYPE (GstTestH265Dec, gst_test_h265_dec, GST_TYPE_H265_DECODER);
+
+static void
+check_streaming_thread (GstTestH265Dec * self)
+{
+  if (g_thread_self () != self->streaming_thread)
+    self->wrong_thread = TRUE;
+}
+
+/* Only ever called from one thread at a time */
+static void
+check_submit_thread (GstTestH265Dec * self)
+{
+  if (!self->submit_thread)
+    self->submit_thread = g_thread_self ();
+  else if (g_thread_self () != self->submit_thread)
+    self->wrong_thread = TRUE;
+}
+
+static void
+picture_destroyed (gint * n_pictures_alive)
+{
+  g_atomic_int_add (n_pictures_alive, -1);
+}
+
+static gboolean
+gst_test_h265_dec_new_sequence (GstH265Decoder * decoder,
+    const GstH265SPS * sps, gint max_dpb_size)
+{
+  GstTestH265Dec *self = GST_TEST_H265_DEC (decoder);
+  GstVideoCodecState *state;
+
+  check_streaming_thread (self);
+
+  state = gst_video_decoder_set_output_state (GST_VIDEO_DECODER (decoder),
+      GST_VIDEO_FORMAT_GRAY8, sps->width, sps->height, decoder->input_state);
+  gst_video_codec_state_unref (state);
+
+  return TRUE;
+}
+
+static gboolean
+gst_test_h265_dec_new_picture (GstH265Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH265Picture * picture)
+{
+  GstTestH265Dec *self = GST_TEST_H265_DEC (decoder);
+
+  check_streaming_thread (self);
+
+  g_atomic_int_inc (&self->n_pictures_alive);
+  gst_h265_picture_set_user_data (picture, &self->n_pictures_alive,
+      (GDestroyNotify) picture_destroyed);
+
+  return TRUE;
+}
+
+static gboolean
+gst_test_h265_dec_start_picture (GstH265Decoder * decoder,
+    GstH265Picture * picture, GstH265Slice * slice, GstH265Dpb * dpb)
+{
+  GstTestH265Dec *self = GST_TEST_H265_DEC (decoder);
+  GArray *pictures;
+  guint i;
+
+  check_submit_thread (self);
+
+  g_string_append_printf (self->decode_log, "poc %d, dpb",
+      picture->pic_order_cnt);
+  pictures = gst_h265_dpb_get_pictures_all (dpb);
+  for (i = 0; i < pictures->len; i++) {
+    GstH265Picture *other = g_array_index (pictures, GstH265Picture *, i);
+
+    g_string_append_printf (self->decode_log, " %d%s%s%s",
+        other->pic_order_cnt, other->ref ? "r" : "",
+        other->long_term ? "l" : "", other->needed_for_output ? "o" : "");
+  }
+  g_array_unref (pictures);
+
+  return TRUE;
+}
+
+static void
+log_ref_pic_list (GString * log, const gchar * name, GArray * ref_pic_list)
+{
+  guint i;
+
+  g_string_append_printf (log, ", %s", name);
+  for (i = 0; ref_pic_list && i < ref_pic_list->len; i++) {
+    GstH265Picture *ref = g_array_index (ref_pic_list, GstH265Picture *, i);
+
+    g_string_append_printf (log, " %d", ref ? ref->pic_order_cnt : -1);
+  }
+}
+
+static gboolean
+gst_test_h265_dec_decode_slice (GstH265Decoder * decoder,
+    GstH265Picture * picture, GstH265Slice * slice, GArray * ref_pic_list0,
+    GArray * ref_pic_list1)
+{
+  GstTestH265Dec *self = GST_TEST_H265_DEC (decoder);
+
+  check_submit_thread (self);
+  g_atomic_int_inc (&self->n_slices);
+
+  log_ref_pic_list (self->decode_log, "l0", ref_pic_list0);
+  log_ref_pic_list (self->decode_log, "l1", ref_pic_list1);
+
+  if ((gint) picture->system_frame_number == self->fail_frame)
+    return FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_test_h265_dec_end_picture (GstH265Decoder * decoder,
+    GstH265Picture * picture)
+{
+  GstTestH265Dec *self = GST_TEST_H265_DEC (decoder);
+
+  check_submit_thread (self);
+  g_string_append_c (self->decode_log, '\n');
+
+  /* Keeps pictures in flight for a while */
+  if (self->submit_delay)
+    g_usleep (self->submit_delay);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_test_h265_dec_output_picture (GstH265Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH265Picture * picture)
+{
+  GstTestH265Dec *self = GST_TEST_H265_DEC (decoder);
+  GstVideoDecoder *vdec = GST_VIDEO_DECODER (decoder);
+  GstFlowReturn ret;
+
+  check_streaming_thread (self);
+
+  g_string_append_printf (self->output_log, " %d", picture->pic_order_cnt);
+  gst_h265_picture_unref (picture);
+
+  ret = gst_video_decoder_allocate_output_frame (vdec, frame);
+  if (ret != GST_FLOW_OK) {
+    gst_video_decoder_drop_frame (vdec, frame);
+    return ret;
+  }
+
+  return gst_video_decoder_finish_frame (vdec, frame);
+}
+
+static void
+gst_test_h265_dec_finalize (GObject * object)
+{
+  GstTestH265Dec *self = GST_TEST_H265_DEC (object);
+
+  g_string_free (self->decode_log, TRUE);
+  g_string_free (self->output_log, TRUE);
+
+  G_OBJECT_CLASS (gst_test_h265_dec_parent_class)->finalize (object);
+}
+
+static void
+gst_test_h265_dec_class_init (GstTestH265DecClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstH265DecoderClass *h265decoder_class = GST_H265_DECODER_CLASS (klass);
+
+  gst_element_class_set_static_metadata (element_class,
+      "Test H.265 Decoder", "Codec/Decoder/Video",
+      "H.265 decoder base class test helper", "GStreamer developers");
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+
+  object_class->finalize = gst_test_h265_dec_finalize;
+
+  h265decoder_class->new_sequence = gst_test_h265_dec_new_sequence;
+  h265decoder_class->new_picture = gst_test_h265_dec_new_picture;
+  h265decoder_class->start_picture = gst_test_h265_dec_start_picture;
+  h265decoder_class->decode_slice = gst_test_h265_dec_decode_slice;
+  h265decoder_class->end_picture = gst_test_h265_dec_end_picture;
+  h265decoder_class->output_picture = gst_test_h265_dec_output_picture;
+}
+
+static void
+gst_test_h265_dec_init (GstTestH265Dec * self)
+{
+  self->fail_frame = -1;
+  self->decode_log = g_string_new (NULL);
+  self->output_log = g_string_new (NULL);
+
+  gst_h265_decoder_set_process_ref_pic_lists (GST_H265_DECODER (self), TRUE);
+}
+
+/* Tests */
+
+static GstHarness *
+setup_decoder (guint depth, gulong submit_delay)
+{
+  GstTestH265Dec *dec = g_object_new (GST_TYPE_TEST_H265_DEC, NULL);
+  GstHarness *h;
+
+  dec->streaming_thread = g_thread_self ();
+  dec->submit_delay = submit_delay;
+  gst_h265_decoder_set_pipeline_depth (GST_H265_DECODER (dec), depth);
+
+  h = gst_harness_new_with_element (GST_ELEMENT (dec), "sink", "src");
+  gst_object_unref (dec);
+  gst_harness_set_src_caps_str (h, "video/x-h265, "
+      "stream-format = (string) byte-stream, alignment = (string) au, "
+      "framerate = (fraction) 25/1");
+
+  return h;
+}
+
+/* An access unit of the B frames stream, with the parameter sets in the
+ * first one. Timestamped according to the picture order count. */
+static GstBuffer *
+create_bframes_access_unit (guint n)
+{
+  const BFramesPicture *picture = &h265_128x128_bframes[n];
+  GstBuffer *buffer = gst_buffer_new ();
+
+#define APPEND(data, size) \
+  gst_buffer_append_memory (buffer, gst_memory_new_wrapped ( \
+          GST_MEMORY_FLAG_READONLY, (gpointer) data, size, 0, size, NULL, \
+          NULL))
+  if (n == 0) {
+    APPEND (h265_128x128_bframes_vps, sizeof (h265_128x128_bframes_vps));
+    APPEND (h265_128x128_bframes_sps, sizeof (h265_128x128_bframes_sps));
+    APPEND (h265_128x128_bframes_pps, sizeof (h265_128x128_bframes_pps));
+  }
+  APPEND (picture->data, picture->size);
+#undef APPEND
+
+  GST_BUFFER_PTS (buffer) = picture->poc * FRAME_DURATION;
+  GST_BUFFER_DTS (buffer) = n * FRAME_DURATION;
+  GST_BUFFER_DURATION (buffer) = FRAME_DURATION;
+
+  return buffer;
+}
+
+/* Pushes access units with the parameter sets and the two slices of an IDR
+ * picture. Every IDR bumps the previous picture out of the DPB */
+static void
+push_access_units (GstHarness * h, guint first, guint n)
+{
+  guint i;
+
+  for (i = first; i < first + n; i++)
+    fail_unless_equals_int (gst_harness_push (h,
+            create_access_unit (h265_access_unit,
+                G_N_ELEMENTS (h265_access_unit), i)), GST_FLOW_OK);
+}
+
+static GList *
+pull_all (GstHarness * h)
+{
+  GList *buffers = NULL;
+  GstBuffer *buffer;
+
+  while ((buffer = gst_harness_try_pull (h)))
+    buffers = g_list_append (buffers, buffer);
+
+  return buffers;
+}
+
+/* Once drained, all the pictures and frames are released */
+static void
+assert_drained (GstHarness * h)
+{
+  GstTestH265Dec *dec = GST_TEST_H265_DEC (h->element);
+  GList *frames;
+
+  frames = gst_video_decoder_get_frames (GST_VIDEO_DECODER (dec));
+  fail_unless_equals_int (g_list_length (frames), 0);
+  g_list_free_full (frames, (GDestroyNotify) gst_video_codec_frame_unref);
+
+  fail_unless_equals_int (g_atomic_int_get (&dec->n_pictures_alive), 0);
+}
+
+static void
+assert_threads (GstHarness * h, gboolean pipelined)
+{
+  GstTestH265Dec *dec = GST_TEST_H265_DEC (h->element);
+
+  fail_if (dec->wrong_thread);
+  fail_unless (dec->submit_thread != NULL);
+  if (pipelined)
+    fail_unless (dec->submit_thread != dec->streaming_thread);
+  else
+    fail_unless (dec->submit_thread == dec->streaming_thread);
+}
+
+static GList *
+decode (guint depth, gulong submit_delay)
+{
+  GstHarness *h = setup_decoder (depth, submit_delay);
+  GList *buffers;
+
+  push_access_units (h, 0, N_FRAMES);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+  buffers = pull_all (h);
+
+  fail_unless_equals_int (g_atomic_int_get (&GST_TEST_H265_DEC
+          (h->element)->n_slices), 2 * N_FRAMES);
+  assert_threads (h, depth > 0);
+  assert_drained (h);
+  gst_harness_teardown (h);
+
+  return buffers;
+}
+
+/* Decodes the B frames stream, checks that it is output in presentation
+ * order and returns what the subclass got to see */
+static void
+decode_bframes (guint depth, gulong submit_delay, gchar ** decode_log,
+    gchar ** output_log)
+{
+  GstHarness *h = setup_decoder (depth, submit_delay);
+  GstTestH265Dec *dec = GST_TEST_H265_DEC (h->element);
+  GList *buffers, *l;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (h265_128x128_bframes); i++)
+    fail_unless_equals_int (gst_harness_push (h,
+            create_bframes_access_unit (i)), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  buffers = pull_all (h);
+  fail_unless_equals_int (g_list_length (buffers),
+      G_N_ELEMENTS (h265_128x128_bframes));
+  for (l = buffers, i = 0; l; l = l->next, i++)
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (l->data), i * FRAME_DURATION);
+  g_list_free_full (buffers, (GDestroyNotify) gst_buffer_unref);
+
+  fail_unless_equals_int (g_atomic_int_get (&dec->n_slices),
+      G_N_ELEMENTS (h265_128x128_bframes));
+  assert_threads (h, depth > 0);
+  assert_drained (h);
+
+  *decode_log = g_strdup (dec->decode_log->str);
+  *output_log = g_strdup (dec->output_log->str);
+  gst_harness_teardown (h);
+}
+
+/* The reference picture lists of each picture are the expected ones */
+static void
+assert_ref_pic_lists (const gchar * decode_log)
+{
+  gchar **lines = g_strsplit (decode_log, "\n", -1);
+  guint i;
+
+  fail_unless_equals_int (g_strv_length (lines),
+      G_N_ELEMENTS (h265_128x128_bframes) + 1);
+  for (i = 0; i < G_N_ELEMENTS (h265_128x128_bframes); i++) {
+    const BFramesPicture *picture = &h265_128x128_bframes[i];
+    gchar *prefix = g_strdup_printf ("poc %d, ", picture->poc);
+
+    fail_unless (g_str_has_prefix (lines[i], prefix), "%s", lines[i]);
+    fail_unless (g_str_has_suffix (lines[i], picture->ref_pic_lists), "%s",
+        lines[i]);
+    g_free (prefix);
+  }
+
+  g_strfreev (lines);
+}
+
+/* Pipelining doesn't change the output */
+GST_START_TEST (test_pipelined_output)
+{
+  GList *serial, *pipelined, *l, *m;
+  guint i;
+
+  serial = decode (0, 0);
+  pipelined = decode (PIPELINE_DEPTH, 0);
+
+  fail_unless_equals_int (g_list_length (serial), N_FRAMES);
+  fail_unless_equals_int (g_list_length (pipelined), N_FRAMES);
+  for (l = serial, m = pipelined, i = 0; l && m; l = l->next, m = m->next,
+      i++) {
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (l->data), i * FRAME_DURATION);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (m->data),
+        GST_BUFFER_PTS (l->data));
+    fail_unless_equals_uint64 (GST_BUFFER_DURATION (m->data),
+        GST_BUFFER_DURATION (l->data));
+  }
+
+  g_list_free_full (serial, (GDestroyNotify) gst_buffer_unref);
+  g_list_free_full (pipelined, (GDestroyNotify) gst_buffer_unref);
+}
+
+GST_END_TEST;
+
+/* Also with a slow subclass, where the submission thread always has work
+ * queued */
+GST_START_TEST (test_pipelined_slow_submit)
+{
+  GList *buffers, *l;
+  guint i;
+
+  buffers = decode (PIPELINE_DEPTH, 5 * G_TIME_SPAN_MILLISECOND);
+
+  fail_unless_equals_int (g_list_length (buffers), N_FRAMES);
+  for (l = buffers, i = 0; l; l = l->next, i++)
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (l->data), i * FRAME_DURATION);
+
+  g_list_free_full (buffers, (GDestroyNotify) gst_buffer_unref);
+}
+
+GST_END_TEST;
+
+/* Flushing with pictures in flight drops them without waiting for the
+ * whole queue, and decoding goes on afterwards */
+GST_START_TEST (test_pipelined_flush)
+{
+  GstHarness *h;
+  GstSegment segment;
+  GList *buffers, *l;
+  guint n_buffers, i;
+
+  h = setup_decoder (PIPELINE_DEPTH, 20 * G_TIME_SPAN_MILLISECOND);
+
+  push_access_units (h, 0, PIPELINE_DEPTH);
+  fail_unless (gst_harness_push_event (h, gst_event_new_flush_start ()));
+  fail_unless (gst_harness_push_event (h, gst_event_new_flush_stop (TRUE)));
+  fail_unless_equals_int (g_atomic_int_get (&GST_TEST_H265_DEC
+          (h->element)->n_pictures_alive), 0);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_harness_push_event (h, gst_event_new_segment (&segment)));
+  push_access_units (h, PIPELINE_DEPTH, N_FRAMES - PIPELINE_DEPTH);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  /* Whatever was output before the flush, then all of the rest */
+  buffers = pull_all (h);
+  n_buffers = g_list_length (buffers);
+  fail_unless (n_buffers >= N_FRAMES - PIPELINE_DEPTH);
+  fail_unless (n_buffers <= N_FRAMES);
+  for (l = g_list_nth (buffers, n_buffers - (N_FRAMES - PIPELINE_DEPTH)),
+      i = PIPELINE_DEPTH; l; l = l->next, i++)
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (l->data), i * FRAME_DURATION);
+
+  assert_threads (h, TRUE);
+  assert_drained (h);
+
+  g_list_free_full (buffers, (GDestroyNotify) gst_buffer_unref);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* With P and B pictures, pipelining doesn't change the DPB and reference
+ * picture lists the subclass gets to see, nor the output order */
+GST_START_TEST (test_pipelined_bframes)
+{
+  gchar *serial_decode_log, *serial_output_log;
+  gchar *pipelined_decode_log, *pipelined_output_log;
+
+  decode_bframes (0, 0, &serial_decode_log, &serial_output_log);
+  assert_ref_pic_lists (serial_decode_log);
+  fail_unless_equals_string (serial_output_log, " 0 1 2 3 4 5 6 7 8");
+
+  decode_bframes (PIPELINE_DEPTH, 0, &pipelined_decode_log,
+      &pipelined_output_log);
+  fail_unless_equals_string (pipelined_decode_log, serial_decode_log);
+  fail_unless_equals_string (pipelined_output_log, serial_output_log);
+  g_free (pipelined_decode_log);
+  g_free (pipelined_output_log);
+
+  decode_bframes (PIPELINE_DEPTH, 5 * G_TIME_SPAN_MILLISECOND,
+      &pipelined_decode_log, &pipelined_output_log);
+  fail_unless_equals_string (pipelined_decode_log, serial_decode_log);
+  fail_unless_equals_string (pipelined_output_log, serial_output_log);
+  g_free (pipelined_decode_log);
+  g_free (pipelined_output_log);
+
+  g_free (serial_decode_log);
+  g_free (serial_output_log);
+}
+
+GST_END_TEST;
+
+/* The frame of a picture the subclass failed to decode is dropped rather
+ * than output, like in serial mode */
+GST_START_TEST (test_pipelined_error)
+{
+  const guint depths[] = { 0, PIPELINE_DEPTH };
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (depths); i++) {
+    GstHarness *h = setup_decoder (depths[i], 0);
+    GList *buffers, *l;
+
+    GST_TEST_H265_DEC (h->element)->fail_frame = 3;
+
+    push_access_units (h, 0, N_FRAMES);
+    fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+    buffers = pull_all (h);
+    fail_unless_equals_int (g_list_length (buffers), N_FRAMES - 1);
+    for (l = buffers, j = 0; l; l = l->next, j++) {
+      fail_unless_equals_uint64 (GST_BUFFER_PTS (l->data),
+          (j < 3 ? j : j + 1) * FRAME_DURATION);
+    }
+    g_list_free_full (buffers, (GDestroyNotify) gst_buffer_unref);
+
+    assert_drained (h);
+    gst_harness_teardown (h);
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+h265decoder_suite (void)
+{
+  Suite *s = suite_create ("h265decoder");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_pipelined_output);
+  tcase_add_test (tc_chain, test_pipelined_slow_submit);
+  tcase_add_test (tc_chain, test_pipelined_flush);
+  tcase_add_test (tc_chain, test_pipelined_bframes);
+  tcase_add_test (tc_chain, test_pipelined_error);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h265decoder);
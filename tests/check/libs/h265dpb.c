@@ -0,0 +1,233 @@
+/* GStreamer
+ *
+ * Unit tests for the H.265 decoded picture buffer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/codecs/gsth265picture.h>
+
+static GstH265Picture *
+new_picture (gint32 poc)
+{
+  GstH265Picture *picture = gst_h265_picture_new ();
+
+  picture->pic_order_cnt = poc;
+  picture->output_flag = TRUE;
+
+  return picture;
+}
+
+/* Adds @picture then outputs what the DPB wants to, appending the POCs to
+ * @output */
+static void
+add_and_bump (GstH265Dpb * dpb, GstH265Picture * picture,
+    guint max_num_reorder_pics, GArray * output)
+{
+  gst_h265_dpb_add (dpb, picture);
+
+  while (gst_h265_dpb_needs_bump (dpb, max_num_reorder_pics, 0, 0)) {
+    GstH265Picture *out = gst_h265_dpb_bump (dpb, FALSE);
+
+    fail_unless (out != NULL);
+    g_array_append_val (output, out->pic_order_cnt);
+    gst_h265_picture_unref (out);
+  }
+}
+
+/* Outputs all remaining pictures then drops the reference ones, as the
+ * decoder does */
+static void
+drain (GstH265Dpb * dpb, GArray * output)
+{
+  GstH265Picture *out;
+
+  while ((out = gst_h265_dpb_bump (dpb, TRUE))) {
+    g_array_append_val (output, out->pic_order_cnt);
+    gst_h265_picture_unref (out);
+  }
+
+  gst_h265_dpb_clear (dpb);
+}
+
+static void
+assert_output (GArray * output, const gint32 * expected, guint n_expected)
+{
+  guint i;
+
+  fail_unless_equals_int (output->len, n_expected);
+  for (i = 0; i < n_expected; i++)
+    fail_unless_equals_int (g_array_index (output, gint32, i), expected[i]);
+
+  g_array_set_size (output, 0);
+}
+
+GST_START_TEST (test_h265_dpb_bump_order)
+{
+  GstH265Dpb *dpb = gst_h265_dpb_new ();
+  GArray *output = g_array_new (FALSE, FALSE, sizeof (gint32));
+  const gint32 pocs[] = { 0, 8, 4, 2, 6, 16, 12, 10, 14 };
+  const gint32 expected[] = { 0, 2, 4, 6, 8, 10, 12, 14, 16 };
+  const gint32 expected_dups[] = { 20, 20, 22 };
+  GstH265Picture *picture;
+  guint i;
+
+  gst_h265_dpb_set_max_num_pics (dpb, 16);
+
+  for (i = 0; i < G_N_ELEMENTS (pocs); i++)
+    add_and_bump (dpb, new_picture (pocs[i]), 2, output);
+
+  /* Pictures with output_flag 0 never come out */
+  picture = new_picture (1);
+  picture->output_flag = FALSE;
+  gst_h265_dpb_add (dpb, picture);
+  fail_if (picture->needed_for_output);
+
+  drain (dpb, output);
+  assert_output (output, expected, G_N_ELEMENTS (expected));
+
+  /* Pictures with the same POC come out in the order they were added */
+  for (i = 0; i < 3; i++) {
+    picture = new_picture (i == 2 ? 22 : 20);
+    picture->system_frame_number = i;
+    gst_h265_dpb_add (dpb, picture);
+  }
+
+  for (i = 0; i < 3; i++) {
+    picture = gst_h265_dpb_bump (dpb, TRUE);
+    fail_unless_equals_int (picture->system_frame_number, i);
+    g_array_append_val (output, picture->pic_order_cnt);
+    gst_h265_picture_unref (picture);
+  }
+  fail_unless (gst_h265_dpb_bump (dpb, TRUE) == NULL);
+  assert_output (output, expected_dups, G_N_ELEMENTS (expected_dups));
+
+  g_array_unref (output);
+  gst_h265_dpb_free (dpb);
+}
+
+GST_END_TEST;
+
+/* In low-latency mode, a picture is output as soon as its POC directly
+ * follows the last output one, instead of once sps_max_num_reorder_pics
+ * is exceeded */
+GST_START_TEST (test_h265_dpb_low_latency)
+{
+  GstH265Dpb *dpb = gst_h265_dpb_new ();
+  GArray *output = g_array_new (FALSE, FALSE, sizeof (gint32));
+  const gint32 pocs[] = { 0, 2, 1, 4, 3, 5, 6 };
+  const guint n_output[] = { 0, 0, 3, 3, 5, 6, 7 };
+  const guint n_output_reorder[] = { 0, 0, 1, 2, 3, 4, 5 };
+  const gint32 expected[] = { 0, 1, 2, 3, 4, 5, 6 };
+  guint i;
+
+  gst_h265_dpb_set_max_num_pics (dpb, 16);
+  gst_h265_dpb_set_low_latency (dpb, TRUE);
+
+  /* Nothing is known to follow before the first picture was output because
+   * of reordering. POC 4 waits for 3 */
+  for (i = 0; i < G_N_ELEMENTS (pocs); i++) {
+    add_and_bump (dpb, new_picture (pocs[i]), 2, output);
+    fail_unless_equals_int (output->len, n_output[i]);
+  }
+
+  drain (dpb, output);
+  assert_output (output, expected, G_N_ELEMENTS (expected));
+
+  /* The same stream, waiting for reordering */
+  gst_h265_dpb_set_low_latency (dpb, FALSE);
+
+  for (i = 0; i < G_N_ELEMENTS (pocs); i++) {
+    add_and_bump (dpb, new_picture (pocs[i]), 2, output);
+    fail_unless_equals_int (output->len, n_output_reorder[i]);
+  }
+
+  drain (dpb, output);
+  assert_output (output, expected, G_N_ELEMENTS (expected));
+
+  g_array_unref (output);
+  gst_h265_dpb_free (dpb);
+}
+
+GST_END_TEST;
+
+/* PicOrderCntVal starts over at an IRAP with NoRaslOutputFlag. Its leading
+ * pictures have lower POCs than the IRAP itself but possibly higher than
+ * what was output before it, so the IRAP must not be taken for the
+ * successor of the last output picture */
+GST_START_TEST (test_h265_dpb_irap_resets_last_output_poc)
+{
+  GstH265Dpb *dpb = gst_h265_dpb_new ();
+  GArray *output = g_array_new (FALSE, FALSE, sizeof (gint32));
+  const gint32 expected[] = { 0, 1, 2, 3 };
+  const gint32 expected_irap[] = { 2, 3, 4 };
+  GstH265Picture *picture;
+  guint i;
+
+  gst_h265_dpb_set_max_num_pics (dpb, 16);
+  gst_h265_dpb_set_low_latency (dpb, TRUE);
+
+  for (i = 0; i < 4; i++)
+    add_and_bump (dpb, new_picture (i), 2, output);
+  assert_output (output, expected, G_N_ELEMENTS (expected));
+
+  /* All prior pictures are unused for reference once the IRAP is decoded */
+  gst_h265_dpb_mark_all_non_ref (dpb);
+  gst_h265_dpb_delete_unused (dpb);
+  fail_unless_equals_int (gst_h265_dpb_get_size (dpb), 0);
+
+  /* A CRA with POC 4 directly follows the last output POC 3 */
+  picture = new_picture (4);
+  picture->RapPicFlag = TRUE;
+  picture->NoRaslOutputFlag = TRUE;
+  add_and_bump (dpb, picture, 2, output);
+  fail_unless_equals_int (output->len, 0);
+
+  /* Its RADL pictures come out first */
+  add_and_bump (dpb, new_picture (2), 2, output);
+  fail_unless_equals_int (output->len, 0);
+  add_and_bump (dpb, new_picture (3), 2, output);
+  assert_output (output, expected_irap, G_N_ELEMENTS (expected_irap));
+
+  drain (dpb, output);
+  fail_unless_equals_int (output->len, 0);
+
+  g_array_unref (output);
+  gst_h265_dpb_free (dpb);
+}
+
+GST_END_TEST;
+
+static Suite *
+h265dpb_suite (void)
+{
+  Suite *s = suite_create ("H.265 DPB");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_h265_dpb_bump_order);
+  tcase_add_test (tc_chain, test_h265_dpb_low_latency);
+  tcase_add_test (tc_chain, test_h265_dpb_irap_resets_last_output_poc);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h265dpb);
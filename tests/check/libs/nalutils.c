@@ -102,6 +102,58 @@ GST_START_TEST (test_nal_writer_emulation_preventation)
 
 GST_END_TEST;
 
+GST_START_TEST (test_nal_reader_emulation_prevention)
+{
+  NalReader nr;
+  guint8 val8;
+  guint32 val32;
+  /* 0x00 0x00 0x01, 0x00 0x00 0x00 and ue(v) codes around emulation
+   * prevention bytes */
+  static const guint8 data[] = {
+    0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x03, 0x00,
+    0x00, 0x00, 0x03, 0x03, 0x01, 0x00, 0x00, 0x03,
+    0x15, 0x5a, 0x80
+  };
+
+  nal_reader_init (&nr, data, sizeof (data));
+
+  fail_unless (nal_reader_get_bits_uint32 (&nr, &val32, 24));
+  assert_equals_int (val32, 0x000001);
+  assert_equals_int (nal_reader_get_epb_count (&nr), 1);
+  assert_equals_int (nal_reader_get_pos (&nr), 32);
+
+  fail_unless (nal_reader_get_bits_uint32 (&nr, &val32, 24));
+  assert_equals_int (val32, 0x000000);
+  assert_equals_int (nal_reader_get_epb_count (&nr), 2);
+
+  /* 0x00 0x00 0x03 0x03, only the first 0x03 is removed */
+  fail_unless (nal_reader_get_bits_uint32 (&nr, &val32, 16));
+  assert_equals_int (val32, 0x0000);
+  fail_unless (nal_reader_get_bits_uint8 (&nr, &val8, 8));
+  assert_equals_int (val8, 0x03);
+  assert_equals_int (nal_reader_get_epb_count (&nr), 3);
+
+  /* 7 leading zero bits */
+  fail_unless (nal_reader_get_ue (&nr, &val32));
+  assert_equals_int (val32, 127);
+  assert_equals_int (nal_reader_get_epb_count (&nr), 3);
+  fail_if (nal_reader_is_byte_aligned (&nr));
+
+  /* 12 leading zero bits, spanning an emulation prevention byte */
+  fail_unless (nal_reader_get_ue (&nr, &val32));
+  assert_equals_int (val32, (1 << 12) - 1 + 0x55a);
+  assert_equals_int (nal_reader_get_epb_count (&nr), 4);
+  fail_unless (nal_reader_is_byte_aligned (&nr));
+
+  /* rbsp_trailing_bits */
+  fail_if (nal_reader_has_more_data (&nr));
+  fail_unless (nal_reader_get_bits_uint8 (&nr, &val8, 8));
+  assert_equals_int (val8, 0x80);
+  fail_if (nal_reader_get_bits_uint8 (&nr, &val8, 1));
+}
+
+GST_END_TEST;
+
 static Suite *
 nalutils_suite (void)
 {
@@ -112,6 +164,7 @@ nalutils_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_nal_writer_init);
   tcase_add_test (tc_chain, test_nal_writer_emulation_preventation);
+  tcase_add_test (tc_chain, test_nal_reader_emulation_prevention);
 
   return s;
 }
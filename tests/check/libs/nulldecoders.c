@@ -0,0 +1,828 @@
+/* GStreamer
+ *
+ * Null backend subclasses of the stateless decoder base classes
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The codec base classes are normally only exercised through hardware
+ * accelerated subclasses. These "null backend" subclasses (nullh264dec,
+ * nullh265dec, nullvp9dec, nullav1dec and nullmpeg2dec) have no-op decoding
+ * vfuncs and output empty GRAY8 frames carrying the timestamps computed by
+ * the base class. They are used by the unit tests and the benchmark.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "nulldecoders.h"
+
+#include <gst/codecs/gsth264decoder.h>
+#include <gst/codecs/gsth265decoder.h>
+#include <gst/codecs/gstvp9decoder.h>
+#include <gst/codecs/gstav1decoder.h>
+#include <gst/codecs/gstmpeg2decoder.h>
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("GRAY8")));
+
+/* Helpers shared by all null decoders */
+
+static void
+null_dec_class_init (GstElementClass * element_class,
+    const gchar * longname, const gchar * sink_caps)
+{
+  GstCaps *caps;
+
+  gst_element_class_set_static_metadata (element_class, longname,
+      "Codec/Decoder/Video", "Decoder base class testing helper",
+      "GStreamer developers");
+
+  caps = gst_caps_from_string (sink_caps);
+  gst_element_class_add_pad_template (element_class,
+      gst_pad_template_new ("sink", GST_PAD_SINK, GST_PAD_ALWAYS, caps));
+  gst_caps_unref (caps);
+
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+}
+
+static gboolean
+null_dec_set_size (GstVideoDecoder * decoder, GstVideoCodecState * input_state,
+    gint width, gint height)
+{
+  GstVideoCodecState *state;
+
+  state = gst_video_decoder_get_output_state (decoder);
+  if (state) {
+    gboolean same = GST_VIDEO_INFO_WIDTH (&state->info) == width &&
+        GST_VIDEO_INFO_HEIGHT (&state->info) == height;
+
+    gst_video_codec_state_unref (state);
+    if (same)
+      return TRUE;
+  }
+
+  /* Negotiation is done by gst_video_decoder_allocate_output_frame() */
+  state = gst_video_decoder_set_output_state (decoder, GST_VIDEO_FORMAT_GRAY8,
+      width, height, input_state);
+  gst_video_codec_state_unref (state);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+null_dec_output (GstVideoDecoder * decoder, GstVideoCodecFrame * frame,
+    GstVideoBufferFlags buffer_flags, NullDecStats * stats)
+{
+  GstClockTime start;
+  GstFlowReturn ret;
+
+  /* Allocate here rather than in new_picture() so that duplicated pictures
+   * (show_existing_frame) get a buffer too */
+  if (!frame->output_buffer) {
+    ret = gst_video_decoder_allocate_output_frame (decoder, frame);
+    if (ret != GST_FLOW_OK) {
+      gst_video_decoder_drop_frame (decoder, frame);
+      return ret;
+    }
+  }
+
+  if (buffer_flags)
+    GST_BUFFER_FLAG_SET (frame->output_buffer, buffer_flags);
+
+  stats->frames++;
+
+  start = gst_util_get_timestamp ();
+  ret = gst_video_decoder_finish_frame (decoder, frame);
+  stats->finish_time += gst_util_get_timestamp () - start;
+
+  return ret;
+}
+
+static GstFlowReturn
+null_dec_handle_frame_timed (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame, GstVideoDecoderClass * parent_class,
+    NullDecStats * stats)
+{
+  GstClockTime finish_time = stats->finish_time;
+  GstClockTime start = gst_util_get_timestamp ();
+  GstFlowReturn ret;
+
+  ret = parent_class->handle_frame (decoder, frame);
+  stats->time += gst_util_get_timestamp () - start -
+      (stats->finish_time - finish_time);
+
+  return ret;
+}
+
+static GstFlowReturn
+null_dec_drain_timed (GstVideoDecoder * decoder,
+    GstFlowReturn (*drain) (GstVideoDecoder * decoder), NullDecStats * stats)
+{
+  GstClockTime finish_time = stats->finish_time;
+  GstClockTime start = gst_util_get_timestamp ();
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if (drain)
+    ret = drain (decoder);
+  stats->time += gst_util_get_timestamp () - start -
+      (stats->finish_time - finish_time);
+
+  return ret;
+}
+
+/* GstNullH264Dec */
+
+#define GST_TYPE_NULL_H264_DEC (gst_null_h264_dec_get_type ())
+G_DECLARE_FINAL_TYPE (GstNullH264Dec, gst_null_h264_dec, GST, NULL_H264_DEC,
+    GstH264Decoder);
+
+struct _GstNullH264Dec
+{
+  GstH264Decoder parent;
+
+  NullDecStats stats;
+};
+
+G_DEFINE_TYPE (GstNullH264Dec, gst_null_h264_dec, GST_TYPE_H264_DECODER);
+
+static GstFlowReturn
+gst_null_h264_dec_handle_frame (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame)
+{
+  return null_dec_handle_frame_timed (decoder, frame,
+      GST_VIDEO_DECODER_CLASS (gst_null_h264_dec_parent_class),
+      &GST_NULL_H264_DEC (decoder)->stats);
+}
+
+static GstFlowReturn
+gst_null_h264_dec_drain (GstVideoDecoder * decoder)
+{
+  return null_dec_drain_timed (decoder,
+      GST_VIDEO_DECODER_CLASS (gst_null_h264_dec_parent_class)->drain,
+      &GST_NULL_H264_DEC (decoder)->stats);
+}
+
+static GstFlowReturn
+gst_null_h264_dec_finish (GstVideoDecoder * decoder)
+{
+  return null_dec_drain_timed (decoder,
+      GST_VIDEO_DECODER_CLASS (gst_null_h264_dec_parent_class)->finish,
+      &GST_NULL_H264_DEC (decoder)->stats);
+}
+
+static gboolean
+gst_null_h264_dec_new_sequence (GstH264Decoder * decoder,
+    const GstH264SPS * sps, gint max_dpb_size)
+{
+  return null_dec_set_size (GST_VIDEO_DECODER (decoder), decoder->input_state,
+      sps->width, sps->height);
+}
+
+static gboolean
+gst_null_h264_dec_new_picture (GstH264Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH264Picture * picture)
+{
+  GST_NULL_H264_DEC (decoder)->stats.pictures++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_null_h264_dec_new_field_picture (GstH264Decoder * decoder,
+    const GstH264Picture * first_field, GstH264Picture * second_field)
+{
+  GST_NULL_H264_DEC (decoder)->stats.pictures++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_null_h264_dec_start_picture (GstH264Decoder * decoder,
+    GstH264Picture * picture, GstH264Slice * slice, GstH264Dpb * dpb)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_null_h264_dec_decode_slice (GstH264Decoder * decoder,
+    GstH264Picture * picture, GstH264Slice * slice, GArray * ref_pic_list0,
+    GArray * ref_pic_list1)
+{
+  GST_NULL_H264_DEC (decoder)->stats.slices++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_null_h264_dec_end_picture (GstH264Decoder * decoder,
+    GstH264Picture * picture)
+{
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_null_h264_dec_output_picture (GstH264Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH264Picture * picture)
+{
+  GstVideoBufferFlags buffer_flags = picture->buffer_flags;
+
+  gst_h264_picture_unref (picture);
+
+  return null_dec_output (GST_VIDEO_DECODER (decoder), frame, buffer_flags,
+      &GST_NULL_H264_DEC (decoder)->stats);
+}
+
+static void
+gst_null_h264_dec_class_init (GstNullH264DecClass * klass)
+{
+  GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
+  GstH264DecoderClass *h264decoder_class = GST_H264_DECODER_CLASS (klass);
+
+  null_dec_class_init (GST_ELEMENT_CLASS (klass), "Null H.264 Decoder",
+      "video/x-h264, stream-format = (string) { avc, avc3, byte-stream }, "
+      "alignment = (string) au");
+
+  decoder_class->handle_frame = gst_null_h264_dec_handle_frame;
+  decoder_class->drain = gst_null_h264_dec_drain;
+  decoder_class->finish = gst_null_h264_dec_finish;
+
+  h264decoder_class->new_sequence = gst_null_h264_dec_new_sequence;
+  h264decoder_class->new_picture = gst_null_h264_dec_new_picture;
+  h264decoder_class->new_field_picture = gst_null_h264_dec_new_field_picture;
+  h264decoder_class->start_picture = gst_null_h264_dec_start_picture;
+  h264decoder_class->decode_slice = gst_null_h264_dec_decode_slice;
+  h264decoder_class->end_picture = gst_null_h264_dec_end_picture;
+  h264decoder_class->output_picture = gst_null_h264_dec_output_picture;
+}
+
+static void
+gst_null_h264_dec_init (GstNullH264Dec * self)
+{
+}
+
+/* GstNullH265Dec */
+
+#define GST_TYPE_NULL_H265_DEC (gst_null_h265_dec_get_type ())
+G_DECLARE_FINAL_TYPE (GstNullH265Dec, gst_null_h265_dec, GST, NULL_H265_DEC,
+    GstH265Decoder);
+
+struct _GstNullH265Dec
+{
+  GstH265Decoder parent;
+
+  NullDecStats stats;
+};
+
+G_DEFINE_TYPE (GstNullH265Dec, gst_null_h265_dec, GST_TYPE_H265_DECODER);
+
+static GstFlowReturn
+gst_null_h265_dec_handle_frame (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame)
+{
+  return null_dec_handle_frame_timed (decoder, frame,
+      GST_VIDEO_DECODER_CLASS (gst_null_h265_dec_parent_class),
+      &GST_NULL_H265_DEC (decoder)->stats);
+}
+
+static GstFlowReturn
+gst_null_h265_dec_drain (GstVideoDecoder * decoder)
+{
+  return null_dec_drain_timed (decoder,
+      GST_VIDEO_DECODER_CLASS (gst_null_h265_dec_parent_class)->drain,
+      &GST_NULL_H265_DEC (decoder)->stats);
+}
+
+static GstFlowReturn
+gst_null_h265_dec_finish (GstVideoDecoder * decoder)
+{
+  return null_dec_drain_timed (decoder,
+      GST_VIDEO_DECODER_CLASS (gst_null_h265_dec_parent_class)->finish,
+      &GST_NULL_H265_DEC (decoder)->stats);
+}
+
+static gboolean
+gst_null_h265_dec_new_sequence (GstH265Decoder * decoder,
+    const GstH265SPS * sps, gint max_dpb_size)
+{
+  return null_dec_set_size (GST_VIDEO_DECODER (decoder), decoder->input_state,
+      sps->width, sps->height);
+}
+
+static gboolean
+gst_null_h265_dec_new_picture (GstH265Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH265Picture * picture)
+{
+  GST_NULL_H265_DEC (decoder)->stats.pictures++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_null_h265_dec_start_picture (GstH265Decoder * decoder,
+    GstH265Picture * picture, GstH265Slice * slice, GstH265Dpb * dpb)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_null_h265_dec_decode_slice (GstH265Decoder * decoder,
+    GstH265Picture * picture, GstH265Slice * slice, GArray * ref_pic_list0,
+    GArray * ref_pic_list1)
+{
+  GST_NULL_H265_DEC (decoder)->stats.slices++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_null_h265_dec_end_picture (GstH265Decoder * decoder,
+    GstH265Picture * picture)
+{
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_null_h265_dec_output_picture (GstH265Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH265Picture * picture)
+{
+  GstVideoBufferFlags buffer_flags = picture->buffer_flags;
+
+  gst_h265_picture_unref (picture);
+
+  return null_dec_output (GST_VIDEO_DECODER (decoder), frame, buffer_flags,
+      &GST_NULL_H265_DEC (decoder)->stats);
+}
+
+static void
+gst_null_h265_dec_class_init (GstNullH265DecClass * klass)
+{
+  GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
+  GstH265DecoderClass *h265decoder_class = GST_H265_DECODER_CLASS (klass);
+
+  null_dec_class_init (GST_ELEMENT_CLASS (klass), "Null H.265 Decoder",
+      "video/x-h265, stream-format = (string) { hvc1, hev1, byte-stream }, "
+      "alignment = (string) au");
+
+  decoder_class->handle_frame = gst_null_h265_dec_handle_frame;
+  decoder_class->drain = gst_null_h265_dec_drain;
+  decoder_class->finish = gst_null_h265_dec_finish;
+
+  h265decoder_class->new_sequence = gst_null_h265_dec_new_sequence;
+  h265decoder_class->new_picture = gst_null_h265_dec_new_picture;
+  h265decoder_class->start_picture = gst_null_h265_dec_start_picture;
+  h265decoder_class->decode_slice = gst_null_h265_dec_decode_slice;
+  h265decoder_class->end_picture = gst_null_h265_dec_end_picture;
+  h265decoder_class->output_picture = gst_null_h265_dec_output_picture;
+}
+
+static void
+gst_null_h265_dec_init (GstNullH265Dec * self)
+{
+}
+
+/* GstNullVp9Dec */
+
+#define GST_TYPE_NULL_VP9_DEC (gst_null_vp9_dec_get_type ())
+G_DECLARE_FINAL_TYPE (GstNullVp9Dec, gst_null_vp9_dec, GST, NULL_VP9_DEC,
+    GstVp9Decoder);
+
+struct _GstNullVp9Dec
+{
+  GstVp9Decoder parent;
+
+  NullDecStats stats;
+};
+
+G_DEFINE_TYPE (GstNullVp9Dec, gst_null_vp9_dec, GST_TYPE_VP9_DECODER);
+
+static GstFlowReturn
+gst_null_vp9_dec_handle_frame (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame)
+{
+  return null_dec_handle_frame_timed (decoder, frame,
+      GST_VIDEO_DECODER_CLASS (gst_null_vp9_dec_parent_class),
+      &GST_NULL_VP9_DEC (decoder)->stats);
+}
+
+static GstFlowReturn
+gst_null_vp9_dec_drain (GstVideoDecoder * decoder)
+{
+  return null_dec_drain_timed (decoder,
+      GST_VIDEO_DECODER_CLASS (gst_null_vp9_dec_parent_class)->drain,
+      &GST_NULL_VP9_DEC (decoder)->stats);
+}
+
+static GstFlowReturn
+gst_null_vp9_dec_finish (GstVideoDecoder * decoder)
+{
+  return null_dec_drain_timed (decoder,
+      GST_VIDEO_DECODER_CLASS (gst_null_vp9_dec_parent_class)->finish,
+      &GST_NULL_VP9_DEC (decoder)->stats);
+}
+
+static gboolean
+gst_null_vp9_dec_new_sequence (GstVp9Decoder * decoder,
+    const GstVp9Parser * parser, const GstVp9FrameHdr * frame_hdr)
+{
+  return null_dec_set_size (GST_VIDEO_DECODER (decoder), decoder->input_state,
+      frame_hdr->width, frame_hdr->height);
+}
+
+static gboolean
+gst_null_vp9_dec_new_picture (GstVp9Decoder * decoder,
+    GstVideoCodecFrame * frame, GstVp9Picture * picture)
+{
+  GST_NULL_VP9_DEC (decoder)->stats.pictures++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_null_vp9_dec_start_picture (GstVp9Decoder * decoder,
+    GstVp9Picture * picture)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_null_vp9_dec_decode_picture (GstVp9Decoder * decoder,
+    GstVp9Picture * picture, GstVp9Dpb * dpb)
+{
+  GST_NULL_VP9_DEC (decoder)->stats.slices++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_null_vp9_dec_end_picture (GstVp9Decoder * decoder, GstVp9Picture * picture)
+{
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_null_vp9_dec_output_picture (GstVp9Decoder * decoder,
+    GstVideoCodecFrame * frame, GstVp9Picture * picture)
+{
+  gst_vp9_picture_unref (picture);
+
+  return null_dec_output (GST_VIDEO_DECODER (decoder), frame, 0,
+      &GST_NULL_VP9_DEC (decoder)->stats);
+}
+
+static void
+gst_null_vp9_dec_class_init (GstNullVp9DecClass * klass)
+{
+  GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
+  GstVp9DecoderClass *vp9decoder_class = GST_VP9_DECODER_CLASS (klass);
+
+  null_dec_class_init (GST_ELEMENT_CLASS (klass), "Null VP9 Decoder",
+      "video/x-vp9");
+
+  decoder_class->handle_frame = gst_null_vp9_dec_handle_frame;
+  decoder_class->drain = gst_null_vp9_dec_drain;
+  decoder_class->finish = gst_null_vp9_dec_finish;
+
+  vp9decoder_class->new_sequence = gst_null_vp9_dec_new_sequence;
+  vp9decoder_class->new_picture = gst_null_vp9_dec_new_picture;
+  vp9decoder_class->start_picture = gst_null_vp9_dec_start_picture;
+  vp9decoder_class->decode_picture = gst_null_vp9_dec_decode_picture;
+  vp9decoder_class->end_picture = gst_null_vp9_dec_end_picture;
+  vp9decoder_class->output_picture = gst_null_vp9_dec_output_picture;
+}
+
+static void
+gst_null_vp9_dec_init (GstNullVp9Dec * self)
+{
+}
+
+/* GstNullAV1Dec */
+
+#define GST_TYPE_NULL_AV1_DEC (gst_null_av1_dec_get_type ())
+G_DECLARE_FINAL_TYPE (GstNullAV1Dec, gst_null_av1_dec, GST, NULL_AV1_DEC,
+    GstAV1Decoder);
+
+struct _GstNullAV1Dec
+{
+  GstAV1Decoder parent;
+
+  NullDecStats stats;
+};
+
+G_DEFINE_TYPE (GstNullAV1Dec, gst_null_av1_dec, GST_TYPE_AV1_DECODER);
+
+static GstFlowReturn
+gst_null_av1_dec_handle_frame (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame)
+{
+  return null_dec_handle_frame_timed (decoder, frame,
+      GST_VIDEO_DECODER_CLASS (gst_null_av1_dec_parent_class),
+      &GST_NULL_AV1_DEC (decoder)->stats);
+}
+
+static GstFlowReturn
+gst_null_av1_dec_drain (GstVideoDecoder * decoder)
+{
+  return null_dec_drain_timed (decoder,
+      GST_VIDEO_DECODER_CLASS (gst_null_av1_dec_parent_class)->drain,
+      &GST_NULL_AV1_DEC (decoder)->stats);
+}
+
+static GstFlowReturn
+gst_null_av1_dec_finish (GstVideoDecoder * decoder)
+{
+  return null_dec_drain_timed (decoder,
+      GST_VIDEO_DECODER_CLASS (gst_null_av1_dec_parent_class)->finish,
+      &GST_NULL_AV1_DEC (decoder)->stats);
+}
+
+static gboolean
+gst_null_av1_dec_new_sequence (GstAV1Decoder * decoder,
+    const GstAV1SequenceHeaderOBU * seq_hdr)
+{
+  return null_dec_set_size (GST_VIDEO_DECODER (decoder), decoder->input_state,
+      seq_hdr->max_frame_width_minus_1 + 1,
+      seq_hdr->max_frame_height_minus_1 + 1);
+}
+
+static gboolean
+gst_null_av1_dec_new_picture (GstAV1Decoder * decoder,
+    GstVideoCodecFrame * frame, GstAV1Picture * picture)
+{
+  GST_NULL_AV1_DEC (decoder)->stats.pictures++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_null_av1_dec_start_picture (GstAV1Decoder * decoder,
+    GstAV1Picture * picture, GstAV1Dpb * dpb)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_null_av1_dec_decode_tile (GstAV1Decoder * decoder,
+    GstAV1Picture * picture, GstAV1Tile * tile)
+{
+  GST_NULL_AV1_DEC (decoder)->stats.slices++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_null_av1_dec_end_picture (GstAV1Decoder * decoder, GstAV1Picture * picture)
+{
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_null_av1_dec_output_picture (GstAV1Decoder * decoder,
+    GstVideoCodecFrame * frame, GstAV1Picture * picture)
+{
+  gst_av1_picture_unref (picture);
+
+  return null_dec_output (GST_VIDEO_DECODER (decoder), frame, 0,
+      &GST_NULL_AV1_DEC (decoder)->stats);
+}
+
+static void
+gst_null_av1_dec_class_init (GstNullAV1DecClass * klass)
+{
+  GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
+  GstAV1DecoderClass *av1decoder_class = GST_AV1_DECODER_CLASS (klass);
+
+  null_dec_class_init (GST_ELEMENT_CLASS (klass), "Null AV1 Decoder",
+      "video/x-av1");
+
+  decoder_class->handle_frame = gst_null_av1_dec_handle_frame;
+  decoder_class->drain = gst_null_av1_dec_drain;
+  decoder_class->finish = gst_null_av1_dec_finish;
+
+  av1decoder_class->new_sequence = gst_null_av1_dec_new_sequence;
+  av1decoder_class->new_picture = gst_null_av1_dec_new_picture;
+  av1decoder_class->start_picture = gst_null_av1_dec_start_picture;
+  av1decoder_class->decode_tile = gst_null_av1_dec_decode_tile;
+  av1decoder_class->end_picture = gst_null_av1_dec_end_picture;
+  av1decoder_class->output_picture = gst_null_av1_dec_output_picture;
+}
+
+static void
+gst_null_av1_dec_init (GstNullAV1Dec * self)
+{
+}
+
+/* GstNullMpeg2Dec */
+
+#define GST_TYPE_NULL_MPEG2_DEC (gst_null_mpeg2_dec_get_type ())
+G_DECLARE_FINAL_TYPE (GstNullMpeg2Dec, gst_null_mpeg2_dec, GST,
+    NULL_MPEG2_DEC, GstMpeg2Decoder);
+
+struct _GstNullMpeg2Dec
+{
+  GstMpeg2Decoder parent;
+
+  NullDecStats stats;
+};
+
+G_DEFINE_TYPE (GstNullMpeg2Dec, gst_null_mpeg2_dec, GST_TYPE_MPEG2_DECODER);
+
+static GstFlowReturn
+gst_null_mpeg2_dec_handle_frame (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame)
+{
+  return null_dec_handle_frame_timed (decoder, frame,
+      GST_VIDEO_DECODER_CLASS (gst_null_mpeg2_dec_parent_class),
+      &GST_NULL_MPEG2_DEC (decoder)->stats);
+}
+
+static GstFlowReturn
+gst_null_mpeg2_dec_drain (GstVideoDecoder * decoder)
+{
+  return null_dec_drain_timed (decoder,
+      GST_VIDEO_DECODER_CLASS (gst_null_mpeg2_dec_parent_class)->drain,
+      &GST_NULL_MPEG2_DEC (decoder)->stats);
+}
+
+static GstFlowReturn
+gst_null_mpeg2_dec_finish (GstVideoDecoder * decoder)
+{
+  return null_dec_drain_timed (decoder,
+      GST_VIDEO_DECODER_CLASS (gst_null_mpeg2_dec_parent_class)->finish,
+      &GST_NULL_MPEG2_DEC (decoder)->stats);
+}
+
+static gboolean
+gst_null_mpeg2_dec_new_sequence (GstMpeg2Decoder * decoder,
+    const GstMpegVideoSequenceHdr * seq,
+    const GstMpegVideoSequenceExt * seq_ext,
+    const GstMpegVideoSequenceDisplayExt * seq_display_ext,
+    const GstMpegVideoSequenceScalableExt * seq_scalable_ext)
+{
+  return null_dec_set_size (GST_VIDEO_DECODER (decoder), decoder->input_state,
+      seq->width, seq->height);
+}
+
+static gboolean
+gst_null_mpeg2_dec_new_picture (GstMpeg2Decoder * decoder,
+    GstVideoCodecFrame * frame, GstMpeg2Picture * picture)
+{
+  GST_NULL_MPEG2_DEC (decoder)->stats.pictures++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_null_mpeg2_dec_new_field_picture (GstMpeg2Decoder * decoder,
+    const GstMpeg2Picture * first_field, GstMpeg2Picture * second_field)
+{
+  GST_NULL_MPEG2_DEC (decoder)->stats.pictures++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_null_mpeg2_dec_start_picture (GstMpeg2Decoder * decoder,
+    GstMpeg2Picture * picture, GstMpeg2Slice * slice,
+    GstMpeg2Picture * prev_picture, GstMpeg2Picture * next_picture)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_null_mpeg2_dec_decode_slice (GstMpeg2Decoder * decoder,
+    GstMpeg2Picture * picture, GstMpeg2Slice * slice)
+{
+  GST_NULL_MPEG2_DEC (decoder)->stats.slices++;
+
+  return TRUE;
+}
+
+static gboolean
+gst_null_mpeg2_dec_end_picture (GstMpeg2Decoder * decoder,
+    GstMpeg2Picture * picture)
+{
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_null_mpeg2_dec_output_picture (GstMpeg2Decoder * decoder,
+    GstVideoCodecFrame * frame, GstMpeg2Picture * picture)
+{
+  GstVideoBufferFlags buffer_flags = picture->buffer_flags;
+
+  gst_mpeg2_picture_unref (picture);
+
+  return null_dec_output (GST_VIDEO_DECODER (decoder), frame, buffer_flags,
+      &GST_NULL_MPEG2_DEC (decoder)->stats);
+}
+
+static void
+gst_null_mpeg2_dec_class_init (GstNullMpeg2DecClass * klass)
+{
+  GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
+  GstMpeg2DecoderClass *mpeg2decoder_class = GST_MPEG2_DECODER_CLASS (klass);
+
+  null_dec_class_init (GST_ELEMENT_CLASS (klass), "Null MPEG-2 Decoder",
+      "video/mpeg, mpegversion = (int) 2, systemstream = (boolean) false");
+
+  decoder_class->handle_frame = gst_null_mpeg2_dec_handle_frame;
+  decoder_class->drain = gst_null_mpeg2_dec_drain;
+  decoder_class->finish = gst_null_mpeg2_dec_finish;
+
+  mpeg2decoder_class->new_sequence = gst_null_mpeg2_dec_new_sequence;
+  mpeg2decoder_class->new_picture = gst_null_mpeg2_dec_new_picture;
+  mpeg2decoder_class->new_field_picture =
+      gst_null_mpeg2_dec_new_field_picture;
+  mpeg2decoder_class->start_picture = gst_null_mpeg2_dec_start_picture;
+  mpeg2decoder_class->decode_slice = gst_null_mpeg2_dec_decode_slice;
+  mpeg2decoder_class->end_picture = gst_null_mpeg2_dec_end_picture;
+  mpeg2decoder_class->output_picture = gst_null_mpeg2_dec_output_picture;
+}
+
+static void
+gst_null_mpeg2_dec_init (GstNullMpeg2Dec * self)
+{
+}
+
+/* Public API */
+
+typedef struct
+{
+  const gchar *caps_name;
+  const gchar *factory_name;
+} NullDecMap;
+
+static const NullDecMap null_decoders[] = {
+  {"video/x-h264", "nullh264dec"},
+  {"video/x-h265", "nullh265dec"},
+  {"video/x-vp9", "nullvp9dec"},
+  {"video/x-av1", "nullav1dec"},
+  {"video/mpeg", "nullmpeg2dec"},
+};
+
+void
+register_null_decoders (void)
+{
+  gst_element_register (NULL, "nullh264dec", GST_RANK_NONE,
+      GST_TYPE_NULL_H264_DEC);
+  gst_element_register (NULL, "nullh265dec", GST_RANK_NONE,
+      GST_TYPE_NULL_H265_DEC);
+  gst_element_register (NULL, "nullvp9dec", GST_RANK_NONE,
+      GST_TYPE_NULL_VP9_DEC);
+  gst_element_register (NULL, "nullav1dec", GST_RANK_NONE,
+      GST_TYPE_NULL_AV1_DEC);
+  gst_element_register (NULL, "nullmpeg2dec", GST_RANK_NONE,
+      GST_TYPE_NULL_MPEG2_DEC);
+}
+
+NullDecStats *
+null_dec_get_stats (GstElement * dec)
+{
+  if (GST_IS_NULL_H264_DEC (dec))
+    return &GST_NULL_H264_DEC (dec)->stats;
+  if (GST_IS_NULL_H265_DEC (dec))
+    return &GST_NULL_H265_DEC (dec)->stats;
+  if (GST_IS_NULL_VP9_DEC (dec))
+    return &GST_NULL_VP9_DEC (dec)->stats;
+  if (GST_IS_NULL_AV1_DEC (dec))
+    return &GST_NULL_AV1_DEC (dec)->stats;
+  if (GST_IS_NULL_MPEG2_DEC (dec))
+    return &GST_NULL_MPEG2_DEC (dec)->stats;
+
+  g_assert_not_reached ();
+  return NULL;
+}
+
+GstElement *
+make_null_decoder (GstCaps * caps)
+{
+  const gchar *name;
+  guint i;
+
+  if (!caps || gst_caps_is_empty (caps) || gst_caps_is_any (caps))
+    return NULL;
+
+  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+  for (i = 0; i < G_N_ELEMENTS (null_decoders); i++) {
+    if (g_strcmp0 (name, null_decoders[i].caps_name) == 0)
+      return gst_element_factory_make (null_decoders[i].factory_name, NULL);
+  }
+
+  return NULL;
+}
@@ -0,0 +1,48 @@
+/* GStreamer
+ *
+ * Null backend subclasses of the stateless decoder base classes
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __NULL_DECODERS_H__
+#define __NULL_DECODERS_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* What a null decoder went through. @time is spent in the base class,
+ * @finish_time in gst_video_decoder_finish_frame(), which is mostly the
+ * time downstream takes to handle the frames, and isn't part of @time */
+typedef struct
+{
+  guint64 frames;
+  guint64 pictures;
+  guint64 slices;
+  GstClockTime time;
+  GstClockTime finish_time;
+} NullDecStats;
+
+void           register_null_decoders (void);
+
+GstElement *   make_null_decoder      (GstCaps * caps);
+
+NullDecStats * null_dec_get_stats     (GstElement * dec);
+
+G_END_DECLS
+
+#endif /* __NULL_DECODERS_H__ */